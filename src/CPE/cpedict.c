@@ -58,6 +58,10 @@ struct cpe_dict_model *cpe_dict_model_import_source(struct oscap_source *source)
 	if (ctx) {
 		xmlTextReaderNextNode(cpe_parser_ctx_get_reader(ctx));
 		dict = cpe_dict_model_parse(ctx);
+		if (dict != NULL && oscap_source_xmlTextReader_failed(reader)) {
+			cpe_dict_model_free(dict);
+			dict = NULL;
+		}
 		if (dict != NULL) {
 			dict->origin_file = oscap_strdup(oscap_source_readable_origin(source));
 		}
@@ -105,30 +109,13 @@ void cpe_dict_model_export(const struct cpe_dict_model *dict, const char *file)
 
 bool cpe_name_match_dict(struct cpe_name * cpe, struct cpe_dict_model * dict)
 {
-	// FIXME: We could match faster by matching per component and storing all
-	//        cpe_dict items in a big tree where leaves contain cpe_items and
-	//        inner nodes are the components.
-
 	__attribute__nonnull__(cpe);
 	__attribute__nonnull__(dict);
 
 	if (cpe == NULL || dict == NULL)
 		return false;
 
-	struct cpe_item_iterator *items = cpe_dict_model_get_items(dict);
-
-	bool ret = false;
-	while (cpe_item_iterator_has_more(items)) {
-		struct cpe_item* item = cpe_item_iterator_next(items);
-		struct cpe_name* name = cpe_item_get_name(item);
-
-		if (cpe_name_match_one(name, cpe)) {
-			ret = true;
-			break;
-		}
-	}
-	cpe_item_iterator_free(items);
-	return ret;
+	return cpe_dict_index_match(cpe_dict_model_get_index(dict), cpe);
 }
 
 bool cpe_name_match_dict_str(const char *cpestr, struct cpe_dict_model * dict)
@@ -149,34 +136,26 @@ bool cpe_name_match_dict_str(const char *cpestr, struct cpe_dict_model * dict)
 
 bool cpe_name_applicable_dict(struct cpe_name *cpe, struct cpe_dict_model *dict, cpe_check_fn cb, void* usr)
 {
-	// FIXME: We could match faster by matching per component and storing all
-	//        cpe_dict items in a big tree where leaves contain cpe_items and
-	//        inner nodes are the components.
-
 	__attribute__nonnull__(cpe);
 	__attribute__nonnull__(dict);
 
 	if (cpe == NULL || dict == NULL)
 		return false;
 
-	struct cpe_item_iterator *items = cpe_dict_model_get_items(dict);
+	size_t count;
+	struct cpe_item **items = cpe_dict_index_find(cpe_dict_model_get_index(dict), cpe, &count);
 
 	// essentially, we want at least one applicable match so as soon as we find
 	// a match we break and return true
 
 	bool ret = false;
-	while (cpe_item_iterator_has_more(items)) {
-		struct cpe_item* item = cpe_item_iterator_next(items);
-		struct cpe_name* name = cpe_item_get_name(item);
-
-		if (cpe_name_match_one(cpe, name)) {
-			if (cpe_item_is_applicable(item, cb, usr)) {
-				ret = true;
-				break;
-			}
+	for (size_t i = 0; i < count; ++i) {
+		if (cpe_item_is_applicable(items[i], cb, usr)) {
+			ret = true;
+			break;
 		}
 	}
-	cpe_item_iterator_free(items);
+	free(items);
 	return ret;
 }
 
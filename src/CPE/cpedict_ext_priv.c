@@ -178,10 +178,10 @@ static struct cpe_ext_deprecation *cpe_ext_deprecation_parse(xmlTextReaderPtr re
 	struct cpe_ext_deprecation *deprecation = cpe_ext_deprecation_new();
 	deprecation->date = (char *) xmlTextReaderGetAttribute(reader, BAD_CAST ATTR_DATE_STR);
 	if (xmlTextReaderIsEmptyElement(reader) == 0) { // the element contains child nodes
-		xmlTextReaderNextNode(reader);
-		while (xmlStrcmp(xmlTextReaderConstLocalName(reader), BAD_CAST TAG_CPE_EXT_DEPRECATION_STR) != 0) {
+		int next_ret = xmlTextReaderNextNode(reader);
+		while (next_ret == 1 && xmlStrcmp(xmlTextReaderConstLocalName(reader), BAD_CAST TAG_CPE_EXT_DEPRECATION_STR) != 0) {
 			if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT) {
-				xmlTextReaderNextNode(reader);
+				next_ret = xmlTextReaderNextNode(reader);
 				continue;
 			}
 
@@ -199,7 +199,11 @@ static struct cpe_ext_deprecation *cpe_ext_deprecation_parse(xmlTextReaderPtr re
 				cpe_ext_deprecation_free(deprecation);
 				return NULL;
 			}
-			xmlTextReaderNextNode(reader);
+			next_ret = xmlTextReaderNextNode(reader);
+		}
+		if (next_ret == -1) {
+			cpe_ext_deprecation_free(deprecation);
+			return NULL;
 		}
 	}
 	return deprecation;
@@ -244,10 +248,10 @@ struct cpe23_item *cpe23_item_parse(xmlTextReaderPtr reader)
 	struct cpe23_item *item = cpe23_item_new();
 	item->name = (char *) xmlTextReaderGetAttribute(reader, BAD_CAST ATTR_NAME_STR);
 	if (xmlTextReaderIsEmptyElement(reader) == 0) { // the element contains child nodes
-		xmlTextReaderNextNode(reader);
-		while (xmlStrcmp(xmlTextReaderConstLocalName(reader), BAD_CAST TAG_CPE23_ITEM_STR) != 0) {
+		int next_ret = xmlTextReaderNextNode(reader);
+		while (next_ret == 1 && xmlStrcmp(xmlTextReaderConstLocalName(reader), BAD_CAST TAG_CPE23_ITEM_STR) != 0) {
 			if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT) {
-				xmlTextReaderNextNode(reader);
+				next_ret = xmlTextReaderNextNode(reader);
 				continue;
 			}
 
@@ -265,7 +269,11 @@ struct cpe23_item *cpe23_item_parse(xmlTextReaderPtr reader)
 				cpe23_item_free(item);
 				return NULL;
 			}
-			xmlTextReaderNextNode(reader);
+			next_ret = xmlTextReaderNextNode(reader);
+		}
+		if (next_ret == -1) {
+			cpe23_item_free(item);
+			return NULL;
 		}
 	}
 
@@ -0,0 +1,311 @@
+/*
+ * Copyright 2009 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "cpedict_index_priv.h"
+#include "cpename_priv.h"
+#include "common/util.h"
+
+/*
+ * Nodes and items are referred to by their position in the arrays below,
+ * 0 means none (the root is never a child).
+ */
+struct cpe_dict_index_node {
+	size_t first_child;	// list of all the children, linked by next_sibling
+	size_t next_sibling;
+	size_t any;		// child for an unset component
+	size_t items;		// first item ending here (position + 1)
+};
+
+// edge from a node to its child for a given component
+struct cpe_dict_index_edge {
+	size_t parent;
+	size_t child;		// 0 for an empty slot
+	unsigned int hash;
+	char *key;		// lowercased component
+};
+
+struct cpe_dict_index {
+	struct cpe_dict_index_node *nodes;
+	size_t nodes_count, nodes_alloc;
+	struct cpe_dict_index_edge *edges;
+	size_t edges_count, edges_size;	// edges_size is a power of 2
+	struct cpe_item **items;	// in the dictionary order
+	size_t *items_next;		// next item ending in the same node (position + 1)
+	size_t items_count;
+};
+
+static char *cpe_dict_index_key(const char *component)
+{
+	char *key = oscap_strdup(component != NULL ? component : "");
+
+	for (char *p = key; *p != '\0'; ++p)
+		*p = tolower((unsigned char)*p);
+	return key;
+}
+
+static unsigned int cpe_dict_index_hash(size_t parent, const char *key)
+{
+	unsigned int h = 2166136261u;
+
+	h = (h ^ (unsigned int)parent) * 16777619u;
+	while (*key != '\0') {
+		h ^= (unsigned char)*key++;
+		h *= 16777619u;
+	}
+	return h;
+}
+
+static struct cpe_dict_index_edge *cpe_dict_index_slot(const struct cpe_dict_index *index, size_t parent, const char *key, unsigned int hash)
+{
+	size_t mask = index->edges_size - 1;
+	size_t i = hash & mask;
+
+	while (index->edges[i].child != 0) {
+		struct cpe_dict_index_edge *edge = &index->edges[i];
+
+		if (edge->hash == hash && edge->parent == parent && strcmp(edge->key, key) == 0)
+			break;
+		i = (i + 1) & mask;
+	}
+	return &index->edges[i];
+}
+
+static size_t cpe_dict_index_child(const struct cpe_dict_index *index, size_t parent, const char *component)
+{
+	char *key = cpe_dict_index_key(component);
+	size_t child = cpe_dict_index_slot(index, parent, key, cpe_dict_index_hash(parent, key))->child;
+
+	free(key);
+	return child;
+}
+
+static size_t cpe_dict_index_add_node(struct cpe_dict_index *index, size_t parent)
+{
+	if (index->nodes_count == index->nodes_alloc) {
+		index->nodes_alloc *= 2;
+		index->nodes = realloc(index->nodes, index->nodes_alloc * sizeof(struct cpe_dict_index_node));
+	}
+
+	size_t node = index->nodes_count++;
+	memset(&index->nodes[node], 0, sizeof(struct cpe_dict_index_node));
+	index->nodes[node].next_sibling = index->nodes[parent].first_child;
+	index->nodes[parent].first_child = node;
+	return node;
+}
+
+static void cpe_dict_index_grow_edges(struct cpe_dict_index *index)
+{
+	struct cpe_dict_index_edge *old = index->edges;
+	size_t old_size = index->edges_size;
+
+	index->edges_size *= 2;
+	index->edges = calloc(index->edges_size, sizeof(struct cpe_dict_index_edge));
+	for (size_t i = 0; i < old_size; ++i) {
+		if (old[i].child != 0)
+			*cpe_dict_index_slot(index, old[i].parent, old[i].key, old[i].hash) = old[i];
+	}
+	free(old);
+}
+
+static size_t cpe_dict_index_get_child(struct cpe_dict_index *index, size_t parent, const char *component)
+{
+	if (component == NULL) {
+		if (index->nodes[parent].any == 0) {
+			size_t node = cpe_dict_index_add_node(index, parent);
+			index->nodes[parent].any = node;
+		}
+		return index->nodes[parent].any;
+	}
+
+	char *key = cpe_dict_index_key(component);
+	unsigned int hash = cpe_dict_index_hash(parent, key);
+	struct cpe_dict_index_edge *edge = cpe_dict_index_slot(index, parent, key, hash);
+
+	if (edge->child != 0) {
+		free(key);
+		return edge->child;
+	}
+
+	edge->parent = parent;
+	edge->child = cpe_dict_index_add_node(index, parent);
+	edge->hash = hash;
+	edge->key = key;
+
+	size_t child = edge->child;
+	if (++index->edges_count * 2 > index->edges_size)
+		cpe_dict_index_grow_edges(index);
+	return child;
+}
+
+struct cpe_dict_index *cpe_dict_index_new(struct oscap_list *items)
+{
+	struct cpe_dict_index *index = calloc(1, sizeof(struct cpe_dict_index));
+	size_t count = oscap_list_get_itemcount(items);
+
+	index->nodes_alloc = 64;
+	index->nodes = malloc(index->nodes_alloc * sizeof(struct cpe_dict_index_node));
+	index->nodes_count = 1;
+	memset(&index->nodes[0], 0, sizeof(struct cpe_dict_index_node));
+	index->edges_size = 64;
+	index->edges = calloc(index->edges_size, sizeof(struct cpe_dict_index_edge));
+	index->items = malloc((count + 1) * sizeof(struct cpe_item *));
+	index->items_next = malloc((count + 1) * sizeof(size_t));
+
+	struct oscap_iterator *it = oscap_iterator_new(items);
+	while (oscap_iterator_has_more(it)) {
+		struct cpe_item *item = oscap_iterator_next(it);
+		struct cpe_name *name = cpe_item_get_name(item);
+		size_t pos = index->items_count++;
+
+		index->items[pos] = item;
+		index->items_next[pos] = 0;
+		if (name == NULL)
+			continue;
+
+		const char *fields[CPE_NAME_FIELDNUM];
+		int num = cpe_name_get_fields(name, fields);
+		size_t node = 0;
+
+		for (int i = 0; i < num; ++i)
+			node = cpe_dict_index_get_child(index, node, fields[i]);
+		index->items_next[pos] = index->nodes[node].items;
+		index->nodes[node].items = pos + 1;
+	}
+	oscap_iterator_free(it);
+
+	return index;
+}
+
+void cpe_dict_index_free(struct cpe_dict_index *index)
+{
+	if (index == NULL)
+		return;
+
+	for (size_t i = 0; i < index->edges_size; ++i)
+		free(index->edges[i].key);
+	free(index->edges);
+	free(index->nodes);
+	free(index->items);
+	free(index->items_next);
+	free(index);
+}
+
+size_t cpe_dict_index_get_count(const struct cpe_dict_index *index)
+{
+	return index->items_count;
+}
+
+static bool cpe_dict_index_match_node(const struct cpe_dict_index *index, size_t node, const char **fields, int num, int depth)
+{
+	const struct cpe_dict_index_node *n = &index->nodes[node];
+
+	// an item ending here has no set component the name doesn't match
+	if (n->items != 0)
+		return true;
+	if (depth == num)
+		return false;
+
+	size_t child = cpe_dict_index_child(index, node, fields[depth]);
+	if (child != 0 && cpe_dict_index_match_node(index, child, fields, num, depth + 1))
+		return true;
+	return n->any != 0 && cpe_dict_index_match_node(index, n->any, fields, num, depth + 1);
+}
+
+bool cpe_dict_index_match(const struct cpe_dict_index *index, const struct cpe_name *cpe)
+{
+	const char *fields[CPE_NAME_FIELDNUM];
+	int num = cpe_name_get_fields(cpe, fields);
+
+	return cpe_dict_index_match_node(index, 0, fields, num, 0);
+}
+
+struct cpe_dict_index_found {
+	size_t *pos;
+	size_t count, alloc;
+};
+
+static void cpe_dict_index_collect(const struct cpe_dict_index *index, size_t node, struct cpe_dict_index_found *found)
+{
+	for (size_t item = index->nodes[node].items; item != 0; item = index->items_next[item - 1]) {
+		if (found->count == found->alloc) {
+			found->alloc = found->alloc ? found->alloc * 2 : 16;
+			found->pos = realloc(found->pos, found->alloc * sizeof(size_t));
+		}
+		found->pos[found->count++] = item - 1;
+	}
+	for (size_t child = index->nodes[node].first_child; child != 0; child = index->nodes[child].next_sibling)
+		cpe_dict_index_collect(index, child, found);
+}
+
+static void cpe_dict_index_find_node(const struct cpe_dict_index *index, size_t node, const char **fields, int num, int depth, struct cpe_dict_index_found *found)
+{
+	const struct cpe_dict_index_node *n = &index->nodes[node];
+
+	// items ending above this depth have less components than the name
+	if (depth == num) {
+		cpe_dict_index_collect(index, node, found);
+		return;
+	}
+
+	if (fields[depth] == NULL) {
+		for (size_t child = n->first_child; child != 0; child = index->nodes[child].next_sibling)
+			cpe_dict_index_find_node(index, child, fields, num, depth + 1, found);
+		return;
+	}
+
+	size_t child = cpe_dict_index_child(index, node, fields[depth]);
+	if (child != 0)
+		cpe_dict_index_find_node(index, child, fields, num, depth + 1, found);
+	// an unset component compares as an empty string
+	if (*fields[depth] == '\0' && n->any != 0)
+		cpe_dict_index_find_node(index, n->any, fields, num, depth + 1, found);
+}
+
+static int cpe_dict_index_pos_cmp(const void *a, const void *b)
+{
+	size_t pa = *(const size_t *)a, pb = *(const size_t *)b;
+
+	return pa < pb ? -1 : pa > pb;
+}
+
+struct cpe_item **cpe_dict_index_find(const struct cpe_dict_index *index, const struct cpe_name *cpe, size_t *count)
+{
+	const char *fields[CPE_NAME_FIELDNUM];
+	int num = cpe_name_get_fields(cpe, fields);
+	struct cpe_dict_index_found found = { NULL, 0, 0 };
+
+	cpe_dict_index_find_node(index, 0, fields, num, 0, &found);
+	qsort(found.pos, found.count, sizeof(size_t), cpe_dict_index_pos_cmp);
+
+	struct cpe_item **items = malloc((found.count + 1) * sizeof(struct cpe_item *));
+	for (size_t i = 0; i < found.count; ++i)
+		items[i] = index->items[found.pos[i]];
+	free(found.pos);
+
+	*count = found.count;
+	return items;
+}
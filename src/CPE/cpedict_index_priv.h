@@ -0,0 +1,69 @@
+/*
+ * Copyright 2009 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef CPEDICT_INDEX_PRIV_H_
+#define CPEDICT_INDEX_PRIV_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "cpe_name.h"
+#include "cpe_dict.h"
+#include "../common/list.h"
+
+/*
+ * Component index of CPE dictionary items
+ *
+ * The names of the dictionary items are stored in a tree whose inner
+ * nodes are the lowercased name components (part, vendor, product, ...)
+ * and an item is attached to the node of its last set component. A node
+ * has a separate child for an unset component, which matches anything.
+ * A lookup walks at most two branches per component instead of comparing
+ * the name with every item of the dictionary.
+ */
+struct cpe_dict_index;
+
+/**
+ * Build the index of the given dictionary items
+ * @param items list of struct cpe_item
+ */
+struct cpe_dict_index *cpe_dict_index_new(struct oscap_list *items);
+
+void cpe_dict_index_free(struct cpe_dict_index *index);
+
+/**
+ * @return number of items the index was built from
+ */
+size_t cpe_dict_index_get_count(const struct cpe_dict_index *index);
+
+/**
+ * Is there an item whose name matches the given name?
+ * Same as calling cpe_name_match_one(item_name, cpe) on all the items.
+ */
+bool cpe_dict_index_match(const struct cpe_dict_index *index, const struct cpe_name *cpe);
+
+/**
+ * Find the items whose names are matched by the given name
+ * Same as filtering the items by cpe_name_match_one(cpe, item_name).
+ * @param count number of the found items
+ * @return the items in the dictionary order, to be freed by the caller
+ */
+struct cpe_item **cpe_dict_index_find(const struct cpe_dict_index *index, const struct cpe_name *cpe, size_t *count);
+
+#endif
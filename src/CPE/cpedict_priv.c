@@ -157,9 +157,36 @@ OSCAP_ACCESSOR_STRING(cpe_generator, product_name)
 
 OSCAP_GETTER(struct cpe_generator *, cpe_dict_model, generator)
 OSCAP_ACCESSOR_SIMPLE(int, cpe_dict_model, base_version)
-OSCAP_IGETINS_GEN(cpe_item, cpe_dict_model, items, item) OSCAP_ITERATOR_REMOVE_F(cpe_item)
+OSCAP_IGETTER_GEN(cpe_item, cpe_dict_model, items) OSCAP_ITERATOR_REMOVE_F(cpe_item)
 OSCAP_IGETINS_GEN(cpe_vendor, cpe_dict_model, vendors, vendor) OSCAP_ITERATOR_REMOVE_F(cpe_vendor)
 
+bool cpe_dict_model_add_item(struct cpe_dict_model *dict, struct cpe_item *item)
+{
+	oscap_list_add(dict->items, item);
+
+	pthread_mutex_lock(&dict->index_lock);
+	cpe_dict_index_free(dict->index);
+	dict->index = NULL;
+	pthread_mutex_unlock(&dict->index_lock);
+	return true;
+}
+
+struct cpe_dict_index *cpe_dict_model_get_index(struct cpe_dict_model *dict)
+{
+	pthread_mutex_lock(&dict->index_lock);
+	// items may have been removed through the iterator
+	if (dict->index != NULL && cpe_dict_index_get_count(dict->index) != (size_t)oscap_list_get_itemcount(dict->items)) {
+		cpe_dict_index_free(dict->index);
+		dict->index = NULL;
+	}
+	if (dict->index == NULL)
+		dict->index = cpe_dict_index_new(dict->items);
+	struct cpe_dict_index *index = dict->index;
+	pthread_mutex_unlock(&dict->index_lock);
+
+	return index;
+}
+
 /* ****************************************
  * Component-tree structures
  * ***************************************/
@@ -309,6 +336,7 @@ struct cpe_dict_model *cpe_dict_model_new()
 
 	dict->vendors = oscap_list_new();
 	dict->items = oscap_list_new();
+	pthread_mutex_init(&dict->index_lock, NULL);
 
 	dict->base_version = 2; // default to CPE 2.x
 
@@ -537,6 +565,8 @@ struct cpe_dict_model *cpe_dict_model_parse(struct cpe_parser_ctx *ctx)
 			return NULL;
 		}
 	}
+	if (next_ret == -1)
+		return NULL;
 
 	// make sure we exit when we reach this depth again
 	int entry_depth = xmlTextReaderDepth(reader);
@@ -566,7 +596,7 @@ struct cpe_dict_model *cpe_dict_model_parse(struct cpe_parser_ctx *ctx)
 
 	// go through elements and switch through actions till end of file..
 	next_ret = xmlTextReaderNextElementWE(reader, TAG_CPE_LIST_STR);
-	while (next_ret != 0) {
+	while (next_ret == 1) {
 		if (xmlTextReaderDepth(reader) <= entry_depth) {
 			// we have reached the end of <cpe-list>
 			// this is necessary to make XCCDF CPE integration to work
@@ -601,6 +631,11 @@ struct cpe_dict_model *cpe_dict_model_parse(struct cpe_parser_ctx *ctx)
 
 		next_ret = xmlTextReaderNextElementWE(reader, TAG_CPE_LIST_STR);
 	}
+	if (next_ret == -1) {
+		// the document is malformed or cut off
+		cpe_dict_model_free(ret);
+		return NULL;
+	}
 
 	return ret;
 }
@@ -622,9 +657,9 @@ struct cpe_generator *cpe_generator_parse(struct cpe_parser_ctx *ctx)
 			return NULL;
 
 		// skip nodes until new element
-		xmlTextReaderNextElement(reader);
+		int next_ret = xmlTextReaderNextElement(reader);
 
-		while (xmlStrcmp(xmlTextReaderConstLocalName(reader), TAG_GENERATOR_STR) != 0) {
+		while (next_ret == 1 && xmlStrcmp(xmlTextReaderConstLocalName(reader), TAG_GENERATOR_STR) != 0) {
 
 			if ((xmlStrcmp(xmlTextReaderConstLocalName(reader),
 				       TAG_PRODUCT_NAME_STR) == 0) &&
@@ -653,9 +688,13 @@ struct cpe_generator *cpe_generator_parse(struct cpe_parser_ctx *ctx)
 			}
 			// element saved. Let's jump on the very next one node (not element, because we need to 
 			// find XML_READER_TYPE_END_ELEMENT node, see "while" condition and the condition below "while"
-			xmlTextReaderNextNode(reader);
+			next_ret = xmlTextReaderNextNode(reader);
 
 		}
+		if (next_ret == -1) {
+			cpe_generator_free(ret);
+			return NULL;
+		}
 	}
 
 	return ret;
@@ -716,13 +755,13 @@ struct cpe_item *cpe_item_parse(struct cpe_parser_ctx *ctx)
 		free(data);
 		// ************************************************************************************
 
-		xmlTextReaderNextElementWE(reader, TAG_CPE_ITEM_STR);
+		int next_ret = xmlTextReaderNextElementWE(reader, TAG_CPE_ITEM_STR);
 		// Now it's time to go deaply to cpe-item element and parse it's children
 		// Do while there is another cpe-item element. Then return.
-		while (xmlStrcmp(xmlTextReaderConstLocalName(reader), TAG_CPE_ITEM_STR) != 0) {
+		while (next_ret == 1 && xmlStrcmp(xmlTextReaderConstLocalName(reader), TAG_CPE_ITEM_STR) != 0) {
 
 			if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT) {
-				xmlTextReaderNextNode(reader);
+				next_ret = xmlTextReaderNextNode(reader);
 				continue;
 			}
 
@@ -777,7 +816,11 @@ struct cpe_item *cpe_item_parse(struct cpe_parser_ctx *ctx)
 			} else {
 				return ret;	// <-- we need to return here, because we don't want to jump to next element 
 			}
-			xmlTextReaderNextElementWE(reader, TAG_CPE_ITEM_STR);
+			next_ret = xmlTextReaderNextElementWE(reader, TAG_CPE_ITEM_STR);
+		}
+		if (next_ret == -1) {
+			cpe_item_free(ret);
+			return NULL;
 		}
 	}
 
@@ -837,10 +880,10 @@ static struct cpe_notes *cpe_notes_parse(xmlTextReaderPtr reader)
 	struct cpe_notes *notes = cpe_notes_new();
 	notes->lang = (char *) xmlTextReaderXmlLang(reader);
 	if (xmlTextReaderIsEmptyElement(reader) == 0) { // element contains child nodes
-		xmlTextReaderNextNode(reader);
-		while (xmlStrcmp(xmlTextReaderConstLocalName(reader), TAG_NOTES_STR) != 0) {
+		int next_ret = xmlTextReaderNextNode(reader);
+		while (next_ret == 1 && xmlStrcmp(xmlTextReaderConstLocalName(reader), TAG_NOTES_STR) != 0) {
 			if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT) {
-				xmlTextReaderNextNode(reader);
+				next_ret = xmlTextReaderNextNode(reader);
 				continue;
 			}
 
@@ -853,7 +896,11 @@ static struct cpe_notes *cpe_notes_parse(xmlTextReaderPtr reader)
 				cpe_notes_free(notes);
 				return NULL;
 			}
-			xmlTextReaderNextNode(reader);
+			next_ret = xmlTextReaderNextNode(reader);
+		}
+		if (next_ret == -1) {
+			cpe_notes_free(notes);
+			return NULL;
 		}
 	}
 
@@ -882,12 +929,12 @@ struct cpe_vendor *cpe_vendor_parse(xmlTextReaderPtr reader)
 
 	ret->value = (char *)xmlTextReaderGetAttribute(reader, ATTR_VALUE_STR);
 	// jump to next element (which should be product)
-	xmlTextReaderNextElement(reader);
+	int next_ret = xmlTextReaderNextElement(reader);
 
-	while (xmlStrcmp(xmlTextReaderConstLocalName(reader), TAG_VENDOR_STR) != 0) {
+	while (next_ret == 1 && xmlStrcmp(xmlTextReaderConstLocalName(reader), TAG_VENDOR_STR) != 0) {
 
 		if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT) {
-			xmlTextReaderNextNode(reader);
+			next_ret = xmlTextReaderNextNode(reader);
 			continue;
 		}
 
@@ -944,7 +991,11 @@ struct cpe_vendor *cpe_vendor_parse(xmlTextReaderPtr reader)
 			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Unknown XML element withinin CPE vendor element, local name is '%s'.",
 				xmlTextReaderConstLocalName(reader));
 		}
-		xmlTextReaderNextNode(reader);
+		next_ret = xmlTextReaderNextNode(reader);
+	}
+	if (next_ret == -1) {
+		cpe_vendor_free(ret);
+		return NULL;
 	}
 	return ret;
 
@@ -1307,6 +1358,8 @@ void cpe_dict_model_free(struct cpe_dict_model *dict)
 	if (dict == NULL)
 		return;
 
+	cpe_dict_index_free(dict->index);
+	pthread_mutex_destroy(&dict->index_lock);
 	oscap_list_free(dict->items, (oscap_destruct_func) cpe_item_free);
 	oscap_list_free(dict->vendors, (oscap_destruct_func) cpe_vendor_free);
 	cpe_generator_free(dict->generator);
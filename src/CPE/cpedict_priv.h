@@ -33,10 +33,12 @@
 #include <libxml/xmlreader.h>
 #include <libxml/xmlwriter.h>
 #include <stdlib.h>
+#include <pthread.h>
 
 #include "cpe_name.h"
 #include "cpe_ctx_priv.h"
 #include "cpe_dict.h"
+#include "cpedict_index_priv.h"
 
 #include "../common/public/oscap.h"
 #include "../common/util.h"
@@ -128,8 +130,18 @@ struct cpe_dict_model {		// the main node
 	int base_version;
 	struct cpe_generator *generator;
 	char* origin_file;
+	struct cpe_dict_index *index;	// built by the first match
+	pthread_mutex_t index_lock;
 };
 
+/**
+ * Get the component index of the dictionary items
+ * The index is built on the first call and rebuilt when items are added
+ * or removed; it doesn't notice names of the items modified in place.
+ * @param dict CPE dictionary
+ */
+struct cpe_dict_index *cpe_dict_model_get_index(struct cpe_dict_model *dict);
+
 /** 
  * @cond INTERNAL
  */
@@ -224,6 +224,10 @@ struct cpe_lang_model *cpe_lang_model_import_source(struct oscap_source *source)
 	if (reader != NULL) {
 		xmlTextReaderNextNode(reader);
 		ret = cpe_lang_model_parse(reader);
+		if (ret != NULL && oscap_source_xmlTextReader_failed(reader)) {
+			cpe_lang_model_free(ret);
+			ret = NULL;
+		}
 		if (ret != NULL) {
 			cpe_lang_model_set_origin_file(ret, oscap_source_readable_origin(source));
 		}
@@ -248,14 +252,19 @@ struct cpe_lang_model *cpe_lang_model_parse(xmlTextReaderPtr reader)
 			return NULL;
 
 		// skip nodes until new element
-		xmlTextReaderNextElementWE(reader, TAG_PLATFORM_SPEC_STR);
+		int next_ret = xmlTextReaderNextElementWE(reader, TAG_PLATFORM_SPEC_STR);
 
-		while (xmlStrcmp(xmlTextReaderConstLocalName(reader), TAG_PLATFORM_STR) == 0) {
+		while (next_ret == 1 && xmlStrcmp(xmlTextReaderConstLocalName(reader), TAG_PLATFORM_STR) == 0) {
 
 			platform = cpe_platform_parse(reader);
 			if (platform)
 				cpe_lang_model_add_platform(ret, platform);
-			xmlTextReaderNextElementWE(reader, TAG_PLATFORM_SPEC_STR);
+			next_ret = xmlTextReaderNextElementWE(reader, TAG_PLATFORM_SPEC_STR);
+		}
+		if (next_ret == -1) {
+			// the document is malformed or cut off
+			cpe_lang_model_free(ret);
+			return NULL;
 		}
 	}
 
@@ -281,12 +290,12 @@ struct cpe_platform *cpe_platform_parse(xmlTextReaderPtr reader)
 		return NULL;	// if there is no "id" in platform element, return NULL
 	}
 	// skip from <platform> node to next one
-	xmlTextReaderNextNode(reader);
+	int next_ret = xmlTextReaderNextNode(reader);
 
 	// while we have element that is not "platform", it is inside this element, otherwise it's ended 
 	// element </platform> and we should end. If there is no one from "if" statement cases, we are parsing
 	// attribute or text ,.. and we can continue to next node.
-	while (xmlStrcmp(xmlTextReaderConstLocalName(reader), TAG_PLATFORM_STR) != 0) {
+	while (next_ret == 1 && xmlStrcmp(xmlTextReaderConstLocalName(reader), TAG_PLATFORM_STR) != 0) {
 
 		if (!xmlStrcmp(xmlTextReaderConstLocalName(reader), ATTR_TITLE_STR) &&
 		    xmlTextReaderNodeType(reader) == XML_READER_TYPE_ELEMENT) {
@@ -304,7 +313,11 @@ struct cpe_platform *cpe_platform_parse(xmlTextReaderPtr reader)
 		} else if (xmlTextReaderNodeType(reader) == XML_READER_TYPE_ELEMENT)
 			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Unknown XML element in platform");
 		// get the next node
-		xmlTextReaderNextNode(reader);
+		next_ret = xmlTextReaderNextNode(reader);
+	}
+	if (next_ret == -1) {
+		cpe_platform_free(ret);
+		return NULL;
 	}
 	return ret;
 }
@@ -435,7 +448,7 @@ static char *parse_text_element(xmlTextReaderPtr reader, char *name)
 
 	// parse string element attributes here (like xml:lang)
 
-	while (xmlTextReaderNextNode(reader)) {
+	while (xmlTextReaderNextNode(reader) == 1) {
 		if (xmlTextReaderNodeType(reader) == XML_READER_TYPE_END_ELEMENT &&
 		    !xmlStrcmp(xmlTextReaderConstLocalName(reader), BAD_CAST name)) {
 			return string;
@@ -41,6 +41,7 @@
 #include <ctype.h>
 
 #include "cpe_name.h"
+#include "cpename_priv.h"
 #include "common/util.h"
 
 #define CPE_URI_SUPPORTED "2.3"
@@ -63,7 +64,7 @@ enum cpe_field_t {
 	CPE_FIELD_TARGET_HW = 9,
 	CPE_FIELD_OTHER = 10,
 
-	CPE_TOTAL_FIELDNUM = 11
+	CPE_TOTAL_FIELDNUM = CPE_NAME_FIELDNUM
 };
 
 struct cpe_name {
@@ -524,6 +525,19 @@ static char *cpe_pack_extended_attributes(const struct cpe_name *cpe)
 	return ret;
 }
 
+int cpe_name_get_fields(const struct cpe_name *cpe, const char **fields)
+{
+	int i, num = 0;
+
+	for (i = 0; i < CPE_TOTAL_FIELDNUM; ++i) {
+		fields[i] = cpe_get_field(cpe, i);
+		if (fields[i] != NULL)
+			num = i + 1;
+	}
+
+	return num;
+}
+
 bool cpe_name_match_one(const struct cpe_name * cpe, const struct cpe_name * against)
 {
 
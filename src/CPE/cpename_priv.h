@@ -0,0 +1,36 @@
+/*
+ * Copyright 2009 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef CPENAME_PRIV_H_
+#define CPENAME_PRIV_H_
+
+#include "cpe_name.h"
+
+/// number of fields of a CPE name (part, vendor, ..., other)
+#define CPE_NAME_FIELDNUM 11
+
+/**
+ * Get the fields of a CPE name in the order cpe_name_match_one() compares them
+ * @param cpe CPE name
+ * @param fields array of CPE_NAME_FIELDNUM fields to fill, NULL for unset fields
+ * @return number of fields up to the last one that is set
+ */
+int cpe_name_get_fields(const struct cpe_name *cpe, const char **fields);
+
+#endif
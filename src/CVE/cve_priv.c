@@ -419,6 +419,10 @@ struct cve_model *cve_model_parse_xml(const char *file)
 	}
 
 	ret = cve_model_parse(reader);
+	if (ret != NULL && oscap_source_xmlTextReader_failed(reader)) {
+		cve_model_free(ret);
+		ret = NULL;
+	}
 
 	xmlFreeTextReader(reader);
 	oscap_source_free(source);
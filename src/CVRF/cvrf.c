@@ -69,6 +69,10 @@ struct cvrf_model *cvrf_model_import(struct oscap_source *source) {
 		return NULL;
 	}
 	struct cvrf_model *model = cvrf_model_parse(reader);
+	if (model != NULL && oscap_source_xmlTextReader_failed(reader)) {
+		cvrf_model_free(model);
+		model = NULL;
+	}
 	xmlFreeTextReader(reader);
 	return model;
 }
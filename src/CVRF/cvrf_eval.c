@@ -71,6 +71,14 @@ struct cvrf_session {
 	struct oscap_source *source;
 	struct oscap_stringlist *product_ids;
 	struct oval_definition_model *def_model;
+	struct oscap_htable *product_vulns;	// product id -> struct cvrf_product_vulns
+};
+
+/* Vulnerabilities whose product statuses list a product */
+struct cvrf_product_vulns {
+	size_t *positions;	// in the order of the model's vulnerabilities
+	size_t count;
+	size_t alloc;
 };
 OSCAP_ACCESSOR_SIMPLE(struct cvrf_index*, cvrf_session, index)
 OSCAP_ACCESSOR_STRING(cvrf_session, os_name);
@@ -96,6 +104,7 @@ struct cvrf_session *cvrf_session_new_from_source_model(struct oscap_source *sou
 	ret->os_name = NULL;
 	ret->product_ids = oscap_stringlist_new();
 	ret->def_model = oval_definition_model_new();
+	ret->product_vulns = NULL;
 	return ret;
 }
 
@@ -110,13 +119,78 @@ struct cvrf_session *cvrf_session_new_from_source_index(struct oscap_source *sou
 	ret->os_name = NULL;
 	ret->product_ids = oscap_stringlist_new();
 	ret->def_model = oval_definition_model_new();
+	ret->product_vulns = NULL;
 	return ret;
 }
 
+static void cvrf_product_vulns_free(struct cvrf_product_vulns *vulns) {
+	if (vulns == NULL)
+		return;
+
+	free(vulns->positions);
+	free(vulns);
+}
+
+static void cvrf_session_free_product_vulns(struct cvrf_session *session) {
+	oscap_htable_free(session->product_vulns, (oscap_destruct_func) cvrf_product_vulns_free);
+	session->product_vulns = NULL;
+}
+
+/*
+ * Index the vulnerabilities by the product ids of their statuses, so that
+ * the evaluation doesn't have to scan all the statuses for every product.
+ */
+static void cvrf_session_index_model(struct cvrf_session *session) {
+	size_t statuses = 0, position = 0;
+
+	cvrf_session_free_product_vulns(session);
+
+	struct cvrf_vulnerability_iterator *it = cvrf_model_get_vulnerabilities(session->model);
+	while (cvrf_vulnerability_iterator_has_more(it)) {
+		struct cvrf_product_status_iterator *stats = cvrf_vulnerability_get_product_statuses(cvrf_vulnerability_iterator_next(it));
+		while (cvrf_product_status_iterator_has_more(stats)) {
+			cvrf_product_status_iterator_next(stats);
+			statuses++;
+		}
+		cvrf_product_status_iterator_free(stats);
+	}
+	cvrf_vulnerability_iterator_reset(it);
+
+	session->product_vulns = oscap_htable_new1((oscap_compare_func) strcmp, statuses * 4 + 1);
+	while (cvrf_vulnerability_iterator_has_more(it)) {
+		struct cvrf_vulnerability *vuln = cvrf_vulnerability_iterator_next(it);
+		struct cvrf_product_status_iterator *stats = cvrf_vulnerability_get_product_statuses(vuln);
+		while (cvrf_product_status_iterator_has_more(stats)) {
+			struct oscap_string_iterator *product_ids = cvrf_product_status_get_ids(cvrf_product_status_iterator_next(stats));
+			while (oscap_string_iterator_has_more(product_ids)) {
+				const char *product_id = oscap_string_iterator_next(product_ids);
+				struct cvrf_product_vulns *vulns = oscap_htable_get(session->product_vulns, product_id);
+				if (vulns == NULL) {
+					vulns = calloc(1, sizeof(struct cvrf_product_vulns));
+					oscap_htable_add(session->product_vulns, product_id, vulns);
+				}
+				if (vulns->count > 0 && vulns->positions[vulns->count - 1] == position)
+					continue;
+				if (vulns->count == vulns->alloc) {
+					vulns->alloc = vulns->alloc ? vulns->alloc * 2 : 4;
+					vulns->positions = realloc(vulns->positions, vulns->alloc * sizeof(size_t));
+				}
+				vulns->positions[vulns->count++] = position;
+			}
+			oscap_string_iterator_free(product_ids);
+		}
+		cvrf_product_status_iterator_free(stats);
+		position++;
+	}
+	cvrf_vulnerability_iterator_free(it);
+}
+
 void cvrf_session_free(struct cvrf_session *session) {
 	if (session == NULL)
 		return;
 
+	cvrf_session_free_product_vulns(session);
+
 	cvrf_index_free(session->index);
 	cvrf_model_free(session->model);
 	free(session->os_name);
@@ -192,6 +266,19 @@ static xmlNode *cvrf_model_results_to_dom(struct cvrf_session *session) {
 	cvrf_element_add_child("DocumentType", cvrf_model_get_doc_type(session->model), root_node);
 	xmlAddChildList(root_node, cvrf_document_to_dom(cvrf_model_get_document(session->model)));
 
+	cvrf_session_index_model(session);
+
+	// vulnerabilities of each product, walked along with the vulnerabilities of the model
+	size_t product_count = oscap_list_get_itemcount((struct oscap_list *)session->product_ids);
+	struct cvrf_product_vulns **product_vulns = malloc((product_count + 1) * sizeof(struct cvrf_product_vulns *));
+	size_t *next = calloc(product_count + 1, sizeof(size_t));
+	size_t i = 0;
+	struct oscap_string_iterator *product_ids = cvrf_session_get_product_ids(session);
+	while (oscap_string_iterator_has_more(product_ids))
+		product_vulns[i++] = oscap_htable_get(session->product_vulns, oscap_string_iterator_next(product_ids));
+	oscap_string_iterator_free(product_ids);
+
+	size_t position = 0;
 	struct cvrf_vulnerability_iterator *it = cvrf_model_get_vulnerabilities(session->model);
 	while (cvrf_vulnerability_iterator_has_more(it)) {
 		struct cvrf_vulnerability *vuln = cvrf_vulnerability_iterator_next(it);
@@ -199,22 +286,29 @@ static xmlNode *cvrf_model_results_to_dom(struct cvrf_session *session) {
 		xmlAddChild(root_node, vuln_node);
 		xmlNode *results_node = xmlNewTextChild(vuln_node, NULL, BAD_CAST "Results", NULL);
 
-		struct oscap_string_iterator *product_ids = cvrf_session_get_product_ids(session);
+		i = 0;
+		product_ids = cvrf_session_get_product_ids(session);
 		while (oscap_string_iterator_has_more(product_ids)) {
 			const char *product_id = oscap_string_iterator_next(product_ids);
 			xmlNode *result_node = xmlNewTextChild(results_node, NULL, BAD_CAST "Result", NULL);
 			cvrf_element_add_child("ProductID", product_id, result_node);
 
-			if (cvrf_product_vulnerability_fixed(vuln, product_id)) {
+			struct cvrf_product_vulns *vulns = product_vulns[i];
+			if (vulns != NULL && next[i] < vulns->count && vulns->positions[next[i]] == position) {
+				next[i]++;
 				cvrf_element_add_child("VulnerabilityStatus", "FIXED", result_node);
 			}
 			else {
 				cvrf_element_add_child("VulnerabilityStatus", "VULNERABLE", result_node);
 			}
+			i++;
 		}
 		oscap_string_iterator_free(product_ids);
+		position++;
 	}
 	cvrf_vulnerability_iterator_free(it);
+	free(product_vulns);
+	free(next);
 	return root_node;
 }
 
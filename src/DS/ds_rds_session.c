@@ -72,6 +72,10 @@ void ds_rds_session_free(struct ds_rds_session *rds_session)
 struct rds_index *ds_rds_session_get_rds_idx(struct ds_rds_session *session)
 {
 	if (session->index == NULL) {
+		// The components are looked up in the DOM, let the index be read from it as well
+		if (oscap_source_get_xmlDoc(session->source) == NULL) {
+			return NULL;
+		}
 		xmlTextReader *reader = oscap_source_get_xmlTextReader(session->source);
 		if (reader == NULL) {
 			return NULL;
@@ -36,6 +36,7 @@
 #include "ds_common.h"
 #include "ds_sds_session.h"
 #include "ds_sds_session_priv.h"
+#include "sds_cache_priv.h"
 #include "sds_index_priv.h"
 #include "sds_priv.h"
 #include "source/oscap_source_priv.h"
@@ -53,6 +54,7 @@ struct ds_sds_session {
 	struct oscap_htable *component_sources;	///< oscap_source for parsed components
 	bool fetch_remote_resources;            ///< Allows loading of external components;
 	download_progress_calllback_t progress;	///< Callback to report progress of download.
+	struct ds_sds_cache *cache;             ///< Content cache entry of the current selection
 };
 
 /**
@@ -84,6 +86,7 @@ void ds_sds_session_free(struct ds_sds_session *sds_session)
 			oscap_acquire_cleanup_dir(&(sds_session->temp_dir));
 		}
 		oscap_htable_free(sds_session->component_sources, (oscap_destruct_func) oscap_source_free);
+		ds_sds_cache_free(sds_session->cache);
 		free(sds_session);
 	}
 }
@@ -95,11 +98,53 @@ void ds_sds_session_reset(struct ds_sds_session *session)
 	session->target_dir = NULL;
 	oscap_htable_free(session->component_sources, (oscap_destruct_func) oscap_source_free);
 	session->component_sources = oscap_htable_new();
+	ds_sds_cache_free(session->cache);
+	session->cache = NULL;
+}
+
+bool ds_sds_session_cache_load(struct ds_sds_session *session, const char *selection)
+{
+	ds_sds_cache_free(session->cache);
+	session->cache = ds_sds_cache_open(session->source, selection);
+	if (!ds_sds_cache_is_hit(session->cache))
+		return false;
+
+	struct oscap_htable *components = ds_sds_cache_take_components(session->cache);
+	struct oscap_htable_iterator *hit = oscap_htable_iterator_new(components);
+	while (oscap_htable_iterator_has_more(hit)) {
+		const char *href;
+		void *component;
+		oscap_htable_iterator_next_kv(hit, &href, &component);
+		if (ds_sds_session_register_component_source(session, href, component) != 0)
+			oscap_source_free(component);
+	}
+	oscap_htable_iterator_free(hit);
+	oscap_htable_free0(components);
+	return true;
+}
+
+bool ds_sds_session_cache_validated(struct ds_sds_session *session)
+{
+	return ds_sds_cache_is_validated(session->cache);
+}
+
+void ds_sds_session_disable_cache(struct ds_sds_session *session)
+{
+	ds_sds_cache_disable(session->cache);
+}
+
+int ds_sds_session_cache_store(struct ds_sds_session *session, bool validated)
+{
+	return ds_sds_cache_store(session->cache, session->component_sources, validated);
 }
 
 struct ds_sds_index *ds_sds_session_get_sds_idx(struct ds_sds_session *session)
 {
 	if (session->index == NULL) {
+		// The components are looked up in the DOM, let the index be read from it as well
+		if (oscap_source_get_xmlDoc(session->source) == NULL) {
+			return NULL;
+		}
 		xmlTextReader *reader = oscap_source_get_xmlTextReader(session->source);
 		if (reader == NULL) {
 			return NULL;
@@ -181,8 +226,13 @@ struct oscap_source *ds_sds_session_select_checklist(struct ds_sds_session *sess
 	session->datastream_id = datastream_id;
 	session->checklist_id = component_id;
 
+	if (ds_sds_cache_is_hit(session->cache)) {
+		// The selection is a part of the cache key, the entry knows its result
+		session->datastream_id = ds_sds_cache_get_datastream_id(session->cache);
+		session->checklist_id = ds_sds_cache_get_checklist_id(session->cache);
+	}
 	// We only use benchmark ID if datastream ID and/or component ID were NOT supplied.
-	if (!datastream_id && !component_id && benchmark_id) {
+	else if (!datastream_id && !component_id && benchmark_id) {
 		if (ds_sds_index_select_checklist_by_benchmark_id(ds_sds_session_get_sds_idx(session), benchmark_id,
 				(const char **) &(session->datastream_id), (const char **) &(session->checklist_id)) != 0) {
 			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Failed to locate a datastream with component-ref "
@@ -206,6 +256,7 @@ struct oscap_source *ds_sds_session_select_checklist(struct ds_sds_session *sess
 			return NULL;
 		}
 	}
+	ds_sds_cache_set_checklist(session->cache, session->datastream_id, session->checklist_id);
 	if (ds_sds_session_register_component_with_dependencies(session, "checklists", session->checklist_id, session->checklist_id) != 0) {
 		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not extract %s with all dependencies from datastream.", session->checklist_id);
 		return NULL;
@@ -285,6 +336,10 @@ bool ds_sds_session_can_register_component(struct ds_sds_session *session, const
 
 int ds_sds_session_register_component_with_dependencies(struct ds_sds_session *session, const char *container_name, const char *component_id, const char *target_filename)
 {
+	if (ds_sds_cache_is_registered(session->cache, container_name, component_id, target_filename)) {
+		return 0;
+	}
+
 	xmlNode *datastream = ds_sds_session_get_selected_datastream(session);
 	if (!datastream) {
 		return -1;
@@ -316,9 +371,34 @@ int ds_sds_session_register_component_with_dependencies(struct ds_sds_session *s
 		return -1;
 	}
 
+	if (res == 0) {
+		ds_sds_cache_add_registration(session->cache, container_name, component_id, target_filename);
+	}
 	return res;
 }
 
+struct oscap_string_iterator *ds_sds_session_get_dictionaries(struct ds_sds_session *session)
+{
+	struct oscap_string_iterator *dictionaries = ds_sds_cache_get_dictionaries(session->cache);
+	if (dictionaries != NULL) {
+		return dictionaries;
+	}
+
+	struct ds_sds_index *sds_idx = ds_sds_session_get_sds_idx(session);
+	if (sds_idx == NULL) {
+		return NULL;
+	}
+	struct ds_stream_index *stream_idx = ds_sds_index_get_stream(sds_idx, session->datastream_id);
+	if (stream_idx == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not find any datastream of id '%s'", session->datastream_id);
+		return NULL;
+	}
+	dictionaries = ds_stream_index_get_dictionaries(stream_idx);
+	ds_sds_cache_set_dictionaries(session->cache, dictionaries);
+	oscap_string_iterator_free(dictionaries);
+	return ds_stream_index_get_dictionaries(stream_idx);
+}
+
 void ds_sds_session_set_remote_resources(struct ds_sds_session *session, bool allowed, download_progress_calllback_t callback)
 {
 	session->fetch_remote_resources = allowed;
@@ -41,5 +41,24 @@ const char *ds_sds_session_get_readable_origin(const struct ds_sds_session *sess
 bool ds_sds_session_fetch_remote_resources(struct ds_sds_session *session);
 download_progress_calllback_t ds_sds_session_remote_resources_progress(struct ds_sds_session *session);
 
+/**
+ * Look up the selection in the content cache (see sds_cache_priv.h). On a hit
+ * the cached components are registered and the datastream is parsed only
+ * if something not found in the cache is requested.
+ * @param selection string identifying the datastream, checklist and other
+ * components which are going to be selected
+ * @return true if the cached components were loaded
+ */
+bool ds_sds_session_cache_load(struct ds_sds_session *session, const char *selection);
+bool ds_sds_session_cache_validated(struct ds_sds_session *session);
+void ds_sds_session_disable_cache(struct ds_sds_session *session);
+int ds_sds_session_cache_store(struct ds_sds_session *session, bool validated);
+
+/**
+ * Get the CPE dictionaries of the selected datastream.
+ * @return iterator over the hrefs of the dictionaries or NULL on failure
+ */
+struct oscap_string_iterator *ds_sds_session_get_dictionaries(struct ds_sds_session *session);
+
 void download_progress_empty_calllback(bool warning, const char * format, ...);
 #endif
@@ -33,6 +33,7 @@
 #include "common/util.h"
 #include "common/list.h"
 #include "common/debug_priv.h"
+#include "common/xml_stream.h"
 
 #include "ds_common.h"
 #include "ds_rds_session.h"
@@ -215,13 +216,15 @@ xmlNodePtr ds_rds_create_report(xmlDocPtr target_doc, xmlNodePtr reports_node, x
 	xmlNodePtr report_content = xmlNewNode(arf_ns, BAD_CAST "content");
 	xmlAddChild(report, report_content);
 
-	xmlDOMWrapCtxtPtr wrap_ctxt = xmlDOMWrapNewCtxt();
-	xmlNodePtr res_node = NULL;
-	xmlDOMWrapCloneNode(wrap_ctxt, source_doc, xmlDocGetRootElement(source_doc),
-			&res_node, target_doc, NULL, 1, 0);
-	xmlAddChild(report_content, res_node);
-	xmlDOMWrapReconcileNamespaces(wrap_ctxt, res_node, 0);
-	xmlDOMWrapFreeCtxt(wrap_ctxt);
+	if (source_doc != NULL) {
+		xmlDOMWrapCtxtPtr wrap_ctxt = xmlDOMWrapNewCtxt();
+		xmlNodePtr res_node = NULL;
+		xmlDOMWrapCloneNode(wrap_ctxt, source_doc, xmlDocGetRootElement(source_doc),
+				&res_node, target_doc, NULL, 1, 0);
+		xmlAddChild(report_content, res_node);
+		xmlDOMWrapReconcileNamespaces(wrap_ctxt, res_node, 0);
+		xmlDOMWrapFreeCtxt(wrap_ctxt);
+	}
 
 	xmlAddChild(reports_node, report);
 
@@ -692,10 +695,14 @@ static void ds_rds_add_xccdf_test_results(xmlDocPtr doc, xmlNodePtr reports,
 	}
 }
 
-static int ds_rds_create_from_dom(xmlDocPtr* ret, xmlDocPtr sds_doc, xmlDocPtr xccdf_result_file_doc, struct oscap_htable* oval_result_sources, struct oscap_htable* oval_result_mapping, struct oscap_htable *arf_report_mapping)
+/*
+ * Create the ARF document with everything but the OVAL reports. The data
+ * stream is copied into the report request if sds_doc is given, the content
+ * of the report request is left empty otherwise. The reports element is
+ * not added to the root element yet.
+ */
+static xmlDocPtr ds_rds_create_doc(xmlDocPtr sds_doc, xmlDocPtr xccdf_result_file_doc, struct oscap_htable *arf_report_mapping, xmlNodePtr *arf_content_ret, xmlNodePtr *reports_ret)
 {
-	*ret = NULL;
-
 	xmlDocPtr doc = xmlNewDoc(BAD_CAST "1.0");
 	xmlNodePtr root = xmlNewNode(NULL, BAD_CAST "asset-report-collection");
 	xmlDocSetRootElement(doc, root);
@@ -721,13 +728,15 @@ static int ds_rds_create_from_dom(xmlDocPtr* ret, xmlDocPtr sds_doc, xmlDocPtr x
 
 	xmlNodePtr arf_content = xmlNewNode(arf_ns, BAD_CAST "content");
 
-	xmlDOMWrapCtxtPtr sds_wrap_ctxt = xmlDOMWrapNewCtxt();
-	xmlNodePtr sds_res_node = NULL;
-	xmlDOMWrapCloneNode(sds_wrap_ctxt, sds_doc, xmlDocGetRootElement(sds_doc),
-			&sds_res_node, doc, NULL, 1, 0);
-	xmlAddChild(arf_content, sds_res_node);
-	xmlDOMWrapReconcileNamespaces(sds_wrap_ctxt, sds_res_node, 0);
-	xmlDOMWrapFreeCtxt(sds_wrap_ctxt);
+	if (sds_doc != NULL) {
+		xmlDOMWrapCtxtPtr sds_wrap_ctxt = xmlDOMWrapNewCtxt();
+		xmlNodePtr sds_res_node = NULL;
+		xmlDOMWrapCloneNode(sds_wrap_ctxt, sds_doc, xmlDocGetRootElement(sds_doc),
+				&sds_res_node, doc, NULL, 1, 0);
+		xmlAddChild(arf_content, sds_res_node);
+		xmlDOMWrapReconcileNamespaces(sds_wrap_ctxt, sds_res_node, 0);
+		xmlDOMWrapFreeCtxt(sds_wrap_ctxt);
+	}
 
 	xmlAddChild(report_request, arf_content);
 
@@ -738,25 +747,106 @@ static int ds_rds_create_from_dom(xmlDocPtr* ret, xmlDocPtr sds_doc, xmlDocPtr x
 	ds_rds_add_xccdf_test_results(doc, reports, xccdf_result_file_doc,
 			relationships, assets, "collection1", arf_report_mapping);
 
+	*arf_content_ret = arf_content;
+	*reports_ret = reports;
+	return doc;
+}
+
+static xmlDocPtr ds_rds_get_oval_result_doc(const struct oscap_htable_item *report_mapping_item, struct oscap_htable* oval_result_sources, struct oscap_htable* oval_result_mapping)
+{
+	const char *oval_filename = report_mapping_item->key;
+	const char *report_file = oscap_htable_get(oval_result_mapping, oval_filename);
+	struct oscap_source *oval_source = oscap_htable_get(oval_result_sources, report_file);
+	return oscap_source_get_xmlDoc(oval_source);
+}
+
+static int ds_rds_create_from_dom(xmlDocPtr* ret, xmlDocPtr sds_doc, xmlDocPtr xccdf_result_file_doc, struct oscap_htable* oval_result_sources, struct oscap_htable* oval_result_mapping, struct oscap_htable *arf_report_mapping)
+{
+	*ret = NULL;
+
+	xmlNodePtr arf_content = NULL;
+	xmlNodePtr reports = NULL;
+	xmlDocPtr doc = ds_rds_create_doc(sds_doc, xccdf_result_file_doc, arf_report_mapping, &arf_content, &reports);
+
 	struct oscap_htable_iterator *hit = oscap_htable_iterator_new(arf_report_mapping);
 	while (oscap_htable_iterator_has_more(hit)) {
 		const struct oscap_htable_item *report_mapping_item = oscap_htable_iterator_next(hit);
-		const char *oval_filename = report_mapping_item->key;
 		const char *report_id = report_mapping_item->value;
-		const char *report_file = oscap_htable_get(oval_result_mapping, oval_filename);
-		struct oscap_source *oval_source = oscap_htable_get(oval_result_sources, report_file);
-		xmlDoc *oval_result_doc = oscap_source_get_xmlDoc(oval_source);
+		xmlDoc *oval_result_doc = ds_rds_get_oval_result_doc(report_mapping_item, oval_result_sources, oval_result_mapping);
 
 		ds_rds_create_report(doc, reports, oval_result_doc, report_id);
 	}
 	oscap_htable_iterator_free(hit);
 
-	xmlAddChild(root, reports);
+	xmlAddChild(xmlDocGetRootElement(doc), reports);
 
 	*ret = doc;
 	return 0;
 }
 
+/*
+ * Write the ARF document as it's assembled. The data stream and the OVAL
+ * results are written straight from their documents, only the small parts
+ * of the ARF (relationships, assets and XCCDF results) are built in memory.
+ * The output is the same as the one of ds_rds_create_from_dom().
+ */
+static int ds_rds_create_to_file(const char *target_file, xmlDocPtr sds_doc, xmlDocPtr xccdf_result_file_doc, struct oscap_htable* oval_result_sources, struct oscap_htable* oval_result_mapping, struct oscap_htable *arf_report_mapping)
+{
+	xmlNodePtr arf_content = NULL;
+	xmlNodePtr reports = NULL;
+	xmlDocPtr doc = ds_rds_create_doc(NULL, xccdf_result_file_doc, arf_report_mapping, &arf_content, &reports);
+	xmlNodePtr root = xmlDocGetRootElement(doc);
+	xmlAddChild(root, reports);
+
+	struct oscap_xml_stream *stream = oscap_xml_stream_new(target_file, doc);
+	if (stream == NULL) {
+		xmlFreeDoc(doc);
+		return -1;
+	}
+
+	oscap_xml_stream_push(stream, root);
+
+	/* report-requests/report-request/content */
+	xmlNodePtr report_request = arf_content->parent;
+	oscap_xml_stream_push(stream, report_request->parent);
+	oscap_xml_stream_push(stream, report_request);
+	oscap_xml_stream_push(stream, arf_content);
+	if (sds_doc != NULL) {
+		oscap_xml_stream_write_node(stream, sds_doc, xmlDocGetRootElement(sds_doc));
+	}
+	oscap_xml_stream_pop(stream);
+	oscap_xml_stream_pop(stream);
+	oscap_xml_stream_pop(stream);
+
+	oscap_xml_stream_push(stream, reports);
+	oscap_xml_stream_flush(stream);
+
+	struct oscap_htable_iterator *hit = oscap_htable_iterator_new(arf_report_mapping);
+	while (oscap_htable_iterator_has_more(hit)) {
+		const struct oscap_htable_item *report_mapping_item = oscap_htable_iterator_next(hit);
+		const char *report_id = report_mapping_item->value;
+		xmlDoc *oval_result_doc = ds_rds_get_oval_result_doc(report_mapping_item, oval_result_sources, oval_result_mapping);
+
+		xmlNodePtr report = ds_rds_create_report(doc, reports, NULL, report_id);
+		oscap_xml_stream_push(stream, report);
+		oscap_xml_stream_push(stream, report->children);
+		xmlNodePtr oval_result_root = oval_result_doc != NULL ? xmlDocGetRootElement(oval_result_doc) : NULL;
+		if (oval_result_root != NULL) {
+			oscap_xml_stream_write_node(stream, oval_result_doc, oval_result_root);
+		}
+		oscap_xml_stream_pop(stream);
+		oscap_xml_stream_pop(stream);
+	}
+	oscap_htable_iterator_free(hit);
+
+	oscap_xml_stream_pop(stream);
+	oscap_xml_stream_pop(stream);
+
+	int ret = oscap_xml_stream_close(stream) == 1 ? 0 : -1;
+	xmlFreeDoc(doc);
+	return ret;
+}
+
 struct oscap_source *ds_rds_create_source(struct oscap_source *sds_source, struct oscap_source *xccdf_result_source, struct oscap_htable *oval_result_sources, struct oscap_htable *oval_result_mapping, struct oscap_htable *arf_report_mapping, const char *target_file)
 {
 	xmlDoc *sds_doc = oscap_source_get_xmlDoc(sds_source);
@@ -776,6 +866,21 @@ struct oscap_source *ds_rds_create_source(struct oscap_source *sds_source, struc
 	return oscap_source_new_from_xmlDoc(rds_doc, target_file);
 }
 
+int ds_rds_export(struct oscap_source *sds_source, struct oscap_source *xccdf_result_source, struct oscap_htable *oval_result_sources, struct oscap_htable *oval_result_mapping, struct oscap_htable *arf_report_mapping, const char *target_file)
+{
+	xmlDoc *sds_doc = oscap_source_get_xmlDoc(sds_source);
+	if (sds_doc == NULL) {
+		return -1;
+	}
+	xmlDoc *result_file_doc = oscap_source_get_xmlDoc(xccdf_result_source);
+	if (result_file_doc == NULL) {
+		return -1;
+	}
+
+	return ds_rds_create_to_file(target_file, sds_doc, result_file_doc,
+			oval_result_sources, oval_result_mapping, arf_report_mapping);
+}
+
 int ds_rds_create(const char* sds_file, const char* xccdf_result_file, const char** oval_result_files, const char* target_file)
 {
 	struct oscap_source *sds_source = oscap_source_new_from_file(sds_file);
@@ -802,12 +907,7 @@ int ds_rds_create(const char* sds_file, const char* xccdf_result_file, const cha
 		}
 	}
 	if (result == 0) {
-		struct oscap_source *target_rds = ds_rds_create_source(sds_source, xccdf_result_source, oval_result_sources, oval_result_mapping, arf_report_mapping, target_file);
-		result = target_rds == NULL;
-		if (result == 0) {
-			result = oscap_source_save_as(target_rds, NULL);
-		}
-		oscap_source_free(target_rds);
+		result = ds_rds_export(sds_source, xccdf_result_source, oval_result_sources, oval_result_mapping, arf_report_mapping, target_file);
 	}
 	oscap_htable_free(oval_result_sources, (oscap_destruct_func) oscap_source_free);
 	oscap_htable_free(oval_result_mapping, (oscap_destruct_func) free);
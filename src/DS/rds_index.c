@@ -361,6 +361,10 @@ struct rds_index *rds_index_import(const char *file)
 
 	while (xmlTextReaderRead(reader) == 1 && xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT);
 	struct rds_index *ret = rds_index_parse(reader);
+	if (ret != NULL && oscap_source_xmlTextReader_failed(reader)) {
+		rds_index_free(ret);
+		ret = NULL;
+	}
 	xmlFreeTextReader(reader);
 	oscap_source_free(source);
 	return ret;
@@ -235,6 +235,8 @@ static int ds_sds_register_sce(struct ds_sds_session *session, xmlNodePtr compon
 	char *file_basename = oscap_basename((char*)relative_filepath);
 	char *sce_filename = oscap_sprintf("%s/%s/%s",ds_sds_session_get_target_dir(session), target_filename_dirname, file_basename);
 	free(file_basename);
+	// The scripts are written to the target directory, the cache can't provide them
+	ds_sds_session_disable_cache(session);
 	const int ret = ds_sds_dump_component_sce(component_inner_root->children, component_id, sce_filename);
 	free(sce_filename);
 	return ret;
@@ -302,6 +304,8 @@ static int ds_sds_dump_file_component(const char* external_file, const char* com
 {
 	int ret = 0;
 
+	// The component may change without changing the datastream
+	ds_sds_session_disable_cache(session);
 	struct oscap_source *source_file = load_referenced_source(session, external_file);
 	xmlDoc *doc = oscap_source_get_xmlDoc(source_file);
 
@@ -327,6 +331,7 @@ static int ds_dsd_dump_remote_component(const char* url, const char* component_i
 	int ret = 0;
 	size_t memory_size = 0;
 
+	ds_sds_session_disable_cache(session);
 	ds_sds_session_remote_resources_progress(session)(false, "Downloading: %s ... ", url);
 
 	char* mem = oscap_acquire_url_download(url, &memory_size);
@@ -0,0 +1,549 @@
+/*
+ * Copyright 2015 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "common/debug_priv.h"
+#include "common/oscap_acquire.h"
+#include "common/public/oscap.h"
+#include "common/public/oscap_error.h"
+#include "common/util.h"
+#include "source/oscap_source_priv.h"
+#include "OVAL/probes/crapi/crapi.h"
+#include "sds_cache_priv.h"
+
+#define DS_SDS_CACHE_MAGIC "openscap-sds-cache"
+#define DS_SDS_CACHE_FORMAT "1"
+#define DS_SDS_CACHE_MAXLINE 4096
+#define DS_SDS_CACHE_KEYLEN 32
+
+struct ds_sds_cache {
+	char *dir;                              ///< Cache directory
+	char *path;                             ///< Directory of the entry
+	bool hit;                               ///< The entry was found and loaded
+	bool disabled;                          ///< The entry must not be stored
+	bool validated;                         ///< The datastream passed the schema validation
+	char *datastream_id;                    ///< ID of the selected datastream
+	char *checklist_id;                     ///< ID of the selected checklist
+	struct oscap_stringlist *registrations; ///< Registered component-refs, see _registration_key()
+	struct oscap_stringlist *dictionaries;  ///< CPE dictionaries or NULL if not known
+	struct oscap_htable *components;        ///< Components loaded from the entry
+	struct oscap_stringlist *hrefs;         ///< Relative paths of the loaded components
+};
+
+static char *_registration_key(const char *container_name, const char *component_id, const char *target_filename)
+{
+	return oscap_sprintf("%s\t%s\t%s", container_name,
+			component_id != NULL ? component_id : "", target_filename != NULL ? target_filename : "");
+}
+
+/* The components are stored under their relative paths, these must stay inside the entry */
+static bool _is_safe_href(const char *href)
+{
+	if (href[0] == '\0' || href[0] == '/' || strchr(href, '\n') != NULL)
+		return false;
+	for (const char *segment = href; segment != NULL; segment = strchr(segment, '/')) {
+		if (*segment == '/')
+			segment++;
+		if (strncmp(segment, "..", 2) == 0 && (segment[2] == '/' || segment[2] == '\0'))
+			return false;
+	}
+	return true;
+}
+
+#ifndef _WIN32
+/*
+ * The loaded components are trusted to be the decomposed datastream and the
+ * manifest may skip the schema validation, so refuse the paths anybody else
+ * could have written
+ */
+static bool _is_trusted(const char *path, bool directory)
+{
+	struct stat st;
+	/* Only the cache directory itself may be a symlink */
+	if (lstat(path, &st) != 0)
+		return false;
+	if (directory ? !S_ISDIR(st.st_mode) : !S_ISREG(st.st_mode)) {
+		dW("Content cache path '%s' is not a %s.", path, directory ? "directory" : "regular file");
+		return false;
+	}
+	if (st.st_uid != geteuid() || (st.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+		dW("Content cache path '%s' is not owned by the current user or is writable by others.", path);
+		return false;
+	}
+	return true;
+}
+
+static bool _is_trusted_dir(const char *dir)
+{
+	struct stat st;
+	if (stat(dir, &st) != 0 || !S_ISDIR(st.st_mode))
+		return false;
+	if (st.st_uid != geteuid() || (st.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+		dW("Content cache directory '%s' is not owned by the current user or is writable by others.", dir);
+		return false;
+	}
+	return true;
+}
+
+/* Check every directory between the entry and the component as well */
+static bool _is_trusted_component(const char *path, size_t entry_len)
+{
+	char *p = oscap_strdup(path);
+	bool trusted = true;
+	for (char *slash = strchr(p + entry_len + 1, '/'); trusted && slash != NULL; slash = strchr(slash + 1, '/')) {
+		*slash = '\0';
+		trusted = _is_trusted(p, true);
+		*slash = '/';
+	}
+	free(p);
+	return trusted && _is_trusted(path, false);
+}
+
+static int _load_component(struct ds_sds_cache *cache, const char *href)
+{
+	if (!_is_safe_href(href))
+		return -1;
+
+	char *path = oscap_sprintf("%s/components/%s", cache->path, href);
+	if (!_is_trusted_component(path, strlen(cache->path))) {
+		free(path);
+		return -1;
+	}
+	struct oscap_source *source = oscap_source_new_map_file(path, href);
+	free(path);
+	if (source == NULL)
+		return -1;
+	if (!oscap_htable_add(cache->components, href, source)) {
+		oscap_source_free(source);
+		return -1;
+	}
+	oscap_stringlist_add_string(cache->hrefs, href);
+	return 0;
+}
+
+static int _load_manifest(struct ds_sds_cache *cache)
+{
+	if (!_is_trusted(cache->path, true))
+		return -1;
+	char *path = oscap_sprintf("%s/manifest", cache->path);
+	FILE *f = _is_trusted(path, false) ? fopen(path, "r") : NULL;
+	free(path);
+	if (f == NULL)
+		return -1;
+
+	char line[DS_SDS_CACHE_MAXLINE];
+	int ret = 0;
+	bool header = false;
+	cache->components = oscap_htable_new();
+	cache->hrefs = oscap_stringlist_new();
+	while (ret == 0 && fgets(line, sizeof(line), f) != NULL) {
+		size_t len = strlen(line);
+		if (len == 0 || line[len - 1] != '\n') {
+			ret = -1;
+			break;
+		}
+		line[len - 1] = '\0';
+
+		char *value = strchr(line, ' ');
+		if (value != NULL)
+			*value++ = '\0';
+
+		if (!header) {
+			header = true;
+			if (strcmp(line, DS_SDS_CACHE_MAGIC) != 0 || value == NULL || strcmp(value, DS_SDS_CACHE_FORMAT) != 0)
+				ret = -1;
+		} else if (strcmp(line, "dictionaries") == 0) {
+			if (cache->dictionaries == NULL)
+				cache->dictionaries = oscap_stringlist_new();
+		} else if (value == NULL) {
+			ret = -1;
+		} else if (strcmp(line, "datastream") == 0) {
+			free(cache->datastream_id);
+			cache->datastream_id = oscap_strdup(value);
+		} else if (strcmp(line, "checklist") == 0) {
+			free(cache->checklist_id);
+			cache->checklist_id = oscap_strdup(value);
+		} else if (strcmp(line, "validated") == 0) {
+			cache->validated = strcmp(value, "1") == 0;
+		} else if (strcmp(line, "dictionary") == 0) {
+			if (cache->dictionaries == NULL)
+				ret = -1;
+			else
+				oscap_stringlist_add_string(cache->dictionaries, value);
+		} else if (strcmp(line, "registered") == 0) {
+			oscap_stringlist_add_string(cache->registrations, value);
+		} else if (strcmp(line, "component") == 0) {
+			ret = _load_component(cache, value);
+		}
+		/* Unknown lines are ignored */
+	}
+	fclose(f);
+
+	if (ret != 0 || !header || cache->datastream_id == NULL || cache->checklist_id == NULL)
+		return -1;
+	return 0;
+}
+
+/* The key of the entry is the SHA-256 of the content, the version and the selection */
+static char *_entry_key(struct oscap_source *sds, const char *selection)
+{
+	const char *buffer;
+	size_t size;
+	struct oscap_source *mapped;
+	if (oscap_source_get_content(sds, &buffer, &size, &mapped) != 0) {
+		dD("Not caching '%s', its content is not available.", oscap_source_readable_origin(sds));
+		return NULL;
+	}
+
+	unsigned char digest[DS_SDS_CACHE_KEYLEN];
+	size_t digest_len = sizeof(digest);
+	const char *version = oscap_get_version();
+	void *ctx = crapi_init(NULL) == 0 ? crapi_sha256_init(digest, &digest_len) : NULL;
+	if (ctx == NULL) {
+		dW("Not caching '%s', SHA-256 is not available.", oscap_source_readable_origin(sds));
+		oscap_source_free(mapped);
+		return NULL;
+	}
+	/* Include the terminating null bytes so the fields can't run into each other */
+	if (crapi_sha256_update(ctx, (void *) buffer, size) != 0 ||
+	    crapi_sha256_update(ctx, (void *) version, strlen(version) + 1) != 0 ||
+	    crapi_sha256_update(ctx, (void *) selection, strlen(selection) + 1) != 0) {
+		crapi_sha256_free(ctx);
+		oscap_source_free(mapped);
+		return NULL;
+	}
+	oscap_source_free(mapped);
+	if (crapi_sha256_fini(ctx) != 0)
+		return NULL;
+
+	char *key = malloc(2 * DS_SDS_CACHE_KEYLEN + 1);
+	for (size_t i = 0; i < DS_SDS_CACHE_KEYLEN; i++)
+		sprintf(key + 2 * i, "%02x", digest[i]);
+	return key;
+}
+#endif
+
+static void _clear_entry(struct ds_sds_cache *cache)
+{
+	free(cache->datastream_id);
+	cache->datastream_id = NULL;
+	free(cache->checklist_id);
+	cache->checklist_id = NULL;
+	cache->validated = false;
+	oscap_stringlist_free(cache->registrations);
+	cache->registrations = oscap_stringlist_new();
+	oscap_stringlist_free(cache->dictionaries);
+	cache->dictionaries = NULL;
+	oscap_htable_free(cache->components, (oscap_destruct_func) oscap_source_free);
+	cache->components = NULL;
+	oscap_stringlist_free(cache->hrefs);
+	cache->hrefs = NULL;
+}
+
+struct ds_sds_cache *ds_sds_cache_open(struct oscap_source *sds, const char *selection)
+{
+#ifdef _WIN32
+	return NULL;
+#else
+	const char *dir = getenv(DS_SDS_CACHE_ENV);
+	if (dir == NULL || *dir == '\0')
+		return NULL;
+
+	/* An existing directory must be ours, a new one is created with 0700 */
+	if (access(dir, F_OK) == 0 && !_is_trusted_dir(dir))
+		return NULL;
+
+	char *key = _entry_key(sds, selection);
+	if (key == NULL)
+		return NULL;
+
+	struct ds_sds_cache *cache = calloc(1, sizeof(struct ds_sds_cache));
+	cache->dir = oscap_strdup(dir);
+	cache->path = oscap_sprintf("%s/%s", dir, key);
+	cache->registrations = oscap_stringlist_new();
+	free(key);
+
+	if (access(cache->path, F_OK) == 0) {
+		if (_load_manifest(cache) == 0) {
+			cache->hit = true;
+			dI("Loading '%s' from the content cache '%s'.", oscap_source_readable_origin(sds), cache->path);
+		} else {
+			dW("Ignoring invalid content cache entry '%s'.", cache->path);
+			_clear_entry(cache);
+			/* Leave the invalid entry alone, it may be in use */
+			cache->disabled = true;
+		}
+	}
+	return cache;
+#endif
+}
+
+void ds_sds_cache_free(struct ds_sds_cache *cache)
+{
+	if (cache != NULL) {
+		_clear_entry(cache);
+		oscap_stringlist_free(cache->registrations);
+		free(cache->dir);
+		free(cache->path);
+		free(cache);
+	}
+}
+
+bool ds_sds_cache_is_hit(const struct ds_sds_cache *cache)
+{
+	return cache != NULL && cache->hit;
+}
+
+void ds_sds_cache_disable(struct ds_sds_cache *cache)
+{
+	if (cache != NULL)
+		cache->disabled = true;
+}
+
+struct oscap_htable *ds_sds_cache_take_components(struct ds_sds_cache *cache)
+{
+	struct oscap_htable *components = cache->components;
+	cache->components = NULL;
+	return components;
+}
+
+const char *ds_sds_cache_get_datastream_id(const struct ds_sds_cache *cache)
+{
+	return cache->datastream_id;
+}
+
+const char *ds_sds_cache_get_checklist_id(const struct ds_sds_cache *cache)
+{
+	return cache->checklist_id;
+}
+
+void ds_sds_cache_set_checklist(struct ds_sds_cache *cache, const char *datastream_id, const char *checklist_id)
+{
+	if (cache == NULL || cache->hit)
+		return;
+	free(cache->datastream_id);
+	cache->datastream_id = oscap_strdup(datastream_id);
+	free(cache->checklist_id);
+	cache->checklist_id = oscap_strdup(checklist_id);
+}
+
+bool ds_sds_cache_is_validated(const struct ds_sds_cache *cache)
+{
+	return cache != NULL && cache->validated;
+}
+
+bool ds_sds_cache_is_registered(const struct ds_sds_cache *cache, const char *container_name, const char *component_id, const char *target_filename)
+{
+	if (!ds_sds_cache_is_hit(cache))
+		return false;
+
+	char *key = _registration_key(container_name, component_id, target_filename);
+	bool found = false;
+	struct oscap_string_iterator *it = oscap_stringlist_get_strings(cache->registrations);
+	while (!found && oscap_string_iterator_has_more(it))
+		found = strcmp(oscap_string_iterator_next(it), key) == 0;
+	oscap_string_iterator_free(it);
+	free(key);
+	return found;
+}
+
+void ds_sds_cache_add_registration(struct ds_sds_cache *cache, const char *container_name, const char *component_id, const char *target_filename)
+{
+	if (cache == NULL || cache->hit)
+		return;
+	char *key = _registration_key(container_name, component_id, target_filename);
+	oscap_stringlist_add_string(cache->registrations, key);
+	free(key);
+}
+
+struct oscap_string_iterator *ds_sds_cache_get_dictionaries(const struct ds_sds_cache *cache)
+{
+	if (!ds_sds_cache_is_hit(cache) || cache->dictionaries == NULL)
+		return NULL;
+	return oscap_stringlist_get_strings(cache->dictionaries);
+}
+
+void ds_sds_cache_set_dictionaries(struct ds_sds_cache *cache, struct oscap_string_iterator *dictionaries)
+{
+	if (cache == NULL || cache->hit)
+		return;
+	oscap_stringlist_free(cache->dictionaries);
+	cache->dictionaries = oscap_stringlist_new();
+	while (oscap_string_iterator_has_more(dictionaries))
+		oscap_stringlist_add_string(cache->dictionaries, oscap_string_iterator_next(dictionaries));
+}
+
+#ifndef _WIN32
+static int _write_manifest(const struct ds_sds_cache *cache, FILE *f, struct oscap_htable *components)
+{
+	fprintf(f, "%s %s\n", DS_SDS_CACHE_MAGIC, DS_SDS_CACHE_FORMAT);
+	fprintf(f, "datastream %s\n", cache->datastream_id);
+	fprintf(f, "checklist %s\n", cache->checklist_id);
+	fprintf(f, "validated %d\n", cache->validated ? 1 : 0);
+	if (cache->dictionaries != NULL) {
+		fprintf(f, "dictionaries\n");
+		struct oscap_string_iterator *it = oscap_stringlist_get_strings(cache->dictionaries);
+		while (oscap_string_iterator_has_more(it))
+			fprintf(f, "dictionary %s\n", oscap_string_iterator_next(it));
+		oscap_string_iterator_free(it);
+	}
+	struct oscap_string_iterator *it = oscap_stringlist_get_strings(cache->registrations);
+	while (oscap_string_iterator_has_more(it))
+		fprintf(f, "registered %s\n", oscap_string_iterator_next(it));
+	oscap_string_iterator_free(it);
+	if (components != NULL) {
+		struct oscap_htable_iterator *hit = oscap_htable_iterator_new(components);
+		while (oscap_htable_iterator_has_more(hit))
+			fprintf(f, "component %s\n", oscap_htable_iterator_next_key(hit));
+		oscap_htable_iterator_free(hit);
+	} else if (cache->hrefs != NULL) {
+		it = oscap_stringlist_get_strings(cache->hrefs);
+		while (oscap_string_iterator_has_more(it))
+			fprintf(f, "component %s\n", oscap_string_iterator_next(it));
+		oscap_string_iterator_free(it);
+	}
+	return ferror(f) ? -1 : 0;
+}
+
+/* Replace the manifest of an existing entry */
+static int _update_manifest(const struct ds_sds_cache *cache)
+{
+	char *path = oscap_sprintf("%s/manifest", cache->path);
+	char *tmp = oscap_sprintf("%s.XXXXXX", path);
+	int ret = -1;
+	int fd = mkstemp(tmp);
+	FILE *f = fd != -1 ? fdopen(fd, "w") : NULL;
+	if (f != NULL) {
+		/* The components stay the same, list the loaded ones */
+		ret = _write_manifest(cache, f, NULL);
+		if (fclose(f) != 0 || ret != 0 || rename(tmp, path) != 0) {
+			unlink(tmp);
+			ret = -1;
+		}
+	} else if (fd != -1) {
+		close(fd);
+		unlink(tmp);
+	}
+	free(tmp);
+	free(path);
+	return ret;
+}
+
+static int _store_entry(const struct ds_sds_cache *cache, struct oscap_htable *components)
+{
+	if (mkdir(cache->dir, 0700) != 0 && errno != EEXIST) {
+		dW("Can't create the content cache directory '%s': %s", cache->dir, strerror(errno));
+		return -1;
+	}
+	if (!_is_trusted_dir(cache->dir))
+		return -1;
+
+	char *tmp = oscap_sprintf("%s.XXXXXX", cache->path);
+	if (mkdtemp(tmp) == NULL) {
+		dW("Can't create the content cache entry '%s': %s", cache->path, strerror(errno));
+		free(tmp);
+		return -1;
+	}
+
+	int ret = 0;
+	struct oscap_htable_iterator *hit = oscap_htable_iterator_new(components);
+	while (ret == 0 && oscap_htable_iterator_has_more(hit)) {
+		const char *href;
+		void *source;
+		oscap_htable_iterator_next_kv(hit, &href, &source);
+		if (!_is_safe_href(href)) {
+			dD("Not caching the component '%s', its path leaves the cache entry.", href);
+			ret = -1;
+			break;
+		}
+		char *path = oscap_sprintf("%s/components/%s", tmp, href);
+		/* The files must not be writable by others whatever the umask is */
+		if (oscap_acquire_ensure_parent_dir(path) < 0 || oscap_source_save_as(source, path) != 0 ||
+		    chmod(path, S_IRUSR | S_IWUSR) != 0)
+			ret = -1;
+		free(path);
+	}
+	oscap_htable_iterator_free(hit);
+
+	if (ret == 0) {
+		char *path = oscap_sprintf("%s/manifest", tmp);
+		int fd = open(path, O_WRONLY | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+		free(path);
+		FILE *f = fd != -1 ? fdopen(fd, "w") : NULL;
+		if (f == NULL || _write_manifest(cache, f, components) != 0)
+			ret = -1;
+		if (f != NULL && fclose(f) != 0)
+			ret = -1;
+		else if (f == NULL && fd != -1)
+			close(fd);
+	}
+
+	/* Another process may have stored the same entry meanwhile, keep that one */
+	if (ret != 0 || rename(tmp, cache->path) != 0) {
+		oscap_acquire_cleanup_dir(&tmp);
+		return ret;
+	}
+	free(tmp);
+	dI("Stored the content cache entry '%s'.", cache->path);
+	return 0;
+}
+#endif
+
+int ds_sds_cache_store(struct ds_sds_cache *cache, struct oscap_htable *components, bool validated)
+{
+#ifdef _WIN32
+	return 0;
+#else
+	if (cache == NULL || cache->disabled || cache->datastream_id == NULL || cache->checklist_id == NULL)
+		return 0;
+
+	int ret = 0;
+	if (cache->hit) {
+		if (validated && !cache->validated) {
+			cache->validated = true;
+			ret = _update_manifest(cache);
+		}
+	} else {
+		cache->validated = validated;
+		ret = _store_entry(cache, components);
+		/* Store the entry only once */
+		cache->disabled = true;
+	}
+	if (ret != 0) {
+		dW("Failed to write the content cache entry '%s'.", cache->path);
+		/* The cache is optional, don't report its failures to the caller */
+		oscap_clearerr();
+	}
+	return ret;
+#endif
+}
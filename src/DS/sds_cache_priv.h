@@ -0,0 +1,109 @@
+/*
+ * Copyright 2015 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#ifndef DS_SDS_CACHE_PRIV_H
+#define DS_SDS_CACHE_PRIV_H
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdbool.h>
+#include "common/list.h"
+#include "common/public/oscap_text.h"
+#include "source/public/oscap_source.h"
+
+/*
+ * Cache of decomposed Source DataStreams
+ *
+ * Loading a datastream means parsing the whole collection, looking up the
+ * selected datastream and copying its components to standalone documents.
+ * When OSCAP_CONTENT_CACHE_DIR is set, the components decomposed for a
+ * session are stored in that directory together with a manifest recording
+ * the selected datastream and checklist, the registered component-refs and
+ * whether the datastream passed the schema validation. The entries are keyed
+ * by a SHA-256 digest of the datastream, the library version and the selection
+ * made by the caller, so any change of these makes a new entry. Later sessions
+ * map the stored components instead of parsing the datastream. The cache
+ * directory and the entries must be owned by the current user and must not be
+ * writable by the group or others, otherwise they are ignored.
+ */
+#define DS_SDS_CACHE_ENV "OSCAP_CONTENT_CACHE_DIR"
+
+struct ds_sds_cache;
+
+/**
+ * Look up the cache entry of a datastream.
+ * @param sds the datastream
+ * @param selection any string identifying what is going to be loaded
+ * @return the cache or NULL if the cache is not enabled or usable
+ */
+struct ds_sds_cache *ds_sds_cache_open(struct oscap_source *sds, const char *selection);
+
+void ds_sds_cache_free(struct ds_sds_cache *cache);
+
+/**
+ * @return true if the entry was found and its components are loaded
+ */
+bool ds_sds_cache_is_hit(const struct ds_sds_cache *cache);
+
+/**
+ * Don't store the entry, e.g. because the components don't come from
+ * the datastream alone.
+ */
+void ds_sds_cache_disable(struct ds_sds_cache *cache);
+
+/**
+ * Take the loaded components, the caller becomes the owner of the table.
+ * @return table of oscap_sources indexed by their relative paths or NULL
+ */
+struct oscap_htable *ds_sds_cache_take_components(struct ds_sds_cache *cache);
+
+const char *ds_sds_cache_get_datastream_id(const struct ds_sds_cache *cache);
+const char *ds_sds_cache_get_checklist_id(const struct ds_sds_cache *cache);
+void ds_sds_cache_set_checklist(struct ds_sds_cache *cache, const char *datastream_id, const char *checklist_id);
+
+/**
+ * @return true if the datastream passed the schema validation before
+ */
+bool ds_sds_cache_is_validated(const struct ds_sds_cache *cache);
+
+/**
+ * Check whether the component-ref was registered when the entry was stored.
+ * The arguments are the ones of ds_sds_session_register_component_with_dependencies().
+ */
+bool ds_sds_cache_is_registered(const struct ds_sds_cache *cache, const char *container_name, const char *component_id, const char *target_filename);
+void ds_sds_cache_add_registration(struct ds_sds_cache *cache, const char *container_name, const char *component_id, const char *target_filename);
+
+/**
+ * @return iterator over the CPE dictionaries of the datastream or NULL
+ * if they are not known
+ */
+struct oscap_string_iterator *ds_sds_cache_get_dictionaries(const struct ds_sds_cache *cache);
+void ds_sds_cache_set_dictionaries(struct ds_sds_cache *cache, struct oscap_string_iterator *dictionaries);
+
+/**
+ * Store the entry if it wasn't found, or update its validation status.
+ * @param components the registered components
+ * @param validated the datastream passed the schema validation
+ * @return 0 on success or if there's nothing to store, -1 on failure
+ */
+int ds_sds_cache_store(struct ds_sds_cache *cache, struct oscap_htable *components, bool validated);
+
+#endif
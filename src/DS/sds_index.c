@@ -418,6 +418,10 @@ struct ds_sds_index *ds_sds_index_import(const char* file)
 
 	while (xmlTextReaderRead(reader) == 1 && xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT);
 	struct ds_sds_index* ret = ds_sds_index_parse(reader);
+	if (ret != NULL && oscap_source_xmlTextReader_failed(reader)) {
+		ds_sds_index_free(ret);
+		ret = NULL;
+	}
 	xmlFreeTextReader(reader);
 	oscap_source_free(source);
 
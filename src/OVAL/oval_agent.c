@@ -50,6 +50,7 @@
 #include "common/util.h"
 #include "common/debug_priv.h"
 #include "common/_error.h"
+#include "XCCDF_POLICY/xccdf_policy_engine_priv.h"
 #include "oval_agent_xccdf_api.h"
 
 struct oval_agent_session {
@@ -108,6 +109,7 @@ oval_agent_session_t * oval_agent_new_session(struct oval_definition_model *mode
 	ag_sess->sys_model = oval_syschar_model_new(model);
 #if defined(OVAL_PROBES_ENABLED)
 	ag_sess->psess     = oval_probe_session_new(ag_sess->sys_model);
+	oval_probe_rescan_open(ag_sess->psess, name);
 #endif
 
 #if defined(OVAL_PROBES_ENABLED)
@@ -275,6 +277,13 @@ int oval_agent_eval_system(oval_agent_session_t * ag_sess, agent_reporter cb, vo
 	int ret = 0;
 
 	dI("OVAL agent started to evaluate OVAL definitions on your system.");
+#if defined(OVAL_PROBES_ENABLED)
+	/* collect independent objects in parallel, the loop below reuses them */
+	if (oval_probe_prefetch_definitions(ag_sess->psess, NULL) == -2) {
+		dI("OVAL agent finished evaluation.");
+		return 1;
+	}
+#endif
 	oval_def_it = oval_definition_model_get_definitions(ag_sess->def_model);
 	while (oval_definition_iterator_has_more(oval_def_it)) {
 		oval_def = oval_definition_iterator_next(oval_def_it);
@@ -324,10 +333,22 @@ const char * oval_agent_get_filename(oval_agent_session_t * ag_sess) {
 	return ag_sess->filename;
 }
 
+void oval_agent_get_rescan_stats(oval_agent_session_t *ag_sess, unsigned int *reused, unsigned int *probed)
+{
+	__attribute__nonnull__(ag_sess);
+
+#if defined(OVAL_PROBES_ENABLED)
+	oval_probe_rescan_get_stats(ag_sess->psess, reused, probed);
+#else
+	*reused = *probed = 0;
+#endif
+}
+
 void oval_agent_destroy_session(oval_agent_session_t * ag_sess) {
 	if (ag_sess != NULL) {
 		free(ag_sess->product_name);
 #if defined(OVAL_PROBES_ENABLED)
+		oval_probe_rescan_store(ag_sess->psess);
 		oval_probe_session_destroy(ag_sess->psess);
 		oval_results_model_free(ag_sess->res_model);
 #endif
@@ -619,11 +640,31 @@ xccdf_test_result_type_t oval_agent_eval_rule(struct xccdf_policy *policy, const
         }
 }
 
+static void
+_oval_agent_collect_definitions(struct oval_agent_session *sess, struct oscap_stringlist *query_data)
+{
+	struct oscap_string_iterator *name_it = oscap_stringlist_get_strings(query_data);
+
+	if (oscap_string_iterator_has_more(name_it) && !strcmp(sess->filename, oscap_string_iterator_next(name_it))) {
+#if defined(OVAL_PROBES_ENABLED)
+		/* the evaluation of the rules reuses the objects */
+		if (oval_probe_prefetch_definitions(sess->psess, name_it) == -2)
+			dI("Collection of the objects of '%s' was aborted.", sess->filename);
+#endif
+	}
+
+	oscap_string_iterator_free(name_it);
+}
+
 static void *
 _oval_agent_list_definitions(void *usr, xccdf_policy_engine_query_t query_type, void *query_data)
 {
 	__attribute__nonnull__(usr);
 	struct oval_agent_session *sess = (struct oval_agent_session *) usr;
+	if (query_type == POLICY_ENGINE_QUERY_COLLECT_NAMES) {
+		_oval_agent_collect_definitions(sess, (struct oscap_stringlist *) query_data);
+		return NULL;
+	}
 	if (query_type != POLICY_ENGINE_QUERY_NAMES_FOR_HREF || (query_data != NULL && strcmp(sess->filename, (const char *) query_data)))
 		return NULL;
 	struct oval_definition_iterator *iterator = oval_definition_model_get_definitions(sess->def_model);
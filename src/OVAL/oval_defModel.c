@@ -246,6 +246,8 @@ static inline int _oval_definition_model_merge_source(struct oval_definition_mod
 		&& xmlTextReaderNodeType(context.reader) != XML_READER_TYPE_ELEMENT) ;
 	/* start parsing */
 	int ret = oval_definition_model_parse(context.reader, &context);
+	if (oscap_source_xmlTextReader_failed(context.reader))
+		ret = -1;
 	xmlFreeTextReader(context.reader);
 	return ret;
 }
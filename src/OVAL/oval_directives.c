@@ -119,7 +119,10 @@ int oval_directives_model_import_source(struct oval_directives_model *model, str
         context.directives_model = model;
         context.user_data = NULL;
         /* jump into oval_system_characteristics */
-        xmlTextReaderRead(context.reader);
+	if (xmlTextReaderRead(context.reader) != 1) {
+		xmlFreeTextReader(context.reader);
+		return -1;
+	}
 
         /* make sure this is a right schema and tag */
         tagname = (char *)xmlTextReaderLocalName(context.reader);
@@ -133,6 +136,9 @@ int oval_directives_model_import_source(struct oval_directives_model *model, str
                 ret = -1;
         }
 
+	if (oscap_source_xmlTextReader_failed(context.reader))
+		ret = -1;
+
         free(tagname);
         free(namespace);
 	xmlFreeTextReader(context.reader);
@@ -253,6 +253,11 @@ int oval_probe_query_object(oval_probe_session_t *psess, struct oval_object *obj
 				return 0;
 			}
 		}
+	} else if ((sysc = oval_probe_rescan_reuse(psess, object)) != NULL) {
+		dI("System characteristics for %s_object '%s' reused from the previous scan.", type_name, oid);
+		if (out_syschar)
+			*out_syschar = sysc;
+		return 0;
 	} else {
 		dI("Creating new syschar for %s_object '%s'.", type_name, oid);
 		sysc = oval_syschar_new(model, object);
@@ -479,6 +484,297 @@ static int oval_probe_query_criteria(oval_probe_session_t *sess, struct oval_cri
         return -1;
 }
 
+/*
+ * Parallel collection of objects
+ *
+ * Objects used by the tests of all definitions are collected before the
+ * definitions are evaluated. Objects of the same type are collected by one
+ * thread in the order in which the sequential evaluation would query them,
+ * threads collecting objects of different types wait for their probes at
+ * the same time. Only objects that don't reference variables, sets or
+ * filters are collected this way; their probes don't call back to the
+ * library and the result doesn't depend on other objects. The evaluation
+ * finds the collected objects in the system characteristics model and
+ * queries the remaining ones as usual.
+ */
+struct oval_probe_prefetch_group {
+	oval_subtype_t       type;
+	struct oval_object **objects;
+	size_t               count;
+};
+
+struct oval_probe_prefetch {
+	oval_probe_session_t             *sess;
+	struct oval_string_map           *seen;   /* ids of visited definitions and objects */
+	struct oval_probe_prefetch_group *groups;
+	size_t                            group_count;
+	size_t                            next;   /* next group to collect; protected by model_lock */
+};
+
+bool oval_probe_object_is_independent(struct oval_object *object)
+{
+	struct oval_object_content_iterator *cont_itr;
+	bool independent = true;
+
+	cont_itr = oval_object_get_object_contents(object);
+
+	while (independent && oval_object_content_iterator_has_more(cont_itr)) {
+		struct oval_object_content *content = oval_object_content_iterator_next(cont_itr);
+
+		if (oval_object_content_get_type(content) != OVAL_OBJECTCONTENT_ENTITY)
+			independent = false;
+		else if (oval_entity_get_varref_type(oval_object_content_get_entity(content)) != OVAL_ENTITY_VARREF_NONE)
+			independent = false;
+	}
+
+	oval_object_content_iterator_free(cont_itr);
+
+	return independent;
+}
+
+static void oval_probe_prefetch_object(struct oval_probe_prefetch *pf, struct oval_object *object)
+{
+	struct oval_probe_prefetch_group *group;
+	oval_subtype_t type;
+	oval_ph_t *ph;
+	const char *id;
+	size_t i;
+
+	id = oval_object_get_id(object);
+
+	if (oval_string_map_get_value(pf->seen, id) != NULL)
+		return;
+
+	oval_string_map_put(pf->seen, id, object);
+
+	if (oval_syschar_model_get_syschar(pf->sess->sys_model, id) != NULL)
+		return;
+	if (oval_probe_rescan_reuse(pf->sess, object) != NULL)
+		return;
+	if (!oval_probe_object_is_independent(object))
+		return;
+
+	type = oval_object_get_subtype(object);
+	ph   = oval_probe_handler_get(pf->sess->ph, type);
+
+	if (ph == NULL || ph->func != &oval_probe_ext_handler)
+		return;
+
+	for (i = 0; i < pf->group_count; ++i)
+		if (pf->groups[i].type == type)
+			break;
+
+	if (i == pf->group_count) {
+		pf->groups = realloc(pf->groups, sizeof(struct oval_probe_prefetch_group) * (++pf->group_count));
+		pf->groups[i].type    = type;
+		pf->groups[i].objects = NULL;
+		pf->groups[i].count   = 0;
+	}
+
+	group = pf->groups + i;
+	group->objects = realloc(group->objects, sizeof(struct oval_object *) * (group->count + 1));
+	group->objects[group->count++] = object;
+}
+
+static void oval_probe_prefetch_criteria(struct oval_probe_prefetch *pf, struct oval_criteria_node *cnode)
+{
+	switch (oval_criteria_node_get_type(cnode)) {
+	case OVAL_NODETYPE_CRITERION:{
+		struct oval_test   *test = oval_criteria_node_get_test(cnode);
+		struct oval_object *object;
+
+		if (test == NULL || (object = oval_test_get_object(test)) == NULL)
+			return;
+		/* see oval_probe_query_test */
+		if (oval_test_get_subtype(test) != oval_object_get_subtype(object))
+			return;
+
+		oval_probe_prefetch_object(pf, object);
+		break;
+	}
+	case OVAL_NODETYPE_CRITERIA:{
+		struct oval_criteria_node_iterator *cnode_it = oval_criteria_node_get_subnodes(cnode);
+
+		if (cnode_it == NULL)
+			return;
+
+		while (oval_criteria_node_iterator_has_more(cnode_it))
+			oval_probe_prefetch_criteria(pf, oval_criteria_node_iterator_next(cnode_it));
+
+		oval_criteria_node_iterator_free(cnode_it);
+		break;
+	}
+	case OVAL_NODETYPE_EXTENDDEF:{
+		struct oval_definition *def = oval_criteria_node_get_definition(cnode);
+		struct oval_criteria_node *criteria;
+
+		if (def == NULL || oval_string_map_get_value(pf->seen, oval_definition_get_id(def)) != NULL)
+			return;
+
+		oval_string_map_put(pf->seen, oval_definition_get_id(def), def);
+
+		if ((criteria = oval_definition_get_criteria(def)) != NULL)
+			oval_probe_prefetch_criteria(pf, criteria);
+		break;
+	}
+	case OVAL_NODETYPE_UNKNOWN:
+		break;
+	}
+}
+
+static void *oval_probe_prefetch_worker(void *arg)
+{
+	struct oval_probe_prefetch *pf = (struct oval_probe_prefetch *)arg;
+	oval_pext_t *pext = pf->sess->pext;
+	struct oval_probe_prefetch_group *group;
+	struct oval_syschar *sysv[OVAL_PROBE_BATCH];
+	size_t i, n;
+
+	pthread_mutex_lock(&pext->model_lock);
+
+	while (pf->next < pf->group_count && !pext->aborted) {
+		group = pf->groups + pf->next++;
+
+		dI("Collecting %zu %s object(s).", group->count, oval_subtype_get_text(group->type));
+
+		/*
+		 * The objects are sent to the probe in batches. Failures
+		 * are not reported here, the evaluation queries objects
+		 * without results again and handles the error.
+		 */
+		for (i = 0; i < group->count && !pext->aborted;) {
+			for (n = 0; n < OVAL_PROBE_BATCH && i < group->count; ++i) {
+				struct oval_object *object = group->objects[i];
+
+				if (oval_syschar_model_get_syschar(pf->sess->sys_model, oval_object_get_id(object)) != NULL)
+					continue;
+
+				sysv[n++] = oval_syschar_new(pf->sess->sys_model, object);
+			}
+
+			if (n > 0 && oval_probe_ext_eval_batch(pext, group->type, sysv, n) == -2)
+				pext->aborted = true;
+		}
+	}
+
+	pthread_mutex_unlock(&pext->model_lock);
+	oscap_clearerr();
+
+	return (NULL);
+}
+
+int oval_probe_prefetch_definitions(oval_probe_session_t *sess, struct oscap_string_iterator *ids)
+{
+	struct oval_probe_prefetch pf;
+	struct oval_definition_model *def_model;
+	struct oval_definition_iterator *def_itr;
+	oval_pext_t *pext = sess->pext;
+	pthread_t   *threads;
+	const char  *env;
+	size_t       max_threads, thread_count, i;
+	int ret = 0;
+
+	env = getenv(OVAL_PROBE_PARALLEL_ENV);
+	max_threads = env != NULL ? strtoul(env, NULL, 10) : OVAL_PROBE_PARALLEL;
+
+	if (max_threads < 2)
+		return (0);
+
+	pf.sess        = sess;
+	pf.seen        = oval_string_map_new();
+	pf.groups      = NULL;
+	pf.group_count = 0;
+	pf.next        = 0;
+
+	def_model = oval_syschar_model_get_definition_model(sess->sys_model);
+	def_itr   = ids == NULL ? oval_definition_model_get_definitions(def_model) : NULL;
+
+	for (;;) {
+		struct oval_definition *def;
+		struct oval_criteria_node *criteria;
+
+		if (def_itr != NULL) {
+			if (!oval_definition_iterator_has_more(def_itr))
+				break;
+			def = oval_definition_iterator_next(def_itr);
+		} else {
+			if (!oscap_string_iterator_has_more(ids))
+				break;
+			if ((def = oval_definition_model_get_definition(def_model, oscap_string_iterator_next(ids))) == NULL)
+				continue;
+		}
+
+		if (oval_string_map_get_value(pf.seen, oval_definition_get_id(def)) != NULL)
+			continue;
+
+		oval_string_map_put(pf.seen, oval_definition_get_id(def), def);
+
+		if ((criteria = oval_definition_get_criteria(def)) != NULL)
+			oval_probe_prefetch_criteria(&pf, criteria);
+	}
+
+	if (def_itr != NULL)
+		oval_definition_iterator_free(def_itr);
+
+	/* Nothing to do in parallel */
+	if (pf.group_count < 2)
+		goto cleanup;
+
+	/*
+	 * Start the probes here; a probe is terminated when the thread
+	 * that started it exits.
+	 */
+	for (i = 0; i < pf.group_count; ++i) {
+		oval_ph_t *ph = oval_probe_handler_get(sess->ph, pf.groups[i].type);
+
+		if (ph->func(pf.groups[i].type, ph->uptr, PROBE_HANDLER_ACT_OPEN) != 0) {
+			dW("Can't start the %s probe.", oval_subtype_get_text(pf.groups[i].type));
+			pf.groups[i].count = 0;
+		}
+	}
+
+	oscap_clearerr();
+
+	thread_count = pf.group_count < max_threads ? pf.group_count : max_threads;
+	threads      = malloc(sizeof(pthread_t) * thread_count);
+
+	dI("Collecting objects of %zu types using %zu threads.", pf.group_count, thread_count);
+
+	pext->parallel = true;
+	pext->aborted  = false;
+
+	for (i = 0; i < thread_count; ++i) {
+		if (pthread_create(threads + i, NULL, &oval_probe_prefetch_worker, &pf) != 0) {
+			dW("Can't create a collector thread: %u, %s.", errno, strerror(errno));
+			break;
+		}
+	}
+
+	thread_count = i;
+
+	for (i = 0; i < thread_count; ++i)
+		pthread_join(threads[i], NULL);
+
+	free(threads);
+	pext->parallel = false;
+
+	if (pext->aborted) {
+		dI("Collection was aborted.");
+		pext->aborted = false;
+		oval_probe_ext_restart(pext);
+		ret = -2;
+	}
+
+cleanup:
+	for (i = 0; i < pf.group_count; ++i)
+		free(pf.groups[i].objects);
+
+	free(pf.groups);
+	oval_string_map_free(pf.seen, NULL);
+
+	return (ret);
+}
+
 #if 0
 const oval_probe_meta_t * const oval_probe_meta_get(void)
 {
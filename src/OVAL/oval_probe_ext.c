@@ -66,6 +66,9 @@ oval_pext_t *oval_pext_new(void)
 
         pext->do_init = true;
         pthread_mutex_init(&pext->lock, NULL);
+        pthread_mutex_init(&pext->model_lock, NULL);
+        pext->parallel = false;
+        pext->aborted  = false;
 
 #if defined(OVAL_PROBEDIR_ENV)
         pext->probe_dir = getenv("OVAL_PROBE_DIR");
@@ -75,6 +78,11 @@ oval_pext_t *oval_pext_new(void)
         if (pext->probe_dir == NULL)
                 pext->probe_dir = OVAL_PROBE_DIR;
 
+        pext->probe_scheme = getenv(OVAL_PROBE_SCHEME_ENV);
+
+        if (pext->probe_scheme == NULL || strcmp(pext->probe_scheme, "shm") != 0)
+                pext->probe_scheme = OVAL_PROBE_SCHEME;
+
         pext->pdtbl     = NULL;
         pext->pdsc      = NULL;
         pext->pdsc_cnt  = 0;
@@ -93,6 +101,7 @@ void oval_pext_free(oval_pext_t *pext)
         }
 
         pthread_mutex_destroy(&pext->lock);
+        pthread_mutex_destroy(&pext->model_lock);
         free(pext);
 }
 
@@ -430,7 +439,7 @@ static inline int _handle_SEAP_receive_failure(SEAP_CTX_t *ctx, oval_pd_t *pd, S
 	return (-1);
 }
 
-static int oval_probe_comm(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj, int flags, SEXP_t **out_sexp)
+static int oval_probe_comm(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, const SEXP_t *s_iobj, int flags, SEXP_t **out_sexp)
 {
 	int retry, ret;
 
@@ -447,6 +456,16 @@ static int oval_probe_comm(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj,
 		 * by the probe context handling functions.
 		 */
 		if (pd->sd == -1) {
+			/*
+			 * The probe gets SIGTERM when the thread that
+			 * started it exits, leave starting the probe to
+			 * the sequential evaluation.
+			 */
+			if (pext != NULL && pext->parallel) {
+				oscap_seterr (OSCAP_EFAMILY_OVAL, "Can't start a probe during parallel collection");
+				return (-1);
+			}
+
 			pd->sd = SEAP_connect(ctx, pd->uri, 0);
 
 			if (pd->sd < 0) {
@@ -492,8 +511,18 @@ static int oval_probe_comm(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj,
 
 		dD("Sending message.");
 
+		/*
+		 * Let the other collectors use the model while this
+		 * one waits for the probe.
+		 */
+		if (pext != NULL && pext->parallel)
+			pthread_mutex_unlock(&pext->model_lock);
+
 		ret = SEAP_sendmsg(ctx, pd->sd, s_omsg);
 		if (ret != 0) {
+			if (pext != NULL && pext->parallel)
+				pthread_mutex_lock(&pext->model_lock);
+
                         protect_errno {
                                 dW("Can't send message: %u, %s.", errno, strerror(errno));
                         }
@@ -555,6 +584,13 @@ static int oval_probe_comm(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj,
 		s_imsg = NULL;
 
 		ret = SEAP_recvmsg(ctx, pd->sd, &s_imsg);
+
+		if (pext != NULL && pext->parallel) {
+			protect_errno {
+				pthread_mutex_lock(&pext->model_lock);
+			}
+		}
+
 		if (ret != 0) {
 			protect_errno {
 				ret = _handle_SEAP_receive_failure(ctx, pd, s_omsg, flags);
@@ -637,7 +673,7 @@ static int oval_probe_sys_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, struct oval_sysch
                 SEXP_free (r0);
         }
 
-        ret = oval_probe_comm(ctx, pd, s_obj, 0, &r0);
+        ret = oval_probe_comm(ctx, pd, NULL, s_obj, 0, &r0);
         SEXP_free(s_obj);
 
 	if (ret != 0)
@@ -788,7 +824,7 @@ int oval_probe_sys_handler(oval_subtype_t type, void *ptr, int act, ...)
 		}
 
                 probe_urilen = snprintf(probe_uri, sizeof probe_uri,
-                                        "%s://%s/%s", OVAL_PROBE_SCHEME, probe_dir, probe_dsc->file);
+                                        "%s://%s/%s", pext->probe_scheme, probe_dir, probe_dsc->file);
 
                 if (probe_urilen >= sizeof probe_uri) {
                         oscap_seterr (OSCAP_EFAMILY_GLIBC, "probe URI too long");
@@ -817,6 +853,53 @@ int oval_probe_sys_handler(oval_subtype_t type, void *ptr, int act, ...)
         return(ret);
 }
 
+/*
+ * Find the probe descriptor of the given subtype, create it if the probe
+ * wasn't used yet. Returns 1 if there's no probe for the subtype.
+ */
+static int oval_probe_ext_getpd(oval_pext_t *pext, oval_subtype_t type, oval_pd_t **out_pd)
+{
+        oval_pd_t *pd;
+
+        pd = oval_pdtbl_get(pext->pdtbl, type);
+
+        if (pd == NULL) {
+                char         probe_uri[PATH_MAX + 1];
+                size_t       probe_urilen;
+                char        *probe_dir;
+                oval_pdsc_t *probe_dsc;
+
+                probe_dir = pext->probe_dir;
+                probe_dsc = oval_pdsc_lookup(pext->pdsc, pext->pdsc_cnt, type);
+
+                if (probe_dsc == NULL)
+                        return (1);
+
+                probe_urilen = snprintf(probe_uri, sizeof probe_uri,
+                                        "%s://%s/%s", pext->probe_scheme, probe_dir, probe_dsc->file);
+
+                if (probe_urilen >= sizeof probe_uri) {
+                        oscap_seterr (OSCAP_EFAMILY_GLIBC, "probe URI too long");
+                        return (-1);
+                }
+
+                dI("Starting probe on URI '%s'.", probe_uri);
+
+                if (oval_pdtbl_add(pext->pdtbl, type, -1, probe_uri) != 0)
+                        return (1);
+
+                pd = oval_pdtbl_get(pext->pdtbl, type);
+
+                if (pd == NULL) {
+                        oscap_seterr (OSCAP_EFAMILY_OVAL, "internal error");
+                        return (-1);
+                }
+        }
+
+        *out_pd = pd;
+        return (0);
+}
+
 int oval_probe_ext_handler(oval_subtype_t type, void *ptr, int act, ...)
 {
         int          ret = 0;
@@ -836,49 +919,16 @@ int oval_probe_ext_handler(oval_subtype_t type, void *ptr, int act, ...)
 		sys = va_arg(ap, struct oval_syschar *);
 		flags = va_arg(ap, int);
 		obj = oval_syschar_get_object(sys);
-                pd = oval_pdtbl_get(pext->pdtbl, oval_object_get_subtype(obj));
-
-                if (pd == NULL) {
-                        char         probe_uri[PATH_MAX + 1];
-                        size_t       probe_urilen;
-                        char        *probe_dir;
-                        oval_pdsc_t *probe_dsc;
-
-                        probe_dir = pext->probe_dir;
-                        probe_dsc = oval_pdsc_lookup(pext->pdsc, pext->pdsc_cnt, oval_object_get_subtype(obj));
-
-			if (probe_dsc == NULL) {
-				oval_syschar_add_new_message(sys, "OVAL object not supported", OVAL_MESSAGE_LEVEL_WARNING);
-				oval_syschar_set_flag(sys, SYSCHAR_FLAG_NOT_COLLECTED);
-				va_end(ap);
-				return (1);
-			}
-
-                        probe_urilen = snprintf(probe_uri, sizeof probe_uri,
-                                                "%s://%s/%s", OVAL_PROBE_SCHEME, probe_dir, probe_dsc->file);
-
-                        if (probe_urilen >= sizeof probe_uri) {
-                                oscap_seterr (OSCAP_EFAMILY_GLIBC, "probe URI too long");
-				va_end(ap);
-                                return (-1);
-                        }
+                ret = oval_probe_ext_getpd(pext, oval_object_get_subtype(obj), &pd);
 
-                        dI("Starting probe on URI '%s'.", probe_uri);
-
-                        if (oval_pdtbl_add(pext->pdtbl, oval_object_get_subtype(obj), -1, probe_uri) != 0) {
-				oval_syschar_add_new_message(sys, "OVAL object not supported", OVAL_MESSAGE_LEVEL_WARNING);
-				oval_syschar_set_flag(sys, SYSCHAR_FLAG_NOT_COLLECTED);
-				va_end(ap);
-                                return (1);
-			}
-
-			pd = oval_pdtbl_get(pext->pdtbl, oval_object_get_subtype(obj));
+                if (ret == 1) {
+                        oval_syschar_add_new_message(sys, "OVAL object not supported", OVAL_MESSAGE_LEVEL_WARNING);
+                        oval_syschar_set_flag(sys, SYSCHAR_FLAG_NOT_COLLECTED);
+                }
 
-                        if (pd == NULL) {
-                                oscap_seterr (OSCAP_EFAMILY_OVAL, "internal error");
-				va_end(ap);
-                                return (-1);
-                        }
+                if (ret != 0) {
+                        va_end(ap);
+                        return (ret);
                 }
 
 		ret = oval_probe_ext_eval(pext->pdtbl->ctx, pd, pext, sys, flags);
@@ -888,16 +938,15 @@ int oval_probe_ext_handler(oval_subtype_t type, void *ptr, int act, ...)
 
 		if (ret < 0 && errno == ECONNABORTED) {
 			if (!(flags & OVAL_PDFLAG_SLAVE)) {
-				if (!pext->do_init) {
-					oval_pdtbl_free(pext->pdtbl);
-				}
-
-				pext->do_init  = true;
-				pext->pdtbl    = NULL;
-				pext->pdsc     = NULL;
-				pext->pdsc_cnt = 0;
-
-				oval_probe_ext_init(pext);
+				/*
+				 * The probe table can't be replaced while other
+				 * collectors use it, the caller restarts the
+				 * probes after they finish.
+				 */
+				if (pext->parallel)
+					pext->aborted = true;
+				else
+					oval_probe_ext_restart(pext);
 
 				errno = ECONNABORTED;
 			}
@@ -907,6 +956,23 @@ int oval_probe_ext_handler(oval_subtype_t type, void *ptr, int act, ...)
 		return ret;
         }
         case PROBE_HANDLER_ACT_OPEN:
+                /*
+                 * Start the probe and connect to it.
+                 */
+                ret = oval_probe_ext_getpd(pext, type, &pd);
+
+                if (ret != 0)
+                        break;
+
+                if (pd->sd == -1) {
+                        pd->sd = SEAP_connect(pext->pdtbl->ctx, pd->uri, 0);
+
+                        if (pd->sd < 0) {
+                                dW("Can't connect: %u, %s.", errno, strerror(errno));
+                                pd->sd = -1;
+                                ret = -1;
+                        }
+                }
                 break;
         case PROBE_HANDLER_ACT_INIT:
                 ret = oval_probe_ext_init(pext);
@@ -969,6 +1035,20 @@ int oval_probe_ext_handler(oval_subtype_t type, void *ptr, int act, ...)
         return(ret);
 }
 
+int oval_probe_ext_restart(oval_pext_t *pext)
+{
+	if (!pext->do_init) {
+		oval_pdtbl_free(pext->pdtbl);
+	}
+
+	pext->do_init  = true;
+	pext->pdtbl    = NULL;
+	pext->pdsc     = NULL;
+	pext->pdsc_cnt = 0;
+
+	return oval_probe_ext_init(pext);
+}
+
 int oval_probe_ext_init(oval_pext_t *pext)
 {
         int ret = 0;
@@ -1064,7 +1144,7 @@ int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struc
 	if (ret != 0)
 		return (1);
 
-	ret = oval_probe_comm(ctx, pd, s_obj, flags, &s_sys);
+	ret = oval_probe_comm(ctx, pd, pext, s_obj, flags, &s_sys);
 	SEXP_free(s_obj);
 
 	if (ret != 0) {
@@ -1100,11 +1180,154 @@ int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struc
 	return (ret);
 }
 
+int oval_probe_ext_eval_batch(oval_pext_t *pext, oval_subtype_t type, struct oval_syschar *sysv[], size_t count)
+{
+	SEAP_CTX_t *ctx;
+	SEAP_msg_t *s_omsg, *s_imsg;
+	SEXP_t *s_objs, *s_obj, **s_sys;
+	size_t *idx, n, i;
+	oval_pd_t *pd;
+	int ret = 0;
+
+	pd = oval_pdtbl_get(pext->pdtbl, type);
+
+	if (pd == NULL || pd->sd == -1) {
+		oscap_seterr(OSCAP_EFAMILY_OVAL, "The %s probe is not running.", oval_subtype_to_str(type));
+		return (-1);
+	}
+
+	ctx    = pext->pdtbl->ctx;
+	s_objs = SEXP_list_new(NULL);
+	idx    = malloc(sizeof(size_t) * count);
+
+	for (i = n = 0; i < count; ++i) {
+		if (oval_object_to_sexp(pext->sess_ptr, oval_subtype_to_str(type), sysv[i], &s_obj) != 0)
+			continue;
+
+		SEXP_list_add(s_objs, s_obj);
+		SEXP_free(s_obj);
+		idx[n++] = i;
+	}
+
+	if (n == 0) {
+		SEXP_free(s_objs);
+		free(idx);
+		return (0);
+	}
+
+	s_omsg = SEAP_msg_new();
+	SEAP_msg_set(s_omsg, s_objs);
+	SEXP_free(s_objs);
+
+	if (SEAP_msgattr_set(s_omsg, "batch", NULL) != 0) {
+		SEAP_msg_free(s_omsg);
+		free(idx);
+		oscap_seterr(OSCAP_EFAMILY_OVAL, "Can't set batch attribute.");
+		return (-1);
+	}
+
+	s_sys = calloc(n, sizeof(SEXP_t *));
+
+	dD("Sending a batch of %zu objects.", n);
+
+	if (pext->parallel)
+		pthread_mutex_unlock(&pext->model_lock);
+
+	if (SEAP_sendmsg(ctx, pd->sd, s_omsg) != 0)
+		ret = -1;
+
+	/*
+	 * The probe replies to each object in the order of the request.
+	 */
+	for (i = 0; ret == 0 && i < n; ++i) {
+		s_imsg = NULL;
+
+		if (SEAP_recvmsg(ctx, pd->sd, &s_imsg) != 0) {
+			SEAP_err_t *err = NULL;
+
+			if (errno != ECANCELED) {
+				ret = -1;
+				break;
+			}
+
+			/*
+			 * The object wasn't evaluated, it's left to the
+			 * single request which reports the error.
+			 */
+			if (SEAP_recverr_byid(ctx, pd->sd, &err, SEAP_msg_id(s_omsg)) == 0) {
+				dD("Batch object #%zu: %s", i, _probe_strerror(err->code));
+				SEAP_error_free(err);
+			}
+
+			continue;
+		}
+
+		s_sys[i] = SEAP_msg_get(s_imsg);
+		SEAP_msg_free(s_imsg);
+	}
+
+	if (pext->parallel) {
+		protect_errno {
+			pthread_mutex_lock(&pext->model_lock);
+		}
+	}
+
+	if (ret != 0) {
+		if (errno == ECONNABORTED)
+			ret = -2;
+
+		protect_errno {
+			dW("Batch request failed: %u, %s.", errno, strerror(errno));
+			SEAP_close(ctx, pd->sd);
+			pd->sd = -1;
+		}
+	}
+
+	for (i = 0; i < n; ++i) {
+		if (s_sys[i] == NULL)
+			continue;
+
+		oval_sexp_to_sysch(s_sys[i], sysv[idx[i]]);
+		SEXP_free(s_sys[i]);
+	}
+
+	SEAP_msg_free(s_omsg);
+	free(s_sys);
+	free(idx);
+
+	return (ret);
+}
+
 int oval_probe_ext_reset(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext)
 {
-        SEAP_cmd_exec(ctx, pd->sd, SEAP_EXEC_RECV, PROBECMD_RESET, NULL, SEAP_CMDTYPE_SYNC, NULL, NULL);
+	SEXP_t *res, *hits, *misses;
 
-        return (0);
+	res = SEAP_cmd_exec(ctx, pd->sd, SEAP_EXEC_RECV, PROBECMD_RESET, NULL, SEAP_CMDTYPE_SYNC, NULL, NULL);
+
+	if (res == NULL)
+		return (0);
+
+	/*
+	 * The probe replies with the hit and miss counts of its file metadata
+	 * cache, see probe/fcache.h. Probes which don't look files up report zeros.
+	 */
+	hits   = SEXP_list_nth(res, 1);
+	misses = SEXP_list_nth(res, 2);
+
+	if (SEXP_numberp(hits) && SEXP_numberp(misses)) {
+		unsigned long long h = SEXP_number_getu_64(hits);
+		unsigned long long m = SEXP_number_getu_64(misses);
+
+		if (h + m > 0)
+			dI("Probe %s: file metadata cache: %llu hits, %llu misses.",
+			   oval_subtype_get_text(pd->subtype), h, m);
+	}
+
+	SEXP_free(hits);
+	SEXP_free(misses);
+	SEXP_free(res);
+
+	return (0);
 }
 
 #include <signal.h>
@@ -58,9 +58,14 @@ struct oval_pext {
         size_t        pdsc_cnt;
         oval_pdtbl_t *pdtbl;
         char         *probe_dir;
+        char         *probe_scheme;
 
         void *sess_ptr;
         struct oval_syschar_model **model;
+
+        pthread_mutex_t model_lock; /* held by parallel collectors except while waiting for a probe */
+        bool            parallel;   /* objects are being collected by more threads */
+        bool            aborted;    /* a probe was aborted during the parallel collection */
 };
 
 typedef struct oval_pext oval_pext_t;
@@ -68,7 +73,15 @@ typedef struct oval_pext oval_pext_t;
 oval_pext_t *oval_pext_new(void);
 void oval_pext_free(oval_pext_t *pext);
 int oval_probe_ext_init(oval_pext_t *pext);
+int oval_probe_ext_restart(oval_pext_t *pext);
 int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struct oval_syschar *syschar, int flags);
+/**
+ * Evaluate objects of the same type using one batch request. The probe has
+ * to be started already. Objects which couldn't be evaluated keep
+ * the SYSCHAR_FLAG_UNKNOWN flag.
+ * @return 0 on success, -1 on failure, -2 if the probe was aborted
+ */
+int oval_probe_ext_eval_batch(oval_pext_t *pext, oval_subtype_t type, struct oval_syschar *sysv[], size_t count);
 int oval_probe_ext_reset(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext);
 int oval_probe_ext_abort(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext);
 
@@ -47,6 +47,7 @@
 
 
 #define OVAL_PROBE_SCHEME "pipe"
+#define OVAL_PROBE_SCHEME_ENV "OSCAP_PROBE_SCHEME"
 
 #ifndef OVAL_PROBE_DIR
 # define OVAL_PROBE_DIR    "/usr/libexec/openscap"
@@ -54,6 +55,10 @@
 
 #define OVAL_PROBE_MAXRETRY 0
 
+#define OVAL_PROBE_PARALLEL     4
+#define OVAL_PROBE_PARALLEL_ENV "OSCAP_PROBE_PARALLEL"
+#define OVAL_PROBE_BATCH        512
+
 int oval_probe_query_test(oval_probe_session_t *sess, struct oval_test *test);
 
 
@@ -68,6 +73,59 @@ void oval_probe_tblinit(void);
 const char *oval_subtype_to_str(oval_subtype_t subtype);
 oval_subtype_t oval_str_to_subtype(const char *str);
 
+/**
+ * Collect the objects used by the definitions of the session's model in
+ * parallel, up to OSCAP_PROBE_PARALLEL probes at a time.
+ * @param ids ids of the definitions to collect the objects of, NULL for all definitions
+ * @return 0 on success, -2 if the collection was aborted
+ */
+int oval_probe_prefetch_definitions(oval_probe_session_t *sess, struct oscap_string_iterator *ids);
+
+/**
+ * Find out whether the object references variables, sets or filters.
+ */
+bool oval_probe_object_is_independent(struct oval_object *object);
+
+/*
+ * Incremental scans
+ *
+ * When OSCAP_RESCAN_DIR is set, the objects collected by an agent session
+ * are stored in that directory together with fingerprints of the inputs
+ * they were collected from: the object itself, the file it names, the rpm
+ * or dpkg database or the running kernel. The next session evaluating the
+ * same content takes over the items of the objects whose fingerprint did
+ * not change instead of probing them again. Objects of other types, and
+ * objects with variables, sets, filters, patterns or recursion, are always
+ * probed.
+ */
+#define OVAL_PROBE_RESCAN_ENV "OSCAP_RESCAN_DIR"
+
+struct oval_probe_rescan;
+
+/**
+ * Load the objects stored by the previous session evaluating the content,
+ * nothing is done unless OSCAP_RESCAN_DIR is set.
+ * @param name name of the evaluated content, the key of the stored objects
+ */
+void oval_probe_rescan_open(oval_probe_session_t *sess, const char *name);
+
+/**
+ * Add the object of the previous scan to the session's model if its inputs
+ * didn't change.
+ * @return the reused system characteristics or NULL if the object is to be probed
+ */
+struct oval_syschar *oval_probe_rescan_reuse(oval_probe_session_t *sess, struct oval_object *object);
+
+/**
+ * Store the objects collected by the session for the next one.
+ * @return 0 on success or if there's nothing to store, -1 on failure
+ */
+int oval_probe_rescan_store(oval_probe_session_t *sess);
+
+void oval_probe_rescan_get_stats(oval_probe_session_t *sess, unsigned int *reused, unsigned int *probed);
+
+void oval_probe_rescan_free(struct oval_probe_rescan *rescan);
+
 int oval_probe_hint_definition(oval_probe_session_t *sess, struct oval_definition *definition, int variable_instance_hint);
 
 #endif /* OVAL_PROBE_IMPL_H */
@@ -0,0 +1,651 @@
+/*
+ * Copyright 2015 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#include "public/oval_definitions.h"
+#include "public/oval_system_characteristics.h"
+#include "oval_system_characteristics_impl.h"
+#include "adt/oval_string_map_impl.h"
+#include "_oval_probe_session.h"
+#include "oval_probe_impl.h"
+#include "common/_error.h"
+#include "common/debug_priv.h"
+#include "common/oscap_string.h"
+#include "common/util.h"
+#include "source/public/oscap_source.h"
+#include "source/oscap_source_priv.h"
+
+#define OVAL_PROBE_RESCAN_MAGIC  "oscap-rescan"
+#define OVAL_PROBE_RESCAN_FORMAT "1"
+
+struct oval_probe_rescan {
+	char *dir;
+	char *syschar_path;                        /* objects collected by the previous scan */
+	char *fingerprint_path;                    /* their fingerprints */
+	struct oval_definition_model *prev_defs;   /* stub objects of the previous syschars */
+	struct oval_syschar_model    *prev;
+	struct oval_string_map       *prev_fingerprints; /* object id -> fingerprint */
+	struct oval_string_map       *fingerprints;      /* object id -> fingerprint, this scan */
+	struct oval_string_map       *items;             /* previous item id -> reused item */
+	unsigned int next_item;
+	unsigned int reused;
+};
+
+/* What the items of an object are collected from, besides the object itself */
+typedef enum {
+	RESCAN_INPUT_NONE,
+	RESCAN_INPUT_BOOT,   /* the running kernel */
+	RESCAN_INPUT_RPMDB,  /* the rpm database */
+	RESCAN_INPUT_DPKG,   /* the dpkg status file */
+	RESCAN_INPUT_PATH    /* the file or directory named by the object */
+} oval_probe_rescan_input_t;
+
+static const struct {
+	oval_subtype_t type;
+	oval_probe_rescan_input_t input;
+} rescan_types[] = {
+	{ (oval_subtype_t) OVAL_INDEPENDENT_FAMILY,               RESCAN_INPUT_NONE  },
+	{ (oval_subtype_t) OVAL_INDEPENDENT_FILE_MD5,             RESCAN_INPUT_PATH  },
+	{ (oval_subtype_t) OVAL_INDEPENDENT_FILE_HASH,            RESCAN_INPUT_PATH  },
+	{ (oval_subtype_t) OVAL_INDEPENDENT_FILE_HASH58,          RESCAN_INPUT_PATH  },
+	{ (oval_subtype_t) OVAL_INDEPENDENT_TEXT_FILE_CONTENT,    RESCAN_INPUT_PATH  },
+	{ (oval_subtype_t) OVAL_INDEPENDENT_TEXT_FILE_CONTENT_54, RESCAN_INPUT_PATH  },
+	{ (oval_subtype_t) OVAL_INDEPENDENT_XML_FILE_CONTENT,     RESCAN_INPUT_PATH  },
+	{ (oval_subtype_t) OVAL_LINUX_DPKG_INFO,                  RESCAN_INPUT_DPKG  },
+	{ (oval_subtype_t) OVAL_LINUX_RPM_INFO,                   RESCAN_INPUT_RPMDB },
+	{ (oval_subtype_t) OVAL_UNIX_FILE,                        RESCAN_INPUT_PATH  },
+	{ (oval_subtype_t) OVAL_UNIX_FILEEXTENDEDATTRIBUTE,       RESCAN_INPUT_PATH  },
+	{ (oval_subtype_t) OVAL_UNIX_SYMLINK,                     RESCAN_INPUT_PATH  },
+	{ (oval_subtype_t) OVAL_UNIX_UNAME,                       RESCAN_INPUT_BOOT  }
+};
+
+static void _rescan_append_stat_of(struct oscap_string *fp, int ret, const struct stat *st)
+{
+	char buf[256];
+
+	if (ret != 0) {
+		snprintf(buf, sizeof(buf), " %d", errno);
+	} else {
+		snprintf(buf, sizeof(buf), " %ju:%ju:%o:%ju:%ju:%ju:%jd:%jd.%09ld:%jd.%09ld",
+			(uintmax_t) st->st_dev, (uintmax_t) st->st_ino, (unsigned int) st->st_mode,
+			(uintmax_t) st->st_nlink, (uintmax_t) st->st_uid, (uintmax_t) st->st_gid,
+			(intmax_t) st->st_size, (intmax_t) st->st_mtim.tv_sec, st->st_mtim.tv_nsec,
+			(intmax_t) st->st_ctim.tv_sec, st->st_ctim.tv_nsec);
+	}
+	oscap_string_append_string(fp, buf);
+}
+
+static void _rescan_append_stat(struct oscap_string *fp, const char *path)
+{
+	struct stat st;
+	int ret;
+
+	oscap_string_append_string(fp, path);
+	ret = lstat(path, &st);
+	_rescan_append_stat_of(fp, ret, &st);
+	/* The target of a symlink may change as well */
+	if (ret == 0 && S_ISLNK(st.st_mode)) {
+		ret = stat(path, &st);
+		_rescan_append_stat_of(fp, ret, &st);
+	}
+	oscap_string_append_char(fp, '\n');
+}
+
+static void _rescan_append_root_stat(struct oscap_string *fp, const char *root, const char *path)
+{
+	char *full_path = oscap_sprintf("%s%s", root, path);
+	_rescan_append_stat(fp, full_path);
+	free(full_path);
+}
+
+static void _rescan_append_boot(struct oscap_string *fp)
+{
+	char boot_id[64] = "";
+	struct utsname uts;
+
+	FILE *f = fopen("/proc/sys/kernel/random/boot_id", "r");
+	if (f != NULL) {
+		if (fgets(boot_id, sizeof(boot_id), f) == NULL)
+			boot_id[0] = '\0';
+		fclose(f);
+	}
+	oscap_string_append_string(fp, boot_id);
+
+	if (uname(&uts) == 0) {
+		char *text = oscap_sprintf("%s\n%s\n%s\n%s\n%s\n", uts.sysname, uts.nodename,
+			uts.release, uts.version, uts.machine);
+		oscap_string_append_string(fp, text);
+		free(text);
+	}
+}
+
+static void _rescan_append_rpmdb(struct oscap_string *fp, const char *root)
+{
+	/* Latest database locations and files, see also the rpm probes */
+	static const char *const dirs[] = { "/var/lib/rpm", "/usr/lib/sysimage/rpm" };
+	static const char *const files[] = { "", "/Packages", "/Packages.db", "/rpmdb.sqlite", "/rpmdb.sqlite-wal" };
+
+	for (size_t i = 0; i < sizeof(dirs) / sizeof(dirs[0]); ++i) {
+		for (size_t j = 0; j < sizeof(files) / sizeof(files[0]); ++j) {
+			char *path = oscap_sprintf("%s%s%s", root, dirs[i], files[j]);
+			_rescan_append_stat(fp, path);
+			free(path);
+		}
+	}
+}
+
+/*
+ * Append the path named by a file based object. Only objects naming a single
+ * file or directory are fingerprinted, patterns and recursion can match files
+ * created since the previous scan.
+ */
+static bool _rescan_append_path(struct oscap_string *fp, const char *root, struct oval_object *object)
+{
+	const char *filepath = NULL, *path = NULL, *filename = NULL;
+	bool has_filename = false;
+	bool ok = true;
+
+	struct oval_object_content_iterator *contents = oval_object_get_object_contents(object);
+	while (ok && oval_object_content_iterator_has_more(contents)) {
+		struct oval_entity *entity = oval_object_content_get_entity(oval_object_content_iterator_next(contents));
+		const char *name = oval_entity_get_name(entity);
+		const char **target;
+
+		if (oscap_streq(name, "filepath"))
+			target = &filepath;
+		else if (oscap_streq(name, "path"))
+			target = &path;
+		else if (oscap_streq(name, "filename"))
+			target = &filename;
+		else
+			continue;
+
+		if (oval_entity_get_operation(entity) != OVAL_OPERATION_EQUALS) {
+			ok = false;
+			break;
+		}
+		struct oval_value *value = oval_entity_get_value(entity);
+		*target = value != NULL ? oval_value_get_text(value) : NULL;
+		if (target == &filename)
+			has_filename = true;
+		else if (*target == NULL)
+			ok = false;
+	}
+	oval_object_content_iterator_free(contents);
+
+	struct oval_behavior_iterator *behaviors = oval_object_get_behaviors(object);
+	while (ok && oval_behavior_iterator_has_more(behaviors)) {
+		struct oval_behavior *behavior = oval_behavior_iterator_next(behaviors);
+		if (oscap_streq(oval_behavior_get_key(behavior), "recurse_direction") &&
+				!oscap_streq(oval_behavior_get_value(behavior), "none"))
+			ok = false;
+	}
+	oval_behavior_iterator_free(behaviors);
+
+	if (!ok)
+		return false;
+
+	if (filepath != NULL) {
+		_rescan_append_root_stat(fp, root, filepath);
+	} else if (path != NULL && has_filename) {
+		if (filename == NULL) {
+			/* xsi:nil, the object is the directory itself */
+			_rescan_append_root_stat(fp, root, path);
+		} else {
+			char *full_path = oscap_sprintf("%s/%s", path, filename);
+			_rescan_append_root_stat(fp, root, full_path);
+			free(full_path);
+		}
+	} else {
+		return false;
+	}
+	return true;
+}
+
+static void _rescan_append_object(struct oscap_string *fp, struct oval_object *object)
+{
+	oscap_string_append_string(fp, oval_subtype_get_text(oval_object_get_subtype(object)));
+	oscap_string_append_char(fp, '\n');
+
+	struct oval_object_content_iterator *contents = oval_object_get_object_contents(object);
+	while (oval_object_content_iterator_has_more(contents)) {
+		struct oval_entity *entity = oval_object_content_get_entity(oval_object_content_iterator_next(contents));
+		struct oval_value *value = oval_entity_get_value(entity);
+		char *text = oscap_sprintf("%s %s %s %d %s\n", oval_entity_get_name(entity),
+			oval_operation_get_text(oval_entity_get_operation(entity)),
+			oval_datatype_get_text(oval_entity_get_datatype(entity)),
+			oval_entity_get_mask(entity),
+			value != NULL ? oval_value_get_text(value) : "(nil)");
+		oscap_string_append_string(fp, text);
+		free(text);
+	}
+	oval_object_content_iterator_free(contents);
+
+	struct oval_behavior_iterator *behaviors = oval_object_get_behaviors(object);
+	while (oval_behavior_iterator_has_more(behaviors)) {
+		struct oval_behavior *behavior = oval_behavior_iterator_next(behaviors);
+		char *text = oscap_sprintf("%s=%s\n", oval_behavior_get_key(behavior), oval_behavior_get_value(behavior));
+		oscap_string_append_string(fp, text);
+		free(text);
+	}
+	oval_behavior_iterator_free(behaviors);
+}
+
+/*
+ * Fingerprint the object and the inputs its items are collected from.
+ * @return the fingerprint or NULL if the items of the object can't be reused
+ */
+static char *_rescan_fingerprint(struct oval_object *object)
+{
+	oval_subtype_t type = oval_object_get_subtype(object);
+	size_t i;
+
+	for (i = 0; i < sizeof(rescan_types) / sizeof(rescan_types[0]); ++i) {
+		if (rescan_types[i].type == type)
+			break;
+	}
+	if (i == sizeof(rescan_types) / sizeof(rescan_types[0]) || !oval_probe_object_is_independent(object))
+		return NULL;
+
+	const char *root = getenv("OSCAP_PROBE_ROOT");
+	if (root == NULL)
+		root = "";
+
+	struct oscap_string *fp = oscap_string_new();
+	oscap_string_append_string(fp, oscap_get_version());
+	oscap_string_append_char(fp, '\n');
+	oscap_string_append_string(fp, root);
+	oscap_string_append_char(fp, '\n');
+	_rescan_append_object(fp, object);
+
+	bool ok = true;
+	switch (rescan_types[i].input) {
+	case RESCAN_INPUT_NONE:
+		break;
+	case RESCAN_INPUT_BOOT:
+		_rescan_append_boot(fp);
+		break;
+	case RESCAN_INPUT_RPMDB:
+		_rescan_append_rpmdb(fp, root);
+		break;
+	case RESCAN_INPUT_DPKG:
+		_rescan_append_root_stat(fp, root, "/var/lib/dpkg/status");
+		break;
+	case RESCAN_INPUT_PATH:
+		ok = _rescan_append_path(fp, root, object);
+		break;
+	}
+
+	char *fingerprint = NULL;
+	if (ok) {
+		const char *text = oscap_string_get_cstr(fp);
+		fingerprint = oscap_sprintf("%016" PRIx64, oscap_digest(text, strlen(text), 0));
+	}
+	oscap_string_free(fp);
+	return fingerprint;
+}
+
+static bool _rescan_is_reusable(struct oval_syschar *syschar)
+{
+	switch (oval_syschar_get_flag(syschar)) {
+	case SYSCHAR_FLAG_COMPLETE:
+	case SYSCHAR_FLAG_DOES_NOT_EXIST:
+	case SYSCHAR_FLAG_NOT_APPLICABLE:
+		return oval_syschar_get_variable_instance(syschar) == 1;
+	default:
+		/* The object may collect fine next time */
+		return false;
+	}
+}
+
+static void _rescan_clear_previous(struct oval_probe_rescan *rescan)
+{
+	oval_syschar_model_free(rescan->prev);
+	rescan->prev = NULL;
+	oval_definition_model_free(rescan->prev_defs);
+	rescan->prev_defs = NULL;
+	if (rescan->prev_fingerprints != NULL)
+		oval_string_map_free(rescan->prev_fingerprints, free);
+	rescan->prev_fingerprints = NULL;
+}
+
+/*
+ * The reused items are trusted to be what the system looked like, refuse
+ * the previous scans anybody else could have written. Only the directory
+ * itself may be a symlink.
+ */
+static bool _rescan_is_trusted(const char *path, bool directory)
+{
+	struct stat st;
+	if ((directory ? stat(path, &st) : lstat(path, &st)) != 0)
+		return false;
+	if (directory ? !S_ISDIR(st.st_mode) : !S_ISREG(st.st_mode)) {
+		dW("The previous scan path '%s' is not a %s.", path, directory ? "directory" : "regular file");
+		return false;
+	}
+	if (st.st_uid != geteuid() || (st.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+		dW("The previous scan path '%s' is not owned by the current user or is writable by others.", path);
+		return false;
+	}
+	return true;
+}
+
+static int _rescan_load(struct oval_probe_rescan *rescan)
+{
+	if (access(rescan->fingerprint_path, F_OK) != 0) {
+		dI("No previous scan in '%s'.", rescan->fingerprint_path);
+		return 0;
+	}
+	if (!_rescan_is_trusted(rescan->dir, true) || !_rescan_is_trusted(rescan->fingerprint_path, false) ||
+			!_rescan_is_trusted(rescan->syschar_path, false))
+		return -1;
+
+	FILE *f = fopen(rescan->fingerprint_path, "r");
+	if (f == NULL) {
+		dI("No previous scan in '%s'.", rescan->fingerprint_path);
+		return 0;
+	}
+
+	char *line = NULL;
+	size_t size = 0;
+	ssize_t len;
+	char magic[32], format[8], version[32];
+	uint64_t syschar_digest, digest;
+	int ret = -1;
+
+	rescan->prev_fingerprints = oval_string_map_new();
+
+	if (getline(&line, &size, f) <= 0 ||
+			sscanf(line, "%31s %7s %31s %" SCNx64, magic, format, version, &syschar_digest) != 4 ||
+			strcmp(magic, OVAL_PROBE_RESCAN_MAGIC) != 0 || strcmp(format, OVAL_PROBE_RESCAN_FORMAT) != 0) {
+		dW("Ignoring the invalid fingerprints of the previous scan '%s'.", rescan->fingerprint_path);
+		goto cleanup;
+	}
+	if (strcmp(version, oscap_get_version()) != 0) {
+		dI("The previous scan '%s' was made by OpenSCAP %s, not reusing it.", rescan->fingerprint_path, version);
+		goto cleanup;
+	}
+	while ((len = getline(&line, &size, f)) > 0) {
+		if (line[len - 1] == '\n')
+			line[len - 1] = '\0';
+		char *fingerprint = strchr(line, ' ');
+		if (fingerprint == NULL)
+			continue;
+		*fingerprint++ = '\0';
+		if (oval_string_map_get_value(rescan->prev_fingerprints, line) == NULL)
+			oval_string_map_put_string(rescan->prev_fingerprints, line, fingerprint);
+	}
+
+	struct oscap_source *source = oscap_source_new_from_file(rescan->syschar_path);
+	if (oscap_source_get_digest(source, &digest) != 0 || digest != syschar_digest) {
+		/* Written by an interrupted scan */
+		dW("The system characteristics '%s' don't match their fingerprints.", rescan->syschar_path);
+		oscap_source_free(source);
+		goto cleanup;
+	}
+	rescan->prev_defs = oval_definition_model_new();
+	rescan->prev = oval_syschar_model_new(rescan->prev_defs);
+	if (oval_syschar_model_import_source(rescan->prev, source) != 0) {
+		dW("Can't import the system characteristics of the previous scan '%s'.", rescan->syschar_path);
+		oscap_source_free(source);
+		goto cleanup;
+	}
+	oscap_source_free(source);
+	dI("Reusing unchanged objects of the previous scan '%s'.", rescan->syschar_path);
+	ret = 0;
+
+cleanup:
+	free(line);
+	fclose(f);
+	return ret;
+}
+
+void oval_probe_rescan_open(oval_probe_session_t *sess, const char *name)
+{
+	const char *dir = getenv(OVAL_PROBE_RESCAN_ENV);
+	if (dir == NULL || *dir == '\0')
+		return;
+	if (name == NULL)
+		name = "";
+
+	struct oval_probe_rescan *rescan = calloc(1, sizeof(struct oval_probe_rescan));
+	uint64_t key = oscap_digest(name, strlen(name), 0);
+	rescan->dir = oscap_strdup(dir);
+	rescan->syschar_path = oscap_sprintf("%s/%016" PRIx64 ".xml", dir, key);
+	rescan->fingerprint_path = oscap_sprintf("%s/%016" PRIx64 ".fingerprints", dir, key);
+	rescan->fingerprints = oval_string_map_new();
+	rescan->items = oval_string_map_new();
+
+	if (_rescan_load(rescan) != 0) {
+		_rescan_clear_previous(rescan);
+		/* The previous scan is optional */
+		oscap_clearerr();
+	}
+	sess->rescan = rescan;
+}
+
+void oval_probe_rescan_free(struct oval_probe_rescan *rescan)
+{
+	if (rescan == NULL)
+		return;
+	_rescan_clear_previous(rescan);
+	oval_string_map_free(rescan->fingerprints, free);
+	oval_string_map_free(rescan->items, NULL);
+	free(rescan->dir);
+	free(rescan->syschar_path);
+	free(rescan->fingerprint_path);
+	free(rescan);
+}
+
+static struct oval_syschar *_rescan_clone(struct oval_probe_rescan *rescan, struct oval_syschar_model *model,
+		struct oval_object *object, struct oval_syschar *prev)
+{
+	struct oval_syschar *syschar = oval_syschar_new(model, object);
+	oval_syschar_set_flag(syschar, oval_syschar_get_flag(prev));
+
+	struct oval_message_iterator *messages = oval_syschar_get_messages(prev);
+	while (oval_message_iterator_has_more(messages))
+		oval_syschar_add_message(syschar, oval_message_clone(oval_message_iterator_next(messages)));
+	oval_message_iterator_free(messages);
+
+	/*
+	 * The items get new ids; the ids assigned by the probes start with 1,
+	 * the ones of the previous scan could be assigned again.
+	 */
+	struct oval_sysitem_iterator *items = oval_syschar_get_sysitem(prev);
+	while (oval_sysitem_iterator_has_more(items)) {
+		struct oval_sysitem *prev_item = oval_sysitem_iterator_next(items);
+		struct oval_sysitem *item = oval_string_map_get_value(rescan->items, oval_sysitem_get_id(prev_item));
+		if (item == NULL) {
+			char *id = oscap_sprintf("0%u", ++rescan->next_item);
+			item = oval_sysitem_clone_as(model, prev_item, id);
+			free(id);
+			oval_string_map_put(rescan->items, oval_sysitem_get_id(prev_item), item);
+		}
+		oval_syschar_add_sysitem(syschar, item);
+	}
+	oval_sysitem_iterator_free(items);
+
+	++rescan->reused;
+	return syschar;
+}
+
+struct oval_syschar *oval_probe_rescan_reuse(oval_probe_session_t *sess, struct oval_object *object)
+{
+	struct oval_probe_rescan *rescan = sess->rescan;
+	if (rescan == NULL)
+		return NULL;
+
+	const char *id = oval_object_get_id(object);
+	if (oval_string_map_get_value(rescan->fingerprints, id) != NULL)
+		return NULL;
+
+	/* Fingerprint before probing, changes made meanwhile are seen next time */
+	char *fingerprint = _rescan_fingerprint(object);
+	if (fingerprint == NULL)
+		return NULL;
+	oval_string_map_put(rescan->fingerprints, id, fingerprint);
+
+	if (rescan->prev == NULL)
+		return NULL;
+	const char *prev_fingerprint = oval_string_map_get_value(rescan->prev_fingerprints, id);
+	if (prev_fingerprint == NULL || strcmp(prev_fingerprint, fingerprint) != 0)
+		return NULL;
+	struct oval_syschar *prev = oval_syschar_model_get_syschar(rescan->prev, id);
+	if (prev == NULL || !_rescan_is_reusable(prev))
+		return NULL;
+
+	return _rescan_clone(rescan, sess->sys_model, object, prev);
+}
+
+void oval_probe_rescan_get_stats(oval_probe_session_t *sess, unsigned int *reused, unsigned int *probed)
+{
+	unsigned int count = 0;
+
+	struct oval_syschar_iterator *syschars = oval_syschar_model_get_syschars(sess->sys_model);
+	while (oval_syschar_iterator_has_more(syschars)) {
+		oval_syschar_iterator_next(syschars);
+		++count;
+	}
+	oval_syschar_iterator_free(syschars);
+
+	*reused = sess->rescan != NULL ? sess->rescan->reused : 0;
+	*probed = count - *reused;
+}
+
+static int _rescan_write_syschars(struct oval_syschar_model *model, const char *path, uint64_t *digest)
+{
+	if (oval_syschar_model_export(model, path) < 0)
+		return -1;
+	struct oscap_source *source = oscap_source_new_from_file(path);
+	int ret = oscap_source_get_digest(source, digest);
+	oscap_source_free(source);
+	return ret;
+}
+
+static int _rescan_write_fingerprints(const char *path, uint64_t digest, struct oscap_string *fingerprints)
+{
+	FILE *f = fopen(path, "w");
+	if (f == NULL)
+		return -1;
+	fprintf(f, "%s %s %s %016" PRIx64 "\n", OVAL_PROBE_RESCAN_MAGIC, OVAL_PROBE_RESCAN_FORMAT,
+		oscap_get_version(), digest);
+	fputs(oscap_string_get_cstr(fingerprints), f);
+	int ret = ferror(f) ? -1 : 0;
+	if (fclose(f) != 0)
+		ret = -1;
+	return ret;
+}
+
+int oval_probe_rescan_store(oval_probe_session_t *sess)
+{
+	struct oval_probe_rescan *rescan = sess->rescan;
+	unsigned int reused, probed;
+
+	if (rescan == NULL)
+		return 0;
+	oval_probe_rescan_get_stats(sess, &reused, &probed);
+	if (reused + probed == 0) {
+		/* Nothing was evaluated, keep the previous scan */
+		return 0;
+	}
+	dI("Incremental scan: %u objects reused from the previous scan, %u objects probed.", reused, probed);
+
+	if (mkdir(rescan->dir, 0700) != 0 && errno != EEXIST) {
+		dW("Can't create the directory of the previous scans '%s': %s", rescan->dir, strerror(errno));
+		return -1;
+	}
+	if (!_rescan_is_trusted(rescan->dir, true))
+		return -1;
+
+	struct oval_syschar_model *model = oval_syschar_model_new(oval_syschar_model_get_definition_model(sess->sys_model));
+	struct oval_sysinfo *sysinfo = oval_syschar_model_get_sysinfo(sess->sys_model);
+	if (sysinfo != NULL)
+		oval_syschar_model_set_sysinfo(model, sysinfo);
+
+	struct oscap_string *fingerprints = oscap_string_new();
+	struct oval_syschar_iterator *syschars = oval_syschar_model_get_syschars(sess->sys_model);
+	while (oval_syschar_iterator_has_more(syschars)) {
+		struct oval_syschar *syschar = oval_syschar_iterator_next(syschars);
+		const char *id = oval_syschar_get_id(syschar);
+		const char *fingerprint = oval_string_map_get_value(rescan->fingerprints, id);
+
+		if (fingerprint == NULL || !_rescan_is_reusable(syschar))
+			continue;
+		oval_syschar_clone(model, syschar);
+		oscap_string_append_string(fingerprints, id);
+		oscap_string_append_char(fingerprints, ' ');
+		oscap_string_append_string(fingerprints, fingerprint);
+		oscap_string_append_char(fingerprints, '\n');
+	}
+	oval_syschar_iterator_free(syschars);
+
+	/*
+	 * The fingerprints carry the digest of the system characteristics, an
+	 * interrupted store leaves a pair that is not used.
+	 */
+	char *syschar_tmp = oscap_sprintf("%s.XXXXXX", rescan->syschar_path);
+	char *fingerprint_tmp = oscap_sprintf("%s.XXXXXX", rescan->fingerprint_path);
+	int syschar_fd = mkstemp(syschar_tmp);
+	int fingerprint_fd = mkstemp(fingerprint_tmp);
+	uint64_t digest;
+	int ret = -1;
+
+	if (syschar_fd != -1 && fingerprint_fd != -1) {
+		close(syschar_fd);
+		close(fingerprint_fd);
+		syschar_fd = fingerprint_fd = -1;
+		if (_rescan_write_syschars(model, syschar_tmp, &digest) == 0 &&
+				_rescan_write_fingerprints(fingerprint_tmp, digest, fingerprints) == 0 &&
+				rename(syschar_tmp, rescan->syschar_path) == 0 &&
+				rename(fingerprint_tmp, rescan->fingerprint_path) == 0)
+			ret = 0;
+	}
+	if (syschar_fd != -1)
+		close(syschar_fd);
+	if (fingerprint_fd != -1)
+		close(fingerprint_fd);
+	if (ret != 0) {
+		dW("Failed to store the scan in '%s'.", rescan->dir);
+		unlink(syschar_tmp);
+		unlink(fingerprint_tmp);
+		/* The incremental scan is optional, don't report its failures to the caller */
+		oscap_clearerr();
+	}
+
+	free(syschar_tmp);
+	free(fingerprint_tmp);
+	oscap_string_free(fingerprints);
+	oval_syschar_model_free(model);
+	return ret;
+}
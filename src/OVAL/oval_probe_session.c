@@ -151,6 +151,7 @@ static void oval_probe_session_init(oval_probe_session_t *sess, struct oval_sysc
 oval_probe_session_t *oval_probe_session_new(struct oval_syschar_model *model)
 {
         oval_probe_session_t *sess = oscap_talloc(oval_probe_session_t);
+        sess->rescan = NULL;
         oval_probe_session_init(sess, model);
         return sess;
 }
@@ -176,6 +177,7 @@ void oval_probe_session_reinit(oval_probe_session_t *sess, struct oval_syschar_m
 void oval_probe_session_destroy(oval_probe_session_t *sess)
 {
 	oval_probe_session_free(sess);
+	oval_probe_rescan_free(sess->rescan);
 	free(sess);
 }
 
@@ -36,9 +36,11 @@
 
 #include "common/alloc.h"
 #include "common/debug_priv.h"
+#include "common/oscap_acquire.h"
 #include "common/util.h"
 #include "common/_error.h"
 #include "common/oscapxml.h"
+#include "source/oscap_source_priv.h"
 #include "source/xslt_priv.h"
 #include "public/oval_agent_api.h"
 #include "public/oval_session.h"
@@ -398,6 +400,17 @@ int oval_session_evaluate(struct oval_session *session, char *probe_root, agent_
 	return 0;
 }
 
+void oval_session_get_rescan_stats(struct oval_session *session, unsigned int *reused, unsigned int *probed)
+{
+	__attribute__nonnull__(session);
+
+	if (session->sess != NULL) {
+		oval_agent_get_rescan_stats(session->sess, reused, probed);
+	} else {
+		*reused = *probed = 0;
+	}
+}
+
 int oval_session_export(struct oval_session *session)
 {
 	__attribute__nonnull__(session);
@@ -405,6 +418,7 @@ int oval_session_export(struct oval_session *session)
 	struct oval_directives_model *dir_model = NULL;
 	struct oscap_source *result = NULL;		/* OVAL Results */
 	const char *filename = NULL;
+	char *streamed = NULL;		/* temporary file the results are written to */
 	int ret = 0;
 
 	/* Import OVAL Directives if any */
@@ -421,8 +435,22 @@ int oval_session_export(struct oval_session *session)
 	 * directives to them */
 	if (session->res_model && (session->export.results || session->export.report)) {
 		oval_results_model_set_export_system_characteristics(session->res_model, session->export_sys_chars);
-		result = oval_results_model_export_source(session->res_model, dir_model, NULL);
 		filename = session->export.results;
+		if (filename && strcmp(filename, "-") && !session->export.report) {
+			/* Nothing needs the DOM of the results, write them to a file
+			 * as they are serialized and validate the file afterwards. The
+			 * file replaces the target only if it passes the validation. */
+			streamed = oscap_acquire_temp_sibling(filename);
+			if (streamed == NULL)
+				goto cleanup;
+			if (oval_results_model_export(session->res_model, dir_model, streamed) != 0)
+				goto cleanup;
+			result = oscap_source_new_map_file(streamed, filename);
+			if (result == NULL)
+				goto cleanup;
+		} else {
+			result = oval_results_model_export_source(session->res_model, dir_model, NULL);
+		}
 	}
 
 	/* Validate OVAL Results. The 'result' in condition will make sure that there is
@@ -432,7 +460,12 @@ int oval_session_export(struct oval_session *session)
 			goto cleanup;
 	}
 
-	if (session->export.results && result) {	/* export to XML */
+	if (streamed) {
+		if (oscap_acquire_rename_sibling(streamed, filename) != 0)
+			goto cleanup;
+		free(streamed);
+		streamed = NULL;
+	} else if (session->export.results && result) {	/* export to XML */
 		if (oscap_source_save_as(result, filename) != 0)
 			goto cleanup;
 	}
@@ -458,6 +491,10 @@ int oval_session_export(struct oval_session *session)
 	ret = 0; 	/* successfull export */
 
 cleanup:
+	if (streamed) {
+		unlink(streamed);
+		free(streamed);
+	}
 	if (result)
 		oscap_source_free(result);
 	if (dir_model)
@@ -75,7 +75,12 @@ struct oval_sysitem *oval_sysitem_new(struct oval_syschar_model *model, const ch
 
 struct oval_sysitem *oval_sysitem_clone(struct oval_syschar_model *new_model, struct oval_sysitem *old_item)
 {
-	struct oval_sysitem *new_item = oval_sysitem_new(new_model, oval_sysitem_get_id(old_item));
+	return oval_sysitem_clone_as(new_model, old_item, oval_sysitem_get_id(old_item));
+}
+
+struct oval_sysitem *oval_sysitem_clone_as(struct oval_syschar_model *new_model, struct oval_sysitem *old_item, const char *id)
+{
+	struct oval_sysitem *new_item = oval_sysitem_new(new_model, id);
 
 	struct oval_message_iterator *old_messages = oval_sysitem_get_messages(old_item);
 	while (oval_message_iterator_has_more(old_messages)) {
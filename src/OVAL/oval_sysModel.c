@@ -244,7 +244,10 @@ int oval_syschar_model_import_source(struct oval_syschar_model *model, struct os
         context.user_data = NULL;
 
 	/* jump into oval_system_characteristics */
-	xmlTextReaderRead(context.reader);
+	if (xmlTextReaderRead(context.reader) != 1) {
+		xmlFreeTextReader(context.reader);
+		return -1;
+	}
 	/* make sure this is syschar */
 	char *tagname = (char *)xmlTextReaderLocalName(context.reader);
 	char *namespace = (char *)xmlTextReaderNamespaceUri(context.reader);
@@ -258,6 +261,9 @@ int oval_syschar_model_import_source(struct oval_syschar_model *model, struct os
 		ret = -1;
 	}
 
+	if (oscap_source_xmlTextReader_failed(context.reader))
+		ret = -1;
+
 	free(tagname);
 	free(namespace);
 	xmlFreeTextReader(context.reader);
@@ -319,7 +325,8 @@ struct oval_sysitem *oval_syschar_model_get_new_sysitem(struct oval_syschar_mode
 }
 
 xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xmlDocPtr doc, xmlNode * parent, 
-			           oval_syschar_resolver resolver, void *user_arg, bool export_syschar)
+			           oval_syschar_resolver resolver, void *user_arg, bool export_syschar,
+			           struct oscap_xml_stream *stream)
 {
 
 	xmlNodePtr root_node = NULL;
@@ -345,6 +352,7 @@ xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xm
 	xmlSetNs(root_node, ns_lin);
 	xmlSetNs(root_node, ns_win);
 	xmlSetNs(root_node, ns_syschar);
+	oscap_xml_stream_push(stream, root_node);
 
         /* Always report the generator */
 	oval_generator_to_dom(syschar_model->generator, doc, root_node);
@@ -353,6 +361,7 @@ xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xm
 	oval_sysinfo_to_dom(oval_syschar_model_get_sysinfo(syschar_model), doc, root_node);
 
 	if (!export_syschar) {
+		oscap_xml_stream_pop(stream);
 		return root_node;
 	}
 
@@ -373,6 +382,7 @@ xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xm
 	struct oval_string_map *sysitem_map = oval_string_map_new();
 	if (oval_syschar_iterator_has_more(syschars)) {
 		xmlNode *tag_objects = xmlNewTextChild(root_node, ns_syschar, BAD_CAST "collected_objects", NULL);
+		oscap_xml_stream_push(stream, tag_objects);
 
 		while (oval_syschar_iterator_has_more(syschars)) {
 			struct oval_syschar *syschar = oval_syschar_iterator_next(syschars);
@@ -381,6 +391,7 @@ xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xm
 			    || oval_object_get_base_obj(object)) /* Skip internal objects */
 				continue;
 			oval_syschar_to_dom(syschar, doc, tag_objects);
+			oscap_xml_stream_flush(stream);
 			struct oval_sysitem_iterator *sysitems = oval_syschar_get_sysitem(syschar);
 			while (oval_sysitem_iterator_has_more(sysitems)) {
 				struct oval_sysitem *sysitem = oval_sysitem_iterator_next(sysitems);
@@ -388,6 +399,7 @@ xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xm
 			}
 			oval_sysitem_iterator_free(sysitems);
 		}
+		oscap_xml_stream_pop(stream);
 	}
 	oval_smc_free0(resolved_smc);
 	oval_syschar_iterator_free(syschars);
@@ -395,14 +407,18 @@ xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xm
 	struct oval_iterator *sysitems = oval_string_map_values(sysitem_map);
 	if (oval_collection_iterator_has_more(sysitems)) {
 		xmlNode *tag_items = xmlNewTextChild(root_node, ns_syschar, BAD_CAST "system_data", NULL);
+		oscap_xml_stream_push(stream, tag_items);
 		while (oval_collection_iterator_has_more(sysitems)) {
 			struct oval_sysitem *sysitem = (struct oval_sysitem *)
 			    oval_collection_iterator_next(sysitems);
 			oval_sysitem_to_dom(sysitem, doc, tag_items);
+			oscap_xml_stream_flush(stream);
 		}
+		oscap_xml_stream_pop(stream);
 	}
 	oval_collection_iterator_free(sysitems);
 	oval_string_map_free(sysitem_map, NULL);
+	oscap_xml_stream_pop(stream);
 
 	return root_node;
 }
@@ -420,7 +436,15 @@ int oval_syschar_model_export(struct oval_syschar_model *model, const char *file
 		return -1;
 	}
 
-	oval_syschar_model_to_dom(model, doc, NULL, NULL, NULL, true);
-	return oscap_xml_save_filename_free(file, doc);
+	struct oscap_xml_stream *stream = oscap_xml_stream_new(file, doc);
+	if (stream == NULL) {
+		xmlFreeDoc(doc);
+		return -1;
+	}
+
+	oval_syschar_model_to_dom(model, doc, NULL, NULL, NULL, true, stream);
+	int ret = oscap_xml_stream_close(stream);
+	xmlFreeDoc(doc);
+	return ret;
 }
 
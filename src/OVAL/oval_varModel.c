@@ -310,7 +310,7 @@ struct oval_variable_model *oval_variable_model_import_source(struct oscap_sourc
 	xmlTextReaderRead(reader);
 	struct oval_variable_model *model = oval_variable_model_new();
 	ret = _oval_variable_model_parse(model, reader, NULL);
-	if (ret != 1) {
+	if (ret != 1 || oscap_source_xmlTextReader_failed(reader)) {
 		oval_variable_model_free(model);
 		model = NULL;
 	}
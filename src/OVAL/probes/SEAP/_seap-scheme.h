@@ -82,6 +82,10 @@ SEAP_scheme_t SEAP_scheme_search (const SEAP_schemefn_t fntable[], const char *s
 #include "sch_pipe.h"
 #define SCH_PIPE    3
 
+/* shm */
+#include "sch_shm.h"
+#define SCH_SHM     4
+
 #define SCH_NONE    255
 
 
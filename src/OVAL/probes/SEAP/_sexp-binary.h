@@ -0,0 +1,88 @@
+/*
+ * Copyright 2009 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#pragma once
+#ifndef _SEXP_BINARY_H
+#define _SEXP_BINARY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "public/sexp-types.h"
+#include "../../../common/util.h"
+
+
+/*
+ * Binary S-exp frame
+ *
+ *  +-------+-----------------+--------------------+
+ *  | magic | length (LE u32) | payload (one S-exp) |
+ *  +-------+-----------------+--------------------+
+ *
+ * The payload is a sequence of tagged elements:
+ *
+ *  'L' <count>          list, followed by <count> elements
+ *  'S' <len> <bytes>    string
+ *  'D' <len> <bytes>    string, appended to the frame string table
+ *  'R' <index>          string from the frame string table
+ *  'N' <type> <value>   number of type SEXP_NUM_*, the value is a varint
+ *                       (zigzag encoded for signed types), one byte for
+ *                       bool and 8 raw bytes for double; the decoder
+ *                       picks the same number type as the textual
+ *                       parser would
+ *  'Y' <index>          datatype from the frame datatype table
+ *  'y' <len> <bytes>    datatype, appended to the frame datatype table
+ *
+ * All <count>, <len> and <index> values are unsigned LEB128 varints.
+ * A datatype element applies to the element that follows it. The
+ * string and datatype tables are local to a frame.
+ *
+ * The magic byte can't start a textual S-exp, so a receiver can tell
+ * the two formats apart by looking at the first byte.
+ */
+#define SEXP_BIN_MAGIC   0xb5
+#define SEXP_BIN_HDRSIZE 5
+
+/*
+ * Strings up to this length are put into the string table
+ * (entity names, attribute names, datatype hints, ...)
+ */
+#define SEXP_BIN_STRTBL_STRMAX 32
+#define SEXP_BIN_STRTBL_MAX    4096
+
+/**
+ * Encode an S-exp into a binary frame.
+ * @param s_exp the S-exp
+ * @param frame pointer to the allocated frame is stored here
+ * @param size size of the frame is stored here
+ * @return 0 on success, -1 on failure
+ */
+int SEXP_bin_frame(const SEXP_t *s_exp, uint8_t **frame, size_t *size);
+
+/**
+ * Decode one binary frame.
+ * @param buf buffer containing the frame
+ * @param len length of the data in the buffer
+ * @param s_exp the decoded S-exp is stored here
+ * @return number of bytes consumed, 0 if the buffer doesn't contain
+ *         a complete frame yet, -1 on failure (errno is set to EILSEQ)
+ */
+ssize_t SEXP_bin_unframe(const uint8_t *buf, size_t len, SEXP_t **s_exp);
+
+#endif /* _SEXP_BINARY_H */
@@ -190,17 +190,44 @@ static int check_child (pid_t pid, int waitf)
         return (1);
 }
 
-int sch_pipe_connect (SEAP_desc_t *desc, const char *uri, uint32_t flags)
+/*
+ * Environment of the probe process. Unless the format was
+ * chosen by the user, ask the probe to send binary frames.
+ * The array is prepared before fork() so that the child
+ * doesn't need to allocate memory.
+ */
+static char **child_environ (char *extra)
+{
+        static char fmt_env[] = SEAP_FORMAT_ENV "=" SEAP_FORMAT_BINARY;
+        char  **envp;
+        size_t  envc, i;
+
+        if (getenv (SEAP_FORMAT_ENV) != NULL && extra == NULL)
+                return (environ);
+
+        for (envc = 0; environ[envc] != NULL; ++envc);
+
+        envp = sm_alloc (sizeof (char *) * (envc + 3));
+        memcpy (envp, environ, sizeof (char *) * envc);
+        i = envc;
+
+        if (getenv (SEAP_FORMAT_ENV) == NULL)
+                envp[i++] = fmt_env;
+        if (extra != NULL)
+                envp[i++] = extra;
+
+        envp[i] = NULL;
+
+        return (envp);
+}
+
+int sch_pipe_spawn (sch_pipedata_t *data, const char *uri, uint32_t flags,
+                    char *child_env, const int *child_fds)
 {
-        sch_pipedata_t *data;
         pid_t pid;
         int   pfd[2] = { -1, -1 };
+        char **envp;
 
-        assume_r (desc != NULL, -1, errno = EFAULT;);
-        assume_r (uri  != NULL, -1, errno = EFAULT;);
-        assume_r (desc->scheme_data == NULL, -1, errno = EALREADY;);
-
-        data = (sch_pipedata_t *) sm_talloc (sch_pipedata_t);
         data->execpath = get_exec_path (uri, flags);
 
         if (data->execpath == NULL) {
@@ -218,10 +245,17 @@ int sch_pipe_connect (SEAP_desc_t *desc, const char *uri, uint32_t flags)
         if (socketpair (AF_UNIX, SOCK_STREAM, 0, pfd) < 0)
                 goto fail1;
 
+        envp = child_environ (child_env);
+
         switch (pid = fork ()) {
         case -1: /* error */
+                if (envp != environ)
+                        sm_free (envp);
                 goto fail1;
         case  0: /* child */
+        {
+                char *argv[2] = { data->execpath, NULL };
+
                 close (pfd[0]);
 
                 /*
@@ -231,9 +265,22 @@ int sch_pipe_connect (SEAP_desc_t *desc, const char *uri, uint32_t flags)
                         _exit (errno);
                 if (dup2 (pfd[1], STDOUT_FILENO) != STDOUT_FILENO)
                         _exit (errno);
-                execl (data->execpath, data->execpath, NULL);
+
+                /*
+                 * additional descriptors passed to the probe
+                 */
+                for (; child_fds != NULL && *child_fds != -1; ++child_fds) {
+                        if (fcntl (*child_fds, F_SETFD, 0) != 0)
+                                _exit (errno);
+                }
+
+                execve (data->execpath, argv, envp);
                 _exit (errno);
+        }
         default: /* parent */
+                if (envp != environ)
+                        sm_free (envp);
+
                 close (pfd[1]);
 
                 data->pfd = pfd[0];
@@ -243,8 +290,6 @@ int sch_pipe_connect (SEAP_desc_t *desc, const char *uri, uint32_t flags)
                         goto fail2;
         }
 
-        desc->scheme_data = (void *)data;
-
         return (0);
 fail2:
         protect_errno {
@@ -254,11 +299,33 @@ fail1:
         protect_errno {
                 if (data->execpath != NULL)
                         sm_free (data->execpath);
-                sm_free (data);
+                data->execpath = NULL;
         }
         return (-1);
 }
 
+int sch_pipe_connect (SEAP_desc_t *desc, const char *uri, uint32_t flags)
+{
+        sch_pipedata_t *data;
+
+        assume_r (desc != NULL, -1, errno = EFAULT;);
+        assume_r (uri  != NULL, -1, errno = EFAULT;);
+        assume_r (desc->scheme_data == NULL, -1, errno = EALREADY;);
+
+        data = (sch_pipedata_t *) sm_talloc (sch_pipedata_t);
+
+        if (sch_pipe_spawn (data, uri, flags, NULL, NULL) != 0) {
+                protect_errno {
+                        sm_free (data);
+                }
+                return (-1);
+        }
+
+        desc->scheme_data = (void *)data;
+
+        return (0);
+}
+
 int sch_pipe_openfd (SEAP_desc_t *desc, int fd, uint32_t flags)
 {
         errno = EOPNOTSUPP;
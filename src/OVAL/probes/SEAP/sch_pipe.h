@@ -35,6 +35,15 @@ typedef struct {
         char *execpath;
 } sch_pipedata_t;
 
+/**
+ * Execute the probe and connect its standard input and output to a socket.
+ * @param data the pid, socket and executable path are stored here
+ * @param child_env additional "NAME=value" environment variable or NULL
+ * @param child_fds descriptors inherited by the probe (terminated by -1) or NULL
+ */
+int sch_pipe_spawn (sch_pipedata_t *data, const char *uri, uint32_t flags,
+                    char *child_env, const int *child_fds);
+
 int sch_pipe_connect (SEAP_desc_t *desc, const char *uri, uint32_t flags);
 int sch_pipe_openfd (SEAP_desc_t *desc, int fd, uint32_t flags);
 int sch_pipe_openfd2 (SEAP_desc_t *desc, int ifd, int ofd, uint32_t flags);
@@ -0,0 +1,629 @@
+/*
+ * Copyright 2009 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <common/assume.h>
+
+#if defined(HAVE_MEMFD_CREATE) && defined(HAVE_SYS_EVENTFD_H) && defined(HAVE_ATOMIC_BUILTINS)
+# include <sys/eventfd.h>
+# define SCH_SHM_SUPPORTED
+#endif
+
+#include "generic/common.h"
+#include "public/sm_alloc.h"
+#include "public/strbuf.h"
+#include "_sexp-types.h"
+#include "_sexp-output.h"
+#include "_seap-types.h"
+#include "_seap-scheme.h"
+#include "sch_shm.h"
+#include "seap-descriptor.h"
+
+#define DATA(ptr) ((sch_shmdata_t *)(ptr))
+#define LIBSIDE(data) ((data)->pipe.pid != 0)
+
+#ifndef POLLRDHUP
+# define POLLRDHUP 0
+#endif
+
+#if defined(SCH_SHM_SUPPORTED)
+static int shm_ring_create (sch_shmdata_t *data)
+{
+        int memfd;
+
+        data->ring_mapsize = sizeof (sch_shmring_t) + SCH_SHM_RINGSIZE;
+
+        memfd = memfd_create ("oscap-seap", MFD_CLOEXEC);
+
+        if (memfd < 0)
+                return (-1);
+
+        if (ftruncate (memfd, (off_t)data->ring_mapsize) != 0)
+                goto fail;
+
+        data->ring = mmap (NULL, data->ring_mapsize, PROT_READ|PROT_WRITE, MAP_SHARED, memfd, 0);
+
+        if (data->ring == MAP_FAILED) {
+                data->ring = NULL;
+                goto fail;
+        }
+
+        data->ring->magic = SCH_SHM_MAGIC;
+        data->ring->size  = SCH_SHM_RINGSIZE;
+
+        data->ev_data  = eventfd (0, EFD_CLOEXEC|EFD_NONBLOCK);
+        data->ev_space = eventfd (0, EFD_CLOEXEC|EFD_NONBLOCK);
+
+        if (data->ev_data < 0 || data->ev_space < 0)
+                goto fail;
+
+        return (memfd);
+fail:
+        protect_errno {
+                if (data->ring != NULL)
+                        munmap (data->ring, data->ring_mapsize);
+                if (data->ev_data >= 0)
+                        close (data->ev_data);
+                if (data->ev_space >= 0)
+                        close (data->ev_space);
+
+                data->ring     = NULL;
+                data->ev_data  = -1;
+                data->ev_space = -1;
+
+                close (memfd);
+        }
+        return (-1);
+}
+
+static int shm_ring_attach (sch_shmdata_t *data, const char *env)
+{
+        struct stat st;
+        int memfd, ev_data, ev_space;
+        sch_shmring_t *ring;
+
+        if (sscanf (env, "%d:%d:%d", &memfd, &ev_data, &ev_space) != 3) {
+                errno = EINVAL;
+                return (-1);
+        }
+
+        /* Don't pass the descriptors to processes executed by the probe */
+        if (fcntl (memfd, F_SETFD, FD_CLOEXEC) != 0 ||
+            fcntl (ev_data, F_SETFD, FD_CLOEXEC) != 0 ||
+            fcntl (ev_space, F_SETFD, FD_CLOEXEC) != 0)
+                return (-1);
+
+        if (fstat (memfd, &st) != 0 || (size_t)st.st_size < sizeof (sch_shmring_t))
+                goto fail;
+
+        ring = mmap (NULL, (size_t)st.st_size, PROT_READ|PROT_WRITE, MAP_SHARED, memfd, 0);
+
+        if (ring == MAP_FAILED)
+                goto fail;
+
+        if (ring->magic != SCH_SHM_MAGIC ||
+            sizeof (sch_shmring_t) + ring->size != (size_t)st.st_size)
+        {
+                munmap (ring, (size_t)st.st_size);
+                errno = EINVAL;
+                goto fail;
+        }
+
+        close (memfd);
+
+        data->ring         = ring;
+        data->ring_mapsize = (size_t)st.st_size;
+        data->ev_data      = ev_data;
+        data->ev_space     = ev_space;
+
+        return (0);
+fail:
+        protect_errno {
+                close (memfd);
+                close (ev_data);
+                close (ev_space);
+        }
+        return (-1);
+}
+
+static void shm_signal (int evfd)
+{
+        eventfd_write (evfd, 1);
+}
+
+/*
+ * Wait until the eventfd is signalled or until an event occurs on
+ * the second descriptor. Returns 0 for the eventfd, 1 for the other
+ * descriptor and -1 on failure or timeout.
+ */
+static int shm_wait (int evfd, int fd, short events, int timeout)
+{
+        struct pollfd pfd[2];
+        eventfd_t val;
+
+        pfd[0].fd = evfd;
+        pfd[0].events = POLLIN;
+        pfd[1].fd = fd;
+        pfd[1].events = events;
+
+        for (;;) {
+                switch (poll (pfd, 2, timeout)) {
+                case -1:
+                        if (errno == EINTR)
+                                continue;
+                        return (-1);
+                case  0:
+                        errno = ETIMEDOUT;
+                        return (-1);
+                }
+
+                if (pfd[0].revents & POLLIN) {
+                        eventfd_read (evfd, &val);
+                        return (0);
+                }
+
+                return (1);
+        }
+}
+
+static size_t shm_ring_read (sch_shmring_t *ring, int ev_space, void *buf, size_t len)
+{
+        uint64_t head, tail;
+        size_t   n, off, part;
+
+        head = ring->head;
+        tail = ring->tail;
+        __sync_synchronize ();
+
+        if (head == tail)
+                return (0);
+
+        n    = (size_t)(head - tail) < len ? (size_t)(head - tail) : len;
+        off  = (size_t)(tail & (ring->size - 1));
+        part = ring->size - off < n ? ring->size - off : n;
+
+        memcpy (buf, ring->data + off, part);
+        memcpy ((uint8_t *)buf + part, ring->data, n - part);
+
+        __sync_synchronize ();
+        ring->tail = tail + n;
+        __sync_synchronize ();
+
+        if (__sync_lock_test_and_set (&ring->wwait, 0))
+                shm_signal (ev_space);
+
+        return (n);
+}
+
+static ssize_t shm_ring_write (sch_shmdata_t *data, const void *buf, size_t len)
+{
+        sch_shmring_t *ring = data->ring;
+        uint64_t head, tail;
+        size_t   n, off, part;
+
+        for (;;) {
+                head = ring->head;
+                tail = ring->tail;
+                __sync_synchronize ();
+
+                if (head - tail < ring->size)
+                        break;
+
+                ring->wwait = 1;
+                __sync_synchronize ();
+
+                if (ring->head - ring->tail < ring->size) {
+                        ring->wwait = 0;
+                        continue;
+                }
+
+                /* Wait for the library to make some space or to go away */
+                switch (shm_wait (data->ev_space, data->ifd, POLLRDHUP, -1)) {
+                case 0:
+                        continue;
+                case 1:
+                        errno = EPIPE;
+                        /* FALLTHROUGH */
+                default:
+                        return (-1);
+                }
+        }
+
+        n    = ring->size - (size_t)(head - tail) < len ? ring->size - (size_t)(head - tail) : len;
+        off  = (size_t)(head & (ring->size - 1));
+        part = ring->size - off < n ? ring->size - off : n;
+
+        memcpy (ring->data + off, buf, part);
+        memcpy (ring->data, (const uint8_t *)buf + part, n - part);
+
+        __sync_synchronize ();
+        ring->head = head + n;
+        __sync_synchronize ();
+
+        if (__sync_lock_test_and_set (&ring->rwait, 0))
+                shm_signal (data->ev_data);
+
+        return ((ssize_t)n);
+}
+
+static void shm_ring_close (sch_shmdata_t *data)
+{
+        if (data->ring != NULL) {
+                if (!LIBSIDE(data)) {
+                        data->ring->closed = 1;
+                        __sync_synchronize ();
+
+                        if (__sync_lock_test_and_set (&data->ring->rwait, 0))
+                                shm_signal (data->ev_data);
+                }
+
+                munmap (data->ring, data->ring_mapsize);
+                data->ring = NULL;
+        }
+
+        if (data->ev_data >= 0)
+                close (data->ev_data);
+        if (data->ev_space >= 0)
+                close (data->ev_space);
+
+        data->ev_data  = -1;
+        data->ev_space = -1;
+}
+#else
+static int shm_ring_create (sch_shmdata_t *data)
+{
+        errno = ENOSYS;
+        return (-1);
+}
+
+static int shm_ring_attach (sch_shmdata_t *data, const char *env)
+{
+        errno = ENOSYS;
+        return (-1);
+}
+
+static void shm_ring_close (sch_shmdata_t *data)
+{
+        return;
+}
+#endif /* SCH_SHM_SUPPORTED */
+
+static sch_shmdata_t *shm_data_new (void)
+{
+        sch_shmdata_t *data;
+
+        data = sm_talloc (sch_shmdata_t);
+        memset (data, 0, sizeof (sch_shmdata_t));
+
+        data->ifd      = -1;
+        data->ofd      = -1;
+        data->ring     = NULL;
+        data->ev_data  = -1;
+        data->ev_space = -1;
+
+        return (data);
+}
+
+int sch_shm_connect (SEAP_desc_t *desc, const char *uri, uint32_t flags)
+{
+        sch_shmdata_t *data;
+        char env[64];
+        int  fds[4], memfd;
+
+        assume_r (desc != NULL, -1, errno = EFAULT;);
+        assume_r (uri  != NULL, -1, errno = EFAULT;);
+        assume_r (desc->scheme_data == NULL, -1, errno = EALREADY;);
+
+        data  = shm_data_new ();
+        memfd = shm_ring_create (data);
+
+        if (memfd < 0) {
+                dI("Can't set up the shared memory ring: %s; using the socket.", strerror (errno));
+
+                if (sch_pipe_spawn (&data->pipe, uri, flags, NULL, NULL) != 0)
+                        goto fail;
+        } else {
+                snprintf (env, sizeof env, "%s=%d:%d:%d", SEAP_SHM_ENV,
+                          memfd, data->ev_data, data->ev_space);
+
+                fds[0] = memfd;
+                fds[1] = data->ev_data;
+                fds[2] = data->ev_space;
+                fds[3] = -1;
+
+                if (sch_pipe_spawn (&data->pipe, uri, flags, env, fds) != 0) {
+                        protect_errno {
+                                close (memfd);
+                        }
+                        goto fail;
+                }
+
+                close (memfd);
+        }
+
+        desc->scheme_data = (void *)data;
+
+        return (0);
+fail:
+        protect_errno {
+                shm_ring_close (data);
+                sm_free (data);
+        }
+        return (-1);
+}
+
+int sch_shm_openfd (SEAP_desc_t *desc, int fd, uint32_t flags)
+{
+        errno = EOPNOTSUPP;
+        return (-1);
+}
+
+int sch_shm_openfd2 (SEAP_desc_t *desc, int ifd, int ofd, uint32_t flags)
+{
+        sch_shmdata_t *data;
+        const char    *env;
+
+        data = shm_data_new ();
+        data->ifd = ifd;
+        data->ofd = ofd;
+
+        env = getenv (SEAP_SHM_ENV);
+
+        if (env != NULL && shm_ring_attach (data, env) != 0)
+                dI("Can't attach the shared memory ring: %s; using the output descriptor.", strerror (errno));
+
+        desc->scheme_data = (void *)data;
+
+        return (0);
+}
+
+ssize_t sch_shm_recv (SEAP_desc_t *desc, void *buf, size_t len, uint32_t flags)
+{
+        sch_shmdata_t *data;
+
+        assume_d (desc != NULL, -1, errno = EFAULT;);
+        assume_d (buf  != NULL, -1, errno = EFAULT;);
+
+        data = DATA(desc->scheme_data);
+
+        assume_r (data != NULL, -1, errno = EBADF;);
+
+        if (!LIBSIDE(data))
+                return read (data->ifd, buf, len);
+        if (data->ring == NULL)
+                return sch_pipe_recv (desc, buf, len, flags);
+
+#if defined(SCH_SHM_SUPPORTED)
+        for (;;) {
+                size_t n;
+
+                if ((n = shm_ring_read (data->ring, data->ev_space, buf, len)) > 0)
+                        return ((ssize_t)n);
+
+                data->ring->rwait = 1;
+                __sync_synchronize ();
+
+                if ((n = shm_ring_read (data->ring, data->ev_space, buf, len)) > 0) {
+                        data->ring->rwait = 0;
+                        return ((ssize_t)n);
+                }
+
+                /*
+                 * The probe didn't attach the ring or it has already
+                 * closed it. Everything else comes over the socket.
+                 */
+                if (data->ring->closed) {
+                        data->ring->rwait = 0;
+                        return sch_pipe_recv (desc, buf, len, flags);
+                }
+
+                switch (shm_wait (data->ev_data, data->pipe.pfd, POLLIN, -1)) {
+                case 0:
+                        continue;
+                case 1:
+                        data->ring->rwait = 0;
+                        __sync_synchronize ();
+
+                        if ((n = shm_ring_read (data->ring, data->ev_space, buf, len)) > 0)
+                                return ((ssize_t)n);
+
+                        return sch_pipe_recv (desc, buf, len, flags);
+                default:
+                        return (-1);
+                }
+        }
+#endif
+        return (-1);
+}
+
+ssize_t sch_shm_send (SEAP_desc_t *desc, void *buf, size_t len, uint32_t flags)
+{
+        sch_shmdata_t *data;
+
+        assume_d (desc != NULL, -1, errno = EFAULT;);
+        assume_d (buf  != NULL, -1, errno = EFAULT;);
+
+        data = DATA(desc->scheme_data);
+
+        assume_r (data != NULL, -1, errno = EBADF;);
+
+        if (LIBSIDE(data))
+                return sch_pipe_send (desc, buf, len, flags);
+#if defined(SCH_SHM_SUPPORTED)
+        if (data->ring != NULL)
+                return shm_ring_write (data, buf, len);
+#endif
+        return write (data->ofd, buf, len);
+}
+
+ssize_t sch_shm_sendsexp (SEAP_desc_t *desc, SEXP_t *sexp, uint32_t flags)
+{
+        sch_shmdata_t *data;
+        strbuf_t *sb;
+        ssize_t   ret;
+
+        assume_d (desc != NULL, -1, errno = EFAULT;);
+        assume_d (sexp != NULL, -1, errno = EFAULT;);
+
+        data = DATA(desc->scheme_data);
+
+        assume_r (data != NULL, -1, errno = EBADF;);
+
+        if (LIBSIDE(data))
+                return sch_pipe_sendsexp (desc, sexp, flags);
+
+        sb = strbuf_new (SEAP_STRBUF_MAX);
+
+        if (SEXP_sbprintf_t (sexp, sb) != 0)
+                ret = -1;
+        else if (data->ring == NULL)
+                ret = strbuf_write (sb, data->ofd);
+        else {
+                char  *buf;
+                size_t len, off;
+
+                len = strbuf_length (sb);
+                buf = sm_alloc (len);
+                strbuf_copy (sb, buf, len);
+
+                for (off = 0, ret = 0; off < len; off += (size_t)ret) {
+                        if ((ret = sch_shm_send (desc, buf + off, len - off, flags)) < 0)
+                                break;
+                }
+
+                if (ret >= 0)
+                        ret = (ssize_t)len;
+
+                protect_errno {
+                        sm_free (buf);
+                }
+        }
+
+        protect_errno {
+                strbuf_free (sb);
+        }
+
+        return (ret);
+}
+
+int sch_shm_close (SEAP_desc_t *desc, uint32_t flags)
+{
+        sch_shmdata_t *data;
+
+        assume_d (desc != NULL, -1, errno = EFAULT;);
+
+        data = DATA(desc->scheme_data);
+
+        assume_r (data != NULL, -1, errno = EBADF;);
+
+        shm_ring_close (data);
+
+        if (LIBSIDE(data))
+                return sch_pipe_close (desc, flags);
+
+        if (data->ifd != -1)
+                close (data->ifd);
+        if (data->ofd != -1 && data->ofd != data->ifd)
+                close (data->ofd);
+
+        sm_free (data);
+        desc->scheme_data = NULL;
+
+        return (0);
+}
+
+int sch_shm_select (SEAP_desc_t *desc, int ev, uint16_t timeout, uint32_t flags)
+{
+        sch_shmdata_t *data;
+        struct pollfd  pfd;
+
+        assume_d (desc != NULL, -1, errno = EFAULT;);
+
+        data = DATA(desc->scheme_data);
+
+        assume_r (data != NULL, -1, errno = EBADF;);
+
+        if (LIBSIDE(data)) {
+                if (ev != SEAP_IO_EVREAD || data->ring == NULL)
+                        return sch_pipe_select (desc, ev, timeout, flags);
+#if defined(SCH_SHM_SUPPORTED)
+                if (data->ring->head != data->ring->tail)
+                        return (0);
+
+                data->ring->rwait = 1;
+                __sync_synchronize ();
+
+                if (data->ring->head != data->ring->tail || data->ring->closed) {
+                        data->ring->rwait = 0;
+                        return (data->ring->closed ? sch_pipe_select (desc, ev, timeout, flags) : 0);
+                }
+
+                return (shm_wait (data->ev_data, data->pipe.pfd, POLLIN,
+                                  timeout > 0 ? (int)timeout * 1000 : -1) < 0 ? -1 : 0);
+#endif
+        }
+
+        switch (ev) {
+        case SEAP_IO_EVREAD:
+                pfd.fd = data->ifd;
+                pfd.events = POLLIN;
+                break;
+        case SEAP_IO_EVWRITE:
+                if (data->ring != NULL)
+                        return (0);
+
+                pfd.fd = data->ofd;
+                pfd.events = POLLOUT;
+                break;
+        default:
+                abort ();
+        }
+
+        for (;;) {
+                switch (poll (&pfd, 1, timeout > 0 ? (int)timeout * 1000 : -1)) {
+                case -1:
+                        if (errno == EINTR)
+                                continue;
+
+                        protect_errno {
+                                dI("FAIL: errno=%u, %s.", errno, strerror (errno));
+                        }
+                        return (-1);
+                case  0:
+                        errno = ETIMEDOUT;
+                        return (-1);
+                default:
+                        return (0);
+                }
+        }
+}
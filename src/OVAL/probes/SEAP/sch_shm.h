@@ -0,0 +1,78 @@
+/*
+ * Copyright 2009 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#pragma once
+#ifndef SCH_SHM_H
+#define SCH_SHM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include "sch_pipe.h"
+#include "../../../common/util.h"
+
+/*
+ * Shared memory scheme
+ *
+ * The probe is executed the same way as with the pipe scheme and the
+ * requests are sent to it over the socket. The data sent by the probe
+ * go through a ring buffer in a shared memory object (memfd) instead.
+ * Two eventfds signal "data available" and "space available" if the
+ * other side is waiting. The descriptors are passed to the probe in
+ * the SEAP_SHM_ENV environment variable.
+ *
+ * If the shared memory can't be set up on either side, the scheme
+ * falls back to the socket, i.e. it behaves like the pipe scheme.
+ */
+#define SEAP_SHM_ENV      "OSCAP_SEAP_SHM"
+#define SCH_SHM_MAGIC     0x5345534d /* "SESM" */
+#define SCH_SHM_RINGSIZE  (8*1024*1024)
+
+typedef struct {
+        uint32_t magic;
+        uint32_t size;             /* size of the data area, a power of 2 */
+        volatile uint64_t head;    /* written bytes */
+        volatile uint64_t tail;    /* consumed bytes */
+        volatile uint32_t rwait;   /* the reader waits for data */
+        volatile uint32_t wwait;   /* the writer waits for space */
+        volatile uint32_t closed;  /* the writer is gone */
+        uint8_t  data[] __attribute__ ((aligned (64)));
+} sch_shmring_t;
+
+typedef struct {
+        sch_pipedata_t pipe;      /* library side; must be the first member */
+        int            ifd;       /* probe side */
+        int            ofd;
+        sch_shmring_t *ring;      /* NULL if not available */
+        size_t         ring_mapsize;
+        int            ev_data;
+        int            ev_space;
+} sch_shmdata_t;
+
+int sch_shm_connect (SEAP_desc_t *desc, const char *uri, uint32_t flags);
+int sch_shm_openfd (SEAP_desc_t *desc, int fd, uint32_t flags);
+int sch_shm_openfd2 (SEAP_desc_t *desc, int ifd, int ofd, uint32_t flags);
+ssize_t sch_shm_recv (SEAP_desc_t *desc, void *buf, size_t len, uint32_t flags);
+ssize_t sch_shm_send (SEAP_desc_t *desc, void *buf, size_t len, uint32_t flags);
+ssize_t sch_shm_sendsexp (SEAP_desc_t *desc, SEXP_t *sexp, uint32_t flags);
+int sch_shm_close (SEAP_desc_t *desc, uint32_t flags);
+int sch_shm_select (SEAP_desc_t *desc, int ev, uint16_t timeout, uint32_t flags);
+
+
+#endif /* SCH_SHM_H */
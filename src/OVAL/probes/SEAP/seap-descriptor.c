@@ -79,6 +79,11 @@ int SEAP_desc_add (SEAP_desctable_t *sd_table, SEXP_pstate_t *pstate,
 
 		SEAP_packetq_init(&sd_dsc->pck_queue);
 
+                sd_dsc->ofmt      = SEAP_DESC_FMT_TEXT;
+                sd_dsc->ibin      = NULL;
+                sd_dsc->ibin_len  = 0;
+                sd_dsc->ibin_size = 0;
+
                 pthread_mutexattr_init (&mutex_attr);
                 pthread_mutexattr_settype (&mutex_attr, PTHREAD_MUTEX_RECURSIVE);
 
@@ -134,6 +139,10 @@ void SEAP_desc_free(SEAP_desc_t *dsc)
         pthread_mutex_destroy(&(dsc->r_lock));
         pthread_mutex_destroy(&(dsc->w_lock));
 	rbt_i32_free_cb(dsc->err_queue, __SEAP_desc_errqueue_free_cb);
+
+        if (dsc->ibin != NULL)
+                sm_free(dsc->ibin);
+
         sm_free(dsc);
 }
 
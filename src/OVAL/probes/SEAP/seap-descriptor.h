@@ -63,8 +63,24 @@ typedef struct {
         SEAP_cmdid_t   next_cid;
         SEAP_cmdtbl_t *cmd_c_table; /* Local SEAP commands */
         SEAP_cmdtbl_t *cmd_w_table; /* Waiting SEAP commands */
+
+        uint8_t  ofmt;      /* Output format (SEAP_DESC_FMT_*) */
+        uint8_t *ibin;      /* Incomplete binary frame data */
+        size_t   ibin_len;
+        size_t   ibin_size;
 } SEAP_desc_t;
 
+#define SEAP_DESC_FMT_TEXT   0
+#define SEAP_DESC_FMT_BINARY 1
+
+/*
+ * The library sets this variable in the environment of the probes
+ * it executes (unless already set) to announce that it is able to
+ * receive binary frames. Set it to "text" to debug the protocol.
+ */
+#define SEAP_FORMAT_ENV    "OSCAP_SEAP_FORMAT"
+#define SEAP_FORMAT_BINARY "binary"
+
 #define SEAP_DESC_FDIN  0x00000001
 #define SEAP_DESC_FDOUT 0x00000002
 #define SEAP_DESC_SELF  -1
@@ -31,6 +31,7 @@
 #include "generic/common.h"
 #include "public/sexp-manip.h"
 #include "_sexp-parser.h"
+#include "_sexp-binary.h"
 #include "_seap-packetq.h"
 #include "_seap-packet.h"
 #include "_seap-scheme.h"
@@ -589,6 +590,109 @@ static SEXP_t *SEAP_packet2sexp (SEAP_packet_t *packet)
         return (sexp);
 }
 
+/*
+ * Decode all complete binary frames from the received data.
+ * Data of an incomplete frame are kept in the descriptor until
+ * the rest of the frame is received. The data buffer is freed.
+ */
+static SEXP_t *SEAP_packet_unframe (SEAP_desc_t *dsc, void *data, size_t length)
+{
+        SEXP_t  *sexp_buffer, *sexp_packet;
+        uint8_t *buf;
+        size_t   len, off;
+        ssize_t  ret;
+
+        if (dsc->ibin_len > 0) {
+                if (dsc->ibin_len + length > dsc->ibin_size) {
+                        dsc->ibin_size = dsc->ibin_size * 2 > dsc->ibin_len + length ?
+                                dsc->ibin_size * 2 : dsc->ibin_len + length;
+                        dsc->ibin = sm_realloc (dsc->ibin, dsc->ibin_size);
+                }
+
+                memcpy (dsc->ibin + dsc->ibin_len, data, length);
+                dsc->ibin_len += length;
+                sm_free (data);
+
+                buf = dsc->ibin;
+                len = dsc->ibin_len;
+        } else {
+                buf = data;
+                len = length;
+        }
+
+        sexp_buffer = SEXP_list_new (NULL);
+        off = 0;
+
+        while ((ret = SEXP_bin_unframe (buf + off, len - off, &sexp_packet)) > 0) {
+                SEXP_list_add (sexp_buffer, sexp_packet);
+                SEXP_free (sexp_packet);
+                off += (size_t)ret;
+        }
+
+        if (ret < 0) {
+                protect_errno {
+                        dI("FAIL: binary frame decoding error: offset=%zu, length=%zu", off, len);
+                        SEXP_free (sexp_buffer);
+                        sm_free (buf);
+
+                        dsc->ibin      = NULL;
+                        dsc->ibin_len  = 0;
+                        dsc->ibin_size = 0;
+                }
+                return (NULL);
+        }
+
+        if (off == len) {
+                sm_free (buf);
+
+                dsc->ibin      = NULL;
+                dsc->ibin_len  = 0;
+                dsc->ibin_size = 0;
+        } else {
+                if (off > 0)
+                        memmove (buf, buf + off, len - off);
+
+                if (buf != dsc->ibin) {
+                        dsc->ibin      = buf;
+                        dsc->ibin_size = length;
+                }
+
+                dsc->ibin_len = len - off;
+        }
+
+        return (sexp_buffer);
+}
+
+static ssize_t SEAP_packet_sendbin (SEAP_desc_t *dsc, SEXP_t *sexp)
+{
+        uint8_t *frame;
+        size_t   size, off;
+        ssize_t  ret;
+
+        if (SEXP_bin_frame (sexp, &frame, &size) != 0)
+                return (-1);
+
+        for (off = 0; off < size; off += (size_t)ret) {
+                ret = SCH_SEND(dsc->scheme, dsc, frame + off, size - off, 0);
+
+                if (ret < 0) {
+                        if (errno == EINTR) {
+                                ret = 0;
+                                continue;
+                        }
+
+                        protect_errno {
+                                sm_free (frame);
+                        }
+                        return (-1);
+                }
+        }
+
+        sm_free (frame);
+
+        return ((ssize_t)size);
+}
+
 int SEAP_packet_recv (SEAP_CTX_t *ctx, int sd, SEAP_packet_t **packet)
 {
         SEAP_desc_t *dsc;
@@ -701,7 +805,7 @@ eloop_exit:
                         sm_free (data_buffer);
                         SEXP_psetup_free (psetup);
 
-                        if (pstate != NULL) {
+                        if (pstate != NULL || dsc->ibin_len > 0) {
                                 dI("FAIL: incomplete S-exp received");
                                 errno = ENETRESET;
                                 return (-1);
@@ -718,9 +822,31 @@ eloop_exit:
 			data_buflen = data_length;
 		}
 
-                sexp_buffer = SEXP_parse (psetup, data_buffer, data_length, &pstate);
+                /*
+                 * Binary frames start with a byte that can't start
+                 * a textual S-exp. The format can't change in the
+                 * middle of an expression.
+                 */
+                if (pstate == NULL &&
+                    (dsc->ibin_len > 0 || *(uint8_t *)data_buffer == SEXP_BIN_MAGIC))
+                {
+                        sexp_buffer = SEAP_packet_unframe (dsc, data_buffer, (size_t)data_length);
+
+                        if (sexp_buffer == NULL) {
+                                DESC_RUNLOCK(dsc);
+                                SEXP_psetup_free (psetup);
+                                errno = EILSEQ;
+                                return (-1);
+                        }
 
-                if (sexp_buffer != NULL) {
+                        if (SEXP_list_length (sexp_buffer) > 0) {
+                                DESC_RUNLOCK(dsc);
+                                break;
+                        }
+
+                        SEXP_free (sexp_buffer);
+                        sexp_buffer = NULL;
+                } else if ((sexp_buffer = SEXP_parse (psetup, data_buffer, data_length, &pstate)) != NULL) {
                         _A(pstate == NULL);
 
                         DESC_RUNLOCK(dsc);
@@ -972,9 +1098,16 @@ int SEAP_packet_send (SEAP_CTX_t *ctx, int sd, SEAP_packet_t *packet)
         }
 
         if (DESC_WLOCK (dsc)) {
+                ssize_t sent;
+
                 ret = 0;
 
-                if (SCH_SENDSEXP(dsc->scheme, dsc, packet_sexp, 0) < 0) {
+                if (dsc->ofmt == SEAP_DESC_FMT_BINARY)
+                        sent = SEAP_packet_sendbin (dsc, packet_sexp);
+                else
+                        sent = SCH_SENDSEXP(dsc->scheme, dsc, packet_sexp, 0);
+
+                if (sent < 0) {
                         ret = -1;
 
                         protect_errno {
@@ -118,6 +118,7 @@ int SEAP_packetq_put(SEAP_packetq_t *queue, SEAP_packet_t *packet)
 		queue->last->next = SEAP_packetq_item_new();
 		queue->last->next->packet = packet;
 		queue->last->next->prev   = queue->last;
+		queue->last = queue->last->next;
 	}
 
 	count = ++queue->count;
@@ -51,7 +51,12 @@ const SEAP_schemefn_t __schtbl[] = {
           sch_pipe_connect, sch_pipe_openfd,
           sch_pipe_openfd2, sch_pipe_recv,
           sch_pipe_send, sch_pipe_close,
-          sch_pipe_sendsexp, sch_pipe_select }
+          sch_pipe_sendsexp, sch_pipe_select },
+        { "shm",     /* Like pipe, the probe replies through shared memory */
+          sch_shm_connect, sch_shm_openfd,
+          sch_shm_openfd2, sch_shm_recv,
+          sch_shm_send, sch_shm_close,
+          sch_shm_sendsexp, sch_shm_select }
 };
 
 #define SCHTBLSIZE ((sizeof __schtbl)/sizeof (SEAP_schemefn_t))
@@ -152,9 +152,13 @@ int SEAP_openfd (SEAP_CTX_t *ctx, int fd, uint32_t flags)
 int SEAP_openfd2 (SEAP_CTX_t *ctx, int ifd, int ofd, uint32_t flags)
 {
         SEAP_desc_t *dsc;
+        const char  *fmt;
+        SEAP_scheme_t scheme;
         int sd;
 
-        sd = SEAP_desc_add (ctx->sd_table, NULL, SCH_GENERIC, NULL);
+        /* The library asked for the shared memory scheme */
+        scheme = getenv (SEAP_SHM_ENV) != NULL ? SCH_SHM : SCH_GENERIC;
+        sd = SEAP_desc_add (ctx->sd_table, NULL, scheme, NULL);
 
         if (sd < 0) {
                 dI("Can't create/add new SEAP descriptor");
@@ -168,11 +172,16 @@ int SEAP_openfd2 (SEAP_CTX_t *ctx, int ifd, int ofd, uint32_t flags)
                 return(-1);
         }
 
-        if (SCH_OPENFD2(SCH_GENERIC, dsc, ifd, ofd, flags) != 0) {
+        if (SCH_OPENFD2(scheme, dsc, ifd, ofd, flags) != 0) {
                 dI("FAIL: errno=%u, %s.", errno, strerror (errno));
                 return (-1);
         }
 
+        fmt = getenv (SEAP_FORMAT_ENV);
+
+        if (fmt != NULL && strcmp (fmt, SEAP_FORMAT_BINARY) == 0)
+                dsc->ofmt = SEAP_DESC_FMT_BINARY;
+
         return (sd);
 }
 
@@ -0,0 +1,659 @@
+/*
+ * Copyright 2009 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+
+#include "generic/common.h"
+#include "public/sm_alloc.h"
+#include "public/sexp-manip.h"
+#include "_sexp-types.h"
+#include "_sexp-value.h"
+#include "_sexp-datatype.h"
+#include "_sexp-rawptr.h"
+#include "_sexp-binary.h"
+#include "MurmurHash3.h"
+
+#define SEXP_BIN_TAG_LIST   'L'
+#define SEXP_BIN_TAG_STRING 'S'
+#define SEXP_BIN_TAG_STRDEF 'D'
+#define SEXP_BIN_TAG_STRREF 'R'
+#define SEXP_BIN_TAG_NUMBER 'N'
+#define SEXP_BIN_TAG_DTDEF  'y'
+#define SEXP_BIN_TAG_DTREF  'Y'
+
+#define SEXP_BIN_INITSIZE 4096
+#define SEXP_BIN_MAXDEPTH 512
+#define SEXP_BIN_MAXLEN   UINT32_MAX
+
+/*
+ * Encoder
+ */
+struct bin_str {
+        const char *str;
+        size_t      len;
+};
+
+struct bin_enc {
+        uint8_t *data;
+        size_t   size;
+        size_t   used;
+
+        struct bin_str *strtbl; /* string table entries */
+        size_t          strcnt;
+        uint32_t       *strmap; /* hash -> strtbl index + 1 */
+        size_t          strmap_size;
+
+        SEXP_datatypePtr_t **dttbl; /* datatype table entries */
+        size_t               dtcnt;
+};
+
+static void bin_reserve(struct bin_enc *enc, size_t len)
+{
+        if (enc->used + len > enc->size) {
+                do {
+                        enc->size <<= 1;
+                } while (enc->used + len > enc->size);
+
+                enc->data = sm_realloc(enc->data, enc->size);
+        }
+}
+
+static inline void bin_put8(struct bin_enc *enc, uint8_t b)
+{
+        bin_reserve(enc, 1);
+        enc->data[enc->used++] = b;
+}
+
+static inline void bin_putv(struct bin_enc *enc, uint64_t v)
+{
+        bin_reserve(enc, 10);
+
+        while (v >= 0x80) {
+                enc->data[enc->used++] = (uint8_t)(v | 0x80);
+                v >>= 7;
+        }
+
+        enc->data[enc->used++] = (uint8_t)v;
+}
+
+static inline void bin_puts(struct bin_enc *enc, const void *str, size_t len)
+{
+        bin_putv(enc, len);
+        bin_reserve(enc, len);
+        memcpy(enc->data + enc->used, str, len);
+        enc->used += len;
+}
+
+static inline uint64_t bin_zigzag(int64_t v)
+{
+        return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static void bin_strmap_grow(struct bin_enc *enc)
+{
+        size_t i, s;
+        uint32_t h;
+
+        enc->strmap_size = enc->strmap_size == 0 ? 128 : enc->strmap_size << 1;
+        enc->strmap = sm_reallocf(enc->strmap, sizeof(uint32_t) * enc->strmap_size);
+        memset(enc->strmap, 0, sizeof(uint32_t) * enc->strmap_size);
+
+        for (i = 0; i < enc->strcnt; ++i) {
+                MurmurHash3_x86_32(enc->strtbl[i].str, (int)enc->strtbl[i].len, 0, &h);
+
+                for (s = h & (enc->strmap_size - 1); enc->strmap[s] != 0; s = (s + 1) & (enc->strmap_size - 1));
+
+                enc->strmap[s] = (uint32_t)(i + 1);
+        }
+}
+
+static void bin_encode_str(struct bin_enc *enc, const char *str, size_t len)
+{
+        size_t   s;
+        uint32_t h;
+
+        if (len > SEXP_BIN_STRTBL_STRMAX) {
+                bin_put8(enc, SEXP_BIN_TAG_STRING);
+                bin_puts(enc, str, len);
+                return;
+        }
+
+        if (enc->strmap_size == 0)
+                bin_strmap_grow(enc);
+
+        MurmurHash3_x86_32(str, (int)len, 0, &h);
+
+        for (s = h & (enc->strmap_size - 1); enc->strmap[s] != 0; s = (s + 1) & (enc->strmap_size - 1)) {
+                struct bin_str *e = enc->strtbl + (enc->strmap[s] - 1);
+
+                if (e->len == len && memcmp(e->str, str, len) == 0) {
+                        bin_put8(enc, SEXP_BIN_TAG_STRREF);
+                        bin_putv(enc, enc->strmap[s] - 1);
+                        return;
+                }
+        }
+
+        if (enc->strcnt >= SEXP_BIN_STRTBL_MAX) {
+                bin_put8(enc, SEXP_BIN_TAG_STRING);
+                bin_puts(enc, str, len);
+                return;
+        }
+
+        /*
+         * The strings are owned by the S-exp being encoded,
+         * so only the pointers are stored in the table.
+         */
+        enc->strtbl = sm_realloc(enc->strtbl, sizeof(struct bin_str) * (enc->strcnt + 1));
+        enc->strtbl[enc->strcnt].str = str;
+        enc->strtbl[enc->strcnt].len = len;
+        enc->strmap[s] = (uint32_t)(++enc->strcnt);
+
+        if (enc->strcnt * 2 > enc->strmap_size)
+                bin_strmap_grow(enc);
+
+        bin_put8(enc, SEXP_BIN_TAG_STRDEF);
+        bin_puts(enc, str, len);
+}
+
+static void bin_encode_dt(struct bin_enc *enc, SEXP_datatypePtr_t *dt)
+{
+        const char *name;
+        size_t i;
+
+        for (i = 0; i < enc->dtcnt; ++i) {
+                if (enc->dttbl[i] == dt) {
+                        bin_put8(enc, SEXP_BIN_TAG_DTREF);
+                        bin_putv(enc, i);
+                        return;
+                }
+        }
+
+        enc->dttbl = sm_realloc(enc->dttbl, sizeof(SEXP_datatypePtr_t *) * (enc->dtcnt + 1));
+        enc->dttbl[enc->dtcnt++] = dt;
+
+        name = SEXP_datatype_name(dt);
+
+        bin_put8(enc, SEXP_BIN_TAG_DTDEF);
+        bin_puts(enc, name, strlen(name));
+}
+
+static int bin_encode(SEXP_t *s_exp, void *arg)
+{
+        struct bin_enc *enc = (struct bin_enc *)arg;
+        SEXP_datatypePtr_t *dt;
+        SEXP_val_t v_dsc;
+
+        dt = SEXP_rawptr_mask(s_exp->s_type, SEXP_DATATYPEPTR_MASK);
+
+        if (dt != NULL)
+                bin_encode_dt(enc, dt);
+
+        SEXP_val_dsc(&v_dsc, s_exp->s_valp);
+
+        switch (v_dsc.type) {
+        case SEXP_VALTYPE_NUMBER:
+        {
+                SEXP_numtype_t t;
+
+                t = SEXP_NTYPEP(v_dsc.hdr->size, v_dsc.mem);
+
+                bin_put8(enc, SEXP_BIN_TAG_NUMBER);
+                bin_put8(enc, t);
+
+                switch (t) {
+                case SEXP_NUM_BOOL:
+                        bin_put8(enc, SEXP_NCASTP(b, v_dsc.mem)->n ? 1 : 0);
+                        break;
+                case SEXP_NUM_INT8:
+                        bin_putv(enc, bin_zigzag(SEXP_NCASTP(i8, v_dsc.mem)->n));
+                        break;
+                case SEXP_NUM_UINT8:
+                        bin_putv(enc, SEXP_NCASTP(u8, v_dsc.mem)->n);
+                        break;
+                case SEXP_NUM_INT16:
+                        bin_putv(enc, bin_zigzag(SEXP_NCASTP(i16, v_dsc.mem)->n));
+                        break;
+                case SEXP_NUM_UINT16:
+                        bin_putv(enc, SEXP_NCASTP(u16, v_dsc.mem)->n);
+                        break;
+                case SEXP_NUM_INT32:
+                        bin_putv(enc, bin_zigzag(SEXP_NCASTP(i32, v_dsc.mem)->n));
+                        break;
+                case SEXP_NUM_UINT32:
+                        bin_putv(enc, SEXP_NCASTP(u32, v_dsc.mem)->n);
+                        break;
+                case SEXP_NUM_INT64:
+                        bin_putv(enc, bin_zigzag(SEXP_NCASTP(i64, v_dsc.mem)->n));
+                        break;
+                case SEXP_NUM_UINT64:
+                        bin_putv(enc, SEXP_NCASTP(u64, v_dsc.mem)->n);
+                        break;
+                case SEXP_NUM_DOUBLE:
+                        /* Both ends run on the same host, the byte order is native */
+                        bin_reserve(enc, sizeof(double));
+                        memcpy(enc->data + enc->used, &SEXP_NCASTP(f, v_dsc.mem)->n, sizeof(double));
+                        enc->used += sizeof(double);
+                        break;
+                default:
+                        errno = EINVAL;
+                        return (-1);
+                }
+                break;
+        }
+        case SEXP_VALTYPE_STRING:
+                bin_encode_str(enc, (const char *)v_dsc.mem, v_dsc.hdr->size / sizeof(char));
+                break;
+        case SEXP_VALTYPE_LIST:
+                bin_put8(enc, SEXP_BIN_TAG_LIST);
+                bin_putv(enc, SEXP_rawval_list_length(SEXP_LCASTP(v_dsc.mem)));
+
+                if (SEXP_rawval_lblk_cb((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, bin_encode, enc,
+                                        SEXP_LCASTP(v_dsc.mem)->offset + 1) != 0)
+                        return (-1);
+                break;
+        default:
+                errno = EINVAL;
+                return (-1);
+        }
+
+        return (0);
+}
+
+int SEXP_bin_frame(const SEXP_t *s_exp, uint8_t **frame, size_t *size)
+{
+        struct bin_enc enc;
+        size_t plen;
+        int ret;
+
+        if (s_exp == NULL || frame == NULL || size == NULL) {
+                errno = EFAULT;
+                return (-1);
+        }
+
+        SEXP_VALIDATE(s_exp);
+
+        memset(&enc, 0, sizeof enc);
+        enc.size = SEXP_BIN_INITSIZE;
+        enc.data = sm_alloc(enc.size);
+        enc.used = SEXP_BIN_HDRSIZE;
+
+        ret = bin_encode((SEXP_t *)s_exp, &enc);
+
+        sm_free(enc.strtbl);
+        sm_free(enc.strmap);
+        sm_free(enc.dttbl);
+
+        plen = enc.used - SEXP_BIN_HDRSIZE;
+
+        if (ret == 0 && plen > SEXP_BIN_MAXLEN) {
+                errno = EFBIG;
+                ret = -1;
+        }
+
+        if (ret != 0) {
+                sm_free(enc.data);
+                return (-1);
+        }
+
+        enc.data[0] = SEXP_BIN_MAGIC;
+        enc.data[1] = (uint8_t)(plen);
+        enc.data[2] = (uint8_t)(plen >> 8);
+        enc.data[3] = (uint8_t)(plen >> 16);
+        enc.data[4] = (uint8_t)(plen >> 24);
+
+        *frame = enc.data;
+        *size  = enc.used;
+
+        return (0);
+}
+
+/*
+ * Decoder
+ */
+struct bin_dec {
+        const uint8_t *ptr;
+        const uint8_t *end;
+
+        SEXP_t **strtbl;
+        size_t   strcnt;
+
+        SEXP_datatypePtr_t **dttbl;
+        size_t               dtcnt;
+};
+
+static int bin_getv(struct bin_dec *dec, uint64_t *v)
+{
+        uint64_t r = 0;
+        unsigned int s;
+
+        for (s = 0; s < 64 && dec->ptr < dec->end; s += 7) {
+                uint8_t b = *dec->ptr++;
+
+                r |= (uint64_t)(b & 0x7f) << s;
+
+                if ((b & 0x80) == 0) {
+                        *v = r;
+                        return (0);
+                }
+        }
+
+        return (-1);
+}
+
+static int bin_getlen(struct bin_dec *dec, size_t *len)
+{
+        uint64_t v;
+
+        if (bin_getv(dec, &v) != 0 || v > (uint64_t)(dec->end - dec->ptr))
+                return (-1);
+
+        *len = (size_t)v;
+        return (0);
+}
+
+static inline int64_t bin_unzigzag(uint64_t v)
+{
+        return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+/*
+ * Numbers are typed the same way as the textual parser types them,
+ * i.e. the smallest type that can hold the value is used. Otherwise
+ * the results would depend on the transport format.
+ */
+static SEXP_t *bin_number_u(uint64_t n)
+{
+        if (n > UINT16_MAX) {
+                if (n > UINT32_MAX)
+                        return SEXP_number_newu_64(n);
+                else
+                        return SEXP_number_newu_32((uint32_t)n);
+        } else {
+                if (n > UINT8_MAX)
+                        return SEXP_number_newu_16((uint16_t)n);
+                else
+                        return SEXP_number_newu_8((uint8_t)n);
+        }
+}
+
+static SEXP_t *bin_number_i(int64_t n)
+{
+        if (n >= 0)
+                return bin_number_u((uint64_t)n);
+
+        if (n < INT16_MIN) {
+                if (n < INT32_MIN)
+                        return SEXP_number_newi_64(n);
+                else
+                        return SEXP_number_newi_32((int32_t)n);
+        } else {
+                if (n < INT8_MIN)
+                        return SEXP_number_newi_16((int16_t)n);
+                else
+                        return SEXP_number_newi_8((int8_t)n);
+        }
+}
+
+static SEXP_t *bin_number_f(double f)
+{
+        char buffer[66+1];
+
+        /*
+         * The textual format uses "%g", which rounds the value and
+         * turns integral values into integers.
+         */
+        snprintf(buffer, sizeof buffer, "%g", f);
+
+        if (strpbrk(buffer, ".eEin") != NULL)
+                return SEXP_number_newf(strtod(buffer, NULL));
+        else if (buffer[0] == '-') {
+                int64_t n = strtoll(buffer, NULL, 10);
+                return n == 0 ? SEXP_number_newi_8(0) : bin_number_i(n);
+        } else
+                return bin_number_u(strtoull(buffer, NULL, 10));
+}
+
+static SEXP_t *bin_decode_num(struct bin_dec *dec)
+{
+        SEXP_numtype_t t;
+        uint64_t v;
+
+        if (dec->ptr >= dec->end)
+                return (NULL);
+
+        t = *dec->ptr++;
+
+        switch (t) {
+        case SEXP_NUM_BOOL:
+                if (dec->ptr >= dec->end)
+                        return (NULL);
+                return SEXP_number_newb(*dec->ptr++ != 0);
+        case SEXP_NUM_DOUBLE:
+        {
+                double f;
+
+                if ((size_t)(dec->end - dec->ptr) < sizeof f)
+                        return (NULL);
+
+                memcpy(&f, dec->ptr, sizeof f);
+                dec->ptr += sizeof f;
+
+                return bin_number_f(f);
+        }
+        }
+
+        if (bin_getv(dec, &v) != 0)
+                return (NULL);
+
+        switch (t) {
+        case SEXP_NUM_INT8:
+        case SEXP_NUM_INT16:
+        case SEXP_NUM_INT32:
+        case SEXP_NUM_INT64:
+                return bin_number_i(bin_unzigzag(v));
+        case SEXP_NUM_UINT8:
+        case SEXP_NUM_UINT16:
+        case SEXP_NUM_UINT32:
+        case SEXP_NUM_UINT64:
+                return bin_number_u(v);
+        }
+
+        return (NULL);
+}
+
+static SEXP_datatypePtr_t *bin_decode_dtdef(struct bin_dec *dec)
+{
+        SEXP_datatypePtr_t *dt;
+        char  *name, name_static[128];
+        size_t len;
+
+        if (bin_getlen(dec, &len) != 0)
+                return (NULL);
+
+        name = len < sizeof name_static ? name_static : sm_alloc(len + 1);
+        memcpy(name, dec->ptr, len);
+        name[len] = '\0';
+        dec->ptr += len;
+
+        dt = SEXP_datatype_get(&g_datatypes, name);
+
+        if (dt == NULL) {
+                if (name == name_static)
+                        name = strdup(name);
+
+                dt = SEXP_datatype_add(&g_datatypes, name, NULL, NULL);
+
+                if (dt == NULL) {
+                        sm_free(name);
+                        return (NULL);
+                }
+        } else if (name != name_static)
+                sm_free(name);
+
+        dec->dttbl = sm_realloc(dec->dttbl, sizeof(SEXP_datatypePtr_t *) * (dec->dtcnt + 1));
+        dec->dttbl[dec->dtcnt++] = dt;
+
+        return (dt);
+}
+
+static SEXP_t *bin_decode(struct bin_dec *dec, unsigned int depth)
+{
+        SEXP_datatypePtr_t *dt = NULL;
+        SEXP_t  *s_exp = NULL;
+        uint64_t v;
+        size_t   len;
+
+        if (depth > SEXP_BIN_MAXDEPTH || dec->ptr >= dec->end)
+                return (NULL);
+
+        switch (*dec->ptr) {
+        case SEXP_BIN_TAG_DTDEF:
+                ++dec->ptr;
+
+                if ((dt = bin_decode_dtdef(dec)) == NULL)
+                        return (NULL);
+                break;
+        case SEXP_BIN_TAG_DTREF:
+                ++dec->ptr;
+
+                if (bin_getv(dec, &v) != 0 || v >= dec->dtcnt)
+                        return (NULL);
+
+                dt = dec->dttbl[v];
+                break;
+        }
+
+        if (dec->ptr >= dec->end)
+                return (NULL);
+
+        switch (*dec->ptr++) {
+        case SEXP_BIN_TAG_LIST:
+        {
+                SEXP_t *memb;
+
+                if (bin_getv(dec, &v) != 0 || v > (uint64_t)(dec->end - dec->ptr))
+                        return (NULL);
+
+                s_exp = SEXP_list_new(NULL);
+
+                while (v-- > 0) {
+                        if ((memb = bin_decode(dec, depth + 1)) == NULL) {
+                                SEXP_free(s_exp);
+                                return (NULL);
+                        }
+
+                        SEXP_list_add(s_exp, memb);
+                        SEXP_free(memb);
+                }
+                break;
+        }
+        case SEXP_BIN_TAG_STRING:
+                if (bin_getlen(dec, &len) != 0)
+                        return (NULL);
+
+                s_exp = SEXP_string_new(dec->ptr, len);
+                dec->ptr += len;
+                break;
+        case SEXP_BIN_TAG_STRDEF:
+                if (bin_getlen(dec, &len) != 0)
+                        return (NULL);
+
+                s_exp = SEXP_string_new(dec->ptr, len);
+                dec->ptr += len;
+
+                /*
+                 * The table holds a reference to the value, references
+                 * to the same string in this frame share the value.
+                 */
+                dec->strtbl = sm_realloc(dec->strtbl, sizeof(SEXP_t *) * (dec->strcnt + 1));
+                dec->strtbl[dec->strcnt++] = SEXP_ref(s_exp);
+                break;
+        case SEXP_BIN_TAG_STRREF:
+                if (bin_getv(dec, &v) != 0 || v >= dec->strcnt)
+                        return (NULL);
+
+                s_exp = SEXP_ref(dec->strtbl[v]);
+                break;
+        case SEXP_BIN_TAG_NUMBER:
+                s_exp = bin_decode_num(dec);
+                break;
+        default:
+                return (NULL);
+        }
+
+        if (s_exp != NULL && dt != NULL)
+                s_exp->s_type = dt;
+
+        return (s_exp);
+}
+
+ssize_t SEXP_bin_unframe(const uint8_t *buf, size_t len, SEXP_t **s_exp)
+{
+        struct bin_dec dec;
+        SEXP_t *res;
+        size_t  plen, i;
+
+        if (buf == NULL || s_exp == NULL) {
+                errno = EFAULT;
+                return (-1);
+        }
+
+        if (len > 0 && buf[0] != SEXP_BIN_MAGIC) {
+                errno = EILSEQ;
+                return (-1);
+        }
+
+        if (len < SEXP_BIN_HDRSIZE)
+                return (0);
+
+        plen = (size_t)buf[1]        | (size_t)buf[2] << 8 |
+               (size_t)buf[3] << 16 | (size_t)buf[4] << 24;
+
+        if (len - SEXP_BIN_HDRSIZE < plen)
+                return (0);
+
+        memset(&dec, 0, sizeof dec);
+        dec.ptr = buf + SEXP_BIN_HDRSIZE;
+        dec.end = dec.ptr + plen;
+
+        res = bin_decode(&dec, 0);
+
+        for (i = 0; i < dec.strcnt; ++i)
+                SEXP_free(dec.strtbl[i]);
+
+        sm_free(dec.strtbl);
+        sm_free(dec.dttbl);
+
+        if (res == NULL || dec.ptr != dec.end) {
+                SEXP_free(res);
+                errno = EILSEQ;
+                return (-1);
+        }
+
+        *s_exp = res;
+
+        return ((ssize_t)(SEXP_BIN_HDRSIZE + plen));
+}
@@ -1293,12 +1293,17 @@ SEXP_t *SEXP_list_pop (SEXP_t *list)
         lblk = SEXP_VALP_LBLK(SEXP_LCASTP(v_dsc.mem)->b_addr);
 
         if (lblk != NULL) {
+                /*
+                 * The block is released when all of its members
+                 * were popped, the remaining members are still
+                 * referenced by the list.
+                 */
                 if (++SEXP_LCASTP(v_dsc.mem)->offset == lblk->real) {
                         SEXP_LCASTP(v_dsc.mem)->offset = 0;
                         SEXP_LCASTP(v_dsc.mem)->b_addr = SEXP_VALP_LBLK(lblk->nxsz);
-                }
 
-                SEXP_rawval_lblk_free1 ((uintptr_t)lblk, SEXP_free_lmemb);
+                        SEXP_rawval_lblk_free1 ((uintptr_t)lblk, SEXP_free_lmemb);
+                }
         }
 
 #if !defined(NDEBUG)
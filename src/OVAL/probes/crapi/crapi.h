@@ -25,11 +25,16 @@
 
 #define CRAPI_IO_BUFSZ 4096
 
+/* Read buffer of crapi_mdigest_fd() */
+#define CRAPI_MDIGEST_BUFSZ    (256*1024)
+#define CRAPI_MDIGEST_BUFALIGN 4096
+
 #ifndef _FILE_OFFSET_BITS
 # define _FILE_OFFSET_BITS 32
 #endif
 
 #include "digest.h"
+#include "dcache.h"
 
 int crapi_init (void *unused);
 
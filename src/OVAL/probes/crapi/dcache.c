@@ -0,0 +1,225 @@
+/*
+ * Copyright 2010 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "crapi.h"
+#include "dcache.h"
+
+struct dcache_entry {
+        dev_t    dev;
+        ino_t    ino;
+        off_t    size;
+        struct timespec mtime;
+        struct timespec ctime;
+        uint32_t algs;                      /* mask of the cached digests */
+        uint8_t  len[CRAPI_DIGEST_CNT];
+        uint8_t  dig[CRAPI_DIGEST_CNT][CRAPI_DCACHE_DIGMAX];
+        struct dcache_entry *hnext;         /* hash chain */
+        struct dcache_entry *lnext;         /* insertion order */
+};
+
+static struct {
+        pthread_mutex_t lock;
+        pthread_once_t  once;
+        bool            enabled;
+        struct dcache_entry *table[CRAPI_DCACHE_HSIZE];
+        struct dcache_entry *first, *last;
+        size_t          count;
+} dcache = {
+        .lock = PTHREAD_MUTEX_INITIALIZER,
+        .once = PTHREAD_ONCE_INIT
+};
+
+static void dcache_init (void)
+{
+        const char *env = getenv (CRAPI_DCACHE_ENV);
+
+        dcache.enabled = (env == NULL || strcmp (env, "0") != 0);
+}
+
+static inline unsigned int dcache_hash (dev_t dev, ino_t ino)
+{
+        return (unsigned int)(((uint64_t)dev * 31 + (uint64_t)ino) % CRAPI_DCACHE_HSIZE);
+}
+
+static inline int dcache_algidx (crapi_alg_t alg)
+{
+        return ffs ((int)alg) - 1;
+}
+
+static bool dcache_stat_eq (const struct dcache_entry *ent, const struct stat *st)
+{
+        return ent->size == st->st_size &&
+               ent->mtime.tv_sec  == st->st_mtim.tv_sec &&
+               ent->mtime.tv_nsec == st->st_mtim.tv_nsec &&
+               ent->ctime.tv_sec  == st->st_ctim.tv_sec &&
+               ent->ctime.tv_nsec == st->st_ctim.tv_nsec;
+}
+
+static void dcache_stat_set (struct dcache_entry *ent, const struct stat *st)
+{
+        ent->size  = st->st_size;
+        ent->mtime = st->st_mtim;
+        ent->ctime = st->st_ctim;
+        ent->algs  = 0;
+}
+
+/* The functions below have to be called with the cache lock held */
+
+static struct dcache_entry *dcache_lookup (const struct stat *st)
+{
+        struct dcache_entry *ent;
+
+        for (ent = dcache.table[dcache_hash (st->st_dev, st->st_ino)]; ent != NULL; ent = ent->hnext)
+                if (ent->dev == st->st_dev && ent->ino == st->st_ino)
+                        return (ent);
+
+        return (NULL);
+}
+
+static void dcache_evict_first (void)
+{
+        struct dcache_entry *ent = dcache.first, **ep;
+
+        ep = &dcache.table[dcache_hash (ent->dev, ent->ino)];
+
+        while (*ep != ent)
+                ep = &(*ep)->hnext;
+
+        *ep = ent->hnext;
+        dcache.first = ent->lnext;
+
+        if (dcache.first == NULL)
+                dcache.last = NULL;
+
+        --dcache.count;
+        free (ent);
+}
+
+static struct dcache_entry *dcache_insert (const struct stat *st)
+{
+        struct dcache_entry *ent;
+        unsigned int h;
+
+        if (dcache.count >= CRAPI_DCACHE_MAX)
+                dcache_evict_first ();
+
+        ent = calloc (1, sizeof (struct dcache_entry));
+        ent->dev = st->st_dev;
+        ent->ino = st->st_ino;
+        dcache_stat_set (ent, st);
+
+        h = dcache_hash (st->st_dev, st->st_ino);
+        ent->hnext = dcache.table[h];
+        dcache.table[h] = ent;
+
+        if (dcache.last != NULL)
+                dcache.last->lnext = ent;
+        else
+                dcache.first = ent;
+
+        dcache.last = ent;
+        ++dcache.count;
+
+        return (ent);
+}
+
+int crapi_mdigest_fd_cached (int fd, int num, const crapi_alg_t alg[], void *dst[], size_t *size[])
+{
+        struct stat st;
+        struct dcache_entry *ent;
+        crapi_alg_t m_alg[CRAPI_DIGEST_CNT];
+        void       *m_dst[CRAPI_DIGEST_CNT];
+        size_t     *m_size[CRAPI_DIGEST_CNT];
+        int i, idx, m_num = 0;
+
+        pthread_once (&dcache.once, dcache_init);
+
+        if (!dcache.enabled || num > CRAPI_DIGEST_CNT ||
+            fstat (fd, &st) != 0 || !S_ISREG (st.st_mode))
+                return crapi_mdigest_fdv (fd, num, alg, dst, size);
+
+        pthread_mutex_lock (&dcache.lock);
+
+        ent = dcache_lookup (&st);
+
+        if (ent != NULL && !dcache_stat_eq (ent, &st))
+                dcache_stat_set (ent, &st);
+
+        for (i = 0; i < num; ++i) {
+                idx = dcache_algidx (alg[i]);
+
+                if (ent != NULL && idx >= 0 && idx < CRAPI_DIGEST_CNT &&
+                    (ent->algs & alg[i]) && ent->len[idx] <= *size[i]) {
+                        memcpy (dst[i], ent->dig[idx], ent->len[idx]);
+                        *size[i] = ent->len[idx];
+                } else {
+                        m_alg[m_num]  = alg[i];
+                        m_dst[m_num]  = dst[i];
+                        m_size[m_num] = size[i];
+                        ++m_num;
+                }
+        }
+
+        pthread_mutex_unlock (&dcache.lock);
+
+        if (m_num == 0)
+                return (0);
+
+        if (crapi_mdigest_fdv (fd, m_num, m_alg, m_dst, m_size) != 0)
+                return (-1);
+
+        pthread_mutex_lock (&dcache.lock);
+
+        /* The entry might have been evicted in the meantime */
+        ent = dcache_lookup (&st);
+
+        if (ent == NULL)
+                ent = dcache_insert (&st);
+        else if (!dcache_stat_eq (ent, &st))
+                dcache_stat_set (ent, &st);
+
+        for (i = 0; i < m_num; ++i) {
+                idx = dcache_algidx (m_alg[i]);
+
+                if (idx < 0 || idx >= CRAPI_DIGEST_CNT ||
+                    *m_size[i] == 0 || *m_size[i] > CRAPI_DCACHE_DIGMAX)
+                        continue;
+
+                memcpy (ent->dig[idx], m_dst[i], *m_size[i]);
+                ent->len[idx] = (uint8_t)*m_size[i];
+                ent->algs |= m_alg[i];
+        }
+
+        pthread_mutex_unlock (&dcache.lock);
+
+        return (0);
+}
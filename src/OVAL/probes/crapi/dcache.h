@@ -0,0 +1,47 @@
+/*
+ * Copyright 2010 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#pragma once
+#ifndef CRAPI_DCACHE_H
+#define CRAPI_DCACHE_H
+
+#include <stddef.h>
+#include "digest.h"
+
+/*
+ * Digest cache
+ *
+ * Digests of regular files computed by crapi_mdigest_fd_cached() are
+ * remembered for the lifetime of the process (i.e. the scan in case of
+ * a probe). A file is identified by its device and inode numbers, the
+ * cached digests are used only if the size, mtime and ctime of the file
+ * haven't changed. Setting OSCAP_PROBE_DIGEST_CACHE=0 disables the cache.
+ */
+#define CRAPI_DCACHE_ENV    "OSCAP_PROBE_DIGEST_CACHE"
+#define CRAPI_DCACHE_MAX    16384 /* max. number of cached files */
+#define CRAPI_DCACHE_HSIZE  4099
+#define CRAPI_DCACHE_DIGMAX 64    /* max. digest length */
+
+/*
+ * Same as crapi_mdigest_fdv(), digests that are already known for the
+ * file are taken from the cache and only the missing ones are computed.
+ */
+int crapi_mdigest_fd_cached (int fd, int num, const crapi_alg_t alg[], void *dst[], size_t *size[]);
+
+#endif /* CRAPI_DCACHE_H */
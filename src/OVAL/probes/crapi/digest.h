@@ -55,4 +55,10 @@ struct digest_ctbl_t {
 
 int crapi_mdigest_fd (int fd, int num, ... /*crapi_alg_t alg, void *dst, size_t *size, ...*/);
 
+/*
+ * Same as crapi_mdigest_fd(), the digests are passed in arrays. The file
+ * is read only once, all digests are computed in the same pass.
+ */
+int crapi_mdigest_fdv (int fd, int num, const crapi_alg_t alg[], void *dst[], size_t *size[]);
+
 #endif /* CRAPI_DIGEST_H */
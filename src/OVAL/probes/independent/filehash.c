@@ -134,12 +134,14 @@ static int filehash_cb (const char *p, const char *f, probe_ctx *ctx, oval_schem
                 size_t  sha1_dstlen = sizeof sha1_dst;
                 char    sha1_str[(sizeof sha1_dst * 2) + 1];
 
+                crapi_alg_t alg[2]  = { CRAPI_DIGEST_MD5, CRAPI_DIGEST_SHA1 };
+                void       *dst[2]  = { md5_dst, sha1_dst };
+                size_t     *size[2] = { &md5_dstlen, &sha1_dstlen };
+
                 /*
                  * Compute hash values
                  */
-                if (crapi_mdigest_fd (fd, 2,
-                                      CRAPI_DIGEST_MD5,  md5_dst,  &md5_dstlen,
-                                      CRAPI_DIGEST_SHA1, sha1_dst, &sha1_dstlen) != 0)
+                if (crapi_mdigest_fd_cached (fd, 2, alg, dst, size) != 0)
                 {
                         close (fd);
                         return (-1);
@@ -103,14 +103,14 @@ static int mem2hex (uint8_t *mem, size_t mlen, char *str, size_t slen)
 	return (0);
 }
 
-static int filehash58_cb (const char *p, const char *f, const char *h, probe_ctx *ctx)
+static int filehash58_cb (const char *p, const char *f, const char *h[], int h_num, probe_ctx *ctx)
 {
 	SEXP_t *itm;
 
 	char   pbuf[PATH_MAX+1];
 	size_t plen, flen;
 
-	int fd;
+	int fd, i;
 
 	if (f == NULL)
 		return (0);
@@ -140,61 +140,74 @@ static int filehash58_cb (const char *p, const char *f, const char *h, probe_ctx
 	fd = open (pbuf, O_RDONLY);
 
 	if (fd < 0) {
-		strerror_r (errno, pbuf, PATH_MAX);
+		int open_errno = errno;
+
+		strerror_r (open_errno, pbuf, PATH_MAX);
 		pbuf[PATH_MAX] = '\0';
 
-		itm = probe_item_create (OVAL_INDEPENDENT_FILE_HASH58, NULL,
-					"filepath", OVAL_DATATYPE_STRING, pbuf,
-					"path",     OVAL_DATATYPE_STRING, p,
-					"filename", OVAL_DATATYPE_STRING, f,
-					"hash_type",OVAL_DATATYPE_STRING, h,
-					NULL);
-		probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
-			"Can't open \"%s\": errno=%d, %s.", pbuf, errno, strerror (errno));
-		probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
+		for (i = 0; i < h_num; ++i) {
+			itm = probe_item_create (OVAL_INDEPENDENT_FILE_HASH58, NULL,
+						"filepath", OVAL_DATATYPE_STRING, pbuf,
+						"path",     OVAL_DATATYPE_STRING, p,
+						"filename", OVAL_DATATYPE_STRING, f,
+						"hash_type",OVAL_DATATYPE_STRING, h[i],
+						NULL);
+			probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
+				"Can't open \"%s\": errno=%d, %s.", pbuf, open_errno, strerror (open_errno));
+			probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
+			probe_item_collect(ctx, itm);
+		}
 	} else {
-		uint8_t hash_dst[1025];
-		size_t  hash_dstlen = sizeof hash_dst;
-		char    hash_str[2051];
-
-		crapi_alg_t hash_type;
-
-		hash_type = oscap_string_to_enum(CRAPI_ALG_MAP, h);
-		hash_dstlen = oscap_string_to_enum(CRAPI_ALG_MAP_SIZE, h);
+		uint8_t hash_dst[CRAPI_DIGEST_CNT][64];
+		size_t  hash_dstlen[CRAPI_DIGEST_CNT];
+		char    hash_str[(64 * 2) + 1];
+
+		crapi_alg_t hash_type[CRAPI_DIGEST_CNT];
+		void       *dst[CRAPI_DIGEST_CNT];
+		size_t     *dstlen[CRAPI_DIGEST_CNT];
+
+		for (i = 0; i < h_num; ++i) {
+			hash_type[i]   = oscap_string_to_enum(CRAPI_ALG_MAP, h[i]);
+			hash_dstlen[i] = oscap_string_to_enum(CRAPI_ALG_MAP_SIZE, h[i]);
+			dst[i]    = hash_dst[i];
+			dstlen[i] = &hash_dstlen[i];
+		}
 
 		/*
-		 * Compute hash value
+		 * Compute all requested hash values in one pass
 		 */
-		if (crapi_mdigest_fd (fd, 1, hash_type, hash_dst, &hash_dstlen) != 0) {
+		if (crapi_mdigest_fd_cached (fd, h_num, hash_type, dst, dstlen) != 0) {
 			close (fd);
 			return (-1);
 		}
 
 		close (fd);
 
-		hash_str[0] = '\0';
-		mem2hex (hash_dst, hash_dstlen, hash_str, sizeof hash_str);
+		for (i = 0; i < h_num; ++i) {
+			hash_str[0] = '\0';
+			mem2hex (hash_dst[i], hash_dstlen[i], hash_str, sizeof hash_str);
+
+			/*
+			 * Create and add the item
+			 */
+			itm = probe_item_create(OVAL_INDEPENDENT_FILE_HASH58, NULL,
+						"filepath", OVAL_DATATYPE_STRING, pbuf,
+						"path",     OVAL_DATATYPE_STRING, p,
+						"filename", OVAL_DATATYPE_STRING, f,
+						"hash_type",OVAL_DATATYPE_STRING, h[i],
+						"hash",     OVAL_DATATYPE_STRING, hash_str,
+						NULL);
+
+			if (hash_dstlen[i] == 0) {
+				probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
+						   "Unable to compute %s hash value of \"%s\".", h[i], pbuf);
+				probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
+			}
 
-		/*
-		 * Create and add the item
-		 */
-		itm = probe_item_create(OVAL_INDEPENDENT_FILE_HASH58, NULL,
-					"filepath", OVAL_DATATYPE_STRING, pbuf,
-					"path",     OVAL_DATATYPE_STRING, p,
-					"filename", OVAL_DATATYPE_STRING, f,
-					"hash_type",OVAL_DATATYPE_STRING, h,
-					"hash",     OVAL_DATATYPE_STRING, hash_str,
-					NULL);
-
-		if (hash_dstlen == 0) {
-			probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
-					   "Unable to compute %s hash value of \"%s\".", h, pbuf);
-			probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
+			probe_item_collect(ctx, itm);
 		}
 	}
 
-	probe_item_collect(ctx, itm);
-
 	return (0);
 }
 
@@ -238,6 +251,8 @@ int probe_main(probe_ctx *ctx, void *mutex)
 	SEXP_t *probe_in;
 	SEXP_t *path, *filename, *behaviors, *filepath, *hash_type;
 	char hash_type_str[128];
+	const char *hash_types[CRAPI_DIGEST_CNT];
+	int hash_types_num = 0;
 	int err = 0;
 
 	OVAL_FTS    *ofts;
@@ -271,6 +286,15 @@ int probe_main(probe_ctx *ctx, void *mutex)
 
 	probe_filebehaviors_canonicalize(&behaviors);
 
+	/* find hash types to compare with entity, think "not satisfy" */
+	for (const struct oscap_string_map *p = CRAPI_ALG_MAP; p->value != CRAPI_INVALID; p++) {
+		SEXP_t *crapi_hash_type_sexp = SEXP_string_new(p->string, strlen(p->string));
+		if (probe_entobj_cmp(hash_type, crapi_hash_type_sexp) == OVAL_RESULT_TRUE)
+			hash_types[hash_types_num++] = p->string;
+
+		SEXP_free(crapi_hash_type_sexp);
+	}
+
 	switch (pthread_mutex_lock (&__filehash58_probe_mutex)) {
 	case 0:
 		break;
@@ -283,17 +307,8 @@ int probe_main(probe_ctx *ctx, void *mutex)
 
 	if ((ofts = oval_fts_open(path, filename, filepath, behaviors, probe_ctx_getresult(ctx))) != NULL) {
 		while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
-			/* find hash types to compare with entity, think "not satisfy" */
-			const struct oscap_string_map *p = CRAPI_ALG_MAP;
-			while (p->value != CRAPI_INVALID) {
-				SEXP_t *crapi_hash_type_sexp = SEXP_string_new(p->string, strlen(p->string));
-				if (probe_entobj_cmp(hash_type, crapi_hash_type_sexp) == OVAL_RESULT_TRUE) {
-					filehash58_cb(ofts_ent->path, ofts_ent->file, p->string, ctx);
-				}
-
-				SEXP_free(crapi_hash_type_sexp);
-				p++;
-			}
+			if (hash_types_num > 0)
+				filehash58_cb(ofts_ent->path, ofts_ent->file, hash_types, hash_types_num, ctx);
 			oval_ftsent_free(ofts_ent);
 		}
 
@@ -126,10 +126,14 @@ static int filehash_cb (const char *p, const char *f, void *ptr, const SEXP_t *f
                 size_t  md5_dstlen = sizeof md5_dst;
                 char    md5_str[32+1];
 
+                crapi_alg_t alg[1]  = { CRAPI_DIGEST_MD5 };
+                void       *dst[1]  = { md5_dst };
+                size_t     *size[1] = { &md5_dstlen };
+
                 /*
                  * Compute hash values
                  */
-                if (crapi_digest_fd (fd, CRAPI_DIGEST_MD5,  &md5_dst,  &md5_dstlen) != 0)
+                if (crapi_mdigest_fd_cached (fd, 1, alg, dst, size) != 0)
                 {
                         close (fd);
                         return (-1);
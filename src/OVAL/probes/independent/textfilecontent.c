@@ -69,6 +69,7 @@
 #include <probe/entcmp.h>
 #include <probe/probe.h>
 #include <probe/option.h>
+#include <probe/fcache.h>
 #include <oval_fts.h>
 #include <alloc.h>
 #include "common/assume.h"
@@ -222,7 +223,7 @@ static int process_file(const char *path, const char *filename, void *arg)
 	 * to return 'FTS_SL' and the presence of a valid target has to
 	 * be determined with stat().
 	 */
-	if (stat(whole_path, &st) == -1)
+	if (probe_fcache_stat(whole_path, &st) == -1)
 		goto cleanup;
 	if (!S_ISREG(st.st_mode))
 		goto cleanup;
@@ -43,23 +43,27 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <limits.h>
-#include <pcre.h>
+#include <stdbool.h>
+#include <ctype.h>
 
 #include <seap.h>
 #include <probe-api.h>
 #include <probe/entcmp.h>
 #include <probe/probe.h>
 #include <probe/option.h>
+#include <probe/fcache.h>
 #include <oval_fts.h>
 #include <alloc.h>
 #include "common/assume.h"
 #include "common/debug_priv.h"
+#include "common/oscap_pcre.h"
 
 #define FILE_SEPARATOR '/'
 
 oval_schema_version_t over;
 
-static int get_substrings(char *str, int *ofs, pcre *re, int want_substrs, char ***substrings) {
+static int get_substrings(const char *str, int str_len, int *ofs, int exec_opts, struct oscap_pcre *re,
+			  int want_substrs, char ***substrings) {
 	int i, ret, rc;
 	int ovector[60], ovector_len = sizeof (ovector) / sizeof (ovector[0]);
 	char **substrs;
@@ -70,13 +74,16 @@ static int get_substrings(char *str, int *ofs, pcre *re, int want_substrs, char
 		ovector[i] = -1;
 
 #if defined(__SVR4) && defined(__sun)
-	rc = pcre_exec(re, NULL, str, strlen(str), *ofs, PCRE_NO_UTF8_CHECK, ovector, ovector_len);
-#else
-	rc = pcre_exec(re, NULL, str, strlen(str), *ofs, 0, ovector, ovector_len);
+	exec_opts |= PCRE_NO_UTF8_CHECK;
 #endif
+	rc = oscap_pcre_exec(re, str, str_len, *ofs, exec_opts, ovector, ovector_len);
 
-	if (rc < -1) {
-		dE("Function pcre_exec() failed to match a regular expression with return code %d on string '%s'.", rc, str);
+	if (rc == PCRE_ERROR_PARTIAL) {
+		/* the match may continue after the end of the subject */
+		*ofs = ovector[0];
+		return rc;
+	} else if (rc < -1) {
+		dE("Function pcre_exec() failed to match a regular expression with return code %d at offset %d.", rc, *ofs);
 		return rc;
 	} else if (rc == -1) {
 		/* no match */
@@ -117,6 +124,145 @@ static int get_substrings(char *str, int *ofs, pcre *re, int want_substrs, char
 	return ret;
 }
 
+/*
+ * Find the longest sequence of characters that has to be present in
+ * every string matched by the pattern. Only characters outside of any
+ * group or class are considered and nothing is found if the pattern
+ * contains a top-level alternation or option setting. Letters don't
+ * count in caseless mode. This is used to skip files that can't match
+ * without running the regex engine over them.
+ */
+static size_t required_literal(const char *pattern, bool caseless, char **literal)
+{
+	size_t plen = strlen(pattern), cur_len = 0, best_len = 0;
+	char *cur, *best;
+	const char *p;
+	int depth = 0;
+
+	cur  = malloc(plen + 1);
+	best = malloc(plen + 1);
+
+#define SAVE_RUN()						\
+	do {							\
+		if (cur_len > best_len) {			\
+			memcpy(best, cur, cur_len);		\
+			best_len = cur_len;			\
+		}						\
+	} while (0)
+
+	for (p = pattern; *p != '\0'; ++p) {
+		int c = -1;
+
+		switch (*p) {
+		case '\\':
+			++p;
+			if (*p == '\0' || strchr("QEcgkNopPux0123456789", *p) != NULL)
+				goto none;
+			if (!isalnum((unsigned char)*p) && !((unsigned char)*p & 0x80))
+				c = *p;
+			break;
+		case '[':
+			/* a ']' right after the opening bracket is a literal */
+			++p;
+			if (*p == '^')
+				++p;
+			if (*p == ']')
+				++p;
+			while (*p != ']') {
+				if (*p == '\0')
+					goto none;
+				if (*p == '\\' && *++p == '\0')
+					goto none;
+				++p;
+			}
+			break;
+		case '(':
+			/* option settings, comments, conditions, ... */
+			if (depth == 0 && p[1] == '?' && strchr(":=!<>|", p[2]) == NULL)
+				goto none;
+			++depth;
+			break;
+		case ')':
+			if (--depth < 0)
+				goto none;
+			break;
+		case '|':
+			if (depth == 0)
+				goto none;
+			break;
+		case '{':
+			if (!isdigit((unsigned char)p[1])) {
+				c = *p;
+				break;
+			}
+			if (depth == 0) {
+				/* the preceding character is optional */
+				if (cur_len > 0)
+					--cur_len;
+				SAVE_RUN();
+				cur_len = 0;
+			}
+			while (*p != '}') {
+				if (*p == '\0')
+					goto none;
+				++p;
+			}
+			continue;
+		case '?':
+		case '*':
+			if (depth == 0) {
+				if (cur_len > 0)
+					--cur_len;
+				SAVE_RUN();
+				cur_len = 0;
+			}
+			continue;
+		case '+':
+			/* the preceding character is present, but may be repeated */
+			if (depth == 0 && cur_len > 0) {
+				SAVE_RUN();
+				cur[0] = cur[cur_len - 1];
+				cur_len = 1;
+			}
+			continue;
+		case '.':
+		case '^':
+		case '$':
+			break;
+		default:
+			if (!((unsigned char)*p & 0x80))
+				c = *p;
+			break;
+		}
+
+		if (depth == 0 && c != -1 && !(caseless && isalpha(c))) {
+			cur[cur_len++] = (char)c;
+		} else {
+			SAVE_RUN();
+			cur_len = 0;
+		}
+	}
+
+	if (depth != 0)
+		goto none;
+
+	SAVE_RUN();
+#undef SAVE_RUN
+	free(cur);
+
+	if (best_len == 0) {
+		free(best);
+		return 0;
+	}
+
+	*literal = best;
+	return best_len;
+none:
+	free(cur);
+	free(best);
+	return 0;
+}
+
 static SEXP_t *create_item(const char *path, const char *filename, char *pattern,
 			   int instance, char **substrs, int substr_cnt)
 {
@@ -167,17 +313,333 @@ struct pfdata {
 	int re_opts;
 	SEXP_t *instance_ent;
         probe_ctx *ctx;
-	pcre *compiled_regex;
+	struct oscap_pcre *compiled_regex;
+	char *literal;        /* see required_literal() */
+	size_t literal_len;
+};
+
+static void report_error(struct pfdata *pfd, SEXP_t *msg)
+{
+	probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
+	SEXP_free(msg);
+	probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
+}
+
+/*
+ * The content of a file is read into a window, which slides over the file
+ * when the file doesn't fit into it. The window is grown up to
+ * TFC54_WINDOW_MAX bytes when a single match doesn't fit into it. The
+ * TFC54_WINDOW_CONTEXT bytes before the next match are kept in the window
+ * for lookbehind assertions and \b.
+ */
+#define TFC54_WINDOW_SIZE    (8 * 1024 * 1024)
+#define TFC54_WINDOW_MAX     (256 * 1024 * 1024)
+#define TFC54_WINDOW_CONTEXT 4096
+
+struct tfc54_window {
+	int fd;
+	char *buf;
+	size_t size;          /* allocated bytes */
+	size_t len;           /* bytes read */
+	bool bof;             /* buf starts at the beginning of the file */
+	bool eof;             /* buf ends at the end of the content */
 };
 
+static void window_init(struct tfc54_window *w, int fd, off_t file_size)
+{
+	w->fd = fd;
+	/* Files in /proc report zero size, the window is grown as they're read */
+	if (file_size <= 0)
+		w->size = 4096;
+	else if (file_size < TFC54_WINDOW_SIZE)
+		w->size = file_size + 1;
+	else
+		w->size = TFC54_WINDOW_SIZE;
+	w->buf = malloc(w->size);
+	w->len = 0;
+	w->bof = true;
+	w->eof = false;
+}
+
+/*
+ * Drop the bytes before keep and read more of the file. The content ends
+ * at the end of the file or at the first NUL character.
+ */
+static int window_fill(struct tfc54_window *w, size_t keep)
+{
+	bool grow = false;
+	ssize_t ret;
+	char *nul;
+
+	if (keep > 0) {
+		memmove(w->buf, w->buf + keep, w->len - keep);
+		w->len -= keep;
+		w->bof = false;
+	}
+	/* a match doesn't fit into the window, there has to be more room */
+	if (w->len == w->size)
+		grow = true;
+
+	while (!w->eof) {
+		if (w->len == w->size) {
+			if (w->size >= TFC54_WINDOW_SIZE && !grow)
+				break;
+			if (w->size >= TFC54_WINDOW_MAX) {
+				errno = EFBIG;
+				return -1;
+			}
+			w->size = w->size * 2 < TFC54_WINDOW_MAX ? w->size * 2 : TFC54_WINDOW_MAX;
+			w->buf = realloc(w->buf, w->size);
+			grow = false;
+		}
+		ret = read(w->fd, w->buf + w->len, w->size - w->len);
+		if (ret == 0) {
+			w->eof = true;
+			break;
+		}
+		if (ret == -1) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		nul = memchr(w->buf + w->len, '\0', ret);
+		if (nul != NULL) {
+			w->len = nul - w->buf;
+			w->eof = true;
+			break;
+		}
+		w->len += ret;
+	}
+
+	return 0;
+}
+
+/*
+ * Get the length of the window content without a UTF-8 character which
+ * continues in the part of the file not read yet.
+ */
+static size_t window_complete_len(const struct tfc54_window *w)
+{
+	size_t back, need;
+	unsigned char c;
+
+	if (w->eof)
+		return w->len;
+
+	for (back = 1; back <= 4 && back <= w->len; ++back) {
+		c = w->buf[w->len - back];
+		if ((c & 0xc0) == 0x80)
+			continue;
+		if ((c & 0xe0) == 0xc0)
+			need = 2;
+		else if ((c & 0xf0) == 0xe0)
+			need = 3;
+		else if ((c & 0xf8) == 0xf0)
+			need = 4;
+		else
+			need = 1;
+		return need > back ? w->len - back : w->len;
+	}
+	return w->len;
+}
+
+/*
+ * Move an offset in the window back to the start of a UTF-8 character.
+ */
+static size_t window_char_start(const struct tfc54_window *w, size_t ofs)
+{
+	size_t i;
+
+	for (i = 0; i < 3 && ofs > 0 && ofs < w->len && ((unsigned char)w->buf[ofs] & 0xc0) == 0x80; ++i)
+		--ofs;
+	return ofs;
+}
+
+static size_t window_keep(const struct tfc54_window *w, size_t ofs)
+{
+	return window_char_start(w, ofs > TFC54_WINDOW_CONTEXT ? ofs - TFC54_WINDOW_CONTEXT : 0);
+}
+
+/*
+ * Look for the string required by the pattern (see required_literal()).
+ * Files which don't contain it are still checked for invalid UTF-8, as
+ * pcre_exec() would do first. rewind is set if the window has been moved.
+ * @return 1 if the string was found, 0 if the file can't match, -1 on error
+ */
+static int find_literal(struct pfdata *pfd, const char *whole_path, struct tfc54_window *w, bool *rewind)
+{
+	struct oscap_pcre *utf8_check = NULL;
+	size_t len, keep;
+	void *found;
+	int ret = 0, rc;
+
+	*rewind = false;
+
+	for (;;) {
+		if (pfd->literal_len == 1)
+			found = memchr(w->buf, pfd->literal[0], w->len);
+		else
+			found = memmem(w->buf, w->len, pfd->literal, pfd->literal_len);
+		if (found != NULL) {
+			ret = 1;
+			break;
+		}
+
+		len = window_complete_len(w);
+		if (pfd->re_opts & PCRE_UTF8) {
+			if (utf8_check == NULL)
+				utf8_check = oscap_pcre_compile("", PCRE_UTF8 | PCRE_ANCHORED, NULL, NULL);
+			rc = oscap_pcre_exec(utf8_check, w->buf, len, 0, 0, NULL, 0);
+			if (rc < -1) {
+				report_error(pfd, probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
+					"Regular expression pattern match failed in file %s with error %d.",
+					whole_path, rc));
+				ret = -1;
+				break;
+			}
+		}
+		if (w->eof)
+			break;
+
+		/* the string may continue in the next part of the file */
+		keep = w->len >= pfd->literal_len ? w->len - pfd->literal_len + 1 : 0;
+		if (keep > len)
+			keep = len;
+		*rewind = true;
+		if (window_fill(w, window_char_start(w, keep)) != 0) {
+			report_error(pfd, probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "read(): '%s' %s.", whole_path, strerror(errno)));
+			ret = -1;
+			break;
+		}
+	}
+
+	oscap_pcre_free(utf8_check);
+	return ret;
+}
+
+/*
+ * Move the window to the next part of the file, ofs is the offset the
+ * matching continues from.
+ */
+static int match_next_part(struct pfdata *pfd, const char *whole_path, struct tfc54_window *w, int *ofs)
+{
+	size_t keep = window_keep(w, *ofs);
+
+	if (window_fill(w, keep) != 0) {
+		if (errno == EFBIG)
+			report_error(pfd, probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
+				"A match in file '%s' is longer than %d bytes.", whole_path, TFC54_WINDOW_MAX));
+		else
+			report_error(pfd, probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
+				"read(): '%s' %s.", whole_path, strerror(errno)));
+		return -2;
+	}
+	*ofs -= keep;
+
+	return 0;
+}
+
+/*
+ * Match the pattern against the content of a file and collect the
+ * instances. The file is matched in parts if it doesn't fit into the
+ * window, a match reaching the end of a part is completed with the next
+ * one (PCRE_PARTIAL_HARD). cur_inst counts the instances found so far.
+ */
+static int match_file(struct pfdata *pfd, const char *path, const char *file, const char *whole_path,
+		      struct tfc54_window *w, int *cur_inst)
+{
+	int substr_cnt, buf_len, ofs = 0, exec_opts = 0, opts;
+	SEXP_t *next_inst;
+
+	for (;;) {
+		char **substrs;
+		int want_instance;
+
+		buf_len = window_complete_len(w);
+
+		if (ofs > buf_len) {
+			if (w->eof)
+				break;
+			if (match_next_part(pfd, whole_path, w, &ofs) != 0)
+				return -2;
+			exec_opts = 0;
+			continue;
+		}
+
+		next_inst = SEXP_number_newi_32(*cur_inst + 1);
+
+		if (probe_entobj_cmp(pfd->instance_ent, next_inst) == OVAL_RESULT_TRUE)
+			want_instance = 1;
+		else
+			want_instance = 0;
+
+		SEXP_free(next_inst);
+
+		opts = exec_opts;
+		if (!w->eof)
+			opts |= PCRE_PARTIAL_HARD;
+		if (!w->bof)
+			opts |= PCRE_NOTBOL;
+		substr_cnt = get_substrings(w->buf, buf_len, &ofs, opts, pfd->compiled_regex,
+					    want_instance, &substrs);
+
+		if (substr_cnt == PCRE_ERROR_PARTIAL || (substr_cnt == 0 && !w->eof)) {
+			/* continue from the partial match or after the searched part */
+			if (substr_cnt == 0)
+				ofs = buf_len;
+			if (match_next_part(pfd, whole_path, w, &ofs) != 0)
+				return -2;
+			exec_opts = 0;
+			continue;
+		}
+
+		if (substr_cnt < 0) {
+			report_error(pfd, probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
+				"Regular expression pattern match failed in file %s with error %d.",
+				whole_path, substr_cnt));
+			return -3;
+		}
+
+		if (substr_cnt == 0)
+			break;
+
+		/*
+		 * The whole subject has been validated by the first pcre_exec() call,
+		 * don't validate it again unless the offset points inside of a character.
+		 */
+		if (ofs < buf_len && ((unsigned char)w->buf[ofs] & 0xc0) == 0x80)
+			exec_opts = 0;
+		else
+			exec_opts = PCRE_NO_UTF8_CHECK;
+
+		++*cur_inst;
+
+		if (want_instance) {
+			int k;
+			SEXP_t *item;
+
+			item = create_item(path, file, pfd->pattern,
+					   *cur_inst, substrs, substr_cnt);
+
+                        probe_item_collect(pfd->ctx, item);
+
+			for (k = 0; k < substr_cnt; ++k)
+				free(substrs[k]);
+			free(substrs);
+		}
+	}
+
+	return 0;
+}
+
 static int process_file(const char *path, const char *file, void *arg)
 {
 	struct pfdata *pfd = (struct pfdata *) arg;
-	int ret = 0, path_len, file_len, cur_inst = 0, fd = -1, substr_cnt,
-		buf_size = 0, buf_used = 0, ofs = 0, buf_inc = 4096;
-	char *whole_path = NULL, *buf = NULL;
-	SEXP_t *next_inst = NULL;
+	int ret = 0, path_len, file_len, fd = -1, cur_inst = 0;
+	char *whole_path = NULL;
+	struct tfc54_window w = { .buf = NULL };
 	struct stat st;
+	bool rewind;
 
 	if (file == NULL)
 		goto cleanup;
@@ -204,93 +666,64 @@ static int process_file(const char *path, const char *file, void *arg)
 	 * to return 'FTS_SL' and the presence of a valid target has to
 	 * be determined with stat().
 	 */
-	if (stat(whole_path, &st) == -1)
+	if (probe_fcache_stat(whole_path, &st) == -1)
 		goto cleanup;
 	if (!S_ISREG(st.st_mode))
 		goto cleanup;
 
 	fd = open(whole_path, O_RDONLY);
 	if (fd == -1) {
-		SEXP_t *msg;
-
-		msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "open(): '%s' %s.", whole_path, strerror(errno));
-		probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
-		SEXP_free(msg);
-		probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
+		report_error(pfd, probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "open(): '%s' %s.", whole_path, strerror(errno)));
 		ret = -1;
 		goto cleanup;
 	}
 
-	do {
-		buf_size += buf_inc;
-		buf = realloc(buf, buf_size);
-		ret = read(fd, buf + buf_used, buf_inc);
-		if (ret == -1) {
-			SEXP_t *msg;
-
-			msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "read(): '%s' %s.", whole_path, strerror(errno));
-			probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
-			SEXP_free(msg);
-			probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
-			ret = -2;
-			goto cleanup;
-		}
-		buf_used += ret;
-	} while (ret == buf_inc);
-
-	if (buf_used == buf_size)
-		buf = realloc(buf, ++buf_size);
-	buf[buf_used++] = '\0';
-
-	do {
-		char **substrs;
-		int want_instance;
-
-		next_inst = SEXP_number_newi_32(cur_inst + 1);
-
-		if (probe_entobj_cmp(pfd->instance_ent, next_inst) == OVAL_RESULT_TRUE)
-			want_instance = 1;
-		else
-			want_instance = 0;
-
-		SEXP_free(next_inst);
-		substr_cnt = get_substrings(buf, &ofs, pfd->compiled_regex, want_instance, &substrs);
+	/*
+	 * The file is read, not mapped: a mapped file which is truncated
+	 * while it's matched (e.g. by logrotate with copytruncate) can't be
+	 * read anymore, a truncated file which is read just ends earlier.
+	 */
+	if (fstat(fd, &st) != 0)
+		st.st_size = 0;
+	window_init(&w, fd, st.st_size);
+	if (window_fill(&w, 0) != 0) {
+		report_error(pfd, probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "read(): '%s' %s.", whole_path, strerror(errno)));
+		ret = -2;
+		goto cleanup;
+	}
 
-		if (substr_cnt < 0) {
-			SEXP_t *msg;
-			msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
-				"Regular expression pattern match failed in file %s with error %d.",
-				whole_path, substr_cnt);
-			probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
-			SEXP_free(msg);
-			probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
-			ret = -3;
+	/*
+	 * Skip the regex engine if a string required by the pattern isn't
+	 * there. The file is read again if the string isn't in its first part.
+	 */
+	if (pfd->literal_len > 0) {
+		ret = find_literal(pfd, whole_path, &w, &rewind);
+		if (ret <= 0) {
+			ret = ret < 0 ? -3 : 0;
 			goto cleanup;
 		}
-
-		if (substr_cnt > 0) {
-			++cur_inst;
-
-			if (want_instance) {
-				int k;
-				SEXP_t *item;
-
-				item = create_item(path, file, pfd->pattern,
-						   cur_inst, substrs, substr_cnt);
-
-                                probe_item_collect(pfd->ctx, item);
-
-				for (k = 0; k < substr_cnt; ++k)
-					free(substrs[k]);
-				free(substrs);
+		if (rewind) {
+			if (lseek(fd, 0, SEEK_SET) == -1) {
+				report_error(pfd, probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "lseek(): '%s' %s.", whole_path, strerror(errno)));
+				ret = -2;
+				goto cleanup;
+			}
+			free(w.buf);
+			window_init(&w, fd, st.st_size);
+			if (window_fill(&w, 0) != 0) {
+				report_error(pfd, probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "read(): '%s' %s.", whole_path, strerror(errno)));
+				ret = -2;
+				goto cleanup;
 			}
 		}
-	} while (substr_cnt > 0 && ofs < buf_used);
+	}
+
+	ret = match_file(pfd, path, file, whole_path, &w, &cur_inst);
 
  cleanup:
+	free(w.buf);
 	if (fd != -1)
 		close(fd);
-	free(buf);
 	if (whole_path != NULL)
 		free(whole_path);
 
@@ -416,8 +849,8 @@ int probe_main(probe_ctx *ctx, void *arg)
 			pfd.re_opts |= PCRE_DOTALL;
 	}
 
-	pfd.compiled_regex = pcre_compile(pfd.pattern, pfd.re_opts, &error,
-					  &errorffset, NULL);
+	pfd.compiled_regex = oscap_pcre_compile(pfd.pattern, pfd.re_opts, &error,
+						&errorffset);
 	if (pfd.compiled_regex == NULL) {
 		SEXP_t *msg;
 
@@ -428,6 +861,10 @@ int probe_main(probe_ctx *ctx, void *arg)
 		goto cleanup;
 	}
 
+	pfd.literal_len = required_literal(pfd.pattern, pfd.re_opts & PCRE_CASELESS, &pfd.literal);
+	if (pfd.literal_len > 0)
+		dD("Files without '%.*s' can't match the pattern '%s'.", (int)pfd.literal_len, pfd.literal, pfd.pattern);
+
 	path_with_root[PATH_MAX] = '\0';
 	if (OSCAP_GSYM(offline_mode) & PROBE_OFFLINE_OWN) {
 		strncpy(path_with_root, getenv("OSCAP_PROBE_ROOT"), PATH_MAX);
@@ -459,7 +896,7 @@ int probe_main(probe_ctx *ctx, void *arg)
         SEXP_free(filepath_ent);
 	if (pfd.pattern != NULL)
 		free(pfd.pattern);
-	if (pfd.compiled_regex != NULL)
-		pcre_free(pfd.compiled_regex);
+	oscap_pcre_free(pfd.compiled_regex);
+	free(pfd.literal);
 	return ret;
 }
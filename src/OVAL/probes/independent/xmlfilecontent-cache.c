@@ -0,0 +1,442 @@
+/*
+ * Copyright 2009 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <libxml/parser.h>
+
+#include "common/debug_priv.h"
+#include "xmlfilecontent-cache.h"
+
+#define XML_CACHE_DOC_HSIZE   1021
+#define XML_CACHE_XPATH_HSIZE 509
+/* a parsed document takes roughly this many times the size of the file */
+#define XML_CACHE_TREE_FACTOR 4
+
+static struct {
+	pthread_mutex_t lock;
+	pthread_once_t once;
+	size_t max_mem;
+	struct xml_cache_doc *docs[XML_CACHE_DOC_HSIZE];
+	struct xml_cache_doc *doc_head, *doc_tail;
+	size_t doc_count, doc_mem;
+	size_t doc_hits, doc_misses, doc_evictions;
+	struct xml_cache_xpath *xpaths[XML_CACHE_XPATH_HSIZE];
+	struct xml_cache_xpath *xpath_head, *xpath_tail;
+	size_t xpath_count;
+	size_t xpath_hits, xpath_misses;
+} xml_cache = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.once = PTHREAD_ONCE_INIT
+};
+
+static void xml_cache_init(void)
+{
+	const char *env = getenv(XML_CACHE_ENV);
+	unsigned long mb = XML_CACHE_DEFAULT_MB;
+
+	if (env != NULL) {
+		char *end;
+
+		mb = strtoul(env, &end, 10);
+		if (*env == '\0' || *end != '\0') {
+			dW("Invalid %s value: %s", XML_CACHE_ENV, env);
+			mb = XML_CACHE_DEFAULT_MB;
+		}
+	}
+
+	xml_cache.max_mem = (size_t)mb * 1024 * 1024;
+}
+
+static unsigned int xml_cache_hash(const char *str)
+{
+	unsigned int h = 2166136261u;
+
+	while (*str != '\0') {
+		h ^= (unsigned char)*str++;
+		h *= 16777619u;
+	}
+
+	return h;
+}
+
+static bool xml_cache_doc_stat_eq(const struct xml_cache_doc *doc, const struct stat *st)
+{
+	return doc->dev == st->st_dev &&
+	       doc->ino == st->st_ino &&
+	       doc->size == st->st_size &&
+	       doc->mtime.tv_sec == st->st_mtim.tv_sec &&
+	       doc->mtime.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+static void xml_cache_doc_destroy(struct xml_cache_doc *doc)
+{
+	xmlFreeDoc(doc->doc);
+	pthread_mutex_destroy(&doc->lock);
+	free(doc->path);
+	free(doc);
+}
+
+static void xml_cache_xpath_destroy(struct xml_cache_xpath *xpath)
+{
+	xmlXPathFreeCompExpr(xpath->comp);
+	free(xpath->expr);
+	free(xpath);
+}
+
+/* The functions below have to be called with the cache lock held */
+
+static struct xml_cache_doc *xml_cache_doc_lookup(const char *path, unsigned int hash)
+{
+	struct xml_cache_doc *doc;
+
+	for (doc = xml_cache.docs[hash % XML_CACHE_DOC_HSIZE]; doc != NULL; doc = doc->hnext) {
+		if (doc->hash == hash && strcmp(doc->path, path) == 0)
+			return doc;
+	}
+
+	return NULL;
+}
+
+static void xml_cache_doc_lru_unlink(struct xml_cache_doc *doc)
+{
+	if (doc->prev != NULL)
+		doc->prev->next = doc->next;
+	else
+		xml_cache.doc_head = doc->next;
+	if (doc->next != NULL)
+		doc->next->prev = doc->prev;
+	else
+		xml_cache.doc_tail = doc->prev;
+
+	doc->prev = doc->next = NULL;
+}
+
+static void xml_cache_doc_lru_push(struct xml_cache_doc *doc)
+{
+	doc->prev = NULL;
+	doc->next = xml_cache.doc_head;
+	if (doc->next != NULL)
+		doc->next->prev = doc;
+	else
+		xml_cache.doc_tail = doc;
+	xml_cache.doc_head = doc;
+}
+
+/* remove the document from the cache, it's destroyed once it's not used */
+static void xml_cache_doc_remove(struct xml_cache_doc *doc)
+{
+	struct xml_cache_doc **dp = &xml_cache.docs[doc->hash % XML_CACHE_DOC_HSIZE];
+
+	while (*dp != doc)
+		dp = &(*dp)->hnext;
+	*dp = doc->hnext;
+	doc->hnext = NULL;
+
+	xml_cache_doc_lru_unlink(doc);
+	xml_cache.doc_count--;
+	xml_cache.doc_mem -= doc->mem;
+	doc->cached = false;
+
+	if (doc->refs == 0)
+		xml_cache_doc_destroy(doc);
+}
+
+static void xml_cache_doc_insert(struct xml_cache_doc *doc)
+{
+	while (xml_cache.doc_tail != NULL && xml_cache.doc_mem + doc->mem > xml_cache.max_mem) {
+		xml_cache_doc_remove(xml_cache.doc_tail);
+		xml_cache.doc_evictions++;
+	}
+
+	doc->hnext = xml_cache.docs[doc->hash % XML_CACHE_DOC_HSIZE];
+	xml_cache.docs[doc->hash % XML_CACHE_DOC_HSIZE] = doc;
+	xml_cache_doc_lru_push(doc);
+	xml_cache.doc_count++;
+	xml_cache.doc_mem += doc->mem;
+	doc->cached = true;
+}
+
+static struct xml_cache_xpath *xml_cache_xpath_lookup(const char *expr, unsigned int hash)
+{
+	struct xml_cache_xpath *xpath;
+
+	for (xpath = xml_cache.xpaths[hash % XML_CACHE_XPATH_HSIZE]; xpath != NULL; xpath = xpath->hnext) {
+		if (xpath->hash == hash && strcmp(xpath->expr, expr) == 0)
+			return xpath;
+	}
+
+	return NULL;
+}
+
+static void xml_cache_xpath_lru_unlink(struct xml_cache_xpath *xpath)
+{
+	if (xpath->prev != NULL)
+		xpath->prev->next = xpath->next;
+	else
+		xml_cache.xpath_head = xpath->next;
+	if (xpath->next != NULL)
+		xpath->next->prev = xpath->prev;
+	else
+		xml_cache.xpath_tail = xpath->prev;
+
+	xpath->prev = xpath->next = NULL;
+}
+
+static void xml_cache_xpath_lru_push(struct xml_cache_xpath *xpath)
+{
+	xpath->prev = NULL;
+	xpath->next = xml_cache.xpath_head;
+	if (xpath->next != NULL)
+		xpath->next->prev = xpath;
+	else
+		xml_cache.xpath_tail = xpath;
+	xml_cache.xpath_head = xpath;
+}
+
+static void xml_cache_xpath_remove(struct xml_cache_xpath *xpath)
+{
+	struct xml_cache_xpath **xp = &xml_cache.xpaths[xpath->hash % XML_CACHE_XPATH_HSIZE];
+
+	while (*xp != xpath)
+		xp = &(*xp)->hnext;
+	*xp = xpath->hnext;
+	xpath->hnext = NULL;
+
+	xml_cache_xpath_lru_unlink(xpath);
+	xml_cache.xpath_count--;
+	xpath->cached = false;
+
+	if (xpath->refs == 0)
+		xml_cache_xpath_destroy(xpath);
+}
+
+static void xml_cache_xpath_insert(struct xml_cache_xpath *xpath)
+{
+	if (xml_cache.xpath_count >= XML_CACHE_XPATH_MAX)
+		xml_cache_xpath_remove(xml_cache.xpath_tail);
+
+	xpath->hnext = xml_cache.xpaths[xpath->hash % XML_CACHE_XPATH_HSIZE];
+	xml_cache.xpaths[xpath->hash % XML_CACHE_XPATH_HSIZE] = xpath;
+	xml_cache_xpath_lru_push(xpath);
+	xml_cache.xpath_count++;
+	xpath->cached = true;
+}
+
+struct xml_cache_doc *xml_cache_doc_get(const char *path)
+{
+	struct xml_cache_doc *doc, *cur;
+	struct stat st;
+	unsigned int hash;
+	xmlDoc *xdoc;
+
+	pthread_once(&xml_cache.once, xml_cache_init);
+
+	if (stat(path, &st) != 0)
+		return NULL;
+
+	hash = xml_cache_hash(path);
+
+	if (xml_cache.max_mem > 0) {
+		pthread_mutex_lock(&xml_cache.lock);
+		doc = xml_cache_doc_lookup(path, hash);
+		if (doc != NULL) {
+			if (xml_cache_doc_stat_eq(doc, &st)) {
+				doc->refs++;
+				xml_cache_doc_lru_unlink(doc);
+				xml_cache_doc_lru_push(doc);
+				xml_cache.doc_hits++;
+				pthread_mutex_unlock(&xml_cache.lock);
+
+				pthread_mutex_lock(&doc->lock);
+				return doc;
+			}
+			/* the file has changed */
+			xml_cache_doc_remove(doc);
+		}
+		xml_cache.doc_misses++;
+		pthread_mutex_unlock(&xml_cache.lock);
+	}
+
+	xdoc = xmlParseFile(path);
+	if (xdoc == NULL)
+		return NULL;
+
+	doc = calloc(1, sizeof(struct xml_cache_doc));
+	doc->doc = xdoc;
+	doc->path = strdup(path);
+	doc->dev = st.st_dev;
+	doc->ino = st.st_ino;
+	doc->size = st.st_size;
+	doc->mtime = st.st_mtim;
+	doc->mem = (size_t)st.st_size * XML_CACHE_TREE_FACTOR + sizeof(struct xml_cache_doc);
+	doc->hash = hash;
+	doc->refs = 1;
+	pthread_mutex_init(&doc->lock, NULL);
+
+	if (xml_cache.max_mem > 0 && doc->mem <= xml_cache.max_mem) {
+		pthread_mutex_lock(&xml_cache.lock);
+		/* another thread might have parsed the same file meanwhile */
+		cur = xml_cache_doc_lookup(path, hash);
+		if (cur != NULL && xml_cache_doc_stat_eq(cur, &st)) {
+			cur->refs++;
+			pthread_mutex_unlock(&xml_cache.lock);
+
+			xml_cache_doc_destroy(doc);
+			pthread_mutex_lock(&cur->lock);
+			return cur;
+		}
+		if (cur != NULL)
+			xml_cache_doc_remove(cur);
+		xml_cache_doc_insert(doc);
+		pthread_mutex_unlock(&xml_cache.lock);
+	}
+
+	pthread_mutex_lock(&doc->lock);
+	return doc;
+}
+
+void xml_cache_doc_put(struct xml_cache_doc *doc)
+{
+	bool destroy;
+
+	if (doc == NULL)
+		return;
+
+	pthread_mutex_unlock(&doc->lock);
+
+	pthread_mutex_lock(&xml_cache.lock);
+	destroy = --doc->refs == 0 && !doc->cached;
+	pthread_mutex_unlock(&xml_cache.lock);
+
+	if (destroy)
+		xml_cache_doc_destroy(doc);
+}
+
+struct xml_cache_xpath *xml_cache_xpath_get(const char *expr)
+{
+	struct xml_cache_xpath *xpath, *cur;
+	xmlXPathCompExpr *comp;
+	unsigned int hash;
+
+	pthread_once(&xml_cache.once, xml_cache_init);
+
+	hash = xml_cache_hash(expr);
+
+	if (xml_cache.max_mem > 0) {
+		pthread_mutex_lock(&xml_cache.lock);
+		xpath = xml_cache_xpath_lookup(expr, hash);
+		if (xpath != NULL) {
+			xpath->refs++;
+			xml_cache_xpath_lru_unlink(xpath);
+			xml_cache_xpath_lru_push(xpath);
+			xml_cache.xpath_hits++;
+			pthread_mutex_unlock(&xml_cache.lock);
+
+			return xpath;
+		}
+		xml_cache.xpath_misses++;
+		pthread_mutex_unlock(&xml_cache.lock);
+	}
+
+	comp = xmlXPathCompile(BAD_CAST expr);
+	if (comp == NULL)
+		return NULL;
+
+	xpath = calloc(1, sizeof(struct xml_cache_xpath));
+	xpath->comp = comp;
+	xpath->expr = strdup(expr);
+	xpath->hash = hash;
+	xpath->refs = 1;
+
+	if (xml_cache.max_mem > 0) {
+		pthread_mutex_lock(&xml_cache.lock);
+		cur = xml_cache_xpath_lookup(expr, hash);
+		if (cur != NULL) {
+			cur->refs++;
+			pthread_mutex_unlock(&xml_cache.lock);
+
+			xml_cache_xpath_destroy(xpath);
+			return cur;
+		}
+		xml_cache_xpath_insert(xpath);
+		pthread_mutex_unlock(&xml_cache.lock);
+	}
+
+	return xpath;
+}
+
+void xml_cache_xpath_put(struct xml_cache_xpath *xpath)
+{
+	bool destroy;
+
+	if (xpath == NULL)
+		return;
+
+	pthread_mutex_lock(&xml_cache.lock);
+	destroy = --xpath->refs == 0 && !xpath->cached;
+	pthread_mutex_unlock(&xml_cache.lock);
+
+	if (destroy)
+		xml_cache_xpath_destroy(xpath);
+}
+
+void xml_cache_stats(struct xml_cache_stats *stats)
+{
+	pthread_mutex_lock(&xml_cache.lock);
+	stats->doc_hits = xml_cache.doc_hits;
+	stats->doc_misses = xml_cache.doc_misses;
+	stats->doc_evictions = xml_cache.doc_evictions;
+	stats->doc_count = xml_cache.doc_count;
+	stats->doc_mem = xml_cache.doc_mem;
+	stats->xpath_hits = xml_cache.xpath_hits;
+	stats->xpath_misses = xml_cache.xpath_misses;
+	pthread_mutex_unlock(&xml_cache.lock);
+}
+
+void xml_cache_clear(void)
+{
+	pthread_mutex_lock(&xml_cache.lock);
+
+	if (xml_cache.doc_hits + xml_cache.doc_misses > 0) {
+		dI("XML document cache: %zu hits, %zu misses, %zu evictions, "
+		   "XPath cache: %zu hits, %zu misses.",
+		   xml_cache.doc_hits, xml_cache.doc_misses, xml_cache.doc_evictions,
+		   xml_cache.xpath_hits, xml_cache.xpath_misses);
+	}
+
+	while (xml_cache.doc_head != NULL)
+		xml_cache_doc_remove(xml_cache.doc_head);
+	while (xml_cache.xpath_head != NULL)
+		xml_cache_xpath_remove(xml_cache.xpath_head);
+
+	xml_cache.doc_hits = xml_cache.doc_misses = xml_cache.doc_evictions = 0;
+	xml_cache.xpath_hits = xml_cache.xpath_misses = 0;
+
+	pthread_mutex_unlock(&xml_cache.lock);
+}
@@ -0,0 +1,92 @@
+#ifndef XMLFILECONTENT_CACHE_H
+#define XMLFILECONTENT_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <libxml/tree.h>
+#include <libxml/xpath.h>
+
+/*
+ * Parsed document and compiled XPath cache
+ *
+ * The xmlfilecontent probe keeps the documents it has parsed and the
+ * XPath expressions it has compiled, so objects querying the same files
+ * with different expressions (or the same expression in different files)
+ * parse and compile them only once. A document is identified by its path
+ * and reused only if its device, inode, size and mtime haven't changed.
+ *
+ * The documents are held up to OSCAP_PROBE_XML_CACHE megabytes (an
+ * estimate of the tree size, 64 by default), the least recently used
+ * ones are evicted first; 0 disables the cache. Both caches are dropped
+ * on the probe reset (i.e. when a new scan begins).
+ */
+#define XML_CACHE_ENV          "OSCAP_PROBE_XML_CACHE"
+#define XML_CACHE_DEFAULT_MB   64
+#define XML_CACHE_XPATH_MAX    1024 /* max. number of compiled expressions */
+
+struct xml_cache_doc {
+	pthread_mutex_t lock; /* held by the user of the document */
+	xmlDoc *doc;
+	char *path;
+	dev_t dev;
+	ino_t ino;
+	off_t size;
+	struct timespec mtime;
+	size_t mem;           /* estimated size of the tree */
+	unsigned int hash;
+	unsigned int refs;
+	bool cached;
+	struct xml_cache_doc *hnext;
+	struct xml_cache_doc *prev, *next; /* LRU list, most recently used first */
+};
+
+struct xml_cache_xpath {
+	xmlXPathCompExpr *comp;
+	char *expr;
+	unsigned int hash;
+	unsigned int refs;
+	bool cached;
+	struct xml_cache_xpath *hnext;
+	struct xml_cache_xpath *prev, *next;
+};
+
+struct xml_cache_stats {
+	size_t doc_hits, doc_misses, doc_evictions;
+	size_t doc_count, doc_mem;
+	size_t xpath_hits, xpath_misses;
+};
+
+/**
+ * Get the parsed document, parse it if it isn't cached.
+ * The document is locked until it's released by xml_cache_doc_put().
+ * @return the document or NULL if the file can't be parsed
+ */
+struct xml_cache_doc *xml_cache_doc_get(const char *path);
+
+/**
+ * Unlock and release a document obtained by xml_cache_doc_get().
+ */
+void xml_cache_doc_put(struct xml_cache_doc *doc);
+
+/**
+ * Get the compiled expression, compile it if it isn't cached.
+ * @return the expression or NULL if it can't be compiled
+ */
+struct xml_cache_xpath *xml_cache_xpath_get(const char *expr);
+
+/**
+ * Release an expression obtained by xml_cache_xpath_get().
+ */
+void xml_cache_xpath_put(struct xml_cache_xpath *xpath);
+
+void xml_cache_stats(struct xml_cache_stats *stats);
+
+/**
+ * Drop all the cached documents and expressions.
+ */
+void xml_cache_clear(void);
+
+#endif
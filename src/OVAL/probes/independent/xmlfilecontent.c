@@ -68,6 +68,7 @@
 #include <probe/option.h>
 #include <oval_fts.h>
 #include <common/debug_priv.h>
+#include "xmlfilecontent-cache.h"
 
 #define FILE_SEPARATOR '/'
 
@@ -92,9 +93,17 @@ void *probe_init(void)
 	return NULL;
 }
 
+void probe_reset(void *arg)
+{
+	(void)arg;
+	/* the files may change between the scans */
+	xml_cache_clear();
+}
+
 void probe_fini(void *arg)
 {
         (void)arg;
+	xml_cache_clear();
 	/* deinit libxml */
 	xmlCleanupParser();
 }
@@ -104,7 +113,8 @@ static int process_file(const char *path, const char *filename, void *arg)
 	struct pfdata *pfd = (struct pfdata *) arg;
 	int ret = 0, path_len, filename_len;
 	char *whole_path = NULL;
-	xmlDoc *doc = NULL;
+	struct xml_cache_doc *doc = NULL;
+	struct xml_cache_xpath *xpath = NULL;
 	xmlXPathContext *xpath_ctx = NULL;
 	xmlXPathObject *xpath_obj = NULL;
 	SEXP_t *item = NULL;
@@ -129,7 +139,7 @@ static int process_file(const char *path, const char *filename, void *arg)
 
 	/* evaluate xpath */
 
-	doc = xmlParseFile(whole_path);
+	doc = xml_cache_doc_get(whole_path);
 	if (doc == NULL) {
                 SEXP_t *msg;
                 msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "Can't parse '%s'.", whole_path);
@@ -141,7 +151,7 @@ static int process_file(const char *path, const char *filename, void *arg)
 		goto cleanup;
 	}
 
-	xpath_ctx = xmlXPathNewContext(doc);
+	xpath_ctx = xmlXPathNewContext(doc->doc);
 	if (xpath_ctx == NULL) {
                 SEXP_t *msg;
                 msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "xmlXPathNewContext() error.");
@@ -153,7 +163,9 @@ static int process_file(const char *path, const char *filename, void *arg)
 		goto cleanup;
 	}
 
-	xpath_obj = xmlXPathEvalExpression(BAD_CAST pfd->xpath, xpath_ctx);
+	xpath = xml_cache_xpath_get(pfd->xpath);
+	if (xpath != NULL)
+		xpath_obj = xmlXPathCompiledEval(xpath->comp, xpath_ctx);
 	if (xpath_obj == NULL) {
                 SEXP_t *msg;
                 msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "xmlXPathEvalExpression() error");
@@ -262,8 +274,10 @@ static int process_file(const char *path, const char *filename, void *arg)
 		xmlXPathFreeObject(xpath_obj);
 	if (xpath_ctx != NULL)
 		xmlXPathFreeContext(xpath_ctx);
+	if (xpath != NULL)
+		xml_cache_xpath_put(xpath);
 	if (doc != NULL)
-		xmlFreeDoc(doc);
+		xml_cache_doc_put(doc);
 	if (whole_path != NULL)
 		free(whole_path);
 
@@ -33,15 +33,16 @@
 #include <limits.h>
 #include <errno.h>
 #include <assume.h>
-#include <pcre.h>
 #include <libgen.h>
 
 #include "fsdev.h"
 #include "_probe-api.h"
 #include "probe/entcmp.h"
+#include "probe/fcache.h"
 #include "alloc.h"
 #include "debug_priv.h"
 #include "oval_fts.h"
+#include "oval_fts_walk.h"
 #if defined(__SVR4) && defined(__sun)
 #include "fts_sun.h"
 #include <sys/mntent.h>
@@ -71,6 +72,8 @@ static OVAL_FTS *OVAL_FTS_new()
 
 static void OVAL_FTS_free(OVAL_FTS *ofts)
 {
+	if (ofts->ofts_walk != NULL)
+		oval_fts_walk_close(ofts->ofts_walk);
 	if (ofts->ofts_match_path_fts != NULL)
 		fts_close(ofts->ofts_match_path_fts);
 	if (ofts->ofts_recurse_path_fts != NULL)
@@ -371,19 +374,19 @@ static char *extract_fixed_path_prefix(char *path)
 
 static int badpartial_check_slash(const char *pattern)
 {
-	pcre *regex;
+	struct oscap_pcre *regex;
 	const char *errptr = NULL;
 	int errofs = 0, fb, ret;
 
-	regex = pcre_compile(pattern + 1 /* skip '^' */, 0, &errptr, &errofs, NULL);
+	regex = oscap_pcre_compile(pattern + 1 /* skip '^' */, 0, &errptr, &errofs);
 	if (regex == NULL) {
 		dE("Failed to validate the pattern: pcre_compile(): "
 		   "error: '%s', error offset: %d, pattern: '%s'.\n",
 		   errofs, errptr, pattern);
 		return -1;
 	}
-	ret = pcre_fullinfo(regex, NULL, PCRE_INFO_FIRSTBYTE, &fb);
-	pcre_free(regex);
+	ret = oscap_pcre_fullinfo(regex, PCRE_INFO_FIRSTBYTE, &fb);
+	oscap_pcre_free(regex);
 	regex = NULL;
 	if (ret != 0) {
 		dE("Failed to validate the pattern: pcre_fullinfo(): "
@@ -403,7 +406,7 @@ static int badpartial_check_slash(const char *pattern)
 #define TEST_PATH1 "/"
 #define TEST_PATH2 "x"
 
-static int badpartial_transform_pattern(char *pattern, pcre **regex_out)
+static int badpartial_transform_pattern(char *pattern, struct oscap_pcre **regex_out)
 {
 	/*
 	  PCREPARTIAL(3)
@@ -428,7 +431,7 @@ static int badpartial_transform_pattern(char *pattern, pcre **regex_out)
 	const char *errptr = NULL;
 	char *s, *brkt_mark;
 	bool bracketed = false, found_regex = false;
-	pcre *regex;
+	struct oscap_pcre *regex;
 
 	/* The processing bellow builds upon the assumption that
 	   the pattern has been validated by pcre_compile() */
@@ -478,7 +481,7 @@ static int badpartial_transform_pattern(char *pattern, pcre **regex_out)
 	else
 		*s = '\0';
 
-	regex = pcre_compile(pattern, 0, &errptr, &errofs, NULL);
+	regex = oscap_pcre_compile(pattern, 0, &errptr, &errofs);
 	if (regex == NULL) {
 		dW("Nonfatal failure: can't transform the pattern for partial "
 		   "match optimization, error: '%s', error offset: %d, "
@@ -486,10 +489,10 @@ static int badpartial_transform_pattern(char *pattern, pcre **regex_out)
 		return -1;
 	}
 
-	ret = pcre_exec(regex, NULL, test_path1, strlen(test_path1), 0,
+	ret = oscap_pcre_exec(regex, test_path1, strlen(test_path1), 0,
 		PCRE_PARTIAL, NULL, 0);
 	if (ret != PCRE_ERROR_PARTIAL && ret < 0) {
-		pcre_free(regex);
+		oscap_pcre_free(regex);
 		dW("Nonfatal failure: can't transform the pattern for partial "
 		   "match optimization, pcre_exec() return code: %d, pattern: "
 		   "'%s'.", ret, pattern);
@@ -505,14 +508,14 @@ static int badpartial_transform_pattern(char *pattern, pcre **regex_out)
 /* Verify that the path is usable and try to craft a regex to speed up
    the filesystem traversal. If the path to match is ill-designed, an
    ugly heuristic is employed to obtain something meaningfull. */
-static int process_pattern_match(const char *path, pcre **regex_out)
+static int process_pattern_match(const char *path, struct oscap_pcre **regex_out)
 {
 	int ret, errofs = 0;
 	char *pattern;
 	const char *test_path1 = TEST_PATH1;
 	//const char *test_path2 = TEST_PATH2;
 	const char *errptr = NULL;
-	pcre *regex;
+	struct oscap_pcre *regex;
 
 	if (path[0] != '^') {
 		/* Matching has to have a fixed starting point and thus
@@ -530,7 +533,7 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 		pattern = strdup(path);
 	}
 
-	regex = pcre_compile(pattern, 0, &errptr, &errofs, NULL);
+	regex = oscap_pcre_compile(pattern, 0, &errptr, &errofs);
 	if (regex == NULL) {
 		dE("Failed to validate the pattern: pcre_compile(): "
 		   "error offset: %d, error: '%s', pattern: '%s'.\n",
@@ -538,7 +541,7 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 		free(pattern);
 		return -1;
 	}
-	ret = pcre_exec(regex, NULL, test_path1, strlen(test_path1), 0,
+	ret = oscap_pcre_exec(regex, test_path1, strlen(test_path1), 0,
 		PCRE_PARTIAL, NULL, 0);
 
 	switch (ret) {
@@ -554,14 +557,14 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 
 		dI("pcre_exec() returned PCRE_ERROR_PARTIAL for pattern '%s' "
 		   "and test path '%s'.\n", pattern, test_path1);
-		ret = pcre_exec(regex, NULL, test_path2, strlen(test_path2),
+		ret = oscap_pcre_exec(regex, test_path2, strlen(test_path2),
 			0, PCRE_PARTIAL, NULL, 0);
 		if (ret == PCRE_ERROR_PARTIAL || ret >= 0) {
 			dE("Failed to validate the pattern: test path '%s' "
 			   "matched by pattern '%s' - the pattern is too "
 			   "general, i.e. inefficient. This could take a "
 			   "lifetime to complete.\n", test_path2, pattern);
-			pcre_free(regex);
+			oscap_pcre_free(regex);
 			free(pattern);
 			return -2;
 		}
@@ -571,7 +574,7 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 		dI("pcre_exec() returned PCRE_ERROR_BADPARTIAL for pattern "
 		   "'%s' and a test path '%s'. Falling back to "
 		   "pcre_fullinfo().\n", pattern, test_path1);
-		pcre_free(regex);
+		oscap_pcre_free(regex);
 		regex = NULL;
 
 		/* Fallback to first byte check to determin if
@@ -595,7 +598,7 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 		   "PCRE_ERROR_NOMATCH for pattern '%s' and a test path '%s'. "
 		   "This indicates the pattern doesn't match a leading '/'.\n",
 		   pattern, test_path1);
-		pcre_free(regex);
+		oscap_pcre_free(regex);
 		free(pattern);
 		return -2;
 	default:
@@ -609,14 +612,14 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 			   their OVAL definitions that use ".*" as
 			   'path' and then uncomment this.
 
-			ret = pcre_exec(regex, NULL, test_path2, strlen(test_path2),
+			ret = oscap_pcre_exec(regex, test_path2, strlen(test_path2),
 					0, PCRE_PARTIAL, NULL, 0);
 			if (ret == PCRE_ERROR_PARTIAL || ret >= 0) {
 				dE("Failed to validate the pattern: test path '%s' "
 				   "matched by pattern '%s' - the pattern is too "
 				   "general, i.e. inefficient. This could take a "
 				   "lifetime to complete.\n", test_path2, pattern);
-				pcre_free(regex);
+				oscap_pcre_free(regex);
 				free(pattern);
 				return -2;
 			}
@@ -627,7 +630,7 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 		dE("Failed to validate the pattern: pcre_exec() return "
 		   "code: %d, pattern '%s', test path '%s'.\n", ret,
 		   pattern, test_path1);
-		pcre_free(regex);
+		oscap_pcre_free(regex);
 		free(pattern);
 		return -1;
 	}
@@ -669,8 +672,9 @@ OVAL_FTS *oval_fts_open(SEXP_t *path, SEXP_t *filename, SEXP_t *filepath, SEXP_t
 	int filesystem  = -1;
 
 	uint32_t path_op;
+	int walk_threads = 0;
 	bool nilfilename = false;
-	pcre *regex = NULL;
+	struct oscap_pcre *regex = NULL;
 	struct stat st;
 
 	assume_d((path == NULL && filename == NULL && filepath != NULL)
@@ -793,6 +797,20 @@ OVAL_FTS *oval_fts_open(SEXP_t *path, SEXP_t *filename, SEXP_t *filepath, SEXP_t
 #endif
 	SEXP_free(r0);
 
+#if !(defined(__SVR4) && defined(__sun)) && !defined(_AIX)
+	/* number of threads traversing the directories below a path */
+	const char *walk_env = getenv("OSCAP_PROBE_FTS_THREADS");
+	if (walk_env != NULL) {
+		char *end;
+		long n = strtol(walk_env, &end, 10);
+
+		if (*end != '\0' || n < 0 || n > OVAL_FTS_WALK_MAX_THREADS)
+			dW("Invalid OSCAP_PROBE_FTS_THREADS value: %s", walk_env);
+		else
+			walk_threads = (int) n;
+	}
+#endif
+
 	/* todo:
 	   Still missing is a propagation of the error to the
 	   user. Currently, all the information is provided in the
@@ -813,12 +831,13 @@ OVAL_FTS *oval_fts_open(SEXP_t *path, SEXP_t *filename, SEXP_t *filepath, SEXP_t
 
 	/* Fail if the provided path doensn't actually exist. Symlinks
 	   without targets are accepted. */
-	if (lstat(paths[0], &st) == -1) {
+	if (probe_fcache_lstat(paths[0], &st) == -1) {
 		if (errno) {
 			dD("lstat() failed: errno: %d, '%s'.",
 			   errno, strerror(errno));
 		}
 		free((void *) paths[0]);
+		oscap_pcre_free(regex);
 		return NULL;
 	}
 
@@ -834,17 +853,13 @@ OVAL_FTS *oval_fts_open(SEXP_t *path, SEXP_t *filename, SEXP_t *filepath, SEXP_t
 	if (ofts->ofts_match_path_fts == NULL || errno != 0) {
 		dE("fts_open() failed, errno: %d \"%s\".", errno, strerror(errno));
 		OVAL_FTS_free(ofts);
+		oscap_pcre_free(regex);
 		return (NULL);
 	}
 
 	ofts->ofts_recurse_path_fts_opts = rec_fts_options;
 	ofts->ofts_path_op = path_op;
-	if (regex != NULL) {
-		const char *errptr = NULL;
-
-		ofts->ofts_path_regex = regex;
-		ofts->ofts_path_regex_extra = pcre_study(regex, 0, &errptr);
-	}
+	ofts->ofts_path_regex = regex;
 
 	if (filesystem == OVAL_RECURSE_FS_LOCAL) {
 #if   defined(__SVR4) && defined(__sun)
@@ -882,6 +897,8 @@ OVAL_FTS *oval_fts_open(SEXP_t *path, SEXP_t *filename, SEXP_t *filepath, SEXP_t
 
 		ofts->max_depth = max_depth;
 		ofts->direction = direction;
+		if (direction == OVAL_RECURSE_DIRECTION_DOWN && walk_threads > 1)
+			ofts->ofts_walk_threads = walk_threads;
 	} else { /* filepath != NULL */
 		ofts->ofts_sfilepath = SEXP_ref(filepath);
 	}
@@ -968,7 +985,7 @@ static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 		if (ofts->ofts_path_regex != NULL && fts_ent->fts_info == FTS_D) {
 			int ret, svec[3];
 
-			ret = pcre_exec(ofts->ofts_path_regex, ofts->ofts_path_regex_extra,
+			ret = oscap_pcre_exec(ofts->ofts_path_regex,
 					fts_ent->fts_path, fts_ent->fts_pathlen, 0, PCRE_PARTIAL,
 					svec, sizeof(svec) / sizeof(svec[0]));
 			if (ret < 0) {
@@ -1287,9 +1304,36 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 	return out_fts_ent;
 }
 
+/* find the next matching file or directory using the parallel traversal */
+static OVAL_FTSENT *oval_fts_read_walk(OVAL_FTS *ofts)
+{
+	OVAL_FTSENT *ofts_ent;
+
+	if (ofts->ofts_walk == NULL) {
+		FTSENT *fts_ent = ofts->ofts_match_path_fts_ent;
+
+		ofts->ofts_walk = oval_fts_walk_open(ofts, fts_ent->fts_path,
+			fts_ent->fts_statp, ofts->ofts_walk_threads);
+		if (ofts->ofts_walk == NULL) {
+			dE("Can't start the traversal of '%s'.", fts_ent->fts_path);
+			return NULL;
+		}
+	}
+
+	ofts_ent = oval_fts_walk_read(ofts->ofts_walk);
+	if (ofts_ent == NULL) {
+		if (oval_fts_walk_close(ofts->ofts_walk) != 0)
+			probe_cobj_set_flag(ofts->result, SYSCHAR_FLAG_ERROR);
+		ofts->ofts_walk = NULL;
+	}
+
+	return ofts_ent;
+}
+
 OVAL_FTSENT *oval_fts_read(OVAL_FTS *ofts)
 {
 	FTSENT *fts_ent;
+	OVAL_FTSENT *ofts_ent;
 
 #if defined(OSCAP_FTS_DEBUG)
 	dI("ofts: %p.", ofts);
@@ -1310,9 +1354,15 @@ OVAL_FTSENT *oval_fts_read(OVAL_FTS *ofts)
 			ofts->ofts_match_path_fts_ent = NULL;
 			break;
 		} else {
-			fts_ent = oval_fts_read_recurse_path(ofts);
-			if (fts_ent != NULL)
-				break;
+			if (ofts->ofts_walk_threads > 1) {
+				ofts_ent = oval_fts_read_walk(ofts);
+				if (ofts_ent != NULL)
+					return ofts_ent;
+			} else {
+				fts_ent = oval_fts_read_recurse_path(ofts);
+				if (fts_ent != NULL)
+					break;
+			}
 
 			ofts->ofts_match_path_fts_ent = NULL;
 
@@ -1336,10 +1386,7 @@ int oval_fts_close(OVAL_FTS *ofts)
 	if (ofts->ofts_recurse_path_pthcpy != NULL)
 		free(ofts->ofts_recurse_path_pthcpy);
 
-	if (ofts->ofts_path_regex)
-		pcre_free(ofts->ofts_path_regex);
-	if (ofts->ofts_path_regex_extra)
-		pcre_free(ofts->ofts_path_regex_extra);
+	oscap_pcre_free(ofts->ofts_path_regex);
 
 	if (ofts->ofts_spath != NULL)
 		SEXP_free(ofts->ofts_spath);
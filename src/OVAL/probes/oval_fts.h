@@ -28,7 +28,7 @@
 #else
 #include <fts.h>
 #endif
-#include <pcre.h>
+#include "oscap_pcre.h"
 #include "fsdev.h"
 
 #define ENT_GET_AREF(ent, dst, attr_name, mandatory)			\
@@ -75,9 +75,11 @@ typedef struct {
 	char *ofts_recurse_path_pthcpy;
 	char *ofts_recurse_path_curpth;
 	dev_t ofts_recurse_path_devid;
+	/* parallel directory traversal of the downward recursion */
+	struct oval_fts_walk *ofts_walk;
+	int ofts_walk_threads;
 
-	pcre       *ofts_path_regex;
-	pcre_extra *ofts_path_regex_extra;
+	struct oscap_pcre *ofts_path_regex;
 	uint32_t ofts_path_op;
 
 	SEXP_t *ofts_spath;
@@ -0,0 +1,812 @@
+/*
+ * Copyright 2010 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+#include "_probe-api.h"
+#include "probe/entcmp.h"
+#include "oscap_pcre.h"
+#include "debug_priv.h"
+#include "../results/oval_cmp_basic_impl.h"
+#include "fsdev.h"
+#include "oval_fts_walk.h"
+
+#if defined(__linux__) && defined(SYS_getdents64)
+#define OVAL_FTS_WALK_GETDENTS 1
+#endif
+
+#ifndef DT_UNKNOWN
+#define DT_UNKNOWN 0
+#endif
+
+/* size of the getdents64() buffer of a thread */
+#define WALK_DENTS_SIZE (32 * 1024)
+/* number of entries a thread collects before passing them to the reader */
+#define WALK_BATCH_MAX  64
+/* number of entries waiting for the reader */
+#define WALK_OUT_MAX    4096
+
+struct walk_dir {
+	struct walk_dir *parent; /* the ancestors are kept for cycle detection */
+	unsigned int refs;       /* the directory itself and its queued subdirectories */
+	dev_t dev;
+	ino_t ino;
+	int level;
+	size_t path_len;
+	char path[];
+};
+
+struct walk_thread {
+	pthread_t tid;
+	oval_fts_walk_t *walk;
+	/* directories to read; the thread takes them from the end,
+	   the other threads from the beginning */
+	pthread_mutex_t lock;
+	struct walk_dir **dirs;
+	size_t head, count, size;
+	/* subdirectories of the directory being read */
+	struct walk_dir **subdirs;
+	size_t subdir_count, subdir_size;
+	/* entries not passed to the reader yet */
+	OVAL_FTSENT *batch[WALK_BATCH_MAX];
+	size_t batch_count;
+	char *path;
+	size_t path_size;
+#if defined(OVAL_FTS_WALK_GETDENTS)
+	char dents[WALK_DENTS_SIZE];
+#endif
+};
+
+struct oval_fts_walk {
+	OVAL_FTS *ofts;
+	bool collect_dirs;
+
+	/* a filename entity with a single string value is compared
+	   without building an S-expression for every entry */
+	bool name_direct;
+	char *name_value;
+	oval_operation_t name_op;
+	struct oscap_pcre *name_regex;
+
+	pthread_mutex_t lock;
+	pthread_cond_t work_cond;  /* directories were queued or the walk is over */
+	pthread_cond_t out_cond;   /* entries were queued or the walk is over */
+	pthread_cond_t space_cond; /* entries were taken by the reader */
+	uint64_t gen;              /* incremented when directories are queued */
+	size_t pending;            /* directories queued or being read */
+	bool abort;
+
+	OVAL_FTSENT **out;
+	size_t out_head, out_count;
+
+	unsigned int cmp_errors;
+
+	struct walk_thread *thr;
+	int thr_cnt;
+	int thr_started;
+};
+
+#if defined(OVAL_FTS_WALK_GETDENTS)
+struct walk_dirent64 {
+	uint64_t d_ino;
+	int64_t d_off;
+	unsigned short d_reclen;
+	unsigned char d_type;
+	char d_name[];
+};
+#endif
+
+static struct walk_dir *walk_dir_new(const char *path, size_t path_len, int level, const struct stat *st, struct walk_dir *parent)
+{
+	struct walk_dir *dir;
+
+	dir = malloc(sizeof(struct walk_dir) + path_len + 1);
+	if (dir == NULL)
+		return NULL;
+
+	dir->parent = parent;
+	dir->refs = 1;
+	dir->dev = st->st_dev;
+	dir->ino = st->st_ino;
+	dir->level = level;
+	dir->path_len = path_len;
+	memcpy(dir->path, path, path_len);
+	dir->path[path_len] = '\0';
+
+	return dir;
+}
+
+/* must be called with walk->lock held once the walk has started */
+static void walk_dir_put(struct walk_dir *dir)
+{
+	while (dir != NULL && --dir->refs == 0) {
+		struct walk_dir *parent = dir->parent;
+
+		free(dir);
+		dir = parent;
+	}
+}
+
+static bool walk_dir_cycle(struct walk_dir *dir, const struct stat *st)
+{
+	for (; dir != NULL; dir = dir->parent) {
+		if (dir->dev == st->st_dev && dir->ino == st->st_ino)
+			return true;
+	}
+
+	return false;
+}
+
+static OVAL_FTSENT *walk_ent_new(oval_fts_walk_t *walk, const char *path, size_t path_len, size_t name_len, unsigned int info)
+{
+	OVAL_FTSENT *ofts_ent;
+
+	ofts_ent = malloc(sizeof(OVAL_FTSENT));
+	if (ofts_ent == NULL)
+		return NULL;
+
+	ofts_ent->fts_info = info;
+	if (walk->collect_dirs) {
+		ofts_ent->path_len = path_len;
+		ofts_ent->path = strndup(path, path_len);
+		ofts_ent->file_len = -1;
+		ofts_ent->file = NULL;
+	} else {
+		/* the same split as pathlen_from_ftse() in oval_fts.c */
+		ofts_ent->path_len = path_len - name_len;
+		if (ofts_ent->path_len > 1)
+			ofts_ent->path_len--;
+		ofts_ent->path = strndup(path, ofts_ent->path_len);
+		ofts_ent->file_len = name_len;
+		ofts_ent->file = strndup(path + path_len - name_len, name_len);
+	}
+
+	return ofts_ent;
+}
+
+static void walk_ent_free(OVAL_FTSENT *ofts_ent)
+{
+	free(ofts_ent->path);
+	free(ofts_ent->file);
+	free(ofts_ent);
+}
+
+/* must be called with walk->lock held */
+static void walk_flush(struct walk_thread *thr)
+{
+	oval_fts_walk_t *walk = thr->walk;
+	size_t i;
+
+	for (i = 0; i < thr->batch_count; ++i) {
+		while (!walk->abort && walk->out_count == WALK_OUT_MAX)
+			pthread_cond_wait(&walk->space_cond, &walk->lock);
+
+		if (walk->abort) {
+			walk_ent_free(thr->batch[i]);
+			continue;
+		}
+
+		walk->out[(walk->out_head + walk->out_count) % WALK_OUT_MAX] = thr->batch[i];
+		walk->out_count++;
+	}
+
+	if (thr->batch_count > 0)
+		pthread_cond_signal(&walk->out_cond);
+
+	thr->batch_count = 0;
+}
+
+static void walk_emit(struct walk_thread *thr, const char *path, size_t path_len, size_t name_len, unsigned int info)
+{
+	oval_fts_walk_t *walk = thr->walk;
+	OVAL_FTSENT *ofts_ent;
+
+	ofts_ent = walk_ent_new(walk, path, path_len, name_len, info);
+	if (ofts_ent == NULL)
+		return;
+
+	if (thr->batch_count == WALK_BATCH_MAX) {
+		pthread_mutex_lock(&walk->lock);
+		walk_flush(thr);
+		pthread_mutex_unlock(&walk->lock);
+	}
+
+	thr->batch[thr->batch_count++] = ofts_ent;
+}
+
+static bool walk_wanted(struct walk_thread *thr, const char *name, int level, unsigned int info)
+{
+	oval_fts_walk_t *walk = thr->walk;
+	OVAL_FTS *ofts = walk->ofts;
+
+	if (walk->collect_dirs) {
+		return (info == FTS_D
+		        && (ofts->max_depth == -1 || level <= ofts->max_depth));
+	}
+
+	if (info == FTS_D)
+		return false;
+
+	oval_result_t result;
+
+	if (walk->name_regex != NULL) {
+		/* the same as oval_string_cmp() with a precompiled pattern */
+		int ret = oscap_pcre_exec(walk->name_regex, name, strlen(name), 0, 0, NULL, 0);
+
+		if (ret > -1) {
+			result = OVAL_RESULT_TRUE;
+		} else if (ret == -1) {
+			result = OVAL_RESULT_FALSE;
+		} else {
+			dE("Unable to match regex pattern, "
+			   "pcre_exec() returned error: %d.", ret);
+			result = OVAL_RESULT_ERROR;
+		}
+	} else if (walk->name_direct) {
+		result = oval_string_cmp(walk->name_value, name, walk->name_op);
+	} else {
+		SEXP_t *stmp = SEXP_string_newf("%s", name);
+		result = probe_entobj_cmp(ofts->ofts_sfilename, stmp);
+		SEXP_free(stmp);
+	}
+
+	if (result == OVAL_RESULT_ERROR) {
+		pthread_mutex_lock(&walk->lock);
+		walk->cmp_errors++;
+		pthread_mutex_unlock(&walk->lock);
+	}
+
+	return (result == OVAL_RESULT_TRUE);
+}
+
+/* find out whether the filename entity can be compared directly */
+static void walk_name_prepare(oval_fts_walk_t *walk)
+{
+	SEXP_t *ent = walk->ofts->ofts_sfilename;
+	SEXP_t *vals = NULL, *val, *stmp;
+	oval_operation_t op;
+	const char *err;
+	int errofs;
+
+	if (probe_ent_attrexists(ent, "var_ref")
+	    || probe_ent_getdatatype(ent) != OVAL_DATATYPE_STRING)
+		return;
+
+	if (probe_ent_getvals(ent, &vals) != 1) {
+		SEXP_free(vals);
+		return;
+	}
+	val = SEXP_list_first(vals);
+	SEXP_free(vals);
+	if (val == NULL || !SEXP_stringp(val)) {
+		SEXP_free(val);
+		return;
+	}
+
+	stmp = probe_ent_getattrval(ent, "operation");
+	if (stmp == NULL) {
+		op = OVAL_OPERATION_EQUALS;
+	} else {
+		op = SEXP_number_geti_32(stmp);
+		SEXP_free(stmp);
+	}
+
+	switch (op) {
+	case OVAL_OPERATION_EQUALS:
+	case OVAL_OPERATION_NOT_EQUAL:
+	case OVAL_OPERATION_CASE_INSENSITIVE_EQUALS:
+	case OVAL_OPERATION_CASE_INSENSITIVE_NOT_EQUAL:
+		walk->name_value = SEXP_string_cstr(val);
+		walk->name_op = op;
+		walk->name_direct = (walk->name_value != NULL);
+		break;
+	case OVAL_OPERATION_PATTERN_MATCH:
+		walk->name_value = SEXP_string_cstr(val);
+		if (walk->name_value != NULL) {
+			/* an invalid pattern is left to probe_entobj_cmp() to report */
+			walk->name_regex = oscap_pcre_compile(walk->name_value, PCRE_UTF8, &err, &errofs);
+		}
+		break;
+	default:
+		break;
+	}
+
+	SEXP_free(val);
+}
+
+/* the recurse_file_system check of directories and symlinks */
+static bool walk_fs_allowed(oval_fts_walk_t *walk, const struct stat *st)
+{
+	OVAL_FTS *ofts = walk->ofts;
+
+	switch (ofts->filesystem) {
+	case OVAL_RECURSE_FS_LOCAL:
+		return (fsdev_search(ofts->localdevs, (void *) &st->st_dev) == 1);
+	case OVAL_RECURSE_FS_DEFINED:
+		return (st->st_dev == ofts->ofts_recurse_path_devid);
+	}
+
+	return true;
+}
+
+static unsigned int walk_info(const struct stat *st)
+{
+	if (S_ISDIR(st->st_mode))
+		return FTS_D;
+	if (S_ISLNK(st->st_mode))
+		return FTS_SL;
+	if (S_ISREG(st->st_mode))
+		return FTS_F;
+	return FTS_DEFAULT;
+}
+
+/*
+ * Handle an entry of a directory the way oval_fts_read_recurse_path()
+ * handles the entries returned by fts_read(). st is NULL if the entry
+ * wasn't stat'ed yet, the directories always are.
+ */
+static void walk_visit(struct walk_thread *thr, struct walk_dir *dir, int dfd,
+                       const char *path, size_t path_len, size_t name_len,
+                       unsigned int info, const struct stat *st)
+{
+	oval_fts_walk_t *walk = thr->walk;
+	OVAL_FTS *ofts = walk->ofts;
+	const char *name = path + path_len - name_len;
+	int level = dir->level + 1;
+	struct stat sb;
+
+	if (info == FTS_D && walk_dir_cycle(dir, st)) {
+		dW("Filesystem tree cycle detected at '%s'.", path);
+		return;
+	}
+
+	if (walk_wanted(thr, name, level, info))
+		walk_emit(thr, path, path_len, name_len, info);
+
+	/* limit recursion depth */
+	if (ofts->max_depth != -1 && level > ofts->max_depth)
+		return;
+
+	/* limit recursion only to selected file types */
+	switch (info) {
+	case FTS_D:
+		if (!(ofts->recurse & OVAL_RECURSE_DIRS))
+			return;
+		break;
+	case FTS_SL:
+		if (!(ofts->recurse & OVAL_RECURSE_SYMLINKS))
+			return;
+		break;
+	default:
+		return;
+	}
+
+	if (st == NULL) {
+		if (fstatat(dfd, name, &sb, AT_SYMLINK_NOFOLLOW) != 0)
+			return;
+		st = &sb;
+	}
+
+	if (!walk_fs_allowed(walk, st))
+		return;
+
+	if (info == FTS_SL) {
+		/* like FTS_FOLLOW, the target is reported as well */
+		if (fstatat(dfd, name, &sb, 0) != 0)
+			walk_visit(thr, dir, dfd, path, path_len, name_len, FTS_SLNONE, st);
+		else
+			walk_visit(thr, dir, dfd, path, path_len, name_len, walk_info(&sb), &sb);
+		return;
+	}
+
+	if (thr->subdir_count == thr->subdir_size) {
+		size_t size = thr->subdir_size ? thr->subdir_size * 2 : 64;
+		struct walk_dir **subdirs = realloc(thr->subdirs, size * sizeof(struct walk_dir *));
+
+		if (subdirs == NULL)
+			return;
+		thr->subdirs = subdirs;
+		thr->subdir_size = size;
+	}
+
+	struct walk_dir *subdir = walk_dir_new(path, path_len, level, st, dir);
+	if (subdir != NULL)
+		thr->subdirs[thr->subdir_count++] = subdir;
+}
+
+static void walk_entry(struct walk_thread *thr, struct walk_dir *dir, int dfd,
+                       const char *name, unsigned char type)
+{
+	size_t name_len, prefix_len, path_len;
+	unsigned int info;
+	struct stat st;
+
+	if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+		return;
+
+	/* the child path is built the same way as by fts */
+	name_len = strlen(name);
+	prefix_len = dir->path_len;
+	if (prefix_len > 0 && dir->path[prefix_len - 1] == '/')
+		prefix_len--;
+	path_len = prefix_len + 1 + name_len;
+
+	if (path_len + 1 > thr->path_size) {
+		size_t size = path_len + 1 + 256;
+		char *path = realloc(thr->path, size);
+
+		if (path == NULL)
+			return;
+		thr->path = path;
+		thr->path_size = size;
+	}
+	memcpy(thr->path, dir->path, prefix_len);
+	thr->path[prefix_len] = '/';
+	memcpy(thr->path + prefix_len + 1, name, name_len + 1);
+
+	switch (type) {
+	case DT_UNKNOWN:
+	case DT_DIR:
+		if (fstatat(dfd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+			walk_visit(thr, dir, dfd, thr->path, path_len, name_len, FTS_NS, NULL);
+			return;
+		}
+		walk_visit(thr, dir, dfd, thr->path, path_len, name_len, walk_info(&st), &st);
+		return;
+#ifdef DT_LNK
+	case DT_LNK:
+		info = FTS_SL;
+		break;
+#endif
+#ifdef DT_REG
+	case DT_REG:
+		info = FTS_F;
+		break;
+#endif
+	default:
+		info = FTS_DEFAULT;
+		break;
+	}
+
+	/* files are only stat'ed when needed */
+	walk_visit(thr, dir, dfd, thr->path, path_len, name_len, info, NULL);
+}
+
+static void walk_dir_list(struct walk_thread *thr, struct walk_dir *dir)
+{
+	int dfd;
+
+	dfd = open(dir->path, O_RDONLY | O_DIRECTORY | O_NOCTTY | O_CLOEXEC);
+	if (dfd == -1) {
+		dD("Can't open directory '%s': %s.", dir->path, strerror(errno));
+		return;
+	}
+
+#if defined(OVAL_FTS_WALK_GETDENTS)
+	for (;;) {
+		long n, off;
+
+		n = syscall(SYS_getdents64, dfd, thr->dents, sizeof thr->dents);
+		if (n <= 0) {
+			if (n < 0)
+				dD("Can't read directory '%s': %s.", dir->path, strerror(errno));
+			break;
+		}
+
+		for (off = 0; off < n;) {
+			struct walk_dirent64 *d = (struct walk_dirent64 *) (thr->dents + off);
+
+			walk_entry(thr, dir, dfd, d->d_name, d->d_type);
+			off += d->d_reclen;
+		}
+	}
+	close(dfd);
+#else
+	DIR *d = fdopendir(dfd);
+	struct dirent *de;
+
+	if (d == NULL) {
+		close(dfd);
+		return;
+	}
+	while ((de = readdir(d)) != NULL) {
+#if defined(_DIRENT_HAVE_D_TYPE) || defined(DT_DIR)
+		walk_entry(thr, dir, dfd, de->d_name, de->d_type);
+#else
+		walk_entry(thr, dir, dfd, de->d_name, DT_UNKNOWN);
+#endif
+	}
+	closedir(d);
+#endif
+}
+
+/* take a directory from the thread's queue or from the queue of another thread */
+static struct walk_dir *walk_take(struct walk_thread *thr)
+{
+	oval_fts_walk_t *walk = thr->walk;
+	struct walk_dir *dir = NULL;
+	uint64_t gen;
+	int i;
+
+	for (;;) {
+		pthread_mutex_lock(&thr->lock);
+		if (thr->count > thr->head) {
+			dir = thr->dirs[--thr->count];
+			if (thr->count == thr->head)
+				thr->head = thr->count = 0;
+		}
+		pthread_mutex_unlock(&thr->lock);
+
+		if (dir != NULL)
+			return dir;
+
+		pthread_mutex_lock(&walk->lock);
+		gen = walk->gen;
+		if (walk->abort || walk->pending == 0) {
+			pthread_mutex_unlock(&walk->lock);
+			return NULL;
+		}
+		pthread_mutex_unlock(&walk->lock);
+
+		for (i = 1; i < walk->thr_cnt && dir == NULL; ++i) {
+			struct walk_thread *victim = &walk->thr[(thr - walk->thr + i) % walk->thr_cnt];
+
+			pthread_mutex_lock(&victim->lock);
+			if (victim->count > victim->head) {
+				dir = victim->dirs[victim->head++];
+				if (victim->count == victim->head)
+					victim->head = victim->count = 0;
+			}
+			pthread_mutex_unlock(&victim->lock);
+		}
+
+		if (dir != NULL)
+			return dir;
+
+		pthread_mutex_lock(&walk->lock);
+		while (!walk->abort && walk->pending > 0 && walk->gen == gen)
+			pthread_cond_wait(&walk->work_cond, &walk->lock);
+		pthread_mutex_unlock(&walk->lock);
+	}
+}
+
+/* pass the entries and the subdirectories of a read directory on */
+static void walk_dir_done(struct walk_thread *thr, struct walk_dir *dir)
+{
+	oval_fts_walk_t *walk = thr->walk;
+	size_t i;
+
+	pthread_mutex_lock(&walk->lock);
+	walk_flush(thr);
+
+	if (walk->abort) {
+		for (i = 0; i < thr->subdir_count; ++i)
+			free(thr->subdirs[i]);
+		thr->subdir_count = 0;
+	}
+
+	if (thr->subdir_count > 0) {
+		pthread_mutex_lock(&thr->lock);
+		if (thr->count + thr->subdir_count > thr->size) {
+			size_t size = thr->count + thr->subdir_count + 256;
+			struct walk_dir **dirs = realloc(thr->dirs, size * sizeof(struct walk_dir *));
+
+			if (dirs == NULL) {
+				dE("Can't queue %zu directories below '%s'.", thr->subdir_count, dir->path);
+				for (i = 0; i < thr->subdir_count; ++i)
+					free(thr->subdirs[i]);
+				thr->subdir_count = 0;
+			} else {
+				thr->dirs = dirs;
+				thr->size = size;
+			}
+		}
+		for (i = 0; i < thr->subdir_count; ++i)
+			thr->dirs[thr->count++] = thr->subdirs[i];
+		pthread_mutex_unlock(&thr->lock);
+
+		dir->refs += thr->subdir_count;
+		walk->pending += thr->subdir_count;
+		walk->gen++;
+		pthread_cond_broadcast(&walk->work_cond);
+		thr->subdir_count = 0;
+	}
+
+	walk_dir_put(dir);
+	if (--walk->pending == 0) {
+		pthread_cond_broadcast(&walk->work_cond);
+		pthread_cond_broadcast(&walk->out_cond);
+	}
+	pthread_mutex_unlock(&walk->lock);
+}
+
+static void *walk_thread(void *arg)
+{
+	struct walk_thread *thr = arg;
+	struct walk_dir *dir;
+
+	while ((dir = walk_take(thr)) != NULL) {
+		walk_dir_list(thr, dir);
+		walk_dir_done(thr, dir);
+	}
+
+	return NULL;
+}
+
+static void walk_free(oval_fts_walk_t *walk)
+{
+	int i;
+	size_t j;
+
+	for (i = 0; i < walk->thr_cnt; ++i) {
+		struct walk_thread *thr = &walk->thr[i];
+
+		for (j = thr->head; j < thr->count; ++j)
+			walk_dir_put(thr->dirs[j]);
+		free(thr->dirs);
+		free(thr->subdirs);
+		free(thr->path);
+		pthread_mutex_destroy(&thr->lock);
+	}
+
+	for (j = 0; j < walk->out_count; ++j)
+		walk_ent_free(walk->out[(walk->out_head + j) % WALK_OUT_MAX]);
+
+	pthread_cond_destroy(&walk->space_cond);
+	pthread_cond_destroy(&walk->out_cond);
+	pthread_cond_destroy(&walk->work_cond);
+	pthread_mutex_destroy(&walk->lock);
+	oscap_pcre_free(walk->name_regex);
+	free(walk->name_value);
+	free(walk->out);
+	free(walk->thr);
+	free(walk);
+}
+
+oval_fts_walk_t *oval_fts_walk_open(OVAL_FTS *ofts, const char *root, const struct stat *root_st, int threads)
+{
+	oval_fts_walk_t *walk;
+	struct walk_dir *dir;
+	int i;
+
+	if (threads < 1)
+		threads = 1;
+	if (threads > OVAL_FTS_WALK_MAX_THREADS)
+		threads = OVAL_FTS_WALK_MAX_THREADS;
+
+	walk = calloc(1, sizeof(oval_fts_walk_t));
+	if (walk == NULL)
+		return NULL;
+
+	walk->ofts = ofts;
+	/* the condition below is correct because ofts_sfilepath is NULL here */
+	walk->collect_dirs = (ofts->ofts_sfilename == NULL);
+	if (!walk->collect_dirs)
+		walk_name_prepare(walk);
+	pthread_mutex_init(&walk->lock, NULL);
+	pthread_cond_init(&walk->work_cond, NULL);
+	pthread_cond_init(&walk->out_cond, NULL);
+	pthread_cond_init(&walk->space_cond, NULL);
+	walk->out = malloc(WALK_OUT_MAX * sizeof(OVAL_FTSENT *));
+	walk->thr = calloc(threads, sizeof(struct walk_thread));
+	if (walk->out == NULL || walk->thr == NULL) {
+		walk_free(walk);
+		return NULL;
+	}
+	for (i = 0; i < threads; ++i) {
+		walk->thr[i].walk = walk;
+		pthread_mutex_init(&walk->thr[i].lock, NULL);
+	}
+	walk->thr_cnt = threads;
+
+	/* the root itself is a target when collecting directories */
+	if (walk->collect_dirs) {
+		walk->out[0] = walk_ent_new(walk, root, strlen(root), 0, FTS_D);
+		if (walk->out[0] != NULL)
+			walk->out_count = 1;
+	}
+
+	if (!walk_fs_allowed(walk, root_st))
+		return walk;
+
+	dir = walk_dir_new(root, strlen(root), 0, root_st, NULL);
+	if (dir == NULL)
+		return walk;
+
+	walk->thr[0].dirs = malloc(256 * sizeof(struct walk_dir *));
+	if (walk->thr[0].dirs == NULL) {
+		free(dir);
+		return walk;
+	}
+	walk->thr[0].size = 256;
+	walk->thr[0].dirs[walk->thr[0].count++] = dir;
+	walk->pending = 1;
+
+	/* the queues of threads which fail to start stay empty */
+	for (i = 0; i < walk->thr_cnt; ++i) {
+		if ((errno = pthread_create(&walk->thr[i].tid, NULL, walk_thread, &walk->thr[i])) != 0) {
+			dE("Can't start a directory traversal thread: %s.", strerror(errno));
+			break;
+		}
+		walk->thr_started++;
+	}
+
+	if (walk->thr_started == 0) {
+		walk_free(walk);
+		return NULL;
+	}
+
+	return walk;
+}
+
+OVAL_FTSENT *oval_fts_walk_read(oval_fts_walk_t *walk)
+{
+	OVAL_FTSENT *ofts_ent = NULL;
+
+	pthread_mutex_lock(&walk->lock);
+	while (walk->out_count == 0 && walk->pending > 0)
+		pthread_cond_wait(&walk->out_cond, &walk->lock);
+
+	if (walk->out_count > 0) {
+		ofts_ent = walk->out[walk->out_head];
+		walk->out_head = (walk->out_head + 1) % WALK_OUT_MAX;
+		walk->out_count--;
+		pthread_cond_signal(&walk->space_cond);
+	}
+	pthread_mutex_unlock(&walk->lock);
+
+	return ofts_ent;
+}
+
+int oval_fts_walk_close(oval_fts_walk_t *walk)
+{
+	int i, ret;
+
+	pthread_mutex_lock(&walk->lock);
+	walk->abort = true;
+	pthread_cond_broadcast(&walk->work_cond);
+	pthread_cond_broadcast(&walk->space_cond);
+	pthread_mutex_unlock(&walk->lock);
+
+	for (i = 0; i < walk->thr_started; ++i)
+		pthread_join(walk->thr[i].tid, NULL);
+
+	ret = walk->cmp_errors > 0 ? -1 : 0;
+	walk_free(walk);
+
+	return ret;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2010 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#ifndef OVAL_FTS_WALK_H
+#define OVAL_FTS_WALK_H
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "oval_fts.h"
+
+/*
+ * Parallel directory traversal
+ *
+ * An alternative to fts(3) for the downward recursion of oval_fts_read().
+ * The directories below the root are read by a pool of threads. Each thread
+ * reads the directories found by itself first and takes directories from
+ * the queues of the other threads when its own queue is empty. The entries
+ * the object asks for are passed to the reading thread through a bounded
+ * queue, in no particular order.
+ *
+ * The walk follows the rules of the fts(3) based recursion: max_depth,
+ * recurse, recurse_file_system, symlinks and cycle detection.
+ */
+#define OVAL_FTS_WALK_MAX_THREADS 64
+
+typedef struct oval_fts_walk oval_fts_walk_t;
+
+/**
+ * Start a walk of the directory tree below root.
+ * @param ofts the OVAL_FTS which the walk belongs to
+ * @param root path of the root directory
+ * @param root_st status of the root directory
+ * @param threads number of threads reading the directories
+ */
+oval_fts_walk_t *oval_fts_walk_open(OVAL_FTS *ofts, const char *root, const struct stat *root_st, int threads);
+
+/**
+ * Get the next entry found by the walk, waits for the threads if needed.
+ * @return the entry or NULL when the whole tree has been traversed
+ */
+OVAL_FTSENT *oval_fts_walk_read(oval_fts_walk_t *walk);
+
+/**
+ * Stop the walk and free it.
+ * @return -1 if a filename couldn't be compared with the filename entity, 0 otherwise
+ */
+int oval_fts_walk_close(oval_fts_walk_t *walk);
+
+#endif /* OVAL_FTS_WALK_H */
@@ -0,0 +1,40 @@
+/**
+ * @file   batch.c
+ * @brief  file containg the dummy probe_main_batch function
+ */
+
+/*
+ * Copyright 2009 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <probe-api.h>
+
+/**
+ * Dummy probe_main_batch function.
+ * The objects of a batch request are evaluated one by one
+ * using probe_main.
+ */
+int probe_main_batch(probe_ctx *ctx[], int ret[], size_t count, void *arg)
+{
+	return (PROBE_EOPNOTSUPP);
+}
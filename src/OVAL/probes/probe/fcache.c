@@ -0,0 +1,441 @@
+/*
+ * Copyright 2011 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#if defined(__linux__)
+#include <sys/xattr.h>
+#endif
+
+#include "common/debug_priv.h"
+#include "fcache.h"
+
+#define PROBE_FCACHE_HSIZE 4099
+
+/* What is cached for a file */
+#define FCACHE_LSTAT  0x01
+#define FCACHE_STAT   0x02
+#define FCACHE_ACL    0x04
+#define FCACHE_XATTRS 0x08
+
+struct probe_fcache_xattr {
+	char    *value;
+	ssize_t  size;  /* -1 if lgetxattr() failed */
+	int      error;
+};
+
+struct probe_fcache_ent {
+	char *path;
+	unsigned int hash;
+	unsigned int flags;
+
+	struct stat lst;
+	int lst_error;
+	struct stat st;
+	int st_error;
+	int acl;
+	int acl_error;
+
+	char *xattr_list;                  /* names separated by '\0' */
+	ssize_t xattr_list_size;           /* -1 if llistxattr() failed */
+	int xattr_error;
+	struct probe_fcache_xattr *xattrs; /* values, in the order of the names */
+
+	struct probe_fcache_ent *hnext;      /* hash chain */
+	struct probe_fcache_ent *prev, *next; /* LRU list, most recently used first */
+};
+
+static struct {
+	pthread_mutex_t lock;
+	struct probe_fcache_ent *table[PROBE_FCACHE_HSIZE];
+	struct probe_fcache_ent *head, *tail;
+	size_t count;
+	size_t hits, misses;
+} probe_fcache = {
+	.lock = PTHREAD_MUTEX_INITIALIZER
+};
+
+static unsigned int probe_fcache_hash(const char *path)
+{
+	unsigned int h = 2166136261u;
+
+	while (*path != '\0') {
+		h ^= (unsigned char)*path++;
+		h *= 16777619u;
+	}
+
+	return h;
+}
+
+static void probe_fcache_xattrs_free(char *list, ssize_t size, struct probe_fcache_xattr *xattrs)
+{
+	size_t i, n = 0;
+
+	if (xattrs != NULL) {
+		for (i = 0; i < (size_t)size; i += strlen(list + i) + 1)
+			free(xattrs[n++].value);
+		free(xattrs);
+	}
+	free(list);
+}
+
+static void probe_fcache_ent_free(struct probe_fcache_ent *ent)
+{
+	probe_fcache_xattrs_free(ent->xattr_list, ent->xattr_list_size, ent->xattrs);
+	free(ent->path);
+	free(ent);
+}
+
+/* The functions below have to be called with the cache lock held */
+
+static void probe_fcache_lru_unlink(struct probe_fcache_ent *ent)
+{
+	if (ent->prev != NULL)
+		ent->prev->next = ent->next;
+	else
+		probe_fcache.head = ent->next;
+	if (ent->next != NULL)
+		ent->next->prev = ent->prev;
+	else
+		probe_fcache.tail = ent->prev;
+
+	ent->prev = ent->next = NULL;
+}
+
+static void probe_fcache_lru_push(struct probe_fcache_ent *ent)
+{
+	ent->prev = NULL;
+	ent->next = probe_fcache.head;
+	if (ent->next != NULL)
+		ent->next->prev = ent;
+	else
+		probe_fcache.tail = ent;
+	probe_fcache.head = ent;
+}
+
+static void probe_fcache_evict(struct probe_fcache_ent *ent)
+{
+	struct probe_fcache_ent **ep = &probe_fcache.table[ent->hash % PROBE_FCACHE_HSIZE];
+
+	while (*ep != ent)
+		ep = &(*ep)->hnext;
+	*ep = ent->hnext;
+
+	probe_fcache_lru_unlink(ent);
+	--probe_fcache.count;
+	probe_fcache_ent_free(ent);
+}
+
+/*
+ * Find the cached file, count a hit if it has the requested data or a miss
+ * otherwise. A missing entry is created if create is set.
+ */
+static struct probe_fcache_ent *probe_fcache_lookup(const char *path, unsigned int what, bool create)
+{
+	unsigned int hash = probe_fcache_hash(path);
+	struct probe_fcache_ent *ent;
+
+	for (ent = probe_fcache.table[hash % PROBE_FCACHE_HSIZE]; ent != NULL; ent = ent->hnext) {
+		if (ent->hash == hash && strcmp(ent->path, path) == 0)
+			break;
+	}
+
+	if (ent != NULL) {
+		if (ent != probe_fcache.head) {
+			probe_fcache_lru_unlink(ent);
+			probe_fcache_lru_push(ent);
+		}
+	} else if (create) {
+		while (probe_fcache.count >= PROBE_FCACHE_MAX)
+			probe_fcache_evict(probe_fcache.tail);
+
+		ent = calloc(1, sizeof(struct probe_fcache_ent));
+		ent->path = strdup(path);
+		ent->hash = hash;
+		ent->hnext = probe_fcache.table[hash % PROBE_FCACHE_HSIZE];
+		probe_fcache.table[hash % PROBE_FCACHE_HSIZE] = ent;
+		probe_fcache_lru_push(ent);
+		++probe_fcache.count;
+	}
+
+	if (!create) {
+		if (ent != NULL && (ent->flags & what))
+			++probe_fcache.hits;
+		else
+			++probe_fcache.misses;
+	}
+
+	return ent;
+}
+
+static int probe_fcache_stat_common(const char *path, struct stat *st, unsigned int what)
+{
+	struct probe_fcache_ent *ent;
+	struct stat sb;
+	int ret, error;
+
+	pthread_mutex_lock(&probe_fcache.lock);
+	ent = probe_fcache_lookup(path, what, false);
+	if (ent != NULL && (ent->flags & what)) {
+		memcpy(st, what == FCACHE_LSTAT ? &ent->lst : &ent->st, sizeof(struct stat));
+		error = what == FCACHE_LSTAT ? ent->lst_error : ent->st_error;
+		pthread_mutex_unlock(&probe_fcache.lock);
+		goto out;
+	}
+	pthread_mutex_unlock(&probe_fcache.lock);
+
+	/* Query the filesystem without holding the lock */
+	ret = what == FCACHE_LSTAT ? lstat(path, &sb) : stat(path, &sb);
+	error = ret == 0 ? 0 : errno;
+	if (ret != 0)
+		memset(&sb, 0, sizeof(sb));
+
+	pthread_mutex_lock(&probe_fcache.lock);
+	ent = probe_fcache_lookup(path, what, true);
+	if (what == FCACHE_LSTAT) {
+		ent->lst = sb;
+		ent->lst_error = error;
+	} else {
+		ent->st = sb;
+		ent->st_error = error;
+	}
+	ent->flags |= what;
+	pthread_mutex_unlock(&probe_fcache.lock);
+	memcpy(st, &sb, sizeof(struct stat));
+out:
+	if (error != 0) {
+		errno = error;
+		return -1;
+	}
+	return 0;
+}
+
+int probe_fcache_lstat(const char *path, struct stat *st)
+{
+	return probe_fcache_stat_common(path, st, FCACHE_LSTAT);
+}
+
+int probe_fcache_stat(const char *path, struct stat *st)
+{
+	return probe_fcache_stat_common(path, st, FCACHE_STAT);
+}
+
+int probe_fcache_acl_extended(const char *path, int (*acl_extended)(const char *path))
+{
+	struct probe_fcache_ent *ent;
+	int acl, error;
+
+	pthread_mutex_lock(&probe_fcache.lock);
+	ent = probe_fcache_lookup(path, FCACHE_ACL, false);
+	if (ent != NULL && (ent->flags & FCACHE_ACL)) {
+		acl = ent->acl;
+		error = ent->acl_error;
+		pthread_mutex_unlock(&probe_fcache.lock);
+		if (acl == -1)
+			errno = error;
+		return acl;
+	}
+	pthread_mutex_unlock(&probe_fcache.lock);
+
+	acl = acl_extended(path);
+	error = acl == -1 ? errno : 0;
+
+	pthread_mutex_lock(&probe_fcache.lock);
+	ent = probe_fcache_lookup(path, FCACHE_ACL, true);
+	ent->acl = acl;
+	ent->acl_error = error;
+	ent->flags |= FCACHE_ACL;
+	pthread_mutex_unlock(&probe_fcache.lock);
+
+	if (acl == -1)
+		errno = error;
+	return acl;
+}
+
+#if defined(__linux__)
+/* Read the names and the values of all the extended attributes of a file */
+static void probe_fcache_read_xattrs(const char *path, char **list_out, ssize_t *size_out,
+                                     int *error_out, struct probe_fcache_xattr **xattrs_out)
+{
+	struct probe_fcache_xattr *xattrs = NULL;
+	char *list = NULL;
+	ssize_t size;
+	size_t i, n;
+
+	for (;;) {
+		size = llistxattr(path, NULL, 0);
+		if (size <= 0)
+			break;
+		list = realloc(list, size);
+		size = llistxattr(path, list, size);
+		/* The attributes may have changed meanwhile */
+		if (size >= 0 || errno != ERANGE)
+			break;
+	}
+	if (size <= 0) {
+		*error_out = size < 0 ? errno : 0;
+		free(list);
+		list = NULL;
+	} else {
+		*error_out = 0;
+		for (i = n = 0; i < (size_t)size; i += strlen(list + i) + 1)
+			++n;
+		xattrs = calloc(n, sizeof(struct probe_fcache_xattr));
+		for (i = n = 0; i < (size_t)size; i += strlen(list + i) + 1, ++n) {
+			struct probe_fcache_xattr *xattr = &xattrs[n];
+
+			for (;;) {
+				xattr->size = lgetxattr(path, list + i, NULL, 0);
+				if (xattr->size < 0)
+					break;
+				xattr->value = realloc(xattr->value, xattr->size + 1);
+				xattr->size = lgetxattr(path, list + i, xattr->value, xattr->size);
+				if (xattr->size >= 0 || errno != ERANGE)
+					break;
+			}
+			if (xattr->size < 0) {
+				xattr->error = errno;
+				free(xattr->value);
+				xattr->value = NULL;
+			}
+		}
+	}
+
+	*list_out = list;
+	*size_out = size;
+	*xattrs_out = xattrs;
+}
+#endif
+
+/* Get the cached attributes of a file, read them on a miss; returns with the lock held */
+static struct probe_fcache_ent *probe_fcache_xattrs(const char *path)
+{
+	struct probe_fcache_ent *ent;
+
+	pthread_mutex_lock(&probe_fcache.lock);
+	ent = probe_fcache_lookup(path, FCACHE_XATTRS, false);
+	if (ent != NULL && (ent->flags & FCACHE_XATTRS))
+		return ent;
+	pthread_mutex_unlock(&probe_fcache.lock);
+
+	struct probe_fcache_xattr *xattrs = NULL;
+	char *list = NULL;
+	ssize_t size = -1;
+	int error = ENOTSUP;
+#if defined(__linux__)
+	probe_fcache_read_xattrs(path, &list, &size, &error, &xattrs);
+#endif
+
+	pthread_mutex_lock(&probe_fcache.lock);
+	ent = probe_fcache_lookup(path, FCACHE_XATTRS, true);
+	if (ent->flags & FCACHE_XATTRS) {
+		/* Read by another thread in the meantime */
+		probe_fcache_xattrs_free(list, size, xattrs);
+	} else {
+		ent->xattr_list = list;
+		ent->xattr_list_size = size;
+		ent->xattr_error = error;
+		ent->xattrs = xattrs;
+		ent->flags |= FCACHE_XATTRS;
+	}
+	return ent;
+}
+
+ssize_t probe_fcache_listxattr(const char *path, char *list, size_t size)
+{
+	struct probe_fcache_ent *ent = probe_fcache_xattrs(path);
+	ssize_t ret = ent->xattr_list_size;
+	int error = ent->xattr_error;
+
+	if (ret > 0 && size > 0) {
+		if ((size_t)ret > size) {
+			ret = -1;
+			error = ERANGE;
+		} else {
+			memcpy(list, ent->xattr_list, ret);
+		}
+	}
+	pthread_mutex_unlock(&probe_fcache.lock);
+
+	if (ret < 0)
+		errno = error;
+	return ret;
+}
+
+ssize_t probe_fcache_getxattr(const char *path, const char *name, void *value, size_t size)
+{
+	struct probe_fcache_ent *ent = probe_fcache_xattrs(path);
+	ssize_t ret = -1;
+	int error = ent->xattr_list_size < 0 ? ent->xattr_error : ENODATA;
+	size_t i, n;
+
+	for (i = n = 0; ent->xattr_list_size > 0 && i < (size_t)ent->xattr_list_size; i += strlen(ent->xattr_list + i) + 1, ++n) {
+		if (strcmp(ent->xattr_list + i, name) != 0)
+			continue;
+		ret = ent->xattrs[n].size;
+		error = ent->xattrs[n].error;
+		if (ret > 0 && size > 0) {
+			if ((size_t)ret > size) {
+				ret = -1;
+				error = ERANGE;
+			} else {
+				memcpy(value, ent->xattrs[n].value, ret);
+			}
+		}
+		break;
+	}
+	pthread_mutex_unlock(&probe_fcache.lock);
+
+	if (ret < 0)
+		errno = error;
+	return ret;
+}
+
+void probe_fcache_stats(size_t *hits, size_t *misses)
+{
+	pthread_mutex_lock(&probe_fcache.lock);
+	if (hits != NULL)
+		*hits = probe_fcache.hits;
+	if (misses != NULL)
+		*misses = probe_fcache.misses;
+	pthread_mutex_unlock(&probe_fcache.lock);
+}
+
+void probe_fcache_clear(void)
+{
+	pthread_mutex_lock(&probe_fcache.lock);
+	if (probe_fcache.hits + probe_fcache.misses > 0) {
+		dI("File metadata cache: %zu hits, %zu misses, %zu files.", probe_fcache.hits,
+		   probe_fcache.misses, probe_fcache.count);
+	}
+	while (probe_fcache.tail != NULL)
+		probe_fcache_evict(probe_fcache.tail);
+	probe_fcache.hits = probe_fcache.misses = 0;
+	pthread_mutex_unlock(&probe_fcache.lock);
+}
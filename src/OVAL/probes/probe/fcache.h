@@ -0,0 +1,84 @@
+/*
+ * Copyright 2011 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#ifndef PROBE_FCACHE_H
+#define PROBE_FCACHE_H
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/*
+ * File metadata cache
+ *
+ * The file based probes look up the same files over and over, the objects
+ * of a hardening profile check the same /etc files dozens of times. The
+ * status, the extended ACL flag and the extended attributes of the files
+ * are kept in a cache shared by all the objects evaluated by the probe
+ * process. The cache is cleared when the probe is reset, i.e. it's valid
+ * for one scan, and it holds at most PROBE_FCACHE_MAX files.
+ *
+ * The functions behave like the system calls they replace, errors are
+ * cached as well and reported through errno.
+ */
+#ifndef PROBE_FCACHE_MAX
+#define PROBE_FCACHE_MAX 16384
+#endif
+
+/**
+ * lstat(2) through the cache.
+ */
+int probe_fcache_lstat(const char *path, struct stat *st);
+
+/**
+ * stat(2) through the cache.
+ */
+int probe_fcache_stat(const char *path, struct stat *st);
+
+/**
+ * Find out whether a file has an extended ACL.
+ * @param path path of the file
+ * @param acl_extended the function called on a cache miss, e.g. acl_extended_file(3)
+ * @return the value returned by acl_extended
+ */
+int probe_fcache_acl_extended(const char *path, int (*acl_extended)(const char *path));
+
+/**
+ * llistxattr(2) through the cache.
+ */
+ssize_t probe_fcache_listxattr(const char *path, char *list, size_t size);
+
+/**
+ * lgetxattr(2) through the cache.
+ */
+ssize_t probe_fcache_getxattr(const char *path, const char *name, void *value, size_t size);
+
+/**
+ * Get the number of lookups answered from the cache and of the ones
+ * which had to query the filesystem. The counts are sent to the library
+ * in the reply to PROBECMD_RESET.
+ */
+void probe_fcache_stats(size_t *hits, size_t *misses);
+
+/**
+ * Drop all the cached files.
+ */
+void probe_fcache_clear(void);
+
+#endif /* PROBE_FCACHE_H */
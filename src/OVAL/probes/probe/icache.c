@@ -31,7 +31,6 @@
 #include <inttypes.h>
 #include <stdlib.h>
 
-#include "../SEAP/generic/rbt/rbt.h"
 #include "probe-api.h"
 #include "common/debug_priv.h"
 #include "common/memusage.h"
@@ -85,23 +84,102 @@ static void probe_icache_item_setID(SEXP_t *item, SEXP_ID_t item_ID)
         return;
 }
 
-static int icache_lookup(rbt_t *tree, int64_t item_id, probe_iqpair_t *pair) {
+static inline probe_icache_shard_t *icache_shard(probe_icache_t *cache, SEXP_ID_t item_ID)
+{
+	return (&cache->shard[(item_ID >> 32) & (PROBE_ICACHE_SHARDS - 1)]);
+}
+
+/*
+ * Returns the slot holding the given ID or the first empty
+ * slot where the ID should be stored.
+ */
+static probe_icache_slot_t *icache_shard_find(probe_icache_shard_t *shard, SEXP_ID_t item_ID)
+{
+	size_t mask = shard->size - 1;
+	size_t i    = (size_t)item_ID & mask;
+
+	while (shard->slot[i].citem != NULL) {
+		if (shard->slot[i].id == item_ID)
+			break;
+		i = (i + 1) & mask;
+	}
+
+	return (&shard->slot[i]);
+}
+
+static int icache_shard_grow(probe_icache_shard_t *shard)
+{
+	probe_icache_slot_t *old_slot = shard->slot;
+	size_t old_size = shard->size, i;
+
+	shard->slot = calloc(old_size * 2, sizeof(probe_icache_slot_t));
+
+	if (shard->slot == NULL) {
+		shard->slot = old_slot;
+		return (-1);
+	}
+
+	shard->size = old_size * 2;
+
+	for (i = 0; i < old_size; ++i) {
+		if (old_slot[i].citem != NULL)
+			*icache_shard_find(shard, old_slot[i].id) = old_slot[i];
+	}
+
+	free(old_slot);
+	return (0);
+}
+
+/*
+ * Look up the item in the cache. If an equal item is already cached,
+ * the item is freed and replaced by the cached one. Otherwise the
+ * item gets an unique ID and is stored in the cache.
+ */
+static int icache_lookup(probe_icache_shard_t *shard, SEXP_ID_t item_ID, SEXP_t **item)
+{
+	probe_icache_slot_t *slot;
+	probe_citem_t *cached;
+	register uint16_t i;
+
+	slot = icache_shard_find(shard, item_ID);
+
+	if (slot->citem == NULL) {
+		/*
+		 * Cache MISS
+		 */
+		dI("cache MISS");
+
+		cached = oscap_talloc(probe_citem_t);
+		cached->item = oscap_talloc(SEXP_t *);
+		cached->item[0] = *item;
+		cached->count = 1;
+
+		/* Assign an unique item ID */
+		probe_icache_item_setID(*item, item_ID);
+
+		slot->id    = item_ID;
+		slot->citem = cached;
 
-	probe_citem_t *cached = NULL;
+		if (++shard->used * 4 >= shard->size * 3) {
+			if (icache_shard_grow(shard) != 0) {
+				dE("Can't grow the item cache shard (%p)", shard);
+				/* now what? */
+				abort();
+			}
+		}
 
-	if (rbt_i64_get(tree, item_id, (void**)&cached) != 0) {
-		return -1;
+		return (0);
 	}
 
 	/*
 	* Maybe a cache HIT
 	*/
 	dI("cache HIT #1");
+	cached = slot->citem;
 
-	register uint16_t i;
 	for (i = 0; i < cached->count; ++i) {
 		SEXP_t rest1;
-		SEXP_t* rest_r1 = SEXP_list_rest_r(&rest1, pair->p.item);
+		SEXP_t* rest_r1 = SEXP_list_rest_r(&rest1, *item);
 
 		SEXP_t rest2;
 		SEXP_t* rest_r2 = SEXP_list_rest_r(&rest2, cached->item[i]);
@@ -123,47 +201,68 @@ static int icache_lookup(rbt_t *tree, int64_t item_id, probe_iqpair_t *pair) {
 		dI("cache MISS");
 
 		cached->item = realloc(cached->item, sizeof(SEXP_t *) * ++cached->count);
-		cached->item[cached->count - 1] = pair->p.item;
+		cached->item[cached->count - 1] = *item;
 
 		/* Assign an unique item ID */
-		probe_icache_item_setID(pair->p.item, item_id);
+		probe_icache_item_setID(*item, item_ID);
 	} else {
 		/*
 		* Cache HIT
 		*/
 		dI("cache HIT #2 -> real HIT");
-		SEXP_free(pair->p.item);
-		pair->p.item = cached->item[i];
+		SEXP_free(*item);
+		*item = cached->item[i];
 	}
 	return 0;
 }
 
-static void icache_add_to_tree(rbt_t *tree, int64_t item_id, probe_iqpair_t *pair) {
+/*
+ * Deduplicate the item using the cache and add it to the collected object.
+ */
+static int icache_handle(probe_icache_t *cache, SEXP_t *cobj, SEXP_t *item)
+{
+	probe_icache_shard_t *shard;
+	SEXP_ID_t item_ID;
+	int ret;
 
-	probe_citem_t *cached = oscap_talloc(probe_citem_t);
-	cached->item = oscap_talloc(SEXP_t *);
-	cached->item[0] = pair->p.item;
-	cached->count = 1;
+	/*
+	 * Compute item ID
+	 */
+	item_ID = SEXP_ID_v(item);
+	dD("item ID=%"PRIu64"", item_ID);
+
+	shard = icache_shard(cache, item_ID);
+
+	if (pthread_mutex_lock(&shard->mutex) != 0) {
+		dE("An error ocured while locking the shard mutex: %u, %s",
+		   errno, strerror(errno));
+		SEXP_free(item);
+		return (-1);
+	}
 
-	/* Assign an unique item ID */
-	probe_icache_item_setID(pair->p.item, item_id);
+	ret = icache_lookup(shard, item_ID, &item);
 
-	if (rbt_i64_add(tree, (int64_t)item_id, (void **)cached, NULL) != 0) {
-		dE("Can't add item (k=%"PRIi64" to the cache (%p)", item_id, tree);
+	if (pthread_mutex_unlock(&shard->mutex) != 0) {
+		dE("An error ocured while unlocking the shard mutex: %u, %s",
+		   errno, strerror(errno));
+		abort();
+	}
 
-		free(cached->item);
-		free(cached);
+	if (ret != 0)
+		return (-1);
 
-		/* now what? */
-		abort();
+	if (probe_cobj_add_item(cobj, item) != 0) {
+		dW("An error ocured while adding the item to the collected object");
+		return (-1);
 	}
+
+	return (0);
 }
 
 static void *probe_icache_worker(void *arg)
 {
         probe_icache_t *cache = (probe_icache_t *)(arg);
         probe_iqpair_t *pair, pair_mem;
-        SEXP_ID_t       item_ID;
 
         assume_d(cache != NULL, NULL);
 
@@ -250,26 +349,10 @@ static void *probe_icache_worker(void *arg)
                 } else {
 
                         dD("Handling cache request");
+                        dD("pair address: %"PRIu64, (uint64_t) pair);
+                        dD("item address: %"PRIu64, (uint64_t) pair->p.item);
 
-                        /*
-                         * Compute item ID
-                         */
-			dD("pair address: %"PRIu64, (uint64_t) pair);
-			dD("item address: %"PRIu64, (uint64_t) pair->p.item);
-                        item_ID = SEXP_ID_v(pair->p.item);
-                        dD("item ID=%"PRIu64"", item_ID);
-
-                        if (icache_lookup(cache->tree, item_ID, pair) != 0) {
-                                /*
-                                 * Cache MISS
-                                 */
-                                dI("cache MISS");
-                                icache_add_to_tree(cache->tree, item_ID, pair);
-                        }
-
-                        if (probe_cobj_add_item(pair->cobj, pair->p.item) != 0) {
-                            dW("An error ocured while adding the item to the collected object");
-                        }
+                        (void)icache_handle(cache, pair->cobj, pair->p.item);
                 }
 
                 if (pthread_mutex_lock(&cache->queue_mutex) != 0) {
@@ -284,12 +367,40 @@ static void *probe_icache_worker(void *arg)
         return (NULL);
 }
 
-probe_icache_t *probe_icache_new(void)
+probe_icache_t *probe_icache_new(bool worker)
 {
         probe_icache_t *cache;
+        size_t i;
+
+        cache = calloc(1, sizeof(probe_icache_t));
+
+        if (cache == NULL)
+                return (NULL);
+
+        for (i = 0; i < PROBE_ICACHE_SHARDS; ++i) {
+                probe_icache_shard_t *shard = &cache->shard[i];
+
+                shard->slot = calloc(PROBE_ICACHE_SHARD_INITSIZE, sizeof(probe_icache_slot_t));
+                shard->size = PROBE_ICACHE_SHARD_INITSIZE;
+                shard->used = 0;
+
+                if (shard->slot == NULL) {
+                        dE("Can't allocate icache shard #%zu", i);
+                        goto fail;
+                }
 
-        cache = oscap_talloc(probe_icache_t);
-        cache->tree = rbt_i64_new();
+                if (pthread_mutex_init(&shard->mutex, NULL) != 0) {
+                        dE("Can't initialize icache shard mutex: %u, %s", errno, strerror(errno));
+                        free(shard->slot);
+                        shard->slot = NULL;
+                        goto fail;
+                }
+        }
+
+        cache->worker = worker;
+
+        if (!worker)
+                return (cache);
 
         if (pthread_mutex_init(&cache->queue_mutex, NULL) != 0) {
                 dE("Can't initialize icache mutex: %u, %s", errno, strerror(errno));
@@ -322,11 +433,17 @@ probe_icache_t *probe_icache_new(void)
 
         return (cache);
 fail:
-        if (cache->tree != NULL)
-                rbt_i64_free(cache->tree);
+        for (i = 0; i < PROBE_ICACHE_SHARDS; ++i) {
+                if (cache->shard[i].slot != NULL) {
+                        free(cache->shard[i].slot);
+                        pthread_mutex_destroy(&cache->shard[i].mutex);
+                }
+        }
 
-        pthread_mutex_destroy(&cache->queue_mutex);
-        pthread_cond_destroy(&cache->queue_notempty);
+        if (worker) {
+                pthread_mutex_destroy(&cache->queue_mutex);
+                pthread_cond_destroy(&cache->queue_notempty);
+        }
         free(cache);
 
         return (NULL);
@@ -370,23 +487,56 @@ retry:
 
 int probe_icache_add(probe_icache_t *cache, SEXP_t *cobj, SEXP_t *item)
 {
-        int ret;
-
         if (cache == NULL || cobj == NULL || item == NULL)
                 return (-1); /* XXX: EFAULT */
 
+        return probe_icache_add_batch(cache, cobj, &item, 1);
+}
+
+int probe_icache_add_batch(probe_icache_t *cache, SEXP_t *cobj, SEXP_t **items, size_t count)
+{
+        int ret = 0, cstate;
+        size_t i;
+
+        if (cache == NULL || cobj == NULL || items == NULL)
+                return (-1); /* XXX: EFAULT */
+
+        /*
+         * The calling thread might be canceled asynchronously. Don't let
+         * it happen while a cache lock is held.
+         */
+        pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &cstate);
+
+        if (!cache->worker) {
+                for (i = 0; i < count; ++i) {
+                        if (icache_handle(cache, cobj, items[i]) != 0)
+                                ret = -1;
+                }
+
+                pthread_setcancelstate(cstate, NULL);
+                return (ret);
+        }
+
         if (pthread_mutex_lock(&cache->queue_mutex) != 0) {
                 dE("An error ocured while locking the queue mutex: %u, %s",
                    errno, strerror(errno));
+                pthread_setcancelstate(cstate, NULL);
                 return (-1);
         }
 
-        ret = __probe_icache_add_nolock(cache, cobj, item, NULL);
+        for (i = 0; i < count; ++i) {
+                if (__probe_icache_add_nolock(cache, cobj, items[i], NULL) != 0) {
+                        for (; i < count; ++i)
+                                SEXP_free(items[i]);
+                        ret = -1;
+                        break;
+                }
 
-        if (pthread_cond_signal(&cache->queue_notempty) != 0) {
-                dE("An error ocured while signaling the `notempty' condition: %u, %s",
-                   errno, strerror(errno));
-                return (-1);
+                if (pthread_cond_signal(&cache->queue_notempty) != 0) {
+                        dE("An error ocured while signaling the `notempty' condition: %u, %s",
+                           errno, strerror(errno));
+                        ret = -1;
+                }
         }
 
         if (pthread_mutex_unlock(&cache->queue_mutex) != 0) {
@@ -395,16 +545,22 @@ int probe_icache_add(probe_icache_t *cache, SEXP_t *cobj, SEXP_t *item)
                 abort();
         }
 
-        if (ret != 0)
-                return (-1);
+        pthread_setcancelstate(cstate, NULL);
 
-        return (0);
+        return (ret);
 }
 
 int probe_icache_nop(probe_icache_t *cache)
 {
         pthread_cond_t cond;
 
+        /*
+         * Without the worker thread all the items are handled
+         * synchronously, there's nothing to wait for.
+         */
+        if (!cache->worker)
+                return (0);
+
         dD("NOP");
 
         if (pthread_mutex_lock(&cache->queue_mutex) != 0) {
@@ -462,6 +618,8 @@ int probe_icache_nop(probe_icache_t *cache)
 }
 
 #define PROBE_RESULT_MEMCHECK_CTRESHOLD  32768  /* item count */
+#define PROBE_RESULT_MEMCHECK_CSTEP      4096   /* item count between two checks */
+#define PROBE_RESULT_MEMCHECK_SSTEP      8192   /* KiB of items between two checks */
 #define PROBE_RESULT_MEMCHECK_MINFREEMEM 512    /* MiB */
 #define PROBE_RESULT_MEMCHECK_MAXRATIO   0.8   /* max. memory usage ratio - used/total */
 
@@ -469,39 +627,83 @@ int probe_icache_nop(probe_icache_t *cache)
  * Returns 0 if the memory constraints are not reached. Otherwise, 1 is returned.
  * In case of an error, -1 is returned.
  */
-static int probe_cobj_memcheck(size_t item_cnt)
+static int probe_memcheck(void)
 {
-	if (item_cnt > PROBE_RESULT_MEMCHECK_CTRESHOLD) {
-		struct proc_memusage mu_proc;
-		struct sys_memusage  mu_sys;
-		double c_ratio;
-
-		if (oscap_proc_memusage (&mu_proc) != 0)
-			return (-1);
+	struct proc_memusage   mu_proc;
+	struct sys_memusage    mu_sys;
+	struct cgroup_memusage mu_cg;
+	double c_ratio;
 
-		if (oscap_sys_memusage (&mu_sys) != 0)
-			return (-1);
+	/*
+	 * If we run inside a memory limited cgroup (e.g. a container), the
+	 * cgroup limit is reached long before the system-wide limits.
+	 */
+	if (oscap_cgroup_memusage(&mu_cg) == 0 && mu_cg.mu_limit > 0) {
+		size_t used;
 
-		c_ratio = (double)mu_proc.mu_rss/(double)(mu_sys.mu_total);
+		used = mu_cg.mu_current > mu_cg.mu_file ? mu_cg.mu_current - mu_cg.mu_file : 0;
+		c_ratio = (double)used/(double)(mu_cg.mu_limit);
 
 		if (c_ratio > PROBE_RESULT_MEMCHECK_MAXRATIO) {
-			dW("Memory usage ratio limit reached! limit=%f, current=%f",
+			dW("Cgroup memory usage ratio limit reached! limit=%f, current=%f",
 			   PROBE_RESULT_MEMCHECK_MAXRATIO, c_ratio);
 			errno = ENOMEM;
 			return (1);
 		}
+	}
 
-		if ((mu_sys.mu_realfree / 1024) < PROBE_RESULT_MEMCHECK_MINFREEMEM) {
-			dW("Minimum free memory limit reached! limit=%zu, current=%zu",
-			   PROBE_RESULT_MEMCHECK_MINFREEMEM, mu_sys.mu_realfree / 1024);
-			errno = ENOMEM;
-			return (1);
-		}
+	if (oscap_proc_memusage (&mu_proc) != 0)
+		return (-1);
+
+	if (oscap_sys_memusage (&mu_sys) != 0)
+		return (-1);
+
+	c_ratio = (double)mu_proc.mu_rss/(double)(mu_sys.mu_total);
+
+	if (c_ratio > PROBE_RESULT_MEMCHECK_MAXRATIO) {
+		dW("Memory usage ratio limit reached! limit=%f, current=%f",
+		   PROBE_RESULT_MEMCHECK_MAXRATIO, c_ratio);
+		errno = ENOMEM;
+		return (1);
+	}
+
+	if ((mu_sys.mu_realfree / 1024) < PROBE_RESULT_MEMCHECK_MINFREEMEM) {
+		dW("Minimum free memory limit reached! limit=%zu, current=%zu",
+		   PROBE_RESULT_MEMCHECK_MINFREEMEM, mu_sys.mu_realfree / 1024);
+		errno = ENOMEM;
+		return (1);
 	}
 
 	return (0);
 }
 
+/**
+ * Check the memory constraints for the collected object of the given
+ * probe context. The check is expensive (it parses several /proc files)
+ * so it's done only once per PROBE_RESULT_MEMCHECK_CSTEP items or once
+ * per PROBE_RESULT_MEMCHECK_SSTEP KiB of collected items, whichever
+ * comes first. Once the constraints are reached, the result is kept
+ * for the rest of the collection.
+ */
+static int probe_cobj_memcheck(struct probe_ctx *ctx)
+{
+	if (ctx->mcheck_result != 0)
+		return (ctx->mcheck_result);
+
+	if (ctx->cobj_itemcnt <= PROBE_RESULT_MEMCHECK_CTRESHOLD)
+		return (0);
+
+	if (ctx->cobj_itemcnt < ctx->mcheck_itemcnt &&
+	    ctx->cobj_size    < ctx->mcheck_size)
+		return (0);
+
+	ctx->mcheck_itemcnt = ctx->cobj_itemcnt + PROBE_RESULT_MEMCHECK_CSTEP;
+	ctx->mcheck_size    = ctx->cobj_size + PROBE_RESULT_MEMCHECK_SSTEP * 1024;
+	ctx->mcheck_result  = probe_memcheck();
+
+	return (ctx->mcheck_result);
+}
+
 /**
  * Collect an item
  * This function adds an item the collected object assosiated
@@ -519,18 +721,13 @@ static int probe_cobj_memcheck(size_t item_cnt)
  */
 int probe_item_collect(struct probe_ctx *ctx, SEXP_t *item)
 {
-	SEXP_t *cobj_content;
-	size_t  cobj_itemcnt;
+	size_t item_size;
 
 	assume_d(ctx != NULL, -1);
 	assume_d(ctx->probe_out != NULL, -1);
 	assume_d(item != NULL, -1);
 
-	cobj_content = SEXP_listref_nth(ctx->probe_out, 3);
-	cobj_itemcnt = SEXP_list_length(cobj_content);
-	SEXP_free(cobj_content);
-
-	if (probe_cobj_memcheck(cobj_itemcnt) != 0) {
+	if (probe_cobj_memcheck(ctx) != 0) {
 
 		/*
 		 * Don't set the message again if the collected object is
@@ -554,6 +751,7 @@ int probe_item_collect(struct probe_ctx *ctx, SEXP_t *item)
 			SEXP_free(msg);
 		}
 
+		SEXP_free(item);
 		return 2;
 	}
 
@@ -562,19 +760,26 @@ int probe_item_collect(struct probe_ctx *ctx, SEXP_t *item)
 		return (1);
         }
 
+        /*
+         * The item is owned by the icache thread once it's added
+         * to the queue, so get its size now.
+         */
+        item_size = SEXP_sizeof(item);
+
         if (probe_icache_add(ctx->icache, ctx->probe_out, item) != 0) {
                 dE("Can't add item (%p) to the item cache (%p)", item, ctx->icache);
                 SEXP_free(item);
                 return (-1);
         }
 
+        ++ctx->cobj_itemcnt;
+        ctx->cobj_size += item_size;
+
         return (0);
 }
 
-static void probe_icache_free_node(struct rbt_i64_node *n)
+static void probe_icache_free_citem(probe_citem_t *ci)
 {
-        probe_citem_t *ci = (probe_citem_t *)n->data;
-
 	for ( ; ci->count > 0 ; --ci->count ) {
 		SEXP_free(ci->item[ci->count - 1]);
 	}
@@ -587,14 +792,28 @@ static void probe_icache_free_node(struct rbt_i64_node *n)
 void probe_icache_free(probe_icache_t *cache)
 {
         void *ret = NULL;
+        size_t i, j;
+
+        if (cache->worker) {
+                pthread_cancel(cache->thid);
+                pthread_join(cache->thid, &ret);
+                pthread_mutex_destroy(&cache->queue_mutex);
+                pthread_cond_destroy(&cache->queue_notempty);
+                pthread_cond_destroy(&cache->queue_notfull);
+        }
+
+        for (i = 0; i < PROBE_ICACHE_SHARDS; ++i) {
+                probe_icache_shard_t *shard = &cache->shard[i];
 
-        pthread_cancel(cache->thid);
-        pthread_join(cache->thid, &ret);
-        pthread_mutex_destroy(&cache->queue_mutex);
-        pthread_cond_destroy(&cache->queue_notempty);
-        pthread_cond_destroy(&cache->queue_notfull);
+                for (j = 0; j < shard->size; ++j) {
+                        if (shard->slot[j].citem != NULL)
+                                probe_icache_free_citem(shard->slot[j].citem);
+                }
+
+                free(shard->slot);
+                pthread_mutex_destroy(&shard->mutex);
+        }
 
-        rbt_i64_free_cb(cache->tree, &probe_icache_free_node);
         free(cache);
         return;
 }
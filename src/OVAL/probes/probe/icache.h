@@ -23,13 +23,24 @@
 #define ICACHE_H
 
 #include <stddef.h>
+#include <stdbool.h>
+#include <pthread.h>
 #include <sexp.h>
-#include "../SEAP/generic/rbt/rbt.h"
 
 #ifndef PROBE_IQUEUE_CAPACITY
 #define PROBE_IQUEUE_CAPACITY 1024
 #endif
 
+/* number of item cache shards, must be a power of two */
+#ifndef PROBE_ICACHE_SHARDS
+#define PROBE_ICACHE_SHARDS 64
+#endif
+
+/* initial number of slots in a shard, must be a power of two */
+#ifndef PROBE_ICACHE_SHARD_INITSIZE
+#define PROBE_ICACHE_SHARD_INITSIZE 64
+#endif
+
 typedef struct {
         SEXP_t *cobj;
         union {
@@ -39,7 +50,36 @@ typedef struct {
 } probe_iqpair_t;
 
 typedef struct {
-        rbt_t    *tree; /* XXX: rewrite to extensible or linear hashing */
+        SEXP_t  **item;
+        uint16_t  count;
+} probe_citem_t;
+
+typedef struct {
+        SEXP_ID_t      id;
+        probe_citem_t *citem; /* NULL if the slot is empty */
+} probe_icache_slot_t;
+
+/*
+ * Open addressing (linear probing) hash table holding a part
+ * of the items. The shard is selected by the high bits of the
+ * item ID, the slot by the low bits.
+ */
+typedef struct {
+        pthread_mutex_t      mutex;
+        probe_icache_slot_t *slot;
+        size_t               size; /* power of two */
+        size_t               used;
+} probe_icache_shard_t;
+
+typedef struct {
+        probe_icache_shard_t shard[PROBE_ICACHE_SHARDS];
+
+        /*
+         * Optional consumer thread. If it's not running, items are
+         * deduplicated and added to the collected object directly
+         * in the thread which collects them.
+         */
+        bool      worker;
         pthread_t thid;
 
         pthread_mutex_t queue_mutex;
@@ -53,13 +93,19 @@ typedef struct {
         uint16_t        queue_max;
 } probe_icache_t;
 
-typedef struct {
-        SEXP_t  **item;
-        uint16_t  count;
-} probe_citem_t;
-
-probe_icache_t *probe_icache_new(void);
+/**
+ * Create a new item cache.
+ * @param worker if true, start a consumer thread which handles all
+ *        item cache requests, otherwise handle them in the calling thread
+ */
+probe_icache_t *probe_icache_new(bool worker);
 int probe_icache_add(probe_icache_t *cache, SEXP_t *cobj, SEXP_t *item);
+
+/**
+ * Add several items to the cache and the collected object at once.
+ * The cache takes ownership of all the items, even on failure.
+ */
+int probe_icache_add_batch(probe_icache_t *cache, SEXP_t *cobj, SEXP_t **items, size_t count);
 int probe_icache_nop(probe_icache_t *cache);
 void probe_icache_free(probe_icache_t *cache);
 
@@ -38,15 +38,61 @@
 #include "input_handler.h"
 #include "common/compat_pthread_barrier.h"
 
+/*
+ * Queue the request for the worker pool. Returns -1 if the request can't
+ * be queued, the caller has to reply with an error.
+ */
+static int probe_input_queue(probe_t *probe, SEAP_msg_t *seap_request)
+{
+	probe_pwpair_t *pair;
+
+	pair = oscap_talloc(probe_pwpair_t);
+	pair->probe = probe;
+	pair->pth   = probe_worker_new();
+	pair->pth->sid = SEAP_msg_id(seap_request);
+	pair->pth->msg = seap_request;
+	pair->pth->msg_handler = &probe_worker;
+
+	if (rbt_i32_add(probe->workers, pair->pth->sid, pair->pth, NULL) != 0) {
+		/*
+		 * Getting here means that there is already a
+		 * thread handling the message with the given
+		 * ID.
+		 */
+		dW("Attempt to evaluate an object "
+		   "(ID=%u) " // TODO: 64b IDs
+		   "which is already being evaluated by an other thread.", pair->pth->sid);
+
+		free(pair->pth);
+		free(pair);
+		SEAP_msg_free(seap_request);
+
+		return (0);
+	}
+
+	if (probe_workerpool_add(probe->pool, pair) != 0) {
+		dE("Cannot queue the request (ID=%u): %d, %s.", pair->pth->sid, errno, strerror(errno));
+
+		if (rbt_i32_del(probe->workers, pair->pth->sid, NULL) != 0)
+			dE("rbt_i32_del: failed to remove worker thread (ID=%u)", pair->pth->sid);
+
+		free(pair->pth);
+		free(pair);
+
+		return (-1);
+	}
+
+	return (0);
+}
+
 /*
  * The input handler waits for incomming eval requests and either returns
- * a result immediately if it is found in the result cache or spawns a new
- * worker thread which takes care of evaluating the request, caching the
- * result and sending it to the requestee.
+ * a result immediately if it is found in the result cache or queues the
+ * request for the worker pool. A worker thread takes care of evaluating
+ * the request, caching the result and sending it to the requestee.
  */
 void *probe_input_handler(void *arg)
 {
-        pthread_attr_t pth_attr;
         probe_t       *probe = (probe_t *)arg;
 
         int probe_ret, cstate; /* XXX */
@@ -66,16 +112,6 @@ void *probe_input_handler(void *arg)
 
         TH_CANCEL_OFF;
 
-        if (pthread_attr_init(&pth_attr))
-                return (NULL);
-
-        if (pthread_attr_setdetachstate(&pth_attr, PTHREAD_CREATE_JOINABLE)) {
-                pthread_attr_destroy(&pth_attr);
-                return (NULL);
-        }
-
-        pthread_cleanup_push((void(*)(void *))pthread_attr_destroy, (void *)&pth_attr);
-        
         switch (errno = pthread_barrier_wait(&OSCAP_GSYM(th_barrier)))
         {
         case 0:
@@ -108,6 +144,31 @@ void *probe_input_handler(void *arg)
 
 		SEXP_VALIDATE(probe_in);
 
+		/*
+		 * A batch request contains a list of objects. The result
+		 * cache is checked and the replies are sent by the worker.
+		 */
+		if (SEAP_msgattr_exists(seap_request, "batch")) {
+			size_t batch_cnt = SEXP_list_length(probe_in);
+
+			SEXP_free(probe_in);
+			probe_in = NULL;
+
+			if (probe_input_queue(probe, seap_request) != 0) {
+				/* each object of the batch gets an error reply */
+				while (batch_cnt-- > 1 &&
+				       SEAP_replyerr(probe->SEAP_ctx, probe->sd, seap_request, PROBE_EUNKNOWN) == 0);
+
+				probe_ret = PROBE_EUNKNOWN;
+				probe_out = NULL;
+
+				goto __error_reply;
+			}
+
+			seap_request = NULL;
+			continue;
+		}
+
                 /*
                  * Get a reference to the `id' attribute of the input object. The value
                  * of this attribute is the OVAL object ID and serves as a key in the
@@ -159,51 +220,15 @@ void *probe_input_handler(void *arg)
 	                                        SEXP_free(skip_flag);
 	                                        SEXP_free(obj_mask);
 					} else {
-						probe_pwpair_t *pair;
-
 	                                        SEXP_free(oid);
 						SEXP_free(skip_flag);
 						SEXP_free(obj_mask);
 
-	                                        pair = oscap_talloc(probe_pwpair_t);
-						pair->probe = probe;
-						pair->pth   = probe_worker_new();
-						pair->pth->sid = SEAP_msg_id(seap_request);
-						pair->pth->msg = seap_request;
-						pair->pth->msg_handler = &probe_worker;
-
-						if (rbt_i32_add(probe->workers, pair->pth->sid, pair->pth, NULL) != 0) {
-							/*
-							 * Getting here means that there is already a
-							 * thread handling the message with the given
-							 * ID.
-							 */
-							dW("Attempt to evaluate an object "
-							   "(ID=%u) " // TODO: 64b IDs
-							   "which is already being evaluated by an other thread.", pair->pth->sid);
-
-							free(pair->pth);
-							free(pair);
-							SEAP_msg_free(seap_request);
-						} else {
-							/* OK */
-
-							if (pthread_create(&pair->pth->tid, &pth_attr, &probe_worker_runfn, pair))
-							{
-								dE("Cannot start a new worker thread: %d, %s.", errno, strerror(errno));
-
-								if (rbt_i32_del(probe->workers, pair->pth->sid, NULL) != 0)
-									dE("rbt_i32_del: failed to remove worker thread (ID=%u)", pair->pth->sid);
-
-								SEAP_msg_free(pair->pth->msg);
-								free(pair->pth);
-								free(pair);
-
-								probe_ret = PROBE_EUNKNOWN;
-								probe_out = NULL;
-
-								goto __error_reply;
-							}
+						if (probe_input_queue(probe, seap_request) != 0) {
+							probe_ret = PROBE_EUNKNOWN;
+							probe_out = NULL;
+
+							goto __error_reply;
 						}
 
 						seap_request = NULL;
@@ -259,6 +284,5 @@ void *probe_input_handler(void *arg)
 		SEAP_msg_free(seap_request);
 	} /* main loop */
 
-        pthread_cleanup_pop(1);
         return (NULL);
 }
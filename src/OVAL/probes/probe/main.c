@@ -27,6 +27,7 @@
 # endif
 #endif
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <signal.h>
 #include <pthread.h>
@@ -38,6 +39,7 @@
 #include "ncache.h"
 #include "rcache.h"
 #include "icache.h"
+#include "fcache.h"
 #include "worker.h"
 #include "signal_handler.h"
 #include "input_handler.h"
@@ -68,9 +70,11 @@ static int probe_optecmp(char **a, char **b)
 	return strcmp(*a, *b);
 }
 
-static SEXP_t *probe_reset(SEXP_t *arg0, void *arg1)
+static SEXP_t *probe_cmd_reset(SEXP_t *arg0, void *arg1)
 {
         probe_t *probe = (probe_t *)arg1;
+        SEXP_t *res, *r0, *r1;
+        size_t hits, misses;
         /*
          * FIXME: implement main loop locking & worker waiting
          */
@@ -79,8 +83,19 @@ static SEXP_t *probe_reset(SEXP_t *arg0, void *arg1)
 
         probe->rcache = probe_rcache_new();
         probe->ncache = probe_ncache_new();
+        OSCAP_GSYM(ncache) = probe->ncache;
 
-        return(NULL);
+        /* The file metadata cache statistics of the scan are sent in the reply */
+        probe_fcache_stats(&hits, &misses);
+        probe_fcache_clear();
+
+        probe_reset(probe->probe_arg);
+
+        res = SEXP_list_new(r0 = SEXP_number_newu_64(hits),
+                            r1 = SEXP_number_newu_64(misses), NULL);
+        SEXP_vfree(r0, r1, NULL);
+
+        return(res);
 }
 
 static int probe_opthandler_varref(int option, int op, va_list args)
@@ -189,10 +204,18 @@ int main(int argc, char *argv[])
 	char *verbose_log_file = getenv("OSCAP_PROBE_VERBOSE_LOG_FILE");
 	oscap_set_verbose(verbosity_level, verbose_log_file, true);
 
+	/*
+	 * By default, items are deduplicated by the item cache directly in
+	 * the worker threads. The dedicated icache thread is used only if
+	 * requested.
+	 */
+	char *icache_thread = getenv("OSCAP_PROBE_ICACHE_THREAD");
+	bool icache_worker = (icache_thread != NULL && strcmp(icache_thread, "1") == 0);
+
 	if ((errno = pthread_barrier_init(&OSCAP_GSYM(th_barrier), NULL,
 	                                  1 + // signal thread
 	                                  1 + // input thread
-	                                  1 + // icache thread
+	                                  (icache_worker ? 1 : 0) + // icache thread
 	                                  0)) != 0)
 	{
 		fail(errno, "pthread_barrier_init", __LINE__ - 6);
@@ -219,6 +242,23 @@ int main(int argc, char *argv[])
 	probe.name = oscap_basename(argv[0]);
         probe.probe_exitcode = 0;
 
+	/*
+	 * Size of the worker thread pool
+	 */
+	char *max_threads = getenv("OSCAP_PROBE_MAX_THREADS");
+
+	probe.max_threads = PROBE_WORKER_DEFAULT_MAX_THREADS;
+	probe.max_chdepth = PROBE_WORKER_DEFAULT_MAX_CHDEPTH;
+
+	if (max_threads != NULL) {
+		unsigned long n = strtoul(max_threads, NULL, 10);
+
+		if (n > 0 && n <= UINT32_MAX)
+			probe.max_threads = (uint32_t)n;
+		else
+			dW("Invalid OSCAP_PROBE_MAX_THREADS value: %s", max_threads);
+	}
+
 	/*
 	 * Initialize SEAP stuff
 	 */
@@ -228,7 +268,7 @@ int main(int argc, char *argv[])
 	if (probe.sd < 0)
 		fail(errno, "SEAP_openfd2", __LINE__ - 3);
 
-	if (SEAP_cmd_register(probe.SEAP_ctx, PROBECMD_RESET, 0, &probe_reset) != 0)
+	if (SEAP_cmd_register(probe.SEAP_ctx, PROBECMD_RESET, SEAP_CMDREG_USEARG, &probe_cmd_reset, &probe) != 0)
 		fail(errno, "SEAP_cmd_register", __LINE__ - 1);
 
 	/*
@@ -236,7 +276,7 @@ int main(int argc, char *argv[])
 	 */
 	probe.rcache = probe_rcache_new();
 	probe.ncache = probe_ncache_new();
-        probe.icache = probe_icache_new();
+        probe.icache = probe_icache_new(icache_worker);
 
         OSCAP_GSYM(ncache) = probe.ncache;
 
@@ -315,6 +355,7 @@ int main(int argc, char *argv[])
 	 * Create input handler (detached)
 	 */
         probe.workers   = rbt_i32_new();
+        probe.pool      = probe_workerpool_new(probe.max_threads);
         probe.probe_arg = probe_init();
 
 	pthread_attr_init(&th_attr);
@@ -357,7 +398,9 @@ int main(int argc, char *argv[])
 	probe_ncache_free(probe.ncache);
 	probe_rcache_free(probe.rcache);
         probe_icache_free(probe.icache);
+        probe_fcache_clear();
 
+        probe_workerpool_free(probe.pool);
         rbt_i32_free(probe.workers);
 
         if (probe.sd != -1)
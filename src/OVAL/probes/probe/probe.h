@@ -37,6 +37,8 @@
 #include "common/util.h"
 #include "common/compat_pthread_barrier.h"
 
+struct probe_workerpool;
+
 typedef struct {
 	pthread_rwlock_t rwlock;
 	uint32_t         flags;
@@ -53,7 +55,8 @@ typedef struct {
 	pthread_t th_input;
 	pthread_t th_signal;
 
-        rbt_t    *workers;
+        rbt_t    *workers;     /**< requests being evaluated, by message ID */
+        struct probe_workerpool *pool; /**< worker threads */
         uint32_t  max_threads;
         uint32_t  max_chdepth;
 
@@ -70,6 +73,12 @@ struct probe_ctx {
         SEXP_t         *probe_out; /**< collected object */
         SEXP_t         *filters;   /**< object filters (OVAL 5.8 and higher) */
         probe_icache_t *icache;    /**< item cache */
+
+        size_t cobj_itemcnt;   /**< number of items added to the collected object */
+        size_t cobj_size;      /**< estimated size of the added items in bytes */
+        size_t mcheck_itemcnt; /**< item count which triggers the next memory check */
+        size_t mcheck_size;    /**< items size which triggers the next memory check */
+        int    mcheck_result;  /**< result of the last memory check */
 };
 
 typedef enum {
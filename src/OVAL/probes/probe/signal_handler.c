@@ -42,6 +42,7 @@
 
 typedef struct {
 	probe_worker_t **thr;
+	SEAP_msgid_t    *sid;
 	size_t           cnt;
 } __thr_collection;
 
@@ -49,12 +50,12 @@ static int __abort_cb(void *n, void *u)
 {
 	__thr_collection    *coll = (__thr_collection *)u;
 	struct rbt_i32_node *node = (struct rbt_i32_node *)n;
-	probe_worker_t      *thr  = (probe_worker_t *)(node->data);
 
-        pthread_cancel(thr->tid);
-
-	coll->thr = realloc(coll->thr, sizeof(SEAP_msg_t *) * ++coll->cnt);
-	coll->thr[coll->cnt - 1] = thr;
+	coll->thr = realloc(coll->thr, sizeof(probe_worker_t *) * (coll->cnt + 1));
+	coll->sid = realloc(coll->sid, sizeof(SEAP_msgid_t) * (coll->cnt + 1));
+	coll->thr[coll->cnt] = (probe_worker_t *)(node->data);
+	coll->sid[coll->cnt] = node->key;
+	++coll->cnt;
 
 	return (0);
 }
@@ -122,49 +123,36 @@ void *probe_signal_handler(void *arg)
 			__thr_collection coll;
 
 			coll.thr = NULL;
+			coll.sid = NULL;
 			coll.cnt = 0;
 
                         pthread_cancel(probe->th_input);
 
-			/* collect IDs and cancel threads */
+			/* drop the queued requests and collect all requests */
+			probe_workerpool_cancel(probe->pool);
 			rbt_walk_inorder2(probe->workers, __abort_cb, &coll, 0);
 
 			/*
-			 * Wait till all threads are canceled (they may temporarily disable
-			 * cancelability), but at most 60 seconds per thread.
+			 * Cancel the thread of each request and free the request.
+			 * A request which was removed from the tree meanwhile is
+			 * freed by its thread. If some thread didn't terminate, its
+			 * request is leaked as it might still be in use. We are
+			 * shutting down anyway.
 			 */
 			for (; coll.cnt > 0; --coll.cnt) {
 				probe_worker_t *thr = coll.thr[coll.cnt - 1];
-#if defined(HAVE_PTHREAD_TIMEDJOIN_NP) && defined(HAVE_CLOCK_GETTIME)
-				struct timespec j_tm;
-
-				if (clock_gettime(CLOCK_REALTIME, &j_tm) == -1) {
-					dE("clock_gettime(CLOCK_REALTIME): %d, %s.", errno, strerror(errno));
-					continue;
-				}
 
-				j_tm.tv_sec += 60;
-
-				if ((errno = pthread_timedjoin_np(thr->tid, NULL, &j_tm)) != 0) {
-					dE("[%llu] pthread_timedjoin_np: %d, %s.", (uint64_t)thr->sid, errno, strerror(errno));
-					/*
-					 * Memory will be leaked here by continuing to the next thread. However, we are in the
-					 * process of shutting down the whole probe. We're just nice and gave the probe_main()
-					 * thread a chance to finish it's critical section which shouldn't take that long...
-					 */
+				if (rbt_i32_del(probe->workers, coll.sid[coll.cnt - 1], NULL) != 0)
 					continue;
-				}
-#else
-				if ((errno = pthread_join(thr->tid, NULL)) != 0) {
-					dE("pthread_join: %d, %s.", errno, strerror(errno));
+				if (probe_workerpool_cancel_request(probe->pool, thr) != 0)
 					continue;
-				}
-#endif
-				SEAP_msg_free(coll.thr[coll.cnt - 1]->msg);
-                                free(coll.thr[coll.cnt - 1]);
+
+				SEAP_msg_free(thr->msg);
+				free(thr);
 			}
 
 			free(coll.thr);
+			free(coll.sid);
 			goto exitloop;
 		}
                 case SIGUSR2:
@@ -40,6 +40,8 @@
 extern bool  OSCAP_GSYM(varref_handling);
 extern void *OSCAP_GSYM(probe_arg);
 
+static void probe_worker_batch(probe_pwpair_t *pair);
+
 void *probe_worker_runfn(void *arg)
 {
 	probe_pwpair_t *pair = (probe_pwpair_t *)arg;
@@ -47,13 +49,11 @@ void *probe_worker_runfn(void *arg)
 	SEXP_t *probe_res, *obj, *oid;
 	int     probe_ret;
 
-#if defined(HAVE_PTHREAD_SETNAME_NP)
-# if defined(__APPLE__)
-	pthread_setname_np("probe_worker");
-# else
-	pthread_setname_np(pthread_self(), "probe_worker");
-# endif
-#endif
+	if (SEAP_msgattr_exists(pair->pth->msg, "batch")) {
+		probe_worker_batch(pair);
+		return (NULL);
+	}
+
 	dD("handling SEAP message ID %u", pair->pth->sid);
 	//
 	probe_ret = -1;
@@ -66,11 +66,11 @@ void *probe_worker_runfn(void *arg)
 		dW("thread not found in the probe thread tree, probably canceled by an external signal");
 		/*
 		 * XXX: this is a possible deadlock; we can't send anything from
-		 * here because the signal handler replied to the message
+		 * here because the signal handler replied to the message. The
+		 * message is freed by the signal handler.
 		 */
 		arg = NULL;
 
-                SEAP_msg_free(pair->pth->msg);
                 SEXP_free(probe_res);
                 free(pair);
 
@@ -136,7 +136,6 @@ void *probe_worker_runfn(void *arg)
         SEAP_msg_free(pair->pth->msg);
         free(pair->pth);
 	free(pair);
-	pthread_detach(pthread_self());
 
 	return (NULL);
 }
@@ -153,6 +152,375 @@ probe_worker_t *probe_worker_new(void)
 	return (pth);
 }
 
+typedef struct probe_workerpool_thr {
+	probe_workerpool_t *pool;
+	pthread_t           tid;
+	probe_pwpair_t     *current;  /**< request being handled by the thread */
+	probe_worker_t     *request;  /**< worker data of the current request */
+	bool                canceled; /**< the thread was canceled by probe_workerpool_cancel_request() */
+	bool                joined;   /**< the thread was joined by probe_workerpool_cancel_request() */
+	struct probe_workerpool_thr *next;
+} probe_workerpool_thr_t;
+
+struct probe_workerpool {
+	pthread_mutex_t lock;
+	pthread_cond_t  cond;
+
+	probe_pwpair_t *head; /**< work queue */
+	probe_pwpair_t *tail;
+	size_t          qlen;
+
+	probe_workerpool_thr_t *thr; /**< started threads */
+	uint32_t        thr_cnt;
+	uint32_t        max_threads;
+	uint32_t        idle_cnt;
+	uint32_t        busy_cnt;
+	uint32_t        blocked_cnt; /**< busy threads waiting for the library */
+	bool            stop;
+	bool            canceled;
+
+	struct timespec created;
+	probe_workerpool_stats_t stats;
+};
+
+static double timespec_diff(const struct timespec *beg, const struct timespec *end)
+{
+	return (double)(end->tv_sec - beg->tv_sec) +
+	       (double)(end->tv_nsec - beg->tv_nsec) / 1e9;
+}
+
+static void probe_workerpool_unlock(void *arg)
+{
+	pthread_mutex_unlock((pthread_mutex_t *)arg);
+}
+
+static void *probe_workerpool_thread(void *arg)
+{
+	probe_workerpool_thr_t *thr  = (probe_workerpool_thr_t *)arg;
+	probe_workerpool_t     *pool = thr->pool;
+	probe_pwpair_t         *pair;
+	struct timespec         t_beg, t_end;
+
+#if defined(HAVE_PTHREAD_SETNAME_NP)
+# if defined(__APPLE__)
+	pthread_setname_np("probe_worker");
+# else
+	pthread_setname_np(pthread_self(), "probe_worker");
+# endif
+#endif
+	pthread_mutex_lock(&pool->lock);
+
+	for (;;) {
+		while (pool->head == NULL && !pool->stop) {
+			++pool->idle_cnt;
+			pthread_cleanup_push(probe_workerpool_unlock, (void *)&pool->lock);
+			pthread_cond_wait(&pool->cond, &pool->lock);
+			pthread_cleanup_pop(0);
+			--pool->idle_cnt;
+		}
+
+		if (pool->head == NULL || pool->canceled)
+			break;
+
+		pair = pool->head;
+		pool->head = pair->next;
+
+		if (pool->head == NULL)
+			pool->tail = NULL;
+
+		--pool->qlen;
+		thr->current = pair;
+		thr->request = pair->pth;
+		pair->pth->tid = thr->tid;
+
+		if (++pool->busy_cnt > pool->stats.busy_max)
+			pool->stats.busy_max = pool->busy_cnt;
+
+		clock_gettime(CLOCK_MONOTONIC, &t_beg);
+		pool->stats.wait_time += timespec_diff(&pair->queued, &t_beg);
+		pthread_mutex_unlock(&pool->lock);
+
+		probe_worker_runfn(pair);
+
+		clock_gettime(CLOCK_MONOTONIC, &t_end);
+		pthread_mutex_lock(&pool->lock);
+
+		thr->current = NULL;
+		thr->request = NULL;
+		--pool->busy_cnt;
+		++pool->stats.jobs;
+		pool->stats.busy_time += timespec_diff(&t_beg, &t_end);
+	}
+
+	pthread_mutex_unlock(&pool->lock);
+
+	return (NULL);
+}
+
+/*
+ * Start a new worker thread. The pool has to be locked.
+ */
+static int probe_workerpool_spawn(probe_workerpool_t *pool)
+{
+	pthread_attr_t pth_attr;
+	probe_workerpool_thr_t *thr;
+
+	thr = oscap_talloc(probe_workerpool_thr_t);
+	memset(thr, 0, sizeof(probe_workerpool_thr_t));
+	thr->pool = pool;
+
+	pthread_attr_init(&pth_attr);
+	pthread_attr_setdetachstate(&pth_attr, PTHREAD_CREATE_JOINABLE);
+
+	if ((errno = pthread_create(&thr->tid, &pth_attr, &probe_workerpool_thread, thr)) != 0) {
+		int err = errno;
+
+		dE("Cannot start a new worker thread: %d, %s.", err, strerror(err));
+		pthread_attr_destroy(&pth_attr);
+		free(thr);
+		errno = err;
+
+		return (-1);
+	}
+
+	pthread_attr_destroy(&pth_attr);
+
+	thr->next = pool->thr;
+	pool->thr = thr;
+	pool->stats.threads = ++pool->thr_cnt;
+
+	return (0);
+}
+
+probe_workerpool_t *probe_workerpool_new(uint32_t max_threads)
+{
+	probe_workerpool_t *pool;
+
+	pool = oscap_talloc(probe_workerpool_t);
+	memset(pool, 0, sizeof(probe_workerpool_t));
+
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->cond, NULL);
+
+	pool->max_threads = max_threads > 0 ? max_threads : 1;
+	clock_gettime(CLOCK_MONOTONIC, &pool->created);
+
+	return (pool);
+}
+
+int probe_workerpool_add(probe_workerpool_t *pool, probe_pwpair_t *pair)
+{
+	bool need_thread;
+
+	pthread_mutex_lock(&pool->lock);
+
+	if (pool->stop) {
+		pthread_mutex_unlock(&pool->lock);
+		errno = ECANCELED;
+		return (-1);
+	}
+
+	/*
+	 * Start a new thread if there are not enough idle threads
+	 * to handle the queued requests. The threads blocked by
+	 * probe_workerpool_block() don't count to the limit.
+	 */
+	need_thread = pool->idle_cnt <= pool->qlen;
+
+	if (need_thread && pool->thr_cnt - pool->blocked_cnt < pool->max_threads) {
+		if (probe_workerpool_spawn(pool) == 0) {
+			need_thread = false;
+		} else if (pool->thr_cnt == pool->blocked_cnt) {
+			/* No thread would ever handle the request */
+			int err = errno;
+
+			pthread_mutex_unlock(&pool->lock);
+			errno = err;
+			return (-1);
+		}
+	}
+
+	if (need_thread)
+		++pool->stats.waited;
+
+	pair->next = NULL;
+	clock_gettime(CLOCK_MONOTONIC, &pair->queued);
+
+	if (pool->tail != NULL)
+		pool->tail->next = pair;
+	else
+		pool->head = pair;
+
+	pool->tail = pair;
+
+	if (++pool->qlen > pool->stats.queue_max)
+		pool->stats.queue_max = pool->qlen;
+
+	pthread_cond_signal(&pool->cond);
+	pthread_mutex_unlock(&pool->lock);
+
+	return (0);
+}
+
+void probe_workerpool_block(probe_workerpool_t *pool)
+{
+	pthread_mutex_lock(&pool->lock);
+
+	if (++pool->blocked_cnt > pool->stats.blocked_max)
+		pool->stats.blocked_max = pool->blocked_cnt;
+
+	/*
+	 * The requests waiting in the queue may be the ones the blocked
+	 * thread waits for, make sure that there's a thread for them.
+	 */
+	if (!pool->stop && pool->idle_cnt < pool->qlen &&
+	    pool->thr_cnt - pool->blocked_cnt < pool->max_threads)
+		probe_workerpool_spawn(pool);
+
+	pthread_mutex_unlock(&pool->lock);
+}
+
+void probe_workerpool_unblock(probe_workerpool_t *pool)
+{
+	pthread_mutex_lock(&pool->lock);
+	--pool->blocked_cnt;
+	pthread_mutex_unlock(&pool->lock);
+}
+
+void probe_workerpool_cancel(probe_workerpool_t *pool)
+{
+	probe_pwpair_t *pair;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = true;
+	pool->canceled = true;
+
+	while ((pair = pool->head) != NULL) {
+		pool->head = pair->next;
+		free(pair);
+	}
+
+	pool->tail = NULL;
+	pool->qlen = 0;
+
+	pthread_cond_broadcast(&pool->cond);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+int probe_workerpool_cancel_request(probe_workerpool_t *pool, probe_worker_t *pth)
+{
+	probe_workerpool_thr_t *thr;
+
+	pthread_mutex_lock(&pool->lock);
+
+	for (thr = pool->thr; thr != NULL; thr = thr->next) {
+		if (thr->request == pth)
+			break;
+	}
+
+	if (thr == NULL) {
+		/* The request isn't being evaluated */
+		pthread_mutex_unlock(&pool->lock);
+		return (0);
+	}
+
+	thr->canceled = true;
+	pthread_cancel(thr->tid);
+	pthread_mutex_unlock(&pool->lock);
+
+	/*
+	 * Wait till the thread is canceled (it may temporarily disable
+	 * cancelability), but at most 60 seconds.
+	 */
+#if defined(HAVE_PTHREAD_TIMEDJOIN_NP) && defined(HAVE_CLOCK_GETTIME)
+	{
+		struct timespec j_tm;
+
+		if (clock_gettime(CLOCK_REALTIME, &j_tm) == -1) {
+			dE("clock_gettime(CLOCK_REALTIME): %d, %s.", errno, strerror(errno));
+			return (-1);
+		}
+
+		j_tm.tv_sec += 60;
+
+		if ((errno = pthread_timedjoin_np(thr->tid, NULL, &j_tm)) != 0) {
+			dE("[%llu] pthread_timedjoin_np: %d, %s.", (unsigned long long)pth->sid, errno, strerror(errno));
+			return (-1);
+		}
+	}
+#else
+	if ((errno = pthread_join(thr->tid, NULL)) != 0) {
+		dE("pthread_join: %d, %s.", errno, strerror(errno));
+		return (-1);
+	}
+#endif
+	pthread_mutex_lock(&pool->lock);
+	thr->joined = true;
+
+	/* The request was interrupted, it wasn't freed by the thread */
+	free(thr->current);
+	thr->current = NULL;
+	thr->request = NULL;
+
+	pthread_mutex_unlock(&pool->lock);
+
+	return (0);
+}
+
+void probe_workerpool_stats(probe_workerpool_t *pool, probe_workerpool_stats_t *stats)
+{
+	pthread_mutex_lock(&pool->lock);
+	memcpy(stats, &pool->stats, sizeof(probe_workerpool_stats_t));
+	pthread_mutex_unlock(&pool->lock);
+}
+
+void probe_workerpool_free(probe_workerpool_t *pool)
+{
+	probe_workerpool_stats_t stats;
+	probe_workerpool_thr_t *thr, *next;
+	struct timespec now;
+	double lifetime;
+
+	if (pool == NULL)
+		return;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = true;
+	pthread_cond_broadcast(&pool->cond);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (thr = pool->thr; thr != NULL; thr = next) {
+		next = thr->next;
+
+		if (!thr->joined) {
+			/* Threads which didn't react to cancellation are left alone */
+			if (thr->canceled || (pool->canceled && thr->current != NULL))
+				continue;
+
+			pthread_join(thr->tid, NULL);
+		}
+
+		free(thr);
+	}
+
+	probe_workerpool_stats(pool, &stats);
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	lifetime = timespec_diff(&pool->created, &now);
+
+	dI("Worker pool: %u thread(s) of %u, %llu request(s), %llu waited for a thread, "
+	   "max. queue length %zu, max. busy threads %u, max. blocked threads %u, "
+	   "avg. wait %.3f ms, utilization %.1f%%",
+	   stats.threads, pool->max_threads,
+	   (unsigned long long)stats.jobs, (unsigned long long)stats.waited,
+	   stats.queue_max, stats.busy_max, stats.blocked_max,
+	   stats.jobs > 0 ? stats.wait_time / stats.jobs * 1e3 : 0.0,
+	   stats.threads > 0 && lifetime > 0 ? stats.busy_time / (stats.threads * lifetime) * 100 : 0.0);
+
+	pthread_cond_destroy(&pool->cond);
+	pthread_mutex_destroy(&pool->lock);
+	free(pool);
+}
+
 struct probe_varref_ctx {
 	SEXP_t *pi2;
 	unsigned int ent_cnt;
@@ -362,7 +730,7 @@ static SEXP_t *probe_ste_fetch(probe_t *probe, SEXP_t *id_list)
  * Evaluate an OVAL object identified by its id. Using a remote
  * synchronous SEAP command, this function executes evaluation of an
  * OVAL object which results weren't found in the probe cache. This
- * indirectly spawns a new thread in the probe process which evaluates
+ * indirectly queues a request for a worker thread which evaluates
  * the object and stores the result in the probe cache. That result is
  * not send to the library because it doesn't know how to handle
  * it. Instead, the result is fetched by this function from the cache
@@ -374,7 +742,13 @@ static SEXP_t *probe_obj_eval(probe_t *probe, SEXP_t *id)
 {
 	SEXP_t *res, *rid;
 
+	/*
+	 * The object is evaluated by an other worker thread of this probe
+	 * if it's of the same type, this thread must not hold it up.
+	 */
+	probe_workerpool_block(probe->pool);
 	res = SEAP_cmd_exec(probe->SEAP_ctx, probe->sd, 0, PROBECMD_OBJ_EVAL, id, SEAP_CMDTYPE_SYNC, NULL, NULL);
+	probe_workerpool_unblock(probe->pool);
 
 	rid = SEXP_list_first(res);
 	assume_r(SEXP_string_cmp(id, rid) == 0, NULL);
@@ -893,27 +1267,28 @@ static SEXP_t *probe_set_eval(probe_t *probe, SEXP_t *set, size_t depth)
 }
 
 /**
- * Worker thread function. This functions handles the evalution of objects and sets.
- * @param msg_in SEAP message with the request which contains the object to be evaluated
- * @param ret pointer to the return code storage
+ * Set the collected object of the probe context and reset
+ * the collected object statistics.
  */
-SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
+static void probe_ctx_setcobj(struct probe_ctx *ctx, SEXP_t *cobj)
 {
-	SEXP_t *probe_in, *probe_out, *set;
+	ctx->probe_out      = cobj;
+	ctx->cobj_itemcnt   = 0;
+	ctx->cobj_size      = 0;
+	ctx->mcheck_itemcnt = 0;
+	ctx->mcheck_size    = 0;
+	ctx->mcheck_result  = 0;
+}
 
-	if (msg_in == NULL) {
-		*ret = PROBE_EINVAL;
-		return (NULL);
-	}
+/*
+ * Evaluate an object or a set. The reference to the input object is
+ * not consumed.
+ */
+static SEXP_t *probe_worker_eval(probe_t *probe, SEXP_t *probe_in, int *ret)
+{
+	SEXP_t *probe_out, *set;
 
-	probe_in  = SEAP_msg_get(msg_in);
 	probe_out = NULL;
-
-	if (probe_in == NULL) {
-		*ret = PROBE_ENOOBJ;
-		return (NULL);
-	}
-
 	set = probe_obj_getent(probe_in, "set", 1);
 
 	if (set != NULL) {
@@ -944,7 +1319,7 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 			SEXP_free(mask);
 			
                         pctx.probe_in  = probe_in;
-                        pctx.probe_out = probe_out;
+                        probe_ctx_setcobj(&pctx, probe_out);
 
                         /*
                          * Run the main function of the probe implementation. Set thread
@@ -972,7 +1347,7 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 			dD("handling varrefs in object");
 
 			if (probe_varref_create_ctx(probe_in, varrefs, &ctx) != 0) {
-				SEXP_vfree(varrefs, pctx.filters, probe_in, mask, NULL);
+				SEXP_vfree(varrefs, pctx.filters, mask, NULL);
 				*ret = PROBE_EUNKNOWN;
 				return (NULL);
 			}
@@ -987,7 +1362,7 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 				cobj = probe_cobj_new(SYSCHAR_FLAG_UNKNOWN, NULL, NULL, mask);
 
                                 pctx.probe_in  = ctx->pi2;
-                                pctx.probe_out = cobj;
+                                probe_ctx_setcobj(&pctx, cobj);
                                 /*
                                  * Run the main function of the probe implementation
                                  */
@@ -1012,8 +1387,268 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
                 SEXP_free(pctx.filters);
 	}
 
-	SEXP_free(probe_in);
 	SEXP_VALIDATE(probe_out);
 
 	return (probe_out);
 }
+
+/**
+ * Worker thread function. This functions handles the evalution of objects and sets.
+ * @param msg_in SEAP message with the request which contains the object to be evaluated
+ * @param ret pointer to the return code storage
+ */
+SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
+{
+	SEXP_t *probe_in, *probe_out;
+
+	if (msg_in == NULL) {
+		*ret = PROBE_EINVAL;
+		return (NULL);
+	}
+
+	probe_in = SEAP_msg_get(msg_in);
+
+	if (probe_in == NULL) {
+		*ret = PROBE_ENOOBJ;
+		return (NULL);
+	}
+
+	probe_out = probe_worker_eval(probe, probe_in, ret);
+	SEXP_free(probe_in);
+
+	return (probe_out);
+}
+
+/*
+ * Batch requests
+ *
+ * The message contains a list of objects of the same type. A reply is sent
+ * for each of them in the order of the list; an object which couldn't be
+ * evaluated gets a SEAP error instead. Simple objects (without sets and
+ * variable references) are passed to probe_main_batch at once so that the
+ * probe can collect them in a single pass, the others are evaluated one by
+ * one. Results of failed evaluations are not cached so that a subsequent
+ * single request for the object gets the same reply as without batching.
+ */
+static bool probe_obj_is_simple(SEXP_t *obj)
+{
+	SEXP_t *ent;
+
+	if ((ent = probe_obj_getent(obj, "set", 1)) != NULL) {
+		SEXP_free(ent);
+		return (false);
+	}
+
+	if (OSCAP_GSYM(varref_handling) && (ent = probe_obj_getent(obj, "varrefs", 1)) != NULL) {
+		SEXP_free(ent);
+		return (false);
+	}
+
+	return (true);
+}
+
+/*
+ * Get the result of an object which doesn't need to be evaluated,
+ * see probe_input_handler.
+ */
+static SEXP_t *probe_batch_lookup(probe_t *probe, SEXP_t *obj, int *ret)
+{
+	SEXP_t *oid, *res, *skip_flag, *mask;
+
+	*ret = 0;
+	oid  = probe_obj_getattrval(obj, "id");
+
+	if (oid == NULL) {
+		dE("No `id' attribute");
+		*ret = PROBE_ENOATTR;
+		return (NULL);
+	}
+
+	if ((OSCAP_GSYM(offline_mode) != PROBE_OFFLINE_NONE) &&
+	    !(OSCAP_GSYM(offline_mode) & OSCAP_GSYM(offline_mode_supported))) {
+		dW("Requested offline mode is not supported by %s.", probe->name);
+		SEXP_free(oid);
+		return probe_cobj_new(OSCAP_GSYM(offline_mode_cobjflag), NULL, NULL, NULL);
+	}
+
+	res = probe_rcache_sexp_get(probe->rcache, oid);
+
+	if (res == NULL && (skip_flag = probe_obj_getattrval(obj, "skip_eval")) != NULL) {
+		mask = probe_obj_getmask(obj);
+		res  = probe_cobj_new(SEXP_number_geti_32(skip_flag), NULL, NULL, mask);
+
+		if (probe_rcache_sexp_add(probe->rcache, oid, res) != 0) {
+			dE("Unable to cache the result of a skipped object");
+			SEXP_free(res);
+			res  = NULL;
+			*ret = PROBE_EUNKNOWN;
+		}
+
+		SEXP_vfree(skip_flag, mask, NULL);
+	}
+
+	SEXP_free(oid);
+
+	return (res);
+}
+
+/*
+ * Cache the result of an object. The object fails if its result can't be
+ * cached, e.g. when the batch contains the same object twice.
+ */
+static int probe_batch_cache(probe_t *probe, SEXP_t *obj, SEXP_t *res)
+{
+	SEXP_t *oid, *items;
+	int ret = 0;
+
+	oid   = probe_obj_getattrval(obj, "id");
+	items = probe_cobj_get_items(res);
+
+	if (items != NULL) {
+		SEXP_list_sort(items, SEXP_refcmp);
+		SEXP_free(items);
+	}
+
+	if (probe_rcache_sexp_add(probe->rcache, oid, res) != 0) {
+		dE("Unable to cache the result of an object");
+		ret = PROBE_EUNKNOWN;
+	}
+
+	SEXP_free(oid);
+
+	return (ret);
+}
+
+static void probe_worker_batch(probe_pwpair_t *pair)
+{
+	probe_t *probe = pair->probe;
+	SEXP_t  *objs, **obj, **res, *mask;
+	SEXP_list_it *objs_it;
+	struct probe_ctx *pctx;
+	probe_ctx **batch;
+	int     *ret, *batch_ret, r;
+	size_t   count, batch_cnt, i, j;
+	bool     canceled;
+
+	objs  = SEAP_msg_get(pair->pth->msg);
+	count = SEXP_list_length(objs);
+
+	dD("batch request ID %u: %zu objects", pair->pth->sid, count);
+
+	obj   = calloc(count, sizeof(SEXP_t *));
+	res   = calloc(count, sizeof(SEXP_t *));
+	ret   = calloc(count, sizeof(int));
+	pctx  = calloc(count, sizeof(struct probe_ctx));
+	batch = calloc(count, sizeof(probe_ctx *));
+	batch_ret = calloc(count, sizeof(int));
+	batch_cnt = 0;
+
+	objs_it = SEXP_list_it_new(objs);
+
+	for (i = 0; i < count; ++i) {
+		obj[i] = SEXP_ref(SEXP_list_it_next(objs_it));
+		res[i] = probe_batch_lookup(probe, obj[i], &ret[i]);
+
+		if (res[i] != NULL || ret[i] != 0)
+			continue;
+
+		if (!probe_obj_is_simple(obj[i])) {
+			res[i] = probe_worker_eval(probe, obj[i], &ret[i]);
+
+			if (ret[i] == 0 && res[i] != NULL)
+				ret[i] = probe_batch_cache(probe, obj[i], res[i]);
+			continue;
+		}
+
+		mask   = probe_obj_getmask(obj[i]);
+		res[i] = probe_cobj_new(SYSCHAR_FLAG_UNKNOWN, NULL, NULL, mask);
+		SEXP_free(mask);
+
+		pctx[i].icache   = probe->icache;
+		pctx[i].filters  = probe_prepare_filters(probe, obj[i]);
+		pctx[i].probe_in = obj[i];
+		probe_ctx_setcobj(&pctx[i], res[i]);
+
+		batch[batch_cnt++] = &pctx[i];
+	}
+
+	SEXP_list_it_free(objs_it);
+
+	if (batch_cnt > 0) {
+		int __unused_oldstate;
+
+		pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS, &__unused_oldstate);
+		r = probe_main_batch(batch, batch_ret, batch_cnt, probe->probe_arg);
+
+		if (r == PROBE_EOPNOTSUPP) {
+			for (j = 0; j < batch_cnt; ++j)
+				batch_ret[j] = probe_main(batch[j], probe->probe_arg);
+		} else if (r != 0) {
+			for (j = 0; j < batch_cnt; ++j)
+				batch_ret[j] = r;
+		}
+		pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, &__unused_oldstate);
+
+		/*
+		 * Synchronize
+		 */
+		probe_icache_nop(probe->icache);
+
+		for (j = 0; j < batch_cnt; ++j) {
+			i = batch[j] - pctx;
+
+			probe_cobj_compute_flag(res[i]);
+			SEXP_free(pctx[i].filters);
+
+			if ((ret[i] = batch_ret[j]) == 0)
+				ret[i] = probe_batch_cache(probe, obj[i], res[i]);
+		}
+	}
+
+	canceled = rbt_i32_del(probe->workers, pair->pth->sid, NULL) != 0;
+
+	if (canceled) {
+		dW("thread not found in the probe thread tree, probably canceled by an external signal");
+	} else {
+		for (i = 0; i < count; ++i) {
+			if (ret[i] != 0 || res[i] == NULL) {
+				r = SEAP_replyerr(probe->SEAP_ctx, probe->sd, pair->pth->msg,
+						  ret[i] != 0 ? ret[i] : PROBE_EUNKNOWN);
+			} else {
+				SEAP_msg_t *seap_reply;
+
+				seap_reply = SEAP_msg_new();
+				SEAP_msg_set(seap_reply, res[i]);
+				r = SEAP_reply(probe->SEAP_ctx, probe->sd, seap_reply, pair->pth->msg);
+				SEAP_msg_free(seap_reply);
+			}
+
+			if (r == -1) {
+				/*
+				 * The connection is broken, the rest of the
+				 * batch can't be sent either
+				 */
+				dE("An error ocured while sending the reply. errno=%u, %s.", errno, strerror(errno));
+				break;
+			}
+		}
+	}
+
+	for (i = 0; i < count; ++i)
+		SEXP_vfree(obj[i], res[i], NULL);
+
+	free(obj);
+	free(res);
+	free(ret);
+	free(pctx);
+	free(batch);
+	free(batch_ret);
+	SEXP_free(objs);
+
+	/* The message of a canceled request is freed by the signal handler */
+	if (!canceled) {
+		SEAP_msg_free(pair->pth->msg);
+		free(pair->pth);
+	}
+	free(pair);
+}
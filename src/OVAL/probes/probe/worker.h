@@ -25,6 +25,8 @@
 #include <seap.h>
 #include <sexp.h>
 #include <pthread.h>
+#include <stdbool.h>
+#include <time.h>
 #include "probe.h"
 
 #ifndef PROBE_WORKER_DEFAULT_MAX_THREADS
@@ -37,18 +39,92 @@
 
 typedef struct {
 	SEAP_msgid_t sid; /**< SEAP message handled by this thread */
-	pthread_t    tid; /**< thread ID */
+	pthread_t    tid; /**< ID of the thread evaluating the request */
 	SEXP_t * (*msg_handler)(probe_t *, SEAP_msg_t *, int *); /**< input message (object) handler */
 	SEAP_msg_t  *msg; /**< the message being handled */
 } probe_worker_t;
 
-typedef struct {
+typedef struct probe_pwpair {
 	probe_t        *probe;
 	probe_worker_t *pth;
+	struct probe_pwpair *next;   /**< next request in the work queue */
+	struct timespec      queued; /**< time when the request was queued */
 } probe_pwpair_t;
 
+/**
+ * Worker pool statistics
+ */
+typedef struct {
+	uint32_t threads;   /**< number of started threads */
+	uint32_t busy_max;  /**< maximum number of concurrently busy threads */
+	uint32_t blocked_max; /**< maximum number of concurrently blocked threads */
+	size_t   queue_max; /**< maximum length of the work queue */
+	uint64_t jobs;      /**< number of handled requests */
+	uint64_t waited;    /**< number of requests which had to wait for a busy thread */
+	double   wait_time; /**< total time the requests spent in the queue (seconds) */
+	double   busy_time; /**< total time spent by handling the requests (seconds) */
+} probe_workerpool_stats_t;
+
+typedef struct probe_workerpool probe_workerpool_t;
+
 probe_worker_t *probe_worker_new(void);
 void *probe_worker_runfn(void *arg);
 SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret);
 
+/**
+ * Create a new worker pool. The threads are started on demand and
+ * they are reused for subsequent requests.
+ * @param max_threads maximum number of worker threads, not counting
+ *        the threads blocked by probe_workerpool_block()
+ */
+probe_workerpool_t *probe_workerpool_new(uint32_t max_threads);
+
+/**
+ * Queue a request for evaluation by a worker thread.
+ * @return 0 on success, -1 if the request can't be handled (the pool
+ *         was canceled or no thread could be started)
+ */
+int probe_workerpool_add(probe_workerpool_t *pool, probe_pwpair_t *pair);
+
+/**
+ * Mark the calling worker thread as blocked until the library answers
+ * a request of the thread, e.g. the evaluation of an object referenced
+ * by a set. The library may send new requests to the probe meanwhile,
+ * a new thread is started for them if needed.
+ */
+void probe_workerpool_block(probe_workerpool_t *pool);
+
+/**
+ * Mark the calling worker thread as busy again.
+ */
+void probe_workerpool_unblock(probe_workerpool_t *pool);
+
+/**
+ * Stop the pool: drop the queued requests and let the idle threads
+ * terminate. The requests being evaluated have to be canceled by
+ * probe_workerpool_cancel_request(). The messages of the dropped
+ * requests are left in the probe_t.workers tree.
+ */
+void probe_workerpool_cancel(probe_workerpool_t *pool);
+
+/**
+ * Cancel the thread evaluating the given request and wait till it
+ * terminates, but at most 60 seconds. The caller has to remove the
+ * request from the probe_t.workers tree first and frees its message
+ * if the request isn't used anymore.
+ * @return 0 if the request isn't being evaluated anymore, -1 if the
+ *         thread didn't terminate in time
+ */
+int probe_workerpool_cancel_request(probe_workerpool_t *pool, probe_worker_t *pth);
+
+/**
+ * Get a snapshot of the pool statistics.
+ */
+void probe_workerpool_stats(probe_workerpool_t *pool, probe_workerpool_stats_t *stats);
+
+/**
+ * Wait for the worker threads to finish and free the pool.
+ */
+void probe_workerpool_free(probe_workerpool_t *pool);
+
 #endif /* WORKER_H */
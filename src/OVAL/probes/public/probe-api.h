@@ -475,10 +475,31 @@ OSCAP_API void probe_preload(void);
 OSCAP_API void *probe_init(void) __attribute__ ((unused));
 OSCAP_API void probe_fini(void *) __attribute__ ((unused));
 
+/**
+ * Called when the probe receives the reset command, i.e. before
+ * a new scan. A probe can implement this function to drop data
+ * it keeps across the objects of a scan.
+ * @param arg value returned by probe_init
+ */
+OSCAP_API void probe_reset(void *arg);
+
 typedef struct probe_ctx probe_ctx;
 
 OSCAP_API int probe_main(probe_ctx *, void *) __attribute__ ((nonnull(1)));
 
+/**
+ * Evaluate the objects of a batch request at once. A probe can implement
+ * this function to collect all the objects in a single pass over its data
+ * source. The objects don't contain sets or variable references.
+ * @param ctx contexts of the objects
+ * @param ret return codes of probe_main for each object are stored here
+ * @param count number of objects
+ * @param arg value returned by probe_init
+ * @return 0 on success, PROBE_EOPNOTSUPP if the probe doesn't support
+ *         batches; the objects are then evaluated using probe_main
+ */
+OSCAP_API int probe_main_batch(probe_ctx *ctx[], int ret[], size_t count, void *arg);
+
 OSCAP_API bool probe_item_filtered(const SEXP_t *item, const SEXP_t *filters);
 
 OSCAP_API int probe_result_additem(SEXP_t *result, SEXP_t *item);
@@ -54,6 +54,7 @@
 
 #include <probe/probe.h>
 #include <probe/option.h>
+#include <probe/fcache.h>
 #include "oval_fts.h"
 #include "SEAP/generic/rbt/rbt.h"
 #include "common/debug_priv.h"
@@ -248,7 +249,7 @@ static SEXP_t *get_size(struct stat *st, SEXP_t *sexp)
 static SEXP_t *has_extended_acl(const char *path)
 {
 #if defined(HAVE_ACL_EXTENDED_FILE)
-	int has_acl = acl_extended_file(path);
+	int has_acl = probe_fcache_acl_extended(path, acl_extended_file);
 	if (has_acl == -1) {
 		dD("Getting extended ACL for file '%s' has failed, %s", path, strerror(errno));
 		return NULL;
@@ -276,7 +277,7 @@ static int file_cb (const char *p, const char *f, void *ptr)
 		st_path = path_buffer;
 	}
 
-        if (lstat (st_path, &st) == -1) {
+        if (probe_fcache_lstat(st_path, &st) == -1) {
                 dI("lstat failed when processing %s: errno=%u, %s.", st_path, errno, strerror (errno));
 		/*
 		 * Whatever the reason of this lstat error (for example the file may
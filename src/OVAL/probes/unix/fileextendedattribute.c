@@ -45,6 +45,7 @@
 
 #include <probe/probe.h>
 #include <probe/option.h>
+#include <probe/fcache.h>
 #include "probe/entcmp.h"
 #include "oval_fts.h"
 #include "common/debug_priv.h"
@@ -105,7 +106,7 @@ static int file_cb (const char *p, const char *f, void *ptr)
 
 	do {
 		/* estimate the size of the buffer */
-		xattr_count = llistxattr(st_path, NULL, 0);
+		xattr_count = probe_fcache_listxattr(st_path, NULL, 0);
 
 		if (xattr_count == 0)
 				return (0);
@@ -120,7 +121,7 @@ static int file_cb (const char *p, const char *f, void *ptr)
 		xattr_buf    = realloc(xattr_buf, sizeof(char) * xattr_buflen);
 
 		/* fill the buffer */
-		xattr_count = llistxattr(st_path, xattr_buf, xattr_buflen);
+		xattr_count = probe_fcache_listxattr(st_path, xattr_buf, xattr_buflen);
 
 		/* check & retry if needed */
 	} while (errno == ERANGE);
@@ -148,7 +149,7 @@ static int file_cb (const char *p, const char *f, void *ptr)
                         ssize_t xattr_vallen = -1;
                         char   *xattr_val = NULL;
 
-                        xattr_vallen = lgetxattr(st_path, xattr_buf + i, NULL, 0);
+                        xattr_vallen = probe_fcache_getxattr(st_path, xattr_buf + i, NULL, 0);
                 retry_value:
                         if (xattr_vallen >= 0) {
 				// Check possible buffer overflow
@@ -162,7 +163,7 @@ static int file_cb (const char *p, const char *f, void *ptr)
 
 				// we don't want to override space for '\0' by call of 'lgetxattr'
 				// we pass only 'xattr_vallen' instead of 'xattr_vallen + 1'
-                                xattr_vallen = lgetxattr(st_path, xattr_buf + i, xattr_val, xattr_vallen);
+                                xattr_vallen = probe_fcache_getxattr(st_path, xattr_buf + i, xattr_val, xattr_vallen);
 
                                 if (xattr_vallen < 0 || errno == ERANGE)
                                         goto retry_value;
@@ -44,10 +44,8 @@ static int opencache (void) {
         return 1;
 }
 
-struct dpkginfo_reply_t * dpkginfo_get_by_name(const char *name, int *err)
+static struct dpkginfo_reply_t * dpkginfo_lookup(pkgCache &cache, pkgRecords &Recs, const char *name, int *err)
 {
-        pkgCache &cache = *cgCache;
-        pkgRecords Recs (cache);
         struct dpkginfo_reply_t *reply = NULL;
 
         // Locate the package
@@ -109,6 +107,29 @@ struct dpkginfo_reply_t * dpkginfo_get_by_name(const char *name, int *err)
         return reply;
 }
 
+struct dpkginfo_reply_t * dpkginfo_get_by_name(const char *name, int *err)
+{
+        pkgCache &cache = *cgCache;
+        pkgRecords Recs (cache);
+
+        return dpkginfo_lookup(cache, Recs, name, err);
+}
+
+void dpkginfo_get_by_names(const char *names[], size_t count, struct dpkginfo_reply_t *replies[], int err[])
+{
+        pkgCache &cache = *cgCache;
+        pkgRecords Recs (cache);
+
+        for (size_t i = 0; i < count; ++i) {
+                if (names[i] == NULL) {
+                        replies[i] = NULL;
+                        continue;
+                }
+
+                replies[i] = dpkginfo_lookup(cache, Recs, names[i], &err[i]);
+        }
+}
+
 void * dpkginfo_free_reply(struct dpkginfo_reply_t *reply)
 {
         if (reply) {
@@ -22,6 +22,8 @@
 #ifndef __DPKGINFO_HELPER__
 #define __DPKGINFO_HELPER__
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -40,6 +42,12 @@ int dpkginfo_fini();
 
 struct dpkginfo_reply_t * dpkginfo_get_by_name(const char *name, int *err);
 
+/*
+ * Look up several packages at once, the package records are opened only
+ * once. NULL names are skipped.
+ */
+void dpkginfo_get_by_names(const char *names[], size_t count, struct dpkginfo_reply_t *replies[], int err[]);
+
 void * dpkginfo_free_reply(struct dpkginfo_reply_t *reply);
 
 #ifdef __cplusplus
@@ -46,6 +46,7 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <assert.h>
@@ -86,18 +87,10 @@ void probe_fini (void *ptr)
         return;
 }
 
-int probe_main (probe_ctx *ctx, void *arg)
+static int dpkginfo_get_request(SEXP_t *obj, char **request_st)
 {
-	SEXP_t *val, *item, *ent, *obj;
-        char *request_st = NULL;
-        struct dpkginfo_reply_t *dpkginfo_reply = NULL;
-        int errflag;
-
-	if (arg == NULL) {
-		return PROBE_EINIT;
-	}
+	SEXP_t *val, *ent;
 
-	obj = probe_ctx_getobject(ctx);
 	ent = probe_obj_getent(obj, "name", 1);
 
         if (ent == NULL) {
@@ -105,17 +98,17 @@ int probe_main (probe_ctx *ctx, void *arg)
         }
 
         val = probe_ent_getval (ent);
+        SEXP_free (ent);
 
         if (val == NULL) {
                 dI("%s: no value", "name");
-                SEXP_free (ent);
                 return (PROBE_ENOVAL);
         }
 
-        request_st = SEXP_string_cstr (val);
+        *request_st = SEXP_string_cstr (val);
         SEXP_free (val);
 
-        if (request_st == NULL) {
+        if (*request_st == NULL) {
                 switch (errno) {
                 case EINVAL:
                         dI("%s: invalid value type", "name");
@@ -130,10 +123,13 @@ int probe_main (probe_ctx *ctx, void *arg)
                 }
         }
 
-        /* get info from debian apt cache */
-        pthread_mutex_lock (&(g_dpkg.mutex));
-        dpkginfo_reply = dpkginfo_get_by_name(request_st, &errflag);
-        pthread_mutex_unlock (&(g_dpkg.mutex));
+	return (0);
+}
+
+static void dpkginfo_collect(probe_ctx *ctx, const char *request_st,
+			     struct dpkginfo_reply_t *dpkginfo_reply, int errflag)
+{
+	SEXP_t *item;
 
         if (dpkginfo_reply == NULL) {
                 switch (errflag) {
@@ -157,7 +153,7 @@ int probe_main (probe_ctx *ctx, void *arg)
                 int i;
                 int num_items = 1; /* FIXME */
 		oval_datatype_t evr_string_type;
-		oval_schema_version_t oval_version = probe_obj_get_platform_schema_version(obj);
+		oval_schema_version_t oval_version = probe_obj_get_platform_schema_version(probe_ctx_getobject(ctx));
 		if (oval_schema_version_cmp(oval_version, OVAL_SCHEMA_VERSION(5.11.1)) >= 0) {
 			evr_string_type = OVAL_DATATYPE_DEBIAN_EVR_STRING;
 		} else {
@@ -180,9 +176,69 @@ int probe_main (probe_ctx *ctx, void *arg)
                         dpkginfo_free_reply(dpkginfo_reply);
                 }
         }
+}
+
+int probe_main (probe_ctx *ctx, void *arg)
+{
+        char *request_st = NULL;
+        struct dpkginfo_reply_t *dpkginfo_reply = NULL;
+        int errflag, ret;
+
+	if (arg == NULL) {
+		return PROBE_EINIT;
+	}
+
+	if ((ret = dpkginfo_get_request(probe_ctx_getobject(ctx), &request_st)) != 0)
+		return (ret);
+
+        /* get info from debian apt cache */
+        pthread_mutex_lock (&(g_dpkg.mutex));
+        dpkginfo_reply = dpkginfo_get_by_name(request_st, &errflag);
+        pthread_mutex_unlock (&(g_dpkg.mutex));
+
+	dpkginfo_collect(ctx, request_st, dpkginfo_reply, errflag);
+        free(request_st);
+
+        return (0);
+}
+
+/*
+ * All packages of a batch are looked up while holding the lock once
+ * and using the same package records.
+ */
+int probe_main_batch (probe_ctx *ctx[], int ret[], size_t count, void *arg)
+{
+        char **request_st;
+        struct dpkginfo_reply_t **dpkginfo_reply;
+        int *errflag;
+        size_t i;
+
+	if (arg == NULL) {
+		return PROBE_EINIT;
+	}
+
+        request_st     = calloc(count, sizeof(char *));
+        dpkginfo_reply = calloc(count, sizeof(struct dpkginfo_reply_t *));
+        errflag        = calloc(count, sizeof(int));
+
+        for (i = 0; i < count; ++i)
+                ret[i] = dpkginfo_get_request(probe_ctx_getobject(ctx[i]), &request_st[i]);
+
+        /* get info from debian apt cache */
+        pthread_mutex_lock (&(g_dpkg.mutex));
+        dpkginfo_get_by_names((const char **)request_st, count, dpkginfo_reply, errflag);
+        pthread_mutex_unlock (&(g_dpkg.mutex));
+
+        for (i = 0; i < count; ++i) {
+                if (ret[i] == 0)
+                        dpkginfo_collect(ctx[i], request_st[i], dpkginfo_reply[i], errflag[i]);
+
+                free(request_st[i]);
+        }
 
-        SEXP_vfree(ent, NULL);
         free(request_st);
+        free(dpkginfo_reply);
+        free(errflag);
 
         return (0);
 }
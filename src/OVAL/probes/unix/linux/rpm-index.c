@@ -0,0 +1,510 @@
+/*
+ * Copyright 2015 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <limits.h>
+#include <regex.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "probe-api.h"
+#include "probe/entcmp.h"
+#include "common/debug_priv.h"
+#include "rpm-index.h"
+
+#define RPM_INDEX_INITIAL_COUNT 1024
+
+static struct {
+	pthread_mutex_t lock;
+	pthread_once_t once;
+	bool enabled;
+	char *dbpath;
+	struct rpm_index *idx;
+	bool keyid_regex_ok;
+	regex_t keyid_regex;
+} rpm_indexes = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.once = PTHREAD_ONCE_INIT
+};
+
+static const char keyid_regex_string[] = "Key ID [a-fA-F0-9]{16}";
+
+static void rpm_index_init(void)
+{
+	const char *env = getenv(RPM_INDEX_ENV);
+
+	rpm_indexes.enabled = (env == NULL || strcmp(env, "0") != 0);
+
+	if (regcomp(&rpm_indexes.keyid_regex, keyid_regex_string, REG_EXTENDED) == 0)
+		rpm_indexes.keyid_regex_ok = true;
+	else
+		dE("regcomp(%s) failed.", keyid_regex_string);
+}
+
+/*
+ * The rpm mutex is locked the same way the probes lock it,
+ * see RPM_MUTEX_LOCK.
+ */
+static int rpm_lock(struct rpm_probe_global *rpm)
+{
+	RPM_MUTEX_LOCK(&rpm->mutex);
+	return 0;
+}
+
+static void rpm_unlock(struct rpm_probe_global *rpm)
+{
+	RPM_MUTEX_UNLOCK(&rpm->mutex);
+}
+
+/* Has to be called with the rpm mutex held */
+static char *rpm_db_path(struct rpm_probe_global *rpm)
+{
+	const char *root;
+	char *dbpath, *path;
+
+	root = rpmtsRootDir(rpm->rpmts);
+	if (root == NULL || strcmp(root, "/") == 0)
+		root = "";
+
+	dbpath = rpmExpand("%{_dbpath}", NULL);
+	path = oscap_sprintf("%s%s", root, dbpath != NULL ? dbpath : "");
+	free(dbpath);
+
+	return path;
+}
+
+/*
+ * Latest modification time of the database directory and of the files
+ * holding the packages in any of the database formats.
+ */
+static unsigned long long rpm_db_mtime(const char *dbpath)
+{
+	static const char *const files[] = { "", "/Packages", "/Packages.db", "/rpmdb.sqlite" };
+	char path[PATH_MAX];
+	struct stat st;
+	unsigned long long mtime = 0, t;
+
+	for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); ++i) {
+		snprintf(path, sizeof(path), "%s%s", dbpath, files[i]);
+		if (stat(path, &st) != 0)
+			continue;
+		t = (unsigned long long)st.st_mtim.tv_sec * 1000000000ULL + st.st_mtim.tv_nsec;
+		if (t > mtime)
+			mtime = t;
+	}
+
+	return mtime;
+}
+
+static char *get_keyid(Header h)
+{
+	errmsg_t rpmerr;
+	regmatch_t keyid_match[1];
+	char *str, *sid = NULL;
+
+	str = headerFormat(h, "%|SIGGPG?{%{SIGGPG:pgpsig}}:{%{SIGPGP:pgpsig}}|", &rpmerr);
+
+	if (str == NULL || !rpm_indexes.keyid_regex_ok ||
+	    regexec(&rpm_indexes.keyid_regex, str, 1, keyid_match, 0) != 0) {
+		dD("Failed to extract the Key ID value: regex=\"%s\", string=\"%s\"",
+		   keyid_regex_string, str);
+	} else if (keyid_match[0].rm_so >= 0 && keyid_match[0].rm_eo >= 0) {
+		size_t keyid_start = keyid_match[0].rm_so + strlen("Key ID ");
+
+		sid = strndup(str + keyid_start, keyid_match[0].rm_eo - keyid_start);
+	}
+
+	free(str);
+	return sid != NULL ? sid : strdup("0");
+}
+
+static bool pkg_from_header(Header h, struct rpm_index_pkg *pkg)
+{
+	errmsg_t rpmerr;
+	const char *epoch;
+
+	pkg->name = headerFormat(h, "%{NAME}", &rpmerr);
+	if (pkg->name == NULL)
+		return false;
+
+	pkg->arch = headerFormat(h, "%{ARCH}", &rpmerr);
+	pkg->epoch = headerFormat(h, "%{EPOCH}", &rpmerr);
+	pkg->release = headerFormat(h, "%{RELEASE}", &rpmerr);
+	pkg->version = headerFormat(h, "%{VERSION}", &rpmerr);
+
+	epoch = oscap_streq(pkg->epoch, "(none)") ? "0" : pkg->epoch;
+	pkg->evr = oscap_sprintf("%s:%s-%s", epoch, pkg->version, pkg->release);
+	pkg->extended_name = oscap_sprintf("%s-%s:%s-%s.%s", pkg->name, epoch,
+					   pkg->version, pkg->release, pkg->arch);
+	pkg->signature_keyid = get_keyid(h);
+
+	return true;
+}
+
+static void pkg_free(struct rpm_index_pkg *pkg)
+{
+	free(pkg->name);
+	free(pkg->arch);
+	free(pkg->epoch);
+	free(pkg->release);
+	free(pkg->version);
+	free(pkg->evr);
+	free(pkg->signature_keyid);
+	free(pkg->extended_name);
+}
+
+static int pkg_namecmp(const void *a, const void *b)
+{
+	const struct rpm_index_pkg *pa = a, *pb = b;
+	int r = strcmp(pa->name, pb->name);
+
+	if (r == 0)
+		r = pa->instance < pb->instance ? -1 : pa->instance > pb->instance;
+
+	return r;
+}
+
+static int pkg_instancecmp(const void *a, const void *b)
+{
+	unsigned int ia = (*(struct rpm_index_pkg * const *)a)->instance;
+	unsigned int ib = (*(struct rpm_index_pkg * const *)b)->instance;
+
+	return ia < ib ? -1 : ia > ib;
+}
+
+static int file_pathcmp(const void *a, const void *b)
+{
+	const struct rpm_index_file *fa = a, *fb = b;
+	int r = strcmp(fa->path, fb->path);
+
+	if (r == 0)
+		r = fa->pkg < fb->pkg ? -1 : fa->pkg > fb->pkg;
+
+	return r;
+}
+
+static struct rpm_index *rpm_index_build(struct rpm_probe_global *rpm, unsigned long long mtime, bool shared)
+{
+	struct rpm_index *idx;
+	rpmdbMatchIterator match;
+	Header pkgh;
+	size_t size = RPM_INDEX_INITIAL_COUNT;
+
+	if (rpm_lock(rpm) != 0)
+		return NULL;
+
+	idx = calloc(1, sizeof(struct rpm_index));
+	pthread_mutex_init(&idx->lock, NULL);
+	idx->refs = 1;
+	idx->shared = shared;
+	idx->mtime = mtime;
+	idx->pkgs = malloc(size * sizeof(struct rpm_index_pkg));
+
+	/* An empty or missing database gives an empty index */
+	match = rpmtsInitIterator(rpm->rpmts, RPMDBI_PACKAGES, NULL, 0);
+
+	while (match != NULL && (pkgh = rpmdbNextIterator(match)) != NULL) {
+		if (idx->count == size) {
+			size *= 2;
+			idx->pkgs = realloc(idx->pkgs, size * sizeof(struct rpm_index_pkg));
+		}
+		if (pkg_from_header(pkgh, &idx->pkgs[idx->count])) {
+			idx->pkgs[idx->count].instance = rpmdbGetIteratorOffset(match);
+			++idx->count;
+		}
+	}
+
+	if (match != NULL)
+		rpmdbFreeIterator(match);
+
+	rpm_unlock(rpm);
+
+	qsort(idx->pkgs, idx->count, sizeof(struct rpm_index_pkg), pkg_namecmp);
+	dD("Package index: %zu packages.", idx->count);
+
+	return idx;
+}
+
+static void rpm_index_free(struct rpm_index *idx)
+{
+	for (size_t i = 0; i < idx->count; ++i)
+		pkg_free(&idx->pkgs[i]);
+	for (size_t i = 0; i < idx->file_count; ++i)
+		free(idx->files[i].path);
+
+	free(idx->pkgs);
+	free(idx->files);
+	pthread_mutex_destroy(&idx->lock);
+	free(idx);
+}
+
+/*
+ * Build the index of the package files, all headers have to be read
+ * again, so it's done only if some object needs it.
+ */
+static void rpm_index_load_files(struct rpm_probe_global *rpm, struct rpm_index *idx)
+{
+	struct rpm_index_pkg **by_instance, **found, key, *kptr = &key;
+	rpmTag tag[2] = { RPMTAG_BASENAMES, RPMTAG_DIRNAMES };
+	rpmdbMatchIterator match;
+	Header pkgh;
+	rpmfi fi;
+	size_t size = RPM_INDEX_INITIAL_COUNT * 16;
+
+	pthread_mutex_lock(&idx->lock);
+	if (idx->files != NULL) {
+		pthread_mutex_unlock(&idx->lock);
+		return;
+	}
+
+	by_instance = malloc((idx->count + 1) * sizeof(struct rpm_index_pkg *));
+	for (size_t i = 0; i < idx->count; ++i)
+		by_instance[i] = &idx->pkgs[i];
+	qsort(by_instance, idx->count, sizeof(struct rpm_index_pkg *), pkg_instancecmp);
+
+	idx->files = malloc(size * sizeof(struct rpm_index_file));
+
+	if (rpm_lock(rpm) == 0) {
+		match = rpmtsInitIterator(rpm->rpmts, RPMDBI_PACKAGES, NULL, 0);
+
+		while (match != NULL && (pkgh = rpmdbNextIterator(match)) != NULL) {
+			key.instance = rpmdbGetIteratorOffset(match);
+			found = bsearch(&kptr, by_instance, idx->count, sizeof(struct rpm_index_pkg *), pkg_instancecmp);
+			/* The package was installed after the index was built */
+			if (found == NULL)
+				continue;
+
+			for (int i = 0; i < 2; ++i) {
+				fi = rpmfiNew(rpm->rpmts, pkgh, tag[i], 1);
+
+				while (rpmfiNext(fi) != -1) {
+					if (idx->file_count == size) {
+						size *= 2;
+						idx->files = realloc(idx->files, size * sizeof(struct rpm_index_file));
+					}
+					idx->files[idx->file_count].path = strdup(rpmfiFN(fi));
+					idx->files[idx->file_count].pkg = *found;
+					++idx->file_count;
+				}
+
+				rpmfiFree(fi);
+			}
+		}
+
+		if (match != NULL)
+			rpmdbFreeIterator(match);
+
+		rpm_unlock(rpm);
+	}
+
+	qsort(idx->files, idx->file_count, sizeof(struct rpm_index_file), file_pathcmp);
+	dD("Package index: %zu files.", idx->file_count);
+
+	free(by_instance);
+	pthread_mutex_unlock(&idx->lock);
+}
+
+struct rpm_index *rpm_index_get(struct rpm_probe_global *rpm)
+{
+	struct rpm_index *idx, *old = NULL;
+	unsigned long long mtime;
+
+	pthread_once(&rpm_indexes.once, rpm_index_init);
+
+	if (!rpm_indexes.enabled)
+		return rpm_index_build(rpm, 0, false);
+
+	/* Concurrent callers wait for the index built by the first one */
+	pthread_mutex_lock(&rpm_indexes.lock);
+
+	if (rpm_indexes.dbpath == NULL && rpm_lock(rpm) == 0) {
+		rpm_indexes.dbpath = rpm_db_path(rpm);
+		rpm_unlock(rpm);
+	}
+
+	mtime = rpm_indexes.dbpath != NULL ? rpm_db_mtime(rpm_indexes.dbpath) : 0;
+
+	if (rpm_indexes.idx != NULL && rpm_indexes.idx->mtime != mtime) {
+		dD("The rpm database was modified, rebuilding the package index.");
+		old = rpm_indexes.idx;
+		rpm_indexes.idx = NULL;
+		if (--old->refs > 0)
+			old = NULL;
+	}
+
+	if (rpm_indexes.idx == NULL)
+		rpm_indexes.idx = rpm_index_build(rpm, mtime, true);
+	idx = rpm_indexes.idx;
+	if (idx != NULL)
+		++idx->refs;
+
+	pthread_mutex_unlock(&rpm_indexes.lock);
+
+	if (old != NULL)
+		rpm_index_free(old);
+
+	return idx;
+}
+
+void rpm_index_put(struct rpm_index *idx)
+{
+	bool destroy;
+
+	if (idx == NULL)
+		return;
+
+	pthread_mutex_lock(&rpm_indexes.lock);
+	destroy = --idx->refs == 0;
+	pthread_mutex_unlock(&rpm_indexes.lock);
+
+	if (destroy)
+		rpm_index_free(idx);
+}
+
+size_t rpm_index_find_name(struct rpm_index *idx, const char *name, struct rpm_index_pkg **pkgs)
+{
+	size_t lo, hi, mid, end;
+
+	/* Lower bound of the name */
+	lo = 0;
+	hi = idx->count;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (strcmp(idx->pkgs[mid].name, name) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	end = lo;
+	while (end < idx->count && strcmp(idx->pkgs[end].name, name) == 0)
+		++end;
+
+	*pkgs = idx->pkgs + lo;
+	return end - lo;
+}
+
+/*
+ * Get the value of an entity which requires an equal value,
+ * returns NULL if the entity can match more values. An entity without
+ * a string value is treated as such, the caller then selects all packages
+ * and compares each of them with rpm_index_ent_cmp().
+ */
+static char *get_equal_value(SEXP_t *ent)
+{
+	SEXP_t *val;
+	char *str;
+
+	if (ent == NULL || probe_ent_attrexists(ent, "var_ref") ||
+	    probe_ent_getoperation(ent, OVAL_OPERATION_EQUALS) != OVAL_OPERATION_EQUALS)
+		return NULL;
+
+	val = probe_ent_getval(ent);
+	if (val == NULL)
+		return NULL;
+
+	str = SEXP_stringp(val) ? SEXP_string_cstr(val) : NULL;
+	SEXP_free(val);
+
+	return str;
+}
+
+size_t rpm_index_select(struct rpm_probe_global *rpm, struct rpm_index *idx, SEXP_t *name_ent, const char *filepath, struct rpm_index_pkg ***pkgs)
+{
+	struct rpm_index_pkg *found;
+	struct rpm_index_file key;
+	size_t count, lo, hi, mid;
+	char *name;
+
+	name = get_equal_value(name_ent);
+
+	/* A private index would be read for a single object, it's faster to check all packages */
+	if (filepath != NULL && idx->shared) {
+		rpm_index_load_files(rpm, idx);
+
+		/* Lower bound of the path */
+		key.path = (char *)filepath;
+		key.pkg = NULL;
+		lo = 0;
+		hi = idx->file_count;
+		while (lo < hi) {
+			mid = lo + (hi - lo) / 2;
+			if (file_pathcmp(&idx->files[mid], &key) < 0)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+
+		*pkgs = malloc(sizeof(struct rpm_index_pkg *));
+		for (count = 0; lo < idx->file_count && strcmp(idx->files[lo].path, filepath) == 0; ++lo) {
+			found = idx->files[lo].pkg;
+			if (name != NULL && strcmp(found->name, name) != 0)
+				continue;
+			/* The file may be listed more times */
+			if (count > 0 && (*pkgs)[count - 1] == found)
+				continue;
+			*pkgs = realloc(*pkgs, (count + 1) * sizeof(struct rpm_index_pkg *));
+			(*pkgs)[count++] = found;
+		}
+	} else if (name != NULL) {
+		count = rpm_index_find_name(idx, name, &found);
+		*pkgs = malloc((count + 1) * sizeof(struct rpm_index_pkg *));
+		for (size_t i = 0; i < count; ++i)
+			(*pkgs)[i] = &found[i];
+	} else {
+		*pkgs = malloc((idx->count + 1) * sizeof(struct rpm_index_pkg *));
+		for (count = 0; count < idx->count; ++count)
+			(*pkgs)[count] = &idx->pkgs[count];
+	}
+
+	free(name);
+	return count;
+}
+
+bool rpm_index_ent_cmp(SEXP_t *ent, const char *value)
+{
+	SEXP_t *val;
+	bool match;
+
+	if (ent == NULL)
+		return true;
+
+	val = probe_entval_from_cstr(probe_ent_getdatatype(ent), value, strlen(value));
+	if (val == NULL) {
+		/* The value can't be compared, don't report the package */
+		dW("Unable to convert '%s' to the datatype of the entity", value);
+		return false;
+	}
+
+	match = probe_entobj_cmp(ent, val) == OVAL_RESULT_TRUE;
+	SEXP_free(val);
+
+	return match;
+}
+
+rpmdbMatchIterator rpm_index_pkg_iterator(struct rpm_probe_global *rpm, const struct rpm_index_pkg *pkg)
+{
+	return rpmtsInitIterator(rpm->rpmts, RPMDBI_PACKAGES, &pkg->instance, sizeof(pkg->instance));
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2015 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef RPM_INDEX_H
+#define RPM_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <sexp.h>
+
+#include "rpm-helper.h"
+
+/*
+ * Index of the installed packages
+ *
+ * The rpm probes look up the packages in an index built from the rpm
+ * database when the first object is evaluated instead of walking the
+ * database for every object. The lookups don't call librpm, so they
+ * don't need the rpm mutex; it's still needed to read the headers of
+ * the found packages (e.g. to verify their files). The index is rebuilt
+ * when the modification time of the database changes. Setting
+ * OSCAP_PROBE_RPM_INDEX=0 makes every object read the database on its own.
+ */
+#define RPM_INDEX_ENV "OSCAP_PROBE_RPM_INDEX"
+
+struct rpm_index_pkg {
+	char *name;
+	char *epoch;            /* "(none)" if the package has no epoch */
+	char *version;
+	char *release;
+	char *arch;
+	char *evr;              /* epoch:version-release, the epoch defaults to 0 */
+	char *signature_keyid;  /* "0" if unknown */
+	char *extended_name;    /* name-epoch:version-release.arch */
+	unsigned int instance;  /* header instance in the database */
+};
+
+struct rpm_index_file {
+	char *path;
+	struct rpm_index_pkg *pkg;
+};
+
+struct rpm_index {
+	pthread_mutex_t lock;
+	unsigned refs;
+	bool shared;                   /* false if the index is private to one object */
+	unsigned long long mtime;      /* modification time of the database in ns */
+	struct rpm_index_pkg *pkgs;    /* sorted by name */
+	size_t count;
+	struct rpm_index_file *files;  /* sorted by path, built on demand */
+	size_t file_count;
+};
+
+/**
+ * Get the index of the packages, build it if there's none or if the
+ * database was modified since it was built.
+ * @param rpm the rpm transaction set of the probe and its mutex, the mutex
+ *        must not be held by the caller
+ * @return referenced index or NULL if the database can't be read
+ */
+struct rpm_index *rpm_index_get(struct rpm_probe_global *rpm);
+
+/**
+ * Release an index obtained by rpm_index_get().
+ */
+void rpm_index_put(struct rpm_index *idx);
+
+/**
+ * Find packages by their name.
+ * @param pkgs the first matching package is stored here, the matching
+ *        packages follow it in the index
+ * @return number of the matching packages
+ */
+size_t rpm_index_find_name(struct rpm_index *idx, const char *name, struct rpm_index_pkg **pkgs);
+
+/**
+ * Get the packages which can match the name entity of an object and own
+ * the file. The lookup uses the indexes if the name entity requires
+ * an equal value or if the path is given, the entities still have to be
+ * compared by the caller.
+ * @param name_ent the name entity or NULL
+ * @param filepath path of a file the packages have to own or NULL
+ * @param pkgs the packages are stored here, the array has to be freed
+ *        by the caller
+ * @return number of the packages
+ */
+size_t rpm_index_select(struct rpm_probe_global *rpm, struct rpm_index *idx, SEXP_t *name_ent, const char *filepath, struct rpm_index_pkg ***pkgs);
+
+/**
+ * Compare a field of a package with an object entity.
+ * A value which can't be converted to the datatype of the entity
+ * doesn't match.
+ * @return true if the entity is NULL or matches the value
+ */
+bool rpm_index_ent_cmp(SEXP_t *ent, const char *value);
+
+/**
+ * Start an iteration over the header of an indexed package. Has to be
+ * called with the rpm mutex held.
+ * @return iterator returning the header or NULL
+ */
+rpmdbMatchIterator rpm_index_pkg_iterator(struct rpm_probe_global *rpm, const struct rpm_index_pkg *pkg);
+
+#endif
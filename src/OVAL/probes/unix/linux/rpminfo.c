@@ -51,16 +51,18 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
 #include <string.h>
 #include <errno.h>
 #include <assert.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
-#include <regex.h>
 
 /* RPM headers */
 #include "rpm-helper.h"
+#include "rpm-index.h"
 
 /* SEAP */
 #include <seap.h>
@@ -78,189 +80,11 @@ struct rpminfo_req {
         oval_operation_t op;
 };
 
-struct rpminfo_rep {
-        char *name;
-        char *arch;
-        char *epoch;
-        char *release;
-        char *version;
-        char *evr;
-        char *signature_keyid;
-	char extended_name[1024];
-};
-
 #define RPMINFO_LOCK	RPM_MUTEX_LOCK(&g_rpm.mutex)
 
 #define RPMINFO_UNLOCK	RPM_MUTEX_UNLOCK(&g_rpm.mutex)
 
 static struct rpm_probe_global g_rpm;
-static const char g_keyid_regex_string[] = "Key ID [a-fA-F0-9]{16}";
-static regex_t g_keyid_regex;
-
-static void __rpminfo_rep_free (struct rpminfo_rep *ptr)
-{
-        free (ptr->name);
-        free (ptr->arch);
-        free (ptr->epoch);
-        free (ptr->release);
-        free (ptr->version);
-        free (ptr->evr);
-        free (ptr->signature_keyid);
-}
-
-static void pkgh2rep (Header h, struct rpminfo_rep *r)
-{
-        errmsg_t rpmerr;
-        char *str, *sid;
-	char *epoch_override = NULL;
-        size_t len;
-	regmatch_t keyid_match[1];
-
-        assume_d (h != NULL, /* void */);
-        assume_d (r != NULL, /* void */);
-
-        r->name = headerFormat (h, "%{NAME}", &rpmerr);
-        r->arch = headerFormat (h, "%{ARCH}", &rpmerr);
-        r->epoch = headerFormat (h, "%{EPOCH}", &rpmerr);
-        r->release = headerFormat (h, "%{RELEASE}", &rpmerr);
-        r->version = headerFormat (h, "%{VERSION}", &rpmerr);
-	epoch_override = oscap_streq(r->epoch, "(none)") ? "0" : r->epoch;
-	snprintf(r->extended_name, 1024, "%s-%s:%s-%s.%s", r->name, epoch_override, r->version, r->release, r->arch);
-
-	len = (strlen(epoch_override) +
-               strlen (r->release) +
-               strlen (r->version) + 2);
-
-        str = malloc (sizeof (char) * (len + 1));
-        snprintf (str, len + 1, "%s:%s-%s",
-		epoch_override,
-                  r->version,
-                  r->release);
-
-        r->evr = str;
-
-        str = headerFormat (h, "%|SIGGPG?{%{SIGGPG:pgpsig}}:{%{SIGPGP:pgpsig}}|", &rpmerr);
-
-	if (regexec(&g_keyid_regex, str, 1, keyid_match, 0) != 0) {
-		sid = NULL;
-		dD("Failed to extract the Key ID value: regex=\"%s\", string=\"%s\"",
-		   g_keyid_regex_string, str);
-	} else {
-		size_t keyid_start, keyid_length;
-
-		if (keyid_match[0].rm_so < 0 || keyid_match[0].rm_eo < 0)
-			sid = NULL;
-		else {
-			keyid_start = keyid_match[0].rm_so + strlen("Key ID ");
-			keyid_length = keyid_match[0].rm_eo - keyid_start;
-			sid = str + keyid_start;
-			sid[keyid_length] = '\0';
-		}
-	}
-
-        r->signature_keyid = strdup(sid != NULL ? sid : "0");
-        free (str);
-}
-
-/*
- * req - Structure containing the name of the package.
- * rep - Pointer to rpminfo_rep structure pointer. An
- *       array of rpminfo_rep structures will be allocated
- *       here.
- *
- * The return value on error is -1. Otherwise the number of
- * rpminfo_rep structures allocated in *rep is returned.
- */
-static int get_rpminfo (struct rpminfo_req *req, struct rpminfo_rep **rep)
-{
-	rpmdbMatchIterator match;
-	Header pkgh;
-	int ret = 0, i;
-
-        RPMINFO_LOCK;
-
-        ret = -1;
-
-        switch (req->op) {
-        case OVAL_OPERATION_EQUALS:
-                match = rpmtsInitIterator (g_rpm.rpmts, RPMTAG_NAME, (const void *)req->name, 0);
-
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                ret = rpmdbGetIteratorCount (match);
-
-                break;
-	case OVAL_OPERATION_NOT_EQUAL:
-                match = rpmtsInitIterator (g_rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                if (rpmdbSetIteratorRE (match, RPMTAG_NAME, RPMMIRE_GLOB, "*") != 0)
-                {
-                        ret = -1;
-                        goto ret;
-                }
-
-                break;
-        case OVAL_OPERATION_PATTERN_MATCH:
-                match = rpmtsInitIterator (g_rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
-
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                if (rpmdbSetIteratorRE (match, RPMTAG_NAME, RPMMIRE_REGEX,
-                                        (const char *)req->name) != 0)
-                {
-                        ret = -1;
-                        goto ret;
-                }
-
-                break;
-        default:
-                /* not supported */
-                ret = -1;
-                goto ret;
-        }
-
-        if (ret != -1) {
-                /*
-                 * We can allocate all memory needed now because we know the number
-                 * of results.
-                 */
-                (*rep) = realloc (*rep, sizeof (struct rpminfo_rep) * ret);
-
-                for (i = 0; i < ret; ++i) {
-                        pkgh = rpmdbNextIterator (match);
-
-                        if (pkgh != NULL)
-                                pkgh2rep (pkgh, (*rep) + i);
-                        else {
-                                /* XXX: emit warning */
-                                break;
-                        }
-                }
-        } else {
-                ret = 0;
-
-                while ((pkgh = rpmdbNextIterator (match)) != NULL) {
-                        (*rep) = realloc (*rep, sizeof (struct rpminfo_rep) * ++ret);
-                        assume_r (*rep != NULL, -1);
-                        pkgh2rep (pkgh, (*rep) + (ret - 1));
-                }
-        }
-
-	match = rpmdbFreeIterator (match);
-ret:
-        RPMINFO_UNLOCK;
-        return (ret);
-}
 
 void probe_preload ()
 {
@@ -277,11 +101,6 @@ void *probe_init (void)
 #ifdef RPM46_FOUND
 	rpmlogSetCallback(rpmErrorCb, NULL);
 #endif
-	if (regcomp(&g_keyid_regex, g_keyid_regex_string, REG_EXTENDED) != 0) {
-		dE("regcomp(%s) failed.");
-		return NULL;
-	}
-
 	if (rpmReadConfigFiles ((const char *)NULL, (const char *)NULL) != 0) {
 		dI("rpmReadConfigFiles failed: %u, %s.", errno, strerror (errno));
 		g_rpm.rpmts = NULL;
@@ -316,8 +135,6 @@ void probe_fini (void *ptr)
 	if (r == NULL)
 		return;
 
-	regfree(&g_keyid_regex);
-
 	if (r->rpmts == NULL)
 		return;
 
@@ -327,136 +144,107 @@ void probe_fini (void *ptr)
         return;
 }
 
-static int collect_rpm_files(SEXP_t *item, const struct rpminfo_rep *rep) {
+static void collect_header_files(SEXP_t *item, Header pkgh)
+{
 	SEXP_t *value;
-	rpmdbMatchIterator ts;
-	Header pkgh;
 	rpmfi fi;
 	rpmTag tag[2] = { RPMTAG_BASENAMES, RPMTAG_DIRNAMES };
-	int i, ret = 0;
-
-	ts = rpmtsInitIterator(g_rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
-	if (ts == NULL) {
-		return -1;
-	}
-
-	if (rpmdbSetIteratorRE(ts, RPMTAG_NAME, RPMMIRE_STRCMP, rep->name) != 0) {
-		ret = -1;
-		goto cleanup;
-	}
-	if (rpmdbSetIteratorRE(ts, RPMTAG_EPOCH, RPMMIRE_STRCMP, rep->epoch) != 0) {
-		ret = -1;
-		goto cleanup;
-	}
-	if (rpmdbSetIteratorRE(ts, RPMTAG_VERSION, RPMMIRE_STRCMP, rep->version) != 0) {
-		ret = -1;
-		goto cleanup;
-	}
-	if (rpmdbSetIteratorRE(ts, RPMTAG_RELEASE, RPMMIRE_STRCMP, rep->release) != 0) {
-		ret = -1;
-		goto cleanup;
-	}
-	if (rpmdbSetIteratorRE(ts, RPMTAG_ARCH, RPMMIRE_STRCMP, rep->arch) != 0) {
-		ret = -1;
-		goto cleanup;
-	}
-
-	while ((pkgh = rpmdbNextIterator(ts)) != NULL) {
-		/*
-		 * Inspect package files & directories
-		 */
-		for (i = 0; i < 2; ++i) {
-			fi = rpmfiNew(g_rpm.rpmts, pkgh, tag[i], 1);
-
-			while (rpmfiNext(fi) != -1) {
-				const char *filepath;
-				filepath = rpmfiFN(fi);
-				value = probe_entval_from_cstr(
-						OVAL_DATATYPE_STRING,
-						filepath,
-						strlen(filepath)
-						);
-				if (value != NULL) {
-					probe_item_ent_add(item, "filepath", NULL, value);
-					SEXP_free(value);
-				}
+	int i;
+
+	/*
+	 * Inspect package files & directories
+	 */
+	for (i = 0; i < 2; ++i) {
+		fi = rpmfiNew(g_rpm.rpmts, pkgh, tag[i], 1);
+
+		while (rpmfiNext(fi) != -1) {
+			const char *filepath;
+			filepath = rpmfiFN(fi);
+			value = probe_entval_from_cstr(
+					OVAL_DATATYPE_STRING,
+					filepath,
+					strlen(filepath)
+					);
+			if (value != NULL) {
+				probe_item_ent_add(item, "filepath", NULL, value);
+				SEXP_free(value);
 			}
-			rpmfiFree(fi);
 		}
-
+		rpmfiFree(fi);
 	}
-cleanup:
-	ts = rpmdbFreeIterator(ts);
-	return ret;
 }
 
-int probe_main (probe_ctx *ctx, void *arg)
+static int collect_rpm_files(SEXP_t *item, const struct rpm_index_pkg *pkg)
 {
-	SEXP_t *val, *item, *ent, *probe_in;
-	oval_schema_version_t over;
-	int rpmret, i;
+	rpmdbMatchIterator match;
+	Header pkgh;
 
-        struct rpminfo_req request_st;
-        struct rpminfo_rep *reply_st;
+	RPMINFO_LOCK;
 
-	// arg is NULL if regex compilation failed
-	if (arg == NULL) {
-		return PROBE_EINIT;
+	match = rpm_index_pkg_iterator(&g_rpm, pkg);
+	if (match == NULL) {
+		RPMINFO_UNLOCK;
+		return -1;
 	}
 
-	// There was no rpm config files
-	if (g_rpm.rpmts == NULL) {
-		probe_cobj_set_flag(probe_ctx_getresult(ctx), SYSCHAR_FLAG_NOT_APPLICABLE);
-		return 0;
-	}
+	while ((pkgh = rpmdbNextIterator(match)) != NULL)
+		collect_header_files(item, pkgh);
 
-	probe_in = probe_ctx_getobject(ctx);
-	if (probe_in == NULL)
-		return PROBE_ENOOBJ;
+	rpmdbFreeIterator(match);
 
-	over = probe_obj_get_platform_schema_version(probe_in);
+	RPMINFO_UNLOCK;
+	return 0;
+}
 
-        ent = probe_obj_getent (probe_in, "name", 1);
+/*
+ * Parse the name entity of the object. The entity is returned
+ * in *ent and has to be freed by the caller.
+ */
+static int rpminfo_parse_object(SEXP_t *probe_in, SEXP_t **ent, struct rpminfo_req *req)
+{
+	SEXP_t *val;
+
+        *ent = probe_obj_getent (probe_in, "name", 1);
 
-        if (ent == NULL) {
+        if (*ent == NULL) {
                 return (PROBE_ENOENT);
         }
 
-        val = probe_ent_getval (ent);
+        val = probe_ent_getval (*ent);
 
         if (val == NULL) {
                 dI("%s: no value", "name");
-                SEXP_free (ent);
+                SEXP_free (*ent);
                 return (PROBE_ENOVAL);
         }
 
-        request_st.name = SEXP_string_cstr (val);
+        req->name = SEXP_string_cstr (val);
         SEXP_free (val);
 
-        val = probe_ent_getattrval (ent, "operation");
+        val = probe_ent_getattrval (*ent, "operation");
 
         if (val == NULL) {
-                request_st.op = OVAL_OPERATION_EQUALS;
+                req->op = OVAL_OPERATION_EQUALS;
         } else {
-                request_st.op = (oval_operation_t) SEXP_number_geti_32 (val);
+                req->op = (oval_operation_t) SEXP_number_geti_32 (val);
 
-                switch (request_st.op) {
+                switch (req->op) {
                 case OVAL_OPERATION_EQUALS:
 		case OVAL_OPERATION_NOT_EQUAL:
                 case OVAL_OPERATION_PATTERN_MATCH:
                         break;
                 default:
                         SEXP_free (val);
-                        SEXP_free (ent);
-                        free (request_st.name);
+                        SEXP_free (*ent);
+                        free (req->name);
                         return (PROBE_EOPNOTSUPP);
                 }
 
                 SEXP_free (val);
         }
 
-        if (request_st.name == NULL) {
-		SEXP_free (ent);
+        if (req->name == NULL) {
+		SEXP_free (*ent);
                 switch (errno) {
                 case EINVAL:
                         dI("%s: invalid value type", "name");
@@ -471,93 +259,143 @@ int probe_main (probe_ctx *ctx, void *arg)
                 }
         }
 
-        reply_st  = NULL;
-
-        /* get info from RPM db */
-        switch (rpmret = get_rpminfo (&request_st, &reply_st)) {
-        case 0: /* Not found */
-                dI("Package \"%s\" not found.", request_st.name);
-                break;
-        case -1: /* Error */
-                dI("get_rpminfo failed");
-
-                item = probe_item_create(OVAL_LINUX_RPM_INFO, NULL,
-                                         "name", OVAL_DATATYPE_STRING, request_st.name,
-                                         NULL);
-
-                probe_item_setstatus (item, SYSCHAR_STATUS_ERROR);
-                probe_item_collect(ctx, item);
-                break;
-        default: /* Ok */
-                _A(rpmret   >= 0);
-                _A(reply_st != NULL);
-                {
-                        SEXP_t *name;
-
-                        for (i = 0; i < rpmret; ++i) {
-				name = SEXP_string_newf("%s", reply_st[i].name);
-
-				if (probe_entobj_cmp(ent, name) != OVAL_RESULT_TRUE) {
-					SEXP_free(name);
-					continue;
-				}
-
-                                item = probe_item_create(OVAL_LINUX_RPM_INFO, NULL,
-                                                         "name",    OVAL_DATATYPE_SEXP, name,
-                                                         "arch",    OVAL_DATATYPE_STRING, reply_st[i].arch,
-                                                         "epoch",   OVAL_DATATYPE_STRING, reply_st[i].epoch,
-                                                         "release", OVAL_DATATYPE_STRING, reply_st[i].release,
-                                                         "version", OVAL_DATATYPE_STRING, reply_st[i].version,
-                                                         "evr",     OVAL_DATATYPE_EVR_STRING, reply_st[i].evr,
-                                                         "signature_keyid", OVAL_DATATYPE_STRING, reply_st[i].signature_keyid,
-                                                         NULL);
-
-				/* OVAL 5.10 added extended_name and filepaths behavior */
-				if (oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.10)) >= 0) {
-					SEXP_t *value, *bh_value;
-					value = probe_entval_from_cstr(
-							OVAL_DATATYPE_STRING,
-							reply_st[i].extended_name,
-							strlen(reply_st[i].extended_name)
-					);
-					probe_item_ent_add(item, "extended_name", NULL, value);
-					SEXP_free(value);
-
-					/*
-					 * Parse behaviors
-					 */
-					value = probe_obj_getent(probe_in, "behaviors", 1);
-					if (value != NULL) {
-						bh_value = probe_ent_getattrval(value, "filepaths");
-						if (bh_value != NULL) {
-							if (SEXP_strcmp(bh_value, "true") == 0) {
-								/* collect package files */
-								collect_rpm_files(item, &reply_st[i]);
-
-							}
-							SEXP_free(bh_value);
-						}
-						SEXP_free(value);
-					}
-
-				}
-
-
-				SEXP_free(name);
-                                __rpminfo_rep_free (&(reply_st[i]));
-
-				if (probe_item_collect(ctx, item) < 0) {
-					SEXP_vfree(ent, NULL);
-					return PROBE_EUNKNOWN;
-				}
-                        }
-
-                        free (reply_st);
-                }
-        }
+	return (0);
+}
+
+/*
+ * Returns true if the files of the package have to be collected,
+ * OVAL 5.10 added the filepaths behavior.
+ */
+static bool rpminfo_filepaths_behavior(SEXP_t *probe_in, oval_schema_version_t over)
+{
+	SEXP_t *value, *bh_value;
+	bool filepaths = false;
+
+	if (oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.10)) < 0)
+		return (false);
+
+	value = probe_obj_getent(probe_in, "behaviors", 1);
+	if (value != NULL) {
+		bh_value = probe_ent_getattrval(value, "filepaths");
+		if (bh_value != NULL) {
+			filepaths = SEXP_strcmp(bh_value, "true") == 0;
+			SEXP_free(bh_value);
+		}
+		SEXP_free(value);
+	}
+
+	return (filepaths);
+}
+
+static SEXP_t *rpminfo_item_new(SEXP_t *name, const struct rpm_index_pkg *pkg, oval_schema_version_t over)
+{
+	SEXP_t *item;
+
+	item = probe_item_create(OVAL_LINUX_RPM_INFO, NULL,
+				 "name",    OVAL_DATATYPE_SEXP, name,
+				 "arch",    OVAL_DATATYPE_STRING, pkg->arch,
+				 "epoch",   OVAL_DATATYPE_STRING, pkg->epoch,
+				 "release", OVAL_DATATYPE_STRING, pkg->release,
+				 "version", OVAL_DATATYPE_STRING, pkg->version,
+				 "evr",     OVAL_DATATYPE_EVR_STRING, pkg->evr,
+				 "signature_keyid", OVAL_DATATYPE_STRING, pkg->signature_keyid,
+				 NULL);
+
+	/* OVAL 5.10 added extended_name */
+	if (oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.10)) >= 0) {
+		SEXP_t *value;
+		value = probe_entval_from_cstr(
+				OVAL_DATATYPE_STRING,
+				pkg->extended_name,
+				strlen(pkg->extended_name)
+		);
+		probe_item_ent_add(item, "extended_name", NULL, value);
+		SEXP_free(value);
+	}
+
+	return (item);
+}
+
+int probe_main (probe_ctx *ctx, void *arg)
+{
+	SEXP_t *item, *ent, *probe_in, *name;
+	oval_schema_version_t over;
+	struct rpminfo_req request_st;
+	struct rpm_index *idx;
+	struct rpm_index_pkg **pkgs;
+	size_t count, found, i;
+	int ret;
+	bool filepaths;
 
+	// There was no rpm config files
+	if (g_rpm.rpmts == NULL) {
+		probe_cobj_set_flag(probe_ctx_getresult(ctx), SYSCHAR_FLAG_NOT_APPLICABLE);
+		return 0;
+	}
+
+	probe_in = probe_ctx_getobject(ctx);
+	if (probe_in == NULL)
+		return PROBE_ENOOBJ;
+
+	over = probe_obj_get_platform_schema_version(probe_in);
+
+	if ((ret = rpminfo_parse_object(probe_in, &ent, &request_st)) != 0)
+		return (ret);
+
+	filepaths = rpminfo_filepaths_behavior(probe_in, over);
+
+	/* get info from the package index */
+	idx = rpm_index_get(&g_rpm);
+
+	if (idx == NULL) {
+		dI("Can't get the package index");
+
+		item = probe_item_create(OVAL_LINUX_RPM_INFO, NULL,
+					 "name", OVAL_DATATYPE_STRING, request_st.name,
+					 NULL);
+
+		probe_item_setstatus (item, SYSCHAR_STATUS_ERROR);
+		probe_item_collect(ctx, item);
+
+		SEXP_vfree(ent, NULL);
+		free(request_st.name);
+		return 0;
+	}
+
+	count = rpm_index_select(&g_rpm, idx, ent, NULL, &pkgs);
+	ret = 0;
+
+	for (i = found = 0; i < count; ++i) {
+		name = SEXP_string_newf("%s", pkgs[i]->name);
+
+		if (probe_entobj_cmp(ent, name) != OVAL_RESULT_TRUE) {
+			SEXP_free(name);
+			continue;
+		}
+
+		item = rpminfo_item_new(name, pkgs[i], over);
+		++found;
+
+		if (filepaths) {
+			/* collect package files */
+			collect_rpm_files(item, pkgs[i]);
+		}
+
+		SEXP_free(name);
+
+		if (probe_item_collect(ctx, item) < 0) {
+			ret = PROBE_EUNKNOWN;
+			break;
+		}
+	}
+
+	if (found == 0)
+		dI("Package \"%s\" not found.", request_st.name);
+
+	free(pkgs);
+	rpm_index_put(idx);
 	SEXP_vfree(ent, NULL);
-        free(request_st.name);
+	free(request_st.name);
 
-        return 0;
+	return ret;
 }
@@ -42,6 +42,7 @@
 #include <pcre.h>
 
 #include "rpm-helper.h"
+#include "rpm-index.h"
 
 /* Individual RPM headers */
 #include <rpm/rpmfi.h>
@@ -74,18 +75,91 @@ static struct rpm_probe_global g_rpm;
 #define RPMVERIFY_LOCK   RPM_MUTEX_LOCK(&g_rpm.mutex)
 #define RPMVERIFY_UNLOCK RPM_MUTEX_UNLOCK(&g_rpm.mutex)
 
+/*
+ * Locks the rpm mutex, returns -1 instead of returning from the caller
+ * so that the caller can release what it holds, see RPM_MUTEX_LOCK.
+ */
+static int rpmverify_lock(void)
+{
+	RPMVERIFY_LOCK;
+	return 0;
+}
+
+/*
+ * Verify the files of a package which match the filepath entity
+ */
+static void rpmverify_collect_header(probe_ctx *ctx, char *name, Header pkgh,
+				     SEXP_t *filepath_ent, uint64_t flags,
+				     void (*callback)(probe_ctx *, struct rpmverify_res *))
+{
+	rpmVerifyAttrs omit = (rpmVerifyAttrs)(flags & RPMVERIFY_RPMATTRMASK);
+	rpmTag tag[2] = { RPMTAG_BASENAMES, RPMTAG_DIRNAMES };
+	struct rpmverify_res res;
+	SEXP_t *filepath_sexp;
+	rpmfi fi;
+	int i;
+
+	res.name = name;
+
+	/*
+	 * Inspect package files & directories
+	 */
+	for (i = 0; i < 2; ++i) {
+		fi = rpmfiNew(g_rpm.rpmts, pkgh, tag[i], 1);
+
+		while (rpmfiNext(fi) != -1) {
+			res.fflags = rpmfiFFlags(fi);
+			res.oflags = omit;
+
+			if (((res.fflags & RPMFILE_CONFIG) && (flags & RPMVERIFY_SKIP_CONFIG)) ||
+			    ((res.fflags & RPMFILE_GHOST)  && (flags & RPMVERIFY_SKIP_GHOST)))
+				continue;
+
+			res.file = strdup(rpmfiFN(fi));
+
+			filepath_sexp = SEXP_string_newf("%s", res.file);
+			if (probe_entobj_cmp(filepath_ent, filepath_sexp) != OVAL_RESULT_TRUE) {
+				SEXP_free(filepath_sexp);
+				free(res.file);
+				continue;
+			}
+			SEXP_free(filepath_sexp);
+
+			if (rpmVerifyFile(g_rpm.rpmts, fi, &res.vflags, omit) != 0)
+				res.vflags = RPMVERIFY_FAILURES;
+
+			callback(ctx, &res);
+			free(res.file);
+		}
+
+		rpmfiFree(fi);
+	}
+}
+
 static int rpmverify_collect(probe_ctx *ctx,
-                             const char *name, oval_operation_t name_op,
+                             oval_operation_t name_op,
                              const char *file, oval_operation_t file_op,
 			     SEXP_t *name_ent, SEXP_t *filepath_ent,
                              uint64_t flags,
                              void (*callback)(probe_ctx *, struct rpmverify_res *))
 {
 	rpmdbMatchIterator match;
-        rpmVerifyAttrs omit = (rpmVerifyAttrs)(flags & RPMVERIFY_RPMATTRMASK);
 	Header pkgh;
         pcre *re = NULL;
-	int  ret = -1;
+	struct rpm_index *idx;
+	struct rpm_index_pkg **pkgs;
+	size_t count, p;
+
+        switch (name_op) {
+        case OVAL_OPERATION_EQUALS:
+	case OVAL_OPERATION_NOT_EQUAL:
+        case OVAL_OPERATION_PATTERN_MATCH:
+                break;
+        default:
+                /* not supported */
+                dE("package name: operation not supported");
+                return (-1);
+        }
 
         /* pre-compile regex if needed */
         if (file_op == OVAL_OPERATION_PATTERN_MATCH) {
@@ -100,123 +174,52 @@ static int rpmverify_collect(probe_ctx *ctx,
                 }
         }
 
-        RPMVERIFY_LOCK;
-
-        switch (name_op) {
-        case OVAL_OPERATION_EQUALS:
-                match = rpmtsInitIterator (g_rpm.rpmts, RPMTAG_NAME, (const void *)name, 0);
-
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                ret = rpmdbGetIteratorCount (match);
-
-                break;
-	case OVAL_OPERATION_NOT_EQUAL:
-                match = rpmtsInitIterator (g_rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
+	idx = rpm_index_get(&g_rpm);
 
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                if (rpmdbSetIteratorRE (match, RPMTAG_NAME, RPMMIRE_GLOB, "*") != 0)
-                {
-                        ret = -1;
-                        goto ret;
-                }
-
-                break;
-        case OVAL_OPERATION_PATTERN_MATCH:
-                match = rpmtsInitIterator (g_rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
-
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                if (rpmdbSetIteratorRE (match, RPMTAG_NAME, RPMMIRE_REGEX,
-                                        (const char *)name) != 0)
-                {
-                        ret = -1;
-                        goto ret;
-                }
+	if (idx == NULL) {
+		if (re != NULL)
+			pcre_free(re);
+		return (-1);
+	}
 
-                break;
-        default:
-                /* not supported */
-                dE("package name: operation not supported");
-                ret = -1;
-                goto ret;
-        }
+	/* Only the owners of the file are checked if the object requires an equal path */
+	count = rpm_index_select(&g_rpm, idx, name_ent,
+				 file_op == OVAL_OPERATION_EQUALS && !probe_ent_attrexists(filepath_ent, "var_ref") ? file : NULL,
+				 &pkgs);
+
+	if (rpmverify_lock() != 0) {
+		if (re != NULL)
+			pcre_free(re);
+		free(pkgs);
+		rpm_index_put(idx);
+		return (-1);
+	}
 
 	assume_d(RPMTAG_BASENAMES != 0, -1);
 	assume_d(RPMTAG_DIRNAMES  != 0, -1);
 
-        while ((pkgh = rpmdbNextIterator (match)) != NULL) {
-                rpmfi  fi;
-		rpmTag tag[2] = { RPMTAG_BASENAMES, RPMTAG_DIRNAMES };
-                struct rpmverify_res res;
-                errmsg_t rpmerr;
-		int i;
-		SEXP_t *name_sexp;
-
-                res.name = headerFormat(pkgh, "%{NAME}", &rpmerr);
-
-		name_sexp = SEXP_string_newf("%s", res.name);
-		if (probe_entobj_cmp(name_ent, name_sexp) != OVAL_RESULT_TRUE) {
-			SEXP_free(name_sexp);
+	for (p = 0; p < count; ++p) {
+		if (!rpm_index_ent_cmp(name_ent, pkgs[p]->name))
 			continue;
-		}
-		SEXP_free(name_sexp);
-
-                /*
-                 * Inspect package files & directories
-                 */
-		for (i = 0; i < 2; ++i) {
-		  fi = rpmfiNew(g_rpm.rpmts, pkgh, tag[i], 1);
-
-		  while (rpmfiNext(fi) != -1) {
-		    SEXP_t *filepath_sexp;
-
-		    res.fflags = rpmfiFFlags(fi);
-		    res.oflags = omit;
-
-		    if (((res.fflags & RPMFILE_CONFIG) && (flags & RPMVERIFY_SKIP_CONFIG)) ||
-			((res.fflags & RPMFILE_GHOST)  && (flags & RPMVERIFY_SKIP_GHOST)))
-		      continue;
 
-		    res.file   = strdup(rpmfiFN(fi));
+		match = rpm_index_pkg_iterator(&g_rpm, pkgs[p]);
 
-		    filepath_sexp = SEXP_string_newf("%s", res.file);
-		    if (probe_entobj_cmp(filepath_ent, filepath_sexp) != OVAL_RESULT_TRUE) {
-		      SEXP_free(filepath_sexp);
-		      free(res.file);
-		      continue;
-		    }
-		    SEXP_free(filepath_sexp);
+		while (match != NULL && (pkgh = rpmdbNextIterator (match)) != NULL)
+			rpmverify_collect_header(ctx, pkgs[p]->name, pkgh, filepath_ent, flags, callback);
 
-		    if (rpmVerifyFile(g_rpm.rpmts, fi, &res.vflags, omit) != 0)
-		      res.vflags = RPMVERIFY_FAILURES;
-
-		    callback(ctx, &res);
-		    free(res.file);
-		  }
-
-		  rpmfiFree(fi);
-		}
+		if (match != NULL)
+			rpmdbFreeIterator(match);
 	}
 
-	match = rpmdbFreeIterator (match);
-        ret   = 0;
-ret:
+        RPMVERIFY_UNLOCK;
+
         if (re != NULL)
                 pcre_free(re);
 
-        RPMVERIFY_UNLOCK;
-        return (ret);
+	free(pkgs);
+	rpm_index_put(idx);
+
+        return (0);
 }
 
 void probe_preload ()
@@ -406,7 +409,7 @@ int probe_main (probe_ctx *ctx, void *arg)
            name, name_op, file, file_op);
 
         if (rpmverify_collect(ctx,
-                              name, name_op,
+                              name_op,
                               file, file_op,
 			      name_ent, file_ent,
                               collect_flags,
@@ -44,6 +44,7 @@
 #include <pcre.h>
 
 #include "rpm-helper.h"
+#include "rpm-index.h"
 
 /* Individual RPM headers */
 #include <rpm/rpmfi.h>
@@ -60,13 +61,13 @@
 #include <probe/option.h>
 
 struct rpmverify_res {
-	char *name;  /**< package name */
+	const char *name;  /**< package name */
 	const char *epoch;
 	const char *version;
 	const char *release;
 	const char *arch;
 	char *file;  /**< filepath */
-	char extended_name[1024];
+	const char *extended_name;
 	rpmVerifyAttrs vflags; /**< rpm verify flags */
 	rpmVerifyAttrs oflags; /**< rpm verify omit flags */
 	rpmfileAttrs   fflags; /**< rpm file flags */
@@ -97,46 +98,109 @@ static struct rpm_probe_global g_rpm;
 
 #define RPMVERIFY_UNLOCK RPM_MUTEX_UNLOCK(&g_rpm.mutex)
 
-/* modify passed-in iterator to test also given entity */
-static int adjust_filter(rpmdbMatchIterator iterator, SEXP_t *ent, rpmTag rpm_tag) {
-	oval_operation_t ent_op;
-	char ent_str[1024];
-	int ret = 0;
+/*
+ * Locks the rpm mutex, returns -1 instead of returning from the caller
+ * so that the caller can release what it holds, see RPM_MUTEX_LOCK.
+ */
+static int rpmverify_lock(void)
+{
+	RPMVERIFY_LOCK;
+	return 0;
+}
 
-	if (ent) {
-		ent_op = probe_ent_getoperation(ent, OVAL_OPERATION_EQUALS);
-		PROBE_ENT_STRVAL(ent, ent_str, sizeof ent_str, /* void */, strcpy(ent_str, ""););
+/*
+ * Verify the files of a package which match the filepath. Returns 1 if
+ * the collection has to be stopped, -1 on error.
+ */
+static int rpmverify_collect_header(probe_ctx *ctx, struct rpmverify_res *res, Header pkgh,
+				    const char *file, oval_operation_t file_op, pcre *re,
+				    uint64_t flags,
+				    int (*callback)(probe_ctx *, struct rpmverify_res *))
+{
+	rpmVerifyAttrs omit = (rpmVerifyAttrs)(flags & RPMVERIFY_RPMATTRMASK);
+	rpmTag tag[2] = { RPMTAG_BASENAMES, RPMTAG_DIRNAMES };
+	rpmfi fi;
+	int i, ret = 0;
 
-		switch (ent_op) {
-		case OVAL_OPERATION_EQUALS:
-			if (rpmdbSetIteratorRE (iterator, rpm_tag, RPMMIRE_STRCMP, ent_str) != 0)
-				ret = -1;
+	/*
+	 * Inspect package files & directories
+	 */
+	for (i = 0; i < 2 && ret == 0; ++i) {
+		fi = rpmfiNew(g_rpm.rpmts, pkgh, tag[i], 1);
+
+		while (ret == 0 && rpmfiNext(fi) != -1) {
+			res->fflags = rpmfiFFlags(fi);
+			res->oflags = omit;
+
+			if (((res->fflags & RPMFILE_CONFIG) && (flags & RPMVERIFY_SKIP_CONFIG)) ||
+			    ((res->fflags & RPMFILE_GHOST)  && (flags & RPMVERIFY_SKIP_GHOST)))
+				continue;
 
-			break;
-		case OVAL_OPERATION_PATTERN_MATCH:
-			if (rpmdbSetIteratorRE (iterator, rpm_tag, RPMMIRE_REGEX,
-						(const char *)ent_str) != 0)
+			res->file = oscap_strdup(rpmfiFN(fi));
+
+			switch(file_op) {
+			case OVAL_OPERATION_EQUALS:
+				if (strcmp(res->file, file) != 0) {
+					free(res->file);
+					continue;
+				}
+				break;
+			case OVAL_OPERATION_NOT_EQUAL:
+				if (strcmp(res->file, file) == 0) {
+					free(res->file);
+					continue;
+				}
+				break;
+			case OVAL_OPERATION_PATTERN_MATCH:
+				switch (pcre_exec(re, NULL, res->file, strlen(res->file), 0, 0, NULL, 0)) {
+				case 0: /* match */
+					break;
+				case -1:
+					/* mismatch */
+					free(res->file);
+					continue;
+				default:
+					dE("pcre_exec() failed!");
+					ret = -1;
+					free(res->file);
+					continue;
+				}
+				break;
+			default:
+				/* unsupported operation */
+				dE("Operation \"%d\" on `filepath' not supported", file_op);
 				ret = -1;
+				free(res->file);
+				continue;
+			}
+
+			if (rpmVerifyFile(g_rpm.rpmts, fi, &res->vflags, omit) != 0)
+				res->vflags = RPMVERIFY_FAILURES;
 
-			break;
-		default:
-			ret = 0;
+			if (callback(ctx, res) != 0)
+				ret = 1;
+			free(res->file);
 		}
+
+		rpmfiFree(fi);
 	}
+
 	return ret;
 }
 
 static int rpmverify_collect(probe_ctx *ctx,
-			     const char *file, oval_operation_t file_op,
+			     const char *file, oval_operation_t file_op, bool file_lookup,
 			     SEXP_t *name_ent, SEXP_t *epoch_ent, SEXP_t *version_ent, SEXP_t *release_ent, SEXP_t *arch_ent,
 			     uint64_t flags,
 			     int (*callback)(probe_ctx *, struct rpmverify_res *))
 {
 	rpmdbMatchIterator match;
-	rpmVerifyAttrs omit = (rpmVerifyAttrs)(flags & RPMVERIFY_RPMATTRMASK);
 	Header pkgh;
 	pcre *re = NULL;
-	int  ret = -1;
+	struct rpm_index *idx;
+	struct rpm_index_pkg **pkgs, *pkg;
+	size_t count, p;
+	int  ret = 0;
 
 	/* pre-compile regex if needed */
 	if (file_op == OVAL_OPERATION_PATTERN_MATCH) {
@@ -151,157 +215,66 @@ static int rpmverify_collect(probe_ctx *ctx,
 		}
 	}
 
-	RPMVERIFY_LOCK;
+	idx = rpm_index_get(&g_rpm);
 
-	match = rpmtsInitIterator (g_rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
-	if (match == NULL) {
-		ret = 0;
-		goto ret;
+	if (idx == NULL) {
+		if (re != NULL)
+			pcre_free(re);
+		return (-1);
 	}
 
-	if ((ret = adjust_filter(match, name_ent, RPMTAG_NAME)) == -1) {
-		dE("can't adjust filter with name");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, epoch_ent, RPMTAG_EPOCH)) == -1) {
-		dE("can't adjust filter with epoch");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, version_ent, RPMTAG_VERSION)) == -1) {
-		dE("can't adjust filter with version");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, release_ent, RPMTAG_RELEASE)) == -1) {
-		dE("can't adjust filter with version");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, arch_ent, RPMTAG_ARCH)) == -1) {
-		dE("can't adjust filter with version");
-		goto ret;
+	/* Only the owners of the file are checked if the object requires an equal path */
+	count = rpm_index_select(&g_rpm, idx, name_ent, file_lookup ? file : NULL, &pkgs);
+
+	if (rpmverify_lock() != 0) {
+		if (re != NULL)
+			pcre_free(re);
+		free(pkgs);
+		rpm_index_put(idx);
+		return (-1);
 	}
 
 	assume_d(RPMTAG_BASENAMES != 0, -1);
 	assume_d(RPMTAG_DIRNAMES  != 0, -1);
 
-	while ((pkgh = rpmdbNextIterator (match)) != NULL) {
-		SEXP_t *ent;
-		rpmfi  fi;
-		rpmTag tag[2] = { RPMTAG_BASENAMES, RPMTAG_DIRNAMES };
+	for (p = 0; p < count && ret == 0; ++p) {
 		struct rpmverify_res res;
-		errmsg_t rpmerr;
-		int i;
-
-		/*
-+SEXP_t *probe_ent_from_cstr(const char *name, oval_datatype_t type,
-+                            const char *value, size_t vallen)
-		 */
-
-#define COMPARE_ENT(XXX) \
-		if (XXX ## _ent != NULL) { \
-			ent = probe_entval_from_cstr( \
-				probe_ent_getdatatype(XXX ## _ent), res.XXX, strlen(res.XXX) \
-			); \
-			if (ent != NULL && probe_entobj_cmp(XXX ## _ent, ent) != OVAL_RESULT_TRUE) { \
-				SEXP_free(ent); \
-				continue; \
-			} \
-			SEXP_free(ent); \
-		}
 
-		res.name = headerFormat(pkgh, "%{NAME}", &rpmerr);
-		COMPARE_ENT(name);
-
-		res.epoch = headerFormat(pkgh, "%{EPOCH}", &rpmerr);
-		COMPARE_ENT(epoch);
-
-		res.version = headerFormat(pkgh, "%{VERSION}", &rpmerr);
-		COMPARE_ENT(version);
-		res.release = headerFormat(pkgh, "%{RELEASE}", &rpmerr);
-		COMPARE_ENT(release);
-		res.arch = headerFormat(pkgh, "%{ARCH}", &rpmerr);
-		COMPARE_ENT(arch);
-		snprintf(res.extended_name, 1024, "%s-%s:%s-%s.%s", res.name,
-			oscap_streq(res.epoch, "(none)") ? "0" : res.epoch,
-			res.version, res.release, res.arch);
-
-		/*
-		 * Inspect package files & directories
-		 */
-		for (i = 0; i < 2; ++i) {
-		  fi = rpmfiNew(g_rpm.rpmts, pkgh, tag[i], 1);
-
-		  while (rpmfiNext(fi) != -1) {
-				res.file = oscap_strdup(rpmfiFN(fi));
-		    res.fflags = rpmfiFFlags(fi);
-		    res.oflags = omit;
-
-		    if (((res.fflags & RPMFILE_CONFIG) && (flags & RPMVERIFY_SKIP_CONFIG)) ||
-					((res.fflags & RPMFILE_GHOST)  && (flags & RPMVERIFY_SKIP_GHOST))) {
-					free(res.file);
-					continue;
-				}
+		pkg = pkgs[p];
 
-		    switch(file_op) {
-		    case OVAL_OPERATION_EQUALS:
-					if (strcmp(res.file, file) != 0) {
-						free(res.file);
-						continue;
-					}
-		      break;
-		    case OVAL_OPERATION_NOT_EQUAL:
-					if (strcmp(res.file, file) == 0) {
-						free(res.file);
-						continue;
-					}
-		      break;
-		    case OVAL_OPERATION_PATTERN_MATCH:
-		      ret = pcre_exec(re, NULL, res.file, strlen(res.file), 0, 0, NULL, 0);
-
-		      switch(ret) {
-		      case 0: /* match */
-			break;
-		      case -1:
-			/* mismatch */
-			free(res.file);
+		if (!rpm_index_ent_cmp(name_ent, pkg->name) ||
+		    !rpm_index_ent_cmp(epoch_ent, pkg->epoch) ||
+		    !rpm_index_ent_cmp(version_ent, pkg->version) ||
+		    !rpm_index_ent_cmp(release_ent, pkg->release) ||
+		    !rpm_index_ent_cmp(arch_ent, pkg->arch))
 			continue;
-		      default:
-			dE("pcre_exec() failed!");
-			ret = -1;
-			free(res.file);
-			goto ret;
-		      }
-		      break;
-		    default:
-		      /* unsupported operation */
-		      dE("Operation \"%d\" on `filepath' not supported", file_op);
-		      ret = -1;
-					free(res.file);
-		      goto ret;
-		    }
-
-		    if (rpmVerifyFile(g_rpm.rpmts, fi, &res.vflags, omit) != 0)
-		      res.vflags = RPMVERIFY_FAILURES;
-
-		    if (callback(ctx, &res) != 0) {
-			    ret = 0;
-					free(res.file);
-			    goto ret;
-		    }
-			free(res.file);
-		  }
-
-		  rpmfiFree(fi);
-		}
+
+		res.name = pkg->name;
+		res.epoch = pkg->epoch;
+		res.version = pkg->version;
+		res.release = pkg->release;
+		res.arch = pkg->arch;
+		res.extended_name = pkg->extended_name;
+
+		match = rpm_index_pkg_iterator(&g_rpm, pkg);
+
+		while (ret == 0 && match != NULL && (pkgh = rpmdbNextIterator (match)) != NULL)
+			ret = rpmverify_collect_header(ctx, &res, pkgh, file, file_op, re, flags, callback);
+
+		if (match != NULL)
+			rpmdbFreeIterator(match);
 	}
 
-	match = rpmdbFreeIterator (match);
-	ret   = 0;
-ret:
+	RPMVERIFY_UNLOCK;
+
 	if (re != NULL)
 		pcre_free(re);
 
-	RPMVERIFY_UNLOCK;
-	return (ret);
+	free(pkgs);
+	rpm_index_put(idx);
+
+	/* the collection was stopped by the callback */
+	return ret == 1 ? 0 : ret;
 }
 
 void probe_preload ()
@@ -447,6 +420,7 @@ int probe_main (probe_ctx *ctx, void *arg)
 	char   file[PATH_MAX];
 	size_t file_len = sizeof file;
 	oval_operation_t file_op;
+	bool file_lookup;
 	uint64_t collect_flags = 0;
 	unsigned int i;
 
@@ -484,6 +458,7 @@ int probe_main (probe_ctx *ctx, void *arg)
 	}
 
 	PROBE_ENT_STRVAL(file_ent, file, file_len, /* void */, strcpy(file, ""););
+	file_lookup = file_op == OVAL_OPERATION_EQUALS && !probe_ent_attrexists(file_ent, "var_ref");
 	SEXP_free(file_ent);
 
 	name_ent = probe_obj_getent(probe_in, "name", 1);
@@ -520,7 +495,7 @@ int probe_main (probe_ctx *ctx, void *arg)
 	   file, file_op);
 
 	if (rpmverify_collect(ctx,
-			      file, file_op,
+			      file, file_op, file_lookup,
 			      name_ent, epoch_ent, version_ent, release_ent, arch_ent,
 			      collect_flags,
 			      rpmverify_additem) != 0)
@@ -44,6 +44,7 @@
 #include <pcre.h>
 
 #include "rpm-helper.h"
+#include "rpm-index.h"
 #include "probe-chroot.h"
 
 /* Individual RPM headers */
@@ -75,12 +76,12 @@ const rpmverifypackage_bhmap_t rpmverifypackage_bhmap[] = {
 };
 
 struct rpmverify_res {
-	char *name;  /**< package name */
-	char *epoch;
-	char *version;
-	char *release;
-	char *arch;
-	char extended_name[1024];
+	const char *name;  /**< package name */
+	const char *epoch;
+	const char *version;
+	const char *release;
+	const char *arch;
+	const char *extended_name;
 	uint64_t vflags; /**< rpm verify flags */
 	uint64_t vresults;
 };
@@ -108,6 +109,16 @@ static struct poptOption optionsTable[] = {
 
 #define RPMVERIFY_UNLOCK RPM_MUTEX_UNLOCK(&g_rpm.rpm.mutex)
 
+/*
+ * Locks the rpm mutex, returns -1 instead of returning from the caller
+ * so that the caller can release what it holds, see RPM_MUTEX_LOCK.
+ */
+static int rpmverify_lock(void)
+{
+	RPMVERIFY_LOCK;
+	return 0;
+}
+
 #define CHROOT_ENTER() probe_chroot_enter(&g_rpm.chr)
 
 #define CHROOT_LEAVE() probe_chroot_leave(&g_rpm.chr)
@@ -116,119 +127,55 @@ static struct poptOption optionsTable[] = {
 
 #define CHROOT_PATH() probe_chroot_get_path(&g_rpm.chr)
 
-/* modify passed-in iterator to test also given entity */
-static int adjust_filter(rpmdbMatchIterator iterator, SEXP_t *ent, rpmTag rpm_tag) {
-	oval_operation_t ent_op;
-	char ent_str[1024] = "";
-	int ret = 0;
-
-	if (ent) {
-		ent_op = probe_ent_getoperation(ent, OVAL_OPERATION_EQUALS);
-		PROBE_ENT_STRVAL(ent, ent_str, sizeof ent_str, /* void */, strcpy(ent_str, ""););
-		if (rpm_tag == RPMTAG_EPOCH && strcmp(ent_str, "(none)") == 0) {
-			return ret;
-		}
-
-		switch (ent_op) {
-		case OVAL_OPERATION_EQUALS:
-			if (rpmdbSetIteratorRE (iterator, rpm_tag, RPMMIRE_STRCMP, ent_str) != 0)
-				ret = -1;
-
-			break;
-		case OVAL_OPERATION_PATTERN_MATCH:
-			if (rpmdbSetIteratorRE (iterator, rpm_tag, RPMMIRE_REGEX,
-						(const char *)ent_str) != 0)
-				ret = -1;
-
-			break;
-		default:
-			ret = 0;
-		}
-	}
-	return ret;
-}
-
 static int rpmverify_collect(probe_ctx *ctx,
 			     SEXP_t *name_ent, SEXP_t *epoch_ent, SEXP_t *version_ent, SEXP_t *release_ent, SEXP_t *arch_ent,
 			     uint64_t flags,
 			     int (*callback)(probe_ctx *, struct rpmverify_res *))
 {
-	rpmdbMatchIterator match;
-	Header pkgh;
+	struct rpm_index *idx;
+	struct rpm_index_pkg **pkgs, *pkg;
+	size_t count, p;
 	int  ret = -1;
 	unsigned int i, j, rpmcli_argc = 0;
 	const char * rpmcli_argv[10];
 	poptContext rpmcli_context;
 	QVA_t qva;
 
-	RPMVERIFY_LOCK;
+	idx = rpm_index_get(&g_rpm.rpm);
 
-	match = rpmtsInitIterator (g_rpm.rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
-	if (match == NULL) {
-		ret = 0;
-		goto ret;
-	}
+	if (idx == NULL)
+		return (-1);
 
-	if ((ret = adjust_filter(match, name_ent, RPMTAG_NAME)) == -1) {
-		dE("can't adjust filter with name");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, epoch_ent, RPMTAG_EPOCH)) == -1) {
-		dE("can't adjust filter with epoch");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, version_ent, RPMTAG_VERSION)) == -1) {
-		dE("can't adjust filter with version");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, release_ent, RPMTAG_RELEASE)) == -1) {
-		dE("can't adjust filter with version");
-		goto ret;
-	}
-	if ((ret = adjust_filter(match, arch_ent, RPMTAG_ARCH)) == -1) {
-		dE("can't adjust filter with version");
-		goto ret;
-	}
+	count = rpm_index_select(&g_rpm.rpm, idx, name_ent, NULL, &pkgs);
 
-	assume_d(RPMTAG_BASENAMES != 0, -1);
-	assume_d(RPMTAG_DIRNAMES  != 0, -1);
+	if (rpmverify_lock() != 0) {
+		free(pkgs);
+		rpm_index_put(idx);
+		return (-1);
+	}
 
 	rpmcli_argv[0] = "probe_rpmverifypackage";
 	rpmcli_argv[1] = "--quiet";
 	rpmcli_argv[2] = "--nofiles";
 
-	while ((pkgh = rpmdbNextIterator (match)) != NULL) {
-		SEXP_t *ent;
+	for (p = 0; p < count; ++p) {
 		struct rpmverify_res res;
-		errmsg_t rpmerr;
-
-#define COMPARE_ENT(XXX) \
-		if (XXX ## _ent != NULL) { \
-			ent = probe_entval_from_cstr( \
-				probe_ent_getdatatype(XXX ## _ent), res.XXX, strlen(res.XXX) \
-			); \
-			if (ent != NULL && probe_entobj_cmp(XXX ## _ent, ent) != OVAL_RESULT_TRUE) { \
-				SEXP_free(ent); \
-				continue; \
-			} \
-			SEXP_free(ent); \
-		}
 
-		res.name = headerFormat(pkgh, "%{NAME}", &rpmerr);
-		COMPARE_ENT(name);
+		pkg = pkgs[p];
 
-		res.epoch = headerFormat(pkgh, "%{EPOCH}", &rpmerr);
-		COMPARE_ENT(epoch);
+		if (!rpm_index_ent_cmp(name_ent, pkg->name) ||
+		    !rpm_index_ent_cmp(epoch_ent, pkg->epoch) ||
+		    !rpm_index_ent_cmp(version_ent, pkg->version) ||
+		    !rpm_index_ent_cmp(release_ent, pkg->release) ||
+		    !rpm_index_ent_cmp(arch_ent, pkg->arch))
+			continue;
 
-		res.version = headerFormat(pkgh, "%{VERSION}", &rpmerr);
-		COMPARE_ENT(version);
-		res.release = headerFormat(pkgh, "%{RELEASE}", &rpmerr);
-		COMPARE_ENT(release);
-		res.arch = headerFormat(pkgh, "%{ARCH}", &rpmerr);
-		COMPARE_ENT(arch);
-		snprintf(res.extended_name, 1024, "%s-%s:%s-%s.%s", res.name,
-			oscap_streq(res.epoch, "(none)") ? "0" : res.epoch,
-			res.version, res.release, res.arch);
+		res.name = pkg->name;
+		res.epoch = pkg->epoch;
+		res.version = pkg->version;
+		res.release = pkg->release;
+		res.arch = pkg->arch;
+		res.extended_name = pkg->extended_name;
 
 		/*
 		 * Verify package
@@ -296,17 +243,15 @@ static int rpmverify_collect(probe_ctx *ctx,
 			ret = 1;
 			goto ret;
 		}
-		free(res.name);
-		free(res.epoch);
-		free(res.version);
-		free(res.release);
-		free(res.arch);
 	}
 
-	match = rpmdbFreeIterator (match);
 	ret   = 0;
 ret:
 	RPMVERIFY_UNLOCK;
+
+	free(pkgs);
+	rpm_index_put(idx);
+
 	return (ret);
 }
 
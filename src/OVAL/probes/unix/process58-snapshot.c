@@ -0,0 +1,555 @@
+/*
+ * Copyright 2015 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#if defined(__linux__)
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <ctype.h>
+#ifdef HAVE_STDIO_EXT_H
+# include <stdio_ext.h>
+#endif
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "probe-api.h"
+#include "common/debug_priv.h"
+#include "common/oscap_buffer.h"
+#include "process58-snapshot.h"
+
+#define CHUNK_SIZE 1024
+#define PROC_INITIAL_COUNT 256
+
+static struct {
+	pthread_mutex_t lock;
+	pthread_once_t once;
+	bool enabled;
+	struct proc_snapshot *snap;
+} proc_snapshots = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.once = PTHREAD_ONCE_INIT
+};
+
+static void proc_snapshot_init(void)
+{
+	const char *env = getenv(PROC_SNAPSHOT_ENV);
+
+	proc_snapshots.enabled = (env == NULL || strcmp(env, "0") != 0);
+}
+
+static unsigned long get_boot_time(void)
+{
+	char buf[100];
+	FILE *sf;
+	int line;
+	unsigned long boot = 0;
+
+	sf = fopen("/proc/stat", "rt");
+	if (sf == NULL)
+		return 0;
+
+	line = 0;
+	__fsetlocking(sf, FSETLOCKING_BYCALLER);
+	while (fgets(buf, sizeof(buf), sf)) {
+		if (line == 0) {
+			line++;
+			continue;
+		}
+		if (memcmp(buf, "btime", 5) == 0) {
+			sscanf(buf, "btime %lu", &boot);
+			break;
+		}
+	}
+	fclose(sf);
+
+	return boot;
+}
+
+/*
+ * Parse /proc/<pid>/stat. Returns false if the process has
+ * to be skipped.
+ */
+static bool read_stat(int pid, struct proc_entry *ent)
+{
+	int fd, len;
+	char buf[256];
+	char *tmp;
+	int pgrp, tpgid;
+	unsigned flags;
+	unsigned long minflt, cminflt, majflt, cmajflt;
+	long cutime, cstime, cnice, nthreads, itrealvalue;
+
+	snprintf(buf, 32, "/proc/%d/stat", pid);
+	fd = open(buf, O_RDONLY, 0);
+	if (fd < 0)
+		return false;
+	len = read(fd, buf, sizeof buf - 1);
+	close(fd);
+	if (len < 40)
+		return false;
+	buf[len] = 0;
+	tmp = strrchr(buf, ')');
+	if (tmp)
+		*tmp = 0;
+	else
+		return false;
+
+	memset(ent, 0, sizeof(struct proc_entry));
+	ent->pid = pid;
+	sscanf(buf, "%d (%15c", &ent->ppid, ent->comm);
+	sscanf(tmp+2,	"%c %d %d %d %d %d "
+			"%u %lu %lu %lu %lu "
+			"%lu %lu %lu %ld %ld "
+			"%ld %ld %ld %llu",
+		&ent->state, &ent->ppid, &pgrp, &ent->session, &ent->tty_nr, &tpgid,
+		&flags, &minflt, &cminflt, &majflt, &cmajflt,
+		&ent->uutime, &ent->ustime, &cutime, &cstime, &ent->priority,
+		&cnice, &nthreads, &itrealvalue, &ent->start
+	);
+
+	// Skip kthreads
+	return ent->ppid != 2;
+}
+
+/**
+ * Parse /proc/%d/cmdline file
+ * @param filepath Path to file ~ use preallocated buffer for the path
+ * @param buffer output buffer with non-zero size
+ * @return ps-like command info or NULL
+ */
+static inline bool get_process_cmdline(const char* filepath, struct oscap_buffer* const buffer){
+
+	int fd = open(filepath, O_RDONLY, 0);
+
+	if (fd < 0) {
+		return false;
+	}
+
+	oscap_buffer_clear(buffer);
+
+	for(;;) {
+		char chunk[CHUNK_SIZE];
+		// Read data, store to buffer
+		ssize_t read_size = read(fd, chunk, CHUNK_SIZE);
+		if (read_size < 0) {
+			close(fd);
+			return false;
+		}
+		oscap_buffer_append_binary_data(buffer, chunk, read_size);
+
+		// If reach end of file, then end the loop
+		if (CHUNK_SIZE != read_size) {
+			break;
+		}
+	}
+
+	close(fd);
+
+	int length = oscap_buffer_get_length(buffer);
+	char* buffer_mem = oscap_buffer_get_raw(buffer);
+
+	if ( length == 0 ) { // empty file
+		return false;
+	} else {
+
+		// Skip multiple trailing zeros
+		int i = length - 1;
+		while ( (i > 0) && (buffer_mem[i] == '\0') ) {
+			--i;
+		}
+
+		// Program and args are separated by '\0'
+		// Replace them with spaces ' '
+		while( i >= 0 ){
+			char chr = buffer_mem[i];
+			if ( ( chr == '\0') || ( chr == '\n' ) ) {
+				buffer_mem[i] = ' ';
+			} else if ( !isprint(chr) ) { // "ps" replace non-printable characters with '.' (LC_ALL=C)
+				buffer_mem[i] = '.';
+			}
+			--i;
+		}
+	}
+	return true;
+}
+
+static void load_cmdline(struct proc_entry *ent)
+{
+	char buf[32];
+	struct oscap_buffer *cmdline_buffer;
+
+	if (ent->state == 'Z') { // zombie
+		ent->cmdline = malloc(1 + strlen(ent->comm) + sizeof("] <defunct>"));
+		sprintf(ent->cmdline, "[%s] <defunct>", ent->comm);
+		return;
+	}
+
+	cmdline_buffer = oscap_buffer_new();
+	snprintf(buf, sizeof(buf), "/proc/%d/cmdline", ent->pid);
+	if (get_process_cmdline(buf, cmdline_buffer)) {
+		ent->cmdline = strdup(oscap_buffer_get_raw(cmdline_buffer)); // use full cmdline
+	} else {
+		ent->cmdline = strdup(ent->comm);
+	}
+	oscap_buffer_free(cmdline_buffer);
+}
+
+static void load_uids(struct proc_entry *ent)
+{
+	char buf[100];
+	FILE *sf;
+
+	ent->ruid = -1;
+	ent->user_id = -1;
+
+	snprintf(buf, sizeof(buf), "/proc/%d/status", ent->pid);
+	sf = fopen(buf, "rt");
+	if (sf) {
+		int line = 0;
+		__fsetlocking(sf, FSETLOCKING_BYCALLER);
+		while (fgets(buf, sizeof(buf), sf)) {
+			if (line == 0) {
+				line++;
+				continue;
+			}
+			if (memcmp(buf, "Uid:", 4) == 0) {
+				sscanf(buf, "Uid: %d %d", &ent->ruid, &ent->user_id);
+				break;
+			}
+		}
+		fclose(sf);
+	}
+}
+
+static void load_loginuid(struct proc_entry *ent)
+{
+	char buf[100];
+	FILE *sf;
+
+	ent->loginuid = -1;
+
+	snprintf(buf, sizeof(buf), "/proc/%d/loginuid", ent->pid);
+	sf = fopen(buf, "rt");
+	if (sf) {
+		if (fscanf(sf, "%u", &ent->loginuid) < 1) {
+			dW("fscanf failed from %s", buf);
+		}
+		fclose(sf);
+	}
+}
+
+/* get exec shield status according to http://people.redhat.com/sgrubb/files/lsexec
+ * return value: -1 - not detected, 0 - disabled, 1 - enabled */
+static void load_exec_shield(struct proc_entry *ent)
+{
+	char buf[501];
+	FILE *sf;
+	long unsigned low, high, inode;
+	long long unsigned offset;
+	int dev_min, dev_maj;
+	char perm[3], trim;
+	int read_items;
+
+	ent->exec_shield = -1;
+
+	snprintf(buf, sizeof(buf), "/proc/%d/maps", ent->pid);
+	sf = fopen(buf, "rt");
+	if (sf) {
+		while (fgets(buf, 500, sf)) {
+			read_items = sscanf(
+				buf, "%lx-%lx rw%s %llx %x:%x %lu %c\n",
+				&low, &high, perm, &offset, &dev_min,
+				&dev_maj, &inode, &trim
+			);
+			if (read_items == 7) {
+				if (perm[0] == 'x' && offset != 0) {
+					ent->exec_shield = 0;
+				}
+				else {
+					ent->exec_shield = 1;
+				}
+			}
+		}
+		fclose(sf);
+	}
+}
+
+/* Has to be called with the snapshot lock held */
+static void load_fields(struct proc_entry *ent, unsigned fields)
+{
+	fields &= ~ent->loaded;
+
+	if (fields & PROC_FIELD_CMDLINE)
+		load_cmdline(ent);
+	if (fields & PROC_FIELD_UIDS)
+		load_uids(ent);
+	if (fields & PROC_FIELD_LOGINUID)
+		load_loginuid(ent);
+	if (fields & PROC_FIELD_MAPS)
+		load_exec_shield(ent);
+
+	ent->loaded |= fields;
+}
+
+static int proc_pidcmp(const void *a, const void *b)
+{
+	return ((const struct proc_entry *)a)->pid - ((const struct proc_entry *)b)->pid;
+}
+
+static int proc_commcmp(const void *a, const void *b)
+{
+	return strcmp((*(struct proc_entry * const *)a)->comm, (*(struct proc_entry * const *)b)->comm);
+}
+
+static int proc_cmdlinecmp(const void *a, const void *b)
+{
+	return strcmp((*(struct proc_entry * const *)a)->cmdline, (*(struct proc_entry * const *)b)->cmdline);
+}
+
+static struct proc_snapshot *proc_snapshot_take(void)
+{
+	struct proc_snapshot *snap;
+	struct dirent *dent;
+	size_t size = PROC_INITIAL_COUNT;
+	DIR *d;
+	int pid;
+
+	d = opendir("/proc");
+	if (d == NULL)
+		return NULL;
+
+	snap = calloc(1, sizeof(struct proc_snapshot));
+	pthread_mutex_init(&snap->lock, NULL);
+	snap->refs = 1;
+	// Get the time tick hertz
+	snap->ticks = (unsigned long)sysconf(_SC_CLK_TCK);
+	snap->boot = get_boot_time();
+	snap->procs = malloc(size * sizeof(struct proc_entry));
+
+	// Scan the directories
+	while ((dent = readdir(d))) {
+		// Skip non-process dir entries
+		if (*dent->d_name < '0' || *dent->d_name > '9')
+			continue;
+		errno = 0;
+		pid = strtol(dent->d_name, NULL, 10);
+		if (errno || pid == 2) // skip err & kthreads
+			continue;
+
+		if (snap->count == size) {
+			size *= 2;
+			snap->procs = realloc(snap->procs, size * sizeof(struct proc_entry));
+		}
+		if (read_stat(pid, &snap->procs[snap->count]))
+			++snap->count;
+	}
+	closedir(d);
+
+	qsort(snap->procs, snap->count, sizeof(struct proc_entry), proc_pidcmp);
+	dD("Process table snapshot: %zu processes.", snap->count);
+
+	return snap;
+}
+
+static void proc_snapshot_free(struct proc_snapshot *snap)
+{
+	for (size_t i = 0; i < snap->count; ++i)
+		free(snap->procs[i].cmdline);
+
+	free(snap->index[PROC_KEY_COMM]);
+	free(snap->index[PROC_KEY_CMDLINE]);
+	free(snap->procs);
+	pthread_mutex_destroy(&snap->lock);
+	free(snap);
+}
+
+struct proc_snapshot *proc_snapshot_get(void)
+{
+	struct proc_snapshot *snap;
+
+	pthread_once(&proc_snapshots.once, proc_snapshot_init);
+
+	if (!proc_snapshots.enabled)
+		return proc_snapshot_take();
+
+	/* Concurrent callers wait for the snapshot taken by the first one */
+	pthread_mutex_lock(&proc_snapshots.lock);
+	if (proc_snapshots.snap == NULL)
+		proc_snapshots.snap = proc_snapshot_take();
+	snap = proc_snapshots.snap;
+	if (snap != NULL)
+		++snap->refs;
+	pthread_mutex_unlock(&proc_snapshots.lock);
+
+	return snap;
+}
+
+void proc_snapshot_put(struct proc_snapshot *snap)
+{
+	bool destroy;
+
+	if (snap == NULL)
+		return;
+
+	pthread_mutex_lock(&proc_snapshots.lock);
+	destroy = --snap->refs == 0;
+	pthread_mutex_unlock(&proc_snapshots.lock);
+
+	if (destroy)
+		proc_snapshot_free(snap);
+}
+
+void proc_snapshot_invalidate(void)
+{
+	struct proc_snapshot *snap;
+
+	pthread_mutex_lock(&proc_snapshots.lock);
+	snap = proc_snapshots.snap;
+	proc_snapshots.snap = NULL;
+	pthread_mutex_unlock(&proc_snapshots.lock);
+
+	proc_snapshot_put(snap);
+}
+
+struct proc_entry *proc_snapshot_find_pid(struct proc_snapshot *snap, int pid)
+{
+	struct proc_entry key;
+
+	key.pid = pid;
+	return bsearch(&key, snap->procs, snap->count, sizeof(struct proc_entry), proc_pidcmp);
+}
+
+size_t proc_snapshot_find(struct proc_snapshot *snap, int key, const char *value, struct proc_entry ***ents)
+{
+	int (*cmp)(const void *, const void *);
+	struct proc_entry **index, **first, **last;
+	struct proc_entry kent, *kptr = &kent;
+	size_t lo, hi, mid;
+
+	cmp = key == PROC_KEY_COMM ? proc_commcmp : proc_cmdlinecmp;
+
+	pthread_mutex_lock(&snap->lock);
+	if (snap->index[key] == NULL) {
+		index = malloc((snap->count + 1) * sizeof(struct proc_entry *));
+		for (size_t i = 0; i < snap->count; ++i) {
+			if (key == PROC_KEY_CMDLINE)
+				load_fields(&snap->procs[i], PROC_FIELD_CMDLINE);
+			index[i] = &snap->procs[i];
+		}
+		qsort(index, snap->count, sizeof(struct proc_entry *), cmp);
+		snap->index[key] = index;
+	}
+	index = snap->index[key];
+	pthread_mutex_unlock(&snap->lock);
+
+	if (key == PROC_KEY_COMM) {
+		/* The name is truncated to 15 characters by the kernel */
+		if (strlen(value) >= sizeof(kent.comm)) {
+			*ents = NULL;
+			return 0;
+		}
+		strcpy(kent.comm, value);
+	} else {
+		kent.cmdline = (char *)value;
+	}
+
+	/* Lower bound of the value */
+	lo = 0;
+	hi = snap->count;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (cmp(&index[mid], &kptr) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	first = last = index + lo;
+	while (last < index + snap->count && cmp(last, &kptr) == 0)
+		++last;
+
+	*ents = first;
+	return (size_t)(last - first);
+}
+
+/*
+ * Get the value of an entity which requires an equal value,
+ * returns NULL if the entity can match more values.
+ */
+static SEXP_t *get_equal_value(SEXP_t *ent)
+{
+	if (ent == NULL || probe_ent_attrexists(ent, "var_ref") ||
+	    probe_ent_getoperation(ent, OVAL_OPERATION_EQUALS) != OVAL_OPERATION_EQUALS)
+		return NULL;
+
+	return probe_ent_getval(ent);
+}
+
+size_t proc_snapshot_select(struct proc_snapshot *snap, SEXP_t *pid_ent, SEXP_t *cmd_ent, int cmd_key, struct proc_entry ***ents)
+{
+	struct proc_entry **found, *ent;
+	SEXP_t *val;
+	size_t count;
+	char *cmd;
+
+	if ((val = get_equal_value(pid_ent)) != NULL) {
+		ent = NULL;
+		if (SEXP_numberp(val) && probe_ent_getdatatype(pid_ent) == OVAL_DATATYPE_INTEGER)
+			ent = proc_snapshot_find_pid(snap, SEXP_number_geti_32(val));
+		SEXP_free(val);
+		*ents = malloc(sizeof(struct proc_entry *));
+		**ents = ent;
+		return ent != NULL ? 1 : 0;
+	}
+
+	if ((val = get_equal_value(cmd_ent)) != NULL) {
+		cmd = SEXP_stringp(val) ? SEXP_string_cstr(val) : NULL;
+		SEXP_free(val);
+		if (cmd != NULL) {
+			count = proc_snapshot_find(snap, cmd_key, cmd, &found);
+			free(cmd);
+			*ents = malloc((count + 1) * sizeof(struct proc_entry *));
+			if (count > 0)
+				memcpy(*ents, found, count * sizeof(struct proc_entry *));
+			return count;
+		}
+	}
+
+	*ents = malloc((snap->count + 1) * sizeof(struct proc_entry *));
+	for (count = 0; count < snap->count; ++count)
+		(*ents)[count] = &snap->procs[count];
+
+	return count;
+}
+
+void proc_entry_load(struct proc_snapshot *snap, struct proc_entry *ent, unsigned fields)
+{
+	pthread_mutex_lock(&snap->lock);
+	load_fields(ent, fields);
+	pthread_mutex_unlock(&snap->lock);
+}
+
+#endif /* __linux__ */
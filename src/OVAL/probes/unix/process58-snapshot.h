@@ -0,0 +1,112 @@
+#ifndef PROCESS58_SNAPSHOT_H
+#define PROCESS58_SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <sexp.h>
+
+/*
+ * Process table snapshot
+ *
+ * The process and process58 probes evaluate all their objects against
+ * one snapshot of /proc taken when the first object is evaluated. Only
+ * /proc/<pid>/stat is read when the snapshot is taken, the remaining
+ * fields are read on the first use (see proc_entry_load()) and then
+ * kept in the snapshot. The snapshot is dropped on the probe reset
+ * (i.e. when a new scan begins). Setting OSCAP_PROBE_PROC_SNAPSHOT=0
+ * makes every object read /proc on its own.
+ */
+#define PROC_SNAPSHOT_ENV "OSCAP_PROBE_PROC_SNAPSHOT"
+
+/* Lazily loaded fields */
+#define PROC_FIELD_CMDLINE  0x01 /* /proc/<pid>/cmdline */
+#define PROC_FIELD_UIDS     0x02 /* /proc/<pid>/status */
+#define PROC_FIELD_LOGINUID 0x04 /* /proc/<pid>/loginuid */
+#define PROC_FIELD_MAPS     0x08 /* /proc/<pid>/maps */
+
+/* Lookup keys */
+#define PROC_KEY_COMM    0 /* name of the executable, at most 15 chars */
+#define PROC_KEY_CMDLINE 1 /* command line as shown by ps */
+
+struct proc_entry {
+	int pid;
+	int ppid;
+	int session;
+	int tty_nr;
+	char state;
+	char comm[16];
+	unsigned long uutime, ustime;
+	long priority;
+	unsigned long long start;
+
+	unsigned loaded;     /* mask of the loaded PROC_FIELD_* fields */
+	char *cmdline;       /* PROC_FIELD_CMDLINE */
+	int ruid, user_id;   /* PROC_FIELD_UIDS, -1 if unknown */
+	unsigned loginuid;   /* PROC_FIELD_LOGINUID, (unsigned)-1 if unknown */
+	int exec_shield;     /* PROC_FIELD_MAPS, -1 - not detected, 0 - disabled, 1 - enabled */
+};
+
+struct proc_snapshot {
+	pthread_mutex_t lock;
+	unsigned refs;
+	unsigned long ticks;         /* clock ticks per second */
+	unsigned long boot;          /* boot time */
+	struct proc_entry *procs;    /* sorted by pid */
+	size_t count;
+	struct proc_entry **index[2]; /* sorted by the PROC_KEY_* keys, built on demand */
+};
+
+/**
+ * Get the snapshot of the process table, take it if there's none.
+ * @return referenced snapshot or NULL if /proc can't be read
+ */
+struct proc_snapshot *proc_snapshot_get(void);
+
+/**
+ * Release a snapshot obtained by proc_snapshot_get().
+ */
+void proc_snapshot_put(struct proc_snapshot *snap);
+
+/**
+ * Drop the current snapshot, the next proc_snapshot_get() takes a new one.
+ * Snapshots still in use stay valid until they are released.
+ */
+void proc_snapshot_invalidate(void);
+
+/**
+ * Find a process by its pid.
+ * @return the process or NULL
+ */
+struct proc_entry *proc_snapshot_find_pid(struct proc_snapshot *snap, int pid);
+
+/**
+ * Find processes by the command name or command line.
+ * @param key PROC_KEY_COMM or PROC_KEY_CMDLINE
+ * @param value the name or command line
+ * @param ents array of the matching processes is stored here, it's valid
+ *        as long as the snapshot is referenced
+ * @return number of the matching processes
+ */
+size_t proc_snapshot_find(struct proc_snapshot *snap, int key, const char *value, struct proc_entry ***ents);
+
+/**
+ * Get the processes which can match the pid and command entities of
+ * an object. The lookup uses the indexes if an entity requires an equal
+ * value, the entities still have to be compared by the caller.
+ * @param pid_ent the pid entity or NULL
+ * @param cmd_ent the command entity or NULL
+ * @param cmd_key PROC_KEY_COMM or PROC_KEY_CMDLINE
+ * @param ents the processes are stored here, the array has to be freed
+ *        by the caller
+ * @return number of the processes
+ */
+size_t proc_snapshot_select(struct proc_snapshot *snap, SEXP_t *pid_ent, SEXP_t *cmd_ent, int cmd_key, struct proc_entry ***ents);
+
+/**
+ * Make sure the requested fields of the process are read.
+ * @param fields mask of PROC_FIELD_* values
+ */
+void proc_entry_load(struct proc_snapshot *snap, struct proc_entry *ent, unsigned fields);
+
+#endif
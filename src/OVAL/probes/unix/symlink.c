@@ -42,6 +42,7 @@
 
 #include <probe/probe.h>
 #include <probe/option.h>
+#include <probe/fcache.h>
 
 static int collect_symlink(SEXP_t *ent, probe_ctx *ctx)
 {
@@ -57,7 +58,7 @@ static int collect_symlink(SEXP_t *ent, probe_ctx *ctx)
 		return PROBE_EINVAL;
 	}
 
-	if (lstat(pathname, &sb) == -1) {
+	if (probe_fcache_lstat(pathname, &sb) == -1) {
 		if (errno == ENOENT) {
 			/* File does not exist.
 			 * Resulting item should have a status of "does not exist". */
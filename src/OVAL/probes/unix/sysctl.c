@@ -40,220 +40,461 @@
 #include <ctype.h>
 #include <errno.h>
 #include <limits.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/stat.h>
 #include "oval_fts.h"
 #include "common/debug_priv.h"
 #include "common/assume.h"
 
 #define PROC_SYS_DIR "/proc/sys"
 #define PROC_SYS_MAXDEPTH 7
+#define SYSCTL_MAXFILES 16 /* max. number of files found for one name */
 
-int probe_main(probe_ctx *ctx, void *probe_arg)
+static const char *ipv6_conf_path = "/proc/sys/net/ipv6/conf/";
+
+/*
+ * Index of /proc/sys
+ *
+ * Names of the sysctls and paths of their files are collected by one
+ * walk of /proc/sys when an object needs other operation than "equals".
+ * Values are read when an object matches them for the first time. The
+ * index is dropped on the probe reset.
+ */
+#define SYSCTL_VALUE_UNKNOWN 0
+#define SYSCTL_VALUE_OK      1
+#define SYSCTL_VALUE_SKIP    2
+#define SYSCTL_VALUE_ERROR   3
+
+struct sysctl_entry {
+	char *mib;
+	char *path;
+	int   status;
+	char *value;
+	long  len;
+};
+
+static struct {
+	pthread_mutex_t lock;
+	bool built;
+	struct sysctl_entry *entries;
+	size_t count;
+} sysctl_index = {
+	.lock = PTHREAD_MUTEX_INITIALIZER
+};
+
+/*
+ * Check whether the file can be collected, the sysctl utility
+ * uses the same condition in sysctl.c in ReadSetting()
+ */
+static bool sysctl_readable(const char *mibpath)
 {
-        OVAL_FTS    *ofts;
-        OVAL_FTSENT *ofts_ent;
+	struct stat file_stat;
+
+	/* Skip write-only files, eg. /proc/sys/net/ipv4/route/flush */
+	if (stat(mibpath, &file_stat) == -1) {
+		dE("Stat failed on %s: %u, %s", mibpath, errno, strerror(errno));
+		return false;
+	}
+	if ((file_stat.st_mode & S_IRUSR) == 0) {
+		dI("Skipping write-only file %s", mibpath);
+		return false;
+	}
+
+	return true;
+}
 
-        SEXP_t *name_entity, *probe_in;
-        SEXP_t *r0, *r1, *r2, *r3;
-        SEXP_t *ent_attrs, *bh_entity, *path_entity, *filename_entity;
-        oval_schema_version_t over;
-        int over_cmp;
+/*
+ * Read the value of a sysctl. Returns one of the SYSCTL_VALUE_*
+ * constants, the value is stored in sysval.
+ */
+static int sysctl_read(const char *mibpath, char *sysval, size_t size, long *len)
+{
+	FILE *fp;
+	const char *file;
+	long l;
+
+	fp = fopen(mibpath, "r");
+
+	if (fp == NULL) {
+		dE("Can't read sysctl value from \"%s\": %u, %s",
+		   mibpath, errno, strerror(errno));
+		return (SYSCTL_VALUE_ERROR);
+	}
+
+	l = fread(sysval, 1, size - 1, fp);
+
+	if (ferror(fp)) {
+		/* Linux 4.1.0 introduced a per-NIC IPv6 stable_secret file.
+		 * The stable_secret file cannot be read until it is set,
+		 * so we skip it when it is not readable. Otherwise we collect it.
+		 */
+		file = strrchr(mibpath, '/') + 1;
+		if (strncmp(mibpath, ipv6_conf_path, strlen(ipv6_conf_path)) == 0 &&
+				strcmp(file, "stable_secret") == 0) {
+			dI("Skipping file %s", mibpath);
+			fclose(fp);
+			return (SYSCTL_VALUE_SKIP);
+		} else {
+			dE("An error ocured when reading from \"%s\" (fp=%p): l=%ld, %u, %s",
+				mibpath, fp, l, errno, strerror(errno));
+			fclose(fp);
+			return (SYSCTL_VALUE_ERROR);
+		}
+	}
 
-	const char *ipv6_conf_path = "/proc/sys/net/ipv6/conf/";
-	size_t ipv6_conf_path_len = strlen(ipv6_conf_path);
+	fclose(fp);
 
-        probe_in    = probe_ctx_getobject(ctx);
-        name_entity = probe_obj_getent(probe_in, "name", 1);
-        over        = probe_obj_get_platform_schema_version(probe_in);
-        over_cmp    = oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.10));
+	/* Skip empty values as sysctl tool does.
+	 * See https://bugzilla.redhat.com/show_bug.cgi?id=1473207
+	 */
+	if (l == 0) {
+		dI("Skipping file '%s' because it has no value.", mibpath);
+		return (SYSCTL_VALUE_SKIP);
+	}
 
-        if (name_entity == NULL) {
-                dE("Missing \"name\" entity in the input object");
-                return (PROBE_ENOENT);
-        }
+	*len = l;
+	return (SYSCTL_VALUE_OK);
+}
 
-        /*
-         * prepare behaviors
-         */
-        ent_attrs = probe_attr_creat("max_depth",           r0 = SEXP_string_newf("%d", PROC_SYS_MAXDEPTH),
-                                     "recurse_direction",   r1 = SEXP_string_new("down", 4),
-                                     "recurse_file_system", r2 = SEXP_string_new("local", 7),
-                                     "recurse", r3 = SEXP_string_new("symlinks and directories", 24),
-                                     NULL);
-        bh_entity = probe_ent_creat1("behaviors", ent_attrs, NULL);
-        SEXP_vfree(r0, r1, r2, r3, ent_attrs, NULL);
+/*
+ * Create an item from a value read by sysctl_read(). The value
+ * is modified.
+ */
+static SEXP_t *sysctl_item(SEXP_t *se_mib, char *sysval, long l, int over_cmp)
+{
+	char   *sysvals[512];
+	long    i;
+	size_t  s;
+
+	/*
+	 * sanitize the value
+	 *  - only printable and whitespace chars allowed
+	 *  - remove the last '\n'
+	 */
+	sysvals[0] = sysval;
+
+	for(s = 0, i = 0; i < l && s < sizeof sysvals/sizeof(char *) - 1; ++i) {
+		if ((!isprint(sysval[i]) && !isspace(sysval[i]))
+		    || (over_cmp >= 0 && sysval[i] == '\n' /* OVAL 5.10 and above */))
+		{
+			sysval[i] = '\0';
+			sysvals[++s] = sysval + i + 1;
+		}
+	}
+
+	if (sysval[l - 1] == '\n')
+		sysval[l - 1] = '\0';
+	else
+		sysval[l] = '\0';
+
+	if (strlen(sysvals[s]) == 0)
+		sysvals[s] = NULL;
+	else
+		sysvals[++s] = NULL;
+
+	if (over_cmp >= 0) {
+		/* Only in OVAL 5.10 and above */
+		return probe_item_create(OVAL_UNIX_SYSCTL, NULL,
+					 "name",  OVAL_DATATYPE_SEXP,   se_mib,
+					 "value", OVAL_DATATYPE_STRING_M, sysvals,
+					 NULL);
+	} else {
+		return probe_item_create(OVAL_UNIX_SYSCTL, NULL,
+					 "name",  OVAL_DATATYPE_SEXP,   se_mib,
+					 "value", OVAL_DATATYPE_STRING, sysval,
+					 NULL);
+	}
+}
 
-        /*
-         * prepare path, filename
-         */
-        ent_attrs = probe_attr_creat("operation", r0 = SEXP_number_newi(OVAL_OPERATION_EQUALS),
-                                     NULL);
-        path_entity = probe_ent_creat1("path", ent_attrs, r1 = SEXP_string_new(PROC_SYS_DIR, strlen(PROC_SYS_DIR)));
-        SEXP_vfree(r0, r1, NULL);
+static SEXP_t *sysctl_error_item(void)
+{
+	SEXP_t *item;
 
-        ent_attrs = probe_attr_creat("operation", r0 = SEXP_number_newi(OVAL_OPERATION_PATTERN_MATCH),
-                                     NULL);
-        filename_entity = probe_ent_creat1("filename", ent_attrs, r1 = SEXP_string_new(".*", 2));
-        SEXP_vfree(r0, r1, ent_attrs, NULL);
+	item = probe_item_creat("sysctl_item", NULL, NULL);
+	probe_item_setstatus(item, SYSCHAR_STATUS_ERROR);
 
-        /*
-         * collect sysctls
-         *  XXX: use direct access for the "equals" op
-         */
-        ofts = oval_fts_open(path_entity, filename_entity, NULL, bh_entity, probe_ctx_getresult(ctx));
+	return (item);
+}
 
-        if (ofts == NULL) {
-                dE("oval_fts_open(%s, %s) failed", PROC_SYS_DIR, ".\\+");
-                SEXP_vfree(path_entity, filename_entity, bh_entity, name_entity, NULL);
+/*
+ * Find the files of a sysctl name. The dots in the name are either
+ * directory separators or a part of a file name (e.g. of a VLAN
+ * interface), all the existing combinations are tried.
+ */
+static size_t sysctl_resolve(char *path, size_t plen, const char *name, int depth, char *found[], size_t n)
+{
+	const char *dot = name;
+	struct stat st;
+	size_t len;
+
+	for (;;) {
+		dot = strchr(dot, '.');
+		len = dot != NULL ? (size_t)(dot - name) : strlen(name);
+
+		if (plen + 1 + len >= PATH_MAX)
+			break;
+
+		/* Don't leave /proc/sys through the "." and ".." entries */
+		if (len > 0 && !(name[0] == '.' && (len == 1 || (len == 2 && name[1] == '.')))) {
+			path[plen] = '/';
+			memcpy(path + plen + 1, name, len);
+			path[plen + 1 + len] = '\0';
+
+			if (stat(path, &st) == 0) {
+				if (dot == NULL) {
+					if (!S_ISDIR(st.st_mode) && n < SYSCTL_MAXFILES)
+						found[n++] = strdup(path);
+				} else if (S_ISDIR(st.st_mode) && depth < PROC_SYS_MAXDEPTH) {
+					n = sysctl_resolve(path, plen + 1 + len, dot + 1, depth + 1, found, n);
+				}
+			}
+		}
 
-                return (PROBE_EFATAL);
-        }
+		if (dot == NULL)
+			break;
+		++dot;
+	}
 
-        while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
-                SEXP_t *se_mib;
-                char    mibpath[PATH_MAX], *mib;
-                size_t  miblen;
-		struct stat file_stat;
+	path[plen] = '\0';
+	return (n);
+}
 
-                snprintf(mibpath, sizeof mibpath, "%s/%s", ofts_ent->path, ofts_ent->file);
+static void sysctl_collect_equals(probe_ctx *ctx, const char *name, int over_cmp)
+{
+	char path[PATH_MAX], *found[SYSCTL_MAXFILES], sysval[8192];
+	size_t i, n;
+	long l;
+	SEXP_t *se_mib, *item;
+
+	if (strchr(name, '/') != NULL)
+		return;
+
+	strcpy(path, PROC_SYS_DIR);
+	n = sysctl_resolve(path, strlen(path), name, 0, found, 0);
+
+	for (i = 0; i < n; ++i) {
+		dI("MIB: %s", name);
+		if (sysctl_readable(found[i])) {
+			switch (sysctl_read(found[i], sysval, sizeof sysval, &l)) {
+			case SYSCTL_VALUE_OK:
+				se_mib = SEXP_string_new(name, strlen(name));
+				item = sysctl_item(se_mib, sysval, l, over_cmp);
+				SEXP_free(se_mib);
+				probe_item_collect(ctx, item);
+				break;
+			case SYSCTL_VALUE_ERROR:
+				probe_item_collect(ctx, sysctl_error_item());
+				break;
+			}
+		}
+		free(found[i]);
+	}
+}
 
-		/* Skip write-only files, eg. /proc/sys/net/ipv4/route/flush */
-		if (stat(mibpath, &file_stat) == -1) {
-			dE("Stat failed on %s: %u, %s", mibpath, errno, strerror(errno));
-			oval_ftsent_free(ofts_ent);
+/* Has to be called with the index lock held */
+static int sysctl_index_build(probe_ctx *ctx)
+{
+	OVAL_FTS    *ofts;
+	OVAL_FTSENT *ofts_ent;
+	SEXP_t *r0, *r1, *r2, *r3;
+	SEXP_t *ent_attrs, *bh_entity, *path_entity, *filename_entity;
+	size_t size = 0;
+
+	/*
+	 * prepare behaviors
+	 */
+	ent_attrs = probe_attr_creat("max_depth",           r0 = SEXP_string_newf("%d", PROC_SYS_MAXDEPTH),
+				     "recurse_direction",   r1 = SEXP_string_new("down", 4),
+				     "recurse_file_system", r2 = SEXP_string_new("local", 7),
+				     "recurse", r3 = SEXP_string_new("symlinks and directories", 24),
+				     NULL);
+	bh_entity = probe_ent_creat1("behaviors", ent_attrs, NULL);
+	SEXP_vfree(r0, r1, r2, r3, ent_attrs, NULL);
+
+	/*
+	 * prepare path, filename
+	 */
+	ent_attrs = probe_attr_creat("operation", r0 = SEXP_number_newi(OVAL_OPERATION_EQUALS),
+				     NULL);
+	path_entity = probe_ent_creat1("path", ent_attrs, r1 = SEXP_string_new(PROC_SYS_DIR, strlen(PROC_SYS_DIR)));
+	SEXP_vfree(r0, r1, NULL);
+
+	ent_attrs = probe_attr_creat("operation", r0 = SEXP_number_newi(OVAL_OPERATION_PATTERN_MATCH),
+				     NULL);
+	filename_entity = probe_ent_creat1("filename", ent_attrs, r1 = SEXP_string_new(".*", 2));
+	SEXP_vfree(r0, r1, ent_attrs, NULL);
+
+	ofts = oval_fts_open(path_entity, filename_entity, NULL, bh_entity, probe_ctx_getresult(ctx));
+
+	if (ofts == NULL) {
+		dE("oval_fts_open(%s, %s) failed", PROC_SYS_DIR, ".\\+");
+		SEXP_vfree(path_entity, filename_entity, bh_entity, NULL);
+
+		return (PROBE_EFATAL);
+	}
+
+	while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
+		struct sysctl_entry *ent;
+		char    mibpath[PATH_MAX], *mib;
+		size_t  miblen;
+
+		snprintf(mibpath, sizeof mibpath, "%s/%s", ofts_ent->path, ofts_ent->file);
+		oval_ftsent_free(ofts_ent);
+
+		if (!sysctl_readable(mibpath))
 			continue;
+
+		mib    = strdup(mibpath + strlen(PROC_SYS_DIR) + 1);
+		miblen = strlen(mib);
+
+		while (miblen > 0) {
+			if(mib[miblen - 1] == '/')
+				mib[miblen - 1] = '.';
+			--miblen;
 		}
-		/* the sysctl utility uses same condition in sysctl.c in ReadSetting() */
-		if ((file_stat.st_mode & S_IRUSR) == 0) {
-			dI("Skipping write-only file %s", mibpath);
-			oval_ftsent_free(ofts_ent);
-			continue;
+
+		if (sysctl_index.count == size) {
+			size = size == 0 ? 1024 : size * 2;
+			sysctl_index.entries = realloc(sysctl_index.entries, size * sizeof(struct sysctl_entry));
 		}
 
-                mib    = strdup(mibpath + strlen(PROC_SYS_DIR) + 1);
-                miblen = strlen(mib);
-
-                while (miblen > 0) {
-                        if(mib[miblen - 1] == '/')
-                                mib[miblen - 1] = '.';
-                        --miblen;
-                }
-
-                dI("MIB: %s", mib);
-                se_mib = SEXP_string_new(mib, strlen(mib));
-                free(mib);
-
-                if (probe_entobj_cmp(name_entity, se_mib) == OVAL_RESULT_TRUE) {
-                        FILE   *fp;
-                        SEXP_t *item;
-                        char    sysval[8192];
-                        char   *sysvals[512];
-                        long i, l;
-                        size_t s;
-
-                        dI("MIB match");
-
-                        /*
-                         * read sysctl value
-                         */
-                        fp = fopen(mibpath, "r");
-
-                        if (fp == NULL) {
-                                dE("Can't read sysctl value from \"%s\": %u, %s",
-                                   mibpath, errno, strerror(errno));
-                                goto fail_item;
-                        }
-
-                        l = fread(sysval, 1, sizeof sysval - 1, fp);
-
-                        if (ferror(fp)) {
-				/* Linux 4.1.0 introduced a per-NIC IPv6 stable_secret file.
-				 * The stable_secret file cannot be read until it is set,
-				 * so we skip it when it is not readable. Otherwise we collect it.
-				 */
-				if (strncmp(ofts_ent->path, ipv6_conf_path, ipv6_conf_path_len) == 0 &&
-						strcmp(ofts_ent->file, "stable_secret") == 0) {
-					dI("Skipping file %s", mibpath);
-					oval_ftsent_free(ofts_ent);
-					SEXP_free(se_mib);
-					fclose(fp);
-					continue;
-				} else {
-					dE("An error ocured when reading from \"%s\" (fp=%p): l=%ld, %u, %s",
-						mibpath, fp, l, errno, strerror(errno));
-					goto fail_item;
-				}
-                        }
+		ent = &sysctl_index.entries[sysctl_index.count++];
+		ent->mib    = mib;
+		ent->path   = strdup(mibpath);
+		ent->status = SYSCTL_VALUE_UNKNOWN;
+		ent->value  = NULL;
+		ent->len    = 0;
+	}
 
-                        fclose(fp);
+	oval_fts_close(ofts);
+	SEXP_vfree(path_entity, filename_entity, bh_entity, NULL);
 
-			/* Skip empty values as sysctl tool does.
-			 * See https://bugzilla.redhat.com/show_bug.cgi?id=1473207
-			 */
-			if (l == 0) {
-				dI("Skipping file '%s' because it has no value.", mibpath);
-				oval_ftsent_free(ofts_ent);
-				SEXP_free(se_mib);
-				continue;
+	dD("Indexed %zu sysctls", sysctl_index.count);
+	sysctl_index.built = true;
+
+	return (0);
+}
+
+static void sysctl_index_free(void)
+{
+	pthread_mutex_lock(&sysctl_index.lock);
+
+	for (size_t i = 0; i < sysctl_index.count; ++i) {
+		free(sysctl_index.entries[i].mib);
+		free(sysctl_index.entries[i].path);
+		free(sysctl_index.entries[i].value);
+	}
+
+	free(sysctl_index.entries);
+	sysctl_index.entries = NULL;
+	sysctl_index.count = 0;
+	sysctl_index.built = false;
+
+	pthread_mutex_unlock(&sysctl_index.lock);
+}
+
+static int sysctl_collect_index(probe_ctx *ctx, SEXP_t *name_entity, int over_cmp)
+{
+	char sysval[8192];
+	int ret = 0;
+
+	pthread_mutex_lock(&sysctl_index.lock);
+
+	if (!sysctl_index.built && (ret = sysctl_index_build(ctx)) != 0) {
+		pthread_mutex_unlock(&sysctl_index.lock);
+		return (ret);
+	}
+
+	for (size_t i = 0; i < sysctl_index.count; ++i) {
+		struct sysctl_entry *ent = &sysctl_index.entries[i];
+		SEXP_t *se_mib, *item;
+
+		dI("MIB: %s", ent->mib);
+		se_mib = SEXP_string_new(ent->mib, strlen(ent->mib));
+
+		if (probe_entobj_cmp(name_entity, se_mib) == OVAL_RESULT_TRUE) {
+			dI("MIB match");
+
+			if (ent->status == SYSCTL_VALUE_UNKNOWN) {
+				ent->status = sysctl_read(ent->path, sysval, sizeof sysval, &ent->len);
+
+				if (ent->status == SYSCTL_VALUE_OK) {
+					ent->value = malloc(ent->len + 1);
+					memcpy(ent->value, sysval, ent->len);
+				}
+			}
+
+			switch (ent->status) {
+			case SYSCTL_VALUE_OK:
+				memcpy(sysval, ent->value, ent->len);
+				item = sysctl_item(se_mib, sysval, ent->len, over_cmp);
+				probe_item_collect(ctx, item);
+				break;
+			case SYSCTL_VALUE_ERROR:
+				probe_item_collect(ctx, sysctl_error_item());
+				break;
 			}
+		}
+
+		SEXP_free(se_mib);
+	}
+
+	pthread_mutex_unlock(&sysctl_index.lock);
+
+	return (0);
+}
+
+void probe_reset(void *arg)
+{
+	sysctl_index_free();
+}
+
+void probe_fini(void *arg)
+{
+	sysctl_index_free();
+}
+
+int probe_main(probe_ctx *ctx, void *probe_arg)
+{
+        SEXP_t *name_entity, *probe_in, *val;
+        oval_schema_version_t over;
+        int over_cmp, ret = 0;
+        char *name = NULL;
+
+        probe_in    = probe_ctx_getobject(ctx);
+        name_entity = probe_obj_getent(probe_in, "name", 1);
+        over        = probe_obj_get_platform_schema_version(probe_in);
+        over_cmp    = oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.10));
+
+        if (name_entity == NULL) {
+                dE("Missing \"name\" entity in the input object");
+                return (PROBE_ENOENT);
+        }
+
+        /*
+         * Sysctls with the name equal to a single value are read
+         * directly, other operations use the index of /proc/sys
+         */
+        if (!probe_ent_attrexists(name_entity, "var_ref") &&
+            probe_ent_getoperation(name_entity, OVAL_OPERATION_EQUALS) == OVAL_OPERATION_EQUALS &&
+            (val = probe_ent_getval(name_entity)) != NULL) {
+                if (SEXP_stringp(val))
+                        name = SEXP_string_cstr(val);
+                SEXP_free(val);
+        }
 
-                        /*
-                         * sanitize the value
-                         *  - only printable and whitespace chars allowed
-                         *  - remove the last '\n'
-                         */
-                        sysvals[0] = sysval;
-
-                        for(s = 0, i = 0; i < l && s < sizeof sysvals/sizeof(char *) - 1; ++i) {
-	                        if ((!isprint(sysval[i]) && !isspace(sysval[i]))
-	                            || (over_cmp >= 0 && sysval[i] == '\n' /* OVAL 5.10 and above */))
-                                {
-                                        sysval[i] = '\0';
-                                        sysvals[++s] = sysval + i + 1;
-                                }
-                        }
-
-                        if (sysval[l - 1] == '\n')
-                                sysval[l - 1] = '\0';
-                        else
-                                sysval[l] = '\0';
-
-                        if (strlen(sysvals[s]) == 0)
-                                sysvals[s] = NULL;
-                        else
-                                sysvals[++s] = NULL;
-
-                        if (over_cmp >= 0) {
-	                        /* Only in OVAL 5.10 and above */
-	                        item = probe_item_create(OVAL_UNIX_SYSCTL, NULL,
-	                                                 "name",  OVAL_DATATYPE_SEXP,   se_mib,
-	                                                 "value", OVAL_DATATYPE_STRING_M, sysvals,
-	                                                 NULL);
-                        } else {
-	                        item = probe_item_create(OVAL_UNIX_SYSCTL, NULL,
-	                                                 "name",  OVAL_DATATYPE_SEXP,   se_mib,
-	                                                 "value", OVAL_DATATYPE_STRING, sysval,
-	                                                 NULL);
-                        }
-
-                        goto add_item;
-                fail_item:
-                        if (fp != NULL)
-                                fclose(fp);
-
-                        item = probe_item_creat("sysctl_item", NULL, NULL);
-                        probe_item_setstatus(item, SYSCHAR_STATUS_ERROR);
-                add_item:
-                        probe_item_collect(ctx, item);
-                }
-
-                oval_ftsent_free(ofts_ent);
-                SEXP_free(se_mib);
+        if (name != NULL) {
+                sysctl_collect_equals(ctx, name, over_cmp);
+                free(name);
+        } else {
+                ret = sysctl_collect_index(ctx, name_entity, over_cmp);
         }
 
-        oval_fts_close(ofts);
-	SEXP_vfree(path_entity, filename_entity, bh_entity, name_entity);
+        SEXP_free(name_entity);
 
-        return (0);
+        return (ret);
 }
 #else
 int probe_main(probe_ctx *ctx, void *probe_arg)
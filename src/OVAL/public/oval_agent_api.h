@@ -118,6 +118,13 @@ OSCAP_API struct oval_results_model * oval_agent_get_results_model(oval_agent_se
  */
 OSCAP_API const char * oval_agent_get_filename(oval_agent_session_t * ag_sess);
 
+/**
+ * Get the number of objects taken over from the previous scan and the number
+ * of objects probed by the agent session. Objects are taken over only when
+ * OSCAP_RESCAN_DIR is set, see the manual.
+ */
+OSCAP_API void oval_agent_get_rescan_stats(oval_agent_session_t *ag_sess, unsigned int *reused, unsigned int *probed);
+
 /**
  * Finish OVAL agent session
  */
@@ -164,7 +164,8 @@ OSCAP_API bool oval_results_model_get_export_system_characteristics(struct oval_
  */
 OSCAP_API void oval_results_model_free(struct oval_results_model *model);
 /**
- * Export oval results into file.
+ * Export oval results into file. The results are written as they are
+ * serialized, the whole document is not kept in memory.
  * @param model the oval_results_model
  * @param model the oval_directives_model
  * @param file filename
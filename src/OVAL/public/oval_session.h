@@ -204,6 +204,18 @@ OSCAP_API int oval_session_evaluate_id(struct oval_session *session, char *probe
  */
 OSCAP_API int oval_session_evaluate(struct oval_session *session, char *probe_root, agent_reporter fn, void *arg);
 
+/**
+ * Get the number of objects taken over from the previous scan and the number
+ * of objects probed by the last evaluation. Objects are taken over only when
+ * OSCAP_RESCAN_DIR is set.
+ *
+ * @memberof oval_session
+ * @param session an \ref oval_session
+ * @param reused the number of objects taken over from the previous scan
+ * @param probed the number of objects probed
+ */
+OSCAP_API void oval_session_get_rescan_stats(struct oval_session *session, unsigned int *reused, unsigned int *probed);
+
 /**
  * Export result to a file. Results can be represented as OVAL System
  * Characteristics if analyse has been done or OVAL Results if evaluation or
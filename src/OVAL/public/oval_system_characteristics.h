@@ -226,7 +226,8 @@ OSCAP_API OSCAP_DEPRECATED(int oval_syschar_model_import(struct oval_syschar_mod
  */
 OSCAP_API struct oval_syschar_model *oval_syschar_model_clone(struct oval_syschar_model *);
 /**
- * Export system characteristics into file.
+ * Export system characteristics into file. The system characteristics are
+ * written as they are serialized, the whole document is not kept in memory.
  * @memberof oval_syschar_model
  */
 OSCAP_API int oval_syschar_model_export(struct oval_syschar_model *, const char *file);
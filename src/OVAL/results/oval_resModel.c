@@ -209,7 +209,10 @@ int oval_results_model_import_source(struct oval_results_model *model, struct os
 	context.user_data = NULL;
 	oscap_setxmlerr(xmlGetLastError());
 	/* jump into document */
-	xmlTextReaderRead(context.reader);
+	if (xmlTextReaderRead(context.reader) != 1) {
+		xmlFreeTextReader(context.reader);
+		return -1;
+	}
 	/* make sure these are results */
 	tagname = (char *)xmlTextReaderLocalName(context.reader);
 	namespace = (char *)xmlTextReaderNamespaceUri(context.reader);
@@ -222,6 +225,9 @@ int oval_results_model_import_source(struct oval_results_model *model, struct os
 		ret = -1;
 	}
 
+	if (oscap_source_xmlTextReader_failed(context.reader))
+		ret = -1;
+
         free(tagname);
         free(namespace);
 	xmlFreeTextReader(context.reader);
@@ -264,7 +270,8 @@ int oval_results_model_eval(struct oval_results_model *res_model)
 
 static xmlNode *oval_results_to_dom(struct oval_results_model *results_model,
 				    struct oval_directives_model *directives_model, 
-				    xmlDocPtr doc, xmlNode * parent)
+				    xmlDocPtr doc, xmlNode * parent,
+				    struct oscap_xml_stream *stream)
 {
 	xmlNode *root_node;
 	struct oval_result_directives * dirs;
@@ -283,6 +290,7 @@ static xmlNode *oval_results_to_dom(struct oval_results_model *results_model,
 
 	xmlSetNs(root_node, ns_common);
 	xmlSetNs(root_node, ns_results);
+	oscap_xml_stream_push(stream, root_node);
 
 	/* Report generator */
 	oval_generator_to_dom(results_model->generator, doc, root_node);
@@ -301,12 +309,15 @@ static xmlNode *oval_results_to_dom(struct oval_results_model *results_model,
 	}
 
 	xmlNode *results_node = xmlNewTextChild(root_node, ns_results, BAD_CAST "results", NULL);
+	oscap_xml_stream_push(stream, results_node);
 	struct oval_result_system_iterator *systems = oval_results_model_get_systems(results_model);
 	while (oval_result_system_iterator_has_more(systems)) {
 		struct oval_result_system *sys = oval_result_system_iterator_next(systems);
-		oval_result_system_to_dom(sys, results_model, dirs_model, doc, results_node);
+		oval_result_system_to_dom(sys, results_model, dirs_model, doc, results_node, stream);
 	}
 	oval_result_system_iterator_free(systems);
+	oscap_xml_stream_pop(stream);
+	oscap_xml_stream_pop(stream);
 
 	return root_node;
 }
@@ -321,7 +332,7 @@ struct oscap_source *oval_results_model_export_source(struct oval_results_model
 		return NULL;
 	}
 
-	oval_results_to_dom(results_model, directives_model, doc, NULL);
+	oval_results_to_dom(results_model, directives_model, doc, NULL, NULL);
 	return oscap_source_new_from_xmlDoc(doc, name);
 }
 
@@ -329,12 +340,24 @@ int oval_results_model_export(struct oval_results_model *results_model,
 			      struct oval_directives_model *directives_model,
 			      const char *file)
 {
-	struct oscap_source *source = oval_results_model_export_source(results_model, directives_model, file);
-	if (source == NULL) {
+	__attribute__nonnull__(results_model);
+
+	xmlDocPtr doc = xmlNewDoc(BAD_CAST "1.0");
+	if (doc == NULL) {
+		oscap_setxmlerr(xmlGetLastError());
 		return -1;
 	}
-	int ret = oscap_source_save_as(source, NULL);
-	oscap_source_free(source);
+
+	/* Write the results as they are serialized, the whole DOM would be
+	 * much bigger than the results model. */
+	struct oscap_xml_stream *stream = oscap_xml_stream_new(file, doc);
+	if (stream == NULL) {
+		xmlFreeDoc(doc);
+		return -1;
+	}
+	oval_results_to_dom(results_model, directives_model, doc, NULL, stream);
+	int ret = oscap_xml_stream_close(stream) == 1 ? 0 : -1;
+	xmlFreeDoc(doc);
 	return ret;
 }
 
@@ -53,6 +53,7 @@
 #include <limits.h>
 #include <unistd.h>
 #include <libgen.h>
+#include <pthread.h>
 
 struct sce_check_result
 {
@@ -207,12 +208,14 @@ void sce_check_result_export(struct sce_check_result* v, const char* target_file
 struct sce_session
 {
 	struct oscap_list* results;
+	pthread_mutex_t lock; // rules of different scripts may be evaluated in parallel
 };
 
 struct sce_session* sce_session_new(void)
 {
 	struct sce_session* ret = malloc(sizeof(struct sce_session));
 	ret->results = oscap_list_new();
+	pthread_mutex_init(&ret->lock, NULL);
 
 	return ret;
 }
@@ -223,18 +226,23 @@ void sce_session_free(struct sce_session* s)
 		return;
 
 	oscap_list_free(s->results, (oscap_destruct_func) sce_check_result_free);
+	pthread_mutex_destroy(&s->lock);
 	free(s);
 }
 
 void sce_session_reset(struct sce_session* s)
 {
+	pthread_mutex_lock(&s->lock);
 	oscap_list_free(s->results, (oscap_destruct_func) sce_check_result_free);
 	s->results = oscap_list_new();
+	pthread_mutex_unlock(&s->lock);
 }
 
 void sce_session_add_check_result(struct sce_session* s, struct sce_check_result* result)
 {
+	pthread_mutex_lock(&s->lock);
 	oscap_list_push(s->results, result);
+	pthread_mutex_unlock(&s->lock);
 }
 
 OSCAP_ITERATOR_GEN(sce_check_result)
@@ -482,10 +490,11 @@ xccdf_test_result_type_t sce_engine_eval_rule(struct xccdf_policy *policy, const
 	env_values = realloc(env_values, (env_value_count + 1) * sizeof(char*));
 	env_values[env_value_count] = NULL;
 
-	// We open a pipe for communication with the forked process
+	// We open a pipe for communication with the forked process, the pipes
+	// must not leak to processes forked by other threads evaluating rules
 	int stdout_pipefd[2];
 	int stderr_pipefd[2];
-	if (pipe(stdout_pipefd) == -1 || pipe(stderr_pipefd) == -1)
+	if (pipe2(stdout_pipefd, O_CLOEXEC) == -1 || pipe2(stderr_pipefd, O_CLOEXEC) == -1)
 	{
 		perror("pipe");
 		// the first 9 values (0 to 8) are compiled in
@@ -66,7 +66,8 @@ struct xccdf_benchmark *xccdf_benchmark_import_source(struct oscap_source *sourc
 
 	while (xmlTextReaderRead(reader) == 1 && xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT) ;
 	struct xccdf_benchmark *benchmark = xccdf_benchmark_new();
-	const bool parse_result = xccdf_benchmark_parse(XITEM(benchmark), reader);
+	const bool parse_result = xccdf_benchmark_parse(XITEM(benchmark), reader)
+		&& !oscap_source_xmlTextReader_failed(reader);
 	xmlFreeTextReader(reader);
 
 	if (!parse_result) { // parsing fatal error
@@ -544,6 +544,17 @@ OSCAP_API unsigned int xccdf_session_get_oval_agents_count(const struct xccdf_se
  */
 OSCAP_API unsigned int xccdf_session_get_cpe_oval_agents_count(const struct xccdf_session *session);
 
+/**
+ * Get the number of OVAL objects taken over from the previous scan and the
+ * number of objects probed by the OVAL agent sessions not used for CPE.
+ * Objects are taken over only when OSCAP_RESCAN_DIR is set.
+ * @memberof xccdf_session
+ * @param session XCCDF Session
+ * @param reused the number of objects taken over from the previous scan
+ * @param probed the number of objects probed
+ */
+OSCAP_API void xccdf_session_get_rescan_stats(const struct xccdf_session *session, unsigned int *reused, unsigned int *probed);
+
 /**
  * Query if the result of evaluation contains FAIL, ERROR, or UNKNOWN rule-result elements.
  * @memberof xccdf_session
@@ -651,6 +651,10 @@ struct xccdf_result *xccdf_result_import_source(struct oscap_source *source)
 	while (xmlTextReaderRead(reader) == 1
 			&& xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT);
 	struct xccdf_result *result = xccdf_result_new_parse(reader);
+	if (result != NULL && oscap_source_xmlTextReader_failed(reader)) {
+		xccdf_result_free(result);
+		result = NULL;
+	}
 	xmlFreeTextReader(reader);
 	return result;
 }
@@ -1018,8 +1022,8 @@ static struct xccdf_target_identifier *xccdf_target_identifier_new_parse(xmlText
 		xccdf_target_identifier_set_name(ret, xccdf_attribute_get(reader, XCCDFA_NAME));
 	}
 	else {
-		// this is OK because we clone the node in the setter
-		xccdf_target_identifier_set_xml_node(ret, xmlTextReaderCurrentNode(reader));
+		// the identifier owns the node, the reader frees its nodes as it advances
+		xccdf_target_identifier_set_xml_node(ret, xmlCopyNode(xmlTextReaderExpand(reader), 1));
 	}
 
 	return ret;
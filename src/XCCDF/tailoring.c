@@ -214,6 +214,10 @@ struct xccdf_tailoring *xccdf_tailoring_import_source(struct oscap_source *sourc
 
 	while (xmlTextReaderRead(reader) == 1 && xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT) ;
 	struct xccdf_tailoring *tailoring = xccdf_tailoring_parse(reader, XITEM(benchmark));
+	if (tailoring != NULL && oscap_source_xmlTextReader_failed(reader)) {
+		xccdf_tailoring_free(tailoring);
+		tailoring = NULL;
+	}
 	xmlFreeTextReader(reader);
 	if (!tailoring) { // parsing fatal error
 		oscap_seterr(OSCAP_EFAMILY_XML, "Failed to parse tailoring from '%s'.", oscap_source_readable_origin(source));
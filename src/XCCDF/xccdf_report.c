@@ -0,0 +1,2162 @@
+/*
+ * Copyright 2015 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+
+#include <oscap.h>
+#include "common/_error.h"
+#include "common/debug_priv.h"
+#include "common/list.h"
+#include "common/oscap_string.h"
+#include "common/oscapxml.h"
+#include "common/util.h"
+#include "OVAL/oval_definitions_impl.h"
+#include "OVAL/public/oval_agent_api.h"
+#include "OVAL/public/oval_results.h"
+#include "OVAL/public/oval_system_characteristics.h"
+#include "XCCDF_POLICY/public/xccdf_policy.h"
+#include "source/public/oscap_source.h"
+#include "source/oscap_source_priv.h"
+#include "elements.h"
+#include "helpers.h"
+#include "item.h"
+#include "xccdf_impl.h"
+#include "xccdf_report_priv.h"
+
+#define REPORT_RESOURCES_XSL "xccdf-resources.xsl"
+#define REPORT_BRANDING_XSL "xccdf-branding.xsl"
+
+#define REPORT_OVAL_SYSTEM "http://oval.mitre.org/XMLSchema/oval-definitions-5"
+#define REPORT_SCE_SYSTEM "http://open-scap.org/page/SCE"
+#define REPORT_SCE_RESULT_NS "http://open-scap.org/page/SCE_result_file"
+
+/* number of OVAL items listed for a test */
+#define REPORT_OVAL_ITEMS_MAX 100
+
+/* flags of the text rendering */
+#define REPORT_SUB_RESULT 0x1   /* the set-values of the TestResult take precedence */
+#define REPORT_SUB_FIX    0x2   /* instance elements are replaced by the contexts of the rule-results */
+
+#define RESULT_BIT(r) (1u << (r))
+#define RESULTS_ATTENTION (RESULT_BIT(XCCDF_RESULT_FAIL) | RESULT_BIT(XCCDF_RESULT_ERROR) | RESULT_BIT(XCCDF_RESULT_UNKNOWN))
+
+/* rule-results of a rule */
+struct report_rule {
+	struct xccdf_rule_result *rule_result;  /* the first one */
+	unsigned results;                       /* RESULT_BIT of all of them */
+	bool overridden;
+	unsigned id;                            /* identifies the rule in the document */
+};
+
+struct xccdf_report {
+	struct xccdf_benchmark *benchmark;
+	struct xccdf_result *result;
+	struct xccdf_profile *profile;
+	struct oval_agent_session **agents;
+	const char *sce_template;
+	FILE *out;
+	struct oscap_string *buf;
+	struct oscap_htable *rules;           /* rule id -> struct report_rule */
+	struct oscap_htable *result_values;   /* value id -> set-value of the TestResult */
+	struct oscap_htable *profile_values;  /* value id -> set-value of the profile */
+	struct oscap_htable *profile_selectors; /* value id -> selector of refine-value of the profile */
+	struct oscap_htable *instances;       /* context -> instance of a rule-result */
+	unsigned last_id;
+	xmlDoc *scratch;                      /* OVAL objects and states are exported here */
+};
+
+static const struct {
+	xccdf_test_result_type_t result;
+	const char *tooltip;
+} REPORT_RESULT_TOOLTIPS[] = {
+	/* the texts are sourced from XCCDF 1.2 specification with minor modifications */
+	{ XCCDF_RESULT_PASS, "The target system or system component satisfied all the conditions of the rule." },
+	{ XCCDF_RESULT_FIXED, "The Rule had failed, but was then fixed (possibly by a tool that can automatically apply remediation, or possibly by the human auditor)." },
+	{ XCCDF_RESULT_INFORMATIONAL, "The Rule was checked, but the output from the checking engine is simply information for auditors or administrators; it is not a compliance category. This status value is designed for Rule elements whose main purpose is to extract information from the target rather than test the target." },
+	{ XCCDF_RESULT_FAIL, "The target system or system component did not satisfy at least one condition of the rule." },
+	{ XCCDF_RESULT_ERROR, "The checking engine could not complete the evaluation, therefore the status of the target's compliance with the rule is not certain. This could happen, for example, if a testing tool was run with insufficient privileges and could not gather all of the necessary information." },
+	{ XCCDF_RESULT_UNKNOWN, "The testing tool encountered some problem and the result is unknown. For example, a result of 'unknown' might be given if the testing tool was unable to interpret the output of the checking engine (the output has no meaning to the testing tool)." },
+	{ XCCDF_RESULT_NOT_CHECKED, "The Rule was not evaluated by the checking engine. This status is designed for Rule elements that have no check elements or that correspond to an unsupported checking system. It may also correspond to a status returned by a checking engine if the checking engine does not support the indicated check code." },
+	{ XCCDF_RESULT_NOT_SELECTED, "The Rule was not selected in the evaluation. This may be caused by the rule not being selected by default in the benchmark or by the profile unselecting it." },
+	{ XCCDF_RESULT_NOT_APPLICABLE, "The Rule was not applicable to the target of the test. For example, the Rule might have been specific to a different version of the target OS, or it might have been a test against a platform feature that was not installed." },
+	{ 0, NULL }
+};
+
+static const struct {
+	const char *prefix;
+	const char *name;
+} REPORT_REFERENCE_NAMES[] = {
+	{ "http://nvlpubs.nist.gov/nistpubs/SpecialPublications/NIST.SP.800-53", "NIST SP 800-53" },
+	{ "http://nvlpubs.nist.gov/nistpubs/SpecialPublications/NIST.SP.800-171", "NIST SP 800-171" },
+	{ "http://iase.disa.mil/stigs/cci/", "DISA CCI" },
+	{ "http://iase.disa.mil/stigs/srgs/", "DISA SRG" },
+	{ "http://iase.disa.mil/stigs/os/general/Pages/index.aspx", "DISA SRG" },
+	{ "http://iase.disa.mil/stigs/app-security/app-servers/Pages/general.aspx", "DISA SRG" },
+	/* STIG weblinks can be subject to change, keep the old ones for compatibility */
+	{ "http://iase.disa.mil/stigs/os/", "DISA STIG" },
+	{ "http://iase.disa.mil/stigs/app-security/", "DISA STIG" },
+	{ "https://www.pcisecuritystandards.org/", "PCI-DSS Requirement" },
+	{ "https://benchmarks.cisecurity.org/", "CIS Recommendation" },
+	{ "https://www.fbi.gov/file-repository/cjis-security-policy", "FBI CJIS" },
+	{ NULL, NULL }
+};
+
+#define REPORT_CONTRIBUTORS_HREF "https://github.com/OpenSCAP/scap-security-guide/wiki/Contributors"
+
+static const struct {
+	const char *system;
+	const char *type;
+} REPORT_FIX_TYPES[] = {
+	{ "urn:xccdf:fix:script:sh", "Shell script" },
+	{ "urn:xccdf:fix:script:ansible", "Ansible snippet" },
+	{ "urn:xccdf:fix:script:puppet", "Puppet snippet" },
+	{ "urn:redhat:anaconda:pre", "Anaconda snippet" },
+	{ NULL, NULL }
+};
+
+static const char *REPORT_IDENTS_TITLE = "A globally meaningful identifiers for this rule. MAY be the name or identifier of a security configuration issue or vulnerability that the rule remediates. By setting an identifier on a rule, the benchmark author effectively declares that the rule instantiates, implements, or remediates the issue for which the name was assigned.";
+static const char *REPORT_REFERENCES_TITLE = "Provide a reference to a document or resource where the user can learn more about the subject of the Rule or Group.";
+
+static const char *REPORT_RULE_OVERVIEW_FORM =
+	"<div class=\"form-group js-only hidden-print\"><div class=\"row\"><div title=\"Filter rules by their XCCDF result\">"
+	"<div class=\"col-sm-2 toggle-rule-display-success\">"
+	"<div class=\"checkbox\"><label><input class=\"toggle-rule-display\" type=\"checkbox\" onclick=\"toggleRuleDisplay(this)\" checked=\"checked\" value=\"pass\">pass</label></div>"
+	"<div class=\"checkbox\"><label><input class=\"toggle-rule-display\" type=\"checkbox\" onclick=\"toggleRuleDisplay(this)\" checked=\"checked\" value=\"fixed\">fixed</label></div>"
+	"<div class=\"checkbox\"><label><input class=\"toggle-rule-display\" type=\"checkbox\" onclick=\"toggleRuleDisplay(this)\" checked=\"checked\" value=\"informational\">informational</label></div>"
+	"</div>"
+	"<div class=\"col-sm-2 toggle-rule-display-danger\">"
+	"<div class=\"checkbox\"><label><input class=\"toggle-rule-display\" type=\"checkbox\" onclick=\"toggleRuleDisplay(this)\" checked=\"checked\" value=\"fail\">fail</label></div>"
+	"<div class=\"checkbox\"><label><input class=\"toggle-rule-display\" type=\"checkbox\" onclick=\"toggleRuleDisplay(this)\" checked=\"checked\" value=\"error\">error</label></div>"
+	"<div class=\"checkbox\"><label><input class=\"toggle-rule-display\" type=\"checkbox\" onclick=\"toggleRuleDisplay(this)\" checked=\"checked\" value=\"unknown\">unknown</label></div>"
+	"</div>"
+	"<div class=\"col-sm-2 toggle-rule-display-other\">"
+	"<div class=\"checkbox\"><label><input class=\"toggle-rule-display\" type=\"checkbox\" onclick=\"toggleRuleDisplay(this)\" checked=\"checked\" value=\"notchecked\">notchecked</label></div>"
+	"<div class=\"checkbox\"><label><input class=\"toggle-rule-display\" type=\"checkbox\" onclick=\"toggleRuleDisplay(this)\" checked=\"checked\" value=\"notapplicable\">notapplicable</label></div>"
+	"</div></div>"
+	"<div class=\"col-sm-6\"><div class=\"input-group\">"
+	"<input type=\"text\" class=\"form-control\" placeholder=\"Search through XCCDF rules\" id=\"search-input\" oninput=\"ruleSearch()\">"
+	"<div class=\"input-group-btn\"><button class=\"btn btn-default\" onclick=\"ruleSearch()\">Search</button></div>"
+	"</div><p id=\"search-matches\"></p>Group rules by: "
+	"<select name=\"groupby\" onchange=\"groupRulesBy(value)\">"
+	"<option value=\"default\" selected=\"selected\">Default</option>"
+	"<option value=\"severity\">Severity</option>"
+	"<option value=\"result\">Result</option>"
+	"<option disabled=\"disabled\">\xe2\x94\x80\xe2\x94\x80\xe2\x94\x80\xe2\x94\x80\xe2\x94\x80\xe2\x94\x80\xe2\x94\x80\xe2\x94\x80\xe2\x94\x80\xe2\x94\x80</option>";
+
+bool xccdf_report_xslt_enabled(void)
+{
+	const char *env = getenv(XCCDF_REPORT_XSLT_ENV);
+
+	return env != NULL && *env != '\0' && strcmp(env, "0") != 0;
+}
+
+/* --------- output -------- */
+
+static inline void _out(struct xccdf_report *report, const char *str)
+{
+	oscap_string_append_string(report->buf, str);
+}
+
+static void _outf(struct xccdf_report *report, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void _outf(struct xccdf_report *report, const char *fmt, ...)
+{
+	va_list ap;
+	va_start(ap, fmt);
+	char *str = oscap_vsprintf(fmt, ap);
+	va_end(ap);
+	oscap_string_append_string(report->buf, str);
+	free(str);
+}
+
+static void _escape(struct oscap_string *out, const char *str, bool attribute)
+{
+	if (str == NULL)
+		return;
+	for (; *str != '\0'; ++str) {
+		switch (*str) {
+		case '&':
+			oscap_string_append_string(out, "&amp;");
+			break;
+		case '<':
+			oscap_string_append_string(out, "&lt;");
+			break;
+		case '>':
+			oscap_string_append_string(out, "&gt;");
+			break;
+		case '"':
+			if (attribute) {
+				oscap_string_append_string(out, "&quot;");
+				break;
+			}
+			/* fallthrough */
+		default:
+			oscap_string_append_char(out, *str);
+		}
+	}
+}
+
+static inline void _text(struct xccdf_report *report, const char *str)
+{
+	_escape(report->buf, str, false);
+}
+
+static inline void _attr(struct xccdf_report *report, const char *str)
+{
+	_escape(report->buf, str, true);
+}
+
+/* Write the buffered part of the report to the output file. */
+static int _flush(struct xccdf_report *report)
+{
+	const char *str = oscap_string_get_cstr(report->buf);
+	size_t len = strlen(str);
+	if (len > 0 && fwrite(str, 1, len, report->out) != len) {
+		oscap_seterr(OSCAP_EFAMILY_GLIBC, "Could not write the HTML report: %s", strerror(errno));
+		oscap_string_clear(report->buf);
+		return -1;
+	}
+	oscap_string_clear(report->buf);
+	return 0;
+}
+
+/* Format a number the way XPath does, the widths of progress bars are computed by the stylesheet. */
+static void _number(struct xccdf_report *report, double number)
+{
+	if (isnan(number)) {
+		_out(report, "NaN");
+	} else if (isinf(number)) {
+		_out(report, number > 0 ? "Infinity" : "-Infinity");
+	} else if (number == (long long) number) {
+		_outf(report, "%lld", (long long) number);
+	} else {
+		char buf[64];
+		int integer_digits = fabs(number) >= 1 ? 1 + (int) log10(fabs(number)) : 1;
+		int fraction_digits = 15 - integer_digits;
+		snprintf(buf, sizeof(buf), "%.*f", fraction_digits > 1 ? fraction_digits : 1, number);
+		char *end = buf + strlen(buf) - 1;
+		while (*end == '0')
+			*end-- = '\0';
+		if (*end == '.')
+			*end = '\0';
+		_out(report, buf);
+	}
+}
+
+static bool _is_blank(const char *str)
+{
+	if (str == NULL)
+		return true;
+	for (; *str != '\0'; ++str) {
+		if (!isspace((unsigned char) *str))
+			return false;
+	}
+	return true;
+}
+
+static const char *_result_text(xccdf_test_result_type_t result)
+{
+	const char *text = oscap_enum_to_string(XCCDF_RESULT_MAP, result);
+	return text != NULL ? text : "";
+}
+
+static const char *_result_tooltip(xccdf_test_result_type_t result)
+{
+	for (int i = 0; REPORT_RESULT_TOOLTIPS[i].tooltip != NULL; ++i) {
+		if (REPORT_RESULT_TOOLTIPS[i].result == result)
+			return REPORT_RESULT_TOOLTIPS[i].tooltip;
+	}
+	return "";
+}
+
+static const char *_reference_name(const char *href)
+{
+	for (int i = 0; REPORT_REFERENCE_NAMES[i].prefix != NULL; ++i) {
+		if (oscap_str_startswith(href, REPORT_REFERENCE_NAMES[i].prefix))
+			return REPORT_REFERENCE_NAMES[i].name;
+	}
+	return href;
+}
+
+static const char *_item_id(struct xccdf_item *item)
+{
+	const char *id = xccdf_item_get_id(item);
+	return id != NULL ? id : "";
+}
+
+/* --------- texts -------- */
+
+static void _render_nodes(struct xccdf_report *report, struct oscap_string *out, xmlNode *node, int flags);
+
+static void _render_sub(struct xccdf_report *report, struct oscap_string *out, const char *subid, int flags)
+{
+	if (subid == NULL)
+		subid = "";
+
+	const char *value = NULL;
+	if ((flags & REPORT_SUB_RESULT) && (value = oscap_htable_get(report->result_values, subid)) != NULL) {
+		oscap_string_append_string(out, "<abbr title=\"from TestResult: ");
+		_escape(out, subid, true);
+		oscap_string_append_string(out, "\">");
+		_escape(out, value, false);
+		oscap_string_append_string(out, "</abbr>");
+		return;
+	}
+	if ((value = oscap_htable_get(report->profile_values, subid)) != NULL) {
+		oscap_string_append_string(out, "<abbr title=\"from Profile/set-value: ");
+		_escape(out, subid, true);
+		oscap_string_append_string(out, "\">");
+		_escape(out, value, false);
+		oscap_string_append_string(out, "</abbr>");
+		return;
+	}
+
+	struct xccdf_item *item = xccdf_benchmark_get_member(report->benchmark, XCCDF_VALUE, subid);
+	struct xccdf_value *xvalue = xccdf_item_to_value(item);
+	const char *selector = oscap_htable_get(report->profile_selectors, subid);
+	if (selector != NULL) {
+		value = NULL;
+		if (xvalue != NULL) {
+			OSCAP_FOR(xccdf_value_instance, inst, xccdf_value_get_instances(xvalue)) {
+				if (inst->flags.value_given && *selector != '\0' && oscap_streq(inst->selector, selector))
+					value = inst->value;
+			}
+		}
+		oscap_string_append_string(out, "<abbr title=\"from Profile/refine-value: ");
+		_escape(out, subid, true);
+		oscap_string_append_string(out, "\">");
+		_escape(out, value, false);
+		oscap_string_append_string(out, "</abbr>");
+		return;
+	}
+
+	bool found = false;
+	if (xvalue != NULL) {
+		OSCAP_FOR(xccdf_value_instance, inst, xccdf_value_get_instances(xvalue)) {
+			if (inst->flags.value_given && (inst->selector == NULL || *inst->selector == '\0')) {
+				value = inst->value;
+				found = true;
+			}
+		}
+	}
+	if (found && xccdf_value_get_prohibit_changes(xvalue)) {
+		_escape(out, value, false);
+	} else if (found) {
+		oscap_string_append_string(out, "<abbr title=\"from Benchmark/Value: ");
+		_escape(out, subid, true);
+		oscap_string_append_string(out, "\">");
+		_escape(out, value, false);
+		oscap_string_append_string(out, "</abbr>");
+	} else if (item == NULL && (value = xccdf_benchmark_get_plain_text(report->benchmark, subid)) != NULL) {
+		_escape(out, value, false);
+	} else {
+		oscap_string_append_string(out, "<abbr title=\"Substitution failed: ");
+		_escape(out, subid, true);
+		oscap_string_append_string(out, "\">(N/A)</abbr>");
+	}
+}
+
+static void _render_instance(struct xccdf_report *report, struct oscap_string *out, const char *context)
+{
+	if (context == NULL)
+		context = "";
+	const char *content = oscap_htable_get(report->instances, context);
+	if (content != NULL) {
+		oscap_string_append_string(out, "<abbr title=\"context: ");
+		_escape(out, context, true);
+		oscap_string_append_string(out, "\">");
+		_escape(out, content, false);
+		oscap_string_append_string(out, "</abbr>");
+	} else {
+		oscap_string_append_string(out, "<abbr class=\"cdf-sub-context\" title=\"replace with actual ");
+		_escape(out, context, true);
+		oscap_string_append_string(out, " context\">");
+		_escape(out, context, false);
+		oscap_string_append_string(out, "</abbr>");
+	}
+}
+
+static bool _is_xhtml(xmlNode *node)
+{
+	return node->ns != NULL && oscap_streq((const char *) node->ns->href, (const char *) XCCDF_XHTML_NAMESPACE);
+}
+
+static void _render_element(struct xccdf_report *report, struct oscap_string *out, xmlNode *node, int flags)
+{
+	const char *name = (const char *) node->name;
+
+	/* XHTML has a sub element too, but it doesn't refer to a Value */
+	if (oscap_streq(name, "sub") && (!_is_xhtml(node) || xmlHasProp(node, BAD_CAST "idref"))) {
+		xmlChar *idref = xmlGetProp(node, BAD_CAST "idref");
+		_render_sub(report, out, (const char *) idref, flags);
+		xmlFree(idref);
+		return;
+	}
+	if ((flags & REPORT_SUB_FIX) && oscap_streq(name, "instance") && !_is_xhtml(node)) {
+		xmlChar *context = xmlGetProp(node, BAD_CAST "context");
+		_render_instance(report, out, (const char *) context);
+		xmlFree(context);
+		return;
+	}
+	if (oscap_streq(name, "br")) {
+		/* <br></br> shows up as 2 <br> elements in HTML5 */
+		oscap_string_append_string(out, "<br>");
+		return;
+	}
+
+	oscap_string_append_char(out, '<');
+	oscap_string_append_string(out, name);
+	for (xmlAttr *attr = node->properties; attr != NULL; attr = attr->next) {
+		xmlChar *value = xmlNodeGetContent((xmlNode *) attr);
+		oscap_string_append_char(out, ' ');
+		oscap_string_append_string(out, (const char *) attr->name);
+		oscap_string_append_string(out, "=\"");
+		_escape(out, (const char *) value, true);
+		oscap_string_append_char(out, '"');
+		xmlFree(value);
+	}
+	oscap_string_append_char(out, '>');
+	_render_nodes(report, out, node->children, flags);
+	oscap_string_append_string(out, "</");
+	oscap_string_append_string(out, name);
+	oscap_string_append_char(out, '>');
+}
+
+static void _render_nodes(struct xccdf_report *report, struct oscap_string *out, xmlNode *node, int flags)
+{
+	for (; node != NULL; node = node->next) {
+		switch (node->type) {
+		case XML_TEXT_NODE:
+		case XML_CDATA_SECTION_NODE:
+			_escape(out, (const char *) node->content, false);
+			break;
+		case XML_COMMENT_NODE:
+			oscap_string_append_string(out, "<!--");
+			oscap_string_append_string(out, (const char *) node->content);
+			oscap_string_append_string(out, "-->");
+			break;
+		case XML_ELEMENT_NODE:
+			_render_element(report, out, node, flags);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+/* Render the content of an XCCDF text element with the substitutions replaced. */
+static void _render_markup(struct xccdf_report *report, struct oscap_string *out, const char *content, bool markup, int flags)
+{
+	if (content == NULL)
+		return;
+	if (!markup || strpbrk(content, "<&") == NULL) {
+		_escape(out, content, false);
+		return;
+	}
+
+	char *input = oscap_sprintf("<x xmlns='%s'>%s</x>", (const char *) XCCDF_XHTML_NAMESPACE, content);
+	xmlDoc *doc = xmlReadMemory(input, strlen(input), NULL, NULL, XML_PARSE_NOERROR | XML_PARSE_NOWARNING | XML_PARSE_NONET);
+	free(input);
+	if (doc == NULL) {
+		dW("Could not parse the text '%s', it is shown as it is.", content);
+		_escape(out, content, false);
+		return;
+	}
+	_render_nodes(report, out, xmlDocGetRootElement(doc)->children, flags);
+	xmlFreeDoc(doc);
+}
+
+static void _render_text(struct xccdf_report *report, struct oscap_text *text, int flags)
+{
+	if (text == NULL)
+		return;
+	bool markup = oscap_text_get_is_html(text) || oscap_text_get_can_substitute(text);
+	_render_markup(report, report->buf, oscap_text_get_text(text), markup, flags);
+}
+
+/* Render all the texts in the iterator, the iterator is freed. */
+static bool _render_texts(struct xccdf_report *report, struct oscap_text_iterator *texts, int flags)
+{
+	bool any = false;
+	while (oscap_text_iterator_has_more(texts)) {
+		_render_text(report, oscap_text_iterator_next(texts), flags);
+		any = true;
+	}
+	oscap_text_iterator_free(texts);
+	return any;
+}
+
+static struct oscap_text *_first_text(struct oscap_text_iterator *texts)
+{
+	struct oscap_text *text = oscap_text_iterator_has_more(texts) ? oscap_text_iterator_next(texts) : NULL;
+	oscap_text_iterator_free(texts);
+	return text;
+}
+
+static void _render_item_title(struct xccdf_report *report, struct xccdf_item *item)
+{
+	if (!_render_texts(report, xccdf_item_get_title(item), 0)) {
+		_out(report, "ID: ");
+		_text(report, _item_id(item));
+	}
+}
+
+/* --------- resources -------- */
+
+static struct oscap_source *_read_stylesheet(const char *filename)
+{
+	const char *path_to_xslt = oscap_path_to_xslt();
+	char *path = oscap_sprintf("%s/%s", path_to_xslt, filename);
+	struct oscap_source *source = NULL;
+	if (access(path, R_OK)) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "XSLT file '%s' not found in path '%s' when trying to generate the HTML report",
+			filename, path_to_xslt);
+	} else {
+		source = oscap_source_new_from_file(path);
+		if (oscap_source_get_xmlDoc(source) == NULL) {
+			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not parse XSLT file '%s'", path);
+			oscap_source_free(source);
+			source = NULL;
+		}
+	}
+	free(path);
+	return source;
+}
+
+static xmlNode *_stylesheet_template(xmlDoc *doc, const char *name)
+{
+	for (xmlNode *node = xmlDocGetRootElement(doc)->children; node != NULL; node = node->next) {
+		if (node->type != XML_ELEMENT_NODE || !oscap_streq((const char *) node->name, "template"))
+			continue;
+		xmlChar *template_name = xmlGetProp(node, BAD_CAST "name");
+		bool match = oscap_streq((const char *) template_name, name);
+		xmlFree(template_name);
+		if (match)
+			return node;
+	}
+	return NULL;
+}
+
+static int _write_head(struct xccdf_report *report)
+{
+	struct oscap_source *source = _read_stylesheet(REPORT_RESOURCES_XSL);
+	if (source == NULL)
+		return -1;
+	xmlDoc *resources = oscap_source_get_xmlDoc(source);
+
+	_out(report, "<!DOCTYPE html><html lang=\"en\"><head><meta charset=\"utf-8\">"
+		"<meta http-equiv=\"X-UA-Compatible\" content=\"IE=edge\">"
+		"<meta name=\"viewport\" content=\"width=device-width, initial-scale=1\"><title>");
+	_text(report, xccdf_result_get_id(report->result));
+	_out(report, " | OpenSCAP Evaluation Report</title><style>");
+	xmlNode *css = _stylesheet_template(resources, "css-sources");
+	xmlChar *content = css != NULL ? xmlNodeGetContent(css) : NULL;
+	_out(report, (const char *) content);
+	xmlFree(content);
+	_out(report, "</style><script>");
+	xmlNode *js = _stylesheet_template(resources, "js-sources");
+	content = js != NULL ? xmlNodeGetContent(js) : NULL;
+	_out(report, (const char *) content);
+	xmlFree(content);
+	_out(report, "</script></head><body>");
+	oscap_source_free(source);
+	return 0;
+}
+
+static int _write_header(struct xccdf_report *report)
+{
+	struct oscap_source *source = _read_stylesheet(REPORT_BRANDING_XSL);
+	if (source == NULL)
+		return -1;
+	xmlDoc *branding = oscap_source_get_xmlDoc(source);
+
+	_out(report, "<nav class=\"navbar navbar-default\" role=\"navigation\">"
+		"<div class=\"navbar-header\" style=\"float: none\"><a class=\"navbar-brand\" href=\"#\">");
+	xmlNode *logo = _stylesheet_template(branding, "xccdf-branding-logo");
+	if (logo != NULL) {
+		xmlBuffer *buffer = xmlBufferCreate();
+		for (xmlNode *node = logo->children; node != NULL; node = node->next) {
+			if (node->type == XML_ELEMENT_NODE)
+				xmlNodeDump(buffer, branding, node, 0, 0);
+		}
+		_out(report, (const char *) xmlBufferContent(buffer));
+		xmlBufferFree(buffer);
+	}
+	_out(report, "</a><div><h1>OpenSCAP Evaluation Report</h1></div></div></nav>");
+	oscap_source_free(source);
+	return 0;
+}
+
+/* --------- introduction, characteristics and scoring -------- */
+
+static void _write_introduction(struct xccdf_report *report)
+{
+	struct xccdf_item *benchmark = XITEM(report->benchmark);
+
+	_out(report, "<div id=\"introduction\"><div class=\"row\"><h2>");
+	struct oscap_text *title = _first_text(xccdf_item_get_title(benchmark));
+	if (title != NULL)
+		_render_text(report, title, 0);
+	else
+		_text(report, _item_id(benchmark));
+	_out(report, "</h2>");
+
+	if (report->profile != NULL) {
+		struct xccdf_item *profile = XITEM(report->profile);
+		_out(report, "<blockquote>with profile <mark>");
+		title = _first_text(xccdf_item_get_title(profile));
+		if (title != NULL && !oscap_streq(oscap_text_get_text(title), ""))
+			_render_text(report, title, 0);
+		else
+			_text(report, _item_id(profile));
+		_out(report, "</mark>");
+		struct oscap_text *description = _first_text(xccdf_item_get_description(profile));
+		if (description != NULL && !oscap_streq(oscap_text_get_text(description), "")) {
+			_out(report, "<div class=\"col-md-12 well well-lg horizontal-scroll\"><div class=\"description profile-description\"><small>");
+			_render_text(report, description, 0);
+			_out(report, "</small></div></div>");
+		}
+		_out(report, "</blockquote>");
+	}
+
+	_out(report, "<div class=\"col-md-12 well well-lg horizontal-scroll\">");
+	struct oscap_text *front_matter = _first_text(xccdf_benchmark_get_front_matter(report->benchmark));
+	if (front_matter != NULL) {
+		_out(report, "<div class=\"front-matter\">");
+		_render_text(report, front_matter, 0);
+		_out(report, "</div>");
+	}
+	struct oscap_text *description = _first_text(xccdf_item_get_description(benchmark));
+	if (description != NULL && !oscap_streq(oscap_text_get_text(description), "")) {
+		_out(report, "<div class=\"description\">");
+		_render_text(report, description, 0);
+		_out(report, "</div>");
+	}
+	struct xccdf_notice_iterator *notices = xccdf_benchmark_get_notices(report->benchmark);
+	if (xccdf_notice_iterator_has_more(notices)) {
+		_out(report, "<div class=\"top-spacer-10\">");
+		while (xccdf_notice_iterator_has_more(notices)) {
+			_out(report, "<div class=\"alert alert-info\">");
+			_render_text(report, xccdf_notice_get_text(xccdf_notice_iterator_next(notices)), 0);
+			_out(report, "</div>");
+		}
+		_out(report, "</div>");
+	}
+	xccdf_notice_iterator_free(notices);
+	_out(report, "</div></div></div>");
+}
+
+static void _write_addresses(struct xccdf_report *report)
+{
+	struct oscap_htable *seen = oscap_htable_new();
+
+	OSCAP_FOR_STR(address, xccdf_result_get_target_addresses(report->result)) {
+		if (!oscap_htable_add(seen, address, NULL))
+			continue;
+		_out(report, "<li class=\"list-group-item\">");
+		if (strchr(address, ':') != NULL) {
+			char *expanded = oscap_expand_ipv6(address);
+			_out(report, "<span class=\"label label-info\">IPv6</span>&nbsp;");
+			_text(report, expanded != NULL ? expanded : address);
+			free(expanded);
+		} else {
+			if (strchr(address, '.') != NULL)
+				_out(report, "<span class=\"label label-primary\">IPv4</span>");
+			_out(report, "&nbsp;");
+			_text(report, address);
+		}
+		_out(report, "</li>");
+	}
+
+	oscap_htable_free0(seen);
+	seen = oscap_htable_new();
+	OSCAP_FOR(xccdf_target_fact, fact, xccdf_result_get_target_facts(report->result)) {
+		const char *value = xccdf_target_fact_get_value(fact);
+		if (value == NULL || !oscap_htable_add(seen, value, NULL))
+			continue;
+		if (!oscap_streq(xccdf_target_fact_get_name(fact), "urn:xccdf:fact:ethernet:MAC"))
+			continue;
+		_out(report, "<li class=\"list-group-item\"><span class=\"label label-default\">MAC</span>&nbsp;");
+		_text(report, value);
+		_out(report, "</li>");
+	}
+	oscap_htable_free0(seen);
+}
+
+static void _write_characteristics(struct xccdf_report *report)
+{
+	struct xccdf_result *result = report->result;
+
+	_out(report, "<div id=\"characteristics\"><h2>Evaluation Characteristics</h2><div class=\"row\">"
+		"<div class=\"col-md-5 well well-lg horizontal-scroll\"><table class=\"table table-bordered\">"
+		"<tr><th>Evaluation target</th><td>");
+	struct oscap_string_iterator *targets = xccdf_result_get_targets(result);
+	if (oscap_string_iterator_has_more(targets))
+		_text(report, oscap_string_iterator_next(targets));
+	oscap_string_iterator_free(targets);
+	_out(report, "</td></tr>");
+
+	const char *benchmark_uri = xccdf_result_get_benchmark_uri(result);
+	if (benchmark_uri != NULL) {
+		_out(report, "<tr><th>Benchmark URL</th><td>");
+		_text(report, benchmark_uri);
+		_out(report, "</td></tr>");
+		if (xccdf_version_cmp(xccdf_item_get_schema_version(XITEM(report->benchmark)), "1.2") >= 0) {
+			_out(report, "<tr><th>Benchmark ID</th><td>");
+			_text(report, xccdf_benchmark_get_id(report->benchmark));
+			_out(report, "</td></tr>");
+		}
+	}
+	const char *profile_id = xccdf_result_get_profile(result);
+	if (profile_id != NULL) {
+		_out(report, "<tr><th>Profile ID</th><td>");
+		_text(report, profile_id);
+		_out(report, "</td></tr>");
+	}
+	const char *start_time = xccdf_result_get_start_time(result);
+	_out(report, "<tr><th>Started at</th><td>");
+	_text(report, start_time != NULL ? start_time : "unknown time");
+	_out(report, "</td></tr><tr><th>Finished at</th><td>");
+	_text(report, xccdf_result_get_end_time(result));
+	_out(report, "</td></tr><tr><th>Performed by</th><td>");
+	struct xccdf_identity_iterator *identities = xccdf_result_get_identities(result);
+	if (xccdf_identity_iterator_has_more(identities))
+		_text(report, xccdf_identity_get_name(xccdf_identity_iterator_next(identities)));
+	else
+		_out(report, "unknown user");
+	xccdf_identity_iterator_free(identities);
+	_out(report, "</td></tr></table></div>");
+
+	/* all the applicable platforms first, then the rest */
+	_out(report, "<div class=\"col-md-3 horizontal-scroll\"><h4>CPE Platforms</h4><ul class=\"list-group\">");
+	struct oscap_htable *applicable = oscap_htable_new();
+	OSCAP_FOR_STR(applicable_platform, xccdf_result_get_applicable_platforms(result)) {
+		oscap_htable_add(applicable, applicable_platform, (void *) applicable_platform);
+	}
+	OSCAP_FOR_STR(platform, xccdf_benchmark_get_platforms(report->benchmark)) {
+		if (oscap_htable_get(applicable, platform) == NULL)
+			continue;
+		_out(report, "<li class=\"list-group-item\"><span class=\"label label-success\" title=\"CPE platform ");
+		_attr(report, platform);
+		_out(report, " was found applicable on the evaluated machine\">");
+		_text(report, platform);
+		_out(report, "</span></li>");
+	}
+	OSCAP_FOR_STR(other, xccdf_benchmark_get_platforms(report->benchmark)) {
+		if (oscap_htable_get(applicable, other) != NULL)
+			continue;
+		_out(report, "<li class=\"list-group-item\"><span class=\"label label-default\" title=\"This CPE platform was not applicable on the evaluated machine\">");
+		_text(report, other);
+		_out(report, "</span></li>");
+	}
+	oscap_htable_free0(applicable);
+	_out(report, "</ul></div>");
+
+	_out(report, "<div class=\"col-md-4 horizontal-scroll\"><h4>Addresses</h4><ul class=\"list-group\">");
+	_write_addresses(report);
+	_out(report, "</ul></div></div></div>");
+}
+
+static void _write_progress_bar(struct xccdf_report *report, const char *type, double width, int count, const char *label)
+{
+	_outf(report, "<div class=\"progress-bar progress-bar-%s\" style=\"width: ", type);
+	_number(report, width);
+	_outf(report, "%%\">%d %s</div>", count, label);
+}
+
+static void _write_compliance(struct xccdf_report *report)
+{
+	int total = 0, ignored = 0, passed = 0, failed = 0, uncertain = 0;
+	int failed_low = 0, failed_medium = 0, failed_high = 0;
+
+	OSCAP_FOR(xccdf_rule_result, rule_result, xccdf_result_get_rule_results(report->result)) {
+		++total;
+		switch (xccdf_rule_result_get_result(rule_result)) {
+		case XCCDF_RESULT_NOT_SELECTED:
+		case XCCDF_RESULT_NOT_APPLICABLE:
+			++ignored;
+			break;
+		case XCCDF_RESULT_PASS:
+		case XCCDF_RESULT_FIXED:
+			++passed;
+			break;
+		case XCCDF_RESULT_FAIL:
+			++failed;
+			switch (xccdf_rule_result_get_severity(rule_result)) {
+			case XCCDF_LOW:
+				++failed_low;
+				break;
+			case XCCDF_MEDIUM:
+				++failed_medium;
+				break;
+			case XCCDF_HIGH:
+				++failed_high;
+				break;
+			default:
+				break;
+			}
+			break;
+		case XCCDF_RESULT_ERROR:
+		case XCCDF_RESULT_UNKNOWN:
+			++uncertain;
+			break;
+		default:
+			break;
+		}
+	}
+
+	_out(report, "<div id=\"compliance-and-scoring\"><h2>Compliance and Scoring</h2>");
+	if (failed > 0) {
+		_outf(report, "<div class=\"alert alert-danger\"><strong>The target system did not satisfy the conditions of %d rules!</strong>", failed);
+		if (uncertain > 0)
+			_outf(report, " Furthermore, the results of %d rules were inconclusive.", uncertain);
+		_out(report, " Please review rule results and consider applying remediation.</div>");
+	} else if (uncertain > 0) {
+		_outf(report, "<div class=\"alert alert-warning\"><strong>There were no failed rules, but the results of %d rules were inconclusive!</strong>"
+			" Please review rule results and consider applying remediation.</div>", uncertain);
+	} else {
+		_out(report, "<div class=\"alert alert-success\"><strong>There were no failed or uncertain rules.</strong> It seems that no action is necessary.</div>");
+	}
+
+	const double considered = total - ignored;
+	_outf(report, "<h3>Rule results</h3><div class=\"progress\" title=\"Displays proportion of passed/fixed, failed/error, and other rules (in that order). There were %d rules taken into account.\">", total - ignored);
+	_write_progress_bar(report, "success", passed / considered * 100, passed, "passed");
+	_write_progress_bar(report, "danger", failed / considered * 100, failed, "failed");
+	_write_progress_bar(report, "warning", (1 - (passed + failed) / considered) * 100, total - ignored - passed - failed, "other");
+	_out(report, "</div>");
+
+	const int failed_other = failed - failed_high - failed_medium - failed_low;
+	const double failed_count = failed;
+	_outf(report, "<h3>Severity of failed rules</h3><div class=\"progress\" title=\"Displays proportion of high, medium, low, and other severity failed rules (in that order). There were %d total failed rules.\">", failed);
+	_write_progress_bar(report, "success", failed_other / failed_count * 100, failed_other, "other");
+	_write_progress_bar(report, "info", failed_low / failed_count * 100, failed_low, "low");
+	_write_progress_bar(report, "warning", failed_medium / failed_count * 100, failed_medium, "medium");
+	_write_progress_bar(report, "danger", failed_high / failed_count * 100, failed_high, "high");
+	_out(report, "</div>");
+
+	_out(report, "<h3 title=\"As per the XCCDF specification\">Score</h3><table class=\"table table-striped table-bordered\">"
+		"<thead><tr><th>Scoring system</th><th class=\"text-center\">Score</th><th class=\"text-center\">Maximum</th>"
+		"<th class=\"text-center\" style=\"width: 40%\">Percent</th></tr></thead><tbody>");
+	OSCAP_FOR(xccdf_score, score, xccdf_result_get_scores(report->result)) {
+		/* the percent is computed from the numbers as they are exported */
+		char *value = oscap_sprintf("%f", (float) xccdf_score_get_score(score));
+		char *maximum = oscap_sprintf("%f", (float) xccdf_score_get_maximum(score));
+		const double percent = strtod(value, NULL) / strtod(maximum, NULL) * 100;
+		_out(report, "<tr><td>");
+		_text(report, xccdf_score_get_system(score));
+		_outf(report, "</td><td class=\"text-center\">%s</td><td class=\"text-center\">%s</td><td><div class=\"progress\">", value, maximum);
+		_out(report, "<div class=\"progress-bar progress-bar-success\" style=\"width: ");
+		_number(report, percent);
+		_out(report, "%\">");
+		if (percent >= 50) {
+			_number(report, round(percent * 100) / 100);
+			_out(report, "%");
+		}
+		_out(report, "</div><div class=\"progress-bar progress-bar-danger\" style=\"width: ");
+		_number(report, 100 - percent);
+		_out(report, "%\">");
+		if (percent < 50) {
+			_number(report, round(percent * 100) / 100);
+			_out(report, "%");
+		}
+		_out(report, "</div></div></td></tr>");
+		free(value);
+		free(maximum);
+	}
+	_out(report, "</tbody></table></div>");
+}
+
+/* --------- rule overview -------- */
+
+static void _collect_references(struct xccdf_item *item, struct oscap_htable *hrefs)
+{
+	OSCAP_FOR(oscap_reference, reference, xccdf_item_get_references(item)) {
+		const char *href = oscap_reference_get_href(reference);
+		if (href != NULL)
+			oscap_htable_add(hrefs, href, (void *) href);
+	}
+
+	struct xccdf_item_iterator *children = NULL;
+	switch (xccdf_item_get_type(item)) {
+	case XCCDF_BENCHMARK: {
+		OSCAP_FOR(xccdf_profile, profile, xccdf_benchmark_get_profiles(xccdf_item_to_benchmark(item))) {
+			_collect_references(XITEM(profile), hrefs);
+		}
+		OSCAP_FOR(xccdf_value, value, xccdf_benchmark_get_values(xccdf_item_to_benchmark(item))) {
+			_collect_references(XITEM(value), hrefs);
+		}
+		children = xccdf_benchmark_get_content(xccdf_item_to_benchmark(item));
+		break;
+	}
+	case XCCDF_GROUP: {
+		OSCAP_FOR(xccdf_value, value, xccdf_group_get_values(xccdf_item_to_group(item))) {
+			_collect_references(XITEM(value), hrefs);
+		}
+		children = xccdf_group_get_content(xccdf_item_to_group(item));
+		break;
+	}
+	default:
+		return;
+	}
+	OSCAP_FOR(xccdf_item, child, children) {
+		_collect_references(child, hrefs);
+	}
+}
+
+static int _strcmp_ptr(const void *a, const void *b)
+{
+	return strcmp(*(const char **) a, *(const char **) b);
+}
+
+static void _write_reference_options(struct xccdf_report *report)
+{
+	struct oscap_htable *hrefs = oscap_htable_new();
+	_collect_references(XITEM(report->benchmark), hrefs);
+
+	size_t count = 0, size = 16;
+	const char **sorted = malloc(size * sizeof(const char *));
+	struct oscap_htable_iterator *it = oscap_htable_iterator_new(hrefs);
+	while (oscap_htable_iterator_has_more(it)) {
+		if (count == size) {
+			size *= 2;
+			sorted = realloc(sorted, size * sizeof(const char *));
+		}
+		sorted[count++] = oscap_htable_iterator_next_key(it);
+	}
+	oscap_htable_iterator_free(it);
+	qsort(sorted, count, sizeof(const char *), _strcmp_ptr);
+
+	for (size_t i = 0; i < count; ++i) {
+		if (_is_blank(sorted[i]) || strcmp(sorted[i], REPORT_CONTRIBUTORS_HREF) == 0)
+			continue;
+		const char *name = _reference_name(sorted[i]);
+		_out(report, "<option value=\"");
+		_attr(report, name);
+		_out(report, "\">");
+		_text(report, name);
+		_out(report, "</option>");
+	}
+	free(sorted);
+	oscap_htable_free0(hrefs);
+}
+
+struct report_reference {
+	const char *href;
+	const char *text;
+	size_t position;
+};
+
+static int _reference_cmp(const void *a, const void *b)
+{
+	const struct report_reference *ra = a, *rb = b;
+	int cmp = strcmp(ra->href != NULL ? ra->href : "", rb->href != NULL ? rb->href : "");
+	if (cmp == 0)
+		return ra->position < rb->position ? -1 : ra->position > rb->position;
+	return cmp;
+}
+
+/* References of a rule as {"name":["text",...],...} for grouping the rules by references. */
+static void _write_references_json(struct xccdf_report *report, struct xccdf_item *item)
+{
+	size_t count = 0, size = 8;
+	struct report_reference *refs = malloc(size * sizeof(struct report_reference));
+	OSCAP_FOR(oscap_reference, reference, xccdf_item_get_references(item)) {
+		if (count == size) {
+			size *= 2;
+			refs = realloc(refs, size * sizeof(struct report_reference));
+		}
+		refs[count].href = oscap_reference_get_href(reference);
+		refs[count].text = oscap_reference_get_title(reference);
+		refs[count].position = count;
+		++count;
+	}
+	qsort(refs, count, sizeof(struct report_reference), _reference_cmp);
+
+	_out(report, "{");
+	for (size_t i = 0; i < count; ++i) {
+		if (refs[i].href == NULL || (i > 0 && oscap_streq(refs[i - 1].href, refs[i].href)))
+			continue;
+		if (i != 0)
+			_out(report, ",");
+		_out(report, "&quot;");
+		_attr(report, _reference_name(refs[i].href));
+		_out(report, "&quot;:[");
+		/* the references with the same href follow in the document order */
+		for (size_t j = i; j < count && oscap_streq(refs[j].href, refs[i].href); ++j) {
+			if (j != i)
+				_out(report, ",");
+			_out(report, "&quot;");
+			_attr(report, _is_blank(refs[j].text) ? "unknown" : refs[j].text);
+			_out(report, "&quot;");
+		}
+		_out(report, "]");
+	}
+	_out(report, "}");
+	free(refs);
+}
+
+static const char *_parent_id(struct xccdf_item *item)
+{
+	struct xccdf_item *parent = xccdf_item_get_parent(item);
+	if (parent == NULL)
+		return NULL;
+	xccdf_type_t type = xccdf_item_get_type(parent);
+	return (type == XCCDF_GROUP || type == XCCDF_BENCHMARK) ? xccdf_item_get_id(parent) : NULL;
+}
+
+static void _write_overview_leaf(struct xccdf_report *report, struct xccdf_item *item, int indent)
+{
+	const char *id = _item_id(item);
+	struct report_rule *rule = oscap_htable_get(report->rules, id);
+	if (rule == NULL || (rule->results & ~RESULT_BIT(XCCDF_RESULT_NOT_SELECTED)) == 0)
+		return;
+
+	xccdf_test_result_type_t result = xccdf_rule_result_get_result(rule->rule_result);
+	const char *result_text = _result_text(result);
+
+	_out(report, "<tr data-tt-id=\"");
+	_attr(report, id);
+	_outf(report, "\" class=\"rule-overview-leaf rule-overview-leaf-%s ", result_text);
+	if (RESULT_BIT(result) & RESULTS_ATTENTION) {
+		_out(report, "rule-overview-needs-attention");
+	} else {
+		_out(report, "rule-overview-leaf-id-");
+		_attr(report, id);
+	}
+	_outf(report, "\" id=\"rule-overview-leaf-idm%u\" data-tt-parent-id=\"", rule->id);
+	_attr(report, _parent_id(item));
+	_out(report, "\" data-references=\"");
+	_write_references_json(report, item);
+	_outf(report, "\"><td style=\"padding-left: %dpx\"><a href=\"#rule-detail-idm%u\" onclick=\"return openRuleDetailsDialog('idm%u')\">",
+		indent * 19, rule->id, rule->id);
+	_render_item_title(report, item);
+	_out(report, "</a>");
+	if (rule->overridden)
+		_out(report, " &nbsp;<span class=\"label label-warning\">waived</span>");
+	_out(report, "</td><td class=\"rule-severity\" style=\"text-align: center\">");
+	xccdf_level_t severity = xccdf_rule_result_get_severity(rule->rule_result);
+	_text(report, severity != XCCDF_LEVEL_NOT_DEFINED ? oscap_enum_to_string(XCCDF_LEVEL_MAP, severity) : "unknown");
+	_outf(report, "</td><td class=\"rule-result rule-result-%s\"><div><abbr title=\"%s\">%s</abbr></div></td></tr>",
+		result_text, _result_tooltip(result), result_text);
+}
+
+struct report_counts {
+	int rules;
+	int fail;
+	int error;
+	int unknown;
+	int notchecked;
+	int notselected;
+};
+
+static void _count_rules(struct xccdf_report *report, struct xccdf_item *item, struct report_counts *counts)
+{
+	OSCAP_FOR(xccdf_item, child, xccdf_item_get_content(item)) {
+		if (xccdf_item_get_type(child) == XCCDF_GROUP) {
+			_count_rules(report, child, counts);
+		} else if (xccdf_item_get_type(child) == XCCDF_RULE) {
+			++counts->rules;
+			struct report_rule *rule = oscap_htable_get(report->rules, _item_id(child));
+			if (rule == NULL)
+				continue;
+			counts->fail += (rule->results & RESULT_BIT(XCCDF_RESULT_FAIL)) != 0;
+			counts->error += (rule->results & RESULT_BIT(XCCDF_RESULT_ERROR)) != 0;
+			counts->unknown += (rule->results & RESULT_BIT(XCCDF_RESULT_UNKNOWN)) != 0;
+			counts->notchecked += (rule->results & RESULT_BIT(XCCDF_RESULT_NOT_CHECKED)) != 0;
+			counts->notselected += (rule->results & RESULT_BIT(XCCDF_RESULT_NOT_SELECTED)) != 0;
+		}
+	}
+}
+
+static int _write_overview_node(struct xccdf_report *report, struct xccdf_item *item, int indent)
+{
+	struct report_counts counts = { 0 };
+	_count_rules(report, item, &counts);
+	if (counts.notselected >= counts.rules)
+		return 0;
+
+	const char *id = _item_id(item);
+	const char *parent_id = _parent_id(item);
+	_out(report, "<tr data-tt-id=\"");
+	_attr(report, id);
+	_out(report, "\" class=\"rule-overview-inner-node rule-overview-inner-node-id-");
+	_attr(report, id);
+	_out(report, "\"");
+	if (parent_id != NULL) {
+		_out(report, " data-tt-parent-id=\"");
+		_attr(report, parent_id);
+		_out(report, "\"");
+	}
+	_outf(report, "><td colspan=\"3\" style=\"padding-left: %dpx\">", indent * 19);
+	if (counts.fail + counts.error + counts.unknown + counts.notchecked > 0) {
+		_out(report, "<strong>");
+		_render_item_title(report, item);
+		_out(report, "</strong>");
+		if (counts.fail > 0)
+			_outf(report, "&nbsp;<span class=\"badge\">%dx fail</span>", counts.fail);
+		if (counts.error > 0)
+			_outf(report, "&nbsp;<span class=\"badge\">%dx error</span>", counts.error);
+		if (counts.unknown > 0)
+			_outf(report, "&nbsp;<span class=\"badge\">%dx unknown</span>", counts.unknown);
+		if (counts.notchecked > 0)
+			_outf(report, "&nbsp;<span class=\"badge\">%dx notchecked</span>", counts.notchecked);
+	} else {
+		_render_item_title(report, item);
+		_out(report, "<script>$(document).ready(function(){$('.treetable').treetable(\"collapseNode\",\"");
+		_text(report, id);
+		_out(report, "\");});</script>");
+	}
+	_out(report, "</td></tr>");
+	if (_flush(report))
+		return -1;
+
+	OSCAP_FOR(xccdf_item, group, xccdf_item_get_content(item)) {
+		if (xccdf_item_get_type(group) == XCCDF_GROUP && _write_overview_node(report, group, indent + 1)) {
+			xccdf_item_iterator_free(group_iter);
+			return -1;
+		}
+	}
+	OSCAP_FOR(xccdf_item, rule, xccdf_item_get_content(item)) {
+		if (xccdf_item_get_type(rule) == XCCDF_RULE)
+			_write_overview_leaf(report, rule, indent + 1);
+	}
+	return _flush(report);
+}
+
+static int _write_overview(struct xccdf_report *report)
+{
+	_out(report, "<div id=\"rule-overview\"><h2>Rule Overview</h2>");
+	_out(report, REPORT_RULE_OVERVIEW_FORM);
+	_write_reference_options(report);
+	_out(report, "</select></div></div></div>"
+		"<table class=\"treetable table table-bordered\"><thead><tr><th>Title</th>"
+		"<th style=\"width: 120px; text-align: center\">Severity</th>"
+		"<th style=\"width: 120px; text-align: center\">Result</th></tr></thead><tbody>");
+	if (_write_overview_node(report, XITEM(report->benchmark), 0))
+		return -1;
+	_out(report, "</tbody></table></div>");
+	return 0;
+}
+
+/* --------- OVAL details -------- */
+
+static void _oval_label(struct oscap_string *out, const char *name)
+{
+	oscap_string_append_string(out, "<th>");
+	for (const char *c = name; *c != '\0'; ++c) {
+		if (*c == '_')
+			oscap_string_append_char(out, ' ');
+		else if (c == name && *c >= 'a' && *c <= 'z')
+			oscap_string_append_char(out, *c - 'a' + 'A');
+		else if (*c == '&' || *c == '<' || *c == '>')
+			_escape(out, (char[]) { *c, '\0' }, false);
+		else
+			oscap_string_append_char(out, *c);
+	}
+	oscap_string_append_string(out, "</th>");
+}
+
+static struct oval_sysent *_oval_sysent(struct oval_sysitem *sysitem, const char *name)
+{
+	struct oval_sysent *found = NULL;
+	struct oval_sysent_iterator *sysents = oval_sysitem_get_sysents(sysitem);
+	while (found == NULL && oval_sysent_iterator_has_more(sysents)) {
+		struct oval_sysent *sysent = oval_sysent_iterator_next(sysents);
+		if (oscap_streq(oval_sysent_get_name(sysent), name))
+			found = sysent;
+	}
+	oval_sysent_iterator_free(sysents);
+	return found;
+}
+
+/* Value of an item entity as it's exported to the OVAL results. */
+static void _oval_sysent_value(struct oscap_string *out, struct oval_sysent *sysent)
+{
+	if (sysent == NULL || oval_sysent_get_mask(sysent))
+		return;
+	_escape(out, oval_sysent_get_value(sysent), false);
+	struct oval_record_field_iterator *fields = oval_sysent_get_record_fields(sysent);
+	while (oval_record_field_iterator_has_more(fields)) {
+		struct oval_record_field *field = oval_record_field_iterator_next(fields);
+		if (!oval_record_field_get_mask(field))
+			_escape(out, oval_record_field_get_value(field), false);
+	}
+	oval_record_field_iterator_free(fields);
+}
+
+static void _oval_permission(struct oscap_string *out, struct oval_sysitem *sysitem, const char *name, char c)
+{
+	struct oval_sysent *sysent = _oval_sysent(sysitem, name);
+	if (sysent == NULL)
+		return;
+	bool set = !oval_sysent_get_mask(sysent) && oscap_streq(oval_sysent_get_value(sysent), "true");
+	oscap_string_append_char(out, set ? c : '-');
+}
+
+static bool _oval_flag(struct oval_sysitem *sysitem, const char *name)
+{
+	struct oval_sysent *sysent = _oval_sysent(sysitem, name);
+	return sysent != NULL && !oval_sysent_get_mask(sysent) && oscap_streq(oval_sysent_get_value(sysent), "true");
+}
+
+static void _oval_path(struct oscap_string *out, struct oval_sysitem *sysitem)
+{
+	_oval_sysent_value(out, _oval_sysent(sysitem, "path"));
+	oscap_string_append_char(out, '/');
+	_oval_sysent_value(out, _oval_sysent(sysitem, "filename"));
+}
+
+static void _oval_item_head(struct oscap_string *out, struct oval_sysitem *sysitem)
+{
+	switch ((int) oval_sysitem_get_subtype(sysitem)) {
+	case OVAL_SUBTYPE_UNKNOWN:
+		return;
+	case OVAL_UNIX_FILE:
+		oscap_string_append_string(out, "<tr><th>Path</th><th>Type</th><th>UID</th><th>GID</th><th>Size (B)</th><th>Permissions</th></tr>");
+		return;
+	case OVAL_INDEPENDENT_TEXT_FILE_CONTENT:
+		oscap_string_append_string(out, "<tr><th>Path</th><th>Content</th></tr>");
+		return;
+	default:
+		break;
+	}
+
+	oscap_string_append_string(out, "<tr>");
+	struct oval_message_iterator *messages = oval_sysitem_get_messages(sysitem);
+	while (oval_message_iterator_has_more(messages)) {
+		oval_message_iterator_next(messages);
+		_oval_label(out, "message");
+	}
+	oval_message_iterator_free(messages);
+	struct oval_sysent_iterator *sysents = oval_sysitem_get_sysents(sysitem);
+	while (oval_sysent_iterator_has_more(sysents))
+		_oval_label(out, oval_sysent_get_name(oval_sysent_iterator_next(sysents)));
+	oval_sysent_iterator_free(sysents);
+	oscap_string_append_string(out, "</tr>");
+}
+
+static void _oval_item_body(struct oscap_string *out, struct oval_sysitem *sysitem)
+{
+	switch ((int) oval_sysitem_get_subtype(sysitem)) {
+	case OVAL_SUBTYPE_UNKNOWN:
+		return;
+	case OVAL_UNIX_FILE:
+		oscap_string_append_string(out, "<tr><td>");
+		_oval_path(out, sysitem);
+		oscap_string_append_string(out, "</td><td>");
+		_oval_sysent_value(out, _oval_sysent(sysitem, "type"));
+		oscap_string_append_string(out, "</td><td>");
+		_oval_sysent_value(out, _oval_sysent(sysitem, "user_id"));
+		oscap_string_append_string(out, "</td><td>");
+		_oval_sysent_value(out, _oval_sysent(sysitem, "group_id"));
+		oscap_string_append_string(out, "</td><td>");
+		_oval_sysent_value(out, _oval_sysent(sysitem, "size"));
+		oscap_string_append_string(out, "</td><td><code>");
+		_oval_permission(out, sysitem, "uread", 'r');
+		_oval_permission(out, sysitem, "uwrite", 'w');
+		if (_oval_flag(sysitem, "suid"))
+			oscap_string_append_char(out, 's');
+		else
+			_oval_permission(out, sysitem, "uexec", 'x');
+		_oval_permission(out, sysitem, "gread", 'r');
+		_oval_permission(out, sysitem, "gwrite", 'w');
+		if (_oval_flag(sysitem, "sgid"))
+			oscap_string_append_char(out, 's');
+		else
+			_oval_permission(out, sysitem, "gexec", 'x');
+		_oval_permission(out, sysitem, "oread", 'r');
+		_oval_permission(out, sysitem, "owrite", 'w');
+		_oval_permission(out, sysitem, "oexec", 'x');
+		oscap_string_append_string(out, _oval_flag(sysitem, "sticky") ? "t" : "&nbsp;");
+		oscap_string_append_string(out, "</code></td></tr>");
+		return;
+	case OVAL_INDEPENDENT_TEXT_FILE_CONTENT:
+		oscap_string_append_string(out, "<tr><td>");
+		_oval_path(out, sysitem);
+		oscap_string_append_string(out, "</td><td>");
+		_oval_sysent_value(out, _oval_sysent(sysitem, "text"));
+		oscap_string_append_string(out, "</td></tr>");
+		return;
+	default:
+		break;
+	}
+
+	oscap_string_append_string(out, "<tr>");
+	struct oval_message_iterator *messages = oval_sysitem_get_messages(sysitem);
+	while (oval_message_iterator_has_more(messages)) {
+		oscap_string_append_string(out, "<td>");
+		_escape(out, oval_message_get_text(oval_message_iterator_next(messages)), false);
+		oscap_string_append_string(out, "</td>");
+	}
+	oval_message_iterator_free(messages);
+	struct oval_sysent_iterator *sysents = oval_sysitem_get_sysents(sysitem);
+	while (oval_sysent_iterator_has_more(sysents)) {
+		struct oval_sysent *sysent = oval_sysent_iterator_next(sysents);
+		oval_datatype_t datatype = oval_sysent_get_datatype(sysent);
+		if (datatype == OVAL_DATATYPE_INTEGER || datatype == OVAL_DATATYPE_BOOLEAN)
+			oscap_string_append_string(out, "<td role=\"num\">");
+		else
+			oscap_string_append_string(out, "<td>");
+		_oval_sysent_value(out, sysent);
+		oscap_string_append_string(out, "</td>");
+	}
+	oval_sysent_iterator_free(sysents);
+	oscap_string_append_string(out, "</tr>");
+}
+
+static void _oval_test_heading(struct oscap_string *out, const char *title, bool pass, const char *passed, const char *failed)
+{
+	oscap_string_append_string(out, "<h4><span class=\"label label-primary\">");
+	_escape(out, title, false);
+	oscap_string_append_string(out, "</span>&nbsp;");
+	oscap_string_append_string(out, pass ? "<span class=\"label label-success\">passed</span> " : "<span class=\"label label-danger\">failed</span> ");
+	oscap_string_append_string(out, pass ? passed : failed);
+	oscap_string_append_string(out, "</h4>");
+}
+
+static void _oval_node_head(struct oscap_string *out, xmlNode *node)
+{
+	oscap_string_append_string(out, "<tr>");
+	for (xmlNode *child = node->children; child != NULL; child = child->next) {
+		if (child->type == XML_ELEMENT_NODE)
+			_oval_label(out, (const char *) child->name);
+	}
+	oscap_string_append_string(out, "</tr>");
+}
+
+static bool _oval_node_has_elements(xmlNode *node)
+{
+	for (xmlNode *child = node->children; child != NULL; child = child->next) {
+		if (child->type == XML_ELEMENT_NODE)
+			return true;
+	}
+	return false;
+}
+
+/* Cells of the entities of an object or a state, empty entities of objects are shown as "no value". */
+static void _oval_node_cells(struct oscap_string *out, xmlNode *node, bool no_value)
+{
+	for (xmlNode *child = node->children; child != NULL; child = child->next) {
+		if (child->type != XML_ELEMENT_NODE)
+			continue;
+		xmlChar *content = xmlNodeGetContent(child);
+		bool has_content = _oval_node_has_elements(child) || !_is_blank((const char *) content);
+		if (has_content) {
+			oscap_string_append_string(out, "<td>");
+			_escape(out, (const char *) content, false);
+			oscap_string_append_string(out, "</td>");
+		} else if (no_value && !xmlHasProp(child, BAD_CAST "var_ref")) {
+			oscap_string_append_string(out, "<td>no value</td>");
+		}
+		xmlFree(content);
+	}
+}
+
+static bool _oval_node_has_var_ref(xmlNode *node)
+{
+	for (xmlNode *child = node->children; child != NULL; child = child->next) {
+		if (child->type == XML_ELEMENT_NODE && xmlHasProp(child, BAD_CAST "var_ref"))
+			return true;
+	}
+	return false;
+}
+
+/* Values of the variables the test was evaluated with and the message of the object. */
+static void _oval_tested_variables(struct oscap_string *out, struct oval_result_system *sys, struct oval_result_test *rtest, const char *object_id, bool table)
+{
+	struct oscap_list *values = oscap_list_new();
+	if (oval_result_test_get_result(rtest) != OVAL_RESULT_NOT_EVALUATED) {
+		struct oval_variable_binding_iterator *bindings = oval_result_test_get_bindings(rtest);
+		while (oval_variable_binding_iterator_has_more(bindings)) {
+			struct oval_variable_binding *binding = oval_variable_binding_iterator_next(bindings);
+			struct oval_string_iterator *binding_values = oval_variable_binding_get_values(binding);
+			while (oval_string_iterator_has_more(binding_values))
+				oscap_list_add(values, oval_string_iterator_next(binding_values));
+			oval_string_iterator_free(binding_values);
+		}
+		oval_variable_binding_iterator_free(bindings);
+	}
+
+	oscap_string_append_string(out, "<td>");
+	bool nested = table && oscap_list_get_itemcount(values) > 1;
+	if (nested)
+		oscap_string_append_string(out, "<table>");
+	struct oscap_iterator *it = oscap_iterator_new(values);
+	while (oscap_iterator_has_more(it)) {
+		const char *value = oscap_iterator_next(it);
+		if (_is_blank(value))
+			continue;
+		if (nested)
+			oscap_string_append_string(out, "<tr><td>");
+		_escape(out, value, false);
+		if (nested)
+			oscap_string_append_string(out, "</td></tr>");
+	}
+	oscap_iterator_free(it);
+	if (nested)
+		oscap_string_append_string(out, "</table>");
+	oscap_list_free0(values);
+
+	struct oval_syschar_model *syschar_model = oval_result_system_get_syschar_model(sys);
+	struct oval_syschar *syschar = syschar_model != NULL ? oval_syschar_model_get_syschar(syschar_model, object_id) : NULL;
+	if (syschar != NULL) {
+		struct oval_message_iterator *messages = oval_syschar_get_messages(syschar);
+		if (oval_message_iterator_has_more(messages))
+			_escape(out, oval_message_get_text(oval_message_iterator_next(messages)), false);
+		oval_message_iterator_free(messages);
+	}
+	oscap_string_append_string(out, "</td>");
+}
+
+static void _oval_test(struct xccdf_report *report, struct oscap_string *out, struct oval_result_system *sys, struct oval_result_test *rtest, bool pass)
+{
+	struct oval_test *test = oval_result_test_get_test(rtest);
+	const char *title = oval_test_get_comment(test);
+
+	/* items and bindings are not reported when the test was not evaluated */
+	struct oval_result_item_iterator *items = NULL;
+	if (oval_result_test_get_result(rtest) != OVAL_RESULT_NOT_EVALUATED)
+		items = oval_result_test_get_items(rtest);
+
+	if (items != NULL && oval_result_item_iterator_has_more(items)) {
+		if (title != NULL) {
+			_oval_test_heading(out, title, pass, "because of these items:", "because of these items:");
+		} else {
+			char *generated = oscap_sprintf("OVAL test %s", oval_test_get_id(test));
+			_oval_test_heading(out, generated, pass, "because of these items:", "because of these items:");
+			free(generated);
+		}
+
+		oscap_string_append_string(out, "<table class=\"table table-striped table-bordered\"><thead>");
+		struct oscap_string *body = oscap_string_new();
+		int count = 0;
+		while (oval_result_item_iterator_has_more(items)) {
+			struct oval_sysitem *sysitem = oval_result_item_get_sysitem(oval_result_item_iterator_next(items));
+			if (count == 0 && sysitem != NULL)
+				_oval_item_head(out, sysitem);
+			if (count < REPORT_OVAL_ITEMS_MAX && sysitem != NULL)
+				_oval_item_body(body, sysitem);
+			++count;
+		}
+		oscap_string_append_string(out, "</thead><tbody>");
+		oscap_string_append_string(out, oscap_string_get_cstr(body));
+		oscap_string_free(body);
+		oscap_string_append_string(out, "</tbody></table>");
+		if (count > REPORT_OVAL_ITEMS_MAX) {
+			char *more = oscap_sprintf("... and %d more items.", count - REPORT_OVAL_ITEMS_MAX);
+			oscap_string_append_string(out, more);
+			free(more);
+		}
+		oval_result_item_iterator_free(items);
+		return;
+	}
+	if (items != NULL)
+		oval_result_item_iterator_free(items);
+
+	/* the tested object doesn't exist or there was an error while accessing it */
+	struct oval_object *object = oval_test_get_object(test);
+	if (object == NULL)
+		return;
+	xmlNode *root = xmlDocGetRootElement(report->scratch);
+	xmlNode *object_node = oval_object_to_dom(object, report->scratch, root);
+	if (object_node == NULL)
+		return;
+
+	const char *object_id = oval_object_get_id(object);
+	const char *comment = oval_object_get_comment(object);
+	_oval_test_heading(out, title, pass, "because these items were not found:", "because these items were missing:");
+	oscap_string_append_string(out, "<h5>Object <strong><abbr");
+	if (comment != NULL) {
+		oscap_string_append_string(out, " title=\"");
+		_escape(out, comment, true);
+		oscap_string_append_string(out, "\"");
+	}
+	oscap_string_append_string(out, ">");
+	_escape(out, object_id, false);
+	oscap_string_append_string(out, "</abbr></strong> of type <strong>");
+	_escape(out, (const char *) object_node->name, false);
+	oscap_string_append_string(out, "</strong></h5><table class=\"table table-striped table-bordered\"><thead>");
+	_oval_node_head(out, object_node);
+	oscap_string_append_string(out, "</thead><tbody><tr>");
+	if (_oval_node_has_var_ref(object_node))
+		_oval_tested_variables(out, sys, rtest, object_id, true);
+	_oval_node_cells(out, object_node, true);
+	oscap_string_append_string(out, "</tr></tbody></table>");
+	xmlUnlinkNode(object_node);
+	xmlFreeNode(object_node);
+
+	struct oval_state_iterator *states = oval_test_get_states(test);
+	struct oval_state *state = oval_state_iterator_has_more(states) ? oval_state_iterator_next(states) : NULL;
+	oval_state_iterator_free(states);
+	xmlNode *state_node = state != NULL ? oval_state_to_dom(state, report->scratch, root) : NULL;
+	if (state_node == NULL)
+		return;
+	oscap_string_append_string(out, "<h5>State <strong>");
+	_escape(out, oval_state_get_id(state), false);
+	oscap_string_append_string(out, "</strong> of type <strong>");
+	_escape(out, (const char *) state_node->name, false);
+	oscap_string_append_string(out, "</strong></h5><table class=\"table table-striped table-bordered\"><thead>");
+	_oval_node_head(out, state_node);
+	oscap_string_append_string(out, "</thead><tbody><tr>");
+	if (_oval_node_has_var_ref(state_node))
+		_oval_tested_variables(out, sys, rtest, object_id, false);
+	_oval_node_cells(out, state_node, false);
+	oscap_string_append_string(out, "</tr></tbody></table>");
+	xmlUnlinkNode(state_node);
+	xmlFreeNode(state_node);
+}
+
+static void _oval_criteria(struct xccdf_report *report, struct oscap_string *out, struct oval_result_system *sys, struct oval_result_criteria_node *node, bool pass)
+{
+	if (node == NULL)
+		return;
+	switch (oval_result_criteria_node_get_type(node)) {
+	case OVAL_NODETYPE_CRITERIA: {
+		struct oval_result_criteria_node_iterator *subnodes = oval_result_criteria_node_get_subnodes(node);
+		while (oval_result_criteria_node_iterator_has_more(subnodes))
+			_oval_criteria(report, out, sys, oval_result_criteria_node_iterator_next(subnodes), pass);
+		oval_result_criteria_node_iterator_free(subnodes);
+		break;
+	}
+	case OVAL_NODETYPE_CRITERION: {
+		struct oval_result_test *rtest = oval_result_criteria_node_get_test(node);
+		if (rtest != NULL)
+			_oval_test(report, out, sys, rtest, pass);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+static struct oval_agent_session *_oval_agent(struct xccdf_report *report, const char *href)
+{
+	if (report->agents == NULL || href == NULL)
+		return NULL;
+	for (int i = 0; report->agents[i] != NULL; ++i) {
+		if (oscap_streq(oval_agent_get_filename(report->agents[i]), href))
+			return report->agents[i];
+	}
+	return NULL;
+}
+
+static void _oval_details(struct xccdf_report *report, struct oscap_string *out, struct xccdf_check *check, bool pass)
+{
+	struct oval_agent_session *agent = NULL;
+	const char *href = NULL, *name = NULL;
+	struct xccdf_check_content_ref_iterator *refs = xccdf_check_get_content_refs(check);
+	while (agent == NULL && xccdf_check_content_ref_iterator_has_more(refs)) {
+		struct xccdf_check_content_ref *ref = xccdf_check_content_ref_iterator_next(refs);
+		href = xccdf_check_content_ref_get_href(ref);
+		name = xccdf_check_content_ref_get_name(ref);
+		agent = _oval_agent(report, href);
+	}
+	xccdf_check_content_ref_iterator_free(refs);
+	if (agent == NULL || name == NULL)
+		return;
+
+	struct oval_results_model *results_model = oval_agent_get_results_model(agent);
+	struct oval_directives_model *directives_model = oval_results_model_get_directives_model(results_model);
+	struct oscap_string *details = oscap_string_new();
+	struct oval_result_system_iterator *systems = oval_results_model_get_systems(results_model);
+	while (oval_result_system_iterator_has_more(systems)) {
+		struct oval_result_system *sys = oval_result_system_iterator_next(systems);
+		struct oval_result_definition *rdef = oval_result_system_get_definition(sys, name);
+		if (rdef == NULL)
+			continue;
+
+		/* show only the details present in the exported results */
+		struct oval_definition *definition = oval_result_definition_get_definition(rdef);
+		struct oval_result_directives *directives = oval_directives_model_get_classdir(directives_model, oval_definition_get_class(definition));
+		if (directives == NULL)
+			directives = oval_directives_model_get_defdirs(directives_model);
+		oval_result_t result = oval_result_definition_get_result(rdef);
+		if (!oval_result_directives_get_reported(directives, result) ||
+				oval_result_directives_get_content(directives, result) != OVAL_DIRECTIVE_CONTENT_FULL)
+			continue;
+
+		_oval_criteria(report, details, sys, oval_result_definition_get_criteria(rdef), pass);
+	}
+	oval_result_system_iterator_free(systems);
+
+	/* the tables alone don't make the details worth showing */
+	char *stripped = oscap_strdup(oscap_string_get_cstr(details));
+	char *w = stripped;
+	bool in_tag = false;
+	for (const char *r = stripped; *r != '\0'; ++r) {
+		if (*r == '<')
+			in_tag = true;
+		else if (*r == '>')
+			in_tag = false;
+		else if (!in_tag)
+			*w++ = *r;
+	}
+	*w = '\0';
+	if (!_is_blank(stripped)) {
+		oscap_string_append_string(out, "<span class=\"label label-default\"><abbr title=\"OVAL details taken from OVAL results of '");
+		_escape(out, href, true);
+		oscap_string_append_string(out, "'\">OVAL details</abbr></span><div class=\"panel panel-default\"><div class=\"panel-body\">");
+		oscap_string_append_string(out, oscap_string_get_cstr(details));
+		oscap_string_append_string(out, "</div></div>");
+	}
+	free(stripped);
+	oscap_string_free(details);
+}
+
+/* --------- SCE details -------- */
+
+static void _sce_output(struct oscap_string *out, const char *stream, const char *origin, const char *text)
+{
+	oscap_string_append_string(out, "<span class=\"label label-default\"><abbr title=\"Script Check Engine ");
+	oscap_string_append_string(out, stream);
+	oscap_string_append_string(out, " taken from ");
+	_escape(out, origin, true);
+	oscap_string_append_string(out, "\">SCE ");
+	oscap_string_append_string(out, stream);
+	oscap_string_append_string(out, "</abbr></span><pre><code>");
+	_escape(out, text, false);
+	oscap_string_append_string(out, "</code></pre>");
+}
+
+/* The entity references in a check-import are expanded when it's exported, so they are here as well. */
+static char *_sce_import(struct xccdf_check *check, const char *import_name)
+{
+	char *content = NULL;
+	struct xccdf_check_import_iterator *imports = xccdf_check_get_imports(check);
+	while (content == NULL && xccdf_check_import_iterator_has_more(imports)) {
+		struct xccdf_check_import *import = xccdf_check_import_iterator_next(imports);
+		if (!oscap_streq(xccdf_check_import_get_name(import), import_name))
+			continue;
+		const char *raw = xccdf_check_import_get_content(import);
+		if (raw == NULL || *raw == '\0')
+			break;
+		xmlDoc *doc = xmlNewDoc(BAD_CAST "1.0");
+		xmlNode *list = xmlStringGetNodeList(doc, BAD_CAST raw);
+		xmlChar *decoded = xmlNodeListGetString(doc, list, 1);
+		xmlFreeNodeList(list);
+		xmlFreeDoc(doc);
+		content = oscap_strdup(decoded != NULL ? (const char *) decoded : raw);
+		xmlFree(decoded);
+	}
+	xccdf_check_import_iterator_free(imports);
+	return content;
+}
+
+static void _sce_details(struct xccdf_report *report, struct oscap_string *out, struct xccdf_check *check)
+{
+	char *stdout_text = _sce_import(check, "stdout");
+	char *stderr_text = _sce_import(check, "stderr");
+	if (stdout_text != NULL || stderr_text != NULL) {
+		if (stdout_text != NULL)
+			_sce_output(out, "stdout", "check-import", stdout_text);
+		if (stderr_text != NULL)
+			_sce_output(out, "stderr", "check-import", stderr_text);
+		free(stdout_text);
+		free(stderr_text);
+		return;
+	}
+
+	const char *template = report->sce_template;
+	if (template == NULL || *template == '\0')
+		return;
+	char *filename = NULL;
+	const char *percent = strchr(template, '%');
+	if (percent != NULL) {
+		const char *href = NULL;
+		struct xccdf_check_content_ref_iterator *refs = xccdf_check_get_content_refs(check);
+		if (xccdf_check_content_ref_iterator_has_more(refs))
+			href = xccdf_check_content_ref_get_href(xccdf_check_content_ref_iterator_next(refs));
+		xccdf_check_content_ref_iterator_free(refs);
+		filename = oscap_sprintf("%.*s%s%s", (int) (percent - template), template, href != NULL ? href : "", percent + 1);
+	} else {
+		filename = oscap_strdup(template);
+	}
+
+	/* A rule may have been evaluated without its result file being kept. */
+	struct oscap_source *source = access(filename, R_OK) == 0 ? oscap_source_new_from_file(filename) : NULL;
+	xmlDoc *doc = source != NULL ? oscap_source_get_xmlDoc(source) : NULL;
+	xmlNode *root = doc != NULL ? xmlDocGetRootElement(doc) : NULL;
+	if (root != NULL && root->ns != NULL && oscap_streq((const char *) root->name, "sce_results") &&
+			oscap_streq((const char *) root->ns->href, REPORT_SCE_RESULT_NS)) {
+		char *origin = oscap_sprintf("'%s'", filename);
+		const char *streams[] = { "stdout", "stderr" };
+		for (size_t i = 0; i < sizeof(streams) / sizeof(streams[0]); ++i) {
+			for (xmlNode *node = root->children; node != NULL; node = node->next) {
+				if (node->type != XML_ELEMENT_NODE || node->ns == NULL || !oscap_streq((const char *) node->name, streams[i]) ||
+						!oscap_streq((const char *) node->ns->href, REPORT_SCE_RESULT_NS))
+					continue;
+				xmlChar *text = xmlNodeGetContent(node);
+				if (!_is_blank((const char *) text))
+					_sce_output(out, streams[i], origin, (const char *) text);
+				xmlFree(text);
+				break;
+			}
+		}
+		free(origin);
+	}
+	oscap_source_free(source);
+	free(filename);
+}
+
+/* --------- result details -------- */
+
+static void _write_idents_refs(struct xccdf_report *report, struct xccdf_item *item)
+{
+	struct xccdf_ident_iterator *idents = xccdf_rule_get_idents(xccdf_item_to_rule(item));
+	if (xccdf_ident_iterator_has_more(idents)) {
+		_outf(report, "<p><span class=\"label label-info\" title=\"%s\">Identifiers:</span>&nbsp;", REPORT_IDENTS_TITLE);
+		bool first = true;
+		while (xccdf_ident_iterator_has_more(idents)) {
+			struct xccdf_ident *ident = xccdf_ident_iterator_next(idents);
+			const char *system = xccdf_ident_get_system(ident);
+			const char *id = xccdf_ident_get_id(ident);
+			if (!first)
+				_out(report, ", ");
+			first = false;
+			const char *link = NULL;
+			if (oscap_str_startswith(system, "http://cve.mitre.org"))
+				link = "https://cve.mitre.org/cgi-bin/cvename.cgi?name=";
+			else if (oscap_str_startswith(system, "https://rhn.redhat.com/errata"))
+				link = "https://rhn.redhat.com/errata/";
+			if (link != NULL) {
+				_outf(report, "<a href=\"%s", link);
+				_attr(report, id);
+				if (oscap_str_startswith(link, "https://rhn"))
+					_out(report, ".html");
+				_out(report, "\">");
+			}
+			_out(report, "<abbr title=\"");
+			_attr(report, system);
+			_out(report, ": ");
+			_attr(report, id);
+			_out(report, "\">");
+			_text(report, id);
+			_out(report, "</abbr>");
+			if (link != NULL)
+				_out(report, "</a>");
+		}
+		_out(report, "</p>");
+	}
+	xccdf_ident_iterator_free(idents);
+
+	struct oscap_reference_iterator *references = xccdf_item_get_references(item);
+	if (oscap_reference_iterator_has_more(references)) {
+		_outf(report, "<p><span class=\"label label-default\" title=\"%s\">References:</span>&nbsp;", REPORT_REFERENCES_TITLE);
+		bool first = true;
+		while (oscap_reference_iterator_has_more(references)) {
+			struct oscap_reference *reference = oscap_reference_iterator_next(references);
+			const char *href = oscap_reference_get_href(reference);
+			const char *text = oscap_reference_get_title(reference);
+			if (!first)
+				_out(report, ", ");
+			first = false;
+			if (href != NULL) {
+				_out(report, "<a href=\"");
+				_attr(report, href);
+				_out(report, "\">");
+				_text(report, (text != NULL && *text != '\0') ? text : href);
+				_out(report, "</a>");
+			} else {
+				_text(report, text);
+			}
+		}
+		_out(report, "</p>");
+	}
+	oscap_reference_iterator_free(references);
+}
+
+static void _write_fix(struct xccdf_report *report, struct xccdf_fix *fix)
+{
+	const char *type = "script";
+	const char *system = xccdf_fix_get_system(fix);
+	for (int i = 0; REPORT_FIX_TYPES[i].system != NULL; ++i) {
+		if (oscap_streq(system, REPORT_FIX_TYPES[i].system))
+			type = REPORT_FIX_TYPES[i].type;
+	}
+	const unsigned id = ++report->last_id;
+
+	_outf(report, "<tr><td colspan=\"2\"><div class=\"remediation\"><span class=\"label label-success\">Remediation %s:</span>"
+		"&nbsp;&nbsp;&nbsp;<a data-toggle=\"collapse\" data-target=\"#idm%u\">(show)</a><br>"
+		"<div class=\"panel-collapse collapse\" id=\"idm%u\">", type, id, id);
+
+	xccdf_level_t complexity = xccdf_fix_get_complexity(fix);
+	xccdf_level_t disruption = xccdf_fix_get_disruption(fix);
+	bool reboot = xccdf_fix_get_reboot(fix);
+	xccdf_strategy_t strategy = xccdf_fix_get_strategy(fix);
+	if (complexity != XCCDF_LEVEL_NOT_DEFINED || disruption != XCCDF_LEVEL_NOT_DEFINED || reboot || strategy != XCCDF_STRATEGY_UNKNOWN) {
+		_out(report, "<table class=\"table table-striped table-bordered table-condensed\">");
+		if (complexity != XCCDF_LEVEL_NOT_DEFINED)
+			_outf(report, "<tr><th>Complexity:</th><td>%s</td></tr>", XCCDF_LEVEL_MAP[complexity - 1].string);
+		if (disruption != XCCDF_LEVEL_NOT_DEFINED)
+			_outf(report, "<tr><th>Disruption:</th><td>%s</td></tr>", XCCDF_LEVEL_MAP[disruption - 1].string);
+		if (reboot)
+			_out(report, "<tr><th>Reboot:</th><td>true</td></tr>");
+		if (strategy != XCCDF_STRATEGY_UNKNOWN)
+			_outf(report, "<tr><th>Strategy:</th><td>%s</td></tr>", XCCDF_STRATEGY_MAP[strategy - 1].string);
+		_out(report, "</table>");
+	}
+	_out(report, "<pre><code>");
+	_render_markup(report, report->buf, xccdf_fix_get_content(fix), true, REPORT_SUB_RESULT | REPORT_SUB_FIX);
+	_out(report, "</code></pre></div></div></td></tr>");
+}
+
+static void _write_check_details(struct xccdf_report *report, struct xccdf_rule_result *rule_result)
+{
+	struct xccdf_check_iterator *checks = xccdf_rule_result_get_checks(rule_result);
+	struct xccdf_check *check = xccdf_check_iterator_has_more(checks) ? xccdf_check_iterator_next(checks) : NULL;
+	xccdf_check_iterator_free(checks);
+	if (check == NULL)
+		return;
+
+	struct oscap_string *details = oscap_string_new();
+	const char *system = xccdf_check_get_system(check);
+	if (oscap_streq(system, REPORT_OVAL_SYSTEM))
+		_oval_details(report, details, check, xccdf_rule_result_get_result(rule_result) == XCCDF_RESULT_PASS);
+	else if (oscap_streq(system, REPORT_SCE_SYSTEM))
+		_sce_details(report, details, check);
+
+	if (!oscap_string_empty(details)) {
+		_out(report, "<tr><td colspan=\"2\"><div class=\"check-system-details\">");
+		_out(report, oscap_string_get_cstr(details));
+		_out(report, "</div></td></tr>");
+	}
+	oscap_string_free(details);
+}
+
+static void _write_details_leaf(struct xccdf_report *report, struct xccdf_item *item)
+{
+	const char *id = _item_id(item);
+	struct report_rule *rule = oscap_htable_get(report->rules, id);
+	if (rule == NULL || (rule->results & ~RESULT_BIT(XCCDF_RESULT_NOT_SELECTED)) == 0)
+		return;
+
+	struct xccdf_rule_result *rule_result = rule->rule_result;
+	xccdf_test_result_type_t result = xccdf_rule_result_get_result(rule_result);
+	const char *result_text = _result_text(result);
+	xccdf_level_t severity = xccdf_rule_result_get_severity(rule_result);
+
+	_outf(report, "<div class=\"panel panel-default rule-detail rule-detail-%s rule-detail-id-", result_text);
+	_attr(report, id);
+	_outf(report, "\" id=\"rule-detail-idm%u\"><div class=\"keywords sr-only\">", rule->id);
+	_render_item_title(report, item);
+	_text(report, id);
+	_out(report, " ");
+	if (severity != XCCDF_LEVEL_NOT_DEFINED)
+		_text(report, oscap_enum_to_string(XCCDF_LEVEL_MAP, severity));
+	OSCAP_FOR(xccdf_ident, ident, xccdf_rule_result_get_idents(rule_result)) {
+		_text(report, xccdf_ident_get_id(ident));
+		_out(report, " ");
+	}
+	_out(report, "</div><div class=\"panel-heading\"><h3 class=\"panel-title\">");
+	_render_item_title(report, item);
+	_out(report, "</h3></div><div class=\"panel-body\"><table class=\"table table-striped table-bordered\"><tbody>"
+		"<tr><td class=\"col-md-3\">Rule ID</td><td class=\"rule-id col-md-9\">");
+	_text(report, id);
+	_outf(report, "</td></tr><tr><td>Result</td><td class=\"rule-result rule-result-%s\"><div><abbr title=\"%s\">%s</abbr></div></td></tr>",
+		result_text, _result_tooltip(result), result_text);
+	_out(report, "<tr><td>Time</td><td>");
+	_text(report, xccdf_rule_result_get_time(rule_result));
+	_out(report, "</td></tr><tr><td>Severity</td><td>");
+	_text(report, severity != XCCDF_LEVEL_NOT_DEFINED ? oscap_enum_to_string(XCCDF_LEVEL_MAP, severity) : "unknown");
+	_out(report, "</td></tr><tr><td>Identifiers and References</td><td class=\"identifiers\">");
+	_write_idents_refs(report, item);
+	_out(report, "</td></tr>");
+
+	struct xccdf_override_iterator *overrides = xccdf_rule_result_get_overrides(rule_result);
+	if (xccdf_override_iterator_has_more(overrides)) {
+		_out(report, "<tr><td colspan=\"2\">");
+		while (xccdf_override_iterator_has_more(overrides)) {
+			struct xccdf_override *override = xccdf_override_iterator_next(overrides);
+			xccdf_test_result_type_t old_result = xccdf_override_get_old_result(override);
+			const char *old_text = old_result != 0 ? _result_text(old_result) : "";
+			_out(report, "<div class=\"alert alert-warning waiver\">This rule has been waived by <strong>");
+			_text(report, xccdf_override_get_authority(override));
+			_out(report, "</strong> at <strong>");
+			_text(report, xccdf_override_get_time(override));
+			_out(report, "</strong>.<blockquote>");
+			struct oscap_text *remark = xccdf_override_get_remark(override);
+			if (remark != NULL)
+				_text(report, oscap_text_get_text(remark));
+			_outf(report, "</blockquote><small>The previous result was <span class=\"rule-result rule-result-%s\">&nbsp;%s&nbsp;</span>.</small></div>",
+				old_text, old_text);
+		}
+		_out(report, "</td></tr>");
+	}
+	xccdf_override_iterator_free(overrides);
+
+	struct oscap_text_iterator *descriptions = xccdf_item_get_description(item);
+	if (oscap_text_iterator_has_more(descriptions)) {
+		_out(report, "<tr><td>Description</td><td><div class=\"description\"><p>");
+		_render_texts(report, descriptions, REPORT_SUB_RESULT);
+		_out(report, "</p></div></td></tr>");
+	} else {
+		oscap_text_iterator_free(descriptions);
+	}
+	struct oscap_text_iterator *rationales = xccdf_item_get_rationale(item);
+	if (oscap_text_iterator_has_more(rationales)) {
+		_out(report, "<tr><td>Rationale</td><td><div class=\"rationale\"><p>");
+		_render_texts(report, rationales, REPORT_SUB_RESULT);
+		_out(report, "</p></div></td></tr>");
+	} else {
+		oscap_text_iterator_free(rationales);
+	}
+	struct xccdf_warning_iterator *warnings = xccdf_item_get_warnings(item);
+	if (xccdf_warning_iterator_has_more(warnings)) {
+		_out(report, "<tr><td>Warnings</td><td>");
+		while (xccdf_warning_iterator_has_more(warnings)) {
+			_out(report, "<div class=\"panel panel-warning\"><div class=\"panel-heading\"><span class=\"label label-warning\">warning</span>&nbsp;");
+			_render_text(report, xccdf_warning_get_text(xccdf_warning_iterator_next(warnings)), 0);
+			_out(report, "</div></div>");
+		}
+		_out(report, "</td></tr>");
+	}
+	xccdf_warning_iterator_free(warnings);
+
+	_write_check_details(report, rule_result);
+
+	struct xccdf_message_iterator *messages = xccdf_rule_result_get_messages(rule_result);
+	if (xccdf_message_iterator_has_more(messages)) {
+		_out(report, "<tr><td colspan=\"2\"><div class=\"evaluation-messages\"><span class=\"label label-default\">"
+			"<abbr title=\"Messages taken from rule-result\">Evaluation messages</abbr></span>"
+			"<div class=\"panel panel-default\"><div class=\"panel-body\">");
+		while (xccdf_message_iterator_has_more(messages)) {
+			struct xccdf_message *message = xccdf_message_iterator_next(messages);
+			xccdf_message_severity_t message_severity = xccdf_message_get_severity(message);
+			if (message_severity != (xccdf_message_severity_t) XCCDF_LEVEL_NOT_DEFINED)
+				_outf(report, "<span class=\"label label-primary\">%s</span>&nbsp;", XCCDF_LEVEL_MAP[message_severity - 1].string);
+			_out(report, "<pre>");
+			_text(report, xccdf_message_get_content(message));
+			_out(report, "</pre>");
+		}
+		_out(report, "</div></div></div></td></tr>");
+	}
+	xccdf_message_iterator_free(messages);
+
+	if (RESULT_BIT(result) & RESULTS_ATTENTION) {
+		struct xccdf_rule *xrule = xccdf_item_to_rule(item);
+		OSCAP_FOR(xccdf_fixtext, fixtext, xccdf_rule_get_fixtexts(xrule)) {
+			_out(report, "<tr><td colspan=\"2\"><div class=\"remediation-description\"><span class=\"label label-success\">Remediation description:</span>"
+				"<div class=\"panel panel-default\"><div class=\"panel-body\">");
+			_render_text(report, xccdf_fixtext_get_text(fixtext), REPORT_SUB_RESULT);
+			_out(report, "</div></div></div></td></tr>");
+		}
+		OSCAP_FOR(xccdf_fix, fix, xccdf_rule_get_fixes(xrule)) {
+			_write_fix(report, fix);
+		}
+	}
+	_out(report, "</tbody></table></div></div>");
+}
+
+static int _write_details_node(struct xccdf_report *report, struct xccdf_item *item)
+{
+	int ret = 0;
+	OSCAP_FOR(xccdf_item, group, xccdf_item_get_content(item)) {
+		if (ret == 0 && xccdf_item_get_type(group) == XCCDF_GROUP)
+			ret = _write_details_node(report, group);
+	}
+	OSCAP_FOR(xccdf_item, rule, xccdf_item_get_content(item)) {
+		if (ret == 0 && xccdf_item_get_type(rule) == XCCDF_RULE) {
+			_write_details_leaf(report, rule);
+			ret = _flush(report);
+		}
+	}
+	return ret;
+}
+
+static int _write_details(struct xccdf_report *report)
+{
+	_out(report, "<div class=\"js-only hidden-print\"><button type=\"button\" class=\"btn btn-info\" onclick=\"return toggleResultDetails(this)\">"
+		"Show all result details</button></div><div id=\"result-details\"><h2>Result Details</h2>");
+	if (_write_details_node(report, XITEM(report->benchmark)))
+		return -1;
+	_out(report, "<a href=\"#result-details\"><button type=\"button\" class=\"btn btn-secondary\">Scroll back to the first rule</button></a></div>");
+	return 0;
+}
+
+static void _write_rear_matter(struct xccdf_report *report)
+{
+	_out(report, "<div id=\"rear-matter\"><div class=\"row top-spacer-10\"><div class=\"col-md-12 well well-lg\">");
+	struct oscap_text *rear_matter = _first_text(xccdf_benchmark_get_rear_matter(report->benchmark));
+	if (rear_matter != NULL) {
+		_out(report, "<div class=\"rear-matter\">");
+		_render_text(report, rear_matter, 0);
+		_out(report, "</div>");
+	}
+	_out(report, "</div></div></div>");
+}
+
+static void _write_footer(struct xccdf_report *report)
+{
+	_out(report, "<footer id=\"footer\"><div class=\"container\"><p class=\"muted credit\">"
+		"Generated using <a href=\"http://open-scap.org\">OpenSCAP</a> ");
+	_text(report, oscap_get_version());
+	_out(report, "</p></div></footer>");
+}
+
+/* --------- report -------- */
+
+static void _report_index(struct xccdf_report *report, struct xccdf_policy_model *model)
+{
+	OSCAP_FOR(xccdf_rule_result, rule_result, xccdf_result_get_rule_results(report->result)) {
+		const char *idref = xccdf_rule_result_get_idref(rule_result);
+		if (idref == NULL)
+			continue;
+		struct report_rule *rule = oscap_htable_get(report->rules, idref);
+		if (rule == NULL) {
+			rule = calloc(1, sizeof(struct report_rule));
+			rule->rule_result = rule_result;
+			rule->id = ++report->last_id;
+			oscap_htable_add(report->rules, idref, rule);
+		}
+		rule->results |= RESULT_BIT(xccdf_rule_result_get_result(rule_result));
+		struct xccdf_override_iterator *overrides = xccdf_rule_result_get_overrides(rule_result);
+		rule->overridden |= xccdf_override_iterator_has_more(overrides);
+		xccdf_override_iterator_free(overrides);
+		OSCAP_FOR(xccdf_instance, instance, xccdf_rule_result_get_instances(rule_result)) {
+			const char *context = xccdf_instance_get_context(instance);
+			if (context != NULL)
+				oscap_htable_add(report->instances, context, (void *) xccdf_instance_get_content(instance));
+		}
+	}
+
+	/* the last set-value of an idref wins */
+	OSCAP_FOR(xccdf_setvalue, setvalue, xccdf_result_get_setvalues(report->result)) {
+		const char *idref = xccdf_setvalue_get_item(setvalue);
+		if (idref == NULL)
+			continue;
+		oscap_htable_detach(report->result_values, idref);
+		oscap_htable_add(report->result_values, idref, (void *) xccdf_setvalue_get_value(setvalue));
+	}
+
+	const char *profile_id = xccdf_result_get_profile(report->result);
+	if (profile_id != NULL) {
+		/* the profile may come from a tailoring file */
+		struct xccdf_policy *policy = xccdf_policy_model_get_policy_by_id(model, profile_id);
+		report->profile = policy != NULL ? xccdf_policy_get_profile(policy) : NULL;
+	}
+	if (report->profile != NULL) {
+		OSCAP_FOR(xccdf_setvalue, profile_setvalue, xccdf_profile_get_setvalues(report->profile)) {
+			const char *idref = xccdf_setvalue_get_item(profile_setvalue);
+			if (idref == NULL)
+				continue;
+			oscap_htable_detach(report->profile_values, idref);
+			oscap_htable_add(report->profile_values, idref, (void *) xccdf_setvalue_get_value(profile_setvalue));
+		}
+		OSCAP_FOR(xccdf_refine_value, refine_value, xccdf_profile_get_refine_values(report->profile)) {
+			const char *idref = xccdf_refine_value_get_item(refine_value);
+			const char *selector = xccdf_refine_value_get_selector(refine_value);
+			if (idref == NULL)
+				continue;
+			oscap_htable_detach(report->profile_selectors, idref);
+			oscap_htable_add(report->profile_selectors, idref, (void *) (selector != NULL ? selector : ""));
+		}
+	}
+}
+
+static int _report_write(struct xccdf_report *report)
+{
+	if (_write_head(report) || _write_header(report))
+		return -1;
+	_out(report, "<div class=\"container\"><div id=\"content\">");
+	_write_introduction(report);
+	_write_characteristics(report);
+	_write_compliance(report);
+	if (_flush(report) || _write_overview(report) || _flush(report) || _write_details(report))
+		return -1;
+	_write_rear_matter(report);
+	_out(report, "</div></div>");
+	_write_footer(report);
+	_out(report, "</body></html>\n");
+	return _flush(report);
+}
+
+int xccdf_report_export(struct xccdf_policy_model *model, struct xccdf_result *result,
+		struct oval_agent_session **agents, const char *outfile, const char *sce_template)
+{
+	if (model == NULL || result == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "No XCCDF results to export.");
+		return -1;
+	}
+
+	FILE *out = outfile != NULL ? fopen(outfile, "w") : stdout;
+	if (out == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not open output file '%s'", outfile);
+		return -1;
+	}
+
+	struct xccdf_report report = {
+		.benchmark = xccdf_policy_model_get_benchmark(model),
+		.result = result,
+		.agents = agents,
+		.sce_template = sce_template,
+		.out = out,
+		.buf = oscap_string_new(),
+		.rules = oscap_htable_new(),
+		.result_values = oscap_htable_new(),
+		.profile_values = oscap_htable_new(),
+		.profile_selectors = oscap_htable_new(),
+		.instances = oscap_htable_new(),
+		.scratch = xmlNewDoc(BAD_CAST "1.0"),
+	};
+	xmlNode *root = xmlNewNode(NULL, BAD_CAST "oval_definitions");
+	xmlNewNs(root, BAD_CAST REPORT_OVAL_SYSTEM, NULL);
+	xmlDocSetRootElement(report.scratch, root);
+
+	/* the SCE result files are relative to the working directory */
+	char *sce_path = NULL;
+	if (sce_template != NULL && *sce_template != '\0' && *sce_template != '/') {
+		char pwd[PATH_MAX];
+		if (getcwd(pwd, sizeof(pwd)) != NULL)
+			report.sce_template = sce_path = oscap_sprintf("%s/%s", pwd, sce_template);
+	}
+
+	_report_index(&report, model);
+	int ret = _report_write(&report);
+
+	free(sce_path);
+	xmlFreeDoc(report.scratch);
+	oscap_htable_free0(report.instances);
+	oscap_htable_free0(report.profile_selectors);
+	oscap_htable_free0(report.profile_values);
+	oscap_htable_free0(report.result_values);
+	oscap_htable_free(report.rules, free);
+	oscap_string_free(report.buf);
+	if (outfile != NULL)
+		fclose(out);
+	return ret;
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2015 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef XCCDF_REPORT_PRIV_H_
+#define XCCDF_REPORT_PRIV_H_
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdbool.h>
+#include "public/xccdf_benchmark.h"
+#include "XCCDF_POLICY/public/xccdf_policy.h"
+#include "OVAL/public/oval_agent_api.h"
+
+/*
+ * HTML report of a TestResult
+ *
+ * The report of an evaluation is written straight from the policy model
+ * and the TestResult held by the session; the OVAL details are taken from
+ * the results of the OVAL agents. Neither the XCCDF results nor the ARF
+ * have to be exported to a document to be transformed by xccdf-report.xsl.
+ * The markup is the one produced by the stylesheet, the CSS, JavaScript and
+ * logo are still read from the installed xccdf-resources.xsl and
+ * xccdf-branding.xsl. Setting OSCAP_REPORT_XSLT=1 makes the session
+ * transform the exported results with the stylesheet instead.
+ */
+#define XCCDF_REPORT_XSLT_ENV "OSCAP_REPORT_XSLT"
+
+/**
+ * Find out whether the HTML report is to be generated by xccdf-report.xsl.
+ */
+bool xccdf_report_xslt_enabled(void);
+
+/**
+ * Write the HTML report of a TestResult.
+ * @param model policy model the TestResult was evaluated with
+ * @param result the TestResult
+ * @param agents NULL terminated array of the OVAL sessions whose results
+ *        are shown in the details of the rules, or NULL
+ * @param outfile path of the report, stdout if NULL
+ * @param sce_template path of the SCE result files, '%' is replaced with
+ *        the href of the check-content-ref; NULL or empty if only the
+ *        output imported to the TestResult is to be shown
+ * @return 0 on success, -1 on error
+ */
+int xccdf_report_export(struct xccdf_policy_model *model, struct xccdf_result *result,
+		struct oval_agent_session **agents, const char *outfile, const char *sce_template);
+
+#endif
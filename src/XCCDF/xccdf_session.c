@@ -50,12 +50,14 @@
 #include "DS/rds_priv.h"
 #include "DS/sds_priv.h"
 #include "OVAL/results/oval_results_impl.h"
+#include "source/oscap_source_priv.h"
 #include "source/xslt_priv.h"
 #include "XCCDF/xccdf_impl.h"
 #include "XCCDF_POLICY/public/xccdf_policy.h"
 #include "XCCDF_POLICY/xccdf_policy_priv.h"
 #include "XCCDF_POLICY/xccdf_policy_model_priv.h"
 #include "item.h"
+#include "xccdf_report_priv.h"
 #include "public/xccdf_session.h"
 #include "XCCDF_POLICY/public/check_engine_plugin.h"
 
@@ -223,20 +225,23 @@ static int _xccdf_session_autonegotiate_tailoring_file(struct xccdf_session *ses
 
 static void xccdf_session_unload_check_engine_plugins(struct xccdf_session *session);
 
+static struct oscap_source *xccdf_session_get_sds_source(struct xccdf_session *session)
+{
+	if (xccdf_session_is_sds(session)) {
+		return session->source;
+	} else {
+		xmlDocPtr sds_doc = ds_sds_compose_xmlDoc_from_xccdf_source(session->source);
+		return oscap_source_new_from_xmlDoc(sds_doc, NULL);
+	}
+}
+
 static struct oscap_source* xccdf_session_create_arf_source(struct xccdf_session *session)
 {
 	if (session->oval.arf_report != NULL) {
 		return session->oval.arf_report;
 	}
 
-	struct oscap_source *sds_source = NULL;
-
-	if (xccdf_session_is_sds(session)) {
-		sds_source = session->source;
-	} else {
-		xmlDocPtr sds_doc = ds_sds_compose_xmlDoc_from_xccdf_source(session->source);
-		sds_source = oscap_source_new_from_xmlDoc(sds_doc, NULL);
-	}
+	struct oscap_source *sds_source = xccdf_session_get_sds_source(session);
 
 	session->oval.arf_report = ds_rds_create_source(sds_source, session->xccdf.result_source, session->oval.result_sources, session->oval.results_mapping, session->oval.arf_report_mapping, session->export.arf_file);
 	if (!xccdf_session_is_sds(session)) {
@@ -245,6 +250,17 @@ static struct oscap_source* xccdf_session_create_arf_source(struct xccdf_session
 	return session->oval.arf_report;
 }
 
+static int xccdf_session_write_arf(struct xccdf_session *session, const char *target_file)
+{
+	struct oscap_source *sds_source = xccdf_session_get_sds_source(session);
+
+	int ret = ds_rds_export(sds_source, session->xccdf.result_source, session->oval.result_sources, session->oval.results_mapping, session->oval.arf_report_mapping, target_file);
+	if (!xccdf_session_is_sds(session)) {
+		oscap_source_free(sds_source);
+	}
+	return ret;
+}
+
 void xccdf_session_free(struct xccdf_session *session)
 {
 	if (session == NULL)
@@ -610,7 +626,13 @@ int xccdf_session_load(struct xccdf_session *session)
 			return ret;
 		}
 	}
-	return xccdf_session_load_tailoring(session);
+	if ((ret = xccdf_session_load_tailoring(session)) != 0) {
+		return ret;
+	}
+	if (xccdf_session_is_sds(session) && (flags & XCCDF_SESSION_LOAD_XCCDF)) {
+		ds_sds_session_cache_store(session->ds.session, session->validate || ds_sds_session_cache_validated(session->ds.session));
+	}
+	return 0;
 }
 
 static int _reporter(const char *file, int line, const char *msg, void *arg)
@@ -658,6 +680,8 @@ static int _acquire_xccdf_checklist_from_tailoring(struct xccdf_session* session
 	if (ds_sds_session == NULL) {
 		return 1;
 	}
+	// The benchmark is looked up by the content of the tailoring, don't cache it
+	ds_sds_session_disable_cache(ds_sds_session);
 
 	xmlDoc *tailoring_xmlDoc = xmlCopyDoc(oscap_source_get_xmlDoc(session->xccdf.source), true);
 	struct oscap_source *tailoring_source = oscap_source_new_from_xmlDoc(tailoring_xmlDoc, NULL);
@@ -726,7 +750,16 @@ int xccdf_session_load_xccdf(struct xccdf_session *session)
 	session->xccdf.source = NULL;
 
 	if (xccdf_session_is_sds(session)) {
-		if (session->validate) {
+		char *selection = oscap_sprintf("%s\n%s\n%s\n%s\n%d",
+				session->ds.user_datastream_id ? session->ds.user_datastream_id : "",
+				session->ds.user_component_id ? session->ds.user_component_id : "",
+				session->ds.user_benchmark_id ? session->ds.user_benchmark_id : "",
+				session->tailoring.user_component_id ? session->tailoring.user_component_id : "",
+				ds_sds_session_fetch_remote_resources(xccdf_session_get_ds_sds_session(session)));
+		ds_sds_session_cache_load(xccdf_session_get_ds_sds_session(session), selection);
+		free(selection);
+
+		if (session->validate && !ds_sds_session_cache_validated(xccdf_session_get_ds_sds_session(session))) {
 			if (oscap_source_validate(session->source, _reporter, NULL)) {
 				oscap_seterr(OSCAP_EFAMILY_OSCAP, "Invalid %s (%s) content in %s",
 						oscap_document_type_to_string(oscap_source_get_scap_type(session->source)),
@@ -793,12 +826,10 @@ int xccdf_session_load_cpe(struct xccdf_session *session)
 	}
 
 	if (xccdf_session_is_sds(session)) {
-		struct ds_sds_index *sds_idx = xccdf_session_get_sds_idx(session);
-		if (sds_idx == NULL) {
+		struct oscap_string_iterator* cpe_it = ds_sds_session_get_dictionaries(xccdf_session_get_ds_sds_session(session));
+		if (cpe_it == NULL) {
 			return -1;
 		}
-		struct ds_stream_index* stream_idx = ds_sds_index_get_stream(sds_idx, xccdf_session_get_datastream_id(session));
-		struct oscap_string_iterator* cpe_it = ds_stream_index_get_dictionaries(stream_idx);
 
 		// This potentially allows us to skip yet another decompose if we are sure
 		// there are no CPE dictionaries or language models inside the datastream.
@@ -1284,7 +1315,9 @@ static int _build_xccdf_result_source(struct xccdf_session *session)
 	}
 
 	/* Build oscap_source of XCCDF TestResult only when needed */
-	if (session->export.xccdf_file != NULL || session->export.report_file != NULL || session->export.arf_file != NULL || session->export.xccdf_stig_viewer_file != NULL) {
+	/* The HTML report is generated from the exported results only by the stylesheet */
+	bool report_xslt = session->export.report_file != NULL && xccdf_report_xslt_enabled();
+	if (session->export.xccdf_file != NULL || report_xslt || session->export.arf_file != NULL || session->export.xccdf_stig_viewer_file != NULL) {
 		const struct xccdf_benchmark *benchmark = xccdf_policy_model_get_benchmark(session->xccdf.policy_model);
 
 		if (session->xccdf.result == NULL) {
@@ -1335,6 +1368,19 @@ int xccdf_session_export_xccdf(struct xccdf_session *session)
 	if (session->export.report_file == NULL)
 		return 0;
 
+	if (!xccdf_report_xslt_enabled()) {
+		if (session->xccdf.result == NULL) {
+			// Attempt to export session before evaluation
+			oscap_seterr(OSCAP_EFAMILY_OSCAP, "No XCCDF results to export.");
+			return 1;
+		}
+		int ret = xccdf_report_export(session->xccdf.policy_model, session->xccdf.result,
+				session->export.oval_results ? session->oval.agents : NULL,
+				session->export.report_file,
+				(session->export.check_engine_plugins_results ? "%.result.xml" : ""));
+		return ret == 0 ? 0 : 1;
+	}
+
 	struct oscap_source* results = session->xccdf.result_source;
 	struct oscap_source* arf = NULL;
 	if (session->export.oval_results) {
@@ -1625,6 +1671,27 @@ int xccdf_session_export_sce(struct xccdf_session *session)
 int xccdf_session_export_arf(struct xccdf_session *session)
 {
 	if (session->export.arf_file != NULL) {
+		if (session->oval.arf_report == NULL && strcmp(session->export.arf_file, "-") != 0) {
+			/* The ARF hasn't been built for the HTML report, write it
+			 * to a file as it's assembled instead of building its DOM.
+			 * The file replaces the target only if it passes the validation. */
+			char *tmp = oscap_acquire_temp_sibling(session->export.arf_file);
+			if (tmp == NULL)
+				return 1;
+			int ret = xccdf_session_write_arf(session, tmp) != 0;
+			if (ret == 0 && session->full_validation) {
+				struct oscap_source *arf_source = oscap_source_new_map_file(tmp, session->export.arf_file);
+				ret = arf_source == NULL || oscap_source_validate(arf_source, _reporter, NULL) != 0;
+				oscap_source_free(arf_source);
+			}
+			if (ret == 0)
+				ret = oscap_acquire_rename_sibling(tmp, session->export.arf_file) != 0;
+			if (ret != 0)
+				unlink(tmp);
+			free(tmp);
+			return ret;
+		}
+
 		struct oscap_source* arf_source = xccdf_session_create_arf_source(session);
 		if (arf_source == NULL) {
 			return 1;
@@ -1684,6 +1751,19 @@ unsigned int xccdf_session_get_cpe_oval_agents_count(const struct xccdf_session
 	return i;
 }
 
+void xccdf_session_get_rescan_stats(const struct xccdf_session *session, unsigned int *reused, unsigned int *probed)
+{
+	*reused = *probed = 0;
+	if (session->oval.agents == NULL)
+		return;
+	for (int i = 0; session->oval.agents[i]; i++) {
+		unsigned int agent_reused, agent_probed;
+		oval_agent_get_rescan_stats(session->oval.agents[i], &agent_reused, &agent_probed);
+		*reused += agent_reused;
+		*probed += agent_probed;
+	}
+}
+
 bool xccdf_session_contains_fail_result(const struct xccdf_session *session)
 {
 	struct xccdf_rule_result_iterator *res_it = xccdf_result_get_rule_results(session->xccdf.result);
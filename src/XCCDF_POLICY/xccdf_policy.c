@@ -52,6 +52,7 @@
 #include "common/text_priv.h"
 #include "XCCDF/result_scoring_priv.h"
 #include "xccdf_policy_resolve.h"
+#include "xccdf_policy_parallel.h"
 
 /* Macros to generate iterators, getters and setters */
 OSCAP_GETTER(struct xccdf_benchmark *, xccdf_policy_model, benchmark)
@@ -946,59 +947,108 @@ bool xccdf_policy_model_item_is_applicable(struct xccdf_policy_model *model, str
 }
 
 /**
- * Evaluate given check which is immediate child of the rule.
- * A possibe child checks will be evaluated by xccdf_policy_check_evaluate.
- * This duplication is needed to handle @multi-check correctly,
- * which is (in general) not predictable in any way.
+ * Find the check to evaluate for the rule.
+ * @param res result of the rule if it has no check to evaluate
+ * @param message message for the result or NULL
+ * @return the check or NULL if the result doesn't depend on a check
  */
-static inline int
-_xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rule *rule, struct xccdf_result *result)
+static const struct xccdf_check *
+_xccdf_policy_rule_get_check(struct xccdf_policy *policy, const struct xccdf_rule *rule, xccdf_role_t role, int *res, const char **message)
 {
-	const char* rule_id = xccdf_rule_get_id(rule);
-	const bool is_selected = xccdf_policy_is_item_selected(policy, rule_id);
-	const char *message = NULL;
-	int report = 0;
-
-	/* If policy selects only one rule and the rule currently being
-	 * evaluated is not equal to the selected rule, do not evaluate it and
-	 * mark it as notselected. */
-	if (policy->rule != NULL) {
-		if (strcmp(policy->rule, rule_id) != 0) {
-			return _xccdf_policy_report_rule_result(policy, result, rule, NULL, XCCDF_RESULT_NOT_SELECTED, NULL);
-		}
-		policy->rule_found = 1;
-	}
-	/* Otherwise start reporting */
-	report = xccdf_policy_report_cb(policy, XCCDF_POLICY_OUTCB_START, (void *) rule);
-	if (report)
-		return report;
+	const char *rule_id = xccdf_rule_get_id(rule);
 
-	struct xccdf_refine_rule_internal* r_rule = oscap_htable_get(policy->refine_rules_internal, rule_id);
-	xccdf_role_t role = xccdf_get_final_role(rule, r_rule);
+	*message = NULL;
 
-	if (!is_selected) {
+	if (!xccdf_policy_is_item_selected(policy, rule_id)) {
 		dI("Rule '%s' is not selected.", rule_id);
-		return _xccdf_policy_report_rule_result(policy, result, rule, NULL, XCCDF_RESULT_NOT_SELECTED, NULL);
+		*res = XCCDF_RESULT_NOT_SELECTED;
+		return NULL;
 	}
 
-	if (role == XCCDF_ROLE_UNCHECKED)
-		return _xccdf_policy_report_rule_result(policy, result, rule, NULL, XCCDF_RESULT_NOT_CHECKED, NULL);
+	if (role == XCCDF_ROLE_UNCHECKED) {
+		*res = XCCDF_RESULT_NOT_CHECKED;
+		return NULL;
+	}
 
 	const bool is_applicable = xccdf_policy_model_item_is_applicable(policy->model, (struct xccdf_item*)rule);
 	if (!is_applicable) {
 		dI("Rule '%s' is not applicable.", rule_id);
-		return _xccdf_policy_report_rule_result(policy, result, rule, NULL, XCCDF_RESULT_NOT_APPLICABLE, NULL);
+		*res = XCCDF_RESULT_NOT_APPLICABLE;
+		return NULL;
 	}
 
-	const struct xccdf_check *orig_check = _xccdf_policy_rule_get_applicable_check(policy, (struct xccdf_item *) rule);
-	if (orig_check == NULL)
+	const struct xccdf_check *check = _xccdf_policy_rule_get_applicable_check(policy, (struct xccdf_item *) rule);
+	if (check == NULL) {
 		// No candidate or applicable check found.
-		return _xccdf_policy_report_rule_result(policy, result, rule, NULL, XCCDF_RESULT_NOT_CHECKED, "No candidate or applicable check found.");
+		*res = XCCDF_RESULT_NOT_CHECKED;
+		*message = "No candidate or applicable check found.";
+	}
+	return check;
+}
+
+void xccdf_policy_rule_prepare(struct xccdf_policy *policy, struct xccdf_policy_rule_task *task)
+{
+	const char *rule_id = xccdf_rule_get_id(task->rule);
+	struct xccdf_refine_rule_internal* r_rule = oscap_htable_get(policy->refine_rules_internal, rule_id);
+
+	task->role = xccdf_get_final_role(task->rule, r_rule);
+	const struct xccdf_check *orig_check = _xccdf_policy_rule_get_check(policy, task->rule, task->role, &task->res, &task->message);
 
 	// we need to clone the check to avoid changing the original content
-	struct xccdf_check *check = xccdf_check_clone(orig_check);
+	task->check = orig_check != NULL ? xccdf_check_clone(orig_check) : NULL;
+}
+
+struct xccdf_policy_rule_outcome {
+	struct xccdf_check *check;
+	int res;
+	const char *message;
+};
+
+static void xccdf_policy_rule_outcome_free(struct xccdf_policy_rule_outcome *outcome)
+{
+	xccdf_check_free(outcome->check);
+	free(outcome);
+}
+
+/**
+ * Report a result of the rule, or keep it in the task if the rule
+ * is evaluated in parallel with others.
+ * @param more another result of the same rule follows
+ */
+static int _xccdf_policy_rule_outcome(struct xccdf_policy *policy, struct xccdf_result *result,
+				      struct xccdf_policy_rule_task *task, struct xccdf_check *check,
+				      int res, const char *message, bool more)
+{
+	if (task->outcomes != NULL) {
+		struct xccdf_policy_rule_outcome *outcome = malloc(sizeof(struct xccdf_policy_rule_outcome));
+		outcome->check = check;
+		outcome->res = res;
+		outcome->message = message;
+		oscap_list_add(task->outcomes, outcome);
+		return res == -1 ? -1 : 0;
+	}
+
+	int ret = _xccdf_policy_report_rule_result(policy, result, task->rule, check, res, message);
+	if (ret == 0 && more)
+		ret = xccdf_policy_report_cb(policy, XCCDF_POLICY_OUTCB_START, (void *) task->rule);
+	return ret;
+}
+
+/**
+ * Evaluate given check which is immediate child of the rule.
+ * A possibe child checks will be evaluated by xccdf_policy_check_evaluate.
+ * This duplication is needed to handle @multi-check correctly,
+ * which is (in general) not predictable in any way.
+ */
+int xccdf_policy_rule_check(struct xccdf_policy *policy, struct xccdf_result *result, struct xccdf_policy_rule_task *task)
+{
+	struct xccdf_check *check = task->check;
+	const char *message = NULL;
+	int report = 0;
+
+	task->check = NULL;
 	if (xccdf_check_get_complex(check))
-		return _xccdf_policy_report_rule_result(policy, result, rule, check, xccdf_policy_check_evaluate(policy, check), NULL);
+		return _xccdf_policy_rule_outcome(policy, result, task, check, xccdf_policy_check_evaluate(policy, check), NULL, false);
 
 	// Now we are evaluating single simple xccdf:check within xccdf:rule.
 	// Since the fact that a check will yield multi-check is not predictable in general
@@ -1009,7 +1059,7 @@ _xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rul
 	const char *system_name = xccdf_check_get_system(check);
 	struct oscap_list *bindings = xccdf_policy_check_get_value_bindings(policy, xccdf_check_get_exports(check));
 	if (bindings == NULL)
-		return _xccdf_policy_report_rule_result(policy, result, rule, check, XCCDF_RESULT_UNKNOWN, "Value bindings not found.");
+		return _xccdf_policy_rule_outcome(policy, result, task, check, XCCDF_RESULT_UNKNOWN, "Value bindings not found.", false);
 
 
 	struct xccdf_check_content_ref_iterator *content_it = xccdf_check_get_content_refs(check);
@@ -1032,7 +1082,7 @@ _xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rul
 				if (!oscap_string_iterator_has_more(name_it)) {
 					// Super special case when oval file contains no definitions
 					// thus multi-check shall yield zero rule-results.
-					report = _xccdf_policy_report_rule_result(policy, result, rule, check, XCCDF_RESULT_UNKNOWN, "No definitions found for @multi-check.");
+					report = _xccdf_policy_rule_outcome(policy, result, task, check, XCCDF_RESULT_UNKNOWN, "No definitions found for @multi-check.", false);
 					oscap_string_iterator_free(name_it);
 					oscap_stringlist_free(names);
 					xccdf_check_content_ref_iterator_free(content_it);
@@ -1049,11 +1099,9 @@ _xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rul
 						report = inner_ret;
 						break;
 					}
-					if ((report = _xccdf_policy_report_rule_result(policy, result, rule, cloned_check, inner_ret, NULL)) != 0)
+					if ((report = _xccdf_policy_rule_outcome(policy, result, task, cloned_check, inner_ret, NULL,
+										 oscap_string_iterator_has_more(name_it))) != 0)
 						break;
-					if (oscap_string_iterator_has_more(name_it))
-						if ((report = xccdf_policy_report_cb(policy, XCCDF_POLICY_OUTCB_START, (void *) rule)) != 0)
-							break;
 				}
 				oscap_string_iterator_free(name_it);
 				oscap_stringlist_free(names);
@@ -1082,14 +1130,71 @@ _xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rul
 	if ((xccdf_test_result_type_t) ret == XCCDF_RESULT_NOT_CHECKED)
 		message = "None of the check-content-ref elements was resolvable.";
 
-	if (role == XCCDF_ROLE_UNSCORED)
+	if (task->role == XCCDF_ROLE_UNSCORED)
 		ret = XCCDF_RESULT_INFORMATIONAL;
 
 	xccdf_check_content_ref_iterator_free(content_it);
 	oscap_list_free(bindings, (oscap_destruct_func) xccdf_value_binding_free);
 	/* Negate only once */
 	ret = _resolve_negate(ret, check);
-	return _xccdf_policy_report_rule_result(policy, result, rule, check, ret, message);
+	return _xccdf_policy_rule_outcome(policy, result, task, check, ret, message, false);
+}
+
+int xccdf_policy_rule_report(struct xccdf_policy *policy, struct xccdf_result *result, struct xccdf_policy_rule_task *task)
+{
+	int ret = 0;
+
+	if (task->outcomes == NULL)
+		return _xccdf_policy_report_rule_result(policy, result, task->rule, NULL, task->res, task->message);
+
+	struct oscap_iterator *it = oscap_iterator_new(task->outcomes);
+	while (ret == 0 && oscap_iterator_has_more(it)) {
+		struct xccdf_policy_rule_outcome *outcome = oscap_iterator_next(it);
+		ret = _xccdf_policy_report_rule_result(policy, result, task->rule, outcome->check, outcome->res, outcome->message);
+		// the check belongs to the rule-result now
+		if (outcome->res != -1)
+			outcome->check = NULL;
+		if (ret == 0 && oscap_iterator_has_more(it))
+			ret = xccdf_policy_report_cb(policy, XCCDF_POLICY_OUTCB_START, (void *) task->rule);
+	}
+	oscap_iterator_free(it);
+	return ret;
+}
+
+void xccdf_policy_rule_task_clear(struct xccdf_policy_rule_task *task)
+{
+	xccdf_check_free(task->check);
+	task->check = NULL;
+	oscap_list_free(task->outcomes, (oscap_destruct_func) xccdf_policy_rule_outcome_free);
+	task->outcomes = NULL;
+}
+
+static inline int
+_xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rule *rule, struct xccdf_result *result)
+{
+	const char* rule_id = xccdf_rule_get_id(rule);
+	struct xccdf_policy_rule_task task = { .rule = rule, .outcomes = NULL };
+	int report = 0;
+
+	/* If policy selects only one rule and the rule currently being
+	 * evaluated is not equal to the selected rule, do not evaluate it and
+	 * mark it as notselected. */
+	if (policy->rule != NULL) {
+		if (strcmp(policy->rule, rule_id) != 0) {
+			return _xccdf_policy_report_rule_result(policy, result, rule, NULL, XCCDF_RESULT_NOT_SELECTED, NULL);
+		}
+		policy->rule_found = 1;
+	}
+	/* Otherwise start reporting */
+	report = xccdf_policy_report_cb(policy, XCCDF_POLICY_OUTCB_START, (void *) rule);
+	if (report)
+		return report;
+
+	xccdf_policy_rule_prepare(policy, &task);
+	if (task.check == NULL)
+		return _xccdf_policy_report_rule_result(policy, result, rule, NULL, task.res, task.message);
+
+	return xccdf_policy_rule_check(policy, result, &task);
 }
 
 /** 
@@ -1135,6 +1240,127 @@ static int xccdf_policy_item_evaluate(struct xccdf_policy * policy, struct xccdf
     return ret;
 }
 
+/**
+ * Names of the check contents of one href used by the rules to be evaluated.
+ */
+struct xccdf_policy_collect_href {
+	const char *system;
+	struct oscap_stringlist *names;         ///< The href followed by the names
+};
+
+static void _xccdf_policy_collect_href_free(struct xccdf_policy_collect_href *entry)
+{
+	oscap_stringlist_free(entry->names);
+	free(entry);
+}
+
+static void _xccdf_policy_collect_check(struct xccdf_policy *policy, const struct xccdf_check *check, struct oscap_htable *hrefs)
+{
+	if (xccdf_check_get_complex(check)) {
+		// all children of a complex check are evaluated
+		struct xccdf_check_iterator *child_it = xccdf_check_get_children(check);
+		while (xccdf_check_iterator_has_more(child_it))
+			_xccdf_policy_collect_check(policy, xccdf_check_iterator_next(child_it), hrefs);
+		xccdf_check_iterator_free(child_it);
+		return;
+	}
+
+	// The content references are alternatives, only the first one is
+	// collected. The evaluation queries the data of the others itself.
+	struct xccdf_check_content_ref_iterator *content_it = xccdf_check_get_content_refs(check);
+	struct xccdf_check_content_ref *content = xccdf_check_content_ref_iterator_has_more(content_it) ?
+		xccdf_check_content_ref_iterator_next(content_it) : NULL;
+	xccdf_check_content_ref_iterator_free(content_it);
+
+	const char *system_name = xccdf_check_get_system(check);
+	const char *href = content != NULL ? xccdf_check_content_ref_get_href(content) : NULL;
+	if (system_name == NULL || href == NULL)
+		return;
+
+	struct xccdf_policy_collect_href *entry = oscap_htable_get(hrefs, href);
+	if (entry == NULL) {
+		entry = malloc(sizeof(struct xccdf_policy_collect_href));
+		entry->system = system_name;
+		entry->names = oscap_stringlist_new();
+		oscap_stringlist_add_string(entry->names, href);
+		oscap_htable_add(hrefs, href, entry);
+	}
+
+	const char *content_name = xccdf_check_content_ref_get_name(content);
+	if (content_name != NULL) {
+		oscap_stringlist_add_string(entry->names, content_name);
+		return;
+	}
+
+	// multi-check or the whole content
+	struct oscap_stringlist *names = _xccdf_policy_get_namesfor_href(policy, system_name, href);
+	if (names == NULL)
+		return;
+	struct oscap_string_iterator *name_it = oscap_stringlist_get_strings(names);
+	while (oscap_string_iterator_has_more(name_it))
+		oscap_stringlist_add_string(entry->names, oscap_string_iterator_next(name_it));
+	oscap_string_iterator_free(name_it);
+	oscap_stringlist_free(names);
+}
+
+static void _xccdf_policy_collect_item(struct xccdf_policy *policy, struct xccdf_item *item, struct oscap_htable *hrefs)
+{
+	switch (xccdf_item_get_type(item)) {
+	case XCCDF_RULE:{
+		const struct xccdf_rule *rule = (const struct xccdf_rule *) item;
+		const char *rule_id = xccdf_rule_get_id(rule);
+		if (policy->rule != NULL && strcmp(policy->rule, rule_id) != 0)
+			break;
+
+		struct xccdf_refine_rule_internal *r_rule = oscap_htable_get(policy->refine_rules_internal, rule_id);
+		const char *message;
+		int res;
+		const struct xccdf_check *check = _xccdf_policy_rule_get_check(policy, rule, xccdf_get_final_role(rule, r_rule), &res, &message);
+		if (check != NULL)
+			_xccdf_policy_collect_check(policy, check, hrefs);
+	} break;
+
+	case XCCDF_GROUP:{
+		struct xccdf_item_iterator *child_it = xccdf_group_get_content((const struct xccdf_group *) item);
+		while (xccdf_item_iterator_has_more(child_it))
+			_xccdf_policy_collect_item(policy, xccdf_item_iterator_next(child_it), hrefs);
+		xccdf_item_iterator_free(child_it);
+	} break;
+
+	default:
+		break;
+	}
+}
+
+/**
+ * Let the checking engines collect the system data of the checks of all
+ * rules to be evaluated. An engine can collect the data of different checks
+ * at the same time, the rules are then evaluated one by one in document order.
+ */
+static void xccdf_policy_collect(struct xccdf_policy *policy, struct xccdf_benchmark *benchmark)
+{
+	struct oscap_htable *hrefs = oscap_htable_new();
+
+	struct xccdf_item_iterator *item_it = xccdf_benchmark_get_content(benchmark);
+	while (xccdf_item_iterator_has_more(item_it))
+		_xccdf_policy_collect_item(policy, xccdf_item_iterator_next(item_it), hrefs);
+	xccdf_item_iterator_free(item_it);
+
+	struct oscap_htable_iterator *hit = oscap_htable_iterator_new(hrefs);
+	while (oscap_htable_iterator_has_more(hit)) {
+		struct xccdf_policy_collect_href *entry = oscap_htable_iterator_next_value(hit);
+		struct oscap_iterator *cb_it = _xccdf_policy_get_engines_by_sysname(policy, entry->system);
+		while (oscap_iterator_has_more(cb_it)) {
+			struct xccdf_policy_engine *engine = (struct xccdf_policy_engine *) oscap_iterator_next(cb_it);
+			xccdf_policy_engine_query(engine, POLICY_ENGINE_QUERY_COLLECT_NAMES, entry->names);
+		}
+		oscap_iterator_free(cb_it);
+	}
+	oscap_htable_iterator_free(hit);
+
+	oscap_htable_free(hrefs, (oscap_destruct_func) _xccdf_policy_collect_href_free);
+}
+
 struct oscap_file_entry {
 	char* system_name;
 	char* file;
@@ -2038,21 +2264,32 @@ struct xccdf_result * xccdf_policy_evaluate(struct xccdf_policy * policy)
 
     free(id);
 
+	xccdf_policy_collect(policy, benchmark);
+
 	/** We need to process document top-down order.
 	 * See conflicts/requires and Item Processing Algorithm */
-	struct xccdf_item_iterator *item_it = xccdf_benchmark_get_content(benchmark);
-	while (xccdf_item_iterator_has_more(item_it)) {
-		struct xccdf_item *item = xccdf_item_iterator_next(item_it);
-		ret = xccdf_policy_item_evaluate(policy, item, result);
+	const size_t thread_count = xccdf_policy_parallel_threads();
+	if (thread_count > 0) {
+		ret = xccdf_policy_evaluate_parallel(policy, result, thread_count);
 		if (ret == -1) {
-			xccdf_item_iterator_free(item_it);
 			xccdf_result_free(result);
 			return NULL;
 		}
-		if (ret != 0)
-			break;
+	} else {
+		struct xccdf_item_iterator *item_it = xccdf_benchmark_get_content(benchmark);
+		while (xccdf_item_iterator_has_more(item_it)) {
+			struct xccdf_item *item = xccdf_item_iterator_next(item_it);
+			ret = xccdf_policy_item_evaluate(policy, item, result);
+			if (ret == -1) {
+				xccdf_item_iterator_free(item_it);
+				xccdf_result_free(result);
+				return NULL;
+			}
+			if (ret != 0)
+				break;
+		}
+		xccdf_item_iterator_free(item_it);
 	}
-	xccdf_item_iterator_free(item_it);
 
 	if (policy->rule != NULL && !policy->rule_found) {
 		oscap_seterr(OSCAP_EFAMILY_XCCDF,
@@ -2243,6 +2480,7 @@ struct xccdf_benchmark *xccdf_policy_get_benchmark(const struct xccdf_policy *po
 
 void xccdf_policy_model_free(struct xccdf_policy_model * model) {
 
+	xccdf_policy_pool_free(model->pool);
 	oscap_list_free(model->policies, (oscap_destruct_func) xccdf_policy_free);
 	xccdf_policy_model_unregister_engines(model, NULL);
 	oscap_list_free(model->callbacks, (oscap_destruct_func) free);
@@ -29,6 +29,13 @@
 #include "common/list.h"
 #include "public/xccdf_policy.h"
 
+/**
+ * Query used by the policy only, it isn't a part of the public xccdf_policy_engine_query_t:
+ * collect the system data for given @name attributes of an href before they are evaluated.
+ * The query data is a (struct oscap_stringlist *) of the href followed by the names, NULL
+ * is returned. Engines which don't know the query return NULL as for any unknown query.
+ */
+#define POLICY_ENGINE_QUERY_COLLECT_NAMES ((xccdf_policy_engine_query_t) 2)
 
 /**
  * Typedef of callback structure with system identificator, callback function and usr data (optional)
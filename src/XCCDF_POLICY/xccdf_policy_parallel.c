@@ -0,0 +1,445 @@
+/*
+ * Copyright 2015 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "xccdf_policy_parallel.h"
+#include "xccdf_policy_model_priv.h"
+#include "public/xccdf_benchmark.h"
+#include "public/oscap_text.h"
+#include "common/list.h"
+#include "common/util.h"
+#include "common/_error.h"
+#include "common/debug_priv.h"
+
+/* Checks of these systems share the state of their href only: the session
+ * of an OVAL file or the script run by SCE */
+#define XCCDF_POLICY_OVAL_SYSTEM "http://oval.mitre.org/XMLSchema/oval-definitions-5"
+#define XCCDF_POLICY_SCE_SYSTEM "http://open-scap.org/page/SCE"
+
+struct xccdf_policy_eval_task {
+	struct xccdf_policy_rule_task base;
+	bool report;                   /* call the callbacks, false if the policy selects another rule */
+	bool evaluate;                 /* the check is evaluated by the pool */
+	bool running;
+	bool done;
+	int ret;                       /* value returned by xccdf_policy_rule_check() */
+	oscap_errfamily_t err_family;
+	char *err;                     /* error set while evaluating the check */
+	size_t *deps;                  /* preceding tasks which have to be done first */
+	size_t dep_count;
+};
+
+struct xccdf_policy_eval {
+	struct xccdf_policy *policy;
+	struct xccdf_policy_eval_task *tasks;  /* in document order */
+	size_t count;
+	size_t alloc;
+	size_t next;                   /* tasks before this one are started */
+	size_t running;
+	bool stop;
+};
+
+struct xccdf_policy_pool {
+	pthread_mutex_t lock;
+	pthread_cond_t work;           /* a task may be ready or the pool is freed */
+	pthread_cond_t done;           /* a task is done */
+	pthread_t *threads;
+	size_t thread_count;
+	bool shutdown;
+	struct xccdf_policy_eval *eval;  /* evaluation in progress or NULL */
+};
+
+/* Range of the tasks of an item */
+struct xccdf_policy_eval_range {
+	size_t first;
+	size_t last;
+};
+
+size_t xccdf_policy_parallel_threads(void)
+{
+	const char *env = getenv(XCCDF_POLICY_THREADS_ENV);
+	unsigned long count;
+
+	if (env == NULL)
+		return 0;
+
+	count = strtoul(env, NULL, 10);
+	return count < 2 ? 0 : count;
+}
+
+static void xccdf_policy_eval_add_rule(struct xccdf_policy_eval *eval, const struct xccdf_rule *rule)
+{
+	struct xccdf_policy *policy = eval->policy;
+	const char *rule_id = xccdf_rule_get_id(rule);
+
+	if (eval->count == eval->alloc) {
+		eval->alloc = eval->alloc == 0 ? 64 : eval->alloc * 2;
+		eval->tasks = realloc(eval->tasks, sizeof(struct xccdf_policy_eval_task) * eval->alloc);
+	}
+
+	struct xccdf_policy_eval_task *task = eval->tasks + eval->count++;
+	memset(task, 0, sizeof(struct xccdf_policy_eval_task));
+	task->base.rule = rule;
+
+	/* See _xccdf_policy_rule_evaluate() */
+	if (policy->rule != NULL) {
+		if (strcmp(policy->rule, rule_id) != 0) {
+			task->base.res = XCCDF_RESULT_NOT_SELECTED;
+			return;
+		}
+		policy->rule_found = 1;
+	}
+
+	task->report = true;
+	xccdf_policy_rule_prepare(policy, &task->base);
+	if (task->base.check != NULL) {
+		task->evaluate = true;
+		task->base.outcomes = oscap_list_new();
+	}
+}
+
+static void xccdf_policy_eval_add_item(struct xccdf_policy_eval *eval, struct oscap_htable *ranges, struct xccdf_item *item)
+{
+	struct xccdf_policy_eval_range *range = malloc(sizeof(struct xccdf_policy_eval_range));
+
+	range->first = eval->count;
+
+	switch (xccdf_item_get_type(item)) {
+	case XCCDF_RULE:
+		xccdf_policy_eval_add_rule(eval, (const struct xccdf_rule *) item);
+		break;
+	case XCCDF_GROUP:{
+		struct xccdf_item_iterator *child_it = xccdf_group_get_content((const struct xccdf_group *) item);
+		while (xccdf_item_iterator_has_more(child_it))
+			xccdf_policy_eval_add_item(eval, ranges, xccdf_item_iterator_next(child_it));
+		xccdf_item_iterator_free(child_it);
+		break;
+	}
+	default:
+		break;
+	}
+
+	range->last = eval->count;
+	if (!oscap_htable_add(ranges, xccdf_item_get_id(item), range))
+		free(range);
+}
+
+/**
+ * Make the later one of two tasks wait for the other one.
+ */
+static void xccdf_policy_eval_add_dep(struct xccdf_policy_eval *eval, size_t a, size_t b)
+{
+	size_t later = a > b ? a : b;
+	size_t earlier = a > b ? b : a;
+	struct xccdf_policy_eval_task *task = eval->tasks + later;
+
+	if (a == b || !task->evaluate || !eval->tasks[earlier].evaluate)
+		return;
+
+	task->deps = realloc(task->deps, sizeof(size_t) * (task->dep_count + 1));
+	task->deps[task->dep_count++] = earlier;
+}
+
+/**
+ * Get the keys of the engine states used by the check.
+ */
+static void xccdf_policy_eval_get_lanes(struct xccdf_check *check, struct oscap_stringlist *lanes)
+{
+	if (xccdf_check_get_complex(check)) {
+		struct xccdf_check_iterator *child_it = xccdf_check_get_children(check);
+		while (xccdf_check_iterator_has_more(child_it))
+			xccdf_policy_eval_get_lanes(xccdf_check_iterator_next(child_it), lanes);
+		xccdf_check_iterator_free(child_it);
+		return;
+	}
+
+	const char *system = xccdf_check_get_system(check);
+	if (system == NULL || (strcmp(system, XCCDF_POLICY_OVAL_SYSTEM) != 0 && strcmp(system, XCCDF_POLICY_SCE_SYSTEM) != 0)) {
+		oscap_stringlist_add_string(lanes, system != NULL ? system : "");
+		return;
+	}
+
+	struct xccdf_check_content_ref_iterator *content_it = xccdf_check_get_content_refs(check);
+	while (xccdf_check_content_ref_iterator_has_more(content_it)) {
+		const char *href = xccdf_check_content_ref_get_href(xccdf_check_content_ref_iterator_next(content_it));
+		char *lane = oscap_sprintf("%s %s", system, href != NULL ? href : "");
+		oscap_stringlist_add_string(lanes, lane);
+		free(lane);
+	}
+	xccdf_check_content_ref_iterator_free(content_it);
+}
+
+static void xccdf_policy_eval_link(struct xccdf_policy_eval *eval, struct oscap_htable *ranges, size_t i, const char *id)
+{
+	struct xccdf_policy_eval_range *range = oscap_htable_get(ranges, id);
+
+	if (range == NULL)
+		return;
+
+	for (size_t j = range->first; j < range->last; ++j)
+		xccdf_policy_eval_add_dep(eval, i, j);
+}
+
+/**
+ * Find the tasks each task has to wait for.
+ */
+static void xccdf_policy_eval_schedule(struct xccdf_policy_eval *eval, struct oscap_htable *ranges)
+{
+	struct oscap_htable *lanes = oscap_htable_new();
+
+	for (size_t i = 0; i < eval->count; ++i) {
+		struct xccdf_policy_eval_task *task = eval->tasks + i;
+
+		if (!task->evaluate)
+			continue;
+
+		struct oscap_stringlist *keys = oscap_stringlist_new();
+		xccdf_policy_eval_get_lanes(task->base.check, keys);
+
+		struct oscap_string_iterator *key_it = oscap_stringlist_get_strings(keys);
+		while (oscap_string_iterator_has_more(key_it)) {
+			const char *key = oscap_string_iterator_next(key_it);
+			size_t *last = oscap_htable_get(lanes, key);
+
+			if (last == NULL) {
+				last = malloc(sizeof(size_t));
+				oscap_htable_add(lanes, key, last);
+			} else
+				xccdf_policy_eval_add_dep(eval, i, *last);
+			*last = i;
+		}
+		oscap_string_iterator_free(key_it);
+		oscap_stringlist_free(keys);
+
+		struct oscap_stringlist_iterator *requires_it = xccdf_rule_get_requires(task->base.rule);
+		while (oscap_stringlist_iterator_has_more(requires_it)) {
+			struct oscap_string_iterator *id_it = oscap_stringlist_get_strings(oscap_stringlist_iterator_next(requires_it));
+			while (oscap_string_iterator_has_more(id_it))
+				xccdf_policy_eval_link(eval, ranges, i, oscap_string_iterator_next(id_it));
+			oscap_string_iterator_free(id_it);
+		}
+		oscap_stringlist_iterator_free(requires_it);
+
+		struct oscap_string_iterator *conflicts_it = xccdf_rule_get_conflicts(task->base.rule);
+		while (oscap_string_iterator_has_more(conflicts_it))
+			xccdf_policy_eval_link(eval, ranges, i, oscap_string_iterator_next(conflicts_it));
+		oscap_string_iterator_free(conflicts_it);
+	}
+
+	oscap_htable_free(lanes, (oscap_destruct_func) free);
+}
+
+/**
+ * Find the first task which can be evaluated. Called with the pool locked.
+ */
+static struct xccdf_policy_eval_task *xccdf_policy_eval_pick(struct xccdf_policy_eval *eval)
+{
+	while (eval->next < eval->count && (!eval->tasks[eval->next].evaluate ||
+		eval->tasks[eval->next].running || eval->tasks[eval->next].done))
+		++eval->next;
+
+	for (size_t i = eval->next; i < eval->count && !eval->stop; ++i) {
+		struct xccdf_policy_eval_task *task = eval->tasks + i;
+		size_t d;
+
+		if (!task->evaluate || task->running || task->done)
+			continue;
+
+		for (d = 0; d < task->dep_count; ++d)
+			if (!eval->tasks[task->deps[d]].done)
+				break;
+
+		if (d == task->dep_count)
+			return task;
+	}
+
+	return NULL;
+}
+
+static void *xccdf_policy_pool_worker(void *arg)
+{
+	struct xccdf_policy_pool *pool = (struct xccdf_policy_pool *) arg;
+
+	pthread_mutex_lock(&pool->lock);
+
+	while (!pool->shutdown) {
+		struct xccdf_policy_eval *eval = pool->eval;
+		struct xccdf_policy_eval_task *task = eval != NULL ? xccdf_policy_eval_pick(eval) : NULL;
+
+		if (task == NULL) {
+			pthread_cond_wait(&pool->work, &pool->lock);
+			continue;
+		}
+
+		task->running = true;
+		++eval->running;
+		pthread_mutex_unlock(&pool->lock);
+
+		dI("Evaluating XCCDF rule '%s'.", xccdf_rule_get_id(task->base.rule));
+		task->ret = xccdf_policy_rule_check(eval->policy, NULL, &task->base);
+		/* errors are thread specific, the evaluating thread sets them again */
+		if (oscap_err()) {
+			task->err_family = oscap_err_family();
+			task->err = oscap_err_get_full_error();
+		}
+
+		pthread_mutex_lock(&pool->lock);
+		task->running = false;
+		task->done = true;
+		--eval->running;
+		pthread_cond_broadcast(&pool->done);
+		pthread_cond_broadcast(&pool->work);
+	}
+
+	pthread_mutex_unlock(&pool->lock);
+	return NULL;
+}
+
+/**
+ * Get the pool of the policy model, start the threads if there are not
+ * enough of them. The threads are kept until the model is freed; a probe
+ * is terminated when the thread that started it exits and the checking
+ * engines keep the probes for later evaluations.
+ */
+static struct xccdf_policy_pool *xccdf_policy_pool_get(struct xccdf_policy_model *model, size_t thread_count)
+{
+	struct xccdf_policy_pool *pool = model->pool;
+
+	if (pool == NULL) {
+		pool = calloc(1, sizeof(struct xccdf_policy_pool));
+		pthread_mutex_init(&pool->lock, NULL);
+		pthread_cond_init(&pool->work, NULL);
+		pthread_cond_init(&pool->done, NULL);
+		model->pool = pool;
+	}
+
+	if (pool->thread_count < thread_count)
+		pool->threads = realloc(pool->threads, sizeof(pthread_t) * thread_count);
+
+	while (pool->thread_count < thread_count) {
+		if (pthread_create(pool->threads + pool->thread_count, NULL, &xccdf_policy_pool_worker, pool) != 0) {
+			dW("Can't create an evaluation thread: %u, %s.", errno, strerror(errno));
+			break;
+		}
+		++pool->thread_count;
+	}
+
+	return pool->thread_count > 0 ? pool : NULL;
+}
+
+void xccdf_policy_pool_free(struct xccdf_policy_pool *pool)
+{
+	if (pool == NULL)
+		return;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->shutdown = true;
+	pthread_cond_broadcast(&pool->work);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (size_t i = 0; i < pool->thread_count; ++i)
+		pthread_join(pool->threads[i], NULL);
+
+	pthread_cond_destroy(&pool->done);
+	pthread_cond_destroy(&pool->work);
+	pthread_mutex_destroy(&pool->lock);
+	free(pool->threads);
+	free(pool);
+}
+
+int xccdf_policy_evaluate_parallel(struct xccdf_policy *policy, struct xccdf_result *result, size_t thread_count)
+{
+	struct xccdf_policy_eval eval;
+	struct xccdf_policy_pool *pool;
+	struct oscap_htable *ranges = oscap_htable_new();
+	struct xccdf_benchmark *benchmark = xccdf_policy_model_get_benchmark(xccdf_policy_get_model(policy));
+	int ret = 0;
+
+	memset(&eval, 0, sizeof(struct xccdf_policy_eval));
+	eval.policy = policy;
+
+	struct xccdf_item_iterator *item_it = xccdf_benchmark_get_content(benchmark);
+	while (xccdf_item_iterator_has_more(item_it))
+		xccdf_policy_eval_add_item(&eval, ranges, xccdf_item_iterator_next(item_it));
+	xccdf_item_iterator_free(item_it);
+
+	xccdf_policy_eval_schedule(&eval, ranges);
+	oscap_htable_free(ranges, (oscap_destruct_func) free);
+
+	pool = xccdf_policy_pool_get(policy->model, thread_count);
+	if (pool != NULL) {
+		dI("Evaluating %zu XCCDF rules using %zu threads.", eval.count, pool->thread_count);
+		pthread_mutex_lock(&pool->lock);
+		pool->eval = &eval;
+		pthread_cond_broadcast(&pool->work);
+		pthread_mutex_unlock(&pool->lock);
+	}
+
+	/* Report the rules in document order as their checks are done */
+	for (size_t i = 0; i < eval.count && ret == 0; ++i) {
+		struct xccdf_policy_eval_task *task = eval.tasks + i;
+
+		if (task->evaluate) {
+			if (pool != NULL) {
+				pthread_mutex_lock(&pool->lock);
+				while (!task->done)
+					pthread_cond_wait(&pool->done, &pool->lock);
+				pthread_mutex_unlock(&pool->lock);
+			} else
+				task->ret = xccdf_policy_rule_check(policy, NULL, &task->base);
+
+			if (task->err != NULL)
+				oscap_seterr(task->err_family, "%s", task->err);
+		}
+
+		if (task->report && (ret = xccdf_policy_report_cb(policy, XCCDF_POLICY_OUTCB_START, (void *) task->base.rule)) != 0)
+			break;
+
+		ret = xccdf_policy_rule_report(policy, result, &task->base);
+		if (ret == 0 && task->ret == -1)
+			ret = -1;
+	}
+
+	if (pool != NULL) {
+		pthread_mutex_lock(&pool->lock);
+		eval.stop = true;
+		while (eval.running > 0)
+			pthread_cond_wait(&pool->done, &pool->lock);
+		pool->eval = NULL;
+		pthread_mutex_unlock(&pool->lock);
+	}
+
+	for (size_t i = 0; i < eval.count; ++i) {
+		xccdf_policy_rule_task_clear(&eval.tasks[i].base);
+		free(eval.tasks[i].deps);
+		free(eval.tasks[i].err);
+	}
+	free(eval.tasks);
+
+	return ret;
+}
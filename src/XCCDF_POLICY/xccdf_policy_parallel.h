@@ -0,0 +1,70 @@
+/*
+ * Copyright 2015 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef XCCDF_POLICY_PARALLEL_H_
+#define XCCDF_POLICY_PARALLEL_H_
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stddef.h>
+#include "xccdf_policy_priv.h"
+
+/*
+ * Parallel evaluation of rules
+ *
+ * When OSCAP_XCCDF_EVAL_THREADS is set to a number greater than one, the
+ * rules are collected in document order first and their checks are then
+ * evaluated by a pool of threads owned by the policy model. Checks sharing
+ * the state of a checking engine are evaluated one after another in document
+ * order: checks of one OVAL file share a session, checks running one SCE
+ * script share the script and checks of any other system share its engine.
+ * The OVAL objects of all rules are collected before the pool starts, see
+ * POLICY_ENGINE_QUERY_COLLECT_NAMES, so the checks of one OVAL file only
+ * evaluate the collected items one after another. A rule requiring or conflicting with other rules
+ * is evaluated after the ones preceding it. The callbacks are called and the
+ * rule-results are added to the test result by the evaluating thread in
+ * document order, so the result is the same as the one of the sequential
+ * evaluation.
+ */
+#define XCCDF_POLICY_THREADS_ENV "OSCAP_XCCDF_EVAL_THREADS"
+
+struct xccdf_policy_pool;
+
+/**
+ * Get the number of threads to evaluate the rules with.
+ * @return 0 if the rules are to be evaluated sequentially
+ */
+size_t xccdf_policy_parallel_threads(void);
+
+/**
+ * Evaluate all rules of the benchmark using the thread pool of the policy model.
+ * @return 0 on success, -1 on error or the value returned by a callback
+ */
+int xccdf_policy_evaluate_parallel(struct xccdf_policy *policy, struct xccdf_result *result, size_t thread_count);
+
+/**
+ * Stop the threads of the pool. The probes started by checks evaluated
+ * in the pool are terminated together with the threads.
+ */
+void xccdf_policy_pool_free(struct xccdf_policy_pool *pool);
+
+#endif
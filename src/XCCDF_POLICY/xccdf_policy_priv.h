@@ -44,6 +44,7 @@ struct xccdf_policy_model {
 	struct oscap_list       * engines;      ///< Callbacks for checking engines (see xccdf_policy_engine)
 
 	struct cpe_session *cpe;
+	struct xccdf_policy_pool *pool;         ///< Threads evaluating rules in parallel or NULL
 };
 
 /**
@@ -109,6 +110,41 @@ int xccdf_policy_rule_result_remediate(struct xccdf_policy *policy, struct xccdf
  */
 int xccdf_policy_check_evaluate(struct xccdf_policy * policy, struct xccdf_check * check);
 
+/**
+ * Rule being evaluated, the evaluation is split into steps so that
+ * the checks of multiple rules can be evaluated in parallel.
+ */
+struct xccdf_policy_rule_task {
+	const struct xccdf_rule *rule;
+	xccdf_role_t role;
+	struct xccdf_check *check;      ///< Check to evaluate or NULL if the result doesn't depend on a check
+	int res;                        ///< Result of the rule if there's no check to evaluate
+	const char *message;            ///< Message for the result if there's no check to evaluate
+	struct oscap_list *outcomes;    ///< Results of the check kept for later reporting, NULL to report them immediately
+};
+
+/**
+ * Resolve the selection, role and applicability of the rule and find its check.
+ * Either sets the check of the task or its result.
+ */
+void xccdf_policy_rule_prepare(struct xccdf_policy *policy, struct xccdf_policy_rule_task *task);
+
+/**
+ * Evaluate the check of a prepared rule and report the results to the callbacks
+ * or keep them in the outcomes of the task.
+ * @return 0 to continue, -1 on error or the value returned by a callback
+ */
+int xccdf_policy_rule_check(struct xccdf_policy *policy, struct xccdf_result *result, struct xccdf_policy_rule_task *task);
+
+/**
+ * Report the results of a rule evaluated by xccdf_policy_rule_check() with kept outcomes,
+ * or the result resolved by xccdf_policy_rule_prepare().
+ * @return 0 to continue, -1 on error or the value returned by a callback
+ */
+int xccdf_policy_rule_report(struct xccdf_policy *policy, struct xccdf_result *result, struct xccdf_policy_rule_task *task);
+
+void xccdf_policy_rule_task_clear(struct xccdf_policy_rule_task *task);
+
 /**
  * Remediate all rule-results in the given result, with settings of given policy.
  * @memberof xccdf_policy
@@ -31,6 +31,8 @@
 #include <ctype.h>
 #include <errno.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <limits.h>
 
 #include "debug_priv.h"
 #include "memusage.h"
@@ -172,6 +174,107 @@ struct stat_parser __proc_stat_ptable[] = {
 	stat_sizet_field("VmStk",  struct proc_memusage, mu_stack),
 };
 
+/*
+ * Find the directory of the unified (v2) cgroup hierarchy
+ * the current process belongs to.
+ */
+static int read_cgroup_dir(char *dir, size_t dir_size)
+{
+	FILE *fp;
+	char linebuf[PATH_MAX];
+	int ret = -1;
+
+	fp = fopen(MEMUSAGE_LINUX_CGROUP_SELF, "r");
+
+	if (fp == NULL)
+		return (-1);
+
+	while (fgets(linebuf, sizeof linebuf, fp) != NULL) {
+		char *nl;
+
+		if (strncmp(linebuf, "0::", 3) != 0)
+			continue;
+
+		nl = strchr(linebuf, '\n');
+
+		if (nl != NULL)
+			*nl = '\0';
+
+		if ((size_t)snprintf(dir, dir_size, "%s%s",
+		                     MEMUSAGE_LINUX_CGROUP_ROOT, linebuf + 3) < dir_size)
+			ret = 0;
+
+		break;
+	}
+
+	fclose(fp);
+	return (ret);
+}
+
+/*
+ * Read a single value (in bytes) from a cgroup control file and
+ * store it in kB. The value "max" is stored as 0.
+ */
+static int read_cgroup_value(const char *dir, const char *name, size_t *value)
+{
+	FILE *fp;
+	char path[PATH_MAX];
+	char linebuf[64];
+	int ret = -1;
+
+	if ((size_t)snprintf(path, sizeof path, "%s/%s", dir, name) >= sizeof path)
+		return (-1);
+
+	fp = fopen(path, "r");
+
+	if (fp == NULL)
+		return (-1);
+
+	if (fgets(linebuf, sizeof linebuf, fp) != NULL) {
+		if (strncmp(linebuf, "max", 3) == 0) {
+			*value = 0;
+			ret = 0;
+		} else if (isdigit(linebuf[0])) {
+			*value = (size_t)(strtoull(linebuf, NULL, 10) / 1024);
+			ret = 0;
+		}
+	}
+
+	fclose(fp);
+	return (ret);
+}
+
+/*
+ * Read the amount of page cache charged to the cgroup (the "file" key
+ * in memory.stat). Page cache is reclaimable, so it is not counted as used.
+ */
+static int read_cgroup_file_usage(const char *dir, size_t *value)
+{
+	FILE *fp;
+	char path[PATH_MAX];
+	char linebuf[256];
+	int ret = -1;
+
+	if ((size_t)snprintf(path, sizeof path, "%s/memory.stat", dir) >= sizeof path)
+		return (-1);
+
+	fp = fopen(path, "r");
+
+	if (fp == NULL)
+		return (-1);
+
+	while (fgets(linebuf, sizeof linebuf, fp) != NULL) {
+		if (strncmp(linebuf, "file ", 5) == 0) {
+			*value = (size_t)(strtoull(linebuf + 5, NULL, 10) / 1024);
+			ret = 0;
+			break;
+		}
+	}
+
+	fclose(fp);
+	return (ret);
+}
+
 #endif /* __linux__ */
 
 int oscap_sys_memusage(struct sys_memusage *mu)
@@ -211,3 +314,28 @@ int oscap_proc_memusage(struct proc_memusage *mu)
 #endif
 	return 0;
 }
+
+int oscap_cgroup_memusage(struct cgroup_memusage *mu)
+{
+	if (mu == NULL)
+		return -1;
+#if defined(__linux__)
+	char dir[PATH_MAX];
+
+	if (read_cgroup_dir(dir, sizeof dir) != 0)
+		return -1;
+
+	if (read_cgroup_value(dir, "memory.current", &mu->mu_current) != 0 ||
+	    read_cgroup_value(dir, "memory.max", &mu->mu_limit) != 0)
+	{
+		return -1;
+	}
+
+	if (read_cgroup_file_usage(dir, &mu->mu_file) != 0)
+		mu->mu_file = 0;
+#else
+	errno = EOPNOTSUPP;
+	return -1;
+#endif
+	return 0;
+}
@@ -6,6 +6,8 @@
 # define MEMUSAGE_LINUX_PROC_ENV    "MEMUSAGE_PROC_STATUS"
 # define MEMUSAGE_LINUX_SYS_STATUS "/proc/meminfo"
 # define MEMUSAGE_LINUX_SYS_ENV "MEMUSAGE_SYS_STATUS"
+# define MEMUSAGE_LINUX_CGROUP_SELF "/proc/self/cgroup"
+# define MEMUSAGE_LINUX_CGROUP_ROOT "/sys/fs/cgroup"
 #endif /* __linux__ */
 
 struct proc_memusage {
@@ -28,7 +30,18 @@ struct sys_memusage {
 	size_t mu_inactive;
 };
 
+/*
+ * Memory usage of the cgroup (v2) the process belongs to.
+ * All values are in kB, mu_limit is 0 if the cgroup is not limited.
+ */
+struct cgroup_memusage {
+	size_t mu_current;
+	size_t mu_limit;
+	size_t mu_file;
+};
+
 int oscap_proc_memusage(struct proc_memusage *mu);
+int oscap_cgroup_memusage(struct cgroup_memusage *mu);
 int oscap_sys_memusage(struct sys_memusage *mu);
 
 #endif /* MEMUSAGE_H */
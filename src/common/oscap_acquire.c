@@ -150,6 +150,50 @@ oscap_acquire_temp_file(const char *dir, const char *template, char **filename)
 	return fd;
 }
 
+char *
+oscap_acquire_temp_sibling(const char *filepath)
+{
+	char *tmp = oscap_sprintf("%s.XXXXXX", filepath);
+#ifdef _WIN32
+	int fd = -1;
+	if (_mktemp_s(tmp, strlen(tmp) + 1) == 0)
+		fd = open(tmp, _O_RDWR | _O_CREAT | _O_EXCL, _S_IREAD | _S_IWRITE);
+#else
+	int fd = mkstemp(tmp);
+	if (fd != -1) {
+		/* mkstemp() creates the file with 0600 */
+		mode_t mask = umask(0);
+		umask(mask);
+		if (fchmod(fd, 0666 & ~mask) != 0) {
+			close(fd);
+			unlink(tmp);
+			fd = -1;
+		}
+	}
+#endif
+	if (fd == -1) {
+		oscap_seterr(OSCAP_EFAMILY_GLIBC, "Unable to create a temporary file for '%s': %s", filepath, strerror(errno));
+		free(tmp);
+		return NULL;
+	}
+	close(fd);
+	return tmp;
+}
+
+int
+oscap_acquire_rename_sibling(const char *tmp, const char *filepath)
+{
+#ifdef _WIN32
+	/* rename() doesn't replace an existing file on Windows */
+	remove(filepath);
+#endif
+	if (rename(tmp, filepath) != 0) {
+		oscap_seterr(OSCAP_EFAMILY_GLIBC, "Unable to rename '%s' to '%s': %s", tmp, filepath, strerror(errno));
+		return -1;
+	}
+	return 0;
+}
+
 bool
 oscap_acquire_url_is_supported(const char *url)
 {
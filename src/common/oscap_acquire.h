@@ -52,6 +52,24 @@ void oscap_acquire_cleanup_dir(char **dir_path);
  */
 int oscap_acquire_temp_file(const char *dir, const char *template, char **filename);
 
+/**
+ * Create an empty temporary file next to the given file, so that it can
+ * replace the file by oscap_acquire_rename_sibling() once it's complete.
+ * The temporary file gets the permissions of a file created by fopen().
+ * @param filepath the file to be replaced
+ * @returns path of the temporary file to be freed by the caller, or NULL
+ * on failure
+ */
+char *oscap_acquire_temp_sibling(const char *filepath);
+
+/**
+ * Replace a file by the temporary file created by oscap_acquire_temp_sibling().
+ * @param tmp path of the temporary file
+ * @param filepath the file to be replaced
+ * @returns 0 on success, -1 on failure
+ */
+int oscap_acquire_rename_sibling(const char *tmp, const char *filepath);
+
 /**
  * Is the given url supported by OpenSCAP?
  * @param url Requested url
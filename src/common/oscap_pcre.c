@@ -0,0 +1,261 @@
+/*
+ * Copyright 2015 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "oscap_pcre.h"
+#include "debug_priv.h"
+
+#define OSCAP_PCRE_HSIZE 509
+
+#ifdef PCRE_STUDY_JIT_COMPILE
+# define OSCAP_PCRE_STUDY_OPTIONS PCRE_STUDY_JIT_COMPILE
+# define oscap_pcre_free_study(extra) pcre_free_study(extra)
+#else
+# define OSCAP_PCRE_STUDY_OPTIONS 0
+# define oscap_pcre_free_study(extra) pcre_free(extra)
+#endif
+
+struct oscap_pcre {
+	pcre *re;
+	pcre_extra *extra;
+	char *pattern;
+	int options;
+	unsigned int hash;
+	unsigned int refs;              ///< references held by the users
+	bool cached;                    ///< the entry is in the cache
+	struct oscap_pcre *hnext;       ///< hash chain
+	struct oscap_pcre *prev, *next; ///< LRU list, most recently used first
+};
+
+static struct {
+	pthread_mutex_t lock;
+	struct oscap_pcre *table[OSCAP_PCRE_HSIZE];
+	struct oscap_pcre *head, *tail;
+	size_t count;
+	size_t hits, misses;
+} oscap_pcre_cache = {
+	.lock = PTHREAD_MUTEX_INITIALIZER
+};
+
+static unsigned int oscap_pcre_hash(const char *pattern, int options)
+{
+	unsigned int h = 2166136261u ^ (unsigned int)options;
+
+	while (*pattern != '\0') {
+		h ^= (unsigned char)*pattern++;
+		h *= 16777619u;
+	}
+
+	return h;
+}
+
+static void oscap_pcre_destroy(struct oscap_pcre *re)
+{
+	if (re->extra != NULL)
+		oscap_pcre_free_study(re->extra);
+	pcre_free(re->re);
+	free(re->pattern);
+	free(re);
+}
+
+/* The functions below have to be called with the cache lock held */
+
+static struct oscap_pcre *oscap_pcre_lookup(const char *pattern, int options, unsigned int hash)
+{
+	struct oscap_pcre *re;
+
+	for (re = oscap_pcre_cache.table[hash % OSCAP_PCRE_HSIZE]; re != NULL; re = re->hnext) {
+		if (re->hash == hash && re->options == options && strcmp(re->pattern, pattern) == 0)
+			return re;
+	}
+
+	return NULL;
+}
+
+static void oscap_pcre_lru_unlink(struct oscap_pcre *re)
+{
+	if (re->prev != NULL)
+		re->prev->next = re->next;
+	else
+		oscap_pcre_cache.head = re->next;
+	if (re->next != NULL)
+		re->next->prev = re->prev;
+	else
+		oscap_pcre_cache.tail = re->prev;
+
+	re->prev = re->next = NULL;
+}
+
+static void oscap_pcre_lru_push(struct oscap_pcre *re)
+{
+	re->prev = NULL;
+	re->next = oscap_pcre_cache.head;
+	if (re->next != NULL)
+		re->next->prev = re;
+	else
+		oscap_pcre_cache.tail = re;
+	oscap_pcre_cache.head = re;
+}
+
+static void oscap_pcre_evict(struct oscap_pcre *re)
+{
+	struct oscap_pcre **rp = &oscap_pcre_cache.table[re->hash % OSCAP_PCRE_HSIZE];
+
+	while (*rp != re)
+		rp = &(*rp)->hnext;
+	*rp = re->hnext;
+
+	oscap_pcre_lru_unlink(re);
+	re->cached = false;
+	--oscap_pcre_cache.count;
+
+	/* Patterns still in use are destroyed by the last oscap_pcre_free() */
+	if (re->refs == 0)
+		oscap_pcre_destroy(re);
+}
+
+struct oscap_pcre *oscap_pcre_compile(const char *pattern, int options, const char **errptr, int *erroffset)
+{
+	struct oscap_pcre *re, *found;
+	const char *errstr = NULL;
+	unsigned int hash;
+	int errofs = 0;
+
+	hash = oscap_pcre_hash(pattern, options);
+
+	pthread_mutex_lock(&oscap_pcre_cache.lock);
+	re = oscap_pcre_lookup(pattern, options, hash);
+	if (re != NULL) {
+		++re->refs;
+		++oscap_pcre_cache.hits;
+		if (re != oscap_pcre_cache.head) {
+			oscap_pcre_lru_unlink(re);
+			oscap_pcre_lru_push(re);
+		}
+		pthread_mutex_unlock(&oscap_pcre_cache.lock);
+		return re;
+	}
+	++oscap_pcre_cache.misses;
+	pthread_mutex_unlock(&oscap_pcre_cache.lock);
+
+	/* Compile without holding the lock */
+	re = calloc(1, sizeof(struct oscap_pcre));
+	re->re = pcre_compile(pattern, options, &errstr, &errofs, NULL);
+	if (re->re == NULL) {
+		if (errptr != NULL)
+			*errptr = errstr;
+		if (erroffset != NULL)
+			*erroffset = errofs;
+		free(re);
+		return NULL;
+	}
+	/* Studying is an optimization only, ignore failures */
+	re->extra = pcre_study(re->re, OSCAP_PCRE_STUDY_OPTIONS, &errstr);
+	re->pattern = strdup(pattern);
+	re->options = options;
+	re->hash = hash;
+	re->refs = 1;
+
+	pthread_mutex_lock(&oscap_pcre_cache.lock);
+	found = oscap_pcre_lookup(pattern, options, hash);
+	if (found != NULL) {
+		/* Compiled by another thread in the meantime */
+		++found->refs;
+		pthread_mutex_unlock(&oscap_pcre_cache.lock);
+		oscap_pcre_destroy(re);
+		return found;
+	}
+	while (oscap_pcre_cache.count >= OSCAP_PCRE_CACHE_MAX)
+		oscap_pcre_evict(oscap_pcre_cache.tail);
+
+	re->hnext = oscap_pcre_cache.table[hash % OSCAP_PCRE_HSIZE];
+	oscap_pcre_cache.table[hash % OSCAP_PCRE_HSIZE] = re;
+	oscap_pcre_lru_push(re);
+	re->cached = true;
+	++oscap_pcre_cache.count;
+	pthread_mutex_unlock(&oscap_pcre_cache.lock);
+
+	return re;
+}
+
+int oscap_pcre_exec(const struct oscap_pcre *re, const char *subject, int length,
+                    int startoffset, int options, int *ovector, int ovecsize)
+{
+	int ret;
+
+	ret = pcre_exec(re->re, re->extra, subject, length, startoffset, options, ovector, ovecsize);
+#ifdef PCRE_ERROR_JIT_STACKLIMIT
+	/* The default JIT stack is small, fall back to the interpreter */
+	if (ret == PCRE_ERROR_JIT_STACKLIMIT)
+		ret = pcre_exec(re->re, NULL, subject, length, startoffset, options, ovector, ovecsize);
+#endif
+	return ret;
+}
+
+int oscap_pcre_fullinfo(const struct oscap_pcre *re, int what, void *where)
+{
+	return pcre_fullinfo(re->re, re->extra, what, where);
+}
+
+void oscap_pcre_free(struct oscap_pcre *re)
+{
+	bool destroy;
+
+	if (re == NULL)
+		return;
+
+	pthread_mutex_lock(&oscap_pcre_cache.lock);
+	destroy = --re->refs == 0 && !re->cached;
+	pthread_mutex_unlock(&oscap_pcre_cache.lock);
+
+	if (destroy)
+		oscap_pcre_destroy(re);
+}
+
+void oscap_pcre_cache_stats(size_t *hits, size_t *misses)
+{
+	pthread_mutex_lock(&oscap_pcre_cache.lock);
+	if (hits != NULL)
+		*hits = oscap_pcre_cache.hits;
+	if (misses != NULL)
+		*misses = oscap_pcre_cache.misses;
+	pthread_mutex_unlock(&oscap_pcre_cache.lock);
+}
+
+void oscap_pcre_cache_clear(void)
+{
+	struct oscap_pcre *re, *prev;
+
+	pthread_mutex_lock(&oscap_pcre_cache.lock);
+	dI("Regex cache: %zu hits, %zu misses, %zu patterns.", oscap_pcre_cache.hits,
+	   oscap_pcre_cache.misses, oscap_pcre_cache.count);
+	for (re = oscap_pcre_cache.tail; re != NULL; re = prev) {
+		prev = re->prev;
+		oscap_pcre_evict(re);
+	}
+	pthread_mutex_unlock(&oscap_pcre_cache.lock);
+}
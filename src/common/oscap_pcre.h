@@ -0,0 +1,77 @@
+/*
+ * Copyright 2015 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef OSCAP_PCRE_
+#define OSCAP_PCRE_
+
+#include <stddef.h>
+#include <pcre.h>
+#include "util.h"
+
+/*
+ * Compiled regular expression cache
+ *
+ * Patterns are compiled (and studied, using the JIT compiler if the PCRE
+ * library supports it) once and kept in a process-wide cache keyed by the
+ * pattern and the compile options. The least recently used patterns are
+ * dropped when the cache is full. All functions are thread-safe.
+ */
+#define OSCAP_PCRE_CACHE_MAX 256
+
+struct oscap_pcre;
+
+/**
+ * Get a compiled pattern from the cache, compile it on a miss.
+ * @param pattern the pattern
+ * @param options pcre_compile() options
+ * @param errptr error message is stored here on failure (may be NULL)
+ * @param erroffset offset of the error is stored here on failure (may be NULL)
+ * @return referenced compiled pattern, NULL on failure; failed
+ *         compilations are not cached
+ */
+struct oscap_pcre *oscap_pcre_compile(const char *pattern, int options, const char **errptr, int *erroffset);
+
+/**
+ * Match a compiled pattern, see pcre_exec().
+ */
+int oscap_pcre_exec(const struct oscap_pcre *re, const char *subject, int length,
+                    int startoffset, int options, int *ovector, int ovecsize);
+
+/**
+ * Get information about a compiled pattern, see pcre_fullinfo().
+ */
+int oscap_pcre_fullinfo(const struct oscap_pcre *re, int what, void *where);
+
+/**
+ * Release a pattern obtained by oscap_pcre_compile().
+ */
+void oscap_pcre_free(struct oscap_pcre *re);
+
+/**
+ * Get the cache hit and miss counters.
+ */
+void oscap_pcre_cache_stats(size_t *hits, size_t *misses);
+
+/**
+ * Empty the cache. Patterns still in use stay valid until they are
+ * released by oscap_pcre_free().
+ */
+void oscap_pcre_cache_clear(void);
+
+#endif
@@ -172,6 +172,48 @@ void oscap_strtoupper(char *str)
     for (; *str; ++str) *str = toupper(*str);
 }
 
+#define OSCAP_DIGEST_K1 0x87c37b91114253d5ULL
+#define OSCAP_DIGEST_K2 0x4cf5ad432745937fULL
+
+static inline uint64_t _oscap_digest_rotl(uint64_t x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t _oscap_digest_mix(uint64_t h, uint64_t k)
+{
+	k *= OSCAP_DIGEST_K1;
+	k = _oscap_digest_rotl(k, 31);
+	k *= OSCAP_DIGEST_K2;
+	h ^= k;
+	return _oscap_digest_rotl(h, 27) * 5 + 0x52dce729;
+}
+
+uint64_t oscap_digest(const void *data, size_t size, uint64_t seed)
+{
+	/* The body of MurmurHash3, one 64-bit lane */
+	const unsigned char *p = data;
+	uint64_t h = seed ^ (size * OSCAP_DIGEST_K2);
+	uint64_t k;
+
+	for (; size >= 8; size -= 8, p += 8) {
+		memcpy(&k, p, 8);
+		h = _oscap_digest_mix(h, k);
+	}
+	if (size > 0) {
+		k = 0;
+		memcpy(&k, p, size);
+		h = _oscap_digest_mix(h, k);
+	}
+
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
 char *oscap_expand_ipv6(const char *input)
 {
 	// we have to do a double pass because we need to know the number of
@@ -25,6 +25,7 @@
 #define OSCAP_UTIL_H_
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <assert.h>
 #include "public/oscap.h"
 #include "alloc.h"
@@ -369,6 +370,13 @@ bool oscap_ptr_cmp(void *node1, void *node2);
  */
 char *oscap_expand_ipv6(const char *input);
 
+/**
+ * Compute a 64-bit digest of the data, e.g. to find out whether some content
+ * changed. The digest is fast, but it isn't cryptographic.
+ * @param seed digest of the preceding data to chain the digests, or 0
+ */
+uint64_t oscap_digest(const void *data, size_t size, uint64_t seed);
+
 #ifndef OSCAP_CONCAT
 # define OSCAP_CONCAT1(a,b) a ## b
 # define OSCAP_CONCAT(a,b) OSCAP_CONCAT1(a,b)
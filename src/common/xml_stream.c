@@ -0,0 +1,301 @@
+/*
+ * Copyright 2015 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#include <sys/stat.h>
+#include <libxml/xmlsave.h>
+
+#include "_error.h"
+#include "debug_priv.h"
+#include "xml_stream.h"
+
+/* See MAX_INDENT in libxml2's xmlsave.c */
+#define OSCAP_XML_STREAM_MAXINDENT 60
+
+struct oscap_xml_stream {
+	xmlOutputBufferPtr out;
+	int fd;                                        ///< file descriptor to close, -1 if none
+	xmlDocPtr doc;
+	xmlChar *encoding;                             ///< the original encoding of the document
+	bool header;                                   ///< the XML declaration was written
+	int depth;
+	xmlNode *stack[OSCAP_XML_STREAM_MAXDEPTH];     ///< pushed elements
+	bool started[OSCAP_XML_STREAM_MAXDEPTH];       ///< the start tag of the pushed element was written
+};
+
+struct oscap_xml_stream *oscap_xml_stream_new_output(xmlOutputBufferPtr out, xmlDocPtr doc)
+{
+	struct oscap_xml_stream *stream = calloc(1, sizeof(struct oscap_xml_stream));
+	stream->out = out;
+	stream->fd = -1;
+	stream->doc = doc;
+	/* Serialize the nodes like xmlSaveFormatFileTo() with the UTF-8 encoding does */
+	stream->encoding = (xmlChar *) doc->encoding;
+	doc->encoding = BAD_CAST "UTF-8";
+	return stream;
+}
+
+struct oscap_xml_stream *oscap_xml_stream_new(const char *filename, xmlDocPtr doc)
+{
+	xmlOutputBufferPtr out;
+	int fd = -1;
+
+	if (strcmp(filename, "-") == 0) {
+		out = xmlOutputBufferCreateFilename(filename, NULL, 0);
+	}
+	else {
+#ifdef _WIN32
+		fd = open(filename, O_CREAT|O_TRUNC|O_WRONLY, S_IREAD|S_IWRITE);
+#else
+		fd = open(filename, O_CREAT|O_TRUNC|O_WRONLY,
+				S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH|S_IWOTH);
+#endif
+		if (fd < 0) {
+			oscap_seterr(OSCAP_EFAMILY_GLIBC, "%s '%s'", strerror(errno), filename);
+			return NULL;
+		}
+		out = xmlOutputBufferCreateFd(fd, NULL);
+	}
+	if (out == NULL) {
+		if (fd >= 0)
+			close(fd);
+		oscap_setxmlerr(xmlGetLastError());
+		dW("Can't create the output buffer for '%s'.", filename);
+		return NULL;
+	}
+
+	struct oscap_xml_stream *stream = oscap_xml_stream_new_output(out, doc);
+	stream->fd = fd;
+	return stream;
+}
+
+static void _oscap_xml_stream_write(struct oscap_xml_stream *stream, const char *str, size_t len)
+{
+	xmlOutputBufferWrite(stream->out, len, str);
+}
+
+static void _oscap_xml_stream_indent(struct oscap_xml_stream *stream, int level)
+{
+	if (!xmlIndentTreeOutput)
+		return;
+
+	size_t size = strlen(xmlTreeIndentString);
+	int max = size ? OSCAP_XML_STREAM_MAXINDENT / size : 0;
+	for (int i = 0; i < level && i < max; i++)
+		_oscap_xml_stream_write(stream, xmlTreeIndentString, size);
+}
+
+static void _oscap_xml_stream_header(struct oscap_xml_stream *stream)
+{
+	if (stream->header)
+		return;
+
+	const char *version = stream->doc->version ? (const char *) stream->doc->version : "1.0";
+	_oscap_xml_stream_write(stream, "<?xml version=\"", 15);
+	_oscap_xml_stream_write(stream, version, strlen(version));
+	_oscap_xml_stream_write(stream, "\" encoding=\"UTF-8\"?>\n", 21);
+	stream->header = true;
+}
+
+/* Write the start tag of the pushed element at the given level (and of its ancestors) */
+static void _oscap_xml_stream_start(struct oscap_xml_stream *stream, int level)
+{
+	if (stream->started[level])
+		return;
+	if (level > 0)
+		_oscap_xml_stream_start(stream, level - 1);
+	else
+		_oscap_xml_stream_header(stream);
+
+	/* Let libxml2 serialize the element without its children
+	 * (i.e. as an empty element) and turn it into the start tag. */
+	xmlNode *node = stream->stack[level];
+	xmlNode *children = node->children, *last = node->last;
+	node->children = node->last = NULL;
+
+	xmlOutputBufferPtr tag = xmlAllocOutputBuffer(NULL);
+	xmlNodeDumpOutput(tag, stream->doc, node, level, 1, "UTF-8");
+
+	node->children = children;
+	node->last = last;
+
+	const char *content = (const char *) xmlOutputBufferGetContent(tag);
+	size_t len = xmlOutputBufferGetSize(tag);
+	if (len >= 2 && strcmp(content + len - 2, "/>") == 0) {
+		len -= 2;
+	} else {
+		/* xmlSaveNoEmptyTags is set, drop the end tag */
+		const char *end = strrchr(content, '<');
+		len = end ? (size_t) (end - content) : len;
+		if (len > 0 && content[len - 1] == '>')
+			len--;
+	}
+
+	_oscap_xml_stream_indent(stream, level);
+	_oscap_xml_stream_write(stream, content, len);
+	_oscap_xml_stream_write(stream, ">\n", 2);
+	xmlOutputBufferClose(tag);
+
+	stream->started[level] = true;
+}
+
+/* Write a child of the pushed element at the given level */
+static void _oscap_xml_stream_child(struct oscap_xml_stream *stream, int level, xmlDocPtr doc, xmlNode *child)
+{
+	_oscap_xml_stream_start(stream, level);
+	if (child->type == XML_ELEMENT_NODE || child->type == XML_COMMENT_NODE || child->type == XML_PI_NODE)
+		_oscap_xml_stream_indent(stream, level + 1);
+
+	const xmlChar *encoding = doc->encoding;
+	doc->encoding = BAD_CAST "UTF-8";
+	xmlNodeDumpOutput(stream->out, doc, child, level + 1, 1, "UTF-8");
+	doc->encoding = encoding;
+
+	_oscap_xml_stream_write(stream, "\n", 1);
+}
+
+/* Write and free the children of the pushed element at the given level up to the given one */
+static void _oscap_xml_stream_flush_until(struct oscap_xml_stream *stream, int level, xmlNode *until)
+{
+	xmlNode *node = stream->stack[level];
+	xmlNode *child = node->children;
+
+	while (child != NULL && child != until) {
+		xmlNode *next = child->next;
+
+		_oscap_xml_stream_child(stream, level, stream->doc, child);
+		xmlUnlinkNode(child);
+		xmlFreeNode(child);
+		child = next;
+	}
+}
+
+void oscap_xml_stream_push(struct oscap_xml_stream *stream, xmlNode *node)
+{
+	if (stream == NULL)
+		return;
+
+	if (stream->depth >= OSCAP_XML_STREAM_MAXDEPTH) {
+		/* Too deep, the element is written as a whole when its parent is flushed */
+		dW("Can't stream the '%s' element, maximal depth %d reached.", node->name, OSCAP_XML_STREAM_MAXDEPTH);
+		stream->depth++;
+		return;
+	}
+	if (stream->depth > 0)
+		_oscap_xml_stream_flush_until(stream, stream->depth - 1, node);
+
+	stream->stack[stream->depth] = node;
+	stream->started[stream->depth] = false;
+	stream->depth++;
+}
+
+void oscap_xml_stream_flush(struct oscap_xml_stream *stream)
+{
+	if (stream == NULL || stream->depth == 0 || stream->depth > OSCAP_XML_STREAM_MAXDEPTH)
+		return;
+
+	_oscap_xml_stream_flush_until(stream, stream->depth - 1, NULL);
+}
+
+void oscap_xml_stream_write_node(struct oscap_xml_stream *stream, xmlDocPtr doc, xmlNode *node)
+{
+	if (stream == NULL || stream->depth == 0 || stream->depth > OSCAP_XML_STREAM_MAXDEPTH)
+		return;
+
+	_oscap_xml_stream_flush_until(stream, stream->depth - 1, NULL);
+	_oscap_xml_stream_child(stream, stream->depth - 1, doc, node);
+}
+
+void oscap_xml_stream_pop(struct oscap_xml_stream *stream)
+{
+	if (stream == NULL || stream->depth == 0)
+		return;
+
+	int level = --stream->depth;
+	if (level >= OSCAP_XML_STREAM_MAXDEPTH)
+		return;
+
+	xmlNode *node = stream->stack[level];
+	_oscap_xml_stream_flush_until(stream, level, NULL);
+
+	if (!stream->started[level]) {
+		/* No children, write the element as an empty one */
+		if (level > 0) {
+			_oscap_xml_stream_child(stream, level - 1, stream->doc, node);
+			xmlUnlinkNode(node);
+			xmlFreeNode(node);
+		} else {
+			_oscap_xml_stream_header(stream);
+			xmlNodeDumpOutput(stream->out, stream->doc, node, 0, 1, "UTF-8");
+			_oscap_xml_stream_write(stream, "\n", 1);
+		}
+		return;
+	}
+
+	_oscap_xml_stream_indent(stream, level);
+	_oscap_xml_stream_write(stream, "</", 2);
+	if (node->ns != NULL && node->ns->prefix != NULL) {
+		_oscap_xml_stream_write(stream, (const char *) node->ns->prefix, xmlStrlen(node->ns->prefix));
+		_oscap_xml_stream_write(stream, ":", 1);
+	}
+	_oscap_xml_stream_write(stream, (const char *) node->name, xmlStrlen(node->name));
+	_oscap_xml_stream_write(stream, ">\n", 2);
+
+	if (level > 0) {
+		xmlUnlinkNode(node);
+		xmlFreeNode(node);
+	}
+}
+
+int oscap_xml_stream_close(struct oscap_xml_stream *stream)
+{
+	int ret;
+
+	while (stream->depth > 0)
+		oscap_xml_stream_pop(stream);
+
+	stream->doc->encoding = stream->encoding;
+	if (stream->header) {
+		ret = xmlOutputBufferClose(stream->out);
+	} else {
+		/* Nothing was streamed, save the whole document */
+		ret = xmlSaveFormatFileTo(stream->out, stream->doc, "UTF-8", 1);
+	}
+	if (stream->fd >= 0)
+		close(stream->fd);
+	free(stream);
+
+	if (ret < 0) {
+		oscap_setxmlerr(xmlGetLastError());
+		dW("Failed to write the XML document: %d.", ret);
+		return -1;
+	}
+	return 1;
+}
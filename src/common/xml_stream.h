@@ -0,0 +1,93 @@
+/*
+ * Copyright 2015 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef OSCAP_XML_STREAM_H_
+#define OSCAP_XML_STREAM_H_
+
+#include <libxml/tree.h>
+#include <libxml/xmlIO.h>
+#include "util.h"
+
+/*
+ * Streaming export of a DOM document
+ *
+ * The document is built the usual way, but the elements with many children
+ * (e.g. the list of the results) are pushed to the stream. Once a child
+ * of a pushed element is complete, it can be flushed: it is written to the
+ * output and removed from the document. Only the pushed elements and the
+ * children which were not flushed yet are kept in memory.
+ *
+ * The output is the same as the one of oscap_xml_save_filename(). All
+ * functions accept a NULL stream and do nothing then, so the code building
+ * the document can be shared by the streaming and the DOM export.
+ */
+#define OSCAP_XML_STREAM_MAXDEPTH 16
+
+struct oscap_xml_stream;
+
+/**
+ * Create a stream writing the document to a file.
+ * @param filename path to the file, "-" for the standard output
+ * @param doc the document, it's owned by the caller
+ * @return the stream or NULL on failure (oscap_seterr is set)
+ */
+struct oscap_xml_stream *oscap_xml_stream_new(const char *filename, xmlDocPtr doc);
+
+/**
+ * Create a stream writing the document to an output buffer, which can
+ * be e.g. a compressed file or memory.
+ * @param out the output buffer, it's closed by oscap_xml_stream_close()
+ * @param doc the document, it's owned by the caller
+ */
+struct oscap_xml_stream *oscap_xml_stream_new_output(xmlOutputBufferPtr out, xmlDocPtr doc);
+
+/**
+ * Start streaming the children of an element. The element has to be the
+ * root element of the document or a child of the innermost pushed element.
+ * The preceding siblings of the element are flushed.
+ */
+void oscap_xml_stream_push(struct oscap_xml_stream *stream, xmlNode *node);
+
+/**
+ * Write the children of the innermost pushed element and remove them
+ * from the document.
+ */
+void oscap_xml_stream_flush(struct oscap_xml_stream *stream);
+
+/**
+ * Write a node of another document as the next child of the innermost
+ * pushed element. The node is neither copied nor modified, so big documents
+ * can be embedded without building their copy.
+ * @param doc the document of the node
+ */
+void oscap_xml_stream_write_node(struct oscap_xml_stream *stream, xmlDocPtr doc, xmlNode *node);
+
+/**
+ * Finish the innermost pushed element: flush its children and write its
+ * end tag. The element is removed from the document unless it's the root.
+ */
+void oscap_xml_stream_pop(struct oscap_xml_stream *stream);
+
+/**
+ * Finish the document and close the output. The stream is freed.
+ * @return 1 on success, -1 on failure (oscap_seterr is set)
+ */
+int oscap_xml_stream_close(struct oscap_xml_stream *stream);
+
+#endif
@@ -26,6 +26,7 @@
 #endif
 
 #include <libxml/tree.h>
+#include <libxml/xmlreader.h>
 #include <stdlib.h>
 #include <string.h>
 #ifdef _WIN32
@@ -110,6 +111,15 @@ xmlDoc *bz2_fd_read_doc(int fd)
 	return xmlReadIO((xmlInputReadCallback) bz2_file_read, bz2_file_close, bzfile, "url", NULL, XML_PARSE_PEDANTIC);
 }
 
+xmlTextReader *bz2_fd_read_reader(int fd)
+{
+	struct bz2_file *bzfile = bz2_fd_open(fd);
+	if (bzfile == NULL) {
+		return NULL;
+	}
+	return xmlReaderForIO((xmlInputReadCallback) bz2_file_read, bz2_file_close, bzfile, "url", NULL, XML_PARSE_PEDANTIC);
+}
+
 struct bz2_mem {
 	bz_stream *stream;
 	bool eof;
@@ -184,6 +194,15 @@ xmlDoc *bz2_mem_read_doc(const char *buffer, size_t size)
 	return xmlReadIO((xmlInputReadCallback) bz2_mem_read, bz2_mem_close, bzmem, "url", NULL, XML_PARSE_PEDANTIC);
 }
 
+xmlTextReader *bz2_mem_read_reader(const char *buffer, size_t size)
+{
+	struct bz2_mem *bzmem = bz2_mem_open(buffer, size);
+	if (bzmem == NULL) {
+		return NULL;
+	}
+	return xmlReaderForIO((xmlInputReadCallback) bz2_mem_read, bz2_mem_close, bzmem, "url", NULL, XML_PARSE_PEDANTIC);
+}
+
 #endif
 
 static const char magic_number[] = {'B','Z'};
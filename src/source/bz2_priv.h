@@ -28,6 +28,7 @@
 #include "common/public/oscap.h"
 #include "common/util.h"
 #include <libxml/tree.h>
+#include <libxml/xmlreader.h>
 
 
 #ifdef BZIP2_FOUND
@@ -39,6 +40,14 @@
  */
 xmlDoc *bz2_fd_read_doc(int fd);
 
+/**
+ * Create a reader streaming the content of *.xml.bz2 file. The file
+ * is decompressed as the reader advances, no DOM is built.
+ * @param fd The file descriptor to bz2 file, it's closed with the reader
+ * @returns the reader or NULL on failure
+ */
+xmlTextReader *bz2_fd_read_reader(int fd);
+
 /**
  * Parse bzip2ed memory to XML DOM.
  * @param buffer data in memory to process (contains bzip2ed XML)
@@ -47,6 +56,15 @@ xmlDoc *bz2_fd_read_doc(int fd);
  */
 xmlDoc *bz2_mem_read_doc(const char *buffer, size_t size);
 
+/**
+ * Create a reader streaming bzip2ed memory.
+ * @param buffer data in memory to process (contains bzip2ed XML), it has
+ * to be kept until the reader is freed
+ * @param size length of data
+ * @returns the reader or NULL on failure
+ */
+xmlTextReader *bz2_mem_read_reader(const char *buffer, size_t size);
+
 #endif // BZIP2_FOUND
 
 /**
@@ -25,11 +25,14 @@
 #endif
 
 #include <string.h>
+#include <stdint.h>
 #include <fcntl.h>
+#include <sys/stat.h>
 #ifdef _WIN32
 #include <io.h>
 #else
 #include <unistd.h>
+#include <sys/mman.h>
 #endif
 #include <libxml/parser.h>
 #include <libxml/xmlreader.h>
@@ -71,6 +74,7 @@ struct oscap_source {
 		char *filepath;                         ///< Filepath (if originated from file)
 		char *memory;                           ///< Memory buffer (if originated from memory)
 		size_t memory_size;                     ///< Size of the memory buffer (if originated from memory)
+		bool mapped;                            ///< The memory buffer is a mapped file
 	} origin;                                       ///
 	struct {
 		xmlDoc *doc;                            /// DOM
@@ -95,7 +99,10 @@ struct oscap_source *oscap_source_clone(struct oscap_source *old)
 	new->origin.type = old->origin.type;
 	new->origin.version = oscap_strdup(old->origin.version);
 	new->origin.filepath = oscap_strdup(old->origin.filepath);
-	new->origin.memory = oscap_strdup(old->origin.memory);
+	if (old->origin.memory != NULL) {
+		new->origin.memory = malloc(old->origin.memory_size);
+		memcpy(new->origin.memory, old->origin.memory, old->origin.memory_size);
+	}
 	new->origin.memory_size = old->origin.memory_size;
 	new->xml.doc = xmlCopyDoc(old->xml.doc, true);
 	return new;
@@ -131,6 +138,42 @@ struct oscap_source *oscap_source_new_take_memory(char *buffer, size_t size, con
 	return source;
 }
 
+struct oscap_source *oscap_source_new_map_file(const char *path, const char *filepath)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd == -1) {
+		oscap_seterr(OSCAP_EFAMILY_GLIBC, "Unable to open file: '%s'", path);
+		return NULL;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		oscap_seterr(OSCAP_EFAMILY_GLIBC, "Unable to map empty or unreadable file: '%s'", path);
+		close(fd);
+		return NULL;
+	}
+	struct oscap_source *source = _create_oscap_source(st.st_size, filepath);
+#ifdef _WIN32
+	source->origin.memory = malloc(st.st_size);
+	if (read(fd, source->origin.memory, st.st_size) != st.st_size) {
+		free(source->origin.memory);
+		source->origin.memory = NULL;
+	}
+#else
+	void *memory = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (memory != MAP_FAILED) {
+		source->origin.memory = memory;
+		source->origin.mapped = true;
+	}
+#endif
+	close(fd);
+	if (source->origin.memory == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_GLIBC, "Unable to map file: '%s'", path);
+		oscap_source_free(source);
+		return NULL;
+	}
+	return source;
+}
+
 struct oscap_source *oscap_source_new_from_xmlDoc(xmlDoc *doc, const char *filepath)
 {
 	struct oscap_source *source = (struct oscap_source *) calloc(1, sizeof(struct oscap_source));
@@ -144,6 +187,11 @@ void oscap_source_free(struct oscap_source *source)
 {
 	if (source != NULL) {
 		free(source->origin.filepath);
+#ifndef _WIN32
+		if (source->origin.mapped)
+			munmap(source->origin.memory, source->origin.memory_size);
+		else
+#endif
 		free(source->origin.memory);
 		if (source->xml.doc != NULL) {
 			xmlFreeDoc(source->xml.doc);
@@ -163,20 +211,6 @@ const char *oscap_source_readable_origin(const struct oscap_source *source)
 	return source->origin.filepath;
 }
 
-xmlTextReader *oscap_source_get_xmlTextReader(struct oscap_source *source)
-{
-	xmlDoc *doc = oscap_source_get_xmlDoc(source);
-	if (doc == NULL) {
-		return NULL;
-	}
-	xmlTextReader *reader = xmlReaderWalker(doc);
-	if (reader == NULL) {
-		oscap_seterr(OSCAP_EFAMILY_XML, "Unable to create xmlTextReader for %s", oscap_source_readable_origin(source));
-		oscap_setxmlerr(xmlGetLastError());
-	}
-	return reader;
-}
-
 oscap_document_type_t oscap_source_get_scap_type(struct oscap_source *source)
 {
 	if (source->scap_type == OSCAP_DOCUMENT_UNKNOWN) {
@@ -325,6 +359,139 @@ xmlDoc *oscap_source_get_xmlDoc(struct oscap_source *source)
 	return source->xml.doc;
 }
 
+// xmlInputReadCallback
+static int fd_read(void *context, char *buffer, int len)
+{
+	return read((int) (intptr_t) context, buffer, len);
+}
+
+// xmlInputCloseCallback
+static int fd_close(void *context)
+{
+	return close((int) (intptr_t) context);
+}
+
+static void xmlReaderErrorCb(struct oscap_source *source, xmlErrorPtr error)
+{
+	if (error->level == XML_ERR_WARNING) {
+		dW("%s: %s", oscap_source_readable_origin(source), error->message);
+		return;
+	}
+	oscap_setxmlerr(error);
+	oscap_seterr(OSCAP_EFAMILY_XML, "Unable to parse XML at: '%s'", oscap_source_readable_origin(source));
+}
+
+/*
+ * Create a reader parsing the origin of the source as it advances. The reader
+ * never holds more than the current subtree, so the DOM isn't built at all.
+ */
+static xmlTextReader *_create_xmlTextReader(struct oscap_source *source)
+{
+	xmlTextReader *reader = NULL;
+
+	if (source->origin.memory != NULL) {
+		if (bz2_memory_is_bzip(source->origin.memory, source->origin.memory_size)) {
+#ifdef BZIP2_FOUND
+			reader = bz2_mem_read_reader(source->origin.memory, source->origin.memory_size);
+#else
+			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Unable to unpack bz2 from buffer memory '%s'. Please compile OpenSCAP with bz2 support.", oscap_source_readable_origin(source));
+			return NULL;
+#endif
+		} else if (memory_file_is_executable(source->origin.memory, source->origin.memory_size)) {
+			dI("oscap-source in memory was detected as executable file. Skipped XML parsing", oscap_source_readable_origin(source));
+			return NULL;
+		} else {
+			reader = xmlReaderForMemory(source->origin.memory, source->origin.memory_size, NULL, NULL, 0);
+		}
+	}
+	else {
+		int fd = open(source->origin.filepath, O_RDONLY);
+		if (fd == -1) {
+			oscap_seterr(OSCAP_EFAMILY_GLIBC, "Unable to open file: '%s'", oscap_source_readable_origin(source));
+			return NULL;
+		}
+		if (bz2_fd_is_bzip(fd)) {
+#ifdef BZIP2_FOUND
+			// the file is closed by the reader
+			reader = bz2_fd_read_reader(fd);
+#else
+			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Unable to unpack bz2 file '%s'. Please compile OpenSCAP with bz2 support.", oscap_source_readable_origin(source));
+			close(fd);
+			return NULL;
+#endif
+		} else if (fd_file_is_executable(fd)) {
+			dI("oscap-source file was detected as executable file. Skipped XML parsing", oscap_source_readable_origin(source));
+			close(fd);
+			return NULL;
+		} else {
+			reader = xmlReaderForIO(fd_read, fd_close, (void *) (intptr_t) fd, NULL, NULL, 0);
+		}
+	}
+
+	if (reader == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_XML, "Unable to create xmlTextReader for %s", oscap_source_readable_origin(source));
+		oscap_setxmlerr(xmlGetLastError());
+		return NULL;
+	}
+	xmlTextReaderSetStructuredErrorHandler(reader, (xmlStructuredErrorFunc) xmlReaderErrorCb, source);
+	return reader;
+}
+
+xmlTextReader *oscap_source_get_xmlTextReader(struct oscap_source *source)
+{
+	if (source->xml.doc == NULL) {
+		// The DOM is built only when somebody asks for it
+		return _create_xmlTextReader(source);
+	}
+	xmlTextReader *reader = xmlReaderWalker(source->xml.doc);
+	if (reader == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_XML, "Unable to create xmlTextReader for %s", oscap_source_readable_origin(source));
+		oscap_setxmlerr(xmlGetLastError());
+	}
+	return reader;
+}
+
+int oscap_source_get_content(struct oscap_source *source, const char **buffer, size_t *size, struct oscap_source **mapped)
+{
+	*mapped = NULL;
+	if (source->origin.memory == NULL) {
+		if (source->origin.type != OSCAP_SRC_FROM_USER_XML_FILE) {
+			return -1;
+		}
+		*mapped = oscap_source_new_map_file(source->origin.filepath, NULL);
+		if (*mapped == NULL) {
+			return -1;
+		}
+		source = *mapped;
+	}
+	*buffer = source->origin.memory;
+	*size = source->origin.memory_size;
+	return 0;
+}
+
+int oscap_source_get_digest(struct oscap_source *source, uint64_t *digest)
+{
+	const char *buffer;
+	size_t size;
+	struct oscap_source *mapped;
+	if (oscap_source_get_content(source, &buffer, &size, &mapped) != 0) {
+		return -1;
+	}
+	*digest = oscap_digest(buffer, size, 0);
+	oscap_source_free(mapped);
+	return 0;
+}
+
+bool oscap_source_has_xmlDoc(const struct oscap_source *source)
+{
+	return source->xml.doc != NULL;
+}
+
+bool oscap_source_xmlTextReader_failed(xmlTextReader *reader)
+{
+	return xmlTextReaderReadState(reader) == XML_TEXTREADER_MODE_ERROR;
+}
+
 int oscap_source_validate(struct oscap_source *source, xml_reporter reporter, void *user)
 {
 	int ret;
@@ -48,6 +48,16 @@
  */
 struct oscap_source *oscap_source_new_take_memory(char *buffer, size_t size, const char *filepath);
 
+/**
+ * Create new oscap_source from a file mapped to memory. Unlike the
+ * oscap_source_new_from_file() the file is opened right away and its
+ * content stays available even if the file is replaced later.
+ * @param path path to the file
+ * @param filepath Suggested filename for the file or NULL
+ * @returns newly created oscap_source or NULL on failure
+ */
+struct oscap_source *oscap_source_new_map_file(const char *path, const char *filepath);
+
 /**
  * Build new oscap_source from existing xmlDoc. The xmlDoc becomes owned
  * by oscap_source.
@@ -60,13 +70,50 @@ struct oscap_source *oscap_source_new_from_xmlDoc(xmlDoc *doc, const char *filep
 
 /**
  * Get an xmlTextReader assigned with this resource. The reader needs to be
- * disposed by caller.
+ * disposed by caller. Unless the DOM representation was already built, the
+ * reader parses the content as it advances and the errors in the content are
+ * found only while reading, see oscap_source_xmlTextReader_failed().
  * @memberof oscap_source
  * @param source Resource to read the content
  * @returns xmlTextReader structure to read the content
  */
 xmlTextReader *oscap_source_get_xmlTextReader(struct oscap_source *source);
 
+/**
+ * Check whether the reading stopped because the content isn't well-formed.
+ * @param reader xmlTextReader obtained by oscap_source_get_xmlTextReader()
+ * @returns true if the reader failed, the oscap error is set then
+ */
+bool oscap_source_xmlTextReader_failed(xmlTextReader *reader);
+
+/**
+ * Compute a digest of the raw content of this resource (see oscap_digest()).
+ * @memberof oscap_source
+ * @param digest the digest is stored here
+ * @returns 0 on success, -1 if the resource doesn't originate from a file
+ * or memory
+ */
+int oscap_source_get_digest(struct oscap_source *source, uint64_t *digest);
+
+/**
+ * Get the raw content of this resource without copying it.
+ * @memberof oscap_source
+ * @param buffer the content is stored here
+ * @param size the size of the content is stored here
+ * @param mapped a source mapping the file is stored here when the content
+ * isn't in memory yet, it must be freed after the content is used
+ * @returns 0 on success, -1 if the resource doesn't originate from a file
+ * or memory
+ */
+int oscap_source_get_content(struct oscap_source *source, const char **buffer, size_t *size, struct oscap_source **mapped);
+
+/**
+ * Check whether the DOM representation of this resource is available
+ * without parsing the content again.
+ * @memberof oscap_source
+ */
+bool oscap_source_has_xmlDoc(const struct oscap_source *source);
+
 /**
  * Get a DOM representation of this resource. The document ins still owned
  * by oscap_source.
@@ -24,6 +24,7 @@
 
 #include <libxml/parser.h>
 #include <libxml/xmlerror.h>
+#include <libxml/xmlreader.h>
 #include <libxml/xmlschemas.h>
 #include <string.h>
 #ifdef _WIN32
@@ -82,7 +83,39 @@ static void oscap_xml_validity_handler(void *user, xmlErrorPtr error)
 	context->reporter(file, error->line, error->message, context->arg);
 }
 
-static inline int oscap_validate_xml(struct oscap_source *source, const char *schemafile, xml_reporter reporter, void *arg)
+/*
+ * Validate the content while it's being parsed by the reader, the DOM
+ * is not built. Returns the same values as xmlSchemaValidateDoc().
+ */
+static int oscap_validate_xml_reader(struct oscap_source *source, xmlSchemaValidCtxtPtr ctxt, struct ctxt *context)
+{
+	xmlTextReader *reader = oscap_source_get_xmlTextReader(source);
+	if (reader == NULL)
+		return -1;
+
+	/* Report the errors in the content as the validity errors */
+	xmlTextReaderSetStructuredErrorHandler(reader, oscap_xml_validity_handler, context);
+	if (xmlTextReaderSchemaValidateCtxt(reader, ctxt, 0) != 0) {
+		oscap_seterr(OSCAP_EFAMILY_XML, "Could not start validation of '%s'", oscap_source_readable_origin(source));
+		xmlFreeTextReader(reader);
+		return -1;
+	}
+
+	int ret;
+	while ((ret = xmlTextReaderRead(reader)) == 1)
+		;
+
+	if (oscap_source_xmlTextReader_failed(reader)) {
+		oscap_seterr(OSCAP_EFAMILY_XML, "Unable to parse XML at: '%s'", oscap_source_readable_origin(source));
+		ret = -1;
+	} else {
+		ret = xmlTextReaderIsValid(reader) == 1 ? 0 : 1;
+	}
+	xmlFreeTextReader(reader);
+	return ret;
+}
+
+static inline int oscap_validate_xml(struct oscap_source *source, oscap_document_type_t doc_type, const char *schemafile, xml_reporter reporter, void *arg)
 {
 	int result = -1;
 	xmlSchemaParserCtxtPtr parser_ctxt = NULL;
@@ -126,11 +159,18 @@ static inline int oscap_validate_xml(struct oscap_source *source, const char *sc
 
 	xmlSchemaSetValidStructuredErrors(ctxt, oscap_xml_validity_handler, &context);
 
-	doc = oscap_source_get_xmlDoc(source);
-	if (!doc)
-		goto cleanup;
-
-	result = xmlSchemaValidateDoc(ctxt, doc);
+	if (oscap_source_has_xmlDoc(source) || doc_type == OSCAP_DOCUMENT_SDS || doc_type == OSCAP_DOCUMENT_ARF) {
+		/* The components of data streams are looked up in the DOM anyway */
+		doc = oscap_source_get_xmlDoc(source);
+		if (!doc)
+			goto cleanup;
+
+		result = xmlSchemaValidateDoc(ctxt, doc);
+	} else {
+		result = oscap_validate_xml_reader(source, ctxt, &context);
+		if (result == -1)
+			goto cleanup;
+	}
 
 	/*
 	 * xmlSchemaValidateFile() returns "-1" if document is not well formed
@@ -247,7 +287,7 @@ int oscap_source_validate_priv(struct oscap_source *source, oscap_document_type_
 		if (entry->doc_type != doc_type || strcmp(entry->schema_version, version))
 			continue;
 
-		return oscap_validate_xml(source, entry->schema_path, reporter, user);
+		return oscap_validate_xml(source, doc_type, entry->schema_path, reporter, user);
 	}
 
 	oscap_seterr(OSCAP_EFAMILY_OSCAP, "Schema file not found when trying to validate '%s'", oscap_source_readable_origin(source));
@@ -14,7 +14,10 @@
 
 #include <cpe_dict.h>
 #include <cpe_name.h>
+#include <oscap_source.h>
 #include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
 
 #define OSCAP_FOREACH_GENERIC(itype, vtype, val, init_val, code) \
     {                                                            \
@@ -32,6 +35,55 @@
 
 void print_usage(const char *, FILE *);
 
+// identifiers of the checks evaluated by cpe_name_applicable_dict()
+static char applicable_log[1 << 16];
+
+static bool log_check(const char *system, const char *href, const char *name, void *usr)
+{
+	strncat(applicable_log, name, sizeof(applicable_log) - strlen(applicable_log) - 2);
+	strcat(applicable_log, " ");
+	return false;
+}
+
+// Compare the dictionary lookups with matching the items one by one.
+static int match_index(struct cpe_dict_model *dict, const char *cpestr)
+{
+	char expected[sizeof(applicable_log)] = "";
+	bool matched = false;
+	struct cpe_name *cpe = cpe_name_new(cpestr);
+
+	if (cpe == NULL)
+		return 0;
+
+	OSCAP_FOREACH(cpe_item, item, cpe_dict_model_get_items(dict),
+		struct cpe_name *name = cpe_item_get_name(item);
+		if (cpe_name_match_one(name, cpe))
+			matched = true;
+		if (cpe_name_match_one(cpe, name)) {
+			char *str = cpe_name_get_as_str(name);
+			strncat(expected, str, sizeof(expected) - strlen(expected) - 2);
+			strcat(expected, " ");
+			free(str);
+		}
+	)
+
+	applicable_log[0] = '\0';
+	cpe_name_applicable_dict(cpe, dict, log_check, NULL);
+
+	int ret = 0;
+	if (cpe_name_match_dict(cpe, dict) != matched) {
+		fprintf(stderr, "%s was not matched correctly!\n", cpestr);
+		ret = 1;
+	}
+	if (strcmp(applicable_log, expected) != 0) {
+		fprintf(stderr, "%s matched items: %s\nexpected: %s\n", cpestr, applicable_log, expected);
+		ret = 1;
+	}
+
+	cpe_name_free(cpe);
+	return ret;
+}
+
 int main(int argc, char **argv)
 {
 	struct cpe_dict_model *dict_model;
@@ -200,6 +252,49 @@ int main(int argc, char **argv)
 		cpe_dict_model_free(dict_model);
 	}
 
+	else if (argc >= 4 && !strcmp(argv[1], "--match-index")) {
+
+		struct oscap_source *source = oscap_source_new_from_file(argv[2]);
+		dict_model = cpe_dict_model_import_source(source);
+		oscap_source_free(source);
+		if (dict_model == NULL)
+			return 2;
+
+		// let every item log its name when checked
+		OSCAP_FOREACH(cpe_item, local_item,
+			      cpe_dict_model_get_items(dict_model),
+			      char *str = cpe_name_get_as_str(cpe_item_get_name(local_item));
+			      check = cpe_check_new();
+			      cpe_check_set_identifier(check, str);
+			      cpe_item_add_check(local_item, check);
+			      free(str);)
+
+		// names of the items, their prefixes and variants
+		OSCAP_FOREACH(cpe_item, local_item,
+			      cpe_dict_model_get_items(dict_model),
+			      char *str = cpe_name_get_as_str(cpe_item_get_name(local_item));
+			      char variant[1024];
+
+			      ret_val |= match_index(dict_model, str);
+			      for (char *p = str + strlen("cpe:/"); *p != '\0'; ++p) {
+				      if (*p == ':') {
+					      snprintf(variant, sizeof(variant), "%.*s", (int)(p - str), str);
+					      ret_val |= match_index(dict_model, variant);
+				      }
+			      }
+			      snprintf(variant, sizeof(variant), "%s:x", str);
+			      ret_val |= match_index(dict_model, variant);
+			      for (char *p = str; *p != '\0'; ++p)
+				      *p = toupper(*p);
+			      ret_val |= match_index(dict_model, str);
+			      free(str);)
+
+		for (int i = 3; i < argc; ++i)
+			ret_val |= match_index(dict_model, argv[i]);
+
+		cpe_dict_model_free(dict_model);
+	}
+
 	else if (argc == 5 && !strcmp(argv[1], "--remove")) {
 
 		if ((dict_model = cpe_dict_model_import(argv[2])) == NULL)
@@ -286,9 +381,10 @@ void print_usage(const char *program_name, FILE * out)
 		"  %s --list-cpe-names CPE_DICT_XML ENCODING\n"
 		"  %s --list           CPE_DICT_XML ENCODING\n"
 		"  %s --match          CPE_DICT_XML ENCODING CPE_URI\n"
+		"  %s --match-index    CPE_DICT_XML ENCODING [CPE_URI...]\n"
 		"  %s --remove         CPE_DICT_XML ENCODING CPE_URI\n"
 		"  %s --export         CPE_DICT_XML ENCODING CPE_DICT_XML ENCODING\n"
 		"  %s --smoke-test\n",
 		program_name, program_name, program_name, program_name,
-		program_name, program_name, program_name);
+		program_name, program_name, program_name, program_name);
 }
@@ -45,6 +45,12 @@ function test_api_cpe_dict_match_existing_cpe {
     return 0 
 }
 
+function test_api_cpe_dict_match_index {
+    ./test_api_cpe_dict --match-index $srcdir/dict.xml "UTF-8" \
+	"cpe:/" "cpe:/a" "cpe:/a::3c16115-us" "cpe:/a:3com::2.0" \
+	"cpe:/A:3COM:3C16115-US:2.01::~~~~~" "cpe:/h:not_in_the_dictionary"
+}
+
 function test_api_cpe_dict_export_xml {
     ./test_api_cpe_dict --export $srcdir/dict.xml "UTF-8" \
 	dict.xml.out "UTF-8" && \
@@ -126,6 +132,7 @@ if [ -z ${CUSTOM_OSCAP+x} ] ; then
         test_api_cpe_dict_match_non_existing_cpe   
     test_run "test_api_cpe_dict_match_existing_cpe" \
         test_api_cpe_dict_match_existing_cpe
+    test_run "test_api_cpe_dict_match_index" test_api_cpe_dict_match_index
     test_run "test_api_cpe_dict_export_xml"  test_api_cpe_dict_export_xml
     #test_run "test_api_cpe_dict_import_cp1250_xml" \
     #    test_api_cpe_dict_import_cp1250_xml   
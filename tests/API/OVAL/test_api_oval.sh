@@ -26,8 +26,9 @@ function test_api_oval_syschar {
 }
 
 function test_api_oval_results {
-    ./test_api_results $srcdir/results.xml exported-results.xml
+    ./test_api_results $srcdir/results.xml exported-results.xml exported-results-dom.xml
     cmp $srcdir/results-good.xml exported-results.xml
+    cmp exported-results-dom.xml exported-results.xml
 }
 
 function test_api_oval_directives {
@@ -35,6 +36,49 @@ function test_api_oval_directives {
     cmp $srcdir/directives.xml exported-directives.xml
 }
 
+# Loading a generated feed, the load time and the peak RSS are printed.
+# The number of definitions can be set with OVAL_LOAD_DEFINITIONS.
+function test_api_oval_load_benchmark {
+    local definitions=${OVAL_LOAD_DEFINITIONS:-5000}
+    local feed=load-benchmark.xml
+
+    {
+	echo '<?xml version="1.0" encoding="UTF-8"?>'
+	echo '<oval_definitions xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5" xmlns:oval="http://oval.mitre.org/XMLSchema/oval-common-5" xmlns:linux="http://oval.mitre.org/XMLSchema/oval-definitions-5#linux">'
+	echo '  <generator><oval:schema_version>5.11</oval:schema_version><oval:timestamp>2015-08-08T22:19:00+02:00</oval:timestamp></generator>'
+	echo '  <definitions>'
+	for i in $(seq 1 $definitions); do
+	    echo "    <definition id=\"oval:x:def:$i\" version=\"1\" class=\"patch\"><metadata><title>Update $i</title><reference source=\"CVE\" ref_id=\"CVE-2015-$i\"/><description>Package $i is earlier than 0:1.$i</description></metadata><criteria operator=\"AND\"><criterion test_ref=\"oval:x:tst:$i\" comment=\"package$i is earlier than 0:1.$i\"/></criteria></definition>"
+	done
+	echo '  </definitions>'
+	echo '  <tests>'
+	for i in $(seq 1 $definitions); do
+	    echo "    <linux:rpminfo_test id=\"oval:x:tst:$i\" version=\"1\" check=\"at least one\" comment=\"x\"><linux:object object_ref=\"oval:x:obj:$i\"/><linux:state state_ref=\"oval:x:ste:$i\"/></linux:rpminfo_test>"
+	done
+	echo '  </tests>'
+	echo '  <objects>'
+	for i in $(seq 1 $definitions); do
+	    echo "    <linux:rpminfo_object id=\"oval:x:obj:$i\" version=\"1\"><linux:name>package$i</linux:name></linux:rpminfo_object>"
+	done
+	echo '  </objects>'
+	echo '  <states>'
+	for i in $(seq 1 $definitions); do
+	    echo "    <linux:rpminfo_state id=\"oval:x:ste:$i\" version=\"1\"><linux:evr datatype=\"evr_string\" operation=\"less than\">0:1.$i</linux:evr></linux:rpminfo_state>"
+	done
+	echo '  </states>'
+	echo '</oval_definitions>'
+    } > $feed
+
+    ./test_api_oval_load file $feed | tee load-benchmark.out
+    ./test_api_oval_load memory $feed | tee -a load-benchmark.out
+    if command -v bzip2 >/dev/null; then
+	bzip2 -kf $feed
+	./test_api_oval_load file $feed.bz2 | tee -a load-benchmark.out
+    fi
+    [ $(grep -c " $definitions definitions loaded" load-benchmark.out) -eq $(wc -l < load-benchmark.out) ]
+    rm -f $feed $feed.bz2 load-benchmark.out
+}
+
 # Testing.
 
 test_init
@@ -44,6 +88,7 @@ if [ -z ${CUSTOM_OSCAP+x} ] ; then
     test_run "test_api_oval_syschar" test_api_oval_syschar
     test_run "test_api_oval_results" test_api_oval_results
     test_run "test_api_oval_directives" test_api_oval_directives
+    test_run "test_api_oval_load_benchmark" test_api_oval_load_benchmark
 fi
 
 test_exit
@@ -0,0 +1,86 @@
+/*
+ * Load an OVAL definitions file and print the load time and the peak RSS.
+ *
+ * Usage: test_api_oval_load file|memory <definitions.xml[.bz2]>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <oval_definitions.h>
+#include <oscap.h>
+#include "oscap_source.h"
+#include "oscap_error.h"
+
+static char *read_file(const char *path, size_t *size)
+{
+	FILE *f = fopen(path, "rb");
+	if (f == NULL)
+		return NULL;
+	fseek(f, 0, SEEK_END);
+	*size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	char *buffer = malloc(*size);
+	if (fread(buffer, 1, *size, f) != *size) {
+		free(buffer);
+		buffer = NULL;
+	}
+	fclose(f);
+	return buffer;
+}
+
+int main(int argc, char **argv)
+{
+	struct oscap_source *source;
+	struct timespec start, end;
+	struct rusage usage;
+
+	if (argc != 3) {
+		fprintf(stderr, "Usage: %s file|memory <definitions.xml>\n", argv[0]);
+		return 2;
+	}
+
+	if (strcmp(argv[1], "memory") == 0) {
+		size_t size;
+		char *buffer = read_file(argv[2], &size);
+		if (buffer == NULL) {
+			fprintf(stderr, "Can't read '%s'.\n", argv[2]);
+			return 1;
+		}
+		source = oscap_source_new_from_memory(buffer, size, argv[2]);
+		free(buffer);
+	} else {
+		source = oscap_source_new_from_file(argv[2]);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	struct oval_definition_model *model = oval_definition_model_import_source(source);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	getrusage(RUSAGE_SELF, &usage);
+	oscap_source_free(source);
+
+	if (model == NULL) {
+		fprintf(stderr, "GOT error: %s.\n", oscap_err_desc());
+		return 1;
+	}
+
+	int count = 0;
+	struct oval_definition_iterator *definitions = oval_definition_model_get_definitions(model);
+	while (oval_definition_iterator_has_more(definitions)) {
+		oval_definition_iterator_next(definitions);
+		count++;
+	}
+	oval_definition_iterator_free(definitions);
+	oval_definition_model_free(model);
+	oscap_cleanup();
+
+	long elapsed = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000;
+	printf("%s: %d definitions loaded in %ld ms, peak RSS %ld kB\n", argv[1], count, elapsed, usage.ru_maxrss);
+	return 0;
+}
@@ -476,6 +476,14 @@ function test_api_seap_concurency {
     return $ret_val
 }
 
+function test_api_seap_binary {
+    SEXP_VALIDATE_DISABLE=1 ./test_api_seap_binary 100000
+}
+
+function test_api_seap_shm {
+    SEXP_VALIDATE_DISABLE=1 SEAP_DEBUGLOG_DISABLE=1 ./test_api_seap_shm $[16*1024*1024]
+}
+
 function test_api_strto {
     ./test_api_strto
 }
@@ -494,6 +502,8 @@ if [ -z ${CUSTOM_OSCAP+x} ] ; then
     test_run "test_api_seap_number_expression"    ./test_api_seap_number
     test_run "test_api_seap_string_expression"    ./test_api_seap_string
     test_run "test_api_SEXP_deepcmp"              ./test_api_SEXP_deepcmp
+    test_run "test_api_seap_binary"               test_api_seap_binary
+    test_run "test_api_seap_shm"                  test_api_seap_shm
     test_run "test_api_strto"                     ./test_api_strto
 fi
 
@@ -0,0 +1,192 @@
+/*
+ * Round-trip throughput of the textual and the binary S-exp transport
+ * formats. A synthetic collected object is written and read back in both
+ * formats, both results must be equal.
+ *
+ * Usage: test_api_seap_binary [item count]
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sexp.h>
+#include <strbuf.h>
+#include "_sexp-binary.h"
+
+#define FAIL(ret, ...)                                        \
+        do {                                                  \
+                fprintf (stderr, "FAIL: " __VA_ARGS__);       \
+                exit (ret);                                   \
+        } while (0)
+
+static SEXP_t *entity(const char *name, const char *datatype, SEXP_t *value)
+{
+	SEXP_t *attrs, *ent, *name_sexp;
+
+	if (datatype != NULL)
+		SEXP_datatype_set(value, datatype);
+
+	attrs = SEXP_list_new(NULL);
+	name_sexp = SEXP_string_newf(":%s", name);
+	SEXP_list_add(attrs, name_sexp);
+	ent = SEXP_list_new(attrs, value, NULL);
+
+	SEXP_vfree(attrs, name_sexp, value, NULL);
+
+	return ent;
+}
+
+static SEXP_t *synthetic_item(size_t i)
+{
+	SEXP_t *item, *ents[5];
+	char path[64];
+	size_t n;
+
+	snprintf(path, sizeof path, "/usr/share/synthetic/file-%zu", i);
+
+	ents[0] = entity("path", "string", SEXP_string_newf("%s", path));
+	ents[1] = entity("size", "int", SEXP_number_newu_64(i * 4096));
+	ents[2] = entity("uid", "int", SEXP_number_newi_32(-(int32_t)(i % 1000)));
+	ents[3] = entity("suid", "bool", SEXP_number_newb(i % 2));
+	ents[4] = entity("mtime", NULL, SEXP_number_newf((double)i / 3));
+
+	item = SEXP_list_new(NULL);
+
+	for (n = 0; n < 5; ++n) {
+		SEXP_list_add(item, ents[n]);
+		SEXP_free(ents[n]);
+	}
+
+	return item;
+}
+
+static double elapsed(const struct timespec *beg, const struct timespec *end)
+{
+	return (double)(end->tv_sec - beg->tv_sec) +
+	       (double)(end->tv_nsec - beg->tv_nsec) / 1e9;
+}
+
+static SEXP_t *text_roundtrip(const SEXP_t *s_exp, size_t *size)
+{
+	SEXP_psetup_t *psetup;
+	SEXP_pstate_t *pstate = NULL;
+	SEXP_t *parsed, *res;
+	strbuf_t *sb;
+	char *buf;
+
+	sb = strbuf_new(SEAP_STRBUF_MAX);
+
+	if (SEXP_sbprintf_t((SEXP_t *)s_exp, sb) != 0)
+		FAIL(1, "SEXP_sbprintf_t\n");
+
+	*size = strbuf_length(sb);
+	buf = malloc(*size);
+	strbuf_copy(sb, buf, *size);
+	strbuf_free(sb);
+
+	psetup = SEXP_psetup_new();
+	parsed = SEXP_parse(psetup, buf, *size, &pstate);
+
+	if (parsed == NULL)
+		FAIL(1, "SEXP_parse\n");
+
+	res = SEXP_list_first(parsed);
+
+	SEXP_free(parsed);
+	SEXP_psetup_free(psetup);
+	free(buf);
+
+	return res;
+}
+
+static SEXP_t *binary_roundtrip(const SEXP_t *s_exp, size_t *size)
+{
+	SEXP_t  *res;
+	uint8_t *frame;
+	ssize_t  ret;
+
+	if (SEXP_bin_frame(s_exp, &frame, size) != 0)
+		FAIL(1, "SEXP_bin_frame\n");
+
+	/* An incomplete frame must not be decoded */
+	if (SEXP_bin_unframe(frame, *size - 1, &res) != 0)
+		FAIL(1, "incomplete frame decoded\n");
+
+	ret = SEXP_bin_unframe(frame, *size, &res);
+
+	if (ret < 0 || (size_t)ret != *size)
+		FAIL(1, "SEXP_bin_unframe: ret=%zd, size=%zu\n", ret, *size);
+
+	/* Corrupted data must be rejected */
+	frame[SEXP_BIN_HDRSIZE] = 0xff;
+
+	if (SEXP_bin_unframe(frame, *size, &res) != -1 || errno != EILSEQ)
+		FAIL(1, "corrupted frame decoded\n");
+
+	free(frame);
+
+	return res;
+}
+
+int main(int argc, char *argv[])
+{
+	struct timespec t_beg, t_end;
+	SEXP_t *cobj, *items, *item, *res, *text_res, *ent, *val;
+	size_t  count, i, size;
+	double  t_text, t_bin;
+
+	count = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+
+	items = SEXP_list_new(NULL);
+
+	for (i = 0; i < count; ++i) {
+		item = synthetic_item(i);
+		SEXP_list_add(items, item);
+		SEXP_free(item);
+	}
+
+	item = SEXP_string_newf("synthetic_object");
+	cobj = SEXP_list_new(item, items, NULL);
+	SEXP_vfree(item, items, NULL);
+
+	clock_gettime(CLOCK_MONOTONIC, &t_beg);
+	text_res = text_roundtrip(cobj, &size);
+	clock_gettime(CLOCK_MONOTONIC, &t_end);
+	t_text = elapsed(&t_beg, &t_end);
+
+	printf("text:   %zu items, %zu bytes, %.3f s\n", count, size, t_text);
+
+	clock_gettime(CLOCK_MONOTONIC, &t_beg);
+	res = binary_roundtrip(cobj, &size);
+	clock_gettime(CLOCK_MONOTONIC, &t_end);
+	t_bin = elapsed(&t_beg, &t_end);
+
+	printf("binary: %zu items, %zu bytes, %.3f s\n", count, size, t_bin);
+
+	if (SEXP_deepcmp(text_res, res) != true)
+		FAIL(1, "binary round-trip result differs\n");
+
+	/* Datatypes and number types have to match the textual format */
+	items = SEXP_list_nth(res, 2);
+	item  = SEXP_list_nth(items, 2);
+
+	ent = SEXP_list_nth(item, 2);
+	val = SEXP_list_nth(ent, 2);
+
+	if (SEXP_datatype(val) == NULL || strcmp(SEXP_datatype(val), "int") != 0)
+		FAIL(1, "datatype lost\n");
+	if (SEXP_number_type(val) != SEXP_NUM_UINT16)
+		FAIL(1, "number type differs\n");
+
+	SEXP_vfree(val, ent, item, items, res, text_res, cobj, NULL);
+
+	if (t_bin > 0)
+		printf("speedup: %.1fx\n", t_text / t_bin);
+
+	return (0);
+}
@@ -459,5 +459,25 @@ int main (void)
 		SEXP_vfree (r0, r1, r3, NULL);
         }
 
+	{
+		/* test SEXP_list_pop() */
+		SEXP_t *l1, *r0, *r1, *r2;
+
+		l1 = SEXP_list_new(r0 = SEXP_string_newf ("x"),
+				   r1 = SEXP_string_newf ("y"),
+				   r2 = SEXP_string_newf ("z"),
+				   NULL);
+		SEXP_vfree (r0, r1, r2, NULL);
+
+		while ((r0 = SEXP_list_pop (l1)) != NULL) {
+			SEXP_fprintfa (stdout, r0);
+			fputc('\n', stdout);
+			SEXP_free (r0);
+		}
+
+		printf ("l=%zu\n", SEXP_list_length (l1));
+		SEXP_free (l1);
+	}
+
         return (0);
 }
@@ -0,0 +1,169 @@
+/*
+ * Latency and throughput of the pipe and shm SEAP schemes. The program
+ * executes itself as the peer process: the peer replies to a number with
+ * a string of that many bytes.
+ *
+ * Usage: test_api_seap_shm [max message size]
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <sexp.h>
+#include <seap.h>
+
+#define PEER_ENV  "TEST_API_SEAP_SHM_PEER"
+#define SHM_ENV   "OSCAP_SEAP_SHM"
+
+#define LATENCY_ROUNDS 2000
+#define MSG_MIN        1024
+
+#define FAIL(ret, ...)                                        \
+        do {                                                  \
+                fprintf (stderr, "FAIL: " __VA_ARGS__);       \
+                exit (ret);                                   \
+        } while (0)
+
+static int peer(void)
+{
+	SEAP_CTX_t *ctx;
+	SEXP_t *req, *rep;
+	char *buf = NULL;
+	size_t len;
+	int sd;
+
+	ctx = SEAP_CTX_new();
+	sd  = SEAP_openfd2(ctx, STDIN_FILENO, STDOUT_FILENO, 0);
+
+	if (sd < 0)
+		return (1);
+
+	while (SEAP_recvsexp(ctx, sd, &req) == 0) {
+		if (SEXP_stringp(req)) {
+			/* Report whether the shared memory ring was offered */
+			rep = SEXP_number_newb(getenv(SHM_ENV) != NULL);
+		} else {
+			len = SEXP_number_getu_64(req);
+			buf = realloc(buf, len);
+			memset(buf, 'x', len);
+			rep = SEXP_string_new(buf, len);
+		}
+
+		if (SEAP_sendsexp(ctx, sd, rep) != 0)
+			return (1);
+
+		SEXP_vfree(req, rep, NULL);
+	}
+
+	free(buf);
+	SEAP_close(ctx, sd);
+	SEAP_CTX_free(ctx);
+
+	return (0);
+}
+
+static double elapsed(const struct timespec *beg, const struct timespec *end)
+{
+	return (double)(end->tv_sec - beg->tv_sec) +
+	       (double)(end->tv_nsec - beg->tv_nsec) / 1e9;
+}
+
+static void request(SEAP_CTX_t *ctx, int sd, size_t len)
+{
+	SEXP_t *req, *rep;
+
+	req = SEXP_number_newu_64(len);
+
+	if (SEAP_sendsexp(ctx, sd, req) != 0)
+		FAIL(1, "SEAP_sendsexp: %s\n", strerror(errno));
+	if (SEAP_recvsexp(ctx, sd, &rep) != 0)
+		FAIL(1, "SEAP_recvsexp: %s\n", strerror(errno));
+	if (!SEXP_stringp(rep) || SEXP_string_length(rep) != len)
+		FAIL(1, "unexpected reply to a %zu bytes request\n", len);
+
+	SEXP_vfree(req, rep, NULL);
+}
+
+static void run(const char *scheme, const char *self, size_t max)
+{
+	struct timespec t_beg, t_end;
+	SEAP_CTX_t *ctx;
+	SEXP_t *req, *rep;
+	char uri[PATH_MAX + 16];
+	size_t len;
+	int sd, i, rounds;
+
+	snprintf(uri, sizeof uri, "%s://%s", scheme, self);
+
+	ctx = SEAP_CTX_new();
+	sd  = SEAP_connect(ctx, uri, 0);
+
+	if (sd < 0)
+		FAIL(1, "SEAP_connect(%s): %s\n", uri, strerror(errno));
+
+	req = SEXP_string_newf("shm");
+
+	if (SEAP_sendsexp(ctx, sd, req) != 0 || SEAP_recvsexp(ctx, sd, &rep) != 0)
+		FAIL(1, "%s: handshake failed\n", scheme);
+	if (SEXP_number_getb(rep) != (strcmp(scheme, "shm") == 0))
+		FAIL(1, "%s: unexpected transport\n", scheme);
+
+	SEXP_vfree(req, rep, NULL);
+
+	clock_gettime(CLOCK_MONOTONIC, &t_beg);
+
+	for (i = 0; i < LATENCY_ROUNDS; ++i)
+		request(ctx, sd, MSG_MIN);
+
+	clock_gettime(CLOCK_MONOTONIC, &t_end);
+
+	printf("%-4s latency %7zu B: %8.1f us\n", scheme, (size_t)MSG_MIN,
+	       elapsed(&t_beg, &t_end) / LATENCY_ROUNDS * 1e6);
+
+	for (len = MSG_MIN; len <= max; len = len * 16 > max && len < max ? max : len * 16) {
+		rounds = len < 1024 * 1024 ? 256 : 4;
+
+		clock_gettime(CLOCK_MONOTONIC, &t_beg);
+
+		for (i = 0; i < rounds; ++i)
+			request(ctx, sd, len);
+
+		clock_gettime(CLOCK_MONOTONIC, &t_end);
+
+		printf("%-4s throughput %9zu B: %8.1f MiB/s\n", scheme, len,
+		       (double)len * rounds / (1024 * 1024) / elapsed(&t_beg, &t_end));
+	}
+
+	SEAP_close(ctx, sd);
+	SEAP_CTX_free(ctx);
+}
+
+int main(int argc, char *argv[])
+{
+	char self[PATH_MAX];
+	ssize_t n;
+	size_t max;
+
+	if (getenv(PEER_ENV) != NULL)
+		return peer();
+
+	max = argc > 1 ? strtoul(argv[1], NULL, 10) : 100 * 1024 * 1024;
+
+	if ((n = readlink("/proc/self/exe", self, sizeof self - 1)) < 0)
+		FAIL(1, "readlink: %s\n", strerror(errno));
+
+	self[n] = '\0';
+	setenv(PEER_ENV, "1", 1);
+
+	run("pipe", self, max);
+	run("shm", self, max);
+
+	return (0);
+}
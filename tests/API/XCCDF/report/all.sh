@@ -49,6 +49,102 @@ function test_generate_report_custom {
     return 1
 }
 
+# Generate a benchmark of $1 rules checking the lines of a data file, half
+# of the OVAL objects are missing, one rule is not applicable, one is not
+# checked and one is not selected.
+function generate_report_benchmark {
+    local rules=$1
+    local xccdf=$2
+    local oval=$3
+    local data=$4
+
+    seq 1 $rules | sed 's/^/line /' > $data
+    awk -v n=$rules -v data="$PWD/$data" 'BEGIN {
+        print "<?xml version=\"1.0\"?>"
+        print "<oval_definitions xmlns=\"http://oval.mitre.org/XMLSchema/oval-definitions-5\" xmlns:oval=\"http://oval.mitre.org/XMLSchema/oval-common-5\" xmlns:ind=\"http://oval.mitre.org/XMLSchema/oval-definitions-5#independent\">"
+        print "<generator><oval:schema_version>5.11</oval:schema_version><oval:timestamp>2017-01-01T00:00:00</oval:timestamp></generator><definitions>"
+        for (i = 1; i <= n; i++)
+            printf("<definition class=\"compliance\" id=\"oval:x:def:%d\" version=\"1\"><metadata><title>d%d</title><description>d%d</description></metadata><criteria><criterion test_ref=\"oval:x:tst:%d\"/></criteria></definition>\n", i, i, i, i)
+        print "</definitions><tests>"
+        for (i = 1; i <= n; i++)
+            printf("<ind:textfilecontent54_test check=\"all\" check_existence=\"at_least_one_exists\" comment=\"line %d\" id=\"oval:x:tst:%d\" version=\"1\"><ind:object object_ref=\"oval:x:obj:%d\"/></ind:textfilecontent54_test>\n", i, i, i)
+        print "</tests><objects>"
+        for (i = 1; i <= n; i++)
+            printf("<ind:textfilecontent54_object id=\"oval:x:obj:%d\" version=\"1\"><ind:filepath>%s</ind:filepath><ind:pattern operation=\"pattern match\">^line %d$</ind:pattern><ind:instance datatype=\"int\">1</ind:instance></ind:textfilecontent54_object>\n", i, data, (i % 2) ? i : -i)
+        print "</objects></oval_definitions>"
+    }' > $oval
+    awk -v n=$rules -v oval=$oval 'BEGIN {
+        split("low medium high", severity)
+        print "<?xml version=\"1.0\"?>"
+        print "<Benchmark xmlns=\"http://checklists.nist.gov/xccdf/1.2\" xmlns:h=\"http://www.w3.org/1999/xhtml\" id=\"xccdf_moc.elpmaxe.www_benchmark_test\" resolved=\"1\">"
+        print "<status>accepted</status><version>1.0</version>"
+        print "<Value id=\"xccdf_moc.elpmaxe.www_value_1\" type=\"string\"><title>v</title><value>42</value></Value>"
+        for (g = 0; g < n / 100; g++) {
+            printf("<Group id=\"xccdf_moc.elpmaxe.www_group_%d\"><title>Group %d</title>\n", g, g)
+            for (i = g * 100 + 1; i <= n && i <= g * 100 + 100; i++)
+                printf("<Rule selected=\"true\" severity=\"%s\" id=\"xccdf_moc.elpmaxe.www_rule_%d\"><title>Rule %d</title><description>Line <h:code>%d</h:code> is <sub idref=\"xccdf_moc.elpmaxe.www_value_1\"/>.</description><ident system=\"http://example.com\">ID-%d</ident><fixtext>Add line %d.</fixtext><fix system=\"urn:xccdf:fix:script:sh\">echo line %d &gt;&gt; file</fix><check system=\"http://oval.mitre.org/XMLSchema/oval-definitions-5\"><check-content-ref href=\"%s\" name=\"oval:x:def:%d\"/></check></Rule>\n", severity[i % 3 + 1], i, i, i, i, i, i, oval, i)
+            print "</Group>"
+        }
+        print "<Rule selected=\"true\" severity=\"high\" id=\"xccdf_moc.elpmaxe.www_rule_notapplicable\"><title>Not applicable</title><platform idref=\"cpe:/o:example:none\"/><check system=\"http://oval.mitre.org/XMLSchema/oval-definitions-5\"><check-content-ref href=\"" oval "\" name=\"oval:x:def:1\"/></check></Rule>"
+        print "<Rule selected=\"true\" severity=\"low\" id=\"xccdf_moc.elpmaxe.www_rule_notchecked\"><title>Not checked</title><check system=\"http://example.com/unknown\"><check-content-ref href=\"unknown\"/></check></Rule>"
+        print "<Rule selected=\"false\" id=\"xccdf_moc.elpmaxe.www_rule_notselected\"><title>Not selected</title></Rule>"
+        print "</Benchmark>"
+    }' > $xccdf
+}
+
+# Rewrite the markup of a report so the native and the XSLT one can be
+# compared: the whitespace of the stylesheet templates is dropped, the
+# generated ids and the source of the OVAL details named after the ARF are
+# masked and the rule-result message elements the stylesheet copies into
+# the <pre> blocks are replaced by their text.
+function normalize_report {
+    bash $builddir/run ./test_report_render normalize "$1" \
+        | tr '\n\t' '  ' \
+        | sed -E -e 's/<message [^>]*>|<\/message>//g' \
+            -e 's/  */ /g' -e 's/> </></g' -e 's/ </</g' -e 's/> />/g' \
+        | sed 's/</\n</g' \
+        | sed -E -e '/^<html /d' -e '/^<meta http-equiv="Content-Type"/d' \
+            -e 's/\bidm?[0-9]+/id/g' -e 's/(OVAL details taken from )[^"]*"/\1"/'
+}
+
+# The native report of an evaluation must match the one of the stylesheet:
+# the rule results, the OVAL details of the collected and missing items and
+# the score tables.
+function test_report_native_matches_xslt {
+    local xccdf=report-compare.xccdf.xml
+    local oval=report-compare.oval.xml
+    local data=report-compare.txt
+
+    generate_report_benchmark 30 $xccdf $oval $data
+    bash $builddir/run ./test_report_render compare $xccdf report-compare.native.html report-compare.xslt.html
+    for result in pass fail notapplicable notchecked; do
+        grep -q "rule-detail-$result " report-compare.native.html
+    done
+    grep -q "because these items were missing" report-compare.native.html
+    grep -q "because of these items" report-compare.native.html
+    grep -q 'urn:xccdf:scoring:default' report-compare.native.html
+    diff -u <(normalize_report report-compare.xslt.html) <(normalize_report report-compare.native.html)
+    rm -f $xccdf $oval $data $oval.result.xml report-compare.*.html
+}
+
+# Evaluating a generated benchmark and generating its report natively and by
+# the stylesheet, the report time and the peak RSS are printed.
+function test_report_render_benchmark {
+    local rules=${REPORT_RULES:-500}
+    local xccdf=report-benchmark.xccdf.xml
+    local oval=report-benchmark.oval.xml
+    local data=report-benchmark.txt
+
+    generate_report_benchmark $rules $xccdf $oval $data
+    bash $builddir/run ./test_report_render native $xccdf report-benchmark.native.html | tee report-benchmark.out
+    bash $builddir/run ./test_report_render xslt $xccdf report-benchmark.xslt.html | tee -a report-benchmark.out
+    [ $(grep -c "report generated" report-benchmark.out) -eq 2 ]
+    # The notselected rule has no details
+    [ $(grep -o 'id="rule-detail-' report-benchmark.native.html | wc -l) -eq $((rules + 2)) ]
+    [ $(grep -o 'id="rule-detail-' report-benchmark.xslt.html | wc -l) -eq $((rules + 2)) ]
+    rm -f $xccdf $oval $data $oval.result.xml report-benchmark.*.html report-benchmark.out
+}
+
 # Testing.
 
 test_init "test_api_xccdf_report.log"
@@ -63,5 +159,7 @@ test_run "test_api_xccdf_report_idents" test_generate_report results-idents-refs
 test_run "test_api_xccdf_report_refs" test_generate_report results-idents-refs.xml referencereferencereference
 test_run "test_api_xccdf_report_no_title" test_generate_report results-xccdf12.xml "ID: xccdf_moc.elpmaxe.www_rule_1"
 test_run "test_api_xccdf_report_title" test_generate_report results-title.xml "RULETITLE"
+test_run "test_report_native_matches_xslt" test_report_native_matches_xslt
+test_run "test_report_render_benchmark" test_report_render_benchmark
 
 test_exit
@@ -0,0 +1,111 @@
+/*
+ * Evaluate a benchmark and generate its HTML report, print the time spent
+ * in the report generation and the peak RSS before and after it. The compare
+ * mode writes the native and then the XSLT report of the same evaluation,
+ * the normalize mode prints a report as serialized by the libxml2 HTML parser.
+ *
+ * Usage: test_report_render native|xslt <xccdf.xml> <report.html>
+ *        test_report_render compare <xccdf.xml> <native.html> <xslt.html>
+ *        test_report_render normalize <report.html>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <libxml/HTMLparser.h>
+#include <libxml/HTMLtree.h>
+#include <oscap.h>
+#include <xccdf_session.h>
+#include "oscap_error.h"
+
+static int export_report(struct xccdf_session *session, const char *mode, const char *report)
+{
+	struct timespec start, end;
+	struct rusage usage;
+
+	if (strcmp(mode, "xslt") == 0)
+		setenv("OSCAP_REPORT_XSLT", "1", 1);
+	else
+		unsetenv("OSCAP_REPORT_XSLT");
+	xccdf_session_set_report_export(session, report);
+
+	getrusage(RUSAGE_SELF, &usage);
+	long eval_rss = usage.ru_maxrss;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	int ret = xccdf_session_export_xccdf(session);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	getrusage(RUSAGE_SELF, &usage);
+
+	if (ret != 0) {
+		fprintf(stderr, "GOT error: %s.\n", oscap_err_desc());
+		return 1;
+	}
+
+	long elapsed = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000;
+	printf("%s: report generated in %ld ms, peak RSS %ld kB after the evaluation, %ld kB after the report\n",
+		mode, elapsed, eval_rss, usage.ru_maxrss);
+	return 0;
+}
+
+static int normalize_report(const char *report)
+{
+	htmlDocPtr doc = htmlReadFile(report, "UTF-8", HTML_PARSE_RECOVER | HTML_PARSE_NOBLANKS |
+			HTML_PARSE_NOERROR | HTML_PARSE_NOWARNING | HTML_PARSE_NONET);
+	if (doc == NULL) {
+		fprintf(stderr, "Can't parse '%s'.\n", report);
+		return 1;
+	}
+	int ret = htmlSaveFileFormat("-", doc, "UTF-8", 0) < 0 ? 1 : 0;
+	xmlFreeDoc(doc);
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc == 3 && strcmp(argv[1], "normalize") == 0)
+		return normalize_report(argv[2]);
+
+	bool compare = argc == 5 && strcmp(argv[1], "compare") == 0;
+
+	if (!compare && (argc != 4 || (strcmp(argv[1], "native") != 0 && strcmp(argv[1], "xslt") != 0))) {
+		fprintf(stderr, "Usage: %s native|xslt <xccdf.xml> <report.html>\n"
+			"       %s compare <xccdf.xml> <native.html> <xslt.html>\n"
+			"       %s normalize <report.html>\n", argv[0], argv[0], argv[0]);
+		return 2;
+	}
+
+	oscap_init();
+	struct xccdf_session *session = xccdf_session_new(argv[2]);
+	if (session == NULL) {
+		fprintf(stderr, "GOT error: %s.\n", oscap_err_desc());
+		return 1;
+	}
+	xccdf_session_set_oval_results_export(session, true);
+	/* the OVAL results are exported first as oscap does, the stylesheet gets them in the ARF */
+	if (xccdf_session_load(session) != 0 || xccdf_session_evaluate(session) != 0 ||
+			xccdf_session_export_oval(session) != 0) {
+		fprintf(stderr, "GOT error: %s.\n", oscap_err_desc());
+		xccdf_session_free(session);
+		return 1;
+	}
+
+	int ret;
+	if (compare) {
+		ret = export_report(session, "native", argv[3]);
+		if (ret == 0)
+			ret = export_report(session, "xslt", argv[4]);
+	} else {
+		ret = export_report(session, argv[1], argv[3]);
+	}
+	xccdf_session_free(session);
+	oscap_cleanup();
+	return ret;
+}
@@ -0,0 +1,36 @@
+#!/bin/bash
+
+# The rules evaluated by a pool of threads shall give the same output and
+# results, in the same order, as the rules evaluated one after another.
+
+set -e
+set -o pipefail
+
+name=$(basename $0 .sh)
+
+result=$(mktemp -t ${name}.out.XXXXXX)
+result_threads=$(mktemp -t ${name}.out.XXXXXX)
+stdout=$(mktemp -t ${name}.out.XXXXXX)
+stdout_threads=$(mktemp -t ${name}.out.XXXXXX)
+stderr=$(mktemp -t ${name}.out.XXXXXX)
+
+ret=0
+$OSCAP xccdf eval --results $result $srcdir/${name}.xccdf.xml > $stdout 2> $stderr || ret=$?
+[ $ret -eq 2 ]
+ret=0
+OSCAP_XCCDF_EVAL_THREADS=4 $OSCAP xccdf eval --results $result_threads $srcdir/${name}.xccdf.xml > $stdout_threads 2> $stderr || ret=$?
+[ $ret -eq 2 ]
+
+echo "Stdout file = $stdout_threads"
+echo "Result file = $result_threads"
+
+diff $stdout $stdout_threads
+grep -q "^Rule.*xccdf_moc.elpmaxe.www_rule_8" $stdout_threads
+
+$OSCAP xccdf validate-xml $result_threads
+# the times of the evaluation differ
+sed -i -e 's/time="[^"]*"//g' $result $result_threads
+diff $result $result_threads
+[ $(grep -c '<rule-result ' $result_threads) -eq 11 ]
+
+rm $result $result_threads $stdout $stdout_threads $stderr
@@ -2,11 +2,20 @@
 
 . $builddir/tests/test_common.sh
 
+# Collect more items than PROBE_RESULT_MEMCHECK_CTRESHOLD to exercise
+# the sampled memory checks. S-exp validation is disabled, it makes
+# every list append linear in the length of the list.
+function test_probes_collect {
+    SEXP_VALIDATE_DISABLE=1 ./test_api_probes_collect 50000 &&
+    SEXP_VALIDATE_DISABLE=1 ./test_api_probes_collect 50000 worker
+}
+
 test_init "test_api_probes.log"
 
 if [ -z ${CUSTOM_OSCAP+x} ] ; then
     test_run "fts test" $srcdir/fts.sh
     test_run "probe api smoke test" ./test_api_probes_smoke
+    test_run "probe item collection" test_probes_collect
 fi
 
 test_exit
@@ -0,0 +1,145 @@
+/*
+ * Item collection benchmark: feeds a number of synthetic items through
+ * probe_item_collect() and reports the time spent per batch of items.
+ * The time per batch should stay constant as the collected object grows.
+ *
+ * Usage: test_api_probes_collect [item count] [worker]
+ *
+ * If "worker" is given, the item cache uses the dedicated consumer thread.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <seap.h>
+#include <probe-api.h>
+#include "probe/probe.h"
+
+#define FAIL(ret, ...)                                        \
+        do {                                                  \
+                fprintf (stderr, "FAIL: " __VA_ARGS__);       \
+                exit (ret);                                   \
+        } while (0)
+
+#define BATCH_SIZE 100000
+#define DUP_COUNT  1000
+
+static SEXP_t *synthetic_item(size_t i)
+{
+	char value[64];
+
+	snprintf(value, sizeof value, "synthetic value #%zu", i);
+
+	return probe_item_create((oval_subtype_t) OVAL_INDEPENDENT_ENVIRONMENT_VARIABLE, NULL,
+	                         "name",  OVAL_DATATYPE_STRING, "BENCH",
+	                         "value", OVAL_DATATYPE_STRING, value,
+	                         NULL);
+}
+
+static double elapsed(const struct timespec *beg, const struct timespec *end)
+{
+	return (double)(end->tv_sec - beg->tv_sec) +
+	       (double)(end->tv_nsec - beg->tv_nsec) / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+	struct probe_ctx ctx;
+	struct timespec  t_beg, t_batch, t_now;
+	SEXP_t *cobj, *items, *dups[DUP_COUNT];
+	size_t  count, i, collected;
+	bool    worker;
+
+	count  = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+	worker = argc > 2 && strcmp(argv[2], "worker") == 0;
+
+	memset(&ctx, 0, sizeof ctx);
+
+	if (worker) {
+		if (pthread_barrier_init(&OSCAP_GSYM(th_barrier), NULL, 2) != 0)
+			FAIL(1, "pthread_barrier_init\n");
+	}
+
+	ctx.icache = probe_icache_new(worker);
+
+	if (ctx.icache == NULL)
+		FAIL(1, "probe_icache_new\n");
+
+	if (worker)
+		pthread_barrier_wait(&OSCAP_GSYM(th_barrier));
+
+	cobj = probe_cobj_new(SYSCHAR_FLAG_UNKNOWN, NULL, NULL, NULL);
+	ctx.probe_out = cobj;
+
+	clock_gettime(CLOCK_MONOTONIC, &t_beg);
+	t_batch = t_beg;
+
+	for (i = 0; i < count; ++i) {
+		if (probe_item_collect(&ctx, synthetic_item(i)) < 0)
+			FAIL(1, "probe_item_collect failed at item %zu\n", i);
+
+		if ((i + 1) % BATCH_SIZE == 0) {
+			clock_gettime(CLOCK_MONOTONIC, &t_now);
+			printf("%zu items: %.3f s (batch: %.3f s)\n", i + 1,
+			       elapsed(&t_beg, &t_now), elapsed(&t_batch, &t_now));
+			t_batch = t_now;
+		}
+	}
+
+	probe_icache_nop(ctx.icache);
+	clock_gettime(CLOCK_MONOTONIC, &t_now);
+
+	items = probe_cobj_get_items(cobj);
+	collected = SEXP_list_length(items);
+	SEXP_free(items);
+
+	printf("collected %zu of %zu items in %.3f s\n", collected, count,
+	       elapsed(&t_beg, &t_now));
+
+	if (collected != ctx.cobj_itemcnt)
+		FAIL(1, "item count mismatch: %zu != %zu\n", collected, ctx.cobj_itemcnt);
+
+	if (collected != count && probe_cobj_get_flag(cobj) != SYSCHAR_FLAG_INCOMPLETE)
+		FAIL(1, "%zu items missing\n", count - collected);
+
+	/*
+	 * Items equal to already cached ones must be replaced
+	 * by the cached items, i.e. they must get the same ID.
+	 */
+	if (collected == count && count >= DUP_COUNT) {
+		for (i = 0; i < DUP_COUNT; ++i)
+			dups[i] = synthetic_item(i);
+
+		if (probe_icache_add_batch(ctx.icache, cobj, dups, DUP_COUNT) != 0)
+			FAIL(1, "probe_icache_add_batch\n");
+
+		probe_icache_nop(ctx.icache);
+		items = probe_cobj_get_items(cobj);
+
+		for (i = 1; i <= DUP_COUNT; ++i) {
+			SEXP_t *orig, *dup, *orig_id, *dup_id;
+
+			orig = SEXP_list_nth(items, i);
+			dup  = SEXP_list_nth(items, count + i);
+			orig_id = probe_obj_getattrval(orig, "id");
+			dup_id  = probe_obj_getattrval(dup, "id");
+
+			if (orig_id == NULL || dup_id == NULL || SEXP_string_cmp(orig_id, dup_id) != 0)
+				FAIL(1, "item #%zu was not deduplicated\n", i);
+
+			SEXP_vfree(orig, dup, orig_id, dup_id, NULL);
+		}
+
+		SEXP_free(items);
+	}
+
+	probe_icache_free(ctx.icache);
+	SEXP_free(cobj);
+
+	return (0);
+}
@@ -0,0 +1,70 @@
+#!/usr/bin/env bash
+
+# Measures how long "oscap cvrf eval" takes on a synthetic CVRF document.
+#
+# Not a part of the test suite, run it by hand:
+#
+#   benchmark_cvrf_eval.sh [vulnerabilities] [packages]
+#
+# vulnerabilities - number of vulnerabilities in the document (default 1000)
+# packages        - number of packages of the evaluated product (default 1000)
+#
+# Every vulnerability is fixed in every other package of the evaluated
+# product and lists the same packages of another product, so that the
+# product statuses are long. OSCAP may point to the oscap binary, "oscap"
+# from PATH is used otherwise.
+
+VULNS=${1:-1000}
+PACKAGES=${2:-1000}
+OSCAP=${OSCAP:-oscap}
+
+# the product "oscap cvrf eval" evaluates
+OS_NAME="Red Hat Enterprise Linux Desktop Supplementary (v. 6)"
+OS_ID="6Client-Supplementary"
+OTHER_ID="6Server-Supplementary"
+
+set -e
+
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+awk -v vulns=$VULNS -v packages=$PACKAGES -v os_name="$OS_NAME" \
+	-v os_id=$OS_ID -v other_id=$OTHER_ID '
+BEGIN {
+	print "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+	print "<cvrfdoc xmlns=\"http://www.icasi.org/CVRF/schema/cvrf/1.1\" xmlns:cvrf=\"http://www.icasi.org/CVRF/schema/cvrf/1.1\">"
+	print "<DocumentTitle xml:lang=\"en\">Synthetic advisory</DocumentTitle>"
+	print "<DocumentType>Security Advisory</DocumentType>"
+	print "<DocumentPublisher Type=\"Vendor\"><ContactDetails>none</ContactDetails><IssuingAuthority>none</IssuingAuthority></DocumentPublisher>"
+	print "<DocumentTracking><Identification><ID>SYNTHETIC-1</ID></Identification><Status>Final</Status><Version>1</Version>"
+	print "<RevisionHistory><Revision><Number>1</Number><Date>2017-01-01T00:00:00Z</Date><Description>Initial</Description></Revision></RevisionHistory>"
+	print "<InitialReleaseDate>2017-01-01T00:00:00Z</InitialReleaseDate><CurrentReleaseDate>2017-01-01T00:00:00Z</CurrentReleaseDate></DocumentTracking>"
+	print "<ProductTree xmlns=\"http://www.icasi.org/CVRF/schema/prod/1.1\">"
+	print "<Branch Type=\"Product Family\" Name=\"Red Hat Enterprise Linux\">"
+	printf "<Branch Type=\"Product Name\" Name=\"%s\"><FullProductName ProductID=\"%s\">cpe:/a:redhat:rhel_desktop_supplementary:6</FullProductName></Branch>\n", os_name, os_id
+	printf "<Branch Type=\"Product Name\" Name=\"Other\"><FullProductName ProductID=\"%s\">cpe:/a:redhat:rhel_server_supplementary:6</FullProductName></Branch>\n", other_id
+	print "</Branch>"
+	for (p = 0; p < packages; p++)
+		printf "<Branch Type=\"Product Version\" Name=\"package%d-1.0-1.el6\"><FullProductName ProductID=\"package%d-1.0-1.el6\">package%d-1.0-1.el6</FullProductName></Branch>\n", p, p, p
+	for (p = 0; p < packages; p++) {
+		printf "<Relationship ProductReference=\"package%d-1.0-1.el6\" RelationType=\"Default Component Of\" RelatesToProductReference=\"%s\"><FullProductName ProductID=\"%s:package%d-1.0-1.el6\">package%d</FullProductName></Relationship>\n", p, os_id, os_id, p, p
+		printf "<Relationship ProductReference=\"package%d-1.0-1.el6\" RelationType=\"Default Component Of\" RelatesToProductReference=\"%s\"><FullProductName ProductID=\"%s:package%d-1.0-1.el6\">package%d</FullProductName></Relationship>\n", p, other_id, other_id, p, p
+	}
+	print "</ProductTree>"
+	for (v = 0; v < vulns; v++) {
+		printf "<Vulnerability Ordinal=\"%d\" xmlns=\"http://www.icasi.org/CVRF/schema/vuln/1.1\"><CVE>CVE-2017-%d</CVE><ProductStatuses><Status Type=\"Fixed\">", v + 1, 10000 + v
+		for (p = v % 2; p < packages; p += 2)
+			printf "<ProductID>%s:package%d-1.0-1.el6</ProductID><ProductID>%s:package%d-1.0-1.el6</ProductID>", other_id, p, os_id, p
+		print "</Status></ProductStatuses></Vulnerability>"
+	}
+	print "</cvrfdoc>"
+}' > "$WORK_DIR/cvrf.xml"
+
+start=$(date +%s.%N)
+"$OSCAP" cvrf eval --results "$WORK_DIR/results.xml" "$WORK_DIR/cvrf.xml"
+end=$(date +%s.%N)
+
+fixed=$(grep -o "<VulnerabilityStatus>FIXED<" "$WORK_DIR/results.xml" | wc -l)
+vulnerable=$(grep -o "<VulnerabilityStatus>VULNERABLE<" "$WORK_DIR/results.xml" | wc -l)
+awk -v v=$VULNS -v p=$PACKAGES -v s=$start -v e=$end -v f=$fixed -v n=$vulnerable \
+	'BEGIN { printf "%d vulnerabilities, %d packages: %.2f s, %d fixed, %d vulnerable\n", v, p, e - s, f, n }'
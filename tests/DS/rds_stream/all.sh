@@ -0,0 +1,28 @@
+#!/bin/bash
+
+set -e -o pipefail
+
+. $builddir/tests/test_common.sh
+
+# The streamed result data stream has to be the same as the one built in memory.
+function test_rds_stream {
+    local SDS_FILE="$srcdir/../$1"
+    local XCCDF_RESULT_FILE="$srcdir/../$2"
+    shift 2
+    local DS_TARGET_DIR="$(mktemp -d)"
+
+    ./test_rds_stream "$SDS_FILE" "$XCCDF_RESULT_FILE" "$DS_TARGET_DIR/dom.xml" "$DS_TARGET_DIR/stream.xml" "$@"
+    cmp "$DS_TARGET_DIR/dom.xml" "$DS_TARGET_DIR/stream.xml"
+
+    rm -r "$DS_TARGET_DIR"
+}
+
+test_init rds_stream.log
+
+if [ -z ${CUSTOM_OSCAP+x} ] ; then
+    test_run "rds_stream_simple" test_rds_stream rds_simple/sds.xml rds_simple/results-xccdf.xml
+    test_run "rds_stream_oval" test_rds_stream rds_simple/sds.xml rds_simple/results-xccdf.xml scap-fedora14-oval.xml "$srcdir/../rds_simple/results-oval.xml"
+    test_run "rds_stream_testresult" test_rds_stream rds_testresult/sds.xml rds_testresult/results-xccdf.xml
+fi
+
+test_exit
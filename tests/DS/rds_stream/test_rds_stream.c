@@ -0,0 +1,89 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "oscap_source.h"
+#include "common/list.h"
+#include "common/util.h"
+#include "DS/rds_priv.h"
+
+/*
+ * Create the result data stream from the given files twice, once built in
+ * memory and once streamed, so that the outputs can be compared.
+ */
+static int create_rds(const char *sds_file, const char *xccdf_result_file, const char *oval_href, const char *oval_result_file, const char *target_file, bool streamed)
+{
+	struct oscap_source *sds_source = oscap_source_new_from_file(sds_file);
+	struct oscap_source *xccdf_result_source = oscap_source_new_from_file(xccdf_result_file);
+	struct oscap_htable *oval_result_sources = oscap_htable_new();
+	struct oscap_htable *oval_result_mapping = oscap_htable_new();
+	struct oscap_htable *arf_report_mapping = oscap_htable_new();
+
+	if (oval_result_file != NULL) {
+		oscap_htable_add(oval_result_sources, oval_result_file, oscap_source_new_from_file(oval_result_file));
+		oscap_htable_add(oval_result_mapping, oval_href, oscap_strdup(oval_result_file));
+		oscap_htable_add(arf_report_mapping, oval_href, oscap_strdup("oval0"));
+	}
+
+	int ret = -1;
+	if (streamed) {
+		ret = ds_rds_export(sds_source, xccdf_result_source, oval_result_sources, oval_result_mapping, arf_report_mapping, target_file);
+	} else {
+		struct oscap_source *rds_source = ds_rds_create_source(sds_source, xccdf_result_source, oval_result_sources, oval_result_mapping, arf_report_mapping, target_file);
+		if (rds_source != NULL) {
+			ret = oscap_source_save_as(rds_source, NULL);
+			oscap_source_free(rds_source);
+		}
+	}
+
+	oscap_htable_free(oval_result_sources, (oscap_destruct_func) oscap_source_free);
+	oscap_htable_free(oval_result_mapping, (oscap_destruct_func) free);
+	oscap_htable_free(arf_report_mapping, (oscap_destruct_func) free);
+	oscap_source_free(sds_source);
+	oscap_source_free(xccdf_result_source);
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc != 5 && argc != 7) {
+		printf("Invalid arguments, usage: ./test_rds_stream SDS XCCDF_RESULT DOM_TARGET STREAM_TARGET [OVAL_HREF OVAL_RESULT]\n");
+		return 2;
+	}
+
+	const char *oval_href = argc == 7 ? argv[5] : NULL;
+	const char *oval_result_file = argc == 7 ? argv[6] : NULL;
+
+	if (create_rds(argv[1], argv[2], oval_href, oval_result_file, argv[3], false) != 0) {
+		printf("Failed to create the result data stream in memory.\n");
+		return 1;
+	}
+	if (create_rds(argv[1], argv[2], oval_href, oval_result_file, argv[4], true) != 0) {
+		printf("Failed to stream the result data stream.\n");
+		return 1;
+	}
+	return 0;
+}
@@ -29,6 +29,48 @@ function test_eval_cpe {
     rm $stdout $stderr
 }
 
+function test_eval_cache {
+    local cache_dir=$(mktemp -d -t ${name}.cache.XXXXXX)
+    local content=$(mktemp -t ${name}.sds.XXXXXX)
+    local result1=$(mktemp -t ${name}.res1.XXXXXX)
+    local result2=$(mktemp -t ${name}.res2.XXXXXX)
+    local log=$(mktemp -t ${name}.log.XXXXXX)
+    local stderr=$(mktemp -t ${name}.err.XXXXXX)
+    cp "${srcdir}/$1" $content
+
+    OSCAP_CONTENT_CACHE_DIR=$cache_dir $OSCAP xccdf eval --results $result1 $content 2> $stderr
+    diff /dev/null $stderr
+    [ $(ls $cache_dir | wc -l) -eq 1 ]
+    local entry=$(ls $cache_dir)
+    [ -f $cache_dir/$entry/manifest ]
+
+    # The second evaluation loads the components from the cache
+    OSCAP_CONTENT_CACHE_DIR=$cache_dir $OSCAP xccdf eval --verbose INFO --verbose-log-file $log \
+        --results $result2 $content 2> $stderr
+    diff /dev/null $stderr
+    grep -q "from the content cache" $log
+    [ "$(ls $cache_dir)" == "$entry" ]
+    diff <(sed -E 's/(start-time|end-time|time)="[^"]*"//g' $result1) \
+        <(sed -E 's/(start-time|end-time|time)="[^"]*"//g' $result2)
+
+    # Entries writable by others are ignored
+    chmod g+w $cache_dir/$entry/manifest
+    OSCAP_CONTENT_CACHE_DIR=$cache_dir $OSCAP xccdf eval --verbose INFO --verbose-log-file $log \
+        --results $result2 $content 2> $stderr
+    [ $(grep -c "from the content cache" $log) -eq 0 ]
+    grep -q "writable by others" $log
+    chmod g-w $cache_dir/$entry/manifest
+
+    # A modified content gets a new entry
+    echo "<!-- modified -->" >> $content
+    OSCAP_CONTENT_CACHE_DIR=$cache_dir $OSCAP xccdf eval $content 2> $stderr
+    diff /dev/null $stderr
+    [ $(ls $cache_dir | wc -l) -eq 2 ]
+
+    rm -rf $cache_dir
+    rm $content $result1 $result2 $log $stderr
+}
+
 function test_invalid_eval {
     local ret=0
     $OSCAP xccdf eval "${srcdir}/$1" || ret=$?
@@ -162,6 +204,7 @@ test_run "sds_external_xccdf" test_sds_external_xccdf sds_external_xccdf sds_ext
 test_run "sds_tailoring" test_sds_tailoring sds_tailoring sds_tailoring/sds.ds.xml scap_com.example_datastream_with_tailoring xccdf_com.example_cref_tailoring_01 xccdf_com.example_profile_tailoring
 
 test_run "eval_simple" test_eval eval_simple/sds.xml
+test_run "eval_cache" test_eval_cache eval_simple/sds.xml
 test_run "cpe_in_ds" test_eval cpe_in_ds/sds.xml
 test_run "eval_invalid" test_invalid_eval eval_invalid/sds.xml
 test_run "eval_invalid_oval" test_invalid_oval_eval eval_invalid/sds-oval.xml
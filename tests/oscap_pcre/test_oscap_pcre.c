@@ -0,0 +1,203 @@
+/*
+ * Copyright 2015 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "common/oscap_pcre.h"
+
+#define THREAD_COUNT 4
+#define THREAD_ROUNDS 2000
+
+int test_hits_and_misses(void);
+int test_options(void);
+int test_invalid_pattern(void);
+int test_eviction(void);
+int test_threads(void);
+
+static int match(struct oscap_pcre *re, const char *str)
+{
+	return oscap_pcre_exec(re, str, strlen(str), 0, 0, NULL, 0) >= 0;
+}
+
+int test_hits_and_misses()
+{
+	struct oscap_pcre *re1, *re2;
+	size_t hits, misses;
+
+	oscap_pcre_cache_clear();
+	oscap_pcre_cache_stats(&hits, &misses);
+
+	re1 = oscap_pcre_compile("^ab+c$", 0, NULL, NULL);
+	re2 = oscap_pcre_compile("^ab+c$", 0, NULL, NULL);
+	if (re1 == NULL || re1 != re2) {
+		fprintf(stderr, "The compiled pattern wasn't reused.\n");
+		return 1;
+	}
+	if (!match(re1, "abbbc") || match(re2, "ac")) {
+		fprintf(stderr, "Unexpected match result.\n");
+		return 1;
+	}
+	oscap_pcre_free(re1);
+	oscap_pcre_free(re2);
+
+	oscap_pcre_cache_stats(&hits, &misses);
+	if (hits != 1 || misses != 1) {
+		fprintf(stderr, "Unexpected counters: hits=%zu, misses=%zu.\n", hits, misses);
+		return 1;
+	}
+	return 0;
+}
+
+int test_options()
+{
+	struct oscap_pcre *re1, *re2;
+	int ret = 0;
+
+	re1 = oscap_pcre_compile("^abc$", 0, NULL, NULL);
+	re2 = oscap_pcre_compile("^abc$", PCRE_CASELESS, NULL, NULL);
+	if (re1 == re2 || match(re1, "ABC") || !match(re2, "ABC")) {
+		fprintf(stderr, "Compile options are not a part of the key.\n");
+		ret = 1;
+	}
+	oscap_pcre_free(re1);
+	oscap_pcre_free(re2);
+	return ret;
+}
+
+int test_invalid_pattern()
+{
+	struct oscap_pcre *re;
+	const char *err = NULL;
+	int errofs = -1;
+	size_t misses1, misses2;
+
+	oscap_pcre_cache_stats(NULL, &misses1);
+	for (int i = 0; i < 2; i++) {
+		re = oscap_pcre_compile("a(b", 0, &err, &errofs);
+		if (re != NULL || err == NULL || errofs != 3) {
+			fprintf(stderr, "Invalid pattern wasn't reported.\n");
+			return 1;
+		}
+	}
+	oscap_pcre_cache_stats(NULL, &misses2);
+	if (misses2 - misses1 != 2) {
+		fprintf(stderr, "Invalid pattern was cached.\n");
+		return 1;
+	}
+	return 0;
+}
+
+int test_eviction()
+{
+	struct oscap_pcre *first, *re;
+	char pattern[32];
+	size_t hits1, hits2;
+
+	first = oscap_pcre_compile("^pattern-0$", 0, NULL, NULL);
+	for (int i = 1; i <= OSCAP_PCRE_CACHE_MAX; i++) {
+		snprintf(pattern, sizeof(pattern), "^pattern-%d$", i);
+		re = oscap_pcre_compile(pattern, 0, NULL, NULL);
+		oscap_pcre_free(re);
+	}
+	/* The evicted pattern has to stay usable until it is released */
+	if (!match(first, "pattern-0")) {
+		fprintf(stderr, "Evicted pattern in use was destroyed.\n");
+		return 1;
+	}
+	oscap_pcre_cache_stats(&hits1, NULL);
+	re = oscap_pcre_compile("^pattern-0$", 0, NULL, NULL);
+	oscap_pcre_cache_stats(&hits2, NULL);
+	if (re == NULL || re == first || hits2 != hits1) {
+		fprintf(stderr, "The least recently used pattern wasn't evicted.\n");
+		return 1;
+	}
+	oscap_pcre_free(first);
+	oscap_pcre_free(re);
+	return 0;
+}
+
+static void *worker(void *arg)
+{
+	char pattern[32], str[32];
+	long id = (long) arg;
+
+	for (int i = 0; i < THREAD_ROUNDS; i++) {
+		int n = (i * 7 + id) % (OSCAP_PCRE_CACHE_MAX + 32);
+		struct oscap_pcre *re;
+
+		snprintf(pattern, sizeof(pattern), "^t%d$", n);
+		snprintf(str, sizeof(str), "t%d", n);
+		re = oscap_pcre_compile(pattern, PCRE_UTF8, NULL, NULL);
+		if (re == NULL || !match(re, str))
+			return (void *) 1;
+		oscap_pcre_free(re);
+	}
+	return NULL;
+}
+
+int test_threads()
+{
+	pthread_t threads[THREAD_COUNT];
+	void *ret;
+	int retval = 0;
+
+	for (long i = 0; i < THREAD_COUNT; i++)
+		pthread_create(&threads[i], NULL, worker, (void *) i);
+	for (int i = 0; i < THREAD_COUNT; i++) {
+		pthread_join(threads[i], &ret);
+		if (ret != NULL)
+			retval = 1;
+	}
+	if (retval != 0)
+		fprintf(stderr, "Concurrent matching failed.\n");
+	return retval;
+}
+
+int main (int argc, char *argv[])
+{
+	int retval = 0;
+	if ((retval = test_hits_and_misses()) != 0 ) {
+		return retval;
+	}
+
+	if ((retval = test_options()) != 0 ) {
+		return retval;
+	}
+
+	if ((retval = test_invalid_pattern()) != 0 ) {
+		return retval;
+	}
+
+	if ((retval = test_eviction()) != 0 ) {
+		return retval;
+	}
+
+	if ((retval = test_threads()) != 0 ) {
+		return retval;
+	}
+
+	oscap_pcre_cache_clear();
+	return retval;
+}
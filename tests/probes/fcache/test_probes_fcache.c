@@ -0,0 +1,87 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "oval_agent_api.h"
+#include "oval_probe.h"
+#include "oval_probe_session.h"
+#include "oscap_source.h"
+
+/*
+ * Collects all the objects of the definition model and exports the
+ * collected system characteristics.
+ */
+static int collect(oval_probe_session_t *sess, struct oval_definition_model *def_model,
+		   struct oval_syschar_model *sys_model, const char *file)
+{
+	struct oval_object_iterator *obj_it;
+	int ret = 0;
+
+	obj_it = oval_definition_model_get_objects(def_model);
+
+	while (oval_object_iterator_has_more(obj_it)) {
+		struct oval_object *obj = oval_object_iterator_next(obj_it);
+
+		if (oval_probe_query_object(sess, obj, 0, NULL) != 0)
+			ret = -1;
+	}
+
+	oval_object_iterator_free(obj_it);
+
+	if (oval_syschar_model_export(sys_model, file) < 0)
+		ret = -1;
+
+	return ret;
+}
+
+/*
+ * Collects the objects of the definitions twice in one probe session, the
+ * probes are reset between the scans. The optional command is run before
+ * the second scan, e.g. to change the collected files.
+ */
+int main(int argc, char *argv[])
+{
+	struct oscap_source *source;
+	struct oval_definition_model *def_model;
+	struct oval_syschar_model *sys_model[2];
+	oval_probe_session_t *sess;
+
+	if (argc < 4 || argc > 5) {
+		fprintf(stderr, "Usage: %s <definitions> <syschar 1> <syschar 2> [command]\n", argv[0]);
+		return 1;
+	}
+
+	source = oscap_source_new_from_file(argv[1]);
+	def_model = oval_definition_model_import_source(source);
+	oscap_source_free(source);
+	assert(def_model != NULL);
+
+	sys_model[0] = oval_syschar_model_new(def_model);
+	sys_model[1] = oval_syschar_model_new(def_model);
+	assert(sys_model[0] != NULL && sys_model[1] != NULL);
+
+	sess = oval_probe_session_new(sys_model[0]);
+	assert(sess != NULL);
+
+	if (collect(sess, def_model, sys_model[0], argv[2]) != 0)
+		return 1;
+
+	if (argc == 5 && system(argv[4]) != 0)
+		return 1;
+
+	if (oval_probe_session_reset(sess, sys_model[1]) != 0)
+		return 1;
+
+	if (collect(sess, def_model, sys_model[1], argv[3]) != 0)
+		return 1;
+
+	oval_probe_session_destroy(sess);
+	oval_syschar_model_free(sys_model[0]);
+	oval_syschar_model_free(sys_model[1]);
+	oval_definition_model_free(def_model);
+
+	return 0;
+}
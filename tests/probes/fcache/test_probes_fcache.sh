@@ -0,0 +1,99 @@
+#!/usr/bin/env bash
+
+# The file, fileextendedattribute and symlink probes look files up through
+# a metadata cache which is cleared when the probes are reset. The objects
+# are collected twice in one probe session, see test_probes_fcache.c.
+
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+function fcache_setup {
+    touch $1/some_file
+    echo "some content" > $1/some_file
+    chmod 0644 $1/some_file
+    if command -v setfattr > /dev/null; then
+        setfattr -n user.fooattr -v foo $1/some_file || true
+    fi
+    touch $1/other_file
+    ln -s $1/some_file $1/some_symlink
+
+    bash ${srcdir}/test_probes_fcache.xml.sh $1 > "$DF"
+}
+
+function test_probes_fcache_rescan {
+    probecheck "file" || return 255
+    probecheck "fileextendedattribute" || return 255
+    probecheck "symlink" || return 255
+
+    DF="test_probes_fcache.xml"
+    SC1="syschar1.xml"
+    SC2="syschar2.xml"
+
+    rm -f $SC1 $SC2
+
+    tmpdir=$(mktemp -t -d "test_fcache.XXXXXX")
+    fcache_setup $tmpdir
+
+    bash $builddir/run ./test_probes_fcache $DF $SC1 $SC2
+
+    # Nothing has changed, both scans collect the same items
+    diff <(grep -v "<oval:timestamp>" $SC1) <(grep -v "<oval:timestamp>" $SC2)
+
+    # The second object of each pair is collected from the cache
+    result=$SC1
+    p='oval_system_characteristics/collected_objects/object'
+    assert_exists 7 $p
+    assert_exists 1 $p'[@id="oval:1:obj:2"]/reference'
+    assert_exists 0 $p'[@id="oval:1:obj:2"]/reference[not(@item_ref=../../object[@id="oval:1:obj:1"]/reference/@item_ref)]'
+    assert_exists 0 $p'[@id="oval:1:obj:5"]/reference[not(@item_ref=../../object[@id="oval:1:obj:4"]/reference/@item_ref)]'
+    assert_exists 1 $p'[@id="oval:1:obj:7"]/reference'
+    assert_exists 0 $p'[@id="oval:1:obj:7"]/reference[not(@item_ref=../../object[@id="oval:1:obj:6"]/reference/@item_ref)]'
+
+    rm -rf $tmpdir
+    rm -f $DF $SC1 $SC2
+}
+
+function test_probes_fcache_reset {
+    probecheck "file" || return 255
+    probecheck "symlink" || return 255
+
+    DF="test_probes_fcache.xml"
+    SC1="syschar1.xml"
+    SC2="syschar2.xml"
+
+    rm -f $SC1 $SC2
+
+    tmpdir=$(mktemp -t -d "test_fcache.XXXXXX")
+    fcache_setup $tmpdir
+
+    # The files are changed between the scans, the reset drops the cached ones
+    bash $builddir/run ./test_probes_fcache $DF $SC1 $SC2 \
+         "chmod 0600 $tmpdir/some_file && echo 'more content' >> $tmpdir/some_file && ln -sfn $tmpdir/other_file $tmpdir/some_symlink"
+
+    p='oval_system_characteristics/system_data/'
+    file=$p'unix-sys:file_item[unix-sys:filepath="'$tmpdir/some_file'"]'
+    symlink=$p'unix-sys:symlink_item[unix-sys:filepath="'$tmpdir/some_symlink'"]'
+
+    result=$SC1
+    assert_exists 1 $file'/unix-sys:size[text()="13"]'
+    assert_exists 1 $file'/unix-sys:oread[text()="true"]'
+    assert_exists 1 $symlink'/unix-sys:canonical_path[text()="'$tmpdir/some_file'"]'
+
+    result=$SC2
+    assert_exists 1 $file'/unix-sys:size[text()="26"]'
+    assert_exists 1 $file'/unix-sys:oread[text()="false"]'
+    assert_exists 1 $symlink'/unix-sys:canonical_path[text()="'$tmpdir/other_file'"]'
+
+    rm -rf $tmpdir
+    rm -f $DF $SC1 $SC2
+}
+
+test_init
+
+if [ -z ${CUSTOM_OSCAP+x} ] ; then
+    test_run "file metadata cache across scans" test_probes_fcache_rescan
+    test_run "file metadata cache reset" test_probes_fcache_reset
+fi
+
+test_exit
@@ -0,0 +1,38 @@
+#!/bin/bash
+
+cat <<EOF
+<?xml version="1.0"?>
+<oval_definitions xmlns:oval-def="http://oval.mitre.org/XMLSchema/oval-definitions-5" xmlns:unix="http://oval.mitre.org/XMLSchema/oval-definitions-5#unix" xmlns:oval="http://oval.mitre.org/XMLSchema/oval-common-5" xmlns:xsi="http://www.w3.org/2001/XMLSchema-instance" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5" xsi:schemaLocation="http://oval.mitre.org/XMLSchema/oval-definitions-5#unix unix-definitions-schema.xsd http://oval.mitre.org/XMLSchema/oval-definitions-5 oval-definitions-schema.xsd http://oval.mitre.org/XMLSchema/oval-common-5 oval-common-schema.xsd">
+  <generator>
+    <oval:schema_version>5.11</oval:schema_version>
+    <oval:timestamp>0001-01-01T00:00:00+00:00</oval:timestamp>
+  </generator>
+
+  <objects>
+    <unix:file_object id="oval:1:obj:1" version="1">
+      <unix:filepath>$1/some_file</unix:filepath>
+    </unix:file_object>
+    <unix:file_object id="oval:1:obj:2" version="1">
+      <unix:filepath>$1/some_file</unix:filepath>
+    </unix:file_object>
+    <unix:file_object id="oval:1:obj:3" version="1">
+      <unix:path>$1</unix:path>
+      <unix:filename operation="pattern match">^some_</unix:filename>
+    </unix:file_object>
+    <unix:fileextendedattribute_object id="oval:1:obj:4" version="1">
+      <unix:filepath>$1/some_file</unix:filepath>
+      <unix:attribute_name operation="pattern match">.*</unix:attribute_name>
+    </unix:fileextendedattribute_object>
+    <unix:fileextendedattribute_object id="oval:1:obj:5" version="1">
+      <unix:filepath>$1/some_file</unix:filepath>
+      <unix:attribute_name operation="pattern match">.*</unix:attribute_name>
+    </unix:fileextendedattribute_object>
+    <unix:symlink_object id="oval:1:obj:6" version="1">
+      <unix:filepath>$1/some_symlink</unix:filepath>
+    </unix:symlink_object>
+    <unix:symlink_object id="oval:1:obj:7" version="1">
+      <unix:filepath>$1/some_symlink</unix:filepath>
+    </unix:symlink_object>
+  </objects>
+</oval_definitions>
+EOF
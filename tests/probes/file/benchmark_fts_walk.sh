@@ -0,0 +1,107 @@
+#!/usr/bin/env bash
+
+# Compares the time the file probe needs to traverse a large directory tree
+# using fts(3) and using the parallel traversal (OSCAP_PROBE_FTS_THREADS).
+#
+# Not a part of the test suite, run it by hand:
+#
+#   benchmark_fts_walk.sh [files] [threads] [dir]
+#
+# files   - number of files in the generated tree (default 5000000)
+# threads - number of traversal threads (default: number of CPUs)
+# dir     - where the tree is generated (default: a new temporary directory,
+#           removed afterwards); an existing tree of the same size is reused
+#
+# The tree consists of directories with 1000 files each, 100 directories per
+# parent directory. One file in every directory matches the file object, so
+# the time is spent on the traversal and not on collecting the items. OSCAP
+# may point to the oscap binary, "oscap" from PATH is used otherwise.
+
+FILES=${1:-5000000}
+THREADS=${2:-$(getconf _NPROCESSORS_ONLN)}
+TREE_DIR=$3
+OSCAP=${OSCAP:-oscap}
+
+PER_DIR=1000
+FANOUT=100
+
+set -e
+
+if [ -z "$TREE_DIR" ]; then
+	TREE_DIR=$(mktemp -d)
+	trap 'rm -rf "$TREE_DIR" "$WORK_DIR"' EXIT
+else
+	trap 'rm -rf "$WORK_DIR"' EXIT
+fi
+WORK_DIR=$(mktemp -d)
+
+generate_tree() {
+	local dirs=$(( (FILES + PER_DIR - 1) / PER_DIR ))
+	local d
+
+	echo "Generating $FILES files in $dirs directories below $TREE_DIR"
+	for (( d = 0; d < dirs; d++ )); do
+		local dir="$TREE_DIR/d$(( d / FANOUT ))/d$(( d % FANOUT ))"
+		local n=$PER_DIR
+
+		[ $(( (d + 1) * PER_DIR )) -gt $FILES ] && n=$(( FILES - d * PER_DIR ))
+		mkdir -p "$dir"
+		( cd "$dir" && touch match && seq -f "file%g" 2 $n | xargs touch )
+	done
+	echo "$FILES" > "$TREE_DIR/.benchmark_files"
+}
+
+if [ "$(cat "$TREE_DIR/.benchmark_files" 2>/dev/null)" != "$FILES" ]; then
+	generate_tree
+fi
+
+cat > "$WORK_DIR/benchmark.xml" <<EOF
+<?xml version="1.0"?>
+<oval_definitions xmlns:oval="http://oval.mitre.org/XMLSchema/oval-common-5" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5">
+	<generator>
+		<oval:schema_version>5.10.1</oval:schema_version>
+		<oval:timestamp>2008-03-31T00:00:00-00:00</oval:timestamp>
+	</generator>
+	<definitions>
+		<definition class="compliance" version="1" id="oval:1:def:1">
+			<metadata>
+				<title></title>
+				<description></description>
+			</metadata>
+			<criteria>
+				<criterion test_ref="oval:1:tst:1"/>
+			</criteria>
+		</definition>
+	</definitions>
+	<tests>
+		<file_test version="1" id="oval:1:tst:1" check="all" check_existence="any_exist" comment="true" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#unix">
+			<object object_ref="oval:1:obj:1"/>
+		</file_test>
+	</tests>
+	<objects>
+		<file_object version="1" id="oval:1:obj:1" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#unix">
+			<behaviors max_depth="-1" recurse="directories" recurse_direction="down"/>
+			<path>$TREE_DIR</path>
+			<filename operation="pattern match">^match$</filename>
+		</file_object>
+	</objects>
+</oval_definitions>
+EOF
+
+run() {
+	local label=$1 start end items
+
+	shift
+	start=$(date +%s.%N)
+	env "$@" "$OSCAP" oval eval --results "$WORK_DIR/results.xml" "$WORK_DIR/benchmark.xml" > /dev/null
+	end=$(date +%s.%N)
+	items=$(grep -c "<unix-sys:file_item " "$WORK_DIR/results.xml" || true)
+	awk -v l="$label" -v s="$start" -v e="$end" -v i="$items" \
+		'BEGIN { printf "%-12s %8.2f s  %d items\n", l, e - s, i }'
+}
+
+# warm up the inode and dentry caches, so that both runs see the same state
+"$OSCAP" oval eval "$WORK_DIR/benchmark.xml" > /dev/null
+
+run "fts" OSCAP_PROBE_FTS_THREADS=0
+run "$THREADS threads" OSCAP_PROBE_FTS_THREADS=$THREADS
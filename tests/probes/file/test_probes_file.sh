@@ -120,6 +120,65 @@ function test_probes_file_invalid_utf8 {
 	return $ret_val
 }
 
+function file_items_by_object {
+	# "object path filename" for every item of every object
+	awk '
+	/<object id=/ { match($0, /id="[^"]*"/); obj = substr($0, RSTART + 4, RLENGTH - 5) }
+	/<reference item_ref=/ { match($0, /item_ref="[^"]*"/); refs[obj] = refs[obj] " " substr($0, RSTART + 10, RLENGTH - 11) }
+	/<unix-sys:file_item / { match($0, /id="[^"]*"/); item = substr($0, RSTART + 4, RLENGTH - 5) }
+	/<unix-sys:(filepath|path|filename)/ { gsub(/^ */, ""); key[item] = key[item] $0 }
+	END { for (obj in refs) { n = split(refs[obj], ids, " "); for (i = 1; i <= n; i++) print obj, key[ids[i]] } }
+	' "$1" | sort
+}
+
+function test_probes_file_walk {
+
+	probecheck "file" || return 255
+
+	local ret_val=0
+	local DF="$srcdir/test_probes_file_walk.xml"
+	files_dir=$(mktemp -d)
+	DF_INJECTED=$(mktemp)
+
+	echo "Files dir:	${files_dir}"
+	echo "Content file:	${DF_INJECTED}"
+
+	# a tree with symlinks to a directory, to a file, to nowhere and
+	# to an ancestor
+	pushd "$files_dir" && {
+		mkdir -p a/b/c/d e/f g
+		for d in . a a/b a/b/c a/b/c/d e e/f g; do
+			for i in 1 2 3; do
+				echo x > $d/f$i
+				echo y > $d/h$i
+			done
+		done
+		ln -s ../e a/link_dir
+		ln -s ../f1 a/link_file
+		ln -s nowhere a/dangling
+		ln -s .. a/b/loop
+		mkfifo g/fifo
+		popd
+	}
+
+	sed "s;<!--injected-path -->;${files_dir};g" "$DF" > $DF_INJECTED
+
+	# the items collected using fts and using the parallel traversal
+	# have to be the same
+	$OSCAP oval eval --results results_fts.xml $DF_INJECTED || ret_val=1
+	OSCAP_PROBE_FTS_THREADS=4 $OSCAP oval eval --results results_walk.xml $DF_INJECTED || ret_val=1
+
+	file_items_by_object results_fts.xml > items_fts.txt
+	file_items_by_object results_walk.xml > items_walk.txt
+	[ -s items_fts.txt ] || ret_val=1
+	diff items_fts.txt items_walk.txt || ret_val=1
+
+	rm -f $DF_INJECTED results_fts.xml results_walk.xml items_fts.txt items_walk.txt
+	rm -rf "$files_dir"
+
+	return $ret_val
+}
+
 # Testing.
 
 test_init
@@ -128,5 +187,6 @@ test_run "test_probes_file with verbose mode" test_probes_file verbose
 test_run "test_probes_file" test_probes_file
 test_run "test_probes_file_filenames" test_probes_file_filenames
 test_run "test_probes_file_invalid_utf8" test_probes_file_invalid_utf8
+test_run "test_probes_file_walk" test_probes_file_walk
 
 test_exit
@@ -9,4 +9,5 @@ test_run "Ensure loguid returns unsigned int (cat /proc/ID/loginuid)" $srcdir/lo
 test_run "Ensure sessionid is correct" $srcdir/sessionid.sh
 test_run "Ensure capabilities with OVAL 5.11" $srcdir/capability.sh
 test_run "Ensure that command_line is collected" $srcdir/command_line.sh
+test_run "Evaluate objects against the process table snapshot" $srcdir/snapshot.sh
 test_exit
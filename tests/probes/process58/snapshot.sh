@@ -0,0 +1,80 @@
+#!/bin/bash
+
+# Evaluating many process58 objects with and without the process table
+# snapshot. The elapsed times are printed, the number of objects can be
+# set with the PROCESS58_OBJECTS variable.
+
+set -e -o pipefail
+
+name=$(basename $0 .sh)
+tmpdir=$(mktemp -t -d "${name}.XXXXXX")
+input=${tmpdir}/${name}.xml
+objects=${PROCESS58_OBJECTS:-60}
+echo "Temp dir: $tmpdir"
+
+function clean_processes {
+	[ -n "${PIDS}" ] && kill ${PIDS}
+}
+trap clean_processes EXIT
+
+# Every even object looks a process up by its command line,
+# every odd one matches all the processes by a pattern.
+PIDS=""
+for i in $(seq 0 4); do
+	sleep 1000$i &
+	PIDS="$PIDS $!"
+done
+
+{
+	cat <<-EOT
+	<?xml version="1.0" encoding="UTF-8"?>
+	<oval_definitions xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5" xmlns:oval="http://oval.mitre.org/XMLSchema/oval-common-5" xmlns:unix="http://oval.mitre.org/XMLSchema/oval-definitions-5#unix">
+	  <generator>
+	    <oval:schema_version>5.11</oval:schema_version>
+	    <oval:timestamp>2015-08-08T22:19:00+02:00</oval:timestamp>
+	  </generator>
+	  <definitions>
+	    <definition id="oval:x:def:1" version="1" class="miscellaneous">
+	      <metadata><title>process58 snapshot</title><description>x</description></metadata>
+	      <criteria>
+	EOT
+	for i in $(seq 1 $objects); do
+		echo "        <criterion test_ref=\"oval:x:tst:$i\"/>"
+	done
+	echo "      </criteria>"
+	echo "    </definition>"
+	echo "  </definitions>"
+	echo "  <tests>"
+	for i in $(seq 1 $objects); do
+		echo "    <unix:process58_test id=\"oval:x:tst:$i\" version=\"1\" check=\"all\" comment=\"x\"><unix:object object_ref=\"oval:x:obj:$i\"/></unix:process58_test>"
+	done
+	echo "  </tests>"
+	echo "  <objects>"
+	for i in $(seq 1 $objects); do
+		if [ $((i % 2)) -eq 0 ]; then
+			cmd="<unix:command_line>sleep 1000$((i % 5))</unix:command_line>"
+		else
+			cmd="<unix:command_line operation=\"pattern match\">^sleep 1000[0-4]\$</unix:command_line>"
+		fi
+		echo "    <unix:process58_object id=\"oval:x:obj:$i\" version=\"1\">$cmd<unix:pid datatype=\"int\" operation=\"greater than\">$i</unix:pid></unix:process58_object>"
+	done
+	echo "  </objects>"
+	echo "</oval_definitions>"
+} > $input
+
+for snapshot in 0 1; do
+	result=${tmpdir}/${name}.results.${snapshot}.xml
+
+	echo "Evaluating content, OSCAP_PROBE_PROC_SNAPSHOT=${snapshot}."
+	start=$(date +%s%N)
+	OSCAP_PROBE_PROC_SNAPSHOT=$snapshot $OSCAP oval eval --results $result $input
+	end=$(date +%s%N)
+	echo "Elapsed time: $(( (end - start) / 1000000 )) ms"
+
+	echo "Testing syschar values."
+	[ "$($XPATH $result 'count(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:1"]/reference)')" == "5" ]
+	[ "$($XPATH $result 'count(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:2"]/reference)')" == "1" ]
+	[ "$($XPATH $result "count(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id='oval:x:obj:${objects}']/reference)")" == "$(( objects % 2 ? 5 : 1 ))" ]
+done
+
+rm -rf $tmpdir
@@ -5,4 +5,5 @@
 test_init test_probes_sysctl.log
 test_run "test sysctl probe" $srcdir/test_sysctl_probe.sh
 test_run "test sysctl probe that collects everything" $srcdir/test_sysctl_probe_all.sh
+test_run "test sysctl probe direct lookup and index" $srcdir/test_sysctl_probe_equals.sh
 test_exit
@@ -0,0 +1,68 @@
+#!/bin/bash
+
+# The "equals" operation reads the sysctls directly, other operations
+# use the index of /proc/sys. Both have to collect the same items.
+
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+probecheck "sysctl" || return 255
+
+name=$(basename $0 .sh)
+
+tmpdir=$(mktemp -t -d "${name}.XXXXXX")
+input=${tmpdir}/${name}.oval.xml
+echo "Temp dir: $tmpdir"
+
+# collect all sysctls using the index
+$OSCAP oval eval --results ${tmpdir}/all.xml $srcdir/test_sysctl_probe_all.oval.xml > /dev/null 2>${tmpdir}/all.err
+
+grep unix-sys:name ${tmpdir}/all.xml | sed -E 's;.*>(.*)<.*;\1;g' | sort > ${tmpdir}/all.names
+[ -s ${tmpdir}/all.names ]
+
+# collect each of them by an "equals" object
+{
+	cat <<-EOT
+	<?xml version="1.0" encoding="UTF-8"?>
+	<oval_definitions xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5" xmlns:oval="http://oval.mitre.org/XMLSchema/oval-common-5" xmlns:unix="http://oval.mitre.org/XMLSchema/oval-definitions-5#unix">
+	  <generator>
+	    <oval:schema_version>5.10</oval:schema_version>
+	    <oval:timestamp>2015-12-08T08:08:08+01:00</oval:timestamp>
+	  </generator>
+	  <definitions>
+	    <definition class="compliance" id="oval:oscap:def:1" version="1">
+	      <metadata><title>sysctl equals</title><description>x</description></metadata>
+	      <criteria>
+	EOT
+	i=0
+	for mib in $(uniq ${tmpdir}/all.names); do
+		i=$((i + 1))
+		echo "        <criterion test_ref=\"oval:oscap:tst:$i\"/>"
+	done
+	echo "      </criteria>"
+	echo "    </definition>"
+	echo "  </definitions>"
+	echo "  <tests>"
+	for j in $(seq 1 $i); do
+		echo "    <unix:sysctl_test id=\"oval:oscap:tst:$j\" version=\"1\" check=\"all\" comment=\"x\"><unix:object object_ref=\"oval:oscap:obj:$j\"/></unix:sysctl_test>"
+	done
+	echo "  </tests>"
+	echo "  <objects>"
+	i=0
+	for mib in $(uniq ${tmpdir}/all.names); do
+		i=$((i + 1))
+		echo "    <unix:sysctl_object id=\"oval:oscap:obj:$i\" version=\"1\"><unix:name>$mib</unix:name></unix:sysctl_object>"
+	done
+	echo "  </objects>"
+	echo "</oval_definitions>"
+} > $input
+
+$OSCAP oval eval --results ${tmpdir}/equals.xml $input > /dev/null 2>${tmpdir}/equals.err
+
+grep unix-sys:name ${tmpdir}/equals.xml | sed -E 's;.*>(.*)<.*;\1;g' | sort > ${tmpdir}/equals.names
+
+diff ${tmpdir}/all.names ${tmpdir}/equals.names
+[ "$(grep -c 'sysctl_item.*status="error"' ${tmpdir}/all.xml || true)" == "$(grep -c 'sysctl_item.*status="error"' ${tmpdir}/equals.xml || true)" ]
+
+rm -rf $tmpdir
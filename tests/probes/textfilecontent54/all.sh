@@ -7,4 +7,7 @@ test_run "textfilecontent54 general functionality" $srcdir/test_probes_textfilec
 test_run "validate OVAL definitions of various schema versions" $srcdir/test_validation_of_various_oval_versions.sh
 test_run "test behavior on symlinks" $srcdir/test_symlinks.sh
 test_run "test multiline behavior" $srcdir/test_behavior_multiline.sh
+test_run "test matching in a large file" $srcdir/test_large_file.sh
+test_run "test incremental scans" $srcdir/test_rescan.sh
+test_run "test a chain of set objects" $srcdir/test_set_chain.sh
 test_exit
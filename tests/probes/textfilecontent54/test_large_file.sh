@@ -0,0 +1,50 @@
+#!/bin/bash
+
+# Matching patterns against a large log file, which is read in parts by
+# the probe. The number of lines can be set with the TFC54_LINES variable,
+# the elapsed time is printed if the TFC54_TIME variable is set.
+
+set -e -o pipefail
+
+name=$(basename $0 .sh)
+tmpdir=$(mktemp -t -d "${name}.XXXXXX")
+tpl=${srcdir}/${name}.xml.tpl
+input=${tmpdir}/${name}.xml
+result=${tmpdir}/${name}.results.xml
+lines=${TFC54_LINES:-200000}
+echo "Temp dir: $tmpdir"
+
+# prepare the environment
+sed "s@%PATH%@${tmpdir}@" $tpl > $input
+awk -v n=$lines 'BEGIN {
+	for (i = 1; i <= n; i++) {
+		if (i % (n / 4) == 0)
+			printf("type=USER_AUTH msg=audit(1500000000.%03d:%d): pid=%d uid=0 auid=1000 msg=\x27op=PAM:authentication acct=\"user\" exe=\"/usr/sbin/sshd\" res=failed\x27 res=failed\n", i % 1000, i, i);
+		else
+			printf("type=SYSCALL msg=audit(1500000000.%03d:%d): arch=c000003e syscall=59 success=yes exit=0 ppid=1 pid=%d auid=1000 uid=0 comm=\"bash\" exe=\"/usr/bin/bash\" key=\"exec\"\n", i % 1000, i, i);
+	}
+	printf("type=SYSCALL msg=audit(1500000000.000:0): arch=c000003e syscall=59 key=\"last\"\n");
+}' > "${tmpdir}/audit.log"
+printf 'type=SYSCALL msg=audit(1500000000.000:1): comm="caf\xe9"\n' > "${tmpdir}/latin1.log"
+ls -l "${tmpdir}/audit.log"
+
+echo "Evaluating content."
+start=$(date +%s%N)
+$OSCAP oval eval --results $result $input || [ $? == 2 ]
+end=$(date +%s%N)
+if [ -n "$TFC54_TIME" ]; then
+	echo "Elapsed time: $(( (end - start) / 1000000 )) ms"
+fi
+
+echo "Testing results."
+[ "$($XPATH $result 'string(/oval_results/results/system/tests/test[@test_id="oval:x:tst:1"]/@result)')" == "true" ]
+[ "$($XPATH $result 'string(/oval_results/results/system/tests/test[@test_id="oval:x:tst:2"]/@result)')" == "true" ]
+[ "$($XPATH $result 'string(/oval_results/results/system/tests/test[@test_id="oval:x:tst:3"]/@result)')" == "true" ]
+echo "Testing syschar values."
+[ "$($XPATH $result 'count(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:1"]/reference)')" == "4" ]
+[ "$($XPATH $result 'string(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:2"]/@flag)')" == "does not exist" ]
+[ "$($XPATH $result 'count(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:3"]/reference)')" == "1" ]
+[ "$($XPATH $result 'string(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:4"]/@flag)')" == "error" ]
+[ "$($XPATH $result 'count(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:5"]/reference)')" == "4" ]
+
+rm -rf $tmpdir
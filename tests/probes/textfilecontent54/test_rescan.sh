@@ -0,0 +1,59 @@
+#!/bin/bash
+
+# Incremental scans: objects of the previous scan whose inputs did not
+# change are reused, the objects of a modified file are probed again.
+
+set -e -o pipefail
+
+name=$(basename $0 .sh)
+tmpdir=$(mktemp -t -d "${name}.XXXXXX")
+tpl=${srcdir}/${name}.xml.tpl
+input=${tmpdir}/${name}.xml
+result=${tmpdir}/${name}.results.xml
+stdout=${tmpdir}/${name}.out
+echo "Temp dir: $tmpdir"
+
+export OSCAP_RESCAN_DIR=${tmpdir}/rescan
+
+# prepare the environment
+sed "s@%PATH%@${tmpdir}@" $tpl > $input
+echo "value = yes" > ${tmpdir}/a.conf
+echo "value = yes" > ${tmpdir}/b.conf
+
+function tst_result {
+	$XPATH $result "string(/oval_results/results/system/tests/test[@test_id=\"oval:x:tst:$1\"]/@result)"
+}
+
+echo "Evaluating content, the first scan."
+$OSCAP oval eval --results $result $input > $stdout
+grep -q "^Objects reused from the previous scan: 0, probed: 3$" $stdout
+[ "$(tst_result 1)" == "true" ]
+ls ${OSCAP_RESCAN_DIR}/*.fingerprints
+
+echo "Evaluating content, nothing has changed."
+$OSCAP oval eval --results $result $input > $stdout
+grep -q "^Objects reused from the previous scan: 3, probed: 0$" $stdout
+[ "$(tst_result 1)" == "true" ]
+[ "$(tst_result 2)" == "true" ]
+[ "$(tst_result 3)" == "true" ]
+[ "$($XPATH $result 'count(/oval_results/results/system/oval_system_characteristics/system_data/*)')" == "3" ]
+
+echo "Evaluating content, a.conf has changed."
+echo "value = no" > ${tmpdir}/a.conf
+$OSCAP oval eval --results $result $input > $stdout || [ $? == 2 ]
+grep -q "^Objects reused from the previous scan: 2, probed: 1$" $stdout
+[ "$(tst_result 1)" == "false" ]
+[ "$(tst_result 2)" == "true" ]
+
+echo "Evaluating content, an object has changed."
+sed -i "s@${tmpdir}/b.conf@${tmpdir}/a.conf@" $input
+$OSCAP oval eval --results $result $input > $stdout || [ $? == 2 ]
+grep -q "^Objects reused from the previous scan: 2, probed: 1$" $stdout
+[ "$($XPATH $result 'string(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:2"]/@flag)')" == "complete" ]
+
+echo "Evaluating content, the previous scan is writable by others."
+chmod g+w ${OSCAP_RESCAN_DIR}/*.fingerprints
+$OSCAP oval eval --results $result $input > $stdout || [ $? == 2 ]
+grep -q "^Objects reused from the previous scan: 0, probed: 3$" $stdout
+
+rm -rf $tmpdir
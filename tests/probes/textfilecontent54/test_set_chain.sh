@@ -0,0 +1,27 @@
+#!/bin/bash
+
+# A chain of set objects deeper than the number of probe worker threads.
+# The worker evaluating a set waits for the objects it references, those
+# have to be evaluated by other threads of the same probe.
+
+set -e -o pipefail
+
+name=$(basename $0 .sh)
+tmpdir=$(mktemp -t -d "${name}.XXXXXX")
+tpl=${srcdir}/${name}.xml.tpl
+input=${tmpdir}/${name}.xml
+result=${tmpdir}/${name}.results.xml
+echo "Temp dir: $tmpdir"
+
+export OSCAP_PROBE_MAX_THREADS=2
+
+# prepare the environment
+sed "s@%PATH%@${tmpdir}@" $tpl > $input
+echo "value = yes" > ${tmpdir}/a.conf
+
+echo "Evaluating content."
+timeout 120 $OSCAP oval eval --results $result $input
+[ "$($XPATH $result 'string(/oval_results/results/system/tests/test[@test_id="oval:x:tst:1"]/@result)')" == "true" ]
+[ "$($XPATH $result 'string(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:4"]/@flag)')" == "complete" ]
+
+rm -rf $tmpdir
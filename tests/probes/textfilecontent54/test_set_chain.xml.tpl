@@ -0,0 +1,55 @@
+<?xml version="1.0"?>
+<oval_definitions xmlns:oval-def="http://oval.mitre.org/XMLSchema/oval-definitions-5" xmlns:oval="http://oval.mitre.org/XMLSchema/oval-common-5" xmlns:xsi="http://www.w3.org/2001/XMLSchema-instance" xmlns:ind-def="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5" xsi:schemaLocation="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent independent-definitions-schema.xsd http://oval.mitre.org/XMLSchema/oval-definitions-5 oval-definitions-schema.xsd http://oval.mitre.org/XMLSchema/oval-common-5 oval-common-schema.xsd">
+    <generator>
+        <oval:schema_version>5.10.1</oval:schema_version>
+        <oval:timestamp>0001-01-01T00:00:00+00:00</oval:timestamp>
+    </generator>
+
+    <definitions>
+        <definition class="compliance" version="1" id="oval:x:def:1">
+            <metadata>
+                <title>x</title>
+                <description>x</description>
+            </metadata>
+            <criteria>
+                <criterion test_ref="oval:x:tst:1"/>
+            </criteria>
+        </definition>
+    </definitions>
+
+    <tests>
+        <textfilecontent54_test id="oval:x:tst:1" check="all" check_existence="at_least_one_exists" comment="the value is set" version="1" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <object object_ref="oval:x:obj:4"/>
+            <state state_ref="oval:x:ste:1"/>
+        </textfilecontent54_test>
+    </tests>
+
+    <objects>
+        <textfilecontent54_object id="oval:x:obj:1" version="1" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <filepath>%PATH%/a.conf</filepath>
+            <pattern operation="pattern match">^value = (\w+)$</pattern>
+            <instance datatype="int">1</instance>
+        </textfilecontent54_object>
+        <textfilecontent54_object id="oval:x:obj:2" version="1" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <set xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5">
+                <object_reference>oval:x:obj:1</object_reference>
+            </set>
+        </textfilecontent54_object>
+        <textfilecontent54_object id="oval:x:obj:3" version="1" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <set xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5">
+                <object_reference>oval:x:obj:2</object_reference>
+            </set>
+        </textfilecontent54_object>
+        <textfilecontent54_object id="oval:x:obj:4" version="1" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <set xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5">
+                <object_reference>oval:x:obj:3</object_reference>
+            </set>
+        </textfilecontent54_object>
+    </objects>
+
+    <states>
+        <textfilecontent54_state id="oval:x:ste:1" version="1" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <subexpression>yes</subexpression>
+        </textfilecontent54_state>
+    </states>
+</oval_definitions>
@@ -0,0 +1,8 @@
+#!/bin/bash
+# Create own file and wait for the file of a script evaluated by another thread
+touch "${XCCDF_VALUE_MINE}"
+for i in $(seq 1 300); do
+    [ -f "${XCCDF_VALUE_OTHER}" ] && exit ${XCCDF_RESULT_PASS}
+    sleep 0.1
+done
+exit ${XCCDF_RESULT_FAIL}
@@ -0,0 +1,33 @@
+#!/bin/bash
+
+# Checks running different SCE scripts shall be evaluated at the same time
+# when the rules are evaluated by multiple threads. Each script waits for the
+# other one, they would fail if they were evaluated one after another.
+
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+function test_sce_eval_threads {
+    local xccdf_file=${srcdir}/$1
+    local stdout=$(mktemp)
+    local result=$(mktemp)
+
+    rm -f sce_eval_threads.first sce_eval_threads.second
+    OSCAP_XCCDF_EVAL_THREADS=2 timeout "60s" $OSCAP xccdf eval --results "$result" "$xccdf_file" > $stdout
+    rm -f sce_eval_threads.first sce_eval_threads.second
+
+    cat $stdout
+    # the results are reported in document order
+    grep -A2 "First script" $stdout | grep -q "Result.*pass"
+    grep -A2 "Second script" $stdout | grep -q "Result.*pass"
+    [ "$(grep -c '<result>pass</result>' $result)" -eq 2 ]
+    rm $stdout $result
+}
+
+# Testing.
+test_init
+
+test_run "SCE scripts evaluated by multiple threads" test_sce_eval_threads test_sce_eval_threads.xccdf.xml
+
+test_exit
@@ -413,6 +413,11 @@ int app_evaluate_oval(const struct oscap_action *action)
 	}
 
 	printf("Evaluation done.\n");
+	if (getenv("OSCAP_RESCAN_DIR") != NULL) {
+		unsigned int reused, probed;
+		oval_session_get_rescan_stats(session, &reused, &probed);
+		printf("Objects reused from the previous scan: %u, probed: %u\n", reused, probed);
+	}
 
 	oval_session_set_directives(session, action->f_directives);
 	oval_session_set_results_export(session, action->f_results);
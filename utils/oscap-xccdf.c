@@ -606,6 +606,12 @@ int app_evaluate_xccdf(const struct oscap_action *action)
 	if (xccdf_session_evaluate(session) != 0)
 		goto cleanup;
 
+	if (getenv("OSCAP_RESCAN_DIR") != NULL && !action->progress) {
+		unsigned int reused, probed;
+		xccdf_session_get_rescan_stats(session, &reused, &probed);
+		printf("OVAL objects reused from the previous scan: %u, probed: %u\n", reused, probed);
+	}
+
 	xccdf_session_set_without_sys_chars_export(session, action->without_sys_chars);
 	xccdf_session_set_oval_results_export(session, action->oval_results);
 	xccdf_session_set_oval_variables_export(session, action->export_variables);